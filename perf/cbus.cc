@@ -0,0 +1,126 @@
+#include "memory.h"
+#include "fiber.h"
+#include "cbus.h"
+
+#include <stdio.h>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+// Throughput of message delivery from several producer threads
+// to one consumer thread, similar to the test/unit/cbus_stress.c
+// workload, but without connecting and disconnecting pipes.
+
+static const int MSG_PER_PRODUCER = 256 * 1024;
+// Number of messages pushed to a pipe before yielding, which
+// makes the producer loop flush the pipe.
+static const int MSG_PER_FLUSH = 64;
+
+// Number of messages processed by the consumer.
+static int64_t received_count;
+
+static void
+bench_msg_cb(struct cmsg *msg)
+{
+	(void)msg;
+	received_count++;
+}
+
+static const struct cmsg_hop bench_route[] = {
+	{bench_msg_cb, NULL},
+};
+
+struct producer {
+	struct cord cord;
+	std::vector<struct cmsg> msgs;
+	producer() : msgs(MSG_PER_PRODUCER) {}
+};
+
+static int
+producer_f(va_list ap)
+{
+	struct producer *p = va_arg(ap, struct producer *);
+	struct cpipe pipe;
+	cpipe_create(&pipe, "consumer");
+	for (int i = 0; i < MSG_PER_PRODUCER; i++) {
+		cmsg_init(&p->msgs[i], bench_route);
+		cpipe_push_input(&pipe, &p->msgs[i]);
+		if ((i + 1) % MSG_PER_FLUSH == 0) {
+			cpipe_flush_input(&pipe);
+			fiber_sleep(0);
+		}
+	}
+	cpipe_destroy(&pipe);
+	return 0;
+}
+
+static void
+consumer_fetch_cb(ev_loop *loop, struct ev_watcher *watcher, int events)
+{
+	(void)loop;
+	(void)watcher;
+	(void)events;
+}
+
+class Bus {
+public:
+	static Bus &instance()
+	{
+		static Bus instance;
+		return instance;
+	}
+private:
+	Bus()
+	{
+		memory_init();
+		fiber_init(fiber_c_invoke);
+		cbus_init();
+	}
+	~Bus()
+	{
+		cbus_free();
+		fiber_free();
+		memory_free();
+	}
+};
+
+static void
+cbus_throughput(benchmark::State &state)
+{
+	Bus::instance();
+	int producer_count = state.range(0);
+	struct cbus_endpoint endpoint;
+	cbus_endpoint_create(&endpoint, "consumer", consumer_fetch_cb, NULL);
+	std::vector<producer> producers(producer_count);
+	int64_t total = 0;
+	for (auto _ : state) {
+		received_count = 0;
+		for (int i = 0; i < producer_count; i++) {
+			char name[FIBER_NAME_MAX];
+			snprintf(name, sizeof(name), "producer_%d", i);
+			if (cord_costart(&producers[i].cord, name, producer_f,
+					 &producers[i]) != 0)
+				abort();
+		}
+		int64_t expected = (int64_t)producer_count * MSG_PER_PRODUCER;
+		while (received_count < expected) {
+			cbus_process(&endpoint);
+			if (received_count < expected)
+				ev_run(loop(), EVRUN_ONCE);
+		}
+		for (int i = 0; i < producer_count; i++) {
+			if (cord_join(&producers[i].cord) != 0)
+				abort();
+		}
+		total += expected;
+	}
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	state.SetItemsProcessed(total);
+}
+
+BENCHMARK(cbus_throughput)
+	->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,176 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+// Point lookup benchmarks of the hash tables used by memtx HASH
+// index: chained salad/light.h and salad/swiss.h with SIMD group
+// probing. Values are pointers to records scattered in memory, like
+// tuples, so comparing a value with a key costs a cache miss.
+
+struct record {
+	uint64_t key;
+	char payload[56];
+};
+
+static inline uint32_t
+record_hash(uint64_t key)
+{
+	key *= 0x9E3779B97F4A7C15ULL;
+	return (uint32_t)(key >> 32) ^ (uint32_t)key;
+}
+
+static inline bool
+record_equal(struct record *a, struct record *b)
+{
+	return a->key == b->key;
+}
+
+static inline bool
+record_equal_key(struct record *a, uint64_t key)
+{
+	return a->key == key;
+}
+
+#define LIGHT_NAME _bench
+#define LIGHT_DATA_TYPE struct record *
+#define LIGHT_KEY_TYPE uint64_t
+#define LIGHT_CMP_ARG_TYPE int
+#define LIGHT_EQUAL(a, b, c) record_equal(a, b)
+#define LIGHT_EQUAL_KEY(a, b, c) record_equal_key(a, b)
+#include "salad/light.h"
+
+#define SWISS_NAME _bench
+#define SWISS_DATA_TYPE struct record *
+#define SWISS_KEY_TYPE uint64_t
+#define SWISS_CMP_ARG_TYPE int
+#define SWISS_EQUAL(a, b, c) record_equal(a, b)
+#define SWISS_EQUAL_KEY(a, b, c) record_equal_key(a, b)
+#include "salad/swiss.h"
+
+static const size_t EXTENT_SIZE = 16 * 1024;
+static const size_t NUM_LOOKUP_KEYS = 1 << 16;
+
+static void *
+extent_alloc(void *ctx)
+{
+	(void)ctx;
+	return malloc(EXTENT_SIZE);
+}
+
+static void
+extent_free(void *ctx, void *extent)
+{
+	(void)ctx;
+	free(extent);
+}
+
+struct LightTable {
+	struct light_bench_core ht;
+	LightTable()
+	{
+		light_bench_create(&ht, EXTENT_SIZE, extent_alloc,
+				   extent_free, NULL, 0);
+	}
+	~LightTable() { light_bench_destroy(&ht); }
+	void insert(struct record *r)
+	{
+		light_bench_insert(&ht, record_hash(r->key), r);
+	}
+	struct record *find(uint64_t key)
+	{
+		uint32_t pos = light_bench_find_key(&ht, record_hash(key), key);
+		return pos != light_bench_end ? light_bench_get(&ht, pos) : NULL;
+	}
+};
+
+struct SwissTable {
+	struct swiss_bench_core ht;
+	SwissTable()
+	{
+		swiss_bench_create(&ht, EXTENT_SIZE, extent_alloc,
+				   extent_free, NULL, 0);
+	}
+	~SwissTable() { swiss_bench_destroy(&ht); }
+	void insert(struct record *r)
+	{
+		swiss_bench_insert(&ht, record_hash(r->key), r);
+	}
+	struct record *find(uint64_t key)
+	{
+		struct record **r = swiss_bench_find_key(&ht, record_hash(key),
+							 key);
+		return r != NULL ? *r : NULL;
+	}
+};
+
+// Records with keys 0, 2, 4, ... allocated in random order.
+class Dataset {
+public:
+	Dataset(size_t count) : records(count)
+	{
+		std::mt19937_64 rng(count);
+		std::vector<size_t> order(count);
+		for (size_t i = 0; i < count; i++)
+			order[i] = i;
+		std::shuffle(order.begin(), order.end(), rng);
+		for (size_t i = 0; i < count; i++) {
+			records[order[i]] = new record();
+			records[order[i]]->key = i * 2;
+		}
+		for (size_t i = 0; i < NUM_LOOKUP_KEYS; i++)
+			keys.push_back(rng() % count * 2);
+	}
+	~Dataset()
+	{
+		for (struct record *r : records)
+			delete r;
+	}
+	std::vector<struct record *> records;
+	// Keys of existing records; key + 1 is always missing.
+	std::vector<uint64_t> keys;
+};
+
+template <class Table>
+static void
+bench_get_hit(benchmark::State &state)
+{
+	Dataset dataset(state.range(0));
+	Table table;
+	for (struct record *r : dataset.records)
+		table.insert(r);
+	size_t i = 0;
+	for (auto _ : state) {
+		struct record *r = table.find(dataset.keys[i]);
+		benchmark::DoNotOptimize(r);
+		i = (i + 1) % NUM_LOOKUP_KEYS;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+template <class Table>
+static void
+bench_get_miss(benchmark::State &state)
+{
+	Dataset dataset(state.range(0));
+	Table table;
+	for (struct record *r : dataset.records)
+		table.insert(r);
+	size_t i = 0;
+	for (auto _ : state) {
+		struct record *r = table.find(dataset.keys[i] + 1);
+		benchmark::DoNotOptimize(r);
+		i = (i + 1) % NUM_LOOKUP_KEYS;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(bench_get_hit, LightTable)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(bench_get_hit, SwissTable)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(bench_get_miss, LightTable)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(bench_get_miss, SwissTable)->Range(1 << 10, 1 << 22);
+
+BENCHMARK_MAIN();
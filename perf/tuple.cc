@@ -350,6 +350,71 @@ tuple_access_unindexed_field(benchmark::State& state)
 
 BENCHMARK(tuple_access_unindexed_field);
 
+// Wide msgpack array of mostly small scalar values, like flags,
+// counters and nulls, with an occasional short string.
+class WideMpData {
+public:
+	static const uint32_t FIELD_COUNT = 40;
+	static WideMpData &instance()
+	{
+		static WideMpData instance;
+		return instance;
+	}
+	const char *fields() const { return data_fields; }
+private:
+	WideMpData()
+	{
+		mp_skip_init();
+		char *p = mp_encode_array(data, FIELD_COUNT);
+		data_fields = p;
+		for (uint32_t i = 0; i < FIELD_COUNT; i++) {
+			switch (i % 8) {
+			case 0: p = mp_encode_nil(p); break;
+			case 1: p = mp_encode_bool(p, i % 3 == 0); break;
+			case 7: p = mp_encode_str(p, "field", 5); break;
+			default: p = mp_encode_uint(p, rand() % 100); break;
+			}
+		}
+	}
+	char data[256];
+	const char *data_fields;
+};
+
+// benchmark of skipping msgpack fields one by one.
+static void
+mp_next_wide_array(benchmark::State& state)
+{
+	const char *fields = WideMpData::instance().fields();
+	size_t total_count = 0;
+	for (auto _ : state) {
+		const char *pos = fields;
+		for (uint32_t k = 0; k < WideMpData::FIELD_COUNT - 1; k++)
+			mp_next(&pos);
+		benchmark::DoNotOptimize(*pos);
+		++total_count;
+	}
+	state.SetItemsProcessed(total_count);
+}
+
+BENCHMARK(mp_next_wide_array);
+
+// benchmark of skipping msgpack fields with mp_skip().
+static void
+mp_skip_wide_array(benchmark::State& state)
+{
+	const char *fields = WideMpData::instance().fields();
+	size_t total_count = 0;
+	for (auto _ : state) {
+		const char *pos = fields;
+		mp_skip(&pos, WideMpData::FIELD_COUNT - 1);
+		benchmark::DoNotOptimize(*pos);
+		++total_count;
+	}
+	state.SetItemsProcessed(total_count);
+}
+
+BENCHMARK(mp_skip_wide_array);
+
 // benchmark of access of indexed field.
 static void
 tuple_access_indexed_field(benchmark::State& state)
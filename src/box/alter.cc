@@ -673,6 +673,11 @@ space_def_new_from_tuple(struct tuple *tuple, uint32_t errcode,
 			 "local space can't be synchronous");
 		return NULL;
 	}
+	if (opts.memory_quota < 0) {
+		diag_set(ClientError, errcode, tt_cstr(name, name_len),
+			 "memory_quota must be non-negative");
+		return NULL;
+	}
 	struct space_def *def =
 		space_def_new(id, uid, exact_field_count, name, name_len,
 			      engine_name, engine_name_len, &opts, fields,
@@ -543,6 +543,11 @@ applier_fetch_snapshot(struct applier *applier)
 
 struct applier_read_ctx {
 	struct ibuf *ibuf;
+	/**
+	 * Buffer for rows unpacked from IPROTO_COMPRESSED packets,
+	 * NULL if compressed packets aren't expected.
+	 */
+	struct ibuf *unpack_buf;
 	struct applier_tx_row *(*alloc_row)(struct applier *);
 	void (*save_body)(struct applier *, struct xrow_header *);
 };
@@ -643,6 +648,7 @@ applier_wait_register(struct applier *applier, uint64_t row_count)
 
 	const struct applier_read_ctx ctx = {
 		.ibuf = &applier->ibuf,
+		.unpack_buf = NULL,
 		.alloc_row = tx_alloc_row,
 		.save_body = tx_save_body,
 	};
@@ -749,7 +755,28 @@ applier_read_tx_row(struct applier *applier, const struct applier_read_ctx *ctx,
 
 	ERROR_INJECT_YIELD(ERRINJ_APPLIER_READ_TX_ROW_DELAY);
 
-	coio_read_xrow_timeout_xc(io, ctx->ibuf, row, timeout);
+	struct ibuf *unpack_buf = ctx->unpack_buf;
+	while (unpack_buf == NULL || ibuf_used(unpack_buf) == 0) {
+		coio_read_xrow_timeout_xc(io, ctx->ibuf, row, timeout);
+		if (row->type != IPROTO_COMPRESSED)
+			goto done;
+		if (unpack_buf == NULL) {
+			tnt_raise(ClientError, ER_PROTOCOL,
+				  "Unexpected compressed packet");
+		}
+		struct iproto_decompressor *decompressor =
+			&applier->thread.decompressor;
+		if (decompressor->zstream == NULL &&
+		    iproto_decompressor_create(decompressor) != 0)
+			diag_raise();
+		ibuf_reset(unpack_buf);
+		if (iproto_decompressor_decompress(decompressor, row,
+						   unpack_buf) != 0)
+			diag_raise();
+	}
+	if (iproto_decompressor_next(unpack_buf, row) != 0)
+		diag_raise();
+done:
 
 	if (row->tm > 0)
 		applier->lag = ev_now(loop()) - row->tm;
@@ -1631,6 +1658,7 @@ applier_thread_reader_f(va_list ap)
 	struct lsregion *lsr = &applier->thread.lsr;
 	const struct applier_read_ctx ctx = {
 		.ibuf = &applier->thread.ibuf,
+		.unpack_buf = &applier->thread.unpack_buf,
 		.alloc_row = thread_alloc_row,
 		.save_body = thread_save_body,
 	};
@@ -1822,6 +1850,8 @@ applier_thread_attach_applier(struct cbus_call_msg *base)
 	lsregion_create(&applier->thread.lsr, &runtime);
 	fiber_cond_create(&applier->thread.writer_cond);
 	applier_thread_ibuf_init(applier);
+	applier->thread.decompressor.zstream = NULL;
+	ibuf_create(&applier->thread.unpack_buf, &cord()->slabc, 1024);
 	applier_thread_msgs_init(applier);
 	applier_thread_fiber_init(applier);
 
@@ -1843,6 +1873,9 @@ applier_thread_detach_applier(struct cbus_call_msg *base)
 	applier->thread.reader = NULL;
 	lsregion_destroy(&applier->thread.lsr);
 	fiber_cond_destroy(&applier->thread.writer_cond);
+	if (applier->thread.decompressor.zstream != NULL)
+		iproto_decompressor_destroy(&applier->thread.decompressor);
+	ibuf_destroy(&applier->thread.unpack_buf);
 	return 0;
 }
 
@@ -1952,7 +1985,8 @@ applier_subscribe(struct applier *applier)
 	 */
 	uint32_t id_filter = box_is_orphan() ? 0 : 1 << instance_id;
 	xrow_encode_subscribe_xc(&row, &REPLICASET_UUID, &INSTANCE_UUID,
-				 &vclock, replication_anon, id_filter);
+				 &vclock, replication_anon, id_filter,
+				 &IPROTO_CURRENT_FEATURES);
 	coio_write_xrow(io, &row);
 
 	/* Read SUBSCRIBE response */
@@ -39,6 +39,7 @@
 
 #include "fiber_cond.h"
 #include "iostream.h"
+#include "iproto_compression.h"
 #include "trigger.h"
 #include "trivia/util.h"
 #include "tt_uuid.h"
@@ -219,6 +220,13 @@ struct applier {
 		struct applier_data_msg msgs[2];
 		/** The input buffer used in thread to read rows. */
 		struct ibuf ibuf;
+		/**
+		 * Decompressor of IPROTO_COMPRESSED packets. Created on
+		 * the first compressed packet, zstream is NULL until then.
+		 */
+		struct iproto_decompressor decompressor;
+		/** Rows unpacked from the last IPROTO_COMPRESSED packet. */
+		struct ibuf unpack_buf;
 		/** The lsregion for allocating rows in thread. */
 		struct lsregion lsr;
 		/** A growing identifier to track lsregion allocations. */
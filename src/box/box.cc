@@ -38,6 +38,7 @@
 #include <scoped_guard.h>
 #include "identifier.h"
 #include "iproto.h"
+#include "iproto_compression.h"
 #include "iproto_constants.h"
 #include "recovery.h"
 #include "wal.h"
@@ -78,7 +79,10 @@
 #include "crash.h"
 #include "func.h"
 #include "sequence.h"
+#include "sql_stat.h"
 #include "sql_stmt_cache.h"
+#include "sql/hash_agg.h"
+#include "sql/hash_join.h"
 #include "msgpack.h"
 #include "raft.h"
 #include "watcher.h"
@@ -523,13 +527,17 @@ wal_stream_apply_raft_row(struct wal_stream *stream, struct xrow_header *row)
  * synchronous transactions.
  */
 static int
-wal_stream_apply_dml_row(struct wal_stream *stream, struct xrow_header *row)
-{
-	struct request request;
-	uint64_t req_type = dml_request_key_map(row->type);
-	if (xrow_decode_dml(row, &request, req_type) != 0) {
-		say_error("couldn't decode a DML request");
-		return -1;
+wal_stream_apply_dml_row(struct wal_stream *stream, struct xrow_header *row,
+			 struct request *request)
+{
+	struct request decoded;
+	if (request == NULL) {
+		request = &decoded;
+		uint64_t req_type = dml_request_key_map(row->type);
+		if (xrow_decode_dml(row, request, req_type) != 0) {
+			say_error("couldn't decode a DML request");
+			return -1;
+		}
 	}
 	/*
 	 * Note that all the information which came from the log is validated
@@ -577,13 +585,13 @@ wal_stream_apply_dml_row(struct wal_stream *stream, struct xrow_header *row)
 	}
 	assert(wal_stream_has_tx(stream));
 	/* Nops might appear at least after before_replace skipping rows. */
-	if (request.type != IPROTO_NOP) {
-		struct space *space = space_cache_find(request.space_id);
+	if (request->type != IPROTO_NOP) {
+		struct space *space = space_cache_find(request->space_id);
 		if (space == NULL) {
 			say_error("couldn't find space by ID");
 			goto end_diag_request;
 		}
-		if (box_process_rw(&request, space, NULL) != 0) {
+		if (box_process_rw(request, space, NULL) != 0) {
 			say_error("couldn't apply the request");
 			goto end_diag_request;
 		}
@@ -627,7 +635,7 @@ end_diag_request:
 	 * request. Errors like txn_begin() fail has nothing to do with it, and
 	 * therefore don't log the request as the fault reason.
 	 */
-	say_error("error at request: %s", request_str(&request));
+	say_error("error at request: %s", request_str(request));
 	return -1;
 }
 
@@ -655,7 +663,7 @@ wal_stream_apply_row(struct xstream *base, struct xrow_header *row)
 	} else if (iproto_type_is_raft_request(row->type)) {
 		if (wal_stream_apply_raft_row(stream, row) != 0)
 			goto end_error;
-	} else if (wal_stream_apply_dml_row(stream, row) != 0) {
+	} else if (wal_stream_apply_dml_row(stream, row, NULL) != 0) {
 		goto end_error;
 	}
 	wal_stream_try_yield(stream);
@@ -667,6 +675,20 @@ end_error:
 	diag_raise();
 }
 
+/** Apply a DML request decoded by a WAL reader thread. */
+static void
+wal_stream_apply_request(struct xstream *base, struct request *request)
+{
+	struct wal_stream *stream =
+		container_of(base, struct wal_stream, base);
+	if (wal_stream_apply_dml_row(stream, request->header, request) != 0) {
+		wal_stream_abort(stream);
+		wal_stream_try_yield(stream);
+		diag_raise();
+	}
+	wal_stream_try_yield(stream);
+}
+
 /**
  * Plan a yield in recovery stream. Wal stream will execute it as soon as it's
  * ready.
@@ -684,6 +706,7 @@ wal_stream_create(struct wal_stream *ctx)
 {
 	xstream_create(&ctx->base, wal_stream_apply_row,
 		       wal_stream_schedule_yield);
+	ctx->base.write_request = wal_stream_apply_request;
 	ctx->tsn = 0;
 	ctx->first_row_lsn = 0;
 	ctx->has_yield = false;
@@ -1075,6 +1098,17 @@ box_check_wal_queue_max_size(void)
 	return size;
 }
 
+static int64_t
+box_check_wal_tail_size(void)
+{
+	int64_t size = cfg_geti64("wal_tail_size");
+	if (size < 0) {
+		diag_set(ClientError, ER_CFG, "wal_tail_size",
+			 "wal_tail_size must be >= 0");
+	}
+	return size;
+}
+
 static double
 box_check_wal_cleanup_delay(void)
 {
@@ -1088,6 +1122,42 @@ box_check_wal_cleanup_delay(void)
 	return value;
 }
 
+static double
+box_check_wal_commit_delay(void)
+{
+	double value = cfg_getd("wal_commit_delay");
+	if (value < 0) {
+		diag_set(ClientError, ER_CFG, "wal_commit_delay",
+			 "value must be >= 0");
+		return -1;
+	}
+	return value;
+}
+
+static int
+box_check_wal_commit_min_batch(void)
+{
+	int value = cfg_geti("wal_commit_min_batch");
+	if (value < 0) {
+		diag_set(ClientError, ER_CFG, "wal_commit_min_batch",
+			 "value must be >= 0");
+		return -1;
+	}
+	return value;
+}
+
+static int
+box_check_wal_recycle_segments(void)
+{
+	int value = cfg_geti("wal_recycle_segments");
+	if (value < 0) {
+		diag_set(ClientError, ER_CFG, "wal_recycle_segments",
+			 "value must be >= 0");
+		return -1;
+	}
+	return value;
+}
+
 static void
 box_check_readahead(int readahead)
 {
@@ -1099,6 +1169,30 @@ box_check_readahead(int readahead)
 	}
 }
 
+static int
+box_check_net_compression_level(void)
+{
+	int level = cfg_geti("net_compression_level");
+	if (level < 0 || level > IPROTO_COMPRESSION_LEVEL_MAX) {
+		diag_set(ClientError, ER_CFG, "net_compression_level",
+			 tt_sprintf("the value must be between 0 and %d",
+				    IPROTO_COMPRESSION_LEVEL_MAX));
+		return -1;
+	}
+	return level;
+}
+
+static int64_t
+box_check_net_compression_min_size(void)
+{
+	int64_t size = cfg_geti64("net_compression_min_size");
+	if (size < 0) {
+		diag_set(ClientError, ER_CFG, "net_compression_min_size",
+			 "the value must be >= 0");
+	}
+	return size;
+}
+
 static void
 box_check_checkpoint_count(int checkpoint_count)
 {
@@ -1144,6 +1238,8 @@ box_check_vinyl_options(void)
 
 	if (box_check_memory_quota("vinyl_memory") < 0)
 		diag_raise();
+	if (box_check_memory_quota("vinyl_page_cache") < 0)
+		diag_raise();
 
 	if (read_threads < 1) {
 		tnt_raise(ClientError, ER_CFG, "vinyl_read_threads",
@@ -1183,6 +1279,42 @@ box_check_sql_cache_size(int size)
 	return 0;
 }
 
+static int64_t
+box_check_sql_hash_agg_memory(void)
+{
+	int64_t memory = cfg_geti64("sql_hash_agg_memory");
+	if (memory < 0) {
+		diag_set(ClientError, ER_CFG, "sql_hash_agg_memory",
+			 "must be non-negative");
+		return -1;
+	}
+	return memory;
+}
+
+static int64_t
+box_check_sql_hash_join_memory(void)
+{
+	int64_t memory = cfg_geti64("sql_hash_join_memory");
+	if (memory < 0) {
+		diag_set(ClientError, ER_CFG, "sql_hash_join_memory",
+			 "must be non-negative");
+		return -1;
+	}
+	return memory;
+}
+
+static double
+box_check_sql_stat_refresh_ratio(void)
+{
+	double ratio = cfg_getd("sql_stat_refresh_ratio");
+	if (ratio < 0) {
+		diag_set(ClientError, ER_CFG, "sql_stat_refresh_ratio",
+			 "must be non-negative");
+		return -1;
+	}
+	return ratio;
+}
+
 static int
 box_check_allocator(void)
 {
@@ -1234,6 +1366,34 @@ box_check_iproto_options(void)
 	return 0;
 }
 
+static int
+box_check_memtx_build_threads(void)
+{
+	int threads = cfg_geti("memtx_build_threads");
+	if (threads < 1 || threads > MEMTX_BUILD_THREADS_MAX) {
+		diag_set(ClientError, ER_CFG, "memtx_build_threads",
+			 tt_sprintf("must be greater than or equal to 1,"
+				    " less than or equal to %d",
+				    MEMTX_BUILD_THREADS_MAX));
+		return -1;
+	}
+	return threads;
+}
+
+static int
+box_check_memtx_snap_threads(void)
+{
+	int threads = cfg_geti("memtx_snap_threads");
+	if (threads < 1 || threads > MEMTX_SNAP_THREADS_MAX) {
+		diag_set(ClientError, ER_CFG, "memtx_snap_threads",
+			 tt_sprintf("must be greater than or equal to 1,"
+				    " less than or equal to %d",
+				    MEMTX_SNAP_THREADS_MAX));
+		return -1;
+	}
+	return threads;
+}
+
 static double
 box_check_txn_timeout(void)
 {
@@ -1273,24 +1433,46 @@ box_check_config(void)
 		diag_raise();
 	box_check_replication_sync_timeout();
 	box_check_readahead(cfg_geti("readahead"));
+	if (box_check_net_compression_level() < 0)
+		diag_raise();
+	if (box_check_net_compression_min_size() < 0)
+		diag_raise();
 	box_check_checkpoint_count(cfg_geti("checkpoint_count"));
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
 	if (box_check_wal_queue_max_size() < 0)
 		diag_raise();
+	if (box_check_wal_tail_size() < 0)
+		diag_raise();
 	if (box_check_wal_cleanup_delay() < 0)
 		diag_raise();
+	if (box_check_wal_commit_delay() < 0)
+		diag_raise();
+	if (box_check_wal_commit_min_batch() < 0)
+		diag_raise();
+	if (box_check_wal_recycle_segments() < 0)
+		diag_raise();
 	if (box_check_memory_quota("memtx_memory") < 0)
 		diag_raise();
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
 	if (box_check_allocator() != 0)
 		diag_raise();
 	box_check_small_alloc_options();
+	if (box_check_memtx_build_threads() < 0)
+		diag_raise();
+	if (box_check_memtx_snap_threads() < 0)
+		diag_raise();
 	box_check_vinyl_options();
 	if (box_check_iproto_options() != 0)
 		diag_raise();
 	if (box_check_sql_cache_size(cfg_geti("sql_cache_size")) != 0)
 		diag_raise();
+	if (box_check_sql_hash_agg_memory() < 0)
+		diag_raise();
+	if (box_check_sql_hash_join_memory() < 0)
+		diag_raise();
+	if (box_check_sql_stat_refresh_ratio() < 0)
+		diag_raise();
 	if (box_check_txn_timeout() < 0)
 		diag_raise();
 }
@@ -2006,6 +2188,19 @@ box_set_memtx_max_tuple_size(void)
 			cfg_geti("memtx_max_tuple_size"));
 }
 
+int
+box_set_memtx_snap_threads(void)
+{
+	int threads = box_check_memtx_snap_threads();
+	if (threads < 0)
+		return -1;
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_snap_threads(memtx, threads);
+	return 0;
+}
+
 void
 box_set_too_long_threshold(void)
 {
@@ -2024,6 +2219,26 @@ box_set_readahead(void)
 	iproto_readahead = readahead;
 }
 
+int
+box_set_net_compression_level(void)
+{
+	int level = box_check_net_compression_level();
+	if (level < 0)
+		return -1;
+	iproto_compression_level = level;
+	return 0;
+}
+
+int
+box_set_net_compression_min_size(void)
+{
+	int64_t size = box_check_net_compression_min_size();
+	if (size < 0)
+		return -1;
+	iproto_compression_min_size = size;
+	return 0;
+}
+
 void
 box_set_checkpoint_count(void)
 {
@@ -2056,6 +2271,46 @@ box_set_wal_queue_max_size(void)
 	return 0;
 }
 
+int
+box_set_wal_tail_size(void)
+{
+	int64_t size = box_check_wal_tail_size();
+	if (size < 0)
+		return -1;
+	wal_set_tail_size(size);
+	return 0;
+}
+
+int
+box_set_wal_commit_delay(void)
+{
+	double delay = box_check_wal_commit_delay();
+	if (delay < 0)
+		return -1;
+	wal_set_commit_delay(delay);
+	return 0;
+}
+
+int
+box_set_wal_commit_min_batch(void)
+{
+	int min_batch = box_check_wal_commit_min_batch();
+	if (min_batch < 0)
+		return -1;
+	wal_set_commit_min_batch(min_batch);
+	return 0;
+}
+
+int
+box_set_wal_recycle_segments(void)
+{
+	int count = box_check_wal_recycle_segments();
+	if (count < 0)
+		return -1;
+	wal_set_recycle_segments(count);
+	return 0;
+}
+
 int
 box_set_wal_cleanup_delay(void)
 {
@@ -2101,6 +2356,17 @@ box_set_vinyl_cache(void)
 	vinyl_engine_set_cache(vinyl, cfg_geti64("vinyl_cache"));
 }
 
+void
+box_set_vinyl_page_cache(void)
+{
+	struct engine *vinyl = engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	ssize_t quota = box_check_memory_quota("vinyl_page_cache");
+	if (quota < 0)
+		diag_raise();
+	vinyl_engine_set_page_cache(vinyl, quota);
+}
+
 void
 box_set_vinyl_timeout(void)
 {
@@ -2130,6 +2396,36 @@ box_set_prepared_stmt_cache_size(void)
 	return 0;
 }
 
+int
+box_set_sql_hash_agg_memory(void)
+{
+	int64_t memory = box_check_sql_hash_agg_memory();
+	if (memory < 0)
+		return -1;
+	sql_hash_agg_memory = memory;
+	return 0;
+}
+
+int
+box_set_sql_hash_join_memory(void)
+{
+	int64_t memory = box_check_sql_hash_join_memory();
+	if (memory < 0)
+		return -1;
+	sql_hash_join_memory = memory;
+	return 0;
+}
+
+int
+box_set_sql_stat_refresh_ratio(void)
+{
+	double ratio = box_check_sql_stat_refresh_ratio();
+	if (ratio < 0)
+		return -1;
+	sql_stat_refresh_ratio = ratio;
+	return 0;
+}
+
 int
 box_set_crash(void)
 {
@@ -2323,7 +2619,8 @@ API_EXPORT int
 box_select(uint32_t space_id, uint32_t index_id,
 	   int iterator, uint32_t offset, uint32_t limit,
 	   const char *key, const char *key_end,
-	   struct port *port)
+	   const char **packed_pos, const char **packed_pos_end,
+	   bool update_pos, struct port *port)
 {
 	(void)key_end;
 
@@ -2346,6 +2643,7 @@ box_select(uint32_t space_id, uint32_t index_id,
 		return -1;
 
 	enum iterator_type type = (enum iterator_type) iterator;
+	const char *packed_key = key;
 	uint32_t part_count = key ? mp_decode_array(&key) : 0;
 	if (key_validate(index->def, type, key, part_count))
 		return -1;
@@ -2370,20 +2668,29 @@ box_select(uint32_t space_id, uint32_t index_id,
 	int rc = 0;
 	uint32_t found = 0;
 	struct tuple *tuple;
+	struct tuple *last = NULL;
 	port_c_create(port);
-	while (found < limit) {
+	if (packed_pos != NULL && *packed_pos != NULL)
+		rc = iterator_start_after(it, type, packed_key,
+					  *packed_pos, *packed_pos_end);
+	if (rc == 0 && offset > 0 && limit > 0)
+		rc = iterator_skip(it, offset);
+	while (rc == 0 && found < limit) {
 		rc = iterator_next(it, &tuple);
 		if (rc != 0 || tuple == NULL)
 			break;
-		if (offset > 0) {
-			offset--;
-			continue;
-		}
 		rc = port_c_add_tuple(port, tuple);
 		if (rc != 0)
 			break;
+		last = tuple;
 		found++;
 	}
+	if (rc == 0 && update_pos && last != NULL) {
+		uint32_t size;
+		const char *data = tuple_data_range(last, &size);
+		rc = index_tuple_position(index, data, data + size,
+					  packed_pos, packed_pos_end);
+	}
 	iterator_delete(it);
 
 	if (rc != 0) {
@@ -2395,6 +2702,60 @@ box_select(uint32_t space_id, uint32_t index_id,
 	return 0;
 }
 
+int
+box_get_many(uint32_t space_id, uint32_t index_id,
+	     const char *keys, const char *keys_end, struct port *port)
+{
+	const char *p = keys;
+	if (keys == keys_end || mp_typeof(*keys) != MP_ARRAY ||
+	    mp_check(&p, keys_end) != 0 || p != keys_end) {
+		diag_set(ClientError, ER_INVALID_MSGPACK,
+			 "keys must be an array");
+		return -1;
+	}
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return -1;
+	if (access_check_space(space, PRIV_R) != 0)
+		return -1;
+	struct index *index = index_find(space, index_id);
+	if (index == NULL)
+		return -1;
+	if (!index->def->opts.is_unique) {
+		diag_set(ClientError, ER_MORE_THAN_ONE_TUPLE);
+		return -1;
+	}
+	uint32_t key_count = mp_decode_array(&keys);
+	const char *key = keys;
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (mp_typeof(*key) != MP_ARRAY) {
+			diag_set(ClientError, ER_ILLEGAL_PARAMS,
+				 "key must be an array");
+			return -1;
+		}
+		uint32_t part_count = mp_decode_array(&key);
+		if (exact_key_validate(index->def->key_def, key,
+				       part_count) != 0)
+			return -1;
+		for (uint32_t j = 0; j < part_count; j++)
+			mp_next(&key);
+	}
+	rmean_collect(rmean_box, IPROTO_SELECT, key_count);
+
+	struct txn *txn;
+	struct txn_ro_savepoint svp;
+	if (txn_begin_ro_stmt(space, &txn, &svp) != 0)
+		return -1;
+	port_c_create(port);
+	if (index_get_many(index, keys, key_count, port) != 0) {
+		port_destroy(port);
+		txn_rollback_stmt(txn);
+		return -1;
+	}
+	txn_commit_ro_stmt(txn, &svp);
+	return 0;
+}
+
 API_EXPORT int
 box_insert(uint32_t space_id, const char *tuple, const char *tuple_end,
 	   box_tuple_t **result)
@@ -2973,9 +3334,10 @@ box_process_subscribe(struct iostream *io, const struct xrow_header *header)
 	uint32_t replica_version_id;
 	bool anon;
 	uint32_t id_filter;
+	struct iproto_features replica_features;
 	xrow_decode_subscribe_xc(header, &peer_replicaset_uuid, &replica_uuid,
 				 &replica_clock, &replica_version_id, &anon,
-				 &id_filter);
+				 &id_filter, &replica_features);
 
 	/* Forbid connection to itself */
 	if (tt_uuid_is_equal(&replica_uuid, &INSTANCE_UUID))
@@ -3117,7 +3479,7 @@ box_process_subscribe(struct iostream *io, const struct xrow_header *header)
 	 * indefinitely).
 	 */
 	relay_subscribe(replica, io, header->sync, &replica_clock,
-			replica_version_id, id_filter);
+			replica_version_id, id_filter, &replica_features);
 }
 
 void
@@ -3199,6 +3561,10 @@ engine_init()
 				    cfg_getd("slab_alloc_factor"));
 	engine_register((struct engine *)memtx);
 	box_set_memtx_max_tuple_size();
+	memtx_engine_set_build_threads(memtx, box_check_memtx_build_threads());
+	memtx_engine_set_use_swiss_hash(memtx, cfg_geti("memtx_use_swiss_hash"));
+	if (box_set_memtx_snap_threads() != 0)
+		diag_raise();
 
 	struct sysview_engine *sysview = sysview_engine_new_xc();
 	engine_register((struct engine *)sysview);
@@ -3213,11 +3579,13 @@ engine_init()
 	vinyl = vinyl_engine_new_xc(cfg_gets("vinyl_dir"),
 				    cfg_geti64("vinyl_memory"),
 				    cfg_geti("vinyl_read_threads"),
+				    cfg_geti("use_io_uring"),
 				    cfg_geti("vinyl_write_threads"),
 				    cfg_geti("force_recovery"));
 	engine_register((struct engine *)vinyl);
 	box_set_vinyl_max_tuple_size();
 	box_set_vinyl_cache();
+	box_set_vinyl_page_cache();
 	box_set_vinyl_timeout();
 }
 
@@ -3430,6 +3798,12 @@ local_recovery(const struct tt_uuid *instance_uuid,
 	bool is_force_recovery = cfg_geti("force_recovery");
 	recovery = recovery_new(wal_dir(), is_force_recovery,
 				checkpoint_vclock);
+	/* Read and decode WAL files ahead of applying them. */
+	recovery->use_reader_thread = true;
+	recovery->is_hot_standby = wal_dir_lock < 0;
+	ERROR_INJECT(ERRINJ_WAL_READER_DISABLE, {
+		recovery->use_reader_thread = false;
+	});
 
 	/*
 	 * Make sure we report the actual recovery position
@@ -3669,7 +4043,8 @@ box_cfg_xc(void)
 	int64_t wal_max_size = box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	enum wal_mode wal_mode = box_check_wal_mode(cfg_gets("wal_mode"));
 	if (wal_init(wal_mode, cfg_gets("wal_dir"), wal_max_size,
-		     &INSTANCE_UUID, on_wal_garbage_collection,
+		     &INSTANCE_UUID, cfg_geti("use_io_uring"),
+		     on_wal_garbage_collection,
 		     on_wal_checkpoint_threshold) != 0) {
 		diag_raise();
 	}
@@ -253,16 +253,24 @@ void box_set_io_collect_interval(void);
 void box_set_snap_io_rate_limit(void);
 void box_set_too_long_threshold(void);
 void box_set_readahead(void);
+int box_set_net_compression_level(void);
+int box_set_net_compression_min_size(void);
 void box_set_checkpoint_count(void);
 void box_set_checkpoint_interval(void);
 void box_set_checkpoint_wal_threshold(void);
 int box_set_wal_queue_max_size(void);
+int box_set_wal_tail_size(void);
 int box_set_wal_cleanup_delay(void);
+int box_set_wal_commit_delay(void);
+int box_set_wal_commit_min_batch(void);
+int box_set_wal_recycle_segments(void);
 void box_set_memtx_memory(void);
 void box_set_memtx_max_tuple_size(void);
+int box_set_memtx_snap_threads(void);
 void box_set_vinyl_memory(void);
 void box_set_vinyl_max_tuple_size(void);
 void box_set_vinyl_cache(void);
+void box_set_vinyl_page_cache(void);
 void box_set_vinyl_timeout(void);
 int box_set_election_mode(void);
 int box_set_election_timeout(void);
@@ -282,6 +290,9 @@ int box_set_txn_timeout(void);
 
 int
 box_set_prepared_stmt_cache_size(void);
+int box_set_sql_hash_agg_memory(void);
+int box_set_sql_hash_join_memory(void);
+int box_set_sql_stat_refresh_ratio(void);
 
 extern "C" {
 #endif /* defined(__cplusplus) */
@@ -300,12 +311,30 @@ box_demote(void);
 int
 box_promote_qsync(void);
 
-/* box_select is private and used only by FFI */
+/**
+ * Select tuples from an index. Private, used by FFI and IPROTO.
+ *
+ * If @a packed_pos is not NULL and points to a position (see
+ * index_tuple_position()), tuples following the position are
+ * selected. If @a update_pos is set, the position of the last
+ * selected tuple is stored in @a packed_pos on the fiber region
+ * (it is left as is if nothing is selected).
+ */
 API_EXPORT int
 box_select(uint32_t space_id, uint32_t index_id,
 	   int iterator, uint32_t offset, uint32_t limit,
 	   const char *key, const char *key_end,
-	   struct port *port);
+	   const char **packed_pos, const char **packed_pos_end,
+	   bool update_pos, struct port *port);
+
+/**
+ * Look up tuples by a MsgPack array of full keys of a unique index.
+ * Found tuples are returned in @a port in the order of the keys.
+ * Private, used by Lua.
+ */
+int
+box_get_many(uint32_t space_id, uint32_t index_id,
+	     const char *keys, const char *keys_end, struct port *port);
 
 /** \cond public */
 
@@ -286,6 +286,7 @@ struct errcode_record {
 	/*231 */_(ER_TRANSACTION_TIMEOUT,       "Transaction has been aborted by timeout") \
 	/*232 */_(ER_ACTIVE_TIMER,              "Operation is not permitted if timer is already running") \
 	/*233 */_(ER_TUPLE_FIELD_COUNT_LIMIT,	"Tuple field count limit reached: see box.schema.FIELD_MAX") \
+	/*234 */_(ER_SPACE_MEMORY_QUOTA,	"Failed to allocate %u bytes for tuple in space '%s': memory quota of %llu bytes exceeded") \
 
 /*
  * !IMPORTANT! Please follow instructions at start of the file
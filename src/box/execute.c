@@ -48,6 +48,7 @@
 #include "box/lua/execute.h"
 #include "box/sql_stmt_cache.h"
 #include "session.h"
+#include "read_view_scan.h"
 #include "rmean.h"
 
 const char *sql_info_key_strs[] = {
@@ -586,7 +587,13 @@ sql_execute_prepared(uint32_t stmt_id, const struct sql_bind *bind,
 		diag_set(ClientError, ER_SQL_EXECUTE, "statement has expired");
 		return -1;
 	}
-	if (sql_stmt_busy(stmt)) {
+	/*
+	 * A statement scanning a read view is compiled anew if a read
+	 * view can't be used now, so that it scans the space as usual.
+	 */
+	if (sql_stmt_busy(stmt) ||
+	    (!read_view_scan_is_available() &&
+	     sql_stmt_uses_read_view(stmt))) {
 		const char *sql_str = sql_stmt_query_str(stmt);
 		return sql_prepare_and_execute(sql_str, strlen(sql_str), bind,
 					       bind_count, port, region);
@@ -138,6 +138,10 @@ sql_stmt_query_str(const struct sql_stmt *stmt);
 int
 sql_stmt_busy(const struct sql_stmt *stmt);
 
+/** Return true if statement scans a read view, see read_view_scan.h. */
+bool
+sql_stmt_uses_read_view(const struct sql_stmt *stmt);
+
 /**
  * Prepare (compile into VDBE byte-code) statement.
  *
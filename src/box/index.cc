@@ -39,6 +39,7 @@
 #include "rmean.h"
 #include "info/info.h"
 #include "memtx_tx.h"
+#include "port.h"
 
 /* {{{ Utilities. **********************************************/
 
@@ -149,6 +150,40 @@ exact_key_validate(struct key_def *key_def, const char *key,
 	return key_validate_parts(key_def, key, part_count, false, &key_end);
 }
 
+/**
+ * Check if an index supports tuple positions. A tuple may have
+ * many keys in multikey and functional indexes, so the position
+ * of a tuple isn't defined in them.
+ */
+static int
+index_check_position_support(struct index_def *def)
+{
+	if (def->type != TREE || def->key_def->is_multikey ||
+	    def->key_def->for_func_index) {
+		diag_set(UnsupportedIndexFeature, def, "pagination");
+		return -1;
+	}
+	return 0;
+}
+
+int
+index_tuple_position(struct index *index, const char *tuple,
+		     const char *tuple_end, const char **pos,
+		     const char **pos_end)
+{
+	if (index_check_position_support(index->def) != 0)
+		return -1;
+	uint32_t size;
+	const char *key = tuple_extract_key_raw(tuple, tuple_end,
+						index->def->cmp_def,
+						MULTIKEY_NONE, &size);
+	if (key == NULL)
+		return -1;
+	*pos = key;
+	*pos_end = key + size;
+	return 0;
+}
+
 char *
 box_tuple_extract_key(box_tuple_t *tuple, uint32_t space_id, uint32_t index_id,
 		      uint32_t *key_size)
@@ -361,6 +396,15 @@ box_index_count(uint32_t space_id, uint32_t index_id, int type,
 box_iterator_t *
 box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
                    const char *key, const char *key_end)
+{
+	return box_index_iterator_after(space_id, index_id, type,
+					key, key_end, NULL, NULL);
+}
+
+box_iterator_t *
+box_index_iterator_after(uint32_t space_id, uint32_t index_id, int type,
+			 const char *key, const char *key_end,
+			 const char *packed_pos, const char *packed_pos_end)
 {
 	assert(key != NULL && key_end != NULL);
 	mp_tuple_assert(key, key_end);
@@ -375,6 +419,7 @@ box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
 	if (check_index(space_id, index_id, &space, &index) != 0)
 		return NULL;
 	assert(mp_typeof(*key) == MP_ARRAY); /* checked by Lua */
+	const char *packed_key = key;
 	uint32_t part_count = mp_decode_array(&key);
 	if (key_validate(index->def, itype, key, part_count))
 		return NULL;
@@ -388,11 +433,39 @@ box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
 		txn_rollback_stmt(txn);
 		return NULL;
 	}
+	if (packed_pos != NULL &&
+	    iterator_start_after(it, itype, packed_key,
+				 packed_pos, packed_pos_end) != 0) {
+		iterator_delete(it);
+		txn_rollback_stmt(txn);
+		return NULL;
+	}
 	txn_commit_ro_stmt(txn, &svp);
 	rmean_collect(rmean_box, IPROTO_SELECT, 1);
 	return it;
 }
 
+const char *
+box_index_tuple_position(uint32_t space_id, uint32_t index_id,
+			 const char *tuple, const char *tuple_end,
+			 const char **packed_pos_end)
+{
+	mp_tuple_assert(tuple, tuple_end);
+	struct space *space;
+	struct index *index;
+	if (check_index(space_id, index_id, &space, &index) != 0)
+		return NULL;
+	(void)space;
+	if (index_check_position_support(index->def) != 0 ||
+	    tuple_validate_key_parts_raw(index->def->cmp_def, tuple) != 0)
+		return NULL;
+	const char *packed_pos;
+	if (index_tuple_position(index, tuple, tuple_end,
+				 &packed_pos, packed_pos_end) != 0)
+		return NULL;
+	return packed_pos;
+}
+
 int
 box_iterator_next(box_iterator_t *itr, box_tuple_t **result)
 {
@@ -447,6 +520,8 @@ iterator_create(struct iterator *it, struct index *index)
 	it->next_raw = NULL;
 	it->next = NULL;
 	it->free = NULL;
+	it->skip = NULL;
+	it->start_after = NULL;
 	it->space_cache_version = space_cache_version;
 	it->space_id = index->def->space_id;
 	it->index_id = index->def->iid;
@@ -494,6 +569,79 @@ iterator_next_raw(struct iterator *it, struct tuple **ret)
 	return it->next_raw(it, ret);
 }
 
+int
+iterator_skip(struct iterator *it, uint32_t count)
+{
+	if (it->skip != NULL && iterator_is_valid(it))
+		return it->skip(it, count);
+	struct tuple *tuple;
+	for (; count > 0; count--) {
+		if (iterator_next(it, &tuple) != 0)
+			return -1;
+		if (tuple == NULL)
+			break;
+	}
+	return 0;
+}
+
+/**
+ * Check that @a pos is a valid position in an index with the
+ * given cmp_def, see index_tuple_position(). On success, returns
+ * the position key without the array header in @a key and the
+ * number of parts in it in @a part_count.
+ */
+static int
+iterator_position_validate(struct key_def *cmp_def, const char *pos,
+			   const char *pos_end, const char **key,
+			   uint32_t *part_count)
+{
+	const char *p = pos;
+	if (pos == pos_end || mp_typeof(*pos) != MP_ARRAY ||
+	    mp_check(&p, pos_end) != 0 || p != pos_end)
+		goto invalid;
+	*key = pos;
+	*part_count = mp_decode_array(key);
+	if (*part_count != cmp_def->part_count ||
+	    key_validate_parts(cmp_def, *key, *part_count, true, &p) != 0)
+		goto invalid;
+	return 0;
+invalid:
+	diag_set(ClientError, ER_ILLEGAL_PARAMS, "Invalid iterator position");
+	return -1;
+}
+
+int
+iterator_start_after(struct iterator *it, enum iterator_type type,
+		     const char *key, const char *pos, const char *pos_end)
+{
+	struct index_def *def = it->index->def;
+	struct key_def *cmp_def = def->cmp_def;
+	if (index_check_position_support(def) != 0)
+		return -1;
+	const char *pos_key;
+	uint32_t part_count;
+	if (iterator_position_validate(cmp_def, pos, pos_end,
+				       &pos_key, &part_count) != 0)
+		return -1;
+	const char *key_parts = key;
+	if (key != NULL && mp_decode_array(&key_parts) > 0) {
+		/*
+		 * If the position precedes the iteration range,
+		 * iterate from the beginning of the range.
+		 */
+		int cmp = key_compare(pos, HINT_NONE, key, HINT_NONE, cmp_def);
+		cmp *= iterator_direction(type);
+		if (cmp < 0 ||
+		    (cmp == 0 && (type == ITER_GT || type == ITER_LT)))
+			return 0;
+	}
+	if (it->start_after == NULL) {
+		diag_set(UnsupportedIndexFeature, def, "pagination");
+		return -1;
+	}
+	return it->start_after(it, pos_key, part_count);
+}
+
 void
 iterator_delete(struct iterator *it)
 {
@@ -685,6 +833,23 @@ generic_index_get(struct index *index, const char *key,
 	return -1;
 }
 
+int
+generic_index_get_many(struct index *index, const char *keys,
+		       uint32_t key_count, struct port *port)
+{
+	for (uint32_t i = 0; i < key_count; i++) {
+		const char *key = keys;
+		mp_next(&keys);
+		uint32_t part_count = mp_decode_array(&key);
+		struct tuple *tuple;
+		if (index_get(index, key, part_count, &tuple) != 0)
+			return -1;
+		if (tuple != NULL && port_c_add_tuple(port, tuple) != 0)
+			return -1;
+	}
+	return 0;
+}
+
 int
 generic_index_replace(struct index *index, struct tuple *old_tuple,
 		      struct tuple *new_tuple, enum dup_replace_mode mode,
@@ -45,6 +45,7 @@ struct index;
 struct index_def;
 struct key_def;
 struct info_handler;
+struct port;
 
 typedef struct tuple box_tuple_t;
 typedef struct key_def box_key_def_t;
@@ -236,6 +237,34 @@ box_index_stat(uint32_t space_id, uint32_t index_id,
 int
 box_index_compact(uint32_t space_id, uint32_t index_id);
 
+/**
+ * Same as box_index_iterator(), but the iteration starts after
+ * the given position, see iterator_start_after().
+ * Private, used by Lua.
+ *
+ * \param packed_pos position or NULL to start from the beginning
+ * \param packed_pos_end the end of \a packed_pos
+ */
+box_iterator_t *
+box_index_iterator_after(uint32_t space_id, uint32_t index_id, int type,
+			 const char *key, const char *key_end,
+			 const char *packed_pos, const char *packed_pos_end);
+
+/**
+ * Get the position of a tuple in an index, see index_tuple_position().
+ * Private, used by Lua.
+ *
+ * \param tuple encoded tuple in MsgPack Array format
+ * \param tuple_end the end of encoded \a tuple
+ * \param[out] packed_pos_end the end of the returned position
+ * \retval NULL on error (check box_error_last())
+ * \retval position allocated on the fiber region
+ */
+const char *
+box_index_tuple_position(uint32_t space_id, uint32_t index_id,
+			 const char *tuple, const char *tuple_end,
+			 const char **packed_pos_end);
+
 struct iterator {
         /**
          * Same as next(), but returns a tuple as it is stored in the index,
@@ -251,6 +280,21 @@ struct iterator {
 	int (*next)(struct iterator *it, struct tuple **ret);
 	/** Destroy the iterator. */
 	void (*free)(struct iterator *);
+	/**
+	 * Skip @a count tuples before the first call of next().
+	 * Returns 0 on success, -1 on error. NULL if the index
+	 * can't do it faster than calling next() @a count times.
+	 */
+	int (*skip)(struct iterator *it, uint32_t count);
+	/**
+	 * Make the iterator return tuples following the one with
+	 * the given key before the first call of next(). The key
+	 * is a full key of the index cmp_def without the array
+	 * header. The key is guaranteed not to precede the range
+	 * of the iterator. NULL if the index doesn't support it.
+	 */
+	int (*start_after)(struct iterator *it, const char *key,
+			   uint32_t part_count);
 	/** Space cache version at the time of the last index lookup. */
 	uint32_t space_cache_version;
 	/** ID of the space the iterator is for. */
@@ -293,6 +337,30 @@ iterator_next(struct iterator *it, struct tuple **ret);
 int
 iterator_next_raw(struct iterator *it, struct tuple **ret);
 
+/**
+ * Skip @a count tuples. Must be called before the first
+ * call of iterator_next().
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+iterator_skip(struct iterator *it, uint32_t count);
+
+/**
+ * Make an iterator return tuples following the position @a pos
+ * in its index, see index_tuple_position(). Must be called
+ * before the first call of iterator_next().
+ *
+ * @param type type the iterator was created with
+ * @param key search key the iterator was created with
+ *        (MsgPack array) or NULL
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+iterator_start_after(struct iterator *it, enum iterator_type type,
+		     const char *key, const char *pos, const char *pos_end);
+
 /**
  * Destroy an iterator instance and free associated memory.
  */
@@ -343,6 +411,26 @@ int
 exact_key_validate(struct key_def *key_def, const char *key,
 		   uint32_t part_count);
 
+/**
+ * Get the position of a tuple in an index: the key of the tuple
+ * extracted by the index cmp_def (MsgPack array). Since cmp_def
+ * includes the primary key parts, the position identifies the
+ * tuple in the index uniquely, so it can be used for continuing
+ * iteration after the tuple, see iterator_start_after().
+ *
+ * @param tuple MsgPack'ed tuple
+ * @param tuple_end the end of @a tuple
+ * @param[out] pos the position, allocated on the fiber region
+ * @param[out] pos_end the end of @a pos
+ *
+ * @retval 0  Success.
+ * @retval -1 The index doesn't support positions or memory error.
+ */
+int
+index_tuple_position(struct index *index, const char *tuple,
+		     const char *tuple_end, const char **pos,
+		     const char **pos_end);
+
 /**
  * The manner in which replace in a unique index must treat
  * duplicates (tuples with the same value of indexed key),
@@ -430,6 +518,14 @@ struct index_vtab {
                        uint32_t part_count, struct tuple **result);
 	int (*get)(struct index *index, const char *key,
 		   uint32_t part_count, struct tuple **result);
+	/**
+	 * Look up tuples by @a key_count full keys stored one after
+	 * another in @a keys, each encoded as a MsgPack array. Found
+	 * tuples are appended to @a port in the order of the keys,
+	 * keys that aren't found are skipped.
+	 */
+	int (*get_many)(struct index *index, const char *keys,
+			uint32_t key_count, struct port *port);
 	/**
 	 * Main entrance point for changing data in index. Once built and
 	 * before deletion this is the only way to insert, replace and delete
@@ -666,6 +762,13 @@ index_get(struct index *index, const char *key,
 	return index->vtab->get(index, key, part_count, result);
 }
 
+static inline int
+index_get_many(struct index *index, const char *keys,
+	       uint32_t key_count, struct port *port)
+{
+	return index->vtab->get_many(index, keys, key_count, port);
+}
+
 /**
  * Get tuple to be inserted in index, based on index-specific constraints
  * (current constraint: if exclude_null = true, return NULL)
@@ -775,6 +878,8 @@ ssize_t generic_index_count(struct index *, enum iterator_type,
 int generic_index_get_raw(struct index *, const char *, uint32_t,
                           struct tuple **);
 int generic_index_get(struct index *, const char *, uint32_t, struct tuple **);
+int generic_index_get_many(struct index *, const char *, uint32_t,
+			   struct port *);
 int generic_index_replace(struct index *, struct tuple *, struct tuple *,
 			  enum dup_replace_mode,
 			  struct tuple **, struct tuple **);
@@ -52,6 +52,7 @@ const struct index_opts index_opts_default = {
 	/* .stat                = */ NULL,
 	/* .func                = */ 0,
 	/* .hint                = */ true,
+	/* .fast_offset         = */ false,
 };
 
 const struct opt_def index_opts_reg[] = {
@@ -68,6 +69,7 @@ const struct opt_def index_opts_reg[] = {
 	OPT_DEF("func", OPT_UINT32, struct index_opts, func_id),
 	OPT_DEF_LEGACY("sql"),
 	OPT_DEF("hint", OPT_BOOL, struct index_opts, hint),
+	OPT_DEF("fast_offset", OPT_BOOL, struct index_opts, fast_offset),
 	OPT_END,
 };
 
@@ -92,8 +92,8 @@ struct index_sample {
  * SQL statistics for index, which is used by query planer.
  * This is general statistics, without any relation to used
  * engine and data structures (e.g. B-tree or LSM tree).
- * Statistics appear only after executing ANALYZE statement.
- * It is loaded from _sql_stat1 and _sql_stat4 system spaces.
+ * Statistics are collected in the background and stored in the
+ * _sql_stat space, see sql_stat.h.
  */
 struct index_stat {
 	/** An array of samples of them left-most key. */
@@ -118,6 +118,11 @@ struct index_stat {
 	bool is_unordered;
 	/** Don't try to use skip-scan optimization if true. */
 	bool skip_scan_enabled;
+	/**
+	 * Number of changes of the space, see space::change_count,
+	 * at the moment the statistics were collected.
+	 */
+	uint64_t change_count;
 };
 
 /** Index options */
@@ -159,8 +164,8 @@ struct index_opts {
 	int64_t lsn;
 	/**
 	 * SQL specific statistics concerning tuples
-	 * distribution for query planer. It is automatically
-	 * filled after running ANALYZE command.
+	 * distribution for query planer. It is filled by the
+	 * statistics collector, see sql_stat.h.
 	 */
 	struct index_stat *stat;
 	/** Identifier of the functional index function. */
@@ -169,6 +174,11 @@ struct index_opts {
 	 * Use hint optimization for tree index.
 	 */
 	bool hint;
+	/**
+	 * Keep the number of elements in each subtree of a tree
+	 * index, so that offset and count are O(log n).
+	 */
+	bool fast_offset;
 };
 
 extern const struct index_opts index_opts_default;
@@ -217,6 +227,8 @@ index_opts_cmp(const struct index_opts *o1, const struct index_opts *o2)
 		return o1->func_id - o2->func_id;
 	if (o1->hint != o2->hint)
 		return o1->hint - o2->hint;
+	if (o1->fast_offset != o2->fast_offset)
+		return o1->fast_offset - o2->fast_offset;
 	return 0;
 }
 
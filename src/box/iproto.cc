@@ -55,14 +55,17 @@
 #include "port.h"
 #include "box.h"
 #include "call.h"
+#include "tuple.h"
 #include "tuple_convert.h"
 #include "session.h"
 #include "xrow.h"
 #include "schema.h" /* schema_version */
 #include "replication.h" /* instance_uuid */
+#include "iproto_compression.h"
 #include "iproto_constants.h"
 #include "iproto_features.h"
 #include "rmean.h"
+#include "clock.h"
 #include "execute.h"
 #include "errinj.h"
 #include "tt_static.h"
@@ -74,6 +77,13 @@
 enum {
 	IPROTO_SALT_SIZE = 32,
 	IPROTO_PACKET_SIZE_MAX = 2UL * 1024 * 1024 * 1024,
+	/**
+	 * Tuples of this size or larger are not copied to the output
+	 * buffer in response to SELECT, see struct iproto_splice.
+	 */
+	IPROTO_SPLICE_SIZE_MIN = 4096,
+	/** Max number of splices written by a single writev(). */
+	IPROTO_SPLICE_BATCH_MAX = 32,
 };
 
 enum {
@@ -126,6 +136,47 @@ iproto_wpos_create(struct iproto_wpos *wpos, struct obuf *out)
 	wpos->svp = obuf_create_svp(out);
 }
 
+/**
+ * Tuple data inserted into a connection output buffer without
+ * copying. The tx thread references the tuple and records the
+ * position in the output buffer the data belongs to, and the
+ * iproto thread writes the data right from the tuple when it
+ * reaches this position (see iproto_flush()). Once the data is
+ * written, the splice is handed back to the tx thread to release
+ * the tuple (see iproto_connection_release_splices()).
+ */
+struct iproto_splice {
+	/** Link in a splice list. */
+	struct stailq_entry in_list;
+	/** Output buffer the data is inserted into. */
+	struct obuf *obuf;
+	/** Size of the output buffer data preceding the tuple data. */
+	size_t used;
+	/** Referenced tuple. */
+	struct tuple *tuple;
+	/** Tuple data. */
+	const char *data;
+	/** Size of the tuple data. */
+	size_t size;
+	/** Number of bytes of the data written to the socket. */
+	size_t written;
+};
+
+/** Memory pool for splices, used by the tx thread. */
+static struct mempool iproto_splice_pool;
+
+/** Release tuples referenced by splices and free them. */
+static void
+tx_release_splices(struct stailq *splices)
+{
+	struct iproto_splice *splice, *next;
+	stailq_foreach_entry_safe(splice, next, splices, in_list) {
+		tuple_unref(splice->tuple);
+		mempool_free(&iproto_splice_pool, splice);
+	}
+	stailq_create(splices);
+}
+
 struct iproto_thread {
 	/**
 	 * Slab cache used for allocating memory for output network buffers
@@ -158,6 +209,7 @@ struct iproto_thread {
 	struct cmsg_hop rollback_on_disconnect_route[2];
 	struct cmsg_hop destroy_route[2];
 	struct cmsg_hop disconnect_route[2];
+	struct cmsg_hop release_splices_route[2];
 	struct cmsg_hop misc_route[2];
 	struct cmsg_hop call_route[2];
 	struct cmsg_hop select_route[2];
@@ -183,6 +235,8 @@ struct iproto_thread {
 	 * Iproto thread stat
 	 */
 	struct rmean *rmean;
+	/** Request latency stat collected in iproto thread. */
+	struct iproto_latency_stat *latency;
 	/*
 	 * Iproto thread id
 	 */
@@ -201,6 +255,8 @@ struct iproto_thread {
 		size_t requests_in_progress;
 		/** Iproto thread stat collected in tx thread. */
 		struct rmean *rmean;
+		/** Request latency stat collected in tx thread. */
+		struct iproto_latency_stat *latency;
 	} tx;
 };
 
@@ -374,6 +430,20 @@ struct iproto_msg
 	struct stailq_entry in_stream;
 	/** Stream that owns this message, or NULL. */
 	struct iproto_stream *stream;
+	/**
+	 * Splices inserted into the response by the tx thread
+	 * (see struct iproto_splice).
+	 */
+	struct stailq splices;
+	/**
+	 * Time when the request was read from the socket, when
+	 * the tx thread started and finished processing it, in
+	 * nanoseconds, see clock_monotonic64(). Used for latency
+	 * statistics.
+	 */
+	uint64_t recv_time;
+	uint64_t process_time;
+	uint64_t reply_time;
 };
 
 static struct iproto_msg *
@@ -417,6 +487,26 @@ const char *rmean_tx_strings[RMEAN_TX_LAST] = {
 	"REQUESTS_IN_PROGRESS",
 };
 
+const char *iproto_latency_stage_strs[IPROTO_LATENCY_STAGE_MAX] = {
+	"queue",
+	"tx",
+	"wal",
+	"net",
+	"total",
+};
+
+/**
+ * Account the time a request spent in a processing stage,
+ * in nanoseconds.
+ */
+static inline void
+iproto_latency_collect(struct iproto_latency_stat *stat, uint32_t type,
+		       enum iproto_latency_stage stage, uint64_t time)
+{
+	if (type < IPROTO_TYPE_STAT_MAX)
+		hdr_histogram_collect(&stat->hist[type][stage], time / 1000);
+}
+
 static void
 tx_process_destroy(struct cmsg *m);
 
@@ -544,6 +634,45 @@ struct iproto_connection
 	 * output is available (see iproto_msg::wpos).
 	 */
 	struct iproto_wpos wend;
+	/**
+	 * Splices that have not been written to the socket yet,
+	 * ordered by their position in the output.
+	 */
+	struct stailq splices;
+	/**
+	 * Splices that have been written to the socket and wait
+	 * to be returned to the tx thread.
+	 */
+	struct stailq done_splices;
+	/**
+	 * Pre-allocated message returning written splices to the
+	 * tx thread right after they are flushed, so that an idle
+	 * connection doesn't keep tuples referenced.
+	 */
+	struct cmsg release_splices_msg;
+	/** Splices carried to the tx thread by release_splices_msg. */
+	struct stailq released_splices;
+	/** Set while release_splices_msg is in the tx thread. */
+	bool is_release_in_progress;
+	/**
+	 * Compression level requested by the client with IPROTO_ID,
+	 * 0 if the output isn't compressed.
+	 */
+	int compression_level;
+	/**
+	 * Set if the output written to the socket so far ends at
+	 * a packet boundary, i.e. compression may be switched on.
+	 */
+	bool is_write_aligned;
+	/**
+	 * Compressor of the output. Created once the client has
+	 * asked for compression and the output is aligned, zstream
+	 * is NULL until then. Once the compressor is created, all
+	 * the output goes through zbuf.
+	 */
+	struct iproto_compressor compressor;
+	/** Output packed by the compressor, not written yet. */
+	struct ibuf zbuf;
 	/*
 	 * Size of readahead which is not parsed yet, i.e. size of
 	 * a piece of request which is not fully read. Is always
@@ -754,6 +883,8 @@ iproto_msg_new(struct iproto_connection *con)
 	msg->close_connection = false;
 	msg->connection = con;
 	msg->stream = NULL;
+	stailq_create(&msg->splices);
+	msg->recv_time = clock_monotonic64();
 	rmean_collect(con->iproto_thread->rmean, IPROTO_REQUESTS, 1);
 	return msg;
 }
@@ -806,6 +937,7 @@ iproto_connection_is_idle(struct iproto_connection *con)
 	 * errors in the future.
 	 */
 	return con->long_poll_count == 0 &&
+	       !con->is_release_in_progress &&
 	       mh_size(con->streams) == 0 &&
 	       ibuf_used(&con->ibuf[0]) == 0 &&
 	       ibuf_used(&con->ibuf[1]) == 0;
@@ -1302,64 +1434,351 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	}
 }
 
+/**
+ * Return the first splice not written to the socket yet if it
+ * belongs to the given output buffer, NULL otherwise.
+ */
+static struct iproto_splice *
+iproto_connection_first_splice(struct iproto_connection *con,
+			       struct obuf *obuf)
+{
+	if (stailq_empty(&con->splices))
+		return NULL;
+	struct iproto_splice *splice = stailq_first_entry(
+		&con->splices, struct iproto_splice, in_list);
+	return splice->obuf == obuf ? splice : NULL;
+}
+
+/** Move splices that have been written to the done list. */
+static void
+iproto_connection_complete_splices(struct iproto_connection *con)
+{
+	while (!stailq_empty(&con->splices)) {
+		struct iproto_splice *splice = stailq_first_entry(
+			&con->splices, struct iproto_splice, in_list);
+		if (splice->written < splice->size)
+			break;
+		stailq_shift(&con->splices);
+		stailq_add_tail_entry(&con->done_splices, splice, in_list);
+	}
+}
+
+/** Discard all splices not written to the socket yet. */
+static void
+iproto_connection_discard_splices(struct iproto_connection *con)
+{
+	stailq_concat(&con->done_splices, &con->splices);
+}
+
+/**
+ * Send the splices that have been written to the socket to the
+ * tx thread to release their tuples. Only one batch of splices
+ * is in flight at a time, the rest are sent when it returns.
+ */
+static void
+iproto_connection_release_splices(struct iproto_connection *con)
+{
+	if (con->is_release_in_progress || stailq_empty(&con->done_splices))
+		return;
+	stailq_concat(&con->released_splices, &con->done_splices);
+	con->is_release_in_progress = true;
+	cpipe_push(&con->iproto_thread->tx_pipe, &con->release_splices_msg);
+}
+
+/**
+ * Append @a size bytes of output buffer data to @a iov, starting
+ * at offset @a src_offset of @a src iov entry. Advance the source
+ * position. Return the new number of entries in @a iov.
+ */
+static int
+iproto_iov_append(struct iovec *iov, struct iproto_splice **owner,
+		  int iovcnt, const struct iovec *src, int *src_pos,
+		  size_t *src_offset, size_t size)
+{
+	while (size > 0) {
+		const struct iovec *chunk = &src[*src_pos];
+		size_t len = MIN(size, chunk->iov_len - *src_offset);
+		if (len > 0) {
+			iov[iovcnt].iov_base = (char *)chunk->iov_base +
+					       *src_offset;
+			iov[iovcnt].iov_len = len;
+			owner[iovcnt] = NULL;
+			iovcnt++;
+			size -= len;
+			*src_offset += len;
+		}
+		if (*src_offset == chunk->iov_len) {
+			(*src_pos)++;
+			*src_offset = 0;
+		}
+	}
+	return iovcnt;
+}
+
+/** Append output data to the packed output of a connection. */
+static int
+iproto_connection_pack_data(struct iproto_connection *con, const char *data,
+			    size_t size, bool compress)
+{
+	if (size == 0)
+		return 0;
+	if (compress) {
+		struct iovec iov = {(void *)data, size};
+		return iproto_compressor_write(&con->compressor, &iov, 1,
+					       &con->zbuf);
+	}
+	void *buf = ibuf_alloc(&con->zbuf, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "ibuf_alloc", "buf");
+		return -1;
+	}
+	memcpy(buf, data, size);
+	return 0;
+}
+
+/**
+ * Pack the output buffer data between @a begin and @a end along
+ * with the tuple data inserted into it to the connection zbuf.
+ * The data is compressed unless it's smaller than the configured
+ * minimum, in which case it's copied as is.
+ */
+static int
+iproto_connection_pack(struct iproto_connection *con, struct obuf *obuf,
+		       struct obuf_svp *begin, struct obuf_svp *end)
+{
+	struct iproto_splice *first =
+		iproto_connection_first_splice(con, obuf);
+	size_t size = end->used - begin->used;
+	struct iproto_splice *splice;
+	for (splice = first; splice != NULL; ) {
+		size += splice->size - splice->written;
+		struct stailq_entry *next = stailq_next(&splice->in_list);
+		splice = next == NULL ? NULL :
+			 stailq_entry(next, struct iproto_splice, in_list);
+		if (splice != NULL && splice->obuf != obuf)
+			splice = NULL;
+	}
+	bool compress = size >= iproto_compression_min_size;
+	if (compress &&
+	    iproto_compressor_begin(&con->compressor, &con->zbuf) != 0)
+		return -1;
+	splice = first;
+	size_t used = begin->used;
+	for (size_t pos = begin->pos; pos <= end->pos; pos++) {
+		/*
+		 * iov[i].iov_len may be concurrently modified in tx
+		 * thread, but only for the last position.
+		 */
+		const char *data = (const char *)obuf->iov[pos].iov_base;
+		size_t len = pos == end->pos ? end->iov_len :
+			     obuf->iov[pos].iov_len;
+		if (pos == begin->pos) {
+			data += begin->iov_len;
+			len -= begin->iov_len;
+		}
+		while (splice != NULL && splice->used <= used + len) {
+			size_t n = splice->used - used;
+			if (iproto_connection_pack_data(con, data, n,
+							compress) != 0 ||
+			    iproto_connection_pack_data(
+					con, splice->data + splice->written,
+					splice->size - splice->written,
+					compress) != 0)
+				return -1;
+			splice->written = splice->size;
+			data += n;
+			len -= n;
+			used += n;
+			struct stailq_entry *next =
+				stailq_next(&splice->in_list);
+			splice = next == NULL ? NULL :
+				 stailq_entry(next, struct iproto_splice,
+					      in_list);
+			if (splice != NULL && splice->obuf != obuf)
+				splice = NULL;
+		}
+		if (iproto_connection_pack_data(con, data, len, compress) != 0)
+			return -1;
+		used += len;
+	}
+	assert(used == end->used && splice == NULL);
+	if (compress &&
+	    iproto_compressor_end(&con->compressor, &con->zbuf) != 0)
+		return -1;
+	iproto_connection_complete_splices(con);
+	*begin = *end;
+	return 0;
+}
+
+/** write() the packed output to the socket and handle the result. */
+static int
+iproto_flush_packed(struct iproto_connection *con)
+{
+	struct ibuf *zbuf = &con->zbuf;
+	assert(ibuf_used(zbuf) > 0);
+	if (!con->can_write) {
+		/* Receiving end was closed. Discard the output. */
+		ibuf_reset(zbuf);
+		return 0;
+	}
+	ssize_t nwr = iostream_write(&con->io, zbuf->rpos, ibuf_used(zbuf));
+	if (nwr >= 0) {
+		/* Count statistics */
+		rmean_collect(con->iproto_thread->rmean, IPROTO_SENT, nwr);
+		zbuf->rpos += nwr;
+		if (ibuf_used(zbuf) > 0)
+			return IOSTREAM_WANT_WRITE;
+		ibuf_reset(zbuf);
+		return 0;
+	} else if (nwr == IOSTREAM_ERROR) {
+		/* See the comment in iproto_flush(). */
+		diag_log();
+		con->can_write = false;
+		ibuf_reset(zbuf);
+		return 0;
+	}
+	return nwr;
+}
+
 /** writev() to the socket and handle the result. */
 static int
 iproto_flush(struct iproto_connection *con)
 {
+	if (ibuf_used(&con->zbuf) > 0)
+		return iproto_flush_packed(con);
 	struct obuf *obuf = con->wpos.obuf;
 	struct obuf_svp obuf_end = obuf_create_svp(obuf);
 	struct obuf_svp *begin = &con->wpos.svp;
 	struct obuf_svp *end = &con->wend.svp;
+	struct iproto_splice *splice =
+		iproto_connection_first_splice(con, obuf);
 	if (con->wend.obuf != obuf) {
 		/*
-		 * Flush the current buffer before
-		 * advancing to the next one.
+		 * Flush the current buffer, including the tuple
+		 * data inserted into it, before advancing to the
+		 * next one.
 		 */
-		if (begin->used == obuf_end.used) {
+		if (begin->used == obuf_end.used && splice == NULL) {
 			obuf = con->wpos.obuf = con->wend.obuf;
 			obuf_svp_reset(begin);
+			splice = iproto_connection_first_splice(con, obuf);
 		} else {
 			end = &obuf_end;
 		}
 	}
-	if (begin->used == end->used) {
+	if (begin->used == end->used && splice == NULL) {
 		/* Nothing to do. */
 		return 1;
 	}
 	if (!con->can_write) {
 		/* Receiving end was closed. Discard the output. */
 		*begin = *end;
+		iproto_connection_discard_splices(con);
 		return 0;
 	}
-	assert(begin->used < end->used);
-	struct iovec iov[SMALL_OBUF_IOV_MAX+1];
+	assert(begin->used <= end->used);
+	if (con->compression_level > 0 && con->compressor.zstream == NULL &&
+	    con->is_write_aligned &&
+	    iproto_compressor_create(&con->compressor,
+				     con->compression_level) != 0) {
+		/* Go on without compression. */
+		diag_log();
+		con->compression_level = 0;
+	}
+	if (con->compressor.zstream != NULL) {
+		if (iproto_connection_pack(con, obuf, begin, end) != 0) {
+			/* Handle it as a write error. */
+			diag_log();
+			con->can_write = false;
+			*begin = *end;
+			iproto_connection_discard_splices(con);
+			ibuf_reset(&con->zbuf);
+			return 0;
+		}
+		return iproto_flush_packed(con);
+	}
+	struct iovec obuf_iov[SMALL_OBUF_IOV_MAX+1];
 	struct iovec *src = obuf->iov;
-	int iovcnt = end->pos - begin->pos + 1;
+	int obuf_iovcnt = end->pos - begin->pos + 1;
 	/*
 	 * iov[i].iov_len may be concurrently modified in tx thread,
 	 * but only for the last position.
 	 */
-	memcpy(iov, src + begin->pos, iovcnt * sizeof(struct iovec));
-	sio_add_to_iov(iov, -begin->iov_len);
+	memcpy(obuf_iov, src + begin->pos, obuf_iovcnt * sizeof(struct iovec));
+	sio_add_to_iov(obuf_iov, -begin->iov_len);
 	/* *Overwrite* iov_len of the last pos as it may be garbage. */
-	iov[iovcnt-1].iov_len = end->iov_len - begin->iov_len * (iovcnt == 1);
+	obuf_iov[obuf_iovcnt-1].iov_len = end->iov_len -
+					  begin->iov_len * (obuf_iovcnt == 1);
+	/*
+	 * Interleave the output buffer data with the tuple data
+	 * inserted into it. The data following a splice that does
+	 * not fit in this writev() is left for the next one.
+	 */
+	struct iovec iov[SMALL_OBUF_IOV_MAX + 1 + 2 * IPROTO_SPLICE_BATCH_MAX];
+	/* Splice owning each iov entry, NULL for the buffer data. */
+	struct iproto_splice *owner[lengthof(iov)];
+	int iovcnt = 0;
+	int src_pos = 0;
+	size_t src_offset = 0;
+	size_t used = begin->used;
+	size_t limit = end->used;
+	for (int i = 0; splice != NULL; i++) {
+		assert(splice->used >= used && splice->used <= end->used);
+		if (i == IPROTO_SPLICE_BATCH_MAX) {
+			limit = splice->used;
+			break;
+		}
+		iovcnt = iproto_iov_append(iov, owner, iovcnt, obuf_iov,
+					   &src_pos, &src_offset,
+					   splice->used - used);
+		used = splice->used;
+		iov[iovcnt].iov_base = (char *)splice->data + splice->written;
+		iov[iovcnt].iov_len = splice->size - splice->written;
+		owner[iovcnt] = splice;
+		iovcnt++;
+		struct stailq_entry *next = stailq_next(&splice->in_list);
+		splice = next == NULL ? NULL :
+			 stailq_entry(next, struct iproto_splice, in_list);
+		if (splice != NULL && splice->obuf != obuf)
+			splice = NULL;
+	}
+	iovcnt = iproto_iov_append(iov, owner, iovcnt, obuf_iov, &src_pos,
+				   &src_offset, limit - used);
+	assert(iovcnt > 0);
 
 	ssize_t nwr = iostream_writev(&con->io, iov, iovcnt);
 	if (nwr >= 0) {
 		/* Count statistics */
 		rmean_collect(con->iproto_thread->rmean, IPROTO_SENT, nwr);
-		if (begin->used + nwr == end->used) {
+		size_t obuf_nwr = 0;
+		size_t left = nwr;
+		bool is_complete = true;
+		for (int i = 0; i < iovcnt; i++) {
+			size_t len = MIN(left, iov[i].iov_len);
+			if (owner[i] != NULL)
+				owner[i]->written += len;
+			else
+				obuf_nwr += len;
+			left -= len;
+			if (len < iov[i].iov_len) {
+				is_complete = false;
+				break;
+			}
+		}
+		iproto_connection_complete_splices(con);
+		con->is_write_aligned = is_complete && limit == end->used;
+		if (begin->used + obuf_nwr == end->used) {
 			*begin = *end;
-			return 0;
+			return is_complete ? 0 : IOSTREAM_WANT_WRITE;
 		}
 		size_t offset = 0;
 		int advance = 0;
-		advance = sio_move_iov(iov, nwr, &offset);
-		begin->used += nwr;             /* advance write position */
+		advance = sio_move_iov(obuf_iov, obuf_nwr, &offset);
+		begin->used += obuf_nwr;        /* advance write position */
 		begin->iov_len = advance == 0 ? begin->iov_len + offset: offset;
 		begin->pos += advance;
 		assert(begin->pos <= end->pos);
-		return IOSTREAM_WANT_WRITE;
+		return is_complete ? 0 : IOSTREAM_WANT_WRITE;
 	} else if (nwr == IOSTREAM_ERROR) {
 		/*
 		 * Don't close the connection on write error. Log the error and
@@ -1370,6 +1789,7 @@ iproto_flush(struct iproto_connection *con)
 		diag_log();
 		con->can_write = false;
 		*begin = *end;
+		iproto_connection_discard_splices(con);
 		return 0;
 	}
 	return nwr;
@@ -1384,6 +1804,7 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 	int rc;
 	while ((rc = iproto_flush(con)) <= 0) {
 		if (rc != 0) {
+			iproto_connection_release_splices(con);
 			int events = iostream_status_to_events(rc);
 			if (con->output.events != events) {
 				ev_io_stop(loop, &con->output);
@@ -1393,6 +1814,7 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 			return;
 		}
 	}
+	iproto_connection_release_splices(con);
 	if (ev_is_active(&con->output))
 		ev_io_stop(con->loop, &con->output);
 	/*
@@ -1430,6 +1852,14 @@ iproto_connection_new(struct iproto_thread *iproto_thread)
 	con->tx.p_obuf = &con->obuf[0];
 	iproto_wpos_create(&con->wpos, con->tx.p_obuf);
 	iproto_wpos_create(&con->wend, con->tx.p_obuf);
+	stailq_create(&con->splices);
+	stailq_create(&con->done_splices);
+	stailq_create(&con->released_splices);
+	con->is_release_in_progress = false;
+	con->compression_level = 0;
+	con->is_write_aligned = true;
+	con->compressor.zstream = NULL;
+	ibuf_create(&con->zbuf, cord_slab_cache(), iproto_readahead);
 	con->parse_size = 0;
 	con->can_write = true;
 	con->long_poll_count = 0;
@@ -1438,6 +1868,8 @@ iproto_connection_new(struct iproto_thread *iproto_thread)
 	/* It may be very awkward to allocate at close. */
 	cmsg_init(&con->destroy_msg, con->iproto_thread->destroy_route);
 	cmsg_init(&con->disconnect_msg, con->iproto_thread->disconnect_route);
+	cmsg_init(&con->release_splices_msg,
+		  con->iproto_thread->release_splices_route);
 	con->state = IPROTO_CONNECTION_ALIVE;
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = false;
@@ -1463,6 +1895,12 @@ iproto_connection_delete(struct iproto_connection *con)
 	       con->obuf[0].iov[0].iov_base == NULL);
 	assert(con->obuf[1].pos == 0 &&
 	       con->obuf[1].iov[0].iov_base == NULL);
+	assert(stailq_empty(&con->splices));
+	assert(stailq_empty(&con->done_splices));
+	assert(stailq_empty(&con->released_splices));
+	if (con->compressor.zstream != NULL)
+		iproto_compressor_destroy(&con->compressor);
+	ibuf_destroy(&con->zbuf);
 
 	assert(mh_size(con->streams) == 0);
 	mh_i64ptr_delete(con->streams);
@@ -1614,6 +2052,10 @@ iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		});
 		if (xrow_decode_id(&msg->header, &msg->id) != 0)
 			goto error;
+		if (iproto_features_test(&msg->id.features,
+					 IPROTO_FEATURE_COMPRESSION))
+			msg->connection->compression_level =
+				iproto_compression_level;
 		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	case IPROTO_JOIN:
@@ -1659,6 +2101,7 @@ tx_fiber_init(struct session *session, uint64_t sync)
 	 */
 	assert(rlist_empty(&f->on_stop));
 	f->storage.net.sync = sync;
+	f->storage.net.wal_wait_time = 0;
 	/*
 	 * We do not cleanup fiber keys at the end of each request.
 	 * This does not lead to privilege escalation as long as
@@ -1734,6 +2177,26 @@ net_finish_disconnect(struct cmsg *m)
 	iproto_connection_try_to_start_destroy(con);
 }
 
+static void
+tx_process_release_splices(struct cmsg *m)
+{
+	struct iproto_connection *con =
+		container_of(m, struct iproto_connection, release_splices_msg);
+	tx_release_splices(&con->released_splices);
+}
+
+static void
+net_finish_release_splices(struct cmsg *m)
+{
+	struct iproto_connection *con =
+		container_of(m, struct iproto_connection, release_splices_msg);
+	con->is_release_in_progress = false;
+	if (con->state == IPROTO_CONNECTION_ALIVE)
+		iproto_connection_release_splices(con);
+	else if (iproto_connection_is_idle(con))
+		iproto_connection_close(con);
+}
+
 /**
  * Destroy the session object, as well as output buffers of the
  * connection.
@@ -1749,11 +2212,13 @@ tx_process_destroy(struct cmsg *m)
 		con->session = NULL; /* safety */
 	}
 	/*
-	 * obuf is being destroyed in tx thread cause it is where
-	 * it was allocated.
+	 * obuf and splices are being destroyed in tx thread cause
+	 * it is where they were allocated.
 	 */
 	obuf_destroy(&con->obuf[0]);
 	obuf_destroy(&con->obuf[1]);
+	tx_release_splices(&con->splices);
+	tx_release_splices(&con->done_splices);
 }
 
 /**
@@ -1869,9 +2334,13 @@ tx_accept_msg(struct cmsg *m)
 	tx_accept_wpos(msg->connection, &msg->wpos);
 	tx_fiber_init(msg->connection->session, msg->header.sync);
 	tx_prepare_transaction_for_request(msg);
-	msg->connection->iproto_thread->tx.requests_in_progress++;
-	rmean_collect(msg->connection->iproto_thread->tx.rmean,
-		      REQUESTS_IN_PROGRESS, 1);
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
+	iproto_thread->tx.requests_in_progress++;
+	rmean_collect(iproto_thread->tx.rmean, REQUESTS_IN_PROGRESS, 1);
+	msg->process_time = clock_monotonic64();
+	iproto_latency_collect(iproto_thread->tx.latency, msg->header.type,
+			       IPROTO_LATENCY_QUEUE,
+			       msg->process_time - msg->recv_time);
 	return msg;
 }
 
@@ -1882,7 +2351,19 @@ tx_end_msg(struct iproto_msg *msg)
 		assert(msg->stream->txn == NULL);
 		msg->stream->txn = txn_detach();
 	}
-	msg->connection->iproto_thread->tx.requests_in_progress--;
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
+	iproto_thread->tx.requests_in_progress--;
+	msg->reply_time = clock_monotonic64();
+	uint64_t wal_wait_time = fiber()->storage.net.wal_wait_time;
+	uint64_t process_time = msg->reply_time - msg->process_time;
+	process_time -= MIN(wal_wait_time, process_time);
+	iproto_latency_collect(iproto_thread->tx.latency, msg->header.type,
+			       IPROTO_LATENCY_TX, process_time);
+	if (wal_wait_time > 0) {
+		iproto_latency_collect(iproto_thread->tx.latency,
+				       msg->header.type, IPROTO_LATENCY_WAL,
+				       wal_wait_time);
+	}
 }
 
 /**
@@ -2024,6 +2505,60 @@ error:
 	tx_end_msg(msg);
 }
 
+/**
+ * Dump SELECT results to the output buffer. Tuples of size
+ * IPROTO_SPLICE_SIZE_MIN or larger are not copied, splices
+ * referencing them are appended to @a splices instead. The total
+ * size of their data is returned in @a spliced_size.
+ *
+ * @retval >= 0 Number of dumped tuples.
+ * @retval -1 Memory error.
+ */
+static int
+tx_dump_select(struct port *base, struct obuf *out, struct stailq *splices,
+	       size_t *spliced_size)
+{
+	assert(base->vtab == &port_c_vtab);
+	struct port_c *port = (struct port_c *)base;
+	*spliced_size = 0;
+	for (struct port_c_entry *pe = port->first; pe != NULL;
+	     pe = pe->next) {
+		uint32_t size = pe->mp_size;
+		if (size == 0 &&
+		    tuple_bsize(pe->tuple) >= IPROTO_SPLICE_SIZE_MIN) {
+			struct iproto_splice *splice = (struct iproto_splice *)
+				mempool_alloc(&iproto_splice_pool);
+			if (splice == NULL) {
+				diag_set(OutOfMemory, sizeof(*splice),
+					 "mempool_alloc", "splice");
+				return -1;
+			}
+			tuple_ref(pe->tuple);
+			splice->obuf = out;
+			splice->used = obuf_size(out);
+			splice->tuple = pe->tuple;
+			splice->data = tuple_data_range(pe->tuple, &size);
+			splice->size = size;
+			splice->written = 0;
+			stailq_add_tail_entry(splices, splice, in_list);
+			*spliced_size += size;
+		} else if (size == 0) {
+			if (tuple_to_obuf(pe->tuple, out) != 0)
+				return -1;
+		} else if (obuf_dup(out, pe->mp, size) != size) {
+			diag_set(OutOfMemory, size, "obuf_dup", "data");
+			return -1;
+		}
+		ERROR_INJECT(ERRINJ_PORT_DUMP, {
+			diag_set(OutOfMemory,
+				 size == 0 ? tuple_size(pe->tuple) : size,
+				 "obuf_dup", "data");
+			return -1;
+		});
+	}
+	return port->size;
+}
+
 static void
 tx_process_select(struct cmsg *m)
 {
@@ -2033,14 +2568,20 @@ tx_process_select(struct cmsg *m)
 	struct port port;
 	int count;
 	int rc;
+	size_t spliced_size;
 	struct request *req = &msg->dml;
+	const char *pos = req->after_position;
+	const char *pos_end = req->after_position_end;
+	/* The fetched position is allocated on the fiber region. */
+	size_t region_svp = region_used(&fiber()->gc);
 	if (tx_check_schema(msg->header.schema_version))
 		goto error;
 
 	tx_inject_delay();
 	rc = box_select(req->space_id, req->index_id,
 			req->iterator, req->offset, req->limit,
-			req->key, req->key_end, &port);
+			req->key, req->key_end, &pos, &pos_end,
+			req->fetch_position, &port);
 	if (rc < 0)
 		goto error;
 
@@ -2052,19 +2593,39 @@ tx_process_select(struct cmsg *m)
 	/*
 	 * SELECT output format has not changed since Tarantool 1.6
 	 */
-	count = port_dump_msgpack_16(&port, out);
+	count = tx_dump_select(&port, out, &msg->splices, &spliced_size);
 	port_destroy(&port);
 	if (count < 0) {
 		/* Discard the prepared select. */
 		obuf_rollback_to_svp(out, &svp);
+		tx_release_splices(&msg->splices);
 		goto error;
 	}
-	iproto_reply_select(out, &svp, msg->header.sync,
-			    ::schema_version, count);
+	if (!req->fetch_position) {
+		iproto_reply_select(out, &svp, msg->header.sync,
+				    ::schema_version, count);
+	} else if (iproto_reply_select_with_position(out, &svp,
+						     msg->header.sync,
+						     ::schema_version, count,
+						     pos, pos_end) != 0) {
+		obuf_rollback_to_svp(out, &svp);
+		tx_release_splices(&msg->splices);
+		goto error;
+	}
+	if (spliced_size != 0) {
+		/* Account the tuple data inserted into the response. */
+		iproto_header_encode((char *)obuf_svp_to_ptr(out, &svp),
+				     IPROTO_OK, msg->header.sync,
+				     ::schema_version,
+				     obuf_size(out) - svp.used -
+				     IPROTO_HEADER_LEN + spliced_size);
+	}
+	region_truncate(&fiber()->gc, region_svp);
 	iproto_wpos_create(&msg->wpos, out);
 	tx_end_msg(msg);
 	return;
 error:
+	region_truncate(&fiber()->gc, region_svp);
 	tx_reply_error(msg);
 	tx_end_msg(msg);
 }
@@ -2441,6 +3002,13 @@ net_send_msg(struct cmsg *m)
 	struct iproto_msg *msg = (struct iproto_msg *) m;
 	struct iproto_connection *con = msg->connection;
 
+	uint64_t now = clock_monotonic64();
+	struct iproto_latency_stat *latency = con->iproto_thread->latency;
+	iproto_latency_collect(latency, msg->header.type, IPROTO_LATENCY_NET,
+			       now - msg->reply_time);
+	iproto_latency_collect(latency, msg->header.type, IPROTO_LATENCY_TOTAL,
+			       now - msg->recv_time);
+
 	iproto_msg_finish_processing_in_stream(msg);
 	if (msg->len != 0) {
 		/* Discard request (see iproto_enqueue_batch()). */
@@ -2451,6 +3019,7 @@ net_send_msg(struct cmsg *m)
 		con->long_poll_count--;
 	}
 	con->wend = msg->wpos;
+	stailq_concat(&con->splices, &msg->splices);
 
 	if (con->state == IPROTO_CONNECTION_ALIVE) {
 		iproto_connection_feed_output(con);
@@ -2821,6 +3390,10 @@ iproto_thread_init_routes(struct iproto_thread *iproto_thread)
 		{ tx_process_disconnect, &iproto_thread->net_pipe };
 	iproto_thread->disconnect_route[1] =
 		{ net_finish_disconnect, NULL };
+	iproto_thread->release_splices_route[0] =
+		{ tx_process_release_splices, &iproto_thread->net_pipe };
+	iproto_thread->release_splices_route[1] =
+		{ net_finish_release_splices, NULL };
 	iproto_thread->misc_route[0] =
 		{ tx_process_misc, &iproto_thread->net_pipe };
 	iproto_thread->misc_route[1] = { net_send_msg, NULL };
@@ -2896,6 +3469,10 @@ iproto_thread_init(struct iproto_thread *iproto_thread)
 	rlist_create(&iproto_thread->stopped_connections);
 	iproto_thread->tx.requests_in_progress = 0;
 	iproto_thread->requests_in_stream_queue = 0;
+	iproto_thread->latency = (struct iproto_latency_stat *)
+		xcalloc(1, sizeof(struct iproto_latency_stat));
+	iproto_thread->tx.latency = (struct iproto_latency_stat *)
+		xcalloc(1, sizeof(struct iproto_latency_stat));
 	return 0;
 fail:
 	if (iproto_thread->rmean != NULL)
@@ -2923,6 +3500,8 @@ iproto_init(int threads_count)
 	 * we don't need any accept functions.
 	 */
 	evio_service_create(loop(), &tx_binary, "tx_binary", NULL, NULL);
+	mempool_create(&iproto_splice_pool, cord_slab_cache(),
+		       sizeof(struct iproto_splice));
 	iproto_threads = (struct iproto_thread *)
 		xcalloc(threads_count, sizeof(struct iproto_thread));
 
@@ -2936,6 +3515,8 @@ iproto_init(int threads_count)
 				 net_cord_f, iproto_thread)) {
 			rmean_delete(iproto_thread->rmean);
 			rmean_delete(iproto_thread->tx.rmean);
+			free(iproto_thread->latency);
+			free(iproto_thread->tx.latency);
 			slab_cache_destroy(&iproto_thread->net_slabc);
 			goto fail;
 		}
@@ -2979,6 +3560,14 @@ enum iproto_cfg_op {
 	 * Command code do get statistic from iproto thread
 	 */
 	IPROTO_CFG_STAT,
+	/**
+	 * Command code to get latency statistic from iproto thread
+	 */
+	IPROTO_CFG_LATENCY,
+	/**
+	 * Command code to reset latency statistic of iproto thread
+	 */
+	IPROTO_CFG_LATENCY_RESET,
 };
 
 /**
@@ -2994,6 +3583,8 @@ struct iproto_cfg_msg: public cbus_call_msg
 	union {
 		/** Pointer to the statistic stucture. */
 		struct iproto_stats *stats;
+		/** Latency statistic to add the thread statistic to. */
+		struct iproto_latency_stat *latency;
 		/** Pointer to evio_service, used for bind */
 		struct evio_service *binary;
 		/** New iproto max message count. */
@@ -3027,6 +3618,17 @@ iproto_fill_stat(struct iproto_thread *iproto_thread,
 		iproto_thread->requests_in_stream_queue;
 }
 
+static void
+iproto_latency_stat_merge(struct iproto_latency_stat *dst,
+			  const struct iproto_latency_stat *src)
+{
+	for (int type = 0; type < IPROTO_TYPE_STAT_MAX; type++) {
+		for (int stage = 0; stage < IPROTO_LATENCY_STAGE_MAX; stage++)
+			hdr_histogram_merge(&dst->hist[type][stage],
+					    &src->hist[type][stage]);
+	}
+}
+
 static int
 iproto_do_cfg_f(struct cbus_call_msg *m)
 {
@@ -3071,6 +3673,14 @@ iproto_do_cfg_f(struct cbus_call_msg *m)
 		case IPROTO_CFG_STAT:
 			iproto_fill_stat(iproto_thread, cfg_msg);
 			break;
+		case IPROTO_CFG_LATENCY:
+			iproto_latency_stat_merge(cfg_msg->latency,
+						  iproto_thread->latency);
+			break;
+		case IPROTO_CFG_LATENCY_RESET:
+			memset(iproto_thread->latency, 0,
+			       sizeof(*iproto_thread->latency));
+			break;
 		default:
 			unreachable();
 		}
@@ -3182,9 +3792,27 @@ iproto_thread_stats_get(struct iproto_stats *stats, int thread_id)
 void
 iproto_reset_stat(void)
 {
+	struct iproto_cfg_msg cfg_msg;
+	iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_LATENCY_RESET);
 	for (int i = 0; i < iproto_threads_count; i++) {
 		rmean_cleanup(iproto_threads[i].rmean);
 		rmean_cleanup(iproto_threads[i].tx.rmean);
+		memset(iproto_threads[i].tx.latency, 0,
+		       sizeof(*iproto_threads[i].tx.latency));
+		iproto_do_cfg_crit(&iproto_threads[i], &cfg_msg);
+	}
+}
+
+void
+iproto_latency_stat_get(struct iproto_latency_stat *stat)
+{
+	memset(stat, 0, sizeof(*stat));
+	struct iproto_cfg_msg cfg_msg;
+	iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_LATENCY);
+	cfg_msg.latency = stat;
+	for (int i = 0; i < iproto_threads_count; i++) {
+		iproto_latency_stat_merge(stat, iproto_threads[i].tx.latency);
+		iproto_do_cfg_crit(&iproto_threads[i], &cfg_msg);
 	}
 }
 
@@ -3220,9 +3848,12 @@ iproto_free(void)
 		evio_service_detach(&iproto_threads[i].binary);
 		rmean_delete(iproto_threads[i].rmean);
 		rmean_delete(iproto_threads[i].tx.rmean);
+		free(iproto_threads[i].latency);
+		free(iproto_threads[i].tx.latency);
 		slab_cache_destroy(&iproto_threads[i].net_slabc);
 	}
 	free(iproto_threads);
+	mempool_destroy(&iproto_splice_pool);
 
 	/*
 	 * Here we close sockets and unlink all unix socket paths.
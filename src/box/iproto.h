@@ -33,6 +33,9 @@
 
 #include <stddef.h>
 
+#include "hdr_histogram.h"
+#include "iproto_constants.h"
+
 struct uri_set;
 
 #if defined(__cplusplus)
@@ -73,6 +76,38 @@ struct iproto_stats {
 	size_t requests_in_stream_queue;
 };
 
+/** Stages of iproto request processing, see box.stat.latency(). */
+enum iproto_latency_stage {
+	/**
+	 * From reading the request from the socket to starting
+	 * its processing in the tx thread.
+	 */
+	IPROTO_LATENCY_QUEUE,
+	/** Processing in the tx thread, except waiting for WAL. */
+	IPROTO_LATENCY_TX,
+	/** Waiting for WAL writes in the tx thread. */
+	IPROTO_LATENCY_WAL,
+	/**
+	 * From the end of processing in the tx thread to handing
+	 * the response over to the network in the iproto thread.
+	 */
+	IPROTO_LATENCY_NET,
+	/** From reading the request to handing the response over. */
+	IPROTO_LATENCY_TOTAL,
+	IPROTO_LATENCY_STAGE_MAX,
+};
+
+extern const char *iproto_latency_stage_strs[IPROTO_LATENCY_STAGE_MAX];
+
+/**
+ * Latency histograms of iproto requests per request type and
+ * processing stage, in microseconds.
+ */
+struct iproto_latency_stat {
+	struct hdr_histogram
+		hist[IPROTO_TYPE_STAT_MAX][IPROTO_LATENCY_STAGE_MAX];
+};
+
 extern unsigned iproto_readahead;
 extern int iproto_threads_count;
 
@@ -95,6 +130,13 @@ iproto_thread_stats_get(struct iproto_stats *stats, int thread_id);
 void
 iproto_reset_stat(void);
 
+/**
+ * Return request latency statistics collected by all iproto
+ * threads.
+ */
+void
+iproto_latency_stat_get(struct iproto_latency_stat *stat);
+
 /**
  * Return count of the addresses currently served by iproto.
  */
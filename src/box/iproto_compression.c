@@ -0,0 +1,225 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "iproto_compression.h"
+
+#include <assert.h>
+
+#include "diag.h"
+#include "errinj.h"
+#include "error.h"
+#include "iproto_constants.h"
+#include "msgpuck.h"
+#include "small/ibuf.h"
+#include "trivia/util.h"
+#include "xrow.h"
+
+int iproto_compression_level = 0;
+size_t iproto_compression_min_size = 1024;
+
+enum {
+	/**
+	 * Size of the fixed part of an IPROTO_COMPRESSED packet:
+	 * the packet length, the header and the body preceding
+	 * the compressed data, all encoded with fixed size.
+	 */
+	IPROTO_COMPRESSED_HEADER_LEN = 5 + 3 + 7,
+};
+
+int
+iproto_compressor_create(struct iproto_compressor *compressor, int level)
+{
+	assert(level > 0 && level <= IPROTO_COMPRESSION_LEVEL_MAX);
+	compressor->zstream = ZSTD_createCStream();
+	if (compressor->zstream == NULL) {
+		diag_set(OutOfMemory, sizeof(compressor->zstream),
+			 "ZSTD_createCStream", "zstream");
+		return -1;
+	}
+	size_t rc = ZSTD_initCStream(compressor->zstream, level);
+	if (ZSTD_isError(rc)) {
+		diag_set(ClientError, ER_COMPRESSION, ZSTD_getErrorName(rc));
+		ZSTD_freeCStream(compressor->zstream);
+		compressor->zstream = NULL;
+		return -1;
+	}
+	compressor->packet_offset = 0;
+	return 0;
+}
+
+void
+iproto_compressor_destroy(struct iproto_compressor *compressor)
+{
+	ZSTD_freeCStream(compressor->zstream);
+}
+
+int
+iproto_compressor_begin(struct iproto_compressor *compressor,
+			struct ibuf *out)
+{
+	compressor->packet_offset = ibuf_used(out);
+	if (ibuf_alloc(out, IPROTO_COMPRESSED_HEADER_LEN) == NULL) {
+		diag_set(OutOfMemory, IPROTO_COMPRESSED_HEADER_LEN,
+			 "ibuf_alloc", "packet header");
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Run the compressor over the input, growing the output buffer as
+ * needed. Flush the compressed data if @a input is NULL.
+ */
+static int
+iproto_compressor_run(struct iproto_compressor *compressor,
+		      ZSTD_inBuffer *input, struct ibuf *out)
+{
+	while (true) {
+		size_t size = ZSTD_CStreamOutSize();
+		if (ibuf_reserve(out, size) == NULL) {
+			diag_set(OutOfMemory, size, "ibuf_reserve", "data");
+			return -1;
+		}
+		ZSTD_outBuffer output = {out->wpos, ibuf_unused(out), 0};
+		size_t rc = input != NULL ?
+			    ZSTD_compressStream(compressor->zstream,
+						&output, input) :
+			    ZSTD_flushStream(compressor->zstream, &output);
+		if (ZSTD_isError(rc)) {
+			diag_set(ClientError, ER_COMPRESSION,
+				 ZSTD_getErrorName(rc));
+			return -1;
+		}
+		out->wpos += output.pos;
+		if (input != NULL ? input->pos == input->size : rc == 0)
+			return 0;
+	}
+}
+
+int
+iproto_compressor_write(struct iproto_compressor *compressor,
+			const struct iovec *iov, int iovcnt, struct ibuf *out)
+{
+	for (int i = 0; i < iovcnt; i++) {
+		ZSTD_inBuffer input = {iov[i].iov_base, iov[i].iov_len, 0};
+		if (iproto_compressor_run(compressor, &input, out) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+int
+iproto_compressor_end(struct iproto_compressor *compressor, struct ibuf *out)
+{
+	if (iproto_compressor_run(compressor, NULL, out) != 0)
+		return -1;
+	char *pos = out->rpos + compressor->packet_offset;
+	size_t data_len = ibuf_used(out) - compressor->packet_offset -
+			  IPROTO_COMPRESSED_HEADER_LEN;
+	/* Packet length. */
+	*pos++ = 0xce;
+	pos = mp_store_u32(pos, IPROTO_COMPRESSED_HEADER_LEN - 5 + data_len);
+	/* Header. */
+	pos = mp_encode_map(pos, 1);
+	pos = mp_encode_uint(pos, IPROTO_REQUEST_TYPE);
+	pos = mp_encode_uint(pos, IPROTO_COMPRESSED);
+	/* Body. */
+	pos = mp_encode_map(pos, 1);
+	pos = mp_encode_uint(pos, IPROTO_DATA);
+	*pos++ = 0xc6;
+	pos = mp_store_u32(pos, data_len);
+	assert(pos == out->rpos + compressor->packet_offset +
+		      IPROTO_COMPRESSED_HEADER_LEN);
+	return 0;
+}
+
+int
+iproto_decompressor_create(struct iproto_decompressor *decompressor)
+{
+	decompressor->zstream = ZSTD_createDStream();
+	if (decompressor->zstream == NULL) {
+		diag_set(OutOfMemory, sizeof(decompressor->zstream),
+			 "ZSTD_createDStream", "zstream");
+		return -1;
+	}
+	iproto_decompressor_reset(decompressor);
+	return 0;
+}
+
+void
+iproto_decompressor_destroy(struct iproto_decompressor *decompressor)
+{
+	ZSTD_freeDStream(decompressor->zstream);
+}
+
+void
+iproto_decompressor_reset(struct iproto_decompressor *decompressor)
+{
+	ZSTD_initDStream(decompressor->zstream);
+}
+
+int
+iproto_decompressor_decompress(struct iproto_decompressor *decompressor,
+			       const struct xrow_header *row, struct ibuf *out)
+{
+	assert(row->type == IPROTO_COMPRESSED);
+	if (row->bodycnt == 0)
+		goto error;
+	const char *data = row->body[0].iov_base;
+	if (mp_typeof(*data) != MP_MAP || mp_decode_map(&data) != 1 ||
+	    mp_typeof(*data) != MP_UINT ||
+	    mp_decode_uint(&data) != IPROTO_DATA ||
+	    mp_typeof(*data) != MP_BIN)
+		goto error;
+	uint32_t len;
+	data = mp_decode_bin(&data, &len);
+	ZSTD_inBuffer input = {data, len, 0};
+	while (true) {
+		size_t size = ZSTD_DStreamOutSize();
+		if (ibuf_reserve(out, size) == NULL) {
+			diag_set(OutOfMemory, size, "ibuf_reserve", "data");
+			return -1;
+		}
+		ZSTD_outBuffer output = {out->wpos, ibuf_unused(out), 0};
+		size_t rc = ZSTD_decompressStream(decompressor->zstream,
+						  &output, &input);
+		if (ZSTD_isError(rc)) {
+			diag_set(ClientError, ER_DECOMPRESSION,
+				 ZSTD_getErrorName(rc));
+			return -1;
+		}
+		out->wpos += output.pos;
+		/*
+		 * The sender flushes the stream at the end of each
+		 * packet so all the data is decompressed as soon as
+		 * the input is consumed and there is room in output.
+		 */
+		if (input.pos == input.size && output.pos < output.size)
+			break;
+	}
+#ifndef NDEBUG
+	++errinj(ERRINJ_IPROTO_COMPRESSED_COUNT, ERRINJ_INT)->iparam;
+#endif
+	return 0;
+error:
+	diag_set(ClientError, ER_INVALID_MSGPACK, "compressed packet");
+	return -1;
+}
+
+int
+iproto_decompressor_next(struct ibuf *in, struct xrow_header *row)
+{
+	const char *pos = in->rpos;
+	if (mp_typeof(*pos) != MP_UINT || mp_check_uint(pos, in->wpos) > 0)
+		goto error;
+	uint64_t len = mp_decode_uint(&pos);
+	if (len > (uint64_t)(in->wpos - pos))
+		goto error;
+	in->rpos = (char *)pos + len;
+	return xrow_header_decode(row, &pos, in->rpos, true);
+error:
+	diag_set(ClientError, ER_INVALID_MSGPACK, "compressed packet");
+	return -1;
+}
@@ -0,0 +1,126 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+#include "zstd.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct ibuf;
+struct xrow_header;
+
+/*
+ * Compression of iproto and replication traffic.
+ *
+ * If a peer reports the IPROTO_FEATURE_COMPRESSION feature, the
+ * sender may wrap a sequence of packets into an IPROTO_COMPRESSED
+ * packet:
+ *
+ *   <len> {IPROTO_REQUEST_TYPE: IPROTO_COMPRESSED}
+ *         {IPROTO_DATA: <zstd data>}
+ *
+ * The compressed data of all IPROTO_COMPRESSED packets sent over
+ * a connection form a single zstd stream, which is flushed at the
+ * end of each packet, so that a packet can be decompressed as soon
+ * as it is received. A packet always carries whole packets.
+ * Compressed and plain packets may be interleaved.
+ */
+
+enum {
+	/** Max compression level. */
+	IPROTO_COMPRESSION_LEVEL_MAX = 22,
+};
+
+/**
+ * Compression level of data sent to peers supporting compression.
+ * 0 disables compression. Applied to new connections.
+ */
+extern int iproto_compression_level;
+
+/**
+ * Data chunks smaller than this are sent uncompressed even if
+ * compression is enabled.
+ */
+extern size_t iproto_compression_min_size;
+
+/** Compressor of outgoing packets. */
+struct iproto_compressor {
+	/** zstd stream shared by all packets sent over a connection. */
+	ZSTD_CStream *zstream;
+	/**
+	 * Offset of the packet being compressed in the output buffer,
+	 * relative to its read position.
+	 */
+	size_t packet_offset;
+};
+
+/**
+ * Create a compressor with the given compression level.
+ * Returns -1 and sets diag on memory error.
+ */
+int
+iproto_compressor_create(struct iproto_compressor *compressor, int level);
+
+void
+iproto_compressor_destroy(struct iproto_compressor *compressor);
+
+/** Start a new IPROTO_COMPRESSED packet in @a out. */
+int
+iproto_compressor_begin(struct iproto_compressor *compressor,
+			struct ibuf *out);
+
+/** Compress data to the packet started in @a out. */
+int
+iproto_compressor_write(struct iproto_compressor *compressor,
+			const struct iovec *iov, int iovcnt, struct ibuf *out);
+
+/** Flush the compressed data and finish the packet. */
+int
+iproto_compressor_end(struct iproto_compressor *compressor, struct ibuf *out);
+
+/** Decompressor of incoming IPROTO_COMPRESSED packets. */
+struct iproto_decompressor {
+	/** zstd stream shared by all packets received over a connection. */
+	ZSTD_DStream *zstream;
+};
+
+/**
+ * Create a decompressor. Returns -1 and sets diag on memory error.
+ */
+int
+iproto_decompressor_create(struct iproto_decompressor *decompressor);
+
+void
+iproto_decompressor_destroy(struct iproto_decompressor *decompressor);
+
+/** Reset the decompressor to receive packets over a new connection. */
+void
+iproto_decompressor_reset(struct iproto_decompressor *decompressor);
+
+/**
+ * Decompress an IPROTO_COMPRESSED packet, appending the packets it
+ * carries to @a out. Use iproto_decompressor_next() to decode them.
+ */
+int
+iproto_decompressor_decompress(struct iproto_decompressor *decompressor,
+			       const struct xrow_header *row, struct ibuf *out);
+
+/**
+ * Decode the next packet from a buffer filled by
+ * iproto_decompressor_decompress(). The row body points to
+ * the buffer memory.
+ */
+int
+iproto_decompressor_next(struct ibuf *in, struct xrow_header *row);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
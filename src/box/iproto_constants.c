@@ -89,11 +89,11 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 	/* 0x29 */	MP_MAP, /* IPROTO_BALLOT */
 	/* 0x2a */	MP_MAP, /* IPROTO_TUPLE_META */
 	/* 0x2b */	MP_MAP, /* IPROTO_OPTIONS */
+	/* 0x2c */	MP_BOOL, /* IPROTO_FETCH_POSITION */
+	/* 0x2d */	MP_STR, /* IPROTO_AFTER_POSITION */
 	/* }}} */
 
 	/* {{{ unused */
-	/* 0x2c */	MP_UINT,
-	/* 0x2d */	MP_UINT,
 	/* 0x2e */	MP_UINT,
 	/* 0x2f */	MP_UINT,
 	/* }}} */
@@ -104,10 +104,10 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 	/* 0x32 */	MP_ARRAY, /* IPROTO_METADATA */
 	/* 0x33 */	MP_ARRAY, /* IPROTO_BIND_METADATA */
 	/* 0x34 */	MP_UINT, /* IIPROTO_BIND_COUNT */
+	/* 0x35 */	MP_STR, /* IPROTO_POSITION */
 	/* }}} */
 
 	/* {{{ unused */
-	/* 0x35 */	MP_UINT,
 	/* 0x36 */	MP_UINT,
 	/* 0x37 */	MP_UINT,
 	/* 0x38 */	MP_UINT,
@@ -243,8 +243,8 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"ballot",           /* 0x29 */
 	"tuple meta",       /* 0x2a */
 	"options",          /* 0x2b */
-	NULL,               /* 0x2c */
-	NULL,               /* 0x2d */
+	"fetch position",   /* 0x2c */
+	"after position",   /* 0x2d */
 	NULL,               /* 0x2e */
 	NULL,               /* 0x2f */
 	"data",             /* 0x30 */
@@ -252,7 +252,7 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"metadata",         /* 0x32 */
 	"bind meta",        /* 0x33 */
 	"bind count",       /* 0x34 */
-	NULL,               /* 0x35 */
+	"position",         /* 0x35 */
 	NULL,               /* 0x36 */
 	NULL,               /* 0x37 */
 	NULL,               /* 0x38 */
@@ -310,6 +310,7 @@ const char *vy_run_info_key_strs[VY_RUN_INFO_KEY_MAX] = {
 	"bloom filter legacy",
 	"bloom filter",
 	"stmt stat",
+	"split bloom filter",
 };
 
 const char *vy_row_index_key_strs[VY_ROW_INDEX_KEY_MAX] = {
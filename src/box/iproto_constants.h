@@ -104,6 +104,10 @@ enum iproto_key {
 	IPROTO_BALLOT = 0x29,
 	IPROTO_TUPLE_META = 0x2a,
 	IPROTO_OPTIONS = 0x2b,
+	/** Return the position of the last selected tuple (SELECT). */
+	IPROTO_FETCH_POSITION = 0x2c,
+	/** Select tuples following the given position (SELECT). */
+	IPROTO_AFTER_POSITION = 0x2d,
 
 	/* Leave a gap between request keys and response keys */
 	IPROTO_DATA = 0x30,
@@ -118,6 +122,8 @@ enum iproto_key {
 	IPROTO_METADATA = 0x32,
 	IPROTO_BIND_METADATA = 0x33,
 	IPROTO_BIND_COUNT = 0x34,
+	/** Position of the last selected tuple. */
+	IPROTO_POSITION = 0x35,
 
 	/* Leave a gap between response keys and SQL keys. */
 	IPROTO_SQL_TEXT = 0x40,
@@ -282,6 +288,11 @@ enum iproto_type {
 	IPROTO_WATCH = 74,
 	IPROTO_UNWATCH = 75,
 	IPROTO_EVENT = 76,
+	/**
+	 * A sequence of packets compressed with zstd, sent to peers
+	 * supporting IPROTO_FEATURE_COMPRESSION.
+	 */
+	IPROTO_COMPRESSED = 77,
 
 	/** Vinyl run info stored in .index file */
 	VY_INDEX_RUN_INFO = 100,
@@ -337,6 +348,8 @@ iproto_type_name(uint16_t type)
 		return "CONFIRM";
 	case IPROTO_RAFT_ROLLBACK:
 		return "ROLLBACK";
+	case IPROTO_COMPRESSED:
+		return "COMPRESSED";
 	case VY_INDEX_RUN_INFO:
 		return "RUNINFO";
 	case VY_INDEX_PAGE_INFO:
@@ -447,10 +460,12 @@ enum vy_run_info_key {
 	VY_RUN_INFO_PAGE_COUNT = 5,
 	/** Legacy bloom filter implementation. */
 	VY_RUN_INFO_BLOOM_LEGACY = 6,
-	/** Bloom filter for keys. */
+	/** Classic bloom filter for keys. */
 	VY_RUN_INFO_BLOOM = 7,
 	/** Number of statements of each type (map). */
 	VY_RUN_INFO_STMT_STAT = 8,
+	/** Split block bloom filter for keys. */
+	VY_RUN_INFO_BLOOM_SPLIT = 9,
 	/** The last key in this enum + 1 */
 	VY_RUN_INFO_KEY_MAX
 };
@@ -45,6 +45,11 @@ enum iproto_feature_id {
 	 * IPROTO_WATCH, IPROTO_UNWATCH, IPROTO_EVENT commands.
 	 */
 	IPROTO_FEATURE_WATCHERS = 3,
+	/**
+	 * Compression of packets sent to the peer:
+	 * IPROTO_COMPRESSED packets (see iproto_compression.h).
+	 */
+	IPROTO_FEATURE_COMPRESSION = 4,
 	iproto_feature_id_MAX,
 };
 
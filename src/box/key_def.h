@@ -891,6 +891,18 @@ tuple_key_contains_null(struct tuple *tuple, struct key_def *def,
 int
 tuple_validate_key_parts(struct key_def *key_def, struct tuple *tuple);
 
+/**
+ * Same as tuple_validate_key_parts(), but the tuple is given as
+ * a MsgPack array.
+ * @param key_def Key definition.
+ * @param tuple Tuple data to validate.
+ *
+ * @retval 0  The tuple is valid.
+ * @retval -1 The tuple is invalid.
+ */
+int
+tuple_validate_key_parts_raw(struct key_def *key_def, const char *tuple);
+
 /**
  * Extract key from tuple by given key definition and return
  * buffer allocated on box_txn_alloc with this key. This function
@@ -169,6 +169,54 @@ lbox_cfg_set_wal_queue_max_size(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_net_compression_level(struct lua_State *L)
+{
+	if (box_set_net_compression_level() != 0)
+		luaT_error(L);
+	return 0;
+}
+
+static int
+lbox_cfg_set_net_compression_min_size(struct lua_State *L)
+{
+	if (box_set_net_compression_min_size() != 0)
+		luaT_error(L);
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_tail_size(struct lua_State *L)
+{
+	if (box_set_wal_tail_size() != 0)
+		luaT_error(L);
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_commit_delay(struct lua_State *L)
+{
+	if (box_set_wal_commit_delay() != 0)
+		luaT_error(L);
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_commit_min_batch(struct lua_State *L)
+{
+	if (box_set_wal_commit_min_batch() != 0)
+		luaT_error(L);
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_recycle_segments(struct lua_State *L)
+{
+	if (box_set_wal_recycle_segments() != 0)
+		luaT_error(L);
+	return 0;
+}
+
 static int
 lbox_cfg_set_wal_cleanup_delay(struct lua_State *L)
 {
@@ -210,6 +258,14 @@ lbox_cfg_set_memtx_max_tuple_size(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_memtx_snap_threads(struct lua_State *L)
+{
+	if (box_set_memtx_snap_threads() != 0)
+		luaT_error(L);
+	return 0;
+}
+
 static int
 lbox_cfg_set_vinyl_memory(struct lua_State *L)
 {
@@ -243,6 +299,17 @@ lbox_cfg_set_vinyl_cache(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_vinyl_page_cache(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_page_cache();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_vinyl_timeout(struct lua_State *L)
 {
@@ -273,6 +340,30 @@ lbox_set_prepared_stmt_cache_size(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_sql_hash_agg_memory(struct lua_State *L)
+{
+	if (box_set_sql_hash_agg_memory() != 0)
+		luaT_error(L);
+	return 0;
+}
+
+static int
+lbox_cfg_set_sql_hash_join_memory(struct lua_State *L)
+{
+	if (box_set_sql_hash_join_memory() != 0)
+		luaT_error(L);
+	return 0;
+}
+
+static int
+lbox_cfg_set_sql_stat_refresh_ratio(struct lua_State *L)
+{
+	if (box_set_sql_stat_refresh_ratio() != 0)
+		luaT_error(L);
+	return 0;
+}
+
 static int
 lbox_cfg_set_worker_pool_threads(struct lua_State *L)
 {
@@ -421,13 +512,21 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_checkpoint_interval", lbox_cfg_set_checkpoint_interval},
 		{"cfg_set_checkpoint_wal_threshold", lbox_cfg_set_checkpoint_wal_threshold},
 		{"cfg_set_wal_queue_max_size", lbox_cfg_set_wal_queue_max_size},
+		{"cfg_set_wal_tail_size", lbox_cfg_set_wal_tail_size},
 		{"cfg_set_wal_cleanup_delay", lbox_cfg_set_wal_cleanup_delay},
+		{"cfg_set_wal_commit_delay", lbox_cfg_set_wal_commit_delay},
+		{"cfg_set_wal_commit_min_batch",
+		 lbox_cfg_set_wal_commit_min_batch},
+		{"cfg_set_wal_recycle_segments",
+		 lbox_cfg_set_wal_recycle_segments},
 		{"cfg_set_read_only", lbox_cfg_set_read_only},
 		{"cfg_set_memtx_memory", lbox_cfg_set_memtx_memory},
 		{"cfg_set_memtx_max_tuple_size", lbox_cfg_set_memtx_max_tuple_size},
+		{"cfg_set_memtx_snap_threads", lbox_cfg_set_memtx_snap_threads},
 		{"cfg_set_vinyl_memory", lbox_cfg_set_vinyl_memory},
 		{"cfg_set_vinyl_max_tuple_size", lbox_cfg_set_vinyl_max_tuple_size},
 		{"cfg_set_vinyl_cache", lbox_cfg_set_vinyl_cache},
+		{"cfg_set_vinyl_page_cache", lbox_cfg_set_vinyl_page_cache},
 		{"cfg_set_vinyl_timeout", lbox_cfg_set_vinyl_timeout},
 		{"cfg_set_election_mode", lbox_cfg_set_election_mode},
 		{"cfg_set_election_timeout", lbox_cfg_set_election_timeout},
@@ -441,7 +540,12 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_replication_skip_conflict", lbox_cfg_set_replication_skip_conflict},
 		{"cfg_set_replication_anon", lbox_cfg_set_replication_anon},
 		{"cfg_set_net_msg_max", lbox_cfg_set_net_msg_max},
+		{"cfg_set_net_compression_level", lbox_cfg_set_net_compression_level},
+		{"cfg_set_net_compression_min_size", lbox_cfg_set_net_compression_min_size},
 		{"cfg_set_sql_cache_size", lbox_set_prepared_stmt_cache_size},
+		{"cfg_set_sql_hash_agg_memory", lbox_cfg_set_sql_hash_agg_memory},
+		{"cfg_set_sql_hash_join_memory", lbox_cfg_set_sql_hash_join_memory},
+		{"cfg_set_sql_stat_refresh_ratio", lbox_cfg_set_sql_stat_refresh_ratio},
 		{"cfg_set_crash", lbox_cfg_set_crash},
 		{"cfg_set_txn_timeout", lbox_cfg_set_txn_timeout},
 		{NULL, NULL}
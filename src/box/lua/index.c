@@ -34,6 +34,7 @@
 #include "info/info.h"
 #include "box/box.h"
 #include "box/index.h"
+#include "box/sql_stat.h"
 #include "box/lua/tuple.h"
 #include "box/lua/misc.h" /* lbox_encode_tuple_on_gc() */
 
@@ -226,6 +227,30 @@ lbox_index_count(lua_State *L)
 	return 1;
 }
 
+static int
+lbox_index_tuple_pos(lua_State *L)
+{
+	if (lua_gettop(L) != 3 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2))
+		return luaL_error(L, "usage index.tuple_pos(space_id, index_id, "
+				  "tuple)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+	size_t region_svp = box_region_used();
+	size_t tuple_len;
+	const char *tuple = lbox_encode_tuple_on_gc(L, 3, &tuple_len);
+	const char *pos_end;
+	const char *pos = box_index_tuple_position(space_id, index_id, tuple,
+						   tuple + tuple_len, &pos_end);
+	if (pos == NULL) {
+		box_region_truncate(region_svp);
+		return luaT_error(L);
+	}
+	lua_pushlstring(L, pos, pos_end - pos);
+	box_region_truncate(region_svp);
+	return 1;
+}
+
 static void
 box_index_init_iterator_types(struct lua_State *L, int idx)
 {
@@ -242,9 +267,11 @@ box_index_init_iterator_types(struct lua_State *L, int idx)
 static int
 lbox_index_iterator(lua_State *L)
 {
-	if (lua_gettop(L) != 4 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
+	int top = lua_gettop(L);
+	if (top < 4 || top > 5 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
 	    !lua_isnumber(L, 3))
-		return luaL_error(L, "usage index.iterator(space_id, index_id, type, key)");
+		return luaL_error(L, "usage index.iterator(space_id, index_id, "
+				  "type, key, after)");
 
 	uint32_t space_id = lua_tonumber(L, 1);
 	uint32_t index_id = lua_tonumber(L, 2);
@@ -252,8 +279,17 @@ lbox_index_iterator(lua_State *L)
 	size_t mpkey_len;
 	const char *mpkey = lua_tolstring(L, 4, &mpkey_len); /* Key encoded by Lua */
 	/* const char *key = lbox_encode_tuple_on_gc(L, 4, key_len); */
-	struct iterator *it = box_index_iterator(space_id, index_id, iterator,
-						 mpkey, mpkey + mpkey_len);
+	const char *pos = NULL;
+	const char *pos_end = NULL;
+	if (top == 5 && !lua_isnil(L, 5)) {
+		size_t pos_len;
+		pos = lua_tolstring(L, 5, &pos_len);
+		pos_end = pos + pos_len;
+	}
+	struct iterator *it = box_index_iterator_after(space_id, index_id,
+						       iterator, mpkey,
+						       mpkey + mpkey_len, pos,
+						       pos_end);
 	if (it == NULL)
 		return luaT_error(L);
 
@@ -328,6 +364,55 @@ lbox_index_compact(lua_State *L)
 	return 0;
 }
 
+static int
+lbox_sql_stat_collect(lua_State *L)
+{
+	if (lua_gettop(L) != 2 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2))
+		return luaL_error(L, "usage sql_stat_collect(space_id, index_id)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+
+	struct tuple *tuple = sql_stat_collect(space_id, index_id);
+	if (tuple == NULL)
+		return luaT_error(L);
+	luaT_pushtuple(L, tuple);
+	return 1;
+}
+
+static int
+lbox_sql_stat_load(lua_State *L)
+{
+	struct tuple *tuple;
+	if (lua_gettop(L) != 1 || (tuple = luaT_istuple(L, 1)) == NULL)
+		return luaL_error(L, "usage sql_stat_load(tuple)");
+	if (sql_stat_load(tuple) != 0)
+		return luaT_error(L);
+	return 0;
+}
+
+/** Append {space_id, index_id} to the table on top of the stack. */
+static int
+lbox_sql_stat_stale_cb(uint32_t space_id, uint32_t index_id, void *arg)
+{
+	lua_State *L = arg;
+	lua_createtable(L, 2, 0);
+	lua_pushnumber(L, space_id);
+	lua_rawseti(L, -2, 1);
+	lua_pushnumber(L, index_id);
+	lua_rawseti(L, -2, 2);
+	lua_rawseti(L, -2, lua_objlen(L, -2) + 1);
+	return 0;
+}
+
+static int
+lbox_sql_stat_stale(lua_State *L)
+{
+	lua_newtable(L);
+	sql_stat_foreach_stale(lbox_sql_stat_stale_cb, L);
+	return 1;
+}
+
 /* }}} */
 
 void
@@ -360,11 +445,15 @@ box_lua_index_init(struct lua_State *L)
 		{"min", lbox_index_min},
 		{"max", lbox_index_max},
 		{"count", lbox_index_count},
+		{"tuple_pos", lbox_index_tuple_pos},
 		{"iterator", lbox_index_iterator},
 		{"iterator_next", lbox_iterator_next},
 		{"truncate", lbox_truncate},
 		{"stat", lbox_index_stat},
 		{"compact", lbox_index_compact},
+		{"sql_stat_collect", lbox_sql_stat_collect},
+		{"sql_stat_load", lbox_sql_stat_load},
+		{"sql_stat_stale", lbox_sql_stat_stale},
 		{NULL, NULL}
 	};
 
@@ -84,7 +84,8 @@ extern char session_lua[],
 	net_box_lua[],
 	upgrade_lua[],
 	console_lua[],
-	merger_lua[];
+	merger_lua[],
+	sql_stat_lua[];
 
 static const char *lua_sources[] = {
 	"box/session", session_lua,
@@ -101,6 +102,7 @@ static const char *lua_sources[] = {
 	"box/upgrade", upgrade_lua,
 	"box/net_box", net_box_lua,
 	"box/console", console_lua,
+	"box/sql_stat", sql_stat_lua,
 	"box/load_cfg", load_cfg_lua,
 	"box/xlog", xlog_lua,
 	"box/key_def", key_def_lua,
@@ -46,6 +46,8 @@ local default_cfg = {
     slab_alloc_factor   = 1.05,
     iproto_threads      = 1,
     memtx_allocator     = "small",
+    memtx_build_threads = 1,
+    memtx_snap_threads  = 1,
     work_dir            = nil,
     memtx_dir           = ".",
     wal_dir             = ".",
@@ -53,6 +55,7 @@ local default_cfg = {
     vinyl_dir           = '.',
     vinyl_memory        = 128 * 1024 * 1024,
     vinyl_cache         = 128 * 1024 * 1024,
+    vinyl_page_cache    = 0,
     vinyl_max_tuple_size = 1024 * 1024,
     vinyl_read_threads  = 1,
     vinyl_write_threads = 4,
@@ -72,6 +75,7 @@ local default_cfg = {
     audit_nonblock      = true,
 
     io_collect_interval = nil,
+    use_io_uring        = false,
     readahead           = 16320,
     snap_io_rate_limit  = nil, -- no limit
     too_long_threshold  = 0.5,
@@ -79,7 +83,11 @@ local default_cfg = {
     wal_max_size        = 256 * 1024 * 1024,
     wal_dir_rescan_delay= 2,
     wal_queue_max_size  = 16 * 1024 * 1024,
+    wal_tail_size       = 16 * 1024 * 1024,
     wal_cleanup_delay   = 4 * 3600,
+    wal_commit_delay    = 0,
+    wal_commit_min_batch = 0,
+    wal_recycle_segments = 0,
     force_recovery      = false,
     replication         = nil,
     instance_uuid       = nil,
@@ -92,6 +100,7 @@ local default_cfg = {
     read_only           = false,
     hot_standby         = false,
     memtx_use_mvcc_engine = false,
+    memtx_use_swiss_hash = false,
     checkpoint_interval = 3600,
     checkpoint_wal_threshold = 1e18,
     checkpoint_count    = 2,
@@ -113,7 +122,12 @@ local default_cfg = {
     feedback_host         = "https://feedback.tarantool.io",
     feedback_interval     = 3600,
     net_msg_max           = 768,
+    net_compression_level = 0,
+    net_compression_min_size = 1024,
     sql_cache_size        = 5 * 1024 * 1024,
+    sql_hash_agg_memory   = 64 * 1024 * 1024,
+    sql_hash_join_memory  = 64 * 1024 * 1024,
+    sql_stat_refresh_ratio = 0,
     txn_timeout           = 365 * 100 * 86400,
 }
 
@@ -158,12 +172,15 @@ local template_cfg = {
     slab_alloc_factor   = 'number',
     iproto_threads      = 'number',
     memtx_allocator     = 'string',
+    memtx_build_threads = 'number',
+    memtx_snap_threads  = 'number',
     work_dir            = 'string',
     memtx_dir            = 'string',
     wal_dir             = 'string',
     vinyl_dir           = 'string',
     vinyl_memory        = 'number',
     vinyl_cache               = 'number',
+    vinyl_page_cache          = 'number',
     vinyl_max_tuple_size      = 'number',
     vinyl_read_threads        = 'number',
     vinyl_write_threads       = 'number',
@@ -184,6 +201,7 @@ local template_cfg = {
     audit_nonblock      = 'boolean',
 
     io_collect_interval = 'number',
+    use_io_uring        = 'boolean',
     readahead           = 'number',
     snap_io_rate_limit  = 'number',
     too_long_threshold  = 'number',
@@ -191,6 +209,9 @@ local template_cfg = {
     wal_max_size        = 'number',
     wal_dir_rescan_delay= 'number',
     wal_cleanup_delay   = 'number',
+    wal_commit_delay    = 'number',
+    wal_commit_min_batch = 'number',
+    wal_recycle_segments = 'number',
     force_recovery      = 'boolean',
     replication         = 'string, number, table',
     instance_uuid       = 'string',
@@ -203,10 +224,12 @@ local template_cfg = {
     checkpoint_interval = 'number',
     checkpoint_wal_threshold = 'number',
     wal_queue_max_size  = 'number',
+    wal_tail_size       = 'number',
     checkpoint_count    = 'number',
     read_only           = 'boolean',
     hot_standby         = 'boolean',
     memtx_use_mvcc_engine = 'boolean',
+    memtx_use_swiss_hash = 'boolean',
     worker_pool_threads = 'number',
     election_mode       = 'string',
     election_timeout    = 'number',
@@ -225,7 +248,12 @@ local template_cfg = {
     feedback_host         = ifdef_feedback('string'),
     feedback_interval     = ifdef_feedback('number'),
     net_msg_max           = 'number',
+    net_compression_level = 'number',
+    net_compression_min_size = 'number',
     sql_cache_size        = 'number',
+    sql_hash_agg_memory   = 'number',
+    sql_hash_join_memory  = 'number',
+    sql_stat_refresh_ratio = 'number',
     txn_timeout           = 'number',
 }
 
@@ -299,15 +327,18 @@ local dynamic_cfg = {
     read_only               = private.cfg_set_read_only,
     memtx_memory            = private.cfg_set_memtx_memory,
     memtx_max_tuple_size    = private.cfg_set_memtx_max_tuple_size,
+    memtx_snap_threads      = private.cfg_set_memtx_snap_threads,
     vinyl_memory            = private.cfg_set_vinyl_memory,
     vinyl_max_tuple_size    = private.cfg_set_vinyl_max_tuple_size,
     vinyl_cache             = private.cfg_set_vinyl_cache,
+    vinyl_page_cache        = private.cfg_set_vinyl_page_cache,
     vinyl_timeout           = private.cfg_set_vinyl_timeout,
     vinyl_defer_deletes     = function() end,
     checkpoint_count        = private.cfg_set_checkpoint_count,
     checkpoint_interval     = private.cfg_set_checkpoint_interval,
     checkpoint_wal_threshold = private.cfg_set_checkpoint_wal_threshold,
     wal_queue_max_size      = private.cfg_set_wal_queue_max_size,
+    wal_tail_size           = private.cfg_set_wal_tail_size,
     worker_pool_threads     = private.cfg_set_worker_pool_threads,
     feedback_enabled        = ifdef_feedback_set_params,
     feedback_crashinfo      = ifdef_feedback_set_params,
@@ -316,6 +347,9 @@ local dynamic_cfg = {
     -- do nothing, affects new replicas, which query this value on start
     wal_dir_rescan_delay    = function() end,
     wal_cleanup_delay       = private.cfg_set_wal_cleanup_delay,
+    wal_commit_delay        = private.cfg_set_wal_commit_delay,
+    wal_commit_min_batch    = private.cfg_set_wal_commit_min_batch,
+    wal_recycle_segments    = private.cfg_set_wal_recycle_segments,
     custom_proc_title       = function()
         require('title').update(box.cfg.custom_proc_title)
     end,
@@ -334,7 +368,15 @@ local dynamic_cfg = {
     instance_uuid           = check_instance_uuid,
     replicaset_uuid         = check_replicaset_uuid,
     net_msg_max             = private.cfg_set_net_msg_max,
+    net_compression_level   = private.cfg_set_net_compression_level,
+    net_compression_min_size = private.cfg_set_net_compression_min_size,
     sql_cache_size          = private.cfg_set_sql_cache_size,
+    sql_hash_agg_memory     = private.cfg_set_sql_hash_agg_memory,
+    sql_hash_join_memory    = private.cfg_set_sql_hash_join_memory,
+    sql_stat_refresh_ratio  = function()
+        private.cfg_set_sql_stat_refresh_ratio()
+        private.sql_stat_daemon.start()
+    end,
     txn_timeout             = private.cfg_set_txn_timeout,
 }
 
@@ -409,9 +451,11 @@ local dynamic_cfg_skip_at_load = {
     listen                  = true,
     memtx_memory            = true,
     memtx_max_tuple_size    = true,
+    memtx_snap_threads      = true,
     vinyl_memory            = true,
     vinyl_max_tuple_size    = true,
     vinyl_cache             = true,
+    vinyl_page_cache        = true,
     vinyl_timeout           = true,
     too_long_threshold      = true,
     election_mode           = true,
@@ -805,6 +849,10 @@ local function load_cfg(cfg)
 
     box_is_configured = true
 
+    -- Load SQL statistics and start refreshing them. The daemon
+    -- needs the _sql_stat space, so box must be fully loaded.
+    private.sql_stat_daemon.init()
+
     -- Check if schema version matches Tarantool version and print
     -- warning if it's not (in case user forgot to call
     -- box.schema.upgrade()).
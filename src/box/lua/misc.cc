@@ -101,10 +101,11 @@ port_msgpack_dump_lua(struct port *base, struct lua_State *L, bool is_flat)
 static int
 lbox_select(lua_State *L)
 {
-	if (lua_gettop(L) != 6 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
+	int top = lua_gettop(L);
+	if (top < 6 || top > 8 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
 		!lua_isnumber(L, 3) || !lua_isnumber(L, 4) || !lua_isnumber(L, 5)) {
 		return luaL_error(L, "Usage index:select(iterator, offset, "
-				  "limit, key)");
+				  "limit, key, after, fetch_pos)");
 	}
 
 	uint32_t space_id = lua_tonumber(L, 1);
@@ -116,9 +117,21 @@ lbox_select(lua_State *L)
 	size_t key_len;
 	const char *key = lbox_encode_tuple_on_gc(L, 6, &key_len);
 
+	const char *pos = NULL;
+	const char *pos_end = NULL;
+	if (top >= 7 && !lua_isnil(L, 7)) {
+		size_t pos_len;
+		pos = lua_tolstring(L, 7, &pos_len);
+		pos_end = pos + pos_len;
+	}
+	bool fetch_pos = top >= 8 && lua_toboolean(L, 8);
+
 	struct port port;
+	size_t region_svp = region_used(&fiber()->gc);
 	if (box_select(space_id, index_id, iterator, offset, limit,
-		       key, key + key_len, &port) != 0) {
+		       key, key + key_len, &pos, &pos_end, fetch_pos,
+		       &port) != 0) {
+		region_truncate(&fiber()->gc, region_svp);
 		return luaT_error(L);
 	}
 
@@ -133,6 +146,37 @@ lbox_select(lua_State *L)
 	 */
 	port_dump_lua(&port, L, false);
 	port_destroy(&port);
+	if (!fetch_pos)
+		return 1; /* lua table with tuples */
+	if (pos != NULL)
+		lua_pushlstring(L, pos, pos_end - pos);
+	else
+		lua_pushnil(L);
+	region_truncate(&fiber()->gc, region_svp);
+	return 2; /* lua table with tuples and position */
+}
+
+/* }}} */
+
+/** {{{ Lua/C implementation of index:get_many() **/
+
+static int
+lbox_get_many(lua_State *L)
+{
+	if (lua_gettop(L) != 3 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2))
+		return luaL_error(L, "Usage index:get_many(keys)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+	size_t keys_len;
+	const char *keys = lbox_encode_tuple_on_gc(L, 3, &keys_len);
+
+	struct port port;
+	if (box_get_many(space_id, index_id, keys, keys + keys_len,
+			 &port) != 0)
+		return luaT_error(L);
+	port_dump_lua(&port, L, false);
+	port_destroy(&port);
 	return 1; /* lua table with tuples */
 }
 
@@ -252,6 +296,7 @@ box_lua_misc_init(struct lua_State *L)
 {
 	static const struct luaL_Reg boxlib_internal[] = {
 		{"select", lbox_select},
+		{"get_many", lbox_get_many},
 		{"new_tuple_format", lbox_tuple_format_new},
 		{NULL, NULL}
 	};
@@ -43,8 +43,10 @@
 #include "scramble.h"
 
 #include "box/iproto_constants.h"
+#include "box/iproto_compression.h"
 #include "box/iproto_features.h"
 #include "box/lua/tuple.h" /* luamp_convert_tuple() / luamp_convert_key() */
+#include "box/lua/net_box_io.h"
 #include "box/xrow.h"
 #include "box/tuple.h"
 #include "box/execute.h"
@@ -112,6 +114,7 @@ enum netbox_method {
 	NETBOX_COMMIT      = 18,
 	NETBOX_ROLLBACK    = 19,
 	NETBOX_INJECT      = 20,
+	NETBOX_SELECT_WITH_POS = 21,
 	netbox_method_MAX
 };
 
@@ -160,6 +163,11 @@ struct netbox_options {
 	 * Flag that determines is it required to fetch server schema or not.
 	 */
 	 bool fetch_schema;
+	/**
+	 * If set, the connection socket is served by the net.box I/O
+	 * thread (see net_box_io.h) rather than by the worker fiber.
+	 */
+	bool io_thread;
 };
 
 /**
@@ -247,10 +255,22 @@ struct netbox_transport {
 	struct iostream_ctx io_ctx;
 	/** Connection I/O stream. */
 	struct iostream io;
+	/**
+	 * Connection served by the net.box I/O thread or NULL.
+	 * Used instead of io if opts.io_thread is set.
+	 */
+	struct netbox_io *thread_io;
 	/** Connection send buffer. */
 	struct ibuf send_buf;
 	/** Connection receive buffer. */
 	struct ibuf recv_buf;
+	/**
+	 * Decompressor of IPROTO_COMPRESSED packets. Created on
+	 * the first compressed packet, zstream is NULL until then.
+	 */
+	struct iproto_decompressor decompressor;
+	/** Packets unpacked from the last IPROTO_COMPRESSED packet. */
+	struct ibuf unpack_buf;
 	/** Signalled when send_buf becomes empty. */
 	struct fiber_cond on_send_buf_empty;
 	/** Next request id. */
@@ -493,8 +513,11 @@ netbox_transport_create(struct netbox_transport *transport)
 	transport->self_ref = LUA_NOREF;
 	iostream_ctx_clear(&transport->io_ctx);
 	iostream_clear(&transport->io);
+	transport->thread_io = NULL;
 	ibuf_create(&transport->send_buf, &cord()->slabc, NETBOX_READAHEAD);
 	ibuf_create(&transport->recv_buf, &cord()->slabc, NETBOX_READAHEAD);
+	transport->decompressor.zstream = NULL;
+	ibuf_create(&transport->unpack_buf, &cord()->slabc, NETBOX_READAHEAD);
 	fiber_cond_create(&transport->on_send_buf_empty);
 	transport->next_sync = 1;
 	transport->requests = mh_i64ptr_new();
@@ -512,8 +535,12 @@ netbox_transport_destroy(struct netbox_transport *transport)
 	assert(transport->self_ref == LUA_NOREF);
 	iostream_ctx_destroy(&transport->io_ctx);
 	assert(!iostream_is_initialized(&transport->io));
+	assert(transport->thread_io == NULL);
 	assert(ibuf_used(&transport->send_buf) == 0);
 	assert(ibuf_used(&transport->recv_buf) == 0);
+	if (transport->decompressor.zstream != NULL)
+		iproto_decompressor_destroy(&transport->decompressor);
+	ibuf_destroy(&transport->unpack_buf);
 	fiber_cond_destroy(&transport->on_send_buf_empty);
 	struct mh_i64ptr_t *h = transport->requests;
 	assert(mh_size(h) == 0);
@@ -552,6 +579,7 @@ netbox_transport_set_error(struct netbox_transport *transport)
 	/* Reset buffers. */
 	ibuf_reinit(&transport->send_buf);
 	ibuf_reinit(&transport->recv_buf);
+	ibuf_reinit(&transport->unpack_buf);
 	fiber_cond_broadcast(&transport->on_send_buf_empty);
 	/* Complete requests and clean up the hash. */
 	struct mh_i64ptr_t *h = transport->requests;
@@ -782,11 +810,16 @@ static void
 netbox_encode_select(lua_State *L, int idx, struct mpstream *stream,
 		     uint64_t sync, uint64_t stream_id)
 {
-	/* Lua stack at idx: space_id, index_id, iterator, offset, limit, key */
+	/*
+	 * Lua stack at idx: space_id, index_id, iterator, offset, limit, key,
+	 * after (optional), fetch_pos (optional)
+	 */
 	size_t svp = netbox_begin_encode(stream, sync, IPROTO_SELECT,
 					 stream_id);
 
-	mpstream_encode_map(stream, 6);
+	bool has_after = !lua_isnoneornil(L, idx + 6);
+	bool fetch_pos = lua_toboolean(L, idx + 7);
+	mpstream_encode_map(stream, 6 + has_after + fetch_pos);
 
 	uint32_t space_id = lua_tonumber(L, idx);
 	uint32_t index_id = lua_tonumber(L, idx + 1);
@@ -818,6 +851,18 @@ netbox_encode_select(lua_State *L, int idx, struct mpstream *stream,
 	mpstream_encode_uint(stream, IPROTO_KEY);
 	luamp_convert_key(L, cfg, stream, idx + 5);
 
+	/* encode position */
+	if (has_after) {
+		size_t len;
+		const char *pos = lua_tolstring(L, idx + 6, &len);
+		mpstream_encode_uint(stream, IPROTO_AFTER_POSITION);
+		mpstream_encode_strn(stream, pos, len);
+	}
+	if (fetch_pos) {
+		mpstream_encode_uint(stream, IPROTO_FETCH_POSITION);
+		mpstream_encode_bool(stream, true);
+	}
+
 	netbox_end_encode(stream, svp);
 }
 
@@ -951,6 +996,48 @@ netbox_encode_upsert(lua_State *L, int idx, struct mpstream *stream,
 	netbox_end_encode(stream, svp);
 }
 
+/**
+ * Closes the connection of a transport, if any.
+ */
+static void
+netbox_transport_disconnect(struct netbox_transport *transport)
+{
+	if (transport->thread_io != NULL) {
+		netbox_io_delete(transport->thread_io);
+		transport->thread_io = NULL;
+	}
+	if (iostream_is_initialized(&transport->io))
+		iostream_close(&transport->io);
+}
+
+/**
+ * Connects a transport to a remote host in the net.box I/O thread
+ * and waits for a greeting message. Returns 0 on success, -1 on error.
+ */
+static int
+netbox_transport_connect_threaded(struct netbox_transport *transport)
+{
+	struct netbox_io *io = netbox_io_new(transport->opts.uri.host,
+					     transport->opts.uri.service,
+					     transport->opts.uri.host_hint,
+					     transport->opts.connect_timeout,
+					     &transport->on_send_buf_empty);
+	if (io == NULL)
+		return -1;
+	transport->thread_io = io;
+	if (netbox_io_connect(io, &transport->greeting) != 0)
+		goto error;
+	if (strcmp(transport->greeting.protocol, "Binary") != 0) {
+		box_error_raise(ER_NO_CONNECTION, "Unsupported protocol: %s",
+				transport->greeting.protocol);
+		goto error;
+	}
+	return 0;
+error:
+	netbox_transport_disconnect(transport);
+	return -1;
+}
+
 /**
  * Connects a transport to a remote host and reads a greeting message.
  * Returns 0 on success, -1 on error.
@@ -961,6 +1048,13 @@ netbox_transport_connect(struct netbox_transport *transport)
 	struct error *e;
 	struct iostream *io = &transport->io;
 	assert(!iostream_is_initialized(io));
+	assert(transport->thread_io == NULL);
+	/* The compressed stream starts anew with each connection. */
+	ibuf_reset(&transport->unpack_buf);
+	if (transport->decompressor.zstream != NULL)
+		iproto_decompressor_reset(&transport->decompressor);
+	if (transport->opts.io_thread)
+		return netbox_transport_connect_threaded(transport);
 	ev_tstamp start, delay;
 	coio_timeout_init(&start, &delay, transport->opts.connect_timeout);
 	int fd = coio_connect_timeout(transport->opts.uri.host,
@@ -998,6 +1092,46 @@ error:
 	return -1;
 }
 
+/**
+ * Passes the send buffer to the net.box I/O thread and waits for
+ * a packet received and decoded by it. Returns 0 and the packet
+ * header on success. On error returns -1 and sets diag.
+ *
+ * Unlike netbox_transport_communicate(), which signals the
+ * `on_send_buf_empty` conditional variable when the send buffer is
+ * written to the socket, here it's signalled by the thread when
+ * it has written all data passed to it.
+ */
+static int
+netbox_transport_recv_threaded(struct netbox_transport *transport,
+			       struct xrow_header *hdr)
+{
+	struct netbox_io *io = transport->thread_io;
+	assert(io != NULL);
+	while (true) {
+		int rc = netbox_io_recv(io, hdr);
+		if (rc <= 0)
+			return rc;
+		if (transport->state == NETBOX_GRACEFUL_SHUTDOWN &&
+		    transport->inprogress_request_count == 0) {
+			box_error_raise(ER_NO_CONNECTION, "Peer closed");
+			return -1;
+		}
+		netbox_io_send(io, &transport->send_buf);
+		if (netbox_io_wait(io) != 0)
+			return -1;
+		ERROR_INJECT_YIELD(ERRINJ_NETBOX_IO_DELAY);
+		ERROR_INJECT(ERRINJ_NETBOX_IO_ERROR, {
+			box_error_raise(ER_NO_CONNECTION, "Error injection");
+			return -1;
+		});
+		if (fiber_is_cancelled()) {
+			diag_set(FiberIsCancelled);
+			return -1;
+		}
+	}
+}
+
 /**
  * Reads data from the given socket until the limit is reached.
  * Returns 0 on success. On error returns -1 and sets diag.
@@ -1093,6 +1227,23 @@ io_error:
 	return -1;
 }
 
+/**
+ * Unpacks an IPROTO_COMPRESSED packet to the unpack buffer.
+ * Returns 0 on success, -1 on error.
+ */
+static int
+netbox_transport_unpack(struct netbox_transport *transport,
+			struct xrow_header *hdr)
+{
+	struct iproto_decompressor *decompressor = &transport->decompressor;
+	if (decompressor->zstream == NULL &&
+	    iproto_decompressor_create(decompressor) != 0)
+		return -1;
+	ibuf_reset(&transport->unpack_buf);
+	return iproto_decompressor_decompress(decompressor, hdr,
+					      &transport->unpack_buf);
+}
+
 /**
  * Sends and receives data over an iproto connection.
  * Returns 0 and a decoded response header on success.
@@ -1102,7 +1253,12 @@ static int
 netbox_transport_send_and_recv(struct netbox_transport *transport,
 			       struct xrow_header *hdr)
 {
+	if (transport->thread_io != NULL)
+		return netbox_transport_recv_threaded(transport, hdr);
 	while (true) {
+		if (ibuf_used(&transport->unpack_buf) > 0)
+			return iproto_decompressor_next(
+				&transport->unpack_buf, hdr);
 		size_t required;
 		size_t data_len = ibuf_used(&transport->recv_buf);
 		size_t fixheader_size = mp_sizeof_uint(UINT32_MAX);
@@ -1116,9 +1272,16 @@ netbox_transport_send_and_recv(struct netbox_transport *transport,
 			if (data_len >= required) {
 				const char *body_end = rpos + len;
 				transport->recv_buf.rpos = (char *)body_end;
-				return xrow_header_decode(
+				if (xrow_header_decode(
 					hdr, &rpos, body_end,
-					/*end_is_exact=*/true);
+					/*end_is_exact=*/true) != 0)
+					return -1;
+				if (hdr->type != IPROTO_COMPRESSED)
+					return 0;
+				if (netbox_transport_unpack(transport,
+							    hdr) != 0)
+					return -1;
+				continue;
 			}
 		}
 		if (netbox_transport_communicate(transport, required) != 0)
@@ -1278,6 +1441,7 @@ netbox_encode_method(struct lua_State *L, int idx, enum netbox_method method,
 		[NETBOX_COMMIT]         = netbox_encode_commit,
 		[NETBOX_ROLLBACK]       = netbox_encode_rollback,
 		[NETBOX_INJECT]		= netbox_encode_inject,
+		[NETBOX_SELECT_WITH_POS] = netbox_encode_select,
 	};
 	struct mpstream stream;
 	mpstream_init(&stream, ibuf, ibuf_reserve_cb, ibuf_alloc_cb,
@@ -1418,6 +1582,38 @@ netbox_decode_select(struct lua_State *L, const char **data,
 	}
 }
 
+/**
+ * Decodes Tarantool response body consisting of IPROTO_DATA and optional
+ * IPROTO_POSITION keys and pushes the table {tuples, position} to Lua stack.
+ */
+static void
+netbox_decode_select_with_pos(struct lua_State *L, const char **data,
+			      const char *data_end, bool return_raw,
+			      struct tuple_format *format)
+{
+	if (return_raw) {
+		luamp_push(L, *data, data_end);
+		*data = data_end;
+		return;
+	}
+	lua_createtable(L, 2, 0);
+	uint32_t map_size = mp_decode_map(data);
+	for (uint32_t i = 0; i < map_size; i++) {
+		uint32_t key = mp_decode_uint(data);
+		if (key == IPROTO_DATA) {
+			netbox_decode_data(L, data, format);
+			lua_rawseti(L, -2, 1);
+		} else if (key == IPROTO_POSITION) {
+			uint32_t len;
+			const char *pos = mp_decode_str(data, &len);
+			lua_pushlstring(L, pos, len);
+			lua_rawseti(L, -2, 2);
+		} else {
+			mp_next(data);
+		}
+	}
+}
+
 /**
  * Same as netbox_decode_select, but only decodes the first tuple of the array,
  * skipping the rest.
@@ -1702,6 +1898,7 @@ netbox_decode_method(struct lua_State *L, enum netbox_method method,
 		[NETBOX_COMMIT]         = netbox_decode_nil,
 		[NETBOX_ROLLBACK]       = netbox_decode_nil,
 		[NETBOX_INJECT]		= netbox_decode_table,
+		[NETBOX_SELECT_WITH_POS] = netbox_decode_select_with_pos,
 	};
 	method_decoder[method](L, data, data_end, return_raw, format);
 }
@@ -2011,12 +2208,12 @@ luaT_netbox_request_pairs(struct lua_State *L)
  * Takes the following arguments: uri (string, number, or table),
  * user (string or nil), password (string or nil), callback (function),
  * connect_timeout (number or nil), reconnect_after (number or nil),
- * fetch_schema (boolean or nil).
+ * fetch_schema (boolean or nil), io_thread (boolean or nil).
  */
 static int
 luaT_netbox_new_transport(struct lua_State *L)
 {
-	assert(lua_gettop(L) == 7);
+	assert(lua_gettop(L) == 8);
 	/* Create a transport object. */
 	struct netbox_transport *transport;
 	transport = lua_newuserdata(L, sizeof(*transport));
@@ -2040,11 +2237,23 @@ luaT_netbox_new_transport(struct lua_State *L)
 		opts->reconnect_after = luaL_checknumber(L, 6);
 	if (!lua_isnil(L, 7))
 		opts->fetch_schema = lua_toboolean(L, 7);
+	opts->io_thread = lua_toboolean(L, 8);
 	if (opts->user == NULL && opts->password != NULL) {
 		diag_set(ClientError, ER_PROC_LUA,
 			 "net.box: user is not defined");
 		return luaT_error(L);
 	}
+	/*
+	 * Checked before creating the stream context so that the error
+	 * is the same whether SSL is available in this build or not.
+	 */
+	const char *transport_param = uri_param(&opts->uri, "transport", 0);
+	if (opts->io_thread && transport_param != NULL &&
+	    strcmp(transport_param, "ssl") == 0) {
+		diag_set(ClientError, ER_UNSUPPORTED, "net.box I/O thread",
+			 "SSL connections");
+		return luaT_error(L);
+	}
 	if (iostream_ctx_create(&transport->io_ctx, IOSTREAM_CLIENT,
 				&opts->uri) != 0) {
 		return luaT_error(L);
@@ -2640,7 +2849,7 @@ netbox_worker_f(va_list ap)
 			/* The worker loop can only be broken by an error. */
 			assert(rc != 0);
 			(void)rc;
-			iostream_close(&transport->io);
+			netbox_transport_disconnect(transport);
 		}
 		if (transport->state == NETBOX_CLOSED)
 			break;
@@ -2713,7 +2922,9 @@ luaT_netbox_transport_stop(struct lua_State *L)
 		 * it is necessary to ensure that all requests are
 		 * sent before the connection is closed.
 		 */
-		while (ibuf_used(&transport->send_buf) > 0)
+		while (ibuf_used(&transport->send_buf) > 0 ||
+		       (transport->thread_io != NULL &&
+			netbox_io_is_sending(transport->thread_io)))
 			fiber_cond_wait(&transport->on_send_buf_empty);
 		transport->is_closing = false;
 	}
@@ -2773,6 +2984,8 @@ luaopen_net_box(struct lua_State *L)
 			    IPROTO_FEATURE_ERROR_EXTENSION);
 	iproto_features_set(&NETBOX_IPROTO_FEATURES,
 			    IPROTO_FEATURE_WATCHERS);
+	iproto_features_set(&NETBOX_IPROTO_FEATURES,
+			    IPROTO_FEATURE_COMPRESSION);
 
 	lua_pushcfunction(L, luaT_netbox_request_iterator_next);
 	luaT_netbox_request_iterator_next_ref = luaL_ref(L, LUA_REGISTRYINDEX);
@@ -46,6 +46,8 @@ local M_COMMIT      = 18
 local M_ROLLBACK    = 19
 -- Injects raw data into connection. Used by tests.
 local M_INJECT      = 20
+-- Same as M_SELECT, but also returns the position of the last tuple.
+local M_SELECT_WITH_POS = 21
 
 -- IPROTO feature id -> name
 local IPROTO_FEATURE_NAMES = {
@@ -53,6 +55,7 @@ local IPROTO_FEATURE_NAMES = {
     [1]     = 'transactions',
     [2]     = 'error_extension',
     [3]     = 'watchers',
+    [4]     = 'compression',
 }
 
 -- Given an array of IPROTO feature ids, returns a map {feature_name: bool}.
@@ -393,7 +396,7 @@ local function new_sm(uri, opts)
     local transport = internal.new_transport(
             uri, user, password, weak_callback,
             opts.connect_timeout, opts.reconnect_after,
-            opts.fetch_schema)
+            opts.fetch_schema, opts.io_thread)
     remote._transport = transport
     remote._gc_hook = ffi.gc(ffi.new('char[1]'), function()
         pcall(transport.stop, transport);
@@ -1009,10 +1012,32 @@ index_metatable = function(remote)
         check_index_arg(self, 'select')
         local key_is_nil = (key == nil or
                             (type(key) == 'table' and #key == 0))
-        local iterator, offset, limit = check_select_opts(opts, key_is_nil)
-        return (remote:_request(M_SELECT, opts, self.space._format_cdata,
-                                self._stream_id, self.space.id, self.id,
-                                iterator, offset, limit, key))
+        local iterator, offset, limit, after, fetch_pos =
+            check_select_opts(opts, key_is_nil)
+        if after ~= nil and type(after) ~= 'string' then
+            box.error(box.error.ILLEGAL_PARAMS,
+                      "net.box supports only string positions in " ..
+                      "'after' option")
+        end
+        if not fetch_pos then
+            return (remote:_request(M_SELECT, opts,
+                                    self.space._format_cdata,
+                                    self._stream_id, self.space.id, self.id,
+                                    iterator, offset, limit, key, after))
+        end
+        if opts.is_async or opts.buffer ~= nil then
+            box.error(box.error.ILLEGAL_PARAMS,
+                      "'fetch_pos' is not supported with 'is_async' " ..
+                      "or 'buffer' options")
+        end
+        local res = remote:_request(M_SELECT_WITH_POS, opts,
+                                    self.space._format_cdata,
+                                    self._stream_id, self.space.id, self.id,
+                                    iterator, offset, limit, key, after, true)
+        if opts.return_raw then
+            return res
+        end
+        return res[1], res[2]
     end
 
     function methods:get(key, opts)
@@ -1106,6 +1131,7 @@ this_module = {
         commit      = M_COMMIT,
         rollback    = M_ROLLBACK,
         inject      = M_INJECT,
+        select_with_pos = M_SELECT_WITH_POS,
     }
 }
 
@@ -0,0 +1,1065 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "net_box_io.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <small/ibuf.h>
+#include <msgpuck.h>
+
+#include "box/error.h"
+#include "box/iproto_constants.h"
+#include "box/iproto_compression.h"
+#include "box/xrow.h"
+#include "cbus.h"
+#include "coio.h"
+#include "coio_task.h"
+#include "diag.h"
+#include "fiber.h"
+#include "fiber_cond.h"
+#include "iostream.h"
+#include "salad/stailq.h"
+#include "trivia/util.h"
+
+enum {
+	/** Receive buffer readahead. */
+	NETBOX_IO_READAHEAD = 16320,
+	/**
+	 * Max amount of data read from the socket in one event loop
+	 * iteration, so that a fast server can't stall writing.
+	 */
+	NETBOX_IO_READ_MAX = 1024 * 1024,
+	/**
+	 * Max amount of data passed to the tx thread and not returned
+	 * by it yet, after which the thread stops reading the socket
+	 * until the tx thread catches up.
+	 */
+	NETBOX_IO_INPUT_MAX = 16 * 1024 * 1024,
+	/** Initial size of the packet array of a batch. */
+	NETBOX_IO_BATCH_ROWS_MIN = 16,
+};
+
+/** The thread doing I/O for all threaded net.box connections. */
+struct netbox_io_thread {
+	/** The thread cord. */
+	struct cord cord;
+	/** Pipe from the tx thread to the I/O thread. */
+	struct cpipe thread_pipe;
+	/** Pipe from the I/O thread to the tx thread. */
+	struct cpipe tx_pipe;
+	/** Endpoint of the tx thread, see netbox_io_tx_cb(). */
+	struct cbus_endpoint tx_endpoint;
+	/**
+	 * Connections served by the thread, linked by
+	 * netbox_io::in_thread. Accessed only by the I/O thread.
+	 */
+	struct rlist connections;
+	/** Set when the thread is started. */
+	bool is_started;
+};
+
+/**
+ * The thread is started on the first threaded connection and is
+ * stopped by netbox_io_free() at exit.
+ */
+static struct netbox_io_thread netbox_io_thread;
+
+/**
+ * Outgoing data passed from the tx thread to the I/O thread and
+ * returned back when it's written.
+ */
+struct netbox_io_chunk {
+	struct cmsg base;
+	/** The connection the chunk belongs to. */
+	struct netbox_io *io;
+	/** Link in netbox_io::send_queue. */
+	struct stailq_entry in_queue;
+	/**
+	 * The connection send buffer moved to the chunk. Its memory
+	 * belongs to the tx thread so it's destroyed by the tx thread
+	 * when the chunk is returned.
+	 */
+	struct ibuf buf;
+};
+
+/**
+ * Packets decoded by the I/O thread and passed to the tx thread.
+ *
+ * The packet bodies are referenced rather than copied: they point
+ * to the receive buffer of the connection or to the unpack buffer
+ * of the batch, which are owned by the I/O thread and aren't reused
+ * until the tx thread returns the batch.
+ */
+struct netbox_io_batch {
+	struct cmsg base;
+	/** The connection the batch belongs to. */
+	struct netbox_io *io;
+	/** Link in netbox_io::input. */
+	struct stailq_entry in_queue;
+	/** The receive buffer the packets were read to. */
+	struct ibuf *in;
+	/** Size of the packets in the receive buffer. */
+	size_t size;
+	/**
+	 * Packets carried by an IPROTO_COMPRESSED packet. A batch
+	 * unpacks at most one compressed packet, because unpacking
+	 * another one could relocate the buffer.
+	 */
+	struct ibuf unpack_buf;
+	/** Size of the unpacked data. */
+	size_t unpack_size;
+	/** Decoded packet headers. */
+	struct xrow_header *rows;
+	/** Number of decoded packets. */
+	int row_count;
+	/** Number of packets the rows array can store. */
+	int row_capacity;
+	/**
+	 * Index of the next packet to be returned by netbox_io_recv().
+	 * Accessed only by the tx thread.
+	 */
+	int next_row;
+};
+
+struct netbox_io {
+	/*
+	 * Members accessed only by the tx thread.
+	 */
+	/** Signalled on any event on the connection. */
+	struct fiber_cond cond;
+	/** Signalled when the thread has written all outgoing data. */
+	struct fiber_cond *on_send_done;
+	/** Set when the connection is deleted by the owner. */
+	bool is_closed;
+	/** Set when the greeting is received. */
+	bool is_connected;
+	/** Error that terminated the connection. */
+	struct diag diag;
+	/** Received batches, linked by netbox_io_batch::in_queue. */
+	struct stailq input;
+	/** Number of chunks not written to the socket yet. */
+	int send_count;
+	/*
+	 * Members set by the tx thread before the connection is
+	 * passed to the I/O thread.
+	 */
+	/** Remote host to connect to. */
+	char *host;
+	/** Remote service to connect to. */
+	char *service;
+	/** Hint passed to getaddrinfo(). */
+	int host_hint;
+	/** Connect and greeting timeout. */
+	double connect_timeout;
+	/*
+	 * Members accessed only by the I/O thread, unless said
+	 * otherwise.
+	 */
+	/** Link in netbox_io_thread::connections. */
+	struct rlist in_thread;
+	/** Fiber doing I/O. */
+	struct fiber *fiber;
+	/** Set while the fiber is running. */
+	bool is_running;
+	/** Set when the fiber may write to the socket. */
+	bool is_ready;
+	/** Connection I/O stream. */
+	struct iostream stream;
+	/**
+	 * Two rotating buffers for data read from the socket, see
+	 * netbox_io_input_buf(). Data between the read and the write
+	 * position of a buffer is referenced by batches not returned
+	 * by the tx thread yet, except for parse_size bytes at the
+	 * end of the current buffer.
+	 */
+	struct ibuf recv_buf[2];
+	/** The buffer the socket is read to. */
+	struct ibuf *p_recv_buf;
+	/** Size of data at the end of p_recv_buf not parsed yet. */
+	size_t parse_size;
+	/**
+	 * Decompressor of IPROTO_COMPRESSED packets. Created on
+	 * the first compressed packet, zstream is NULL until then.
+	 */
+	struct iproto_decompressor decompressor;
+	/** Chunks to be written, linked by netbox_io_chunk::in_queue. */
+	struct stailq send_queue;
+	/** Number of bytes of the first queued chunk written so far. */
+	size_t send_offset;
+	/**
+	 * Size of data passed to the tx thread and not returned by
+	 * it yet, see NETBOX_IO_INPUT_MAX.
+	 */
+	size_t input_size;
+	/** Number of batches passed to the tx thread. */
+	int batch_count;
+	/**
+	 * Set when the fiber stops reading the socket until the tx
+	 * thread returns a batch.
+	 */
+	bool is_input_blocked;
+	/**
+	 * The greeting. Set by the I/O thread before connected_msg
+	 * is sent, read by the tx thread after it's received.
+	 */
+	struct greeting greeting;
+	/**
+	 * Error that terminated the fiber. Set by the I/O thread
+	 * before error_msg is sent, moved to netbox_io::diag by the
+	 * tx thread after it's received.
+	 */
+	struct diag thread_diag;
+	/*
+	 * Messages. Each is sent at most once so they can be
+	 * embedded.
+	 */
+	/** Starts connecting, tx -> I/O. */
+	struct cmsg connect_msg;
+	/** The greeting is received, I/O -> tx. */
+	struct cmsg connected_msg;
+	/** The fiber failed, I/O -> tx. */
+	struct cmsg error_msg;
+	/**
+	 * Closes the connection, tx -> I/O -> tx, then frees it,
+	 * tx -> I/O -> tx. The second round trip lets the I/O thread
+	 * receive all batches the tx thread returned on close before
+	 * the receive buffers and the connection are freed.
+	 */
+	struct cmsg close_msg;
+};
+
+static void
+netbox_io_tx_input_f(struct cmsg *m);
+
+static void
+netbox_io_tx_send_done_f(struct cmsg *m);
+
+static void
+netbox_io_tx_connected_f(struct cmsg *m);
+
+static void
+netbox_io_tx_error_f(struct cmsg *m);
+
+/* {{{ I/O thread */
+
+/** Returns a chunk written to the socket to the tx thread. */
+static void
+netbox_io_send_done(struct netbox_io_chunk *chunk)
+{
+	static const struct cmsg_hop route[] = {
+		{netbox_io_tx_send_done_f, NULL},
+	};
+	cmsg_init(&chunk->base, route);
+	cpipe_push(&netbox_io_thread.tx_pipe, &chunk->base);
+}
+
+/** Returns all queued chunks to the tx thread. */
+static void
+netbox_io_flush_send_queue(struct netbox_io *io)
+{
+	struct netbox_io_chunk *chunk, *tmp;
+	stailq_foreach_entry_safe(chunk, tmp, &io->send_queue, in_queue)
+		netbox_io_send_done(chunk);
+	stailq_create(&io->send_queue);
+	io->send_offset = 0;
+}
+
+/**
+ * Connects to the remote host and reads the greeting.
+ * Returns 0 on success, -1 on error.
+ */
+static int
+netbox_io_do_connect(struct netbox_io *io)
+{
+	struct error *e;
+	ev_tstamp start, delay;
+	coio_timeout_init(&start, &delay, io->connect_timeout);
+	int fd = coio_connect_timeout(io->host, io->service, io->host_hint,
+				      /*addr=*/NULL, /*addr_len=*/NULL, delay);
+	coio_timeout_update(&start, &delay);
+	if (fd < 0)
+		goto io_error;
+	plain_iostream_create(&io->stream, fd);
+	char greetingbuf[IPROTO_GREETING_SIZE];
+	if (coio_readn_timeout(&io->stream, greetingbuf, IPROTO_GREETING_SIZE,
+			       delay) < 0)
+		goto io_error;
+	if (greeting_decode(greetingbuf, &io->greeting) != 0) {
+		box_error_raise(ER_NO_CONNECTION, "Invalid greeting");
+		return -1;
+	}
+	return 0;
+io_error:
+	assert(!diag_is_empty(diag_get()));
+	e = diag_last_error(diag_get());
+	box_error_raise(ER_NO_CONNECTION, "%s", e->errmsg);
+	return -1;
+}
+
+/** Allocates a batch of packets read to the given buffer. */
+static struct netbox_io_batch *
+netbox_io_batch_new(struct netbox_io *io, struct ibuf *in)
+{
+	struct netbox_io_batch *batch = malloc(sizeof(*batch));
+	if (batch == NULL) {
+		diag_set(OutOfMemory, sizeof(*batch), "malloc", "batch");
+		return NULL;
+	}
+	batch->io = io;
+	batch->in = in;
+	batch->size = 0;
+	ibuf_create(&batch->unpack_buf, &cord()->slabc, NETBOX_IO_READAHEAD);
+	batch->unpack_size = 0;
+	batch->rows = NULL;
+	batch->row_count = 0;
+	batch->row_capacity = 0;
+	batch->next_row = 0;
+	return batch;
+}
+
+/** Frees a batch. Must be called from the I/O thread. */
+static void
+netbox_io_batch_delete(struct netbox_io_batch *batch)
+{
+	ibuf_destroy(&batch->unpack_buf);
+	free(batch->rows);
+	free(batch);
+}
+
+/**
+ * Validates the body of a decoded packet and appends the packet to
+ * a batch. The tx thread decodes the body without checks so a
+ * malformed packet must be rejected here. Returns 0 on success,
+ * -1 on error.
+ */
+static int
+netbox_io_batch_add(struct netbox_io_batch *batch,
+		    const struct xrow_header *row)
+{
+	if (row->bodycnt > 0) {
+		const char *data = row->body[0].iov_base;
+		const char *data_end = data + row->body[0].iov_len;
+		if (mp_check(&data, data_end) != 0 || data != data_end) {
+			diag_set(ClientError, ER_INVALID_MSGPACK,
+				 "packet body");
+			return -1;
+		}
+	}
+	if (batch->row_count == batch->row_capacity) {
+		int capacity = MAX(batch->row_capacity * 2,
+				   NETBOX_IO_BATCH_ROWS_MIN);
+		size_t size = capacity * sizeof(*batch->rows);
+		struct xrow_header *rows = realloc(batch->rows, size);
+		if (rows == NULL) {
+			diag_set(OutOfMemory, size, "realloc", "rows");
+			return -1;
+		}
+		batch->rows = rows;
+		batch->row_capacity = capacity;
+	}
+	batch->rows[batch->row_count++] = *row;
+	return 0;
+}
+
+/**
+ * Unpacks an IPROTO_COMPRESSED packet to the unpack buffer of a batch
+ * and appends the packets it carries to the batch. Returns 0 on
+ * success, -1 on error.
+ */
+static int
+netbox_io_batch_unpack(struct netbox_io_batch *batch,
+		       const struct xrow_header *row)
+{
+	struct iproto_decompressor *decompressor = &batch->io->decompressor;
+	if (decompressor->zstream == NULL &&
+	    iproto_decompressor_create(decompressor) != 0)
+		return -1;
+	struct ibuf *buf = &batch->unpack_buf;
+	assert(batch->unpack_size == 0);
+	if (iproto_decompressor_decompress(decompressor, row, buf) != 0)
+		return -1;
+	batch->unpack_size = ibuf_used(buf);
+	while (ibuf_used(buf) > 0) {
+		struct xrow_header unpacked;
+		if (iproto_decompressor_next(buf, &unpacked) != 0 ||
+		    netbox_io_batch_add(batch, &unpacked) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/** Passes a batch to the tx thread. */
+static void
+netbox_io_batch_push(struct netbox_io_batch *batch)
+{
+	struct netbox_io *io = batch->io;
+	static const struct cmsg_hop route[] = {
+		{netbox_io_tx_input_f, NULL},
+	};
+	cmsg_init(&batch->base, route);
+	io->input_size += batch->size + batch->unpack_size;
+	io->batch_count++;
+	cpipe_push(&netbox_io_thread.tx_pipe, &batch->base);
+}
+
+/**
+ * Returns the buffer to read the socket to or NULL if both buffers
+ * are referenced by batches not returned by the tx thread yet.
+ * Returns -1 on memory error, 0 otherwise.
+ *
+ * A buffer that has data referenced by batches can't be reallocated,
+ * so when it runs out of space, reading switches to the other buffer,
+ * which is recycled when all its batches are returned, like it's
+ * done for iproto connections.
+ */
+static int
+netbox_io_input_buf(struct netbox_io *io, struct ibuf **ret)
+{
+	struct ibuf *old_buf = io->p_recv_buf;
+	size_t to_read = NETBOX_IO_READAHEAD;
+	if (ibuf_unused(old_buf) >= to_read) {
+		if (ibuf_used(old_buf) == 0)
+			ibuf_reset(old_buf);
+		*ret = old_buf;
+		return 0;
+	}
+	if (ibuf_used(old_buf) == io->parse_size) {
+		/* Only unparsed data, nothing is referenced. */
+		if (ibuf_reserve(old_buf, to_read) == NULL)
+			goto oom;
+		*ret = old_buf;
+		return 0;
+	}
+	struct ibuf *new_buf = old_buf == &io->recv_buf[0] ?
+			       &io->recv_buf[1] : &io->recv_buf[0];
+	if (ibuf_used(new_buf) != 0) {
+		/* Wait until the tx thread returns the batches. */
+		*ret = NULL;
+		return 0;
+	}
+	ibuf_reset(new_buf);
+	to_read += io->parse_size;
+	if (ibuf_reserve(new_buf, to_read) == NULL)
+		goto oom;
+	/* Move the unparsed packet prefix to the new buffer. */
+	old_buf->wpos -= io->parse_size;
+	memcpy(new_buf->wpos, old_buf->wpos, io->parse_size);
+	new_buf->wpos += io->parse_size;
+	io->p_recv_buf = new_buf;
+	*ret = new_buf;
+	return 0;
+oom:
+	diag_set(OutOfMemory, to_read, "ibuf_reserve", "buf");
+	return -1;
+}
+
+/**
+ * Splits received data into packets, decodes and validates them,
+ * unpacks compressed packets and passes the result to the tx thread.
+ * Returns 0 on success, -1 on error.
+ */
+static int
+netbox_io_parse(struct netbox_io *io)
+{
+	struct ibuf *in = io->p_recv_buf;
+	struct netbox_io_batch *batch = NULL;
+	const char *pos = in->wpos - io->parse_size;
+	while (pos < in->wpos) {
+		const char *rpos = pos;
+		if (mp_typeof(*rpos) != MP_UINT) {
+			diag_set(ClientError, ER_INVALID_MSGPACK,
+				 "packet length");
+			goto error;
+		}
+		if (mp_check_uint(rpos, in->wpos) > 0)
+			break;
+		uint64_t len = mp_decode_uint(&rpos);
+		if (len > (uint64_t)(in->wpos - rpos))
+			break;
+		const char *body_end = rpos + len;
+		struct xrow_header hdr;
+		if (xrow_header_decode(&hdr, &rpos, body_end,
+				       /*end_is_exact=*/true) != 0)
+			goto error;
+		if (batch != NULL && hdr.type == IPROTO_COMPRESSED &&
+		    batch->unpack_size > 0) {
+			netbox_io_batch_push(batch);
+			batch = NULL;
+		}
+		if (batch == NULL) {
+			batch = netbox_io_batch_new(io, in);
+			if (batch == NULL)
+				goto error;
+		}
+		if (hdr.type == IPROTO_COMPRESSED) {
+			if (netbox_io_batch_unpack(batch, &hdr) != 0)
+				goto error;
+		} else if (netbox_io_batch_add(batch, &hdr) != 0) {
+			goto error;
+		}
+		batch->size += body_end - pos;
+		io->parse_size -= body_end - pos;
+		pos = body_end;
+	}
+	if (batch != NULL)
+		netbox_io_batch_push(batch);
+	return 0;
+error:
+	if (batch != NULL)
+		netbox_io_batch_delete(batch);
+	return -1;
+}
+
+/**
+ * Reads and writes data until an error occurs.
+ * Always returns -1 and sets diag.
+ */
+static int
+netbox_io_communicate(struct netbox_io *io)
+{
+	struct error *e;
+	struct iostream *stream = &io->stream;
+	while (true) {
+		int events = 0;
+		size_t read_size = 0;
+		while (true) {
+			if (read_size >= NETBOX_IO_READ_MAX) {
+				/* Continue reading after writing. */
+				events |= COIO_READ;
+				break;
+			}
+			struct ibuf *in = NULL;
+			if (io->input_size < NETBOX_IO_INPUT_MAX &&
+			    netbox_io_input_buf(io, &in) != 0)
+				return -1;
+			if (in == NULL) {
+				/*
+				 * The tx thread is lagging behind. Continue
+				 * reading when it returns batches, see
+				 * netbox_io_thread_input_done_f().
+				 */
+				io->is_input_blocked = true;
+				break;
+			}
+			ssize_t rc = iostream_read(stream, in->wpos,
+						   ibuf_unused(in));
+			if (rc == 0) {
+				box_error_raise(ER_NO_CONNECTION,
+						"Peer closed");
+				return -1;
+			} if (rc > 0) {
+				in->wpos += rc;
+				io->parse_size += rc;
+				read_size += rc;
+				if (netbox_io_parse(io) != 0)
+					return -1;
+			} else if (rc == IOSTREAM_ERROR) {
+				goto io_error;
+			} else {
+				events |= iostream_status_to_events(rc);
+				break;
+			}
+		}
+		while (!stailq_empty(&io->send_queue)) {
+			struct netbox_io_chunk *chunk = stailq_first_entry(
+				&io->send_queue, struct netbox_io_chunk,
+				in_queue);
+			struct ibuf *buf = &chunk->buf;
+			ssize_t rc = iostream_write(
+				stream, buf->rpos + io->send_offset,
+				ibuf_used(buf) - io->send_offset);
+			if (rc >= 0) {
+				io->send_offset += rc;
+				if (io->send_offset == ibuf_used(buf)) {
+					stailq_shift(&io->send_queue);
+					io->send_offset = 0;
+					netbox_io_send_done(chunk);
+				}
+			} else if (rc == IOSTREAM_ERROR) {
+				goto io_error;
+			} else {
+				events |= iostream_status_to_events(rc);
+				break;
+			}
+		}
+		if (events != 0)
+			coio_wait(stream->fd, events, TIMEOUT_INFINITY);
+		else
+			fiber_yield();
+		if (fiber_is_cancelled()) {
+			diag_set(FiberIsCancelled);
+			return -1;
+		}
+	}
+io_error:
+	assert(!diag_is_empty(diag_get()));
+	e = diag_last_error(diag_get());
+	box_error_raise(ER_NO_CONNECTION, "%s", e->errmsg);
+	return -1;
+}
+
+/** Connection fiber function. */
+static int
+netbox_io_fiber_f(va_list ap)
+{
+	struct netbox_io *io = va_arg(ap, struct netbox_io *);
+	if (netbox_io_do_connect(io) != 0)
+		goto error;
+	static const struct cmsg_hop connected_route[] = {
+		{netbox_io_tx_connected_f, NULL},
+	};
+	cmsg_init(&io->connected_msg, connected_route);
+	cpipe_push(&netbox_io_thread.tx_pipe, &io->connected_msg);
+	io->is_ready = true;
+	netbox_io_communicate(io);
+error:
+	io->is_running = false;
+	io->is_ready = false;
+	netbox_io_flush_send_queue(io);
+	if (fiber_is_cancelled()) {
+		/* The connection is being closed. */
+		return 0;
+	}
+	static const struct cmsg_hop error_route[] = {
+		{netbox_io_tx_error_f, NULL},
+	};
+	diag_move(diag_get(), &io->thread_diag);
+	cmsg_init(&io->error_msg, error_route);
+	cpipe_push(&netbox_io_thread.tx_pipe, &io->error_msg);
+	return 0;
+}
+
+/** Starts connecting in the I/O thread. */
+static void
+netbox_io_thread_connect_f(struct cmsg *m)
+{
+	struct netbox_io *io = container_of(m, struct netbox_io, connect_msg);
+	iostream_clear(&io->stream);
+	ibuf_create(&io->recv_buf[0], &cord()->slabc, NETBOX_IO_READAHEAD);
+	ibuf_create(&io->recv_buf[1], &cord()->slabc, NETBOX_IO_READAHEAD);
+	io->p_recv_buf = &io->recv_buf[0];
+	io->parse_size = 0;
+	io->decompressor.zstream = NULL;
+	stailq_create(&io->send_queue);
+	io->send_offset = 0;
+	io->input_size = 0;
+	io->batch_count = 0;
+	io->is_input_blocked = false;
+	io->is_ready = false;
+	rlist_add_entry(&netbox_io_thread.connections, io, in_thread);
+	io->fiber = fiber_new("net.box.io", netbox_io_fiber_f);
+	if (io->fiber == NULL) {
+		static const struct cmsg_hop error_route[] = {
+			{netbox_io_tx_error_f, NULL},
+		};
+		diag_move(diag_get(), &io->thread_diag);
+		cmsg_init(&io->error_msg, error_route);
+		cpipe_push(&netbox_io_thread.tx_pipe, &io->error_msg);
+		return;
+	}
+	fiber_set_joinable(io->fiber, true);
+	io->is_running = true;
+	fiber_start(io->fiber, io);
+}
+
+/** Queues a chunk for writing in the I/O thread. */
+static void
+netbox_io_thread_send_f(struct cmsg *m)
+{
+	struct netbox_io_chunk *chunk = (struct netbox_io_chunk *)m;
+	struct netbox_io *io = chunk->io;
+	if (!io->is_running) {
+		/* The connection is dead, drop the data. */
+		netbox_io_send_done(chunk);
+		return;
+	}
+	stailq_add_tail_entry(&io->send_queue, chunk, in_queue);
+	if (io->is_ready)
+		fiber_wakeup(io->fiber);
+}
+
+/** Recycles a batch returned by the tx thread. */
+static void
+netbox_io_thread_input_done_f(struct cmsg *m)
+{
+	struct netbox_io_batch *batch = (struct netbox_io_batch *)m;
+	struct netbox_io *io = batch->io;
+	assert(ibuf_used(batch->in) >= batch->size);
+	batch->in->rpos += batch->size;
+	assert(io->input_size >= batch->size + batch->unpack_size);
+	io->input_size -= batch->size + batch->unpack_size;
+	assert(io->batch_count > 0);
+	io->batch_count--;
+	netbox_io_batch_delete(batch);
+	if (io->is_input_blocked && io->is_ready) {
+		io->is_input_blocked = false;
+		fiber_wakeup(io->fiber);
+	}
+}
+
+/** Stops the connection fiber and closes the socket. */
+static void
+netbox_io_thread_close(struct netbox_io *io)
+{
+	rlist_del_entry(io, in_thread);
+	if (io->fiber != NULL) {
+		fiber_cancel(io->fiber);
+		fiber_join(io->fiber);
+		io->fiber = NULL;
+	}
+	assert(stailq_empty(&io->send_queue));
+	if (iostream_is_initialized(&io->stream))
+		iostream_close(&io->stream);
+	if (io->decompressor.zstream != NULL)
+		iproto_decompressor_destroy(&io->decompressor);
+}
+
+/**
+ * Frees the receive buffers of a connection. Must be called after
+ * all batches are returned by the tx thread.
+ */
+static void
+netbox_io_thread_destroy(struct netbox_io *io)
+{
+	ibuf_destroy(&io->recv_buf[0]);
+	ibuf_destroy(&io->recv_buf[1]);
+}
+
+/** Closes the connection in the I/O thread. */
+static void
+netbox_io_thread_close_f(struct cmsg *m)
+{
+	struct netbox_io *io = container_of(m, struct netbox_io, close_msg);
+	netbox_io_thread_close(io);
+}
+
+/** Frees the connection resources of the I/O thread. */
+static void
+netbox_io_thread_destroy_f(struct cmsg *m)
+{
+	struct netbox_io *io = container_of(m, struct netbox_io, close_msg);
+	assert(io->batch_count == 0);
+	netbox_io_thread_destroy(io);
+}
+
+/** The I/O thread function. */
+static int
+netbox_io_thread_f(va_list ap)
+{
+	struct netbox_io_thread *thread = va_arg(ap, typeof(thread));
+	/* getaddrinfo() is run in the coio thread pool. */
+	coio_enable();
+	struct cbus_endpoint endpoint;
+	int rc = cbus_endpoint_create(&endpoint, cord()->name,
+				      fiber_schedule_cb, fiber());
+	assert(rc == 0);
+	(void)rc;
+
+	cpipe_create(&thread->tx_pipe, "net.box.tx");
+
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	/*
+	 * Connections that weren't closed by the tx thread. Batches
+	 * not returned by the tx thread and receive buffers of closed
+	 * connections are freed along with the thread slab cache.
+	 */
+	struct netbox_io *io, *tmp;
+	rlist_foreach_entry_safe(io, &thread->connections, in_thread, tmp) {
+		netbox_io_thread_close(io);
+		netbox_io_thread_destroy(io);
+	}
+	cpipe_destroy(&thread->tx_pipe);
+	return 0;
+}
+
+/* }}} I/O thread */
+
+/* {{{ tx thread */
+
+/** Processes messages sent by the I/O thread to the tx thread. */
+static void
+netbox_io_tx_cb(struct ev_loop *loop, struct ev_watcher *watcher, int events)
+{
+	(void)loop;
+	(void)events;
+	struct cbus_endpoint *endpoint = (struct cbus_endpoint *)watcher->data;
+	cbus_process(endpoint);
+}
+
+/**
+ * Starts the I/O thread unless it's already running.
+ * Returns 0 on success, -1 on error.
+ */
+static int
+netbox_io_thread_start(void)
+{
+	struct netbox_io_thread *thread = &netbox_io_thread;
+	if (thread->is_started)
+		return 0;
+	/*
+	 * The tx endpoint must exist before the thread is started,
+	 * because the thread blocks until it's created.
+	 */
+	int rc = cbus_endpoint_create(&thread->tx_endpoint, "net.box.tx",
+				      netbox_io_tx_cb, &thread->tx_endpoint);
+	assert(rc == 0);
+	(void)rc;
+	rlist_create(&thread->connections);
+	if (cord_costart(&thread->cord, "net.box.io", netbox_io_thread_f,
+			 thread) != 0) {
+		cbus_endpoint_destroy(&thread->tx_endpoint, cbus_process);
+		return -1;
+	}
+	cpipe_create(&thread->thread_pipe, "net.box.io");
+	thread->is_started = true;
+	return 0;
+}
+
+/**
+ * Returns a batch to the I/O thread so that it can reuse the memory
+ * the packets point to.
+ */
+static void
+netbox_io_batch_done(struct netbox_io_batch *batch)
+{
+	if (!netbox_io_thread.is_started) {
+		/*
+		 * The thread is stopped, its memory is freed along
+		 * with its slab cache.
+		 */
+		free(batch->rows);
+		free(batch);
+		return;
+	}
+	static const struct cmsg_hop route[] = {
+		{netbox_io_thread_input_done_f, NULL},
+	};
+	cmsg_init(&batch->base, route);
+	cpipe_push(&netbox_io_thread.thread_pipe, &batch->base);
+}
+
+/** Appends a batch received by the I/O thread to the input. */
+static void
+netbox_io_tx_input_f(struct cmsg *m)
+{
+	struct netbox_io_batch *batch = (struct netbox_io_batch *)m;
+	struct netbox_io *io = batch->io;
+	if (io->is_closed) {
+		netbox_io_batch_done(batch);
+		return;
+	}
+	stailq_add_tail_entry(&io->input, batch, in_queue);
+	fiber_cond_broadcast(&io->cond);
+}
+
+/** Frees a chunk written by the I/O thread. */
+static void
+netbox_io_tx_send_done_f(struct cmsg *m)
+{
+	struct netbox_io_chunk *chunk = (struct netbox_io_chunk *)m;
+	struct netbox_io *io = chunk->io;
+	ibuf_destroy(&chunk->buf);
+	free(chunk);
+	assert(io->send_count > 0);
+	if (--io->send_count == 0 && !io->is_closed)
+		fiber_cond_broadcast(io->on_send_done);
+}
+
+/** Marks the connection as established. */
+static void
+netbox_io_tx_connected_f(struct cmsg *m)
+{
+	struct netbox_io *io = container_of(m, struct netbox_io,
+					    connected_msg);
+	io->is_connected = true;
+	fiber_cond_broadcast(&io->cond);
+}
+
+/** Saves the error that terminated the connection. */
+static void
+netbox_io_tx_error_f(struct cmsg *m)
+{
+	struct netbox_io *io = container_of(m, struct netbox_io, error_msg);
+	diag_move(&io->thread_diag, &io->diag);
+	fiber_cond_broadcast(&io->cond);
+}
+
+/** Frees the connection. */
+static void
+netbox_io_tx_destroy_f(struct cmsg *m)
+{
+	struct netbox_io *io = container_of(m, struct netbox_io, close_msg);
+	diag_destroy(&io->diag);
+	diag_destroy(&io->thread_diag);
+	fiber_cond_destroy(&io->cond);
+	free(io->host);
+	free(io->service);
+	free(io);
+}
+
+/**
+ * Frees the connection closed by the I/O thread after the I/O
+ * thread receives all batches returned to it.
+ */
+static void
+netbox_io_tx_close_f(struct cmsg *m)
+{
+	struct netbox_io *io = container_of(m, struct netbox_io, close_msg);
+	assert(io->is_closed);
+	assert(io->send_count == 0);
+	assert(stailq_empty(&io->input));
+	if (!netbox_io_thread.is_started) {
+		netbox_io_tx_destroy_f(m);
+		return;
+	}
+	static const struct cmsg_hop route[] = {
+		{netbox_io_thread_destroy_f, &netbox_io_thread.tx_pipe},
+		{netbox_io_tx_destroy_f, NULL},
+	};
+	cmsg_init(&io->close_msg, route);
+	cpipe_push(&netbox_io_thread.thread_pipe, &io->close_msg);
+}
+
+struct netbox_io *
+netbox_io_new(const char *host, const char *service, int host_hint,
+	      double connect_timeout, struct fiber_cond *on_send_done)
+{
+	if (netbox_io_thread_start() != 0)
+		return NULL;
+	struct netbox_io *io = calloc(1, sizeof(*io));
+	if (io == NULL) {
+		diag_set(OutOfMemory, sizeof(*io), "calloc", "io");
+		return NULL;
+	}
+	fiber_cond_create(&io->cond);
+	io->on_send_done = on_send_done;
+	diag_create(&io->diag);
+	diag_create(&io->thread_diag);
+	stailq_create(&io->input);
+	io->host = xstrdup(host != NULL ? host : "");
+	io->service = xstrdup(service != NULL ? service : "");
+	io->host_hint = host_hint;
+	io->connect_timeout = connect_timeout;
+	static const struct cmsg_hop route[] = {
+		{netbox_io_thread_connect_f, NULL},
+	};
+	cmsg_init(&io->connect_msg, route);
+	cpipe_push(&netbox_io_thread.thread_pipe, &io->connect_msg);
+	return io;
+}
+
+void
+netbox_io_delete(struct netbox_io *io)
+{
+	assert(!io->is_closed);
+	io->is_closed = true;
+	struct netbox_io_batch *batch, *tmp;
+	stailq_foreach_entry_safe(batch, tmp, &io->input, in_queue)
+		netbox_io_batch_done(batch);
+	stailq_create(&io->input);
+	static const struct cmsg_hop route[] = {
+		{netbox_io_thread_close_f, &netbox_io_thread.tx_pipe},
+		{netbox_io_tx_close_f, NULL},
+	};
+	cmsg_init(&io->close_msg, route);
+	cpipe_push(&netbox_io_thread.thread_pipe, &io->close_msg);
+}
+
+/** Sets diag to the error that terminated the connection. */
+static void
+netbox_io_set_error(struct netbox_io *io)
+{
+	assert(!diag_is_empty(&io->diag));
+	diag_set_error(diag_get(), diag_last_error(&io->diag));
+}
+
+int
+netbox_io_connect(struct netbox_io *io, struct greeting *greeting)
+{
+	while (!io->is_connected) {
+		if (!diag_is_empty(&io->diag)) {
+			netbox_io_set_error(io);
+			return -1;
+		}
+		if (fiber_cond_wait(&io->cond) != 0)
+			return -1;
+	}
+	*greeting = io->greeting;
+	return 0;
+}
+
+void
+netbox_io_send(struct netbox_io *io, struct ibuf *buf)
+{
+	if (ibuf_used(buf) == 0)
+		return;
+	struct netbox_io_chunk *chunk = xmalloc(sizeof(*chunk));
+	static const struct cmsg_hop route[] = {
+		{netbox_io_thread_send_f, NULL},
+	};
+	cmsg_init(&chunk->base, route);
+	chunk->io = io;
+	chunk->buf = *buf;
+	ibuf_create(buf, buf->slabc, buf->start_capacity);
+	io->send_count++;
+	cpipe_push(&netbox_io_thread.thread_pipe, &chunk->base);
+}
+
+bool
+netbox_io_is_sending(struct netbox_io *io)
+{
+	return io->send_count > 0;
+}
+
+int
+netbox_io_recv(struct netbox_io *io, struct xrow_header *row)
+{
+	while (!stailq_empty(&io->input)) {
+		struct netbox_io_batch *batch = stailq_first_entry(
+			&io->input, struct netbox_io_batch, in_queue);
+		if (batch->next_row < batch->row_count) {
+			*row = batch->rows[batch->next_row++];
+			return 0;
+		}
+		/* The previous packet is processed by the caller. */
+		stailq_shift(&io->input);
+		netbox_io_batch_done(batch);
+	}
+	if (diag_is_empty(&io->diag))
+		return 1;
+	netbox_io_set_error(io);
+	return -1;
+}
+
+int
+netbox_io_wait(struct netbox_io *io)
+{
+	return fiber_cond_wait(&io->cond);
+}
+
+void
+netbox_io_free(void)
+{
+	struct netbox_io_thread *thread = &netbox_io_thread;
+	if (!thread->is_started)
+		return;
+	cbus_stop_loop(&thread->thread_pipe);
+	cpipe_destroy(&thread->thread_pipe);
+	if (cord_join(&thread->cord) != 0)
+		panic_syserror("net.box I/O thread join failed");
+	/*
+	 * Messages left in the tx endpoint must not be forwarded
+	 * to the stopped thread.
+	 */
+	thread->is_started = false;
+	cbus_endpoint_destroy(&thread->tx_endpoint, cbus_process);
+}
+
+/* }}} tx thread */
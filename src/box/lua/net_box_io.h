@@ -0,0 +1,101 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+/*
+ * net.box connection I/O offloaded to a separate thread.
+ *
+ * The thread owns the socket: it connects to the remote host, reads
+ * the greeting, writes outgoing data, reads incoming data, splits it
+ * into packets, unpacks IPROTO_COMPRESSED packets, decodes packet
+ * headers and validates packet bodies. The tx thread only encodes
+ * requests and converts response bodies to Lua objects, which can't
+ * be done outside of it.
+ *
+ * Data isn't copied between the threads. The connection send buffer
+ * is moved to the thread and returned when it's written. Received
+ * packets are passed to the tx thread as decoded headers pointing to
+ * the thread receive buffers, which aren't reused until the tx thread
+ * is done with the packets.
+ *
+ * All functions below must be called from the tx thread.
+ */
+#include <stdbool.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct ibuf;
+struct fiber_cond;
+struct greeting;
+struct netbox_io;
+struct xrow_header;
+
+/**
+ * Create a connection and start connecting to the given host in
+ * the net.box I/O thread, starting the thread if it isn't running.
+ * Returns NULL and sets diag on error.
+ */
+struct netbox_io *
+netbox_io_new(const char *host, const char *service, int host_hint,
+	      double connect_timeout, struct fiber_cond *on_send_done);
+
+/**
+ * Close a connection. The object must not be used after this
+ * function returns.
+ */
+void
+netbox_io_delete(struct netbox_io *io);
+
+/**
+ * Wait until a connection is established and the greeting is
+ * received. Returns 0 and copies the greeting on success, -1 and
+ * sets diag on error.
+ */
+int
+netbox_io_connect(struct netbox_io *io, struct greeting *greeting);
+
+/**
+ * Pass all data accumulated in the given buffer to the thread to
+ * be written to the socket. The buffer memory is moved to the thread
+ * and the buffer is reinitialized.
+ */
+void
+netbox_io_send(struct netbox_io *io, struct ibuf *buf);
+
+/** Check whether there's data not written to the socket yet. */
+bool
+netbox_io_is_sending(struct netbox_io *io);
+
+/**
+ * Get the next packet received by the thread. Returns 0 and decodes
+ * the packet header to @a row on success. The packet body stays valid
+ * until the next call. Returns 1 if there are no packets. If there
+ * are no packets and the connection was terminated by an error,
+ * returns -1 and sets diag.
+ */
+int
+netbox_io_recv(struct netbox_io *io, struct xrow_header *row);
+
+/**
+ * Wait for an event on a connection. May return spuriously.
+ * Returns -1 and sets diag if the fiber was cancelled.
+ */
+int
+netbox_io_wait(struct netbox_io *io);
+
+/**
+ * Stop the net.box I/O thread if it's running. Connections that
+ * haven't been closed must not be used after this function
+ * returns.
+ */
+void
+netbox_io_free(void);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
@@ -43,6 +43,11 @@ ffi.cdef[[
     void
     box_iterator_free(box_iterator_t *itr);
     /** \endcond public */
+    box_iterator_t *
+    box_index_iterator_after(uint32_t space_id, uint32_t index_id, int type,
+                             const char *key, const char *key_end,
+                             const char *packed_pos,
+                             const char *packed_pos_end);
     /** \cond public */
     ssize_t
     box_index_len(uint32_t space_id, uint32_t index_id);
@@ -103,11 +108,17 @@ ffi.cdef[[
     void
     port_destroy(struct port *port);
 
+    size_t
+    box_region_used(void);
+    void
+    box_region_truncate(size_t size);
+
     int
     box_select(uint32_t space_id, uint32_t index_id,
                int iterator, uint32_t offset, uint32_t limit,
                const char *key, const char *key_end,
-               struct port *port);
+               const char **packed_pos, const char **packed_pos_end,
+               bool update_pos, struct port *port);
 
     void password_prepare(const char *password, int len,
                           char *out, int out_len);
@@ -444,6 +455,7 @@ box.schema.space.create = function(name, options)
         temporary = 'boolean',
         is_sync = 'boolean',
         defer_deletes = 'boolean',
+        memory_quota = 'number',
     }
     local options_defaults = {
         engine = 'memtx',
@@ -495,6 +507,7 @@ box.schema.space.create = function(name, options)
         temporary = options.temporary and true or nil,
         is_sync = options.is_sync,
         defer_deletes = options.defer_deletes and true or nil,
+        memory_quota = options.memory_quota,
     })
     _space:insert{id, uid, name, options.engine, options.field_count,
         space_options, format}
@@ -588,6 +601,7 @@ local alter_space_template = {
     temporary = 'boolean',
     is_sync = 'boolean',
     defer_deletes = 'boolean',
+    memory_quota = 'number',
     name = 'string',
 }
 
@@ -628,6 +642,10 @@ box.schema.space.alter = function(space_id, options)
         flags.defer_deletes = options.defer_deletes
     end
 
+    if options.memory_quota ~= nil then
+        flags.memory_quota = options.memory_quota
+    end
+
     local format
     if options.format ~= nil then
         format = update_format(options.format)
@@ -1099,6 +1117,7 @@ local index_options = {
     bloom_fpr = 'number',
     func = 'number, string',
     hint = 'boolean',
+    fast_offset = 'boolean',
 }
 
 local function jsonpaths_from_idx_parts(parts)
@@ -1206,6 +1225,15 @@ box.schema.index.create = function(space_id, name, options)
         box.error(box.error.MODIFY_INDEX, name, space.name,
                 "functional index can't use hints")
     end
+    if options.fast_offset and
+            (options.type ~= 'tree' or box.space[space_id].engine ~= 'memtx') then
+        box.error(box.error.MODIFY_INDEX, name, space.name,
+                "fast_offset is only reasonable with memtx tree index")
+    end
+    if options.fast_offset and options.func then
+        box.error(box.error.MODIFY_INDEX, name, space.name,
+                "functional index can't use fast_offset")
+    end
 
     local _index = box.space[box.schema.INDEX_ID]
     local _vindex = box.space[box.schema.VINDEX_ID]
@@ -1246,6 +1274,7 @@ box.schema.index.create = function(space_id, name, options)
             bloom_fpr = options.bloom_fpr,
             func = options.func,
             hint = options.hint,
+            fast_offset = options.fast_offset,
     }
     local field_type_aliases = {
         num = 'unsigned'; -- Deprecated since 1.7.2
@@ -1270,6 +1299,10 @@ box.schema.index.create = function(space_id, name, options)
         box.error(box.error.MODIFY_INDEX, name, space.name,
                 "multikey index can't use hints")
     end
+    if options.fast_offset and is_multikey_index(parts) then
+        box.error(box.error.MODIFY_INDEX, name, space.name,
+                "multikey index can't use fast_offset")
+    end
     if index_opts.func ~= nil and type(index_opts.func) == 'string' then
         index_opts.func = func_id_by_name(index_opts.func)
     end
@@ -1403,6 +1436,17 @@ box.schema.index.alter = function(space_id, index_id, options)
                                           space.name,
                 "functional index can't use hints")
     end
+    if options.fast_offset and
+       (options.type ~= 'tree' or box.space[space_id].engine ~= 'memtx') then
+        box.error(box.error.MODIFY_INDEX, space.index[index_id].name,
+                                          space.name,
+            "fast_offset is only reasonable with memtx tree index")
+    end
+    if options.fast_offset and options.func then
+        box.error(box.error.MODIFY_INDEX, space.index[index_id].name,
+                                          space.name,
+                "functional index can't use fast_offset")
+    end
     if options.parts then
         local parts_can_be_simplified
         parts, parts_can_be_simplified =
@@ -1417,6 +1461,11 @@ box.schema.index.alter = function(space_id, index_id, options)
                                           space.name,
                 "multikey index can't use hints")
     end
+    if options.fast_offset and is_multikey_index(parts) then
+        box.error(box.error.MODIFY_INDEX, space.index[index_id].name,
+                                          space.name,
+                "multikey index can't use fast_offset")
+    end
     if index_opts.func ~= nil and type(index_opts.func) == 'string' then
         index_opts.func = func_id_by_name(index_opts.func)
     end
@@ -1899,6 +1948,18 @@ base_index_mt.random_luac = function(index, rnd)
     rnd = rnd or math.random()
     return internal.random(index.space_id, index.id, rnd);
 end
+-- Convert the 'after' option to a position string.
+local function iterator_pos(index, after)
+    if after == nil or type(after) == "string" then
+        return after
+    elseif type(after) == "table" or is_tuple(after) then
+        return internal.tuple_pos(index.space_id, index.id, after)
+    end
+    box.error(box.error.ILLEGAL_PARAMS,
+              "options parameter 'after' should be of type " ..
+              "string, table, tuple")
+end
+
 -- iteration
 base_index_mt.pairs_ffi = function(index, key, opts)
     check_index_arg(index, 'pairs')
@@ -1909,8 +1970,17 @@ base_index_mt.pairs_ffi = function(index, key, opts)
     local keybuf = ffi.string(pkey, pkey_end - pkey)
     cord_ibuf_put(ibuf)
     local pkeybuf = ffi.cast('const char *', keybuf)
-    local cdata = builtin.box_index_iterator(index.space_id, index.id,
-        itype, pkeybuf, pkeybuf + #keybuf);
+    local after = type(opts) == "table" and opts.after or nil
+    after = iterator_pos(index, after)
+    local cdata
+    if after == nil then
+        cdata = builtin.box_index_iterator(index.space_id, index.id,
+            itype, pkeybuf, pkeybuf + #keybuf);
+    else
+        local pafter = ffi.cast('const char *', after)
+        cdata = builtin.box_index_iterator_after(index.space_id, index.id,
+            itype, pkeybuf, pkeybuf + #keybuf, pafter, pafter + #after);
+    end
     if cdata == nil then
         box.error()
     end
@@ -1923,7 +1993,10 @@ base_index_mt.pairs_luac = function(index, key, opts)
     local itype = check_iterator_type(opts, #key == 0);
     local keymp = msgpack.encode(key)
     local keybuf = ffi.string(keymp, #keymp)
-    local cdata = internal.iterator(index.space_id, index.id, itype, keymp);
+    local after = type(opts) == "table" and opts.after or nil
+    after = iterator_pos(index, after)
+    local cdata = internal.iterator(index.space_id, index.id, itype, keymp,
+                                    after);
     return fun.wrap(iterator_gen_luac, keybuf,
         ffi.gc(cdata, builtin.box_iterator_free))
 end
@@ -1970,9 +2043,24 @@ base_index_mt.get_luac = function(index, key)
     return internal.get(index.space_id, index.id, key)
 end
 
+base_index_mt.get_many = function(index, keys)
+    check_index_arg(index, 'get_many')
+    if type(keys) ~= 'table' then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "Usage: index:get_many({key1, key2, ...})")
+    end
+    local packed_keys = {}
+    for i, key in ipairs(keys) do
+        packed_keys[i] = keify(key)
+    end
+    return internal.get_many(index.space_id, index.id, packed_keys)
+end
+
 local function check_select_opts(opts, key_is_nil)
     local offset = 0
     local limit = 4294967295
+    local after = nil
+    local fetch_pos = false
     local iterator = check_iterator_type(opts, key_is_nil)
     if opts ~= nil and type(opts) == "table" then
         if opts.offset ~= nil then
@@ -1981,8 +2069,25 @@ local function check_select_opts(opts, key_is_nil)
         if opts.limit ~= nil then
             limit = opts.limit
         end
+        if opts.after ~= nil then
+            after = opts.after
+            if type(after) ~= "string" and type(after) ~= "table" and
+               not is_tuple(after) then
+                box.error(box.error.ILLEGAL_PARAMS,
+                          "options parameter 'after' should be of type " ..
+                          "string, table, tuple")
+            end
+        end
+        if opts.fetch_pos ~= nil then
+            if type(opts.fetch_pos) ~= "boolean" then
+                box.error(box.error.ILLEGAL_PARAMS,
+                          "options parameter 'fetch_pos' should be of " ..
+                          "type boolean")
+            end
+            fetch_pos = opts.fetch_pos
+        end
     end
-    return iterator, offset, limit
+    return iterator, offset, limit, after, fetch_pos
 end
 
 box.internal.check_select_opts = check_select_opts -- for net.box
@@ -1991,13 +2096,27 @@ base_index_mt.select_ffi = function(index, key, opts)
     check_index_arg(index, 'select')
     local ibuf = cord_ibuf_take()
     local key, key_end = tuple_encode(ibuf, key)
-    local iterator, offset, limit = check_select_opts(opts, key + 1 >= key_end)
+    local iterator, offset, limit, after, fetch_pos =
+        check_select_opts(opts, key + 1 >= key_end)
+    local pos, pos_end = nil, nil
+    if after ~= nil or fetch_pos then
+        after = iterator_pos(index, after)
+        pos = ffi.new('const char *[1]')
+        pos_end = ffi.new('const char *[1]')
+        if after ~= nil then
+            pos[0] = after
+            pos_end[0] = pos[0] + #after
+        end
+    end
 
     local port = ffi.cast('struct port *', port_c)
+    local region_svp = builtin.box_region_used()
     local nok = builtin.box_select(index.space_id, index.id, iterator, offset,
-                                   limit, key, key_end, port) ~= 0
+                                   limit, key, key_end, pos, pos_end,
+                                   fetch_pos, port) ~= 0
     cord_ibuf_put(ibuf)
     if nok then
+        builtin.box_region_truncate(region_svp)
         return box.error()
     end
 
@@ -2008,15 +2127,30 @@ base_index_mt.select_ffi = function(index, key, opts)
         entry = entry.next
     end
     builtin.port_destroy(port);
-    return ret
+    if not fetch_pos then
+        return ret
+    end
+    local new_after = nil
+    if pos[0] ~= nil then
+        new_after = ffi.string(pos[0], pos_end[0] - pos[0])
+    end
+    builtin.box_region_truncate(region_svp)
+    return ret, new_after
 end
 
 base_index_mt.select_luac = function(index, key, opts)
     check_index_arg(index, 'select')
     local key = keify(key)
-    local iterator, offset, limit = check_select_opts(opts, #key == 0)
+    local iterator, offset, limit, after, fetch_pos =
+        check_select_opts(opts, #key == 0)
+    after = iterator_pos(index, after)
     return internal.select(index.space_id, index.id, iterator,
-        offset, limit, key)
+        offset, limit, key, after, fetch_pos)
+end
+
+base_index_mt.tuple_pos = function(index, tuple)
+    check_index_arg(index, 'tuple_pos')
+    return internal.tuple_pos(index.space_id, index.id, tuple)
 end
 
 base_index_mt.update = function(index, key, ops)
@@ -2093,6 +2227,10 @@ space_mt.get = function(space, key)
     check_space_arg(space, 'get')
     return check_primary_index(space):get(key)
 end
+space_mt.get_many = function(space, keys)
+    check_space_arg(space, 'get_many')
+    return check_primary_index(space):get_many(keys)
+end
 space_mt.select = function(space, key, opts)
     check_space_arg(space, 'select')
     return check_primary_index(space):select(key, opts)
@@ -2207,6 +2345,93 @@ space_mt.run_triggers = function(space, yesno)
     builtin.space_run_triggers(s, yesno)
 end
 space_mt.frommap = box.internal.space.frommap
+space_mt.stat = function(space)
+    check_space_arg(space, 'stat')
+    check_space_exists(space)
+    return box.internal.space.stat(space.id)
+end
+
+local read_view_scan_ops = {
+    ['=='] = true, ['~='] = true,
+    ['<'] = true, ['<='] = true, ['>'] = true, ['>='] = true,
+}
+local read_view_scan_funcs = {count = true, sum = true, min = true, max = true}
+
+-- Convert a field name or number to a field number.
+local function read_view_scan_fieldno(space, field, what)
+    if type(field) == 'number' and field >= 1 and field % 1 == 0 then
+        return field
+    end
+    if type(field) == 'string' then
+        for i, f in ipairs(space:format()) do
+            if f.name == field then
+                return i
+            end
+        end
+        box.error(box.error.ILLEGAL_PARAMS,
+                  what .. ": unknown field '" .. field .. "'")
+    end
+    box.error(box.error.ILLEGAL_PARAMS,
+              what .. " should be a field name or number")
+end
+
+space_mt.read_view_scan = function(space, opts)
+    check_space_arg(space, 'read_view_scan')
+    check_space_exists(space)
+    check_param_table(opts, {filter = 'table', fields = 'table',
+                             aggregate = 'table', limit = 'number'})
+    opts = opts or {}
+    local filters = {}
+    for i, filter in ipairs(opts.filter or {}) do
+        local what = 'filter[' .. i .. ']'
+        if type(filter) ~= 'table' or #filter ~= 3 then
+            box.error(box.error.ILLEGAL_PARAMS,
+                      what .. " should be a table {field, op, value}")
+        end
+        if not read_view_scan_ops[filter[2]] then
+            box.error(box.error.ILLEGAL_PARAMS,
+                      what .. ": unknown operator '" ..
+                      tostring(filter[2]) .. "'")
+        end
+        filters[i] = {read_view_scan_fieldno(space, filter[1], what),
+                      filter[2], filter[3]}
+    end
+    local fields = {}
+    for i, field in ipairs(opts.fields or {}) do
+        fields[i] = read_view_scan_fieldno(space, field,
+                                           'fields[' .. i .. ']')
+    end
+    local aggregates = {}
+    for i, aggregate in ipairs(opts.aggregate or {}) do
+        local what = 'aggregate[' .. i .. ']'
+        if type(aggregate) ~= 'table' or
+           not read_view_scan_funcs[aggregate[1]] then
+            box.error(box.error.ILLEGAL_PARAMS,
+                      what .. " should be a table {func, field}" ..
+                      " with func 'count', 'sum', 'min' or 'max'")
+        end
+        if aggregate[2] ~= nil then
+            aggregates[i] = {aggregate[1], read_view_scan_fieldno(
+                                 space, aggregate[2], what)}
+        elseif aggregate[1] == 'count' then
+            aggregates[i] = {aggregate[1]}
+        else
+            box.error(box.error.ILLEGAL_PARAMS,
+                      what .. ": field is required for '" ..
+                      aggregate[1] .. "'")
+        end
+    end
+    if #fields > 0 and #aggregates > 0 then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "fields and aggregate can't be used together")
+    end
+    if opts.limit ~= nil and opts.limit < 0 then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "options parameter 'limit' should be non-negative")
+    end
+    return box.internal.space.read_view_scan(space.id, filters, fields,
+                                             aggregates, opts.limit)
+end
 space_mt.__index = space_mt
 
 local ck_constraint_mt = {}
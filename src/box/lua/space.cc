@@ -35,6 +35,7 @@
 #include "box/sql/sqlLimit.h"
 #include "lua/utils.h"
 #include "lua/trigger.h"
+#include "lua/info.h"
 #include "box/box.h"
 
 extern "C" {
@@ -54,7 +55,10 @@ extern "C" {
 #include "box/coll_id_cache.h"
 #include "box/replication.h" /* GROUP_LOCAL */
 #include "box/iproto_constants.h" /* iproto_type_name */
+#include "box/read_view_scan.h"
 #include "vclock/vclock.h"
+#include "lua/msgpack.h"
+#include "mpstream/mpstream.h"
 
 /**
  * Trigger function for all spaces
@@ -376,6 +380,14 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 			lua_pushnil(L);
 			lua_setfield(L, -2, "hint");
 		}
+		if (space_is_memtx(space) && index_def->type == TREE &&
+		    index_opts->fast_offset) {
+			lua_pushboolean(L, true);
+			lua_setfield(L, -2, "fast_offset");
+		} else {
+			lua_pushnil(L);
+			lua_setfield(L, -2, "fast_offset");
+		}
 
 		if (index_opts->func_id > 0) {
 			lua_pushstring(L, "func");
@@ -633,6 +645,143 @@ usage_error:
 	return luaL_error(L, "Usage: space:frommap(map, opts)");
 }
 
+/**
+ * Report space statistics.
+ * @param Lua space id.
+ * @retval Lua table with statistics.
+ */
+static int
+lbox_space_stat(struct lua_State *L)
+{
+	if (lua_gettop(L) != 1 || !lua_isnumber(L, 1))
+		return luaL_error(L, "usage space.stat(space_id)");
+	uint32_t space_id = lua_tonumber(L, 1);
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return luaT_error(L);
+	struct info_handler info;
+	luaT_info_handler_create(&info, L);
+	space_stat(space, &info);
+	return 1;
+}
+
+/**
+ * Scan a read view of a space in a worker thread.
+ * @param Lua space id.
+ * @param Lua array of filters {fieldno, op, value}.
+ * @param Lua array of field numbers to return.
+ * @param Lua array of aggregates {func, fieldno}.
+ * @param Lua max number of rows to return or nil.
+ * @retval Lua array of result rows.
+ */
+static int
+lbox_space_read_view_scan(struct lua_State *L)
+{
+	if (lua_gettop(L) < 4 || !lua_isnumber(L, 1) || !lua_istable(L, 2) ||
+	    !lua_istable(L, 3) || !lua_istable(L, 4))
+		return luaL_error(L, "usage space.read_view_scan(space_id, "
+				  "filters, fields, aggregates[, limit])");
+	uint32_t space_id = lua_tonumber(L, 1);
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return luaT_error(L);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	struct read_view_scan_def def;
+	memset(&def, 0, sizeof(def));
+	def.limit = UINT64_MAX;
+	if (!lua_isnoneornil(L, 5) && lua_tonumber(L, 5) < (double)UINT64_MAX)
+		def.limit = lua_tonumber(L, 5);
+	def.filter_count = lua_objlen(L, 2);
+	def.field_count = lua_objlen(L, 3);
+	def.aggregate_count = lua_objlen(L, 4);
+	size_t size;
+	struct read_view_scan_filter *filters =
+		region_alloc_array(region, typeof(*filters),
+				   def.filter_count, &size);
+	uint32_t *fields = region_alloc_array(region, typeof(*fields),
+					      def.field_count, &size);
+	struct read_view_scan_aggregate *aggregates =
+		region_alloc_array(region, typeof(*aggregates),
+				   def.aggregate_count, &size);
+	if ((filters == NULL && def.filter_count > 0) ||
+	    (fields == NULL && def.field_count > 0) ||
+	    (aggregates == NULL && def.aggregate_count > 0)) {
+		diag_set(OutOfMemory, size, "region_alloc_array", "def");
+		return luaT_error(L);
+	}
+	for (uint32_t i = 0; i < def.filter_count; i++) {
+		lua_rawgeti(L, 2, i + 1);
+		lua_rawgeti(L, -1, 1);
+		filters[i].fieldno = lua_tointeger(L, -1) - TUPLE_INDEX_BASE;
+		lua_rawgeti(L, -2, 2);
+		filters[i].op = STR2ENUM(read_view_scan_op,
+					 lua_tostring(L, -1));
+		if (filters[i].op == read_view_scan_op_MAX)
+			return luaL_error(L, "unknown filter operator");
+		lua_rawgeti(L, -3, 3);
+		struct mpstream stream;
+		mpstream_init(&stream, region, region_reserve_cb,
+			      region_alloc_cb, luamp_error, L);
+		size_t used = region_used(region);
+		luamp_encode(L, luaL_msgpack_default, &stream, -1);
+		mpstream_flush(&stream);
+		size = region_used(region) - used;
+		filters[i].value = (const char *)region_join(region, size);
+		if (filters[i].value == NULL) {
+			diag_set(OutOfMemory, size, "region_join", "value");
+			return luaT_error(L);
+		}
+		lua_pop(L, 4);
+	}
+	def.filters = filters;
+	for (uint32_t i = 0; i < def.field_count; i++) {
+		lua_rawgeti(L, 3, i + 1);
+		fields[i] = lua_tointeger(L, -1) - TUPLE_INDEX_BASE;
+		lua_pop(L, 1);
+	}
+	def.fields = fields;
+	for (uint32_t i = 0; i < def.aggregate_count; i++) {
+		lua_rawgeti(L, 4, i + 1);
+		lua_rawgeti(L, -1, 1);
+		aggregates[i].func = STR2ENUM(read_view_scan_func,
+					      lua_tostring(L, -1));
+		if (aggregates[i].func == read_view_scan_func_MAX)
+			return luaL_error(L, "unknown aggregate function");
+		lua_rawgeti(L, -2, 2);
+		aggregates[i].fieldno = lua_isnil(L, -1) ?
+			READ_VIEW_SCAN_ALL_FIELDS :
+			lua_tointeger(L, -1) - TUPLE_INDEX_BASE;
+		lua_pop(L, 3);
+	}
+	def.aggregates = aggregates;
+	struct read_view_scan *scan = read_view_scan_new(space, &def);
+	region_truncate(region, region_svp);
+	if (scan == NULL)
+		return luaT_error(L);
+	lua_newtable(L);
+	for (int i = 1;; i++) {
+		const char *row;
+		if (read_view_scan_next(scan, &row) != 0)
+			goto error;
+		if (row == NULL)
+			break;
+		const char *row_end = row;
+		mp_next(&row_end);
+		struct tuple *tuple = tuple_new(box_tuple_format_default(),
+						row, row_end);
+		if (tuple == NULL)
+			goto error;
+		luaT_pushtuple(L, tuple);
+		lua_rawseti(L, -2, i);
+	}
+	read_view_scan_delete(scan);
+	return 1;
+error:
+	read_view_scan_delete(scan);
+	return luaT_error(L);
+}
+
 void
 box_lua_space_init(struct lua_State *L)
 {
@@ -694,6 +843,8 @@ box_lua_space_init(struct lua_State *L)
 	lua_setfield(L, -2, "FUNC_INDEX_ID");
 	lua_pushnumber(L, BOX_SESSION_SETTINGS_ID);
 	lua_setfield(L, -2, "SESSION_SETTINGS_ID");
+	lua_pushnumber(L, BOX_SQL_STAT_ID);
+	lua_setfield(L, -2, "SQL_STAT_ID");
 	lua_pushnumber(L, BOX_SYSTEM_ID_MIN);
 	lua_setfield(L, -2, "SYSTEM_ID_MIN");
 	lua_pushnumber(L, BOX_SYSTEM_ID_MAX);
@@ -732,6 +883,8 @@ box_lua_space_init(struct lua_State *L)
 
 	static const struct luaL_Reg space_internal_lib[] = {
 		{"frommap", lbox_space_frommap},
+		{"stat", lbox_space_stat},
+		{"read_view_scan", lbox_space_read_view_scan},
 		{NULL, NULL}
 	};
 	luaL_register(L, "box.internal.space", space_internal_lib);
@@ -0,0 +1,155 @@
+-- sql_stat.lua (internal file)
+--
+-- Collects statistics of indexes used by the SQL query planner
+-- in the background and stores them in the _sql_stat space, see
+-- box/sql_stat.h.
+--
+local log = require('log')
+local fiber = require('fiber')
+
+local internal = box.internal
+
+local PREFIX = 'sql_stat'
+-- How often to look for stale statistics, in seconds.
+local CHECK_INTERVAL = 1
+
+local daemon = {
+    -- Set once box is configured.
+    is_initialized = false,
+    fiber = nil,
+    -- The _sql_stat space the on_replace trigger is set for.
+    space = nil,
+    -- Set once the missing _sql_stat space is reported.
+    is_space_missing_logged = false,
+}
+
+local function load_stat(tuple)
+    local ok, err = pcall(internal.sql_stat_load, tuple)
+    if not ok then
+        log.warn('%s: failed to load statistics of index %d of space %d: %s',
+                 PREFIX, tuple[2], tuple[1], err)
+    end
+end
+
+local function on_replace(_, new)
+    if new ~= nil then
+        load_stat(new)
+    end
+end
+
+-- Load the statistics stored in the _sql_stat space and keep them
+-- up to date with it, since it may be changed by replication.
+local function watch(space)
+    if daemon.space ~= space then
+        space:on_replace(on_replace)
+        daemon.space = space
+        for _, tuple in space:pairs() do
+            load_stat(tuple)
+        end
+    end
+end
+
+-- Return the _sql_stat space or nil if the schema is too old to
+-- have it. The space may appear later on box.schema.upgrade() or
+-- from a replica set peer.
+local function stat_space()
+    local space = box.space[box.schema.SQL_STAT_ID]
+    if space ~= nil then
+        watch(space)
+    end
+    return space
+end
+
+-- Delete statistics of dropped indexes.
+local function delete_orphans(space)
+    local keys = {}
+    for _, tuple in space:pairs() do
+        local s = box.space[tuple[1]]
+        if s == nil or s.index[tuple[2]] == nil then
+            table.insert(keys, {tuple[1], tuple[2]})
+        end
+    end
+    for _, key in ipairs(keys) do
+        space:delete(key)
+    end
+end
+
+local function refresh()
+    local space = stat_space()
+    local stale = internal.sql_stat_stale()
+    if space == nil and #stale > 0 and
+       not daemon.is_space_missing_logged then
+        log.warn('%s: the _sql_stat space is missing, statistics are ' ..
+                 'not persisted until box.schema.upgrade() is called',
+                 PREFIX)
+        daemon.is_space_missing_logged = true
+    end
+    local can_store = space ~= nil and not box.info.ro
+    if can_store then
+        delete_orphans(space)
+    end
+    for _, index in ipairs(stale) do
+        local space_id, index_id = index[1], index[2]
+        -- The statistics are installed for the planner even if
+        -- they can't be stored.
+        local ok, tuple = pcall(internal.sql_stat_collect, space_id, index_id)
+        if not ok then
+            log.verbose('%s: failed to collect statistics of index %d of ' ..
+                        'space %d: %s', PREFIX, index_id, space_id, tuple)
+        elseif can_store and not box.info.ro then
+            space:replace(tuple)
+        end
+    end
+end
+
+local function daemon_loop()
+    fiber.name(PREFIX, {truncate = true})
+    while true do
+        if not pcall(fiber.sleep, CHECK_INTERVAL) then
+            -- The fiber was cancelled.
+            break
+        end
+        local ok, err = pcall(refresh)
+        if not ok then
+            log.warn('%s: %s', PREFIX, err)
+        end
+    end
+end
+
+local function start(self)
+    self:stop()
+    if self.is_initialized and box.cfg.sql_stat_refresh_ratio > 0 then
+        self.fiber = fiber.new(daemon_loop)
+    end
+end
+
+local function stop(self)
+    if self.fiber ~= nil and self.fiber:status() ~= 'dead' then
+        self.fiber:cancel()
+    end
+    self.fiber = nil
+end
+
+-- Load the statistics stored in the _sql_stat space and start
+-- refreshing them. Called once box is configured.
+local function init(self)
+    stat_space()
+    self.is_initialized = true
+    start(self)
+end
+
+setmetatable(daemon, {
+    __index = {
+        init = function()
+            init(daemon)
+        end,
+        start = function()
+            start(daemon)
+        end,
+        stop = function()
+            stop(daemon)
+        end,
+    }
+})
+
+internal.sql_stat_daemon = daemon
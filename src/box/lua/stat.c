@@ -31,6 +31,7 @@
  */
 #include "stat.h"
 
+#include <math.h>
 #include <string.h>
 #include <rmean.h>
 
@@ -43,6 +44,7 @@
 #include "box/engine.h"
 #include "box/vinyl.h"
 #include "box/sql.h"
+#include "box/wal.h"
 #include "info/info.h"
 #include "lua/info.h"
 #include "lua/utils.h"
@@ -279,6 +281,134 @@ lbox_stat_sql(struct lua_State *L)
 	return 1;
 }
 
+static int
+lbox_stat_wal(struct lua_State *L)
+{
+	struct info_handler info;
+	luaT_info_handler_create(&info, L);
+	wal_stat_info(&info);
+	return 1;
+}
+
+enum {
+	/** Max number of percentiles box.stat.latency() reports. */
+	LATENCY_PERCENTILE_MAX = 16,
+};
+
+/** Convert a latency histogram value to seconds. */
+static double
+latency_to_sec(uint64_t usec)
+{
+	return (double)usec / 1e6;
+}
+
+/**
+ * Push a table with statistics of a latency histogram: count,
+ * sum, max, the given percentiles and, optionally, non-empty
+ * buckets with their upper bounds.
+ */
+static void
+lbox_stat_latency_push_hist(struct lua_State *L,
+			    const struct hdr_histogram *hist,
+			    const double *pct, int pct_count, bool buckets)
+{
+	lua_newtable(L);
+	lua_pushnumber(L, hist->count);
+	lua_setfield(L, -2, "count");
+	lua_pushnumber(L, latency_to_sec(hist->sum));
+	lua_setfield(L, -2, "sum");
+	lua_pushnumber(L, latency_to_sec(hist->max));
+	lua_setfield(L, -2, "max");
+	for (int i = 0; i < pct_count; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "p%g", pct[i]);
+		uint64_t value = hdr_histogram_percentile(hist, pct[i]);
+		lua_pushnumber(L, latency_to_sec(value));
+		lua_setfield(L, -2, name);
+	}
+	if (!buckets)
+		return;
+	lua_newtable(L);
+	int n = 0;
+	for (int i = 0; i < HDR_HISTOGRAM_BUCKET_COUNT; i++) {
+		if (hist->buckets[i] == 0)
+			continue;
+		lua_newtable(L);
+		/*
+		 * Values are truncated to microseconds, so all values
+		 * accounted in a bucket are less than its max + 1.
+		 */
+		if (i == HDR_HISTOGRAM_BUCKET_COUNT - 1)
+			lua_pushnumber(L, HUGE_VAL);
+		else
+			lua_pushnumber(L, latency_to_sec(
+				hdr_histogram_bucket_max(i) + 1));
+		lua_setfield(L, -2, "le");
+		lua_pushnumber(L, hist->buckets[i]);
+		lua_setfield(L, -2, "count");
+		lua_rawseti(L, -2, ++n);
+	}
+	lua_setfield(L, -2, "buckets");
+}
+
+/**
+ * box.stat.latency([{percentiles = {...}, buckets = <boolean>}])
+ * Return iproto request latency statistics per request type and
+ * processing stage.
+ */
+static int
+lbox_stat_latency(struct lua_State *L)
+{
+	double pct[LATENCY_PERCENTILE_MAX] = {50, 90, 99, 99.9};
+	int pct_count = 4;
+	bool buckets = false;
+	if (!lua_isnoneornil(L, 1)) {
+		if (!lua_istable(L, 1))
+			return luaL_error(L, "Usage: box.stat.latency([opts])");
+		lua_getfield(L, 1, "buckets");
+		buckets = lua_toboolean(L, -1);
+		lua_pop(L, 1);
+		lua_getfield(L, 1, "percentiles");
+		if (!lua_isnil(L, -1)) {
+			if (!lua_istable(L, -1) ||
+			    lua_objlen(L, -1) > LATENCY_PERCENTILE_MAX) {
+				return luaL_error(L, "percentiles must be an "
+						  "array of at most %d numbers",
+						  LATENCY_PERCENTILE_MAX);
+			}
+			pct_count = lua_objlen(L, -1);
+			for (int i = 0; i < pct_count; i++) {
+				lua_rawgeti(L, -1, i + 1);
+				pct[i] = lua_tonumber(L, -1);
+				lua_pop(L, 1);
+				if (pct[i] <= 0 || pct[i] > 100) {
+					return luaL_error(L, "percentile must "
+							  "be in (0, 100]");
+				}
+			}
+		}
+		lua_pop(L, 1);
+	}
+	struct iproto_latency_stat *stat =
+		(struct iproto_latency_stat *)xmalloc(sizeof(*stat));
+	iproto_latency_stat_get(stat);
+	lua_newtable(L);
+	for (int type = 0; type < IPROTO_TYPE_STAT_MAX; type++) {
+		if (stat->hist[type][IPROTO_LATENCY_QUEUE].count == 0)
+			continue;
+		lua_newtable(L);
+		for (int stage = 0; stage < IPROTO_LATENCY_STAGE_MAX;
+		     stage++) {
+			lbox_stat_latency_push_hist(L, &stat->hist[type][stage],
+						    pct, pct_count, buckets);
+			lua_setfield(L, -2, iproto_latency_stage_strs[stage]);
+		}
+		lua_setfield(L, -2, iproto_type_name(type));
+	}
+	free(stat);
+	return 1;
+}
+
 static const struct luaL_Reg lbox_stat_meta [] = {
 	{"__index", lbox_stat_index},
 	{"__call",  lbox_stat_call},
@@ -305,6 +435,8 @@ box_lua_stat_init(struct lua_State *L)
 		{"vinyl", lbox_stat_vinyl},
 		{"reset", lbox_stat_reset},
 		{"sql", lbox_stat_sql},
+		{"wal", lbox_stat_wal},
+		{"latency", lbox_stat_latency},
 		{NULL, NULL}
 	};
 
@@ -1225,6 +1225,27 @@ end
 local function upgrade_to_2_10_1()
     grant_rw_access_on__session_settings_to_role_public()
 end
+
+--------------------------------------------------------------------------------
+-- Tarantool 2.11.0
+--------------------------------------------------------------------------------
+local function create_sql_stat_space()
+    local _space = box.space[box.schema.SPACE_ID]
+    local _index = box.space[box.schema.INDEX_ID]
+    local format = {{name='space_id', type='unsigned'},
+                    {name='index_id', type='unsigned'},
+                    {name='stat', type='map'}}
+    log.info("create space _sql_stat")
+    _space:insert{box.schema.SQL_STAT_ID, ADMIN, '_sql_stat', 'memtx', 0,
+                  setmap({}), format}
+    log.info("create index _sql_stat:primary")
+    _index:insert{box.schema.SQL_STAT_ID, 0, 'primary', 'tree',
+                  {unique = true}, {{0, 'unsigned'}, {1, 'unsigned'}}}
+end
+
+local function upgrade_to_2_11_0()
+    create_sql_stat_space()
+end
 --------------------------------------------------------------------------------
 
 local handlers = {
@@ -1243,6 +1264,7 @@ local handlers = {
     {version = mkversion(2, 7, 1), func = upgrade_to_2_7_1, auto = true},
     {version = mkversion(2, 9, 1), func = upgrade_to_2_9_1, auto = true},
     {version = mkversion(2, 10, 1), func = upgrade_to_2_10_1, auto = true},
+    {version = mkversion(2, 11, 0), func = upgrade_to_2_11_0, auto = true},
 }
 
 -- Schema version of the snapshot.
@@ -512,6 +512,7 @@ get_memtx_bitset_index_vtab(void)
 		/* .get_raw = */ generic_index_get_raw,
 		/* .get = */ UNCHANGED ? generic_index_get_raw :
 			     generic_index_get,
+		/* .get_many = */ generic_index_get_many,
 		/* .replace = */ memtx_bitset_index_replace,
 		/* .create_iterator = */
 			memtx_bitset_index_create_iterator<UNCHANGED>,
@@ -34,6 +34,7 @@
 #include <small/quota.h>
 #include <small/small.h>
 #include <small/mempool.h>
+#include <pmatomic.h>
 
 #include "fiber.h"
 #include "errinj.h"
@@ -45,6 +46,7 @@
 #include "iproto_constants.h"
 #include "xrow.h"
 #include "xstream.h"
+#include "xlog_reader.h"
 #include "bootstrap.h"
 #include "replication.h"
 #include "schema.h"
@@ -134,10 +136,11 @@ memtx_end_build_primary_key(struct space *space, void *param)
 }
 
 /**
- * Build memtx secondary index based on the contents of primary index.
+ * Fill memtx secondary index with the contents of primary index.
+ * The index must be finalized with index_end_build() afterwards.
  */
 static int
-memtx_build_secondary_index(struct index *index, struct index *pk)
+memtx_fill_secondary_index(struct index *index, struct index *pk)
 {
 	ssize_t n_tuples = index_size(pk);
 	if (n_tuples < 0)
@@ -171,9 +174,17 @@ memtx_build_secondary_index(struct index *index, struct index *pk)
 			break;
 	}
 	iterator_delete(it);
-	if (rc != 0)
-		return -1;
+	return rc;
+}
 
+/**
+ * Build memtx secondary index based on the contents of primary index.
+ */
+static int
+memtx_build_secondary_index(struct index *index, struct index *pk)
+{
+	if (memtx_fill_secondary_index(index, pk) != 0)
+		return -1;
 	index_end_build(index);
 	return 0;
 }
@@ -216,6 +227,205 @@ memtx_build_secondary_keys(struct space *space, void *param)
 	return 0;
 }
 
+/**
+ * State shared by threads sorting secondary keys in parallel,
+ * see memtx_engine_build_secondary_keys().
+ */
+struct memtx_sort_pool {
+	/** Tree indexes whose build arrays need to be sorted. */
+	struct index **indexes;
+	/** Number of entries in the indexes array. */
+	int index_count;
+	/** Position of the next index to sort, updated atomically. */
+	int next;
+};
+
+/**
+ * Sort build arrays of indexes taken from the pool one by one
+ * until there is nothing left to sort. Run by the tx thread and
+ * all sort threads simultaneously.
+ */
+static void
+memtx_sort_pool_run(struct memtx_sort_pool *pool)
+{
+	int i;
+	while ((i = pm_atomic_fetch_add(&pool->next, 1)) < pool->index_count)
+		memtx_tree_index_sort_build_array(pool->indexes[i]);
+}
+
+static int
+memtx_sort_thread_f(va_list ap)
+{
+	struct memtx_sort_pool *pool = va_arg(ap, struct memtx_sort_pool *);
+	memtx_sort_pool_run(pool);
+	return 0;
+}
+
+/**
+ * Sort build arrays of the given indexes using up to
+ * @a thread_count threads, one of which is the caller's.
+ * Failure to start a thread isn't fatal - the rest of the
+ * threads pick up its share of work.
+ */
+static void
+memtx_sort_build_arrays(struct index **indexes, int index_count,
+			int thread_count)
+{
+	struct memtx_sort_pool pool;
+	pool.indexes = indexes;
+	pool.index_count = index_count;
+	pool.next = 0;
+
+	thread_count = MIN(thread_count, index_count) - 1;
+	struct cord *cords = NULL;
+	if (thread_count > 0) {
+		cords = (struct cord *)calloc(thread_count, sizeof(*cords));
+		if (cords == NULL)
+			thread_count = 0;
+	}
+	int started = 0;
+	for (; started < thread_count; started++) {
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "memtx.sort.%d", started);
+		if (cord_costart(&cords[started], name,
+				 memtx_sort_thread_f, &pool) != 0) {
+			diag_log();
+			break;
+		}
+	}
+	memtx_sort_pool_run(&pool);
+	for (int i = 0; i < started; i++) {
+		if (cord_cojoin(&cords[i]) != 0)
+			diag_log();
+	}
+	free(cords);
+}
+
+/** Context of memtx_engine_build_secondary_keys(). */
+struct memtx_build_ctx {
+	struct memtx_engine *memtx;
+	/** Number of threads sorting build arrays. */
+	int thread_count;
+	/** Filled tree indexes which build arrays need sorting. */
+	struct index **indexes;
+	/** Number of entries in the indexes array. */
+	int index_count;
+	/** Total number of tree indexes sorted in parallel. */
+	int sorted_count;
+};
+
+/**
+ * Returns true if secondary keys of @a space have to be built
+ * by the memtx @a engine.
+ */
+static bool
+memtx_space_needs_build(struct space *space, struct engine *engine)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	return space->engine == engine && space_index(space, 0) != NULL &&
+	       memtx_space->replace != memtx_space_replace_all_keys;
+}
+
+/**
+ * Sort build arrays of the filled tree indexes in parallel and
+ * build the trees, freeing the arrays.
+ */
+static void
+memtx_build_filled_indexes(struct memtx_build_ctx *ctx)
+{
+	memtx_sort_build_arrays(ctx->indexes, ctx->index_count,
+				ctx->thread_count);
+	for (int i = 0; i < ctx->index_count; i++)
+		index_end_build(ctx->indexes[i]);
+	ctx->sorted_count += ctx->index_count;
+	ctx->index_count = 0;
+}
+
+static int
+memtx_fill_secondary_keys(struct space *space, void *param)
+{
+	struct memtx_build_ctx *ctx = (struct memtx_build_ctx *)param;
+	if (!memtx_space_needs_build(space, &ctx->memtx->base))
+		return 0;
+	struct index *pk = space->index[0];
+	if (space->index_count > 1 && index_size(pk) > 0) {
+		say_info("Filling secondary indexes in space '%s'...",
+			 space_name(space));
+	}
+	for (uint32_t j = 1; j < space->index_count; j++) {
+		struct index *index = space->index[j];
+		if (memtx_fill_secondary_index(index, pk) != 0)
+			return -1;
+		if (index->def->type != TREE) {
+			index_end_build(index);
+			continue;
+		}
+		ctx->indexes[ctx->index_count++] = index;
+		if (ctx->index_count == ctx->thread_count)
+			memtx_build_filled_indexes(ctx);
+	}
+	return 0;
+}
+
+static int
+memtx_end_build_secondary_keys(struct space *space, void *param)
+{
+	struct memtx_build_ctx *ctx = (struct memtx_build_ctx *)param;
+	if (!memtx_space_needs_build(space, &ctx->memtx->base))
+		return 0;
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	memtx_space->replace = memtx_space_replace_all_keys;
+	return 0;
+}
+
+/**
+ * Build secondary keys of all memtx spaces that haven't been
+ * fully built yet.
+ *
+ * With box.cfg.memtx_build_threads > 1 tree indexes are filled
+ * in batches of memtx_build_threads. Build arrays of a batch are
+ * sorted in parallel, which is the most CPU intensive part of the
+ * build, and then trees are constructed from the sorted arrays in
+ * the tx thread, freeing the arrays, before the next batch is
+ * filled. So at most memtx_build_threads build arrays are kept in
+ * memory at the same time.
+ */
+static int
+memtx_engine_build_secondary_keys(struct memtx_engine *memtx)
+{
+	if (memtx->build_threads <= 1)
+		return space_foreach(memtx_build_secondary_keys, memtx);
+
+	struct memtx_build_ctx ctx;
+	ctx.memtx = memtx;
+	ctx.thread_count = memtx->build_threads;
+	ctx.index_count = 0;
+	ctx.sorted_count = 0;
+	size_t size = ctx.thread_count * sizeof(ctx.indexes[0]);
+	ctx.indexes = (struct index **)malloc(size);
+	if (ctx.indexes == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "indexes");
+		return -1;
+	}
+	int rc = space_foreach(memtx_fill_secondary_keys, &ctx);
+	/*
+	 * Build the filled indexes even on error, so that none of
+	 * them is left with a build array.
+	 */
+	if (ctx.index_count > 0)
+		memtx_build_filled_indexes(&ctx);
+	free(ctx.indexes);
+	if (rc != 0)
+		return -1;
+	if (space_foreach(memtx_end_build_secondary_keys, &ctx) != 0)
+		return -1;
+	if (ctx.sorted_count > 0) {
+		say_info("Built %d secondary tree indexes using %d threads",
+			 ctx.sorted_count, ctx.thread_count);
+	}
+	return 0;
+}
+
 static void
 memtx_engine_shutdown(struct engine *engine)
 {
@@ -243,7 +453,9 @@ memtx_engine_shutdown(struct engine *engine)
 
 static int
 memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
-				  struct xrow_header *row, int *is_space_system);
+				  struct xrow_header *row,
+				  struct request *request,
+				  int *is_space_system);
 
 int
 memtx_engine_recover_snapshot(struct memtx_engine *memtx,
@@ -256,38 +468,56 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 						    signature, NONE);
 
 	say_info("recovering from `%s'", filename);
-	struct xlog_cursor cursor;
-	if (xlog_cursor_open(&cursor, filename) < 0)
+	/*
+	 * Rows are read by a separate thread and decompressed and
+	 * decoded by memtx_snap_threads decoder threads while the tx
+	 * thread is applying the rows read before.
+	 */
+	struct xlog_reader reader;
+	if (xlog_reader_start(&reader, filename, memtx->force_recovery,
+			      memtx->snap_threads > 1 ?
+			      memtx->snap_threads : 0) != 0)
 		return -1;
+	/* System spaces go first, errors in them can't be skipped. */
+	reader.force_recovery = false;
 
 	int rc;
-	struct xrow_header row;
+	struct xrow_header *rows;
+	struct request *requests;
+	int count;
 	uint64_t row_count = 0;
 	int is_space_system = -1;
-	bool force_recovery = false;
 	/*
 	 * In case when we read system space, we can't ignore errors.
+	 * The reader reads ahead past corrupted data and leaves it
+	 * to us to decide whether to skip it, so the decision is
+	 * made for the row that precedes the corruption.
 	 */
-	while ((rc = xlog_cursor_next(&cursor, &row, force_recovery)) == 0) {
-		row.lsn = signature;
-		rc = memtx_engine_recover_snapshot_row(memtx, &row,
-						       &is_space_system);
-		force_recovery = is_space_system == 0 ?
-				 memtx->force_recovery : false;
-		if (rc < 0) {
-			if (!force_recovery)
-				break;
-			say_error("can't apply row: ");
-			diag_log();
-		}
-		++row_count;
-		if (row_count % 100000 == 0) {
-			say_info_ratelimited("%.1fM rows processed",
-					     row_count / 1e6);
-			fiber_yield_timeout(0);
+	while ((rc = xlog_reader_next(&reader, &rows, &requests,
+				      &count)) == 0 && count > 0) {
+		for (int i = 0; i < count; i++) {
+			struct xrow_header *row = &rows[i];
+			row->lsn = signature;
+			rc = memtx_engine_recover_snapshot_row(
+				memtx, row, &requests[i], &is_space_system);
+			reader.force_recovery = is_space_system == 0 ?
+						memtx->force_recovery : false;
+			if (rc < 0) {
+				if (!reader.force_recovery)
+					goto out;
+				say_error("can't apply row: ");
+				diag_log();
+			}
+			++row_count;
+			if (row_count % 100000 == 0) {
+				say_info_ratelimited("%.1fM rows processed",
+						     row_count / 1e6);
+				fiber_yield_timeout(0);
+			}
 		}
 	}
-	xlog_cursor_close(&cursor, false);
+out:
+	xlog_reader_stop(&reader);
 	if (rc < 0 || is_space_system < 0)
 		return -1;
 
@@ -296,11 +526,11 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 	 * marker - such snapshots are very likely corrupted and
 	 * should not be trusted.
 	 */
-	if (!xlog_cursor_is_eof(&cursor)) {
+	if (!reader.is_eof) {
 		if (!memtx->force_recovery)
-			panic("snapshot `%s' has no EOF marker", cursor.name);
+			panic("snapshot `%s' has no EOF marker", filename);
 		else
-			say_error("snapshot `%s' has no EOF marker", cursor.name);
+			say_error("snapshot `%s' has no EOF marker", filename);
 	}
 
 	return 0;
@@ -334,9 +564,15 @@ memtx_engine_recover_synchro(const struct xrow_header *row)
 	return 0;
 }
 
+/**
+ * Apply a snapshot row. If @a request has a header, it is the DML
+ * request decoded from the row by the reader thread.
+ */
 static int
 memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
-				  struct xrow_header *row, int *is_space_system)
+				  struct xrow_header *row,
+				  struct request *request,
+				  int *is_space_system)
 {
 	assert(row->bodycnt == 1); /* always 1 for read */
 	if (row->type != IPROTO_INSERT) {
@@ -349,11 +585,11 @@ memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 		return -1;
 	}
 	int rc;
-	struct request request;
-	if (xrow_decode_dml(row, &request, dml_request_key_map(row->type)) != 0)
+	if (request->header == NULL &&
+	    xrow_decode_dml(row, request, dml_request_key_map(row->type)) != 0)
 		return -1;
-	*is_space_system = (request.space_id < BOX_SYSTEM_ID_MAX);
-	struct space *space = space_cache_find(request.space_id);
+	*is_space_system = (request->space_id < BOX_SYSTEM_ID_MAX);
+	struct space *space = space_cache_find(request->space_id);
 	if (space == NULL)
 		return -1;
 	/* memtx snapshot must contain only memtx spaces */
@@ -364,13 +600,13 @@ memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 	struct txn *txn = txn_begin();
 	if (txn == NULL)
 		return -1;
-	if (txn_begin_stmt(txn, space, request.type) != 0)
+	if (txn_begin_stmt(txn, space, request->type) != 0)
 		goto rollback;
 	/* no access checks here - applier always works with admin privs */
 	struct tuple *unused;
-	if (space_execute_dml(space, txn, &request, &unused) != 0)
+	if (space_execute_dml(space, txn, request, &unused) != 0)
 		goto rollback_stmt;
-	if (txn_commit_stmt(txn, &request) != 0)
+	if (txn_commit_stmt(txn, request) != 0)
 		goto rollback;
 	/*
 	 * Snapshot rows are confirmed by definition. They don't need to go to
@@ -442,7 +678,7 @@ memtx_engine_begin_final_recovery(struct engine *engine)
 		 * unique keys.
 		 */
 		memtx->state = MEMTX_OK;
-		if (space_foreach(memtx_build_secondary_keys, memtx) != 0)
+		if (memtx_engine_build_secondary_keys(memtx) != 0)
 			return -1;
 	}
 	return 0;
@@ -460,7 +696,7 @@ memtx_engine_begin_hot_standby(struct engine *engine)
 	if (memtx->state != MEMTX_OK) {
 		assert(memtx->state == MEMTX_FINAL_RECOVERY);
 		memtx->state = MEMTX_OK;
-		if (space_foreach(memtx_build_secondary_keys, memtx) != 0)
+		if (memtx_engine_build_secondary_keys(memtx) != 0)
 			return -1;
 	}
 	return 0;
@@ -479,7 +715,7 @@ memtx_engine_end_recovery(struct engine *engine)
 	if (memtx->state != MEMTX_OK) {
 		assert(memtx->state == MEMTX_FINAL_RECOVERY);
 		memtx->state = MEMTX_OK;
-		if (space_foreach(memtx_build_secondary_keys, memtx) != 0)
+		if (memtx_engine_build_secondary_keys(memtx) != 0)
 			return -1;
 	}
 	xdir_collect_inprogress(&memtx->snap_dir);
@@ -528,6 +764,11 @@ memtx_engine_commit(struct engine *engine, struct txn *txn)
 				(struct memtx_space *)stmt->space;
 			size_t *bsize = &mspace->bsize;
 			uint64_t *ctuples = &mspace->compressed_tuples;
+			memtx_space_update_tuple_memory(stmt->space,
+				stmt->del_story != NULL ?
+				stmt->del_story->tuple : NULL,
+				stmt->add_story != NULL ?
+				stmt->add_story->tuple : NULL);
 			memtx_tx_history_commit_stmt(stmt, bsize, ctuples);
 		}
 	}
@@ -578,6 +819,7 @@ memtx_engine_rollback_statement(struct engine *engine, struct txn *txn,
 	}
 
 	memtx_space_update_bsize(space, new_tuple, old_tuple);
+	memtx_space_update_tuple_memory(space, new_tuple, old_tuple);
 	memtx_space_update_compressed_tuples(space, new_tuple, old_tuple);
 	if (old_tuple != NULL)
 		tuple_ref(old_tuple);
@@ -603,7 +845,10 @@ memtx_engine_bootstrap(struct engine *engine)
 	int rc, is_space_system;
 	struct xrow_header row;
 	while ((rc = xlog_cursor_next(&cursor, &row, true)) == 0) {
-		rc = memtx_engine_recover_snapshot_row(memtx, &row, &is_space_system);
+		struct request request;
+		request.header = NULL;
+		rc = memtx_engine_recover_snapshot_row(memtx, &row, &request,
+						       &is_space_system);
 		if (rc < 0)
 			break;
 	}
@@ -611,16 +856,22 @@ memtx_engine_bootstrap(struct engine *engine)
 	return rc < 0 ? -1 : 0;
 }
 
-static int
-checkpoint_write_row(struct xlog *l, struct xrow_header *row)
+/** Timestamp of snapshot rows. */
+static ev_tstamp
+checkpoint_row_tm(void)
 {
 	static ev_tstamp last = 0;
 	if (last == 0) {
 		ev_now_update(loop());
 		last = ev_now(loop());
 	}
+	return last;
+}
 
-	row->tm = last;
+static int
+checkpoint_write_row(struct xlog *l, struct xrow_header *row)
+{
+	row->tm = checkpoint_row_tm();
 	row->replica_id = 0;
 	/**
 	 * Rows in snapshot are numbered from 1 to %rows.
@@ -645,33 +896,86 @@ checkpoint_write_row(struct xlog *l, struct xrow_header *row)
 
 }
 
+/** Encode an INSERT of a tuple into a snapshot row. */
+static void
+checkpoint_encode_tuple(struct xrow_header *row,
+			struct request_replace_body *body,
+			uint32_t space_id, uint32_t group_id,
+			const char *data, uint32_t size)
+{
+	request_replace_body_create(body, space_id);
+
+	memset(row, 0, sizeof(struct xrow_header));
+	row->type = IPROTO_INSERT;
+	row->group_id = group_id;
+
+	row->bodycnt = 2;
+	row->body[0].iov_base = body;
+	row->body[0].iov_len = sizeof(*body);
+	row->body[1].iov_base = (char *)data;
+	row->body[1].iov_len = size;
+}
+
 static int
 checkpoint_write_tuple(struct xlog *l, uint32_t space_id, uint32_t group_id,
 		       const char *data, uint32_t size)
 {
 	struct request_replace_body body;
-	request_replace_body_create(&body, space_id);
-
 	struct xrow_header row;
-	memset(&row, 0, sizeof(struct xrow_header));
-	row.type = IPROTO_INSERT;
-	row.group_id = group_id;
-
-	row.bodycnt = 2;
-	row.body[0].iov_base = &body;
-	row.body[0].iov_len = sizeof(body);
-	row.body[1].iov_base = (char *)data;
-	row.body[1].iov_len = size;
+	checkpoint_encode_tuple(&row, &body, space_id, group_id, data, size);
 	return checkpoint_write_row(l, &row);
 }
 
 struct checkpoint_entry {
 	uint32_t space_id;
 	uint32_t group_id;
+	/** Set for system spaces, which are written first. */
+	bool is_system;
 	struct snapshot_iterator *iterator;
 	struct rlist link;
 };
 
+/**
+ * Threads writing user spaces to a snapshot file in parallel
+ * with the snapshot thread, see checkpoint_write_parallel().
+ */
+struct checkpoint_pool {
+	/**
+	 * Streams of the threads writing to the snapshot file.
+	 * Rows are numbered in the file order when the streams
+	 * write them, see xlog_stream_group.
+	 */
+	struct xlog_stream_group streams;
+	/** Protects the thread counters below. */
+	pthread_mutex_t mutex;
+	/** Signaled when a started thread finishes writing. */
+	pthread_cond_t cond;
+	/** Entries to write. */
+	struct checkpoint_entry **entries;
+	/** Number of entries in the entries array. */
+	int entry_count;
+	/** Index of the next entry to write. */
+	int next;
+	/** Number of rows written before the streams were started. */
+	int64_t first_row_count;
+	/** Number of rows added to the streams so far. */
+	int64_t row_count;
+	/** Timestamp of snapshot rows. */
+	double tm;
+	/** Set if any of the threads failed. */
+	int is_failed;
+	/** Threads started in addition to the snapshot thread. */
+	struct cord *cords;
+	/** Number of started threads. */
+	int started;
+	/** Number of started threads that finished writing. */
+	int finished;
+	/** Number of joined threads. */
+	int joined;
+	/** Set if the streams have been created. */
+	bool is_streams_created;
+};
+
 struct checkpoint {
 	/**
 	 * List of MemTX spaces to snapshot, with consistent
@@ -690,10 +994,18 @@ struct checkpoint {
 	 * checkpoint already exists.
 	 */
 	bool touch;
+	/**
+	 * Number of threads writing the snapshot file,
+	 * box.cfg.memtx_snap_threads.
+	 */
+	int thread_count;
+	/** Threads writing user spaces in parallel. */
+	struct checkpoint_pool pool;
 };
 
 static struct checkpoint *
-checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit)
+checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit,
+	       int thread_count)
 {
 	struct checkpoint *ckpt = (struct checkpoint *)malloc(sizeof(*ckpt));
 	if (ckpt == NULL) {
@@ -712,6 +1024,10 @@ checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit)
 	box_raft_checkpoint_local(&ckpt->raft);
 	txn_limbo_checkpoint(&txn_limbo, &ckpt->synchro_state);
 	ckpt->touch = false;
+	ckpt->thread_count = thread_count;
+	memset(&ckpt->pool, 0, sizeof(ckpt->pool));
+	tt_pthread_mutex_init(&ckpt->pool.mutex, NULL);
+	tt_pthread_cond_init(&ckpt->pool.cond, NULL);
 	return ckpt;
 }
 
@@ -723,6 +1039,12 @@ checkpoint_delete(struct checkpoint *ckpt)
 		entry->iterator->free(entry->iterator);
 		free(entry);
 	}
+	free(ckpt->pool.entries);
+	free(ckpt->pool.cords);
+	if (ckpt->pool.is_streams_created)
+		xlog_stream_group_destroy(&ckpt->pool.streams);
+	tt_pthread_cond_destroy(&ckpt->pool.cond);
+	tt_pthread_mutex_destroy(&ckpt->pool.mutex);
 	xdir_destroy(&ckpt->dir);
 	free(ckpt);
 }
@@ -738,6 +1060,12 @@ checkpoint_cancel(struct checkpoint *ckpt)
 	if (ckpt->waiting_for_snap_thread) {
 		tt_pthread_cancel(ckpt->cord.id);
 		tt_pthread_join(ckpt->cord.id, NULL);
+		/* Threads started by the snapshot thread. */
+		struct checkpoint_pool *pool = &ckpt->pool;
+		for (int i = pool->joined; i < pool->started; i++) {
+			tt_pthread_cancel(pool->cords[i].id);
+			tt_pthread_join(pool->cords[i].id, NULL);
+		}
 	}
 	checkpoint_delete(ckpt);
 }
@@ -776,6 +1104,7 @@ checkpoint_add_space(struct space *sp, void *data)
 
 	entry->space_id = space_id(sp);
 	entry->group_id = space_group_id(sp);
+	entry->is_system = space_is_system(sp);
 	entry->iterator = index_create_snapshot_iterator(pk);
 	if (entry->iterator == NULL)
 		return -1;
@@ -809,6 +1138,212 @@ checkpoint_write_synchro(struct xlog *l, const struct synchro_request *req)
 	return checkpoint_write_row(l, &row);
 }
 
+/** Write all tuples of a checkpoint entry to a snapshot file. */
+static int
+checkpoint_write_entry(struct xlog *snap, struct checkpoint_entry *entry)
+{
+	int rc;
+	uint32_t size;
+	const char *data;
+	struct snapshot_iterator *it = entry->iterator;
+	while ((rc = it->next(it, &data, &size)) == 0 && data != NULL) {
+		if (checkpoint_write_tuple(snap, entry->space_id,
+					   entry->group_id, data, size) != 0)
+			return -1;
+	}
+	return rc;
+}
+
+/** Write a tuple to a snapshot file using a parallel stream. */
+static int
+checkpoint_stream_write_tuple(struct checkpoint_pool *pool,
+			      struct xlog_stream *stream,
+			      uint32_t space_id, uint32_t group_id,
+			      const char *data, uint32_t size)
+{
+	struct request_replace_body body;
+	struct xrow_header row;
+	checkpoint_encode_tuple(&row, &body, space_id, group_id, data, size);
+	row.tm = pool->tm;
+	row.replica_id = 0;
+	/* The LSN is assigned by the stream in the file order. */
+	row.sync = 0;
+
+	ssize_t written = xlog_stream_write_row(stream, &row);
+	fiber_gc();
+	if (written < 0)
+		return -1;
+
+	int64_t n = pool->first_row_count +
+		    pm_atomic_fetch_add(&pool->row_count, 1) + 1;
+	if (n % 100000 == 0) {
+		/*
+		 * say_info_ratelimited() keeps its state in a static
+		 * variable, which isn't safe to update from many threads.
+		 */
+		static __thread struct ratelimit rl =
+			RATELIMIT_INITIALIZER(SAY_RATELIMIT_INTERVAL,
+					      SAY_RATELIMIT_BURST);
+		if (say_ratelimit_check(&rl, S_INFO))
+			say_info("%.1fM rows written", n / 1e6);
+	}
+	return 0;
+}
+
+/**
+ * Take entries from the pool and write them to the snapshot
+ * file until there are no entries left or another thread fails.
+ */
+static int
+checkpoint_pool_run(struct checkpoint_pool *pool)
+{
+	struct xlog_stream stream;
+	if (xlog_stream_create(&stream, &pool->streams) != 0)
+		goto fail;
+	int i;
+	while (pm_atomic_load(&pool->is_failed) == 0 &&
+	       (i = pm_atomic_fetch_add(&pool->next, 1)) < pool->entry_count) {
+		struct checkpoint_entry *entry = pool->entries[i];
+		struct snapshot_iterator *it = entry->iterator;
+		int rc;
+		uint32_t size;
+		const char *data;
+		while ((rc = it->next(it, &data, &size)) == 0 && data != NULL) {
+			if (checkpoint_stream_write_tuple(pool, &stream,
+					entry->space_id, entry->group_id,
+					data, size) != 0)
+				goto fail_stream;
+		}
+		if (rc != 0)
+			goto fail_stream;
+	}
+	if (xlog_stream_flush(&stream) < 0)
+		goto fail_stream;
+	xlog_stream_destroy(&stream);
+	return 0;
+fail_stream:
+	xlog_stream_destroy(&stream);
+fail:
+	pm_atomic_store(&pool->is_failed, 1);
+	return -1;
+}
+
+static int
+checkpoint_pool_f(va_list ap)
+{
+	struct checkpoint_pool *pool = va_arg(ap, struct checkpoint_pool *);
+	int rc = checkpoint_pool_run(pool);
+	tt_pthread_mutex_lock(&pool->mutex);
+	pool->finished++;
+	tt_pthread_cond_signal(&pool->cond);
+	tt_pthread_mutex_unlock(&pool->mutex);
+	return rc;
+}
+
+static void
+checkpoint_pool_unlock_cb(void *mutex)
+{
+	tt_pthread_mutex_unlock((pthread_mutex_t *)mutex);
+}
+
+/**
+ * Wait for the started threads to finish writing and join them.
+ * Only the wait may be cancelled, so that the number of joined
+ * threads is accurate when checkpoint_cancel() reads it.
+ */
+static int
+checkpoint_pool_join(struct checkpoint_pool *pool)
+{
+	tt_pthread_mutex_lock(&pool->mutex);
+	pthread_cleanup_push(checkpoint_pool_unlock_cb, &pool->mutex);
+	while (pool->finished < pool->started)
+		tt_pthread_cond_wait(&pool->cond, &pool->mutex);
+	pthread_cleanup_pop(1);
+	int rc = 0;
+	int cancel_state;
+	tt_pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancel_state);
+	for (; pool->joined < pool->started; pool->joined++) {
+		if (cord_join(&pool->cords[pool->joined]) != 0)
+			rc = -1;
+	}
+	tt_pthread_setcancelstate(cancel_state, NULL);
+	return rc;
+}
+
+/**
+ * Write the given entries to a snapshot file using up to
+ * checkpoint::thread_count threads, one of which is the caller's.
+ * Each thread takes the next entry that hasn't been written yet,
+ * so different spaces are written in parallel. Threads encode
+ * and compress rows independently, only writes of the resulting
+ * blocks to the file are serialized, see xlog_stream.
+ *
+ * Rows of different spaces are interleaved in the file, which
+ * is fine for recovery as long as system spaces precede them,
+ * because the primary key is built in bulk at the end of recovery
+ * from the snapshot. Failure to start a thread isn't fatal - the
+ * rest of the threads pick up its share of work.
+ */
+static int
+checkpoint_write_parallel(struct checkpoint *ckpt, struct xlog *snap,
+			  struct checkpoint_entry *first)
+{
+	struct checkpoint_pool *pool = &ckpt->pool;
+	int count = 0;
+	struct checkpoint_entry *entry;
+	for (entry = first; &entry->link != &ckpt->entries;
+	     entry = rlist_next_entry(entry, link))
+		count++;
+	size_t size = count * sizeof(pool->entries[0]);
+	pool->entries = (struct checkpoint_entry **)malloc(size);
+	if (pool->entries == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "entries");
+		return -1;
+	}
+	for (entry = first; &entry->link != &ckpt->entries;
+	     entry = rlist_next_entry(entry, link))
+		pool->entries[pool->entry_count++] = entry;
+	/* Rows written so far must precede rows of the streams. */
+	if (xlog_flush(snap) < 0)
+		return -1;
+	xlog_stream_group_create(&pool->streams, snap, snap->rows);
+	pool->is_streams_created = true;
+	pool->first_row_count = snap->rows;
+	pool->tm = checkpoint_row_tm();
+
+	int thread_count = MIN(ckpt->thread_count, count) - 1;
+	if (thread_count > 0) {
+		pool->cords = (struct cord *)calloc(thread_count,
+						    sizeof(*pool->cords));
+		if (pool->cords == NULL)
+			thread_count = 0;
+	}
+	say_info("writing %d spaces using %d threads", count,
+		 thread_count + 1);
+	/*
+	 * The tx thread may cancel this thread and then cancels and
+	 * joins the started threads, see checkpoint_cancel(). Don't
+	 * let it happen while a thread is being started, otherwise
+	 * a running thread may be not counted yet.
+	 */
+	int cancel_state;
+	tt_pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancel_state);
+	for (; pool->started < thread_count; pool->started++) {
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "snapshot.%d", pool->started);
+		if (cord_costart(&pool->cords[pool->started], name,
+				 checkpoint_pool_f, pool) != 0) {
+			diag_log();
+			break;
+		}
+	}
+	tt_pthread_setcancelstate(cancel_state, NULL);
+	int rc = checkpoint_pool_run(pool);
+	if (checkpoint_pool_join(pool) != 0)
+		rc = -1;
+	return rc;
+}
+
 static int
 checkpoint_f(va_list ap)
 {
@@ -830,20 +1365,20 @@ checkpoint_f(va_list ap)
 
 	say_info("saving snapshot `%s'", snap.filename);
 	ERROR_INJECT_SLEEP(ERRINJ_SNAP_WRITE_DELAY);
+	/*
+	 * System spaces are always written by the snapshot thread
+	 * first, because they are needed to recover the rest.
+	 */
 	struct checkpoint_entry *entry;
 	rlist_foreach_entry(entry, &ckpt->entries, link) {
-		int rc;
-		uint32_t size;
-		const char *data;
-		struct snapshot_iterator *it = entry->iterator;
-		while ((rc = it->next(it, &data, &size)) == 0 && data != NULL) {
-			if (checkpoint_write_tuple(&snap, entry->space_id,
-					entry->group_id, data, size) != 0)
-				goto fail;
-		}
-		if (rc != 0)
+		if (ckpt->thread_count > 1 && !entry->is_system)
+			break;
+		if (checkpoint_write_entry(&snap, entry) != 0)
 			goto fail;
 	}
+	if (&entry->link != &ckpt->entries &&
+	    checkpoint_write_parallel(ckpt, &snap, entry) != 0)
+		goto fail;
 	if (checkpoint_write_raft(&snap, &ckpt->raft) != 0)
 		goto fail;
 	if (checkpoint_write_synchro(&snap, &ckpt->synchro_state) != 0)
@@ -867,7 +1402,8 @@ memtx_engine_begin_checkpoint(struct engine *engine, bool is_scheduled)
 
 	assert(memtx->checkpoint == NULL);
 	memtx->checkpoint = checkpoint_new(memtx->snap_dir.dirname,
-					   memtx->snap_io_rate_limit);
+					   memtx->snap_io_rate_limit,
+					   memtx->snap_threads);
 	if (memtx->checkpoint == NULL)
 		return -1;
 
@@ -1341,6 +1877,8 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 
 	memtx->state = MEMTX_INITIALIZED;
 	memtx->max_tuple_size = MAX_TUPLE_SIZE;
+	memtx->build_threads = 1;
+	memtx->snap_threads = 1;
 	memtx->force_recovery = force_recovery;
 
 	memtx->replica_join_cord = NULL;
@@ -1388,6 +1926,24 @@ memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size)
 	memtx->max_tuple_size = max_size;
 }
 
+void
+memtx_engine_set_build_threads(struct memtx_engine *memtx, int count)
+{
+	memtx->build_threads = count;
+}
+
+void
+memtx_engine_set_snap_threads(struct memtx_engine *memtx, int count)
+{
+	memtx->snap_threads = count;
+}
+
+void
+memtx_engine_set_use_swiss_hash(struct memtx_engine *memtx, bool value)
+{
+	memtx->use_swiss_hash = value;
+}
+
 void
 memtx_enter_delayed_free_mode(struct memtx_engine *memtx)
 {
@@ -1507,6 +2063,12 @@ memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 	tuple_format_unref(format);
 }
 
+size_t
+memtx_tuple_size(struct tuple *tuple)
+{
+	return tuple_size(tuple) + offsetof(struct memtx_tuple, base);
+}
+
 struct tuple_format_vtab memtx_tuple_format_vtab;
 
 template <class ALLOC>
@@ -1611,6 +2173,8 @@ memtx_index_def_change_requires_rebuild(struct index *index,
 		return true;
 	if (old_def->opts.hint != new_def->opts.hint)
 		return true;
+	if (old_def->opts.fast_offset != new_def->opts.fast_offset)
+		return true;
 
 	const struct key_def *old_cmp_def, *new_cmp_def;
 	if (index_depends_on_pk(index)) {
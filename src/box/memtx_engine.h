@@ -100,6 +100,13 @@ enum memtx_recovery_state {
 /** Memtx extents pool, available to statistics. */
 extern struct mempool memtx_index_extent_pool;
 
+enum {
+	/** Max allowed value of box.cfg.memtx_build_threads. */
+	MEMTX_BUILD_THREADS_MAX = 256,
+	/** Max allowed value of box.cfg.memtx_snap_threads. */
+	MEMTX_SNAP_THREADS_MAX = 256,
+};
+
 enum memtx_reserve_extents_num {
 	/**
 	 * This number is calculated based on the
@@ -163,6 +170,22 @@ struct memtx_engine {
 	void *reserved_extents;
 	/** Maximal allowed tuple size, box.cfg.memtx_max_tuple_size. */
 	size_t max_tuple_size;
+	/**
+	 * Number of threads used for sorting secondary keys when
+	 * they are built in bulk at the end of recovery,
+	 * box.cfg.memtx_build_threads.
+	 */
+	int build_threads;
+	/**
+	 * Number of threads used for writing user spaces to a
+	 * snapshot, box.cfg.memtx_snap_threads.
+	 */
+	int snap_threads;
+	/**
+	 * Create HASH indexes with SIMD group probing instead of
+	 * the chained hash table, box.cfg.memtx_use_swiss_hash.
+	 */
+	bool use_swiss_hash;
 	/** Incremented with each next snapshot. */
 	uint32_t snapshot_version;
 	/**
@@ -243,6 +266,15 @@ memtx_engine_set_memory(struct memtx_engine *memtx, size_t size);
 void
 memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size);
 
+void
+memtx_engine_set_build_threads(struct memtx_engine *memtx, int count);
+
+void
+memtx_engine_set_snap_threads(struct memtx_engine *memtx, int count);
+
+void
+memtx_engine_set_use_swiss_hash(struct memtx_engine *memtx, bool value);
+
 /**
  * Enter tuple delayed free mode: tuple allocated before the call
  * won't be freed until memtx_leave_delayed_free_mode() is called.
@@ -289,6 +321,14 @@ extern struct tuple *
 (*memtx_tuple_new_raw)(struct tuple_format *format, const char *data,
 		       const char *end, bool validate);
 
+/**
+ * Estimate the number of bytes allocated for a memtx tuple:
+ * the tuple size including the memtx tuple header. Rounding up
+ * to the allocator size class isn't taken into account.
+ */
+size_t
+memtx_tuple_size(struct tuple *tuple);
+
 /**
  * Returns the size of an allocation done with memtx_alloc.
  * (The size is stored before the data.)
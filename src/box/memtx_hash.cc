@@ -74,68 +74,302 @@ memtx_hash_equal_key(struct tuple *tuple, const char *key,
 #undef LIGHT_EQUAL
 #undef LIGHT_EQUAL_KEY
 
+#define SWISS_NAME _index
+#define SWISS_DATA_TYPE struct tuple *
+#define SWISS_KEY_TYPE const char *
+#define SWISS_CMP_ARG_TYPE struct key_def *
+#define SWISS_EQUAL(a, b, c) memtx_hash_equal(a, b, c)
+#define SWISS_EQUAL_KEY(a, b, c) memtx_hash_equal_key(a, b, c)
+
+#include "salad/swiss.h"
+
+#undef SWISS_NAME
+#undef SWISS_DATA_TYPE
+#undef SWISS_KEY_TYPE
+#undef SWISS_CMP_ARG_TYPE
+#undef SWISS_EQUAL
+#undef SWISS_EQUAL_KEY
+
+/* {{{ Hash table implementations *********************************/
+
+/**
+ * The index code is shared by hash table implementations and
+ * parametrized by one of the structs below, which wrap a hash
+ * table with the same set of methods.
+ */
+
+/** Chained hash table, see salad/light.h. The default one. */
+struct memtx_light_table {
+	typedef struct light_index_core core;
+	typedef struct light_index_iterator iterator;
+
+	static void
+	create(core *ht, struct memtx_engine *memtx, struct key_def *key_def)
+	{
+		light_index_create(ht, MEMTX_EXTENT_SIZE,
+				   memtx_index_extent_alloc,
+				   memtx_index_extent_free, memtx, key_def);
+	}
+
+	static void
+	destroy(core *ht)
+	{
+		light_index_destroy(ht);
+	}
+
+	static size_t
+	extent_count(core *ht)
+	{
+		return matras_extent_count(&ht->mtable);
+	}
+
+	static struct tuple *
+	random(core *ht, uint32_t rnd)
+	{
+		rnd %= (ht->table_size);
+		while (!light_index_pos_valid(ht, rnd)) {
+			rnd++;
+			rnd %= (ht->table_size);
+		}
+		return light_index_get(ht, rnd);
+	}
+
+	static struct tuple *
+	find_key(core *ht, uint32_t hash, const char *key)
+	{
+		uint32_t k = light_index_find_key(ht, hash, key);
+		return k != light_index_end ? light_index_get(ht, k) : NULL;
+	}
+
+	/**
+	 * Replace a tuple equal to @a tuple, returning it in @a dup,
+	 * or insert @a tuple. Returns -1 on memory error.
+	 */
+	static int
+	replace(core *ht, uint32_t hash, struct tuple *tuple,
+		struct tuple **dup)
+	{
+		uint32_t pos = light_index_replace(ht, hash, tuple, dup);
+		if (pos == light_index_end)
+			pos = light_index_insert(ht, hash, tuple);
+		return pos != light_index_end ? 0 : -1;
+	}
+
+	static int
+	insert(core *ht, uint32_t hash, struct tuple *tuple)
+	{
+		uint32_t pos = light_index_insert(ht, hash, tuple);
+		return pos != light_index_end ? 0 : -1;
+	}
+
+	static int
+	delete_value(core *ht, uint32_t hash, struct tuple *tuple)
+	{
+		return light_index_delete_value(ht, hash, tuple);
+	}
+
+	static void
+	iterator_begin(core *ht, iterator *it)
+	{
+		light_index_iterator_begin(ht, it);
+	}
+
+	/** Returns false if the key isn't found. */
+	static bool
+	iterator_key(core *ht, iterator *it, uint32_t hash, const char *key)
+	{
+		light_index_iterator_key(ht, it, hash, key);
+		return it->slotpos != light_index_end;
+	}
+
+	static struct tuple **
+	iterator_get_and_next(core *ht, iterator *it)
+	{
+		return light_index_iterator_get_and_next(ht, it);
+	}
+
+	static void
+	iterator_freeze(core *ht, iterator *it)
+	{
+		light_index_iterator_freeze(ht, it);
+	}
+
+	static void
+	iterator_destroy(core *ht, iterator *it)
+	{
+		light_index_iterator_destroy(ht, it);
+	}
+};
+
+/**
+ * Hash table with SIMD group probing, see salad/swiss.h.
+ * Used if box.cfg.memtx_use_swiss_hash is set.
+ */
+struct memtx_swiss_table {
+	typedef struct swiss_index_core core;
+	typedef struct swiss_index_iterator iterator;
+
+	static void
+	create(core *ht, struct memtx_engine *memtx, struct key_def *key_def)
+	{
+		swiss_index_create(ht, MEMTX_EXTENT_SIZE,
+				   memtx_index_extent_alloc,
+				   memtx_index_extent_free, memtx, key_def);
+	}
+
+	static void
+	destroy(core *ht)
+	{
+		swiss_index_destroy(ht);
+	}
+
+	static size_t
+	extent_count(core *ht)
+	{
+		return swiss_index_extent_count(ht);
+	}
+
+	static struct tuple *
+	random(core *ht, uint32_t rnd)
+	{
+		return *swiss_index_random(ht, rnd);
+	}
+
+	static struct tuple *
+	find_key(core *ht, uint32_t hash, const char *key)
+	{
+		struct tuple **res = swiss_index_find_key(ht, hash, key);
+		return res != NULL ? *res : NULL;
+	}
+
+	static int
+	replace(core *ht, uint32_t hash, struct tuple *tuple,
+		struct tuple **dup)
+	{
+		int rc = swiss_index_replace(ht, hash, tuple, dup);
+		if (rc > 0)
+			rc = swiss_index_insert(ht, hash, tuple);
+		return rc;
+	}
+
+	static int
+	insert(core *ht, uint32_t hash, struct tuple *tuple)
+	{
+		return swiss_index_insert(ht, hash, tuple);
+	}
+
+	static int
+	delete_value(core *ht, uint32_t hash, struct tuple *tuple)
+	{
+		return swiss_index_delete_value(ht, hash, tuple);
+	}
+
+	static void
+	iterator_begin(core *ht, iterator *it)
+	{
+		swiss_index_iterator_begin(ht, it);
+	}
+
+	static bool
+	iterator_key(core *ht, iterator *it, uint32_t hash, const char *key)
+	{
+		return swiss_index_iterator_key(ht, it, hash, key);
+	}
+
+	static struct tuple **
+	iterator_get_and_next(core *ht, iterator *it)
+	{
+		return swiss_index_iterator_get_and_next(ht, it);
+	}
+
+	static void
+	iterator_freeze(core *ht, iterator *it)
+	{
+		swiss_index_iterator_freeze(ht, it);
+	}
+
+	static void
+	iterator_destroy(core *ht, iterator *it)
+	{
+		swiss_index_iterator_destroy(ht, it);
+	}
+};
+
+/* }}} */
+
+template <class Table>
 struct memtx_hash_index {
 	struct index base;
-	struct light_index_core hash_table;
+	typename Table::core hash_table;
 	struct memtx_gc_task gc_task;
-	struct light_index_iterator gc_iterator;
+	typename Table::iterator gc_iterator;
 };
 
 /* {{{ MemtxHash Iterators ****************************************/
 
+template <class Table>
 struct hash_iterator {
 	struct iterator base; /* Must be the first member. */
-	struct light_index_iterator iterator;
+	typename Table::iterator iterator;
 	/** Memory pool the iterator was allocated from. */
 	struct mempool *pool;
 };
 
-static_assert(sizeof(struct hash_iterator) <= MEMTX_ITERATOR_SIZE,
+static_assert(sizeof(struct hash_iterator<memtx_light_table>) <=
+	      MEMTX_ITERATOR_SIZE,
+	      "sizeof(struct hash_iterator) must be less than or equal "
+	      "to MEMTX_ITERATOR_SIZE");
+static_assert(sizeof(struct hash_iterator<memtx_swiss_table>) <=
+	      MEMTX_ITERATOR_SIZE,
 	      "sizeof(struct hash_iterator) must be less than or equal "
 	      "to MEMTX_ITERATOR_SIZE");
 
+template <class Table>
 static void
 hash_iterator_free(struct iterator *iterator)
 {
-	assert(iterator->free == hash_iterator_free);
-	struct hash_iterator *it = (struct hash_iterator *) iterator;
+	assert(iterator->free == hash_iterator_free<Table>);
+	struct hash_iterator<Table> *it =
+		(struct hash_iterator<Table> *) iterator;
 	mempool_free(it->pool, it);
 }
 
-template <bool UNCHANGED>
+template <class Table, bool UNCHANGED>
 static int
 hash_iterator_ge_raw_base(struct iterator *ptr, struct tuple **ret)
 {
-	assert(ptr->free == hash_iterator_free);
-	struct hash_iterator *it = (struct hash_iterator *) ptr;
-	struct memtx_hash_index *index = (struct memtx_hash_index *)ptr->index;
-	struct tuple **res = light_index_iterator_get_and_next(&index->hash_table,
-							       &it->iterator);
+	assert(ptr->free == hash_iterator_free<Table>);
+	struct hash_iterator<Table> *it = (struct hash_iterator<Table> *) ptr;
+	struct memtx_hash_index<Table> *index =
+		(struct memtx_hash_index<Table> *)ptr->index;
+	struct tuple **res = Table::iterator_get_and_next(&index->hash_table,
+							  &it->iterator);
 	*ret = res != NULL ? *res : NULL;
 	return 0;
 }
 
-template <bool UNCHANGED>
+template <class Table, bool UNCHANGED>
 static int
 hash_iterator_gt_raw_base(struct iterator *ptr, struct tuple **ret)
 {
-	assert(ptr->free == hash_iterator_free);
-	ptr->next_raw = hash_iterator_ge_raw_base<UNCHANGED>;
+	assert(ptr->free == hash_iterator_free<Table>);
+	ptr->next_raw = hash_iterator_ge_raw_base<Table, UNCHANGED>;
 	if (UNCHANGED)
 		ptr->next = ptr->next_raw;
-	struct hash_iterator *it = (struct hash_iterator *) ptr;
-	struct memtx_hash_index *index = (struct memtx_hash_index *)ptr->index;
-	struct tuple **res = light_index_iterator_get_and_next(&index->hash_table,
-							       &it->iterator);
+	struct hash_iterator<Table> *it = (struct hash_iterator<Table> *) ptr;
+	struct memtx_hash_index<Table> *index =
+		(struct memtx_hash_index<Table> *)ptr->index;
+	struct tuple **res = Table::iterator_get_and_next(&index->hash_table,
+							  &it->iterator);
 	if (res != NULL)
-		res = light_index_iterator_get_and_next(&index->hash_table,
-							&it->iterator);
+		res = Table::iterator_get_and_next(&index->hash_table,
+						   &it->iterator);
 	*ret = res != NULL ? *res : NULL;
 	return 0;
 }
 
 #define WRAP_ITERATOR_METHOD(name)						\
-template <bool UNCHANGED>							\
+template <class Table, bool UNCHANGED>						\
 static int									\
 name(struct iterator *iterator, struct tuple **ret)				\
 {										\
@@ -146,8 +380,9 @@ name(struct iterator *iterator, struct tuple **ret)				\
 	bool is_first = true;							\
 	do {									\
 		int rc = is_first ?						\
-			name##_base<UNCHANGED>(iterator, ret) :			\
-			hash_iterator_ge_raw_base<UNCHANGED>(iterator, ret);	\
+			name##_base<Table, UNCHANGED>(iterator, ret) :		\
+			hash_iterator_ge_raw_base<Table, UNCHANGED>(iterator,	\
+								    ret);	\
 		if (rc != 0 || *ret == NULL)					\
 			return rc;						\
 		is_first = false;						\
@@ -169,7 +404,7 @@ tree_iterator_dummie(MAYBE_UNUSED struct iterator *it, struct tuple **ret)
 	return 0;
 }
 
-template <bool UNCHANGED>
+template <class Table, bool UNCHANGED>
 static int
 hash_iterator_raw_eq(struct iterator *it, struct tuple **ret)
 {
@@ -177,7 +412,7 @@ hash_iterator_raw_eq(struct iterator *it, struct tuple **ret)
 	if (UNCHANGED)
 		it->next = it->next_raw;
 	/* always returns zero. */
-	hash_iterator_ge_raw_base<UNCHANGED>(it, ret);
+	hash_iterator_ge_raw_base<Table, UNCHANGED>(it, ret);
 	if (*ret == NULL)
 		return 0;
 	struct txn *txn = in_txn();
@@ -191,13 +426,15 @@ hash_iterator_raw_eq(struct iterator *it, struct tuple **ret)
 
 /* {{{ MemtxHash -- implementation of all hashes. **********************/
 
+template <class Table>
 static void
-memtx_hash_index_free(struct memtx_hash_index *index)
+memtx_hash_index_free(struct memtx_hash_index<Table> *index)
 {
-	light_index_destroy(&index->hash_table);
+	Table::destroy(&index->hash_table);
 	free(index);
 }
 
+template <class Table>
 static void
 memtx_hash_index_gc_run(struct memtx_gc_task *task, bool *done)
 {
@@ -211,14 +448,14 @@ memtx_hash_index_gc_run(struct memtx_gc_task *task, bool *done)
 	enum { YIELD_LOOPS = 10 };
 #endif
 
-	struct memtx_hash_index *index = container_of(task,
-			struct memtx_hash_index, gc_task);
-	struct light_index_core *hash = &index->hash_table;
-	struct light_index_iterator *itr = &index->gc_iterator;
+	struct memtx_hash_index<Table> *index = container_of(task,
+			struct memtx_hash_index<Table>, gc_task);
+	typename Table::core *hash = &index->hash_table;
+	typename Table::iterator *itr = &index->gc_iterator;
 
 	struct tuple **res;
 	unsigned int loops = 0;
-	while ((res = light_index_iterator_get_and_next(hash, itr)) != NULL) {
+	while ((res = Table::iterator_get_and_next(hash, itr)) != NULL) {
 		tuple_unref(*res);
 		if (++loops >= YIELD_LOOPS) {
 			*done = false;
@@ -228,23 +465,32 @@ memtx_hash_index_gc_run(struct memtx_gc_task *task, bool *done)
 	*done = true;
 }
 
+template <class Table>
 static void
 memtx_hash_index_gc_free(struct memtx_gc_task *task)
 {
-	struct memtx_hash_index *index = container_of(task,
-			struct memtx_hash_index, gc_task);
+	struct memtx_hash_index<Table> *index = container_of(task,
+			struct memtx_hash_index<Table>, gc_task);
 	memtx_hash_index_free(index);
 }
 
-static const struct memtx_gc_task_vtab memtx_hash_index_gc_vtab = {
-	.run = memtx_hash_index_gc_run,
-	.free = memtx_hash_index_gc_free,
-};
+template <class Table>
+static const struct memtx_gc_task_vtab *
+get_memtx_hash_index_gc_vtab(void)
+{
+	static const struct memtx_gc_task_vtab vtab = {
+		/* .run = */ memtx_hash_index_gc_run<Table>,
+		/* .free = */ memtx_hash_index_gc_free<Table>,
+	};
+	return &vtab;
+}
 
+template <class Table>
 static void
 memtx_hash_index_destroy(struct index *base)
 {
-	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
+	struct memtx_hash_index<Table> *index =
+		(struct memtx_hash_index<Table> *)base;
 	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
 	if (base->def->iid == 0) {
 		/*
@@ -252,9 +498,8 @@ memtx_hash_index_destroy(struct index *base)
 		 * in the index, which may take a while. Schedule a
 		 * background task in order not to block tx thread.
 		 */
-		index->gc_task.vtab = &memtx_hash_index_gc_vtab;
-		light_index_iterator_begin(&index->hash_table,
-					   &index->gc_iterator);
+		index->gc_task.vtab = get_memtx_hash_index_gc_vtab<Table>();
+		Table::iterator_begin(&index->hash_table, &index->gc_iterator);
 		memtx_engine_schedule_gc(memtx, &index->gc_task);
 	} else {
 		/*
@@ -265,63 +510,68 @@ memtx_hash_index_destroy(struct index *base)
 	}
 }
 
+template <class Table>
 static void
 memtx_hash_index_update_def(struct index *base)
 {
-	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
+	struct memtx_hash_index<Table> *index =
+		(struct memtx_hash_index<Table> *)base;
 	index->hash_table.arg = index->base.def->key_def;
 }
 
+template <class Table>
 static ssize_t
 memtx_hash_index_size(struct index *base)
 {
-	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
+	struct memtx_hash_index<Table> *index =
+		(struct memtx_hash_index<Table> *)base;
 	struct space *space = space_by_id(base->def->space_id);
 	/* Substract invisible count. */
 	return index->hash_table.count -
 	       memtx_tx_index_invisible_count(in_txn(), space, base);
 }
 
+template <class Table>
 static ssize_t
 memtx_hash_index_bsize(struct index *base)
 {
-	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
-	return matras_extent_count(&index->hash_table.mtable) *
-					MEMTX_EXTENT_SIZE;
+	struct memtx_hash_index<Table> *index =
+		(struct memtx_hash_index<Table> *)base;
+	return Table::extent_count(&index->hash_table) * MEMTX_EXTENT_SIZE;
 }
 
+template <class Table>
 static int
 memtx_hash_index_random(struct index *base, uint32_t rnd, struct tuple **result)
 {
-	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
-	struct light_index_core *hash_table = &index->hash_table;
+	struct memtx_hash_index<Table> *index =
+		(struct memtx_hash_index<Table> *)base;
+	typename Table::core *hash_table = &index->hash_table;
 
 	*result = NULL;
 	if (hash_table->count == 0)
 		return 0;
-	rnd %= (hash_table->table_size);
-	while (!light_index_pos_valid(hash_table, rnd)) {
-		rnd++;
-		rnd %= (hash_table->table_size);
-	}
-	*result = light_index_get(hash_table, rnd);
+	*result = Table::random(hash_table, rnd);
 	return memtx_prepare_result_tuple(result);
 }
 
+template <class Table>
 static ssize_t
 memtx_hash_index_count(struct index *base, enum iterator_type type,
 		       const char *key, uint32_t part_count)
 {
 	if (type == ITER_ALL)
-		return memtx_hash_index_size(base); /* optimization */
+		return memtx_hash_index_size<Table>(base); /* optimization */
 	return generic_index_count(base, type, key, part_count);
 }
 
+template <class Table>
 static int
 memtx_hash_index_get_raw(struct index *base, const char *key,
 			 uint32_t part_count, struct tuple **result)
 {
-	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
+	struct memtx_hash_index<Table> *index =
+		(struct memtx_hash_index<Table> *)base;
 
 	assert(base->def->opts.is_unique &&
 	       part_count == base->def->key_def->part_count);
@@ -331,9 +581,8 @@ memtx_hash_index_get_raw(struct index *base, const char *key,
 	struct txn *txn = in_txn();
 	*result = NULL;
 	uint32_t h = key_hash(key, base->def->key_def);
-	uint32_t k = light_index_find_key(&index->hash_table, h, key);
-	if (k != light_index_end) {
-		struct tuple *tuple = light_index_get(&index->hash_table, k);
+	struct tuple *tuple = Table::find_key(&index->hash_table, h, key);
+	if (tuple != NULL) {
 		bool is_rw = txn != NULL;
 		*result = memtx_tx_tuple_clarify(txn, space, tuple, base,
 						 0, is_rw);
@@ -343,13 +592,15 @@ memtx_hash_index_get_raw(struct index *base, const char *key,
 	return 0;
 }
 
+template <class Table>
 static int
 memtx_hash_index_replace(struct index *base, struct tuple *old_tuple,
 			 struct tuple *new_tuple, enum dup_replace_mode mode,
 			 struct tuple **result, struct tuple **successor)
 {
-	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
-	struct light_index_core *hash_table = &index->hash_table;
+	struct memtx_hash_index<Table> *index =
+		(struct memtx_hash_index<Table> *)base;
+	typename Table::core *hash_table = &index->hash_table;
 
 	/* HASH index doesn't support ordering. */
 	*successor = NULL;
@@ -357,18 +608,15 @@ memtx_hash_index_replace(struct index *base, struct tuple *old_tuple,
 	if (new_tuple) {
 		uint32_t h = tuple_hash(new_tuple, base->def->key_def);
 		struct tuple *dup_tuple = NULL;
-		uint32_t pos = light_index_replace(hash_table, h, new_tuple,
-						   &dup_tuple);
-		if (pos == light_index_end)
-			pos = light_index_insert(hash_table, h, new_tuple);
+		int rc = Table::replace(hash_table, h, new_tuple, &dup_tuple);
 
 		ERROR_INJECT(ERRINJ_INDEX_ALLOC,
 		{
-			light_index_delete(hash_table, pos);
-			pos = light_index_end;
+			Table::delete_value(hash_table, h, new_tuple);
+			rc = -1;
 		});
 
-		if (pos == light_index_end) {
+		if (rc != 0) {
 			diag_set(OutOfMemory, (ssize_t)hash_table->count,
 				 "hash_table", "key");
 			return -1;
@@ -376,10 +624,10 @@ memtx_hash_index_replace(struct index *base, struct tuple *old_tuple,
 		uint32_t errcode = replace_check_dup(old_tuple,
 						     dup_tuple, mode);
 		if (errcode) {
-			light_index_delete(hash_table, pos);
+			Table::delete_value(hash_table, h, new_tuple);
 			if (dup_tuple) {
-				uint32_t pos = light_index_insert(hash_table, h, dup_tuple);
-				if (pos == light_index_end) {
+				if (Table::insert(hash_table, h,
+						  dup_tuple) != 0) {
 					panic("Failed to allocate memory in "
 					      "recover of int hash_table");
 				}
@@ -406,44 +654,48 @@ memtx_hash_index_replace(struct index *base, struct tuple *old_tuple,
 
 	if (old_tuple) {
 		uint32_t h = tuple_hash(old_tuple, base->def->key_def);
-		int res = light_index_delete_value(hash_table, h, old_tuple);
+		int res = Table::delete_value(hash_table, h, old_tuple);
 		assert(res == 0); (void) res;
 	}
 	*result = old_tuple;
 	return 0;
 }
 
-template <bool UNCHANGED>
+template <class Table, bool UNCHANGED>
 static struct iterator *
 memtx_hash_index_create_iterator(struct index *base, enum iterator_type type,
 				 const char *key, uint32_t part_count)
 {
-	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
+	struct memtx_hash_index<Table> *index =
+		(struct memtx_hash_index<Table> *)base;
 	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
 
 	assert(part_count == 0 || key != NULL);
 
-	struct hash_iterator *it = (struct hash_iterator *)
+	struct hash_iterator<Table> *it = (struct hash_iterator<Table> *)
 		mempool_alloc(&memtx->iterator_pool);
 	if (it == NULL) {
-		diag_set(OutOfMemory, sizeof(struct hash_iterator),
+		diag_set(OutOfMemory, sizeof(struct hash_iterator<Table>),
 			 "memtx_hash_index", "iterator");
 		return NULL;
 	}
 	iterator_create(&it->base, base);
 	it->pool = &memtx->iterator_pool;
-	it->base.free = hash_iterator_free;
-	light_index_iterator_begin(&index->hash_table, &it->iterator);
+	it->base.free = hash_iterator_free<Table>;
+	Table::iterator_begin(&index->hash_table, &it->iterator);
 
 	switch (type) {
 	case ITER_GT:
 		if (part_count != 0) {
-			light_index_iterator_key(&index->hash_table, &it->iterator,
+			Table::iterator_key(&index->hash_table, &it->iterator,
 					key_hash(key, base->def->key_def), key);
-			it->base.next_raw = hash_iterator_gt_raw<UNCHANGED>;
+			it->base.next_raw =
+				hash_iterator_gt_raw<Table, UNCHANGED>;
 		} else {
-			light_index_iterator_begin(&index->hash_table, &it->iterator);
-			it->base.next_raw = hash_iterator_ge_raw<UNCHANGED>;
+			Table::iterator_begin(&index->hash_table,
+					      &it->iterator);
+			it->base.next_raw =
+				hash_iterator_ge_raw<Table, UNCHANGED>;
 		}
 		/* This iterator needs to be supported as a legacy. */
 		memtx_tx_track_full_scan(in_txn(),
@@ -451,18 +703,18 @@ memtx_hash_index_create_iterator(struct index *base, enum iterator_type type,
 					 &index->base);
 		break;
 	case ITER_ALL:
-		light_index_iterator_begin(&index->hash_table, &it->iterator);
-		it->base.next_raw = hash_iterator_ge_raw<UNCHANGED>;
+		Table::iterator_begin(&index->hash_table, &it->iterator);
+		it->base.next_raw = hash_iterator_ge_raw<Table, UNCHANGED>;
 		memtx_tx_track_full_scan(in_txn(),
 					 space_by_id(it->base.space_id),
 					 &index->base);
 		break;
 	case ITER_EQ:
 		assert(part_count > 0);
-		light_index_iterator_key(&index->hash_table, &it->iterator,
-				key_hash(key, base->def->key_def), key);
-		it->base.next_raw = hash_iterator_raw_eq<UNCHANGED>;
-		if (it->iterator.slotpos == light_index_end)
+		it->base.next_raw = hash_iterator_raw_eq<Table, UNCHANGED>;
+		if (!Table::iterator_key(&index->hash_table, &it->iterator,
+					 key_hash(key, base->def->key_def),
+					 key))
 			memtx_tx_track_point(in_txn(),
 					     space_by_id(it->base.space_id),
 					     &index->base, key);
@@ -477,10 +729,11 @@ memtx_hash_index_create_iterator(struct index *base, enum iterator_type type,
 	return (struct iterator *)it;
 }
 
+template <class Table>
 struct hash_snapshot_iterator {
 	struct snapshot_iterator base;
-	struct memtx_hash_index *index;
-	struct light_index_iterator iterator;
+	struct memtx_hash_index<Table> *index;
+	typename Table::iterator iterator;
 	struct memtx_tx_snapshot_cleaner cleaner;
 };
 
@@ -489,15 +742,16 @@ struct hash_snapshot_iterator {
  * Virtual method of snapshot iterator.
  * @sa index_vtab::create_snapshot_iterator.
  */
+template <class Table>
 static void
 hash_snapshot_iterator_free(struct snapshot_iterator *iterator)
 {
-	assert(iterator->free == hash_snapshot_iterator_free);
-	struct hash_snapshot_iterator *it =
-		(struct hash_snapshot_iterator *) iterator;
+	assert(iterator->free == hash_snapshot_iterator_free<Table>);
+	struct hash_snapshot_iterator<Table> *it =
+		(struct hash_snapshot_iterator<Table> *) iterator;
 	memtx_leave_delayed_free_mode((struct memtx_engine *)
 				      it->index->base.engine);
-	light_index_iterator_destroy(&it->index->hash_table, &it->iterator);
+	Table::iterator_destroy(&it->index->hash_table, &it->iterator);
 	index_unref(&it->index->base);
 	memtx_tx_snapshot_cleaner_destroy(&it->cleaner);
 	free(iterator);
@@ -508,19 +762,20 @@ hash_snapshot_iterator_free(struct snapshot_iterator *iterator)
  * Virtual method of snapshot iterator.
  * @sa index_vtab::create_snapshot_iterator.
  */
+template <class Table>
 static int
 hash_snapshot_iterator_next(struct snapshot_iterator *iterator,
 			    const char **data, uint32_t *size)
 {
-	assert(iterator->free == hash_snapshot_iterator_free);
-	struct hash_snapshot_iterator *it =
-		(struct hash_snapshot_iterator *) iterator;
-	struct light_index_core *hash_table = &it->index->hash_table;
+	assert(iterator->free == hash_snapshot_iterator_free<Table>);
+	struct hash_snapshot_iterator<Table> *it =
+		(struct hash_snapshot_iterator<Table> *) iterator;
+	typename Table::core *hash_table = &it->index->hash_table;
 
 	while (true) {
 		struct tuple **res =
-			light_index_iterator_get_and_next(hash_table,
-			                                  &it->iterator);
+			Table::iterator_get_and_next(hash_table,
+						     &it->iterator);
 		if (res == NULL) {
 			*data = NULL;
 			return 0;
@@ -542,24 +797,26 @@ hash_snapshot_iterator_next(struct snapshot_iterator *iterator,
  * index modifications will not affect the iteration results.
  * Must be destroyed by iterator->free after usage.
  */
+template <class Table>
 static struct snapshot_iterator *
 memtx_hash_index_create_snapshot_iterator(struct index *base)
 {
-	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
-	struct hash_snapshot_iterator *it = (struct hash_snapshot_iterator *)
-		calloc(1, sizeof(*it));
+	struct memtx_hash_index<Table> *index =
+		(struct memtx_hash_index<Table> *)base;
+	struct hash_snapshot_iterator<Table> *it =
+		(struct hash_snapshot_iterator<Table> *)calloc(1, sizeof(*it));
 	if (it == NULL) {
-		diag_set(OutOfMemory, sizeof(struct hash_snapshot_iterator),
+		diag_set(OutOfMemory, sizeof(struct hash_snapshot_iterator<Table>),
 			 "memtx_hash_index", "iterator");
 		return NULL;
 	}
 
-	it->base.next = hash_snapshot_iterator_next;
-	it->base.free = hash_snapshot_iterator_free;
+	it->base.next = hash_snapshot_iterator_next<Table>;
+	it->base.free = hash_snapshot_iterator_free<Table>;
 	it->index = index;
 	index_ref(base);
-	light_index_iterator_begin(&index->hash_table, &it->iterator);
-	light_index_iterator_freeze(&index->hash_table, &it->iterator);
+	Table::iterator_begin(&index->hash_table, &it->iterator);
+	Table::iterator_freeze(&index->hash_table, &it->iterator);
 	memtx_enter_delayed_free_mode((struct memtx_engine *)base->engine);
 	return (struct snapshot_iterator *) it;
 }
@@ -569,34 +826,35 @@ memtx_hash_index_create_snapshot_iterator(struct index *base)
  * If UNCHANGED == true iterator->next and index->get
  * functions are the same as it's raw versions.
  */
-template <bool UNCHANGED>
+template <class Table, bool UNCHANGED>
 static const struct index_vtab *
 get_memtx_hash_index_vtab(void)
 {
 	static const struct index_vtab vtab = {
-		/* .destroy = */ memtx_hash_index_destroy,
+		/* .destroy = */ memtx_hash_index_destroy<Table>,
 		/* .commit_create = */ generic_index_commit_create,
 		/* .abort_create = */ generic_index_abort_create,
 		/* .commit_modify = */ generic_index_commit_modify,
 		/* .commit_drop = */ generic_index_commit_drop,
-		/* .update_def = */ memtx_hash_index_update_def,
+		/* .update_def = */ memtx_hash_index_update_def<Table>,
 		/* .depends_on_pk = */ generic_index_depends_on_pk,
 		/* .def_change_requires_rebuild = */
 			memtx_index_def_change_requires_rebuild,
-		/* .size = */ memtx_hash_index_size,
-		/* .bsize = */ memtx_hash_index_bsize,
+		/* .size = */ memtx_hash_index_size<Table>,
+		/* .bsize = */ memtx_hash_index_bsize<Table>,
 		/* .min = */ generic_index_min,
 		/* .max = */ generic_index_max,
-		/* .random = */ memtx_hash_index_random,
-		/* .count = */ memtx_hash_index_count,
-		/* .get_raw = */ memtx_hash_index_get_raw,
-		/* .get = */ UNCHANGED ? memtx_hash_index_get_raw :
+		/* .random = */ memtx_hash_index_random<Table>,
+		/* .count = */ memtx_hash_index_count<Table>,
+		/* .get_raw = */ memtx_hash_index_get_raw<Table>,
+		/* .get = */ UNCHANGED ? memtx_hash_index_get_raw<Table> :
 			memtx_index_get,
-		/* .replace = */ memtx_hash_index_replace,
+		/* .get_many = */ generic_index_get_many,
+		/* .replace = */ memtx_hash_index_replace<Table>,
 		/* .create_iterator = */
-			memtx_hash_index_create_iterator<UNCHANGED>,
+			memtx_hash_index_create_iterator<Table, UNCHANGED>,
 		/* .create_snapshot_iterator = */
-			memtx_hash_index_create_snapshot_iterator,
+			memtx_hash_index_create_snapshot_iterator<Table>,
 		/* .stat = */ generic_index_stat,
 		/* .compact = */ generic_index_compact,
 		/* .reset_stat = */ generic_index_reset_stat,
@@ -611,43 +869,58 @@ get_memtx_hash_index_vtab(void)
 /**
  * Get index vtab by @a unchanged, argument version.
  */
+template <class Table>
 static const struct index_vtab *
 get_memtx_hash_index_vtab(bool unchanged)
 {
 	static const index_vtab *choice[2] = {
-		get_memtx_hash_index_vtab<false>(),
-		get_memtx_hash_index_vtab<true>()
+		get_memtx_hash_index_vtab<Table, false>(),
+		get_memtx_hash_index_vtab<Table, true>()
 	};
 	return choice[unchanged];
 }
 
-struct index *
-memtx_hash_index_new(struct memtx_engine *memtx, struct index_def *def)
+template <class Table>
+static struct index *
+memtx_hash_index_create(struct memtx_engine *memtx, struct index_def *def)
 {
-	struct memtx_hash_index *index =
-		(struct memtx_hash_index *)calloc(1, sizeof(*index));
+	struct memtx_hash_index<Table> *index =
+		(struct memtx_hash_index<Table> *)calloc(1, sizeof(*index));
 	if (index == NULL) {
 		diag_set(OutOfMemory, sizeof(*index),
 			 "malloc", "struct memtx_hash_index");
 		return NULL;
 	}
-	const struct index_vtab *vtab = get_memtx_hash_index_vtab(true);
+	const struct index_vtab *vtab = get_memtx_hash_index_vtab<Table>(true);
 	if (index_create(&index->base, (struct engine *)memtx,
 			 vtab, def) != 0) {
 		free(index);
 		return NULL;
 	}
 
-	light_index_create(&index->hash_table, MEMTX_EXTENT_SIZE,
-			   memtx_index_extent_alloc, memtx_index_extent_free,
-			   memtx, index->base.def->key_def);
+	Table::create(&index->hash_table, memtx, index->base.def->key_def);
 	return &index->base;
 }
 
+struct index *
+memtx_hash_index_new(struct memtx_engine *memtx, struct index_def *def)
+{
+	if (memtx->use_swiss_hash)
+		return memtx_hash_index_create<memtx_swiss_table>(memtx, def);
+	return memtx_hash_index_create<memtx_light_table>(memtx, def);
+}
+
 void
 memtx_hash_index_set_vtab(struct index *index, bool unchanged)
 {
-	index->vtab = get_memtx_hash_index_vtab(unchanged);
+	if (index->vtab->destroy ==
+	    memtx_hash_index_destroy<memtx_swiss_table>) {
+		index->vtab =
+			get_memtx_hash_index_vtab<memtx_swiss_table>(unchanged);
+	} else {
+		index->vtab =
+			get_memtx_hash_index_vtab<memtx_light_table>(unchanged);
+	}
 }
 
 /* }}} */
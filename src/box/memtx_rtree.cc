@@ -399,6 +399,7 @@ get_memtx_rtree_index_vtab(void)
 		/* .get_raw = */ memtx_rtree_index_get_raw,
 		/* .get = */ UNCHANGED ? memtx_rtree_index_get_raw :
 			memtx_index_get,
+		/* .get_many = */ generic_index_get_many,
 		/* .replace = */ memtx_rtree_index_replace,
 		/* .create_iterator = */
 			memtx_rtree_index_create_iterator<UNCHANGED>,
@@ -45,6 +45,8 @@
 #include "sequence.h"
 #include "memtx_tuple_compression.h"
 #include "schema.h"
+#include "info/info.h"
+#include "session.h"
 
 /*
  * Yield every 1K tuples while building a new index or checking
@@ -75,6 +77,94 @@ memtx_space_bsize(struct space *space)
 	return memtx_space->bsize;
 }
 
+size_t
+memtx_space_memory(struct space *space)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	size_t total = memtx_space->tuple_memory;
+	for (uint32_t i = 0; i < space->index_count; i++)
+		total += index_bsize(space->index[i]);
+	return total;
+}
+
+static void
+memtx_space_stat(struct space *space, struct info_handler *h)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	size_t index_memory = 0;
+	for (uint32_t i = 0; i < space->index_count; i++)
+		index_memory += index_bsize(space->index[i]);
+	info_begin(h);
+	info_append_int(h, "bsize", memtx_space->bsize);
+	info_table_begin(h, "memory");
+	info_append_int(h, "tuples_estimate", memtx_space->tuple_memory);
+	info_append_int(h, "indexes", index_memory);
+	info_append_int(h, "total_estimate",
+			memtx_space->tuple_memory + index_memory);
+	info_append_int(h, "quota", space->def->opts.memory_quota);
+	info_table_end(h);
+	info_end(h);
+}
+
+/**
+ * Check that replacing @a old_tuple with @a new_tuple doesn't
+ * make a space exceed its memory quota. @a old_tuple must be
+ * the tuple actually replaced in the primary key, if any.
+ * The check is approximate: tuple sizes are estimated with
+ * memtx_tuple_size() and index extents allocated for the new
+ * tuple aren't taken into account.
+ * Tuples inserted by transactions that are not committed yet
+ * aren't accounted when the transaction manager is enabled, so
+ * the quota may be exceeded by the size of in-progress
+ * transactions.
+ */
+static int
+memtx_space_check_memory_quota(struct space *space, struct tuple *old_tuple,
+			       struct tuple *new_tuple)
+{
+	int64_t quota = space->def->opts.memory_quota;
+	if (quota == 0 || new_tuple == NULL)
+		return 0;
+	/*
+	 * Rows recovered from disk or received from a replication
+	 * peer have already been applied elsewhere and must not
+	 * be rejected.
+	 */
+	if (memtx_space_is_recovering(space))
+		return 0;
+	struct session *session = fiber_get_session(fiber());
+	if (session != NULL && session->type == SESSION_TYPE_APPLIER)
+		return 0;
+	size_t new_size = memtx_tuple_size(new_tuple);
+	size_t old_size = old_tuple != NULL ? memtx_tuple_size(old_tuple) : 0;
+	if (new_size <= old_size ||
+	    memtx_space_memory(space) + new_size - old_size <= (size_t)quota)
+		return 0;
+	diag_set(ClientError, ER_SPACE_MEMORY_QUOTA, (unsigned)new_size,
+		 space_name(space), (unsigned long long)quota);
+	return -1;
+}
+
+/**
+ * Find the tuple that @a new_tuple would replace in the primary
+ * key @a pk. Sets @a result to NULL if there's no such tuple.
+ */
+static int
+memtx_space_find_replaced(struct index *pk, struct tuple *new_tuple,
+			  struct tuple **result)
+{
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	const char *key = tuple_extract_key(new_tuple, pk->def->key_def,
+					    MULTIKEY_NONE, NULL);
+	if (key == NULL)
+		return -1;
+	uint32_t part_count = mp_decode_array(&key);
+	int rc = index_get_raw(pk, key, part_count, result);
+	region_truncate(region, region_svp);
+	return rc;
+}
+
 /* {{{ DML */
 
 void
@@ -89,6 +179,20 @@ memtx_space_update_bsize(struct space *space, struct tuple *old_tuple,
 	memtx_space->bsize += new_bsize - old_bsize;
 }
 
+void
+memtx_space_update_tuple_memory(struct space *space, struct tuple *old_tuple,
+				struct tuple *new_tuple)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	if (old_tuple != NULL) {
+		assert(memtx_space->tuple_memory >=
+		       memtx_tuple_size(old_tuple));
+		memtx_space->tuple_memory -= memtx_tuple_size(old_tuple);
+	}
+	if (new_tuple != NULL)
+		memtx_space->tuple_memory += memtx_tuple_size(new_tuple);
+}
+
 void
 memtx_space_update_compressed_tuples(struct space *space,
 				     struct tuple *old_tuple,
@@ -150,6 +254,7 @@ memtx_space_replace_build_next(struct space *space, struct tuple *old_tuple,
 	if (index_build_next(space->index[0], new_tuple) != 0)
 		return -1;
 	memtx_space_update_bsize(space, NULL, new_tuple);
+	memtx_space_update_tuple_memory(space, NULL, new_tuple);
 	memtx_space_update_compressed_tuples(space, NULL, new_tuple);
 	tuple_ref(new_tuple);
 	return 0;
@@ -170,6 +275,7 @@ memtx_space_replace_primary_key(struct space *space, struct tuple *old_tuple,
 			  new_tuple, mode, &old_tuple, &successor) != 0)
 		return -1;
 	memtx_space_update_bsize(space, old_tuple, new_tuple);
+	memtx_space_update_tuple_memory(space, old_tuple, new_tuple);
 	memtx_space_update_compressed_tuples(space, old_tuple, new_tuple);
 	if (new_tuple != NULL)
 		tuple_ref(new_tuple);
@@ -299,6 +405,19 @@ memtx_space_replace_all_keys(struct space *space, struct tuple *old_tuple,
 	 */
 	if (memtx_tx_manager_use_mvcc_engine && !space->def->opts.is_ephemeral) {
 		struct txn_stmt *stmt = txn_current_stmt(in_txn());
+		/*
+		 * The transaction manager doesn't report the replaced
+		 * tuple until the statement is added, so look it up
+		 * to check the memory quota.
+		 */
+		struct tuple *replaced = old_tuple;
+		if (replaced == NULL && new_tuple != NULL &&
+		    mode != DUP_INSERT && space->def->opts.memory_quota != 0 &&
+		    memtx_space_find_replaced(pk, new_tuple, &replaced) != 0)
+			return -1;
+		if (memtx_space_check_memory_quota(space, replaced,
+						   new_tuple) != 0)
+			return -1;
 		return memtx_tx_history_add_stmt(stmt, old_tuple, new_tuple,
 						 mode, result);
 	}
@@ -312,9 +431,14 @@ memtx_space_replace_all_keys(struct space *space, struct tuple *old_tuple,
 			  &old_tuple, &successor) != 0)
 		return -1;
 	assert(old_tuple || new_tuple);
+	i++;
+
+	/* The replaced tuple is known only now. */
+	if (memtx_space_check_memory_quota(space, old_tuple, new_tuple) != 0)
+		goto rollback;
 
 	/* Update secondary keys. */
-	for (i++; i < space->index_count; i++) {
+	for (; i < space->index_count; i++) {
 		struct tuple *unused;
 		struct index *index = space->index[i];
 		if (index_replace(index, old_tuple, new_tuple,
@@ -323,6 +447,7 @@ memtx_space_replace_all_keys(struct space *space, struct tuple *old_tuple,
 	}
 
 	memtx_space_update_bsize(space, old_tuple, new_tuple);
+	memtx_space_update_tuple_memory(space, old_tuple, new_tuple);
 	memtx_space_update_compressed_tuples(space, old_tuple, new_tuple);
 	if (new_tuple != NULL)
 		tuple_ref(new_tuple);
@@ -1101,6 +1226,7 @@ memtx_space_drop_primary_key(struct space *space)
 	 */
 	memtx_space->replace = memtx_space_replace_no_keys;
 	memtx_space->bsize = 0;
+	memtx_space->tuple_memory = 0;
 	memtx_space->compressed_tuples = 0;
 }
 
@@ -1418,6 +1544,7 @@ memtx_space_prepare_alter(struct space *old_space, struct space *new_space)
 
 	new_memtx_space->replace = old_memtx_space->replace;
 	new_memtx_space->bsize = old_memtx_space->bsize;
+	new_memtx_space->tuple_memory = old_memtx_space->tuple_memory;
 	new_memtx_space->compressed_tuples = old_memtx_space->compressed_tuples;
 	return 0;
 }
@@ -1427,6 +1554,7 @@ memtx_space_prepare_alter(struct space *old_space, struct space *new_space)
 static const struct space_vtab memtx_space_vtab = {
 	/* .destroy = */ memtx_space_destroy,
 	/* .bsize = */ memtx_space_bsize,
+	/* .stat = */ memtx_space_stat,
 	/* .execute_replace = */ memtx_space_execute_replace,
 	/* .execute_delete = */ memtx_space_execute_delete,
 	/* .execute_update = */ memtx_space_execute_update,
@@ -1487,6 +1615,7 @@ memtx_space_new(struct memtx_engine *memtx,
 	tuple_format_unref(format);
 
 	memtx_space->bsize = 0;
+	memtx_space->tuple_memory = 0;
 	memtx_space->rowid = 0;
 	memtx_space->compressed_tuples = 0;
 	memtx_space->replace = memtx_space_replace_no_keys;
@@ -43,6 +43,12 @@ struct memtx_space {
 	struct space base;
 	/* Number of bytes used in memory by tuples in the space. */
 	size_t bsize;
+	/**
+	 * Estimated number of bytes allocated for tuples in the
+	 * space, see memtx_tuple_size(). Accounted against the space
+	 * memory quota, see space_opts::memory_quota.
+	 */
+	size_t tuple_memory;
 	/**
 	 * This counter is used to generate unique ids for
 	 * ephemeral spaces. Mostly used by SQL: values of this
@@ -73,6 +79,26 @@ void
 memtx_space_update_bsize(struct space *space, struct tuple *old_tuple,
 			 struct tuple *new_tuple);
 
+/**
+ * Change the estimated amount of memory allocated for tuples in
+ * a space subtracting old tuple's size and adding new tuple's
+ * size. Used also for rollback by swapping old and new tuple.
+ *
+ * @param space Instance of memtx space.
+ * @param old_tuple Old tuple (replaced or deleted).
+ * @param new_tuple New tuple (inserted).
+ */
+void
+memtx_space_update_tuple_memory(struct space *space, struct tuple *old_tuple,
+				struct tuple *new_tuple);
+
+/**
+ * Return the number of bytes used by a memtx space in memory:
+ * tuples and index extents.
+ */
+size_t
+memtx_space_memory(struct space *space);
+
 /**
  * Undate count of compressed tuples in @a space. If @a old_tuple
  * is compressed wwe decrement count of compressed tuples. If @a
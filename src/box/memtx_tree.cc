@@ -140,6 +140,34 @@ memtx_tree_data_is_equal(const struct memtx_tree_data_common *a,
 #undef bps_tree_elem_t
 #undef bps_tree_key_t
 
+/*
+ * Trees of indexes with the fast_offset option keep the number of
+ * elements in each subtree, see BPS_INNER_CARD.
+ */
+#define BPS_INNER_CARD
+
+#define BPS_TREE_NAMESPACE NS_NO_HINT_FAST_OFFSET
+#define bps_tree_elem_t struct memtx_tree_data<false>
+#define bps_tree_key_t struct memtx_tree_key_data<false> *
+
+#include "salad/bps_tree.h"
+
+#undef BPS_TREE_NAMESPACE
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
+
+#define BPS_TREE_NAMESPACE NS_USE_HINT_FAST_OFFSET
+#define bps_tree_elem_t struct memtx_tree_data<true>
+#define bps_tree_key_t struct memtx_tree_key_data<true> *
+
+#include "salad/bps_tree.h"
+
+#undef BPS_TREE_NAMESPACE
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
+
+#undef BPS_INNER_CARD
+
 #undef BPS_TREE_NAME
 #undef BPS_TREE_BLOCK_SIZE
 #undef BPS_TREE_EXTENT_SIZE
@@ -151,34 +179,53 @@ memtx_tree_data_is_equal(const struct memtx_tree_data_common *a,
 
 using namespace NS_NO_HINT;
 using namespace NS_USE_HINT;
+using namespace NS_NO_HINT_FAST_OFFSET;
+using namespace NS_USE_HINT_FAST_OFFSET;
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 struct memtx_tree_selector;
 
 template <>
-struct memtx_tree_selector<false> : NS_NO_HINT::memtx_tree {};
+struct memtx_tree_selector<false, false> : NS_NO_HINT::memtx_tree {};
 
 template <>
-struct memtx_tree_selector<true> : NS_USE_HINT::memtx_tree {};
+struct memtx_tree_selector<true, false> : NS_USE_HINT::memtx_tree {};
 
-template <bool USE_HINT>
-using memtx_tree_t = struct memtx_tree_selector<USE_HINT>;
+template <>
+struct memtx_tree_selector<false, true> : NS_NO_HINT_FAST_OFFSET::memtx_tree {};
 
-template <bool USE_HINT>
+template <>
+struct memtx_tree_selector<true, true> : NS_USE_HINT_FAST_OFFSET::memtx_tree {};
+
+template <bool USE_HINT, bool FAST_OFFSET>
+using memtx_tree_t = struct memtx_tree_selector<USE_HINT, FAST_OFFSET>;
+
+template <bool USE_HINT, bool FAST_OFFSET>
 struct memtx_tree_iterator_selector;
 
 template <>
-struct memtx_tree_iterator_selector<false> {
+struct memtx_tree_iterator_selector<false, false> {
 	using type = NS_NO_HINT::memtx_tree_iterator;
 };
 
 template <>
-struct memtx_tree_iterator_selector<true> {
+struct memtx_tree_iterator_selector<true, false> {
 	using type = NS_USE_HINT::memtx_tree_iterator;
 };
 
-template <bool USE_HINT>
-using memtx_tree_iterator_t = typename memtx_tree_iterator_selector<USE_HINT>::type;
+template <>
+struct memtx_tree_iterator_selector<false, true> {
+	using type = NS_NO_HINT_FAST_OFFSET::memtx_tree_iterator;
+};
+
+template <>
+struct memtx_tree_iterator_selector<true, true> {
+	using type = NS_USE_HINT_FAST_OFFSET::memtx_tree_iterator;
+};
+
+template <bool USE_HINT, bool FAST_OFFSET>
+using memtx_tree_iterator_t =
+	typename memtx_tree_iterator_selector<USE_HINT, FAST_OFFSET>::type;
 
 static void
 invalidate_tree_iterator(NS_NO_HINT::memtx_tree_iterator *itr)
@@ -192,14 +239,32 @@ invalidate_tree_iterator(NS_USE_HINT::memtx_tree_iterator *itr)
 	*itr = NS_USE_HINT::memtx_tree_invalid_iterator();
 }
 
-template <bool USE_HINT>
+static void
+invalidate_tree_iterator(NS_NO_HINT_FAST_OFFSET::memtx_tree_iterator *itr)
+{
+	*itr = NS_NO_HINT_FAST_OFFSET::memtx_tree_invalid_iterator();
+}
+
+static void
+invalidate_tree_iterator(NS_USE_HINT_FAST_OFFSET::memtx_tree_iterator *itr)
+{
+	*itr = NS_USE_HINT_FAST_OFFSET::memtx_tree_invalid_iterator();
+}
+
+template <bool USE_HINT, bool FAST_OFFSET>
 struct memtx_tree_index {
 	struct index base;
-	memtx_tree_t<USE_HINT> tree;
+	memtx_tree_t<USE_HINT, FAST_OFFSET> tree;
 	struct memtx_tree_data<USE_HINT> *build_array;
 	size_t build_array_size, build_array_alloc_size;
+	/**
+	 * Set if build_array has already been sorted by
+	 * memtx_tree_index_sort_build_array() so that end_build
+	 * may skip sorting.
+	 */
+	bool is_build_array_sorted;
 	struct memtx_gc_task gc_task;
-	memtx_tree_iterator_t<USE_HINT> gc_iterator;
+	memtx_tree_iterator_t<USE_HINT, FAST_OFFSET> gc_iterator;
 };
 
 /* {{{ Utilities. *************************************************/
@@ -225,7 +290,7 @@ memtx_tree_qcompare(const void* a, const void *b, void *c)
 }
 
 /* {{{ MemtxTree Iterators ****************************************/
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 struct tree_iterator {
 	struct iterator base;
 
@@ -249,7 +314,7 @@ struct tree_iterator {
 	 * One need not care about the iterator's position: it will
 	 * automatically get adjusted on iterator->next call.
 	 */
-	memtx_tree_iterator_t<USE_HINT> tree_iterator;
+	memtx_tree_iterator_t<USE_HINT, FAST_OFFSET> tree_iterator;
 	enum iterator_type type;
 	struct memtx_tree_key_data<USE_HINT> key_data;
 	struct memtx_tree_data<USE_HINT> current;
@@ -268,16 +333,16 @@ struct tree_iterator {
 	struct mempool *pool;
 };
 
-static_assert(sizeof(struct tree_iterator<false>) <= MEMTX_ITERATOR_SIZE,
-	      "sizeof(struct tree_iterator<false>) must be less than or equal "
-	      "to MEMTX_ITERATOR_SIZE");
-static_assert(sizeof(struct tree_iterator<true>) <= MEMTX_ITERATOR_SIZE,
-	      "sizeof(struct tree_iterator<true>) must be less than or equal "
-	      "to MEMTX_ITERATOR_SIZE");
+static_assert(sizeof(struct tree_iterator<false, false>) <= MEMTX_ITERATOR_SIZE,
+	      "sizeof(struct tree_iterator<false, false>) must be less than or "
+	      "equal to MEMTX_ITERATOR_SIZE");
+static_assert(sizeof(struct tree_iterator<true, true>) <= MEMTX_ITERATOR_SIZE,
+	      "sizeof(struct tree_iterator<true, true>) must be less than or "
+	      "equal to MEMTX_ITERATOR_SIZE");
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static inline void
-tree_iterator_set_current_tuple(struct tree_iterator<USE_HINT> *it,
+tree_iterator_set_current_tuple(struct tree_iterator<USE_HINT, FAST_OFFSET> *it,
 				struct tuple *tuple)
 {
 	if (it->current.tuple != NULL)
@@ -287,9 +352,10 @@ tree_iterator_set_current_tuple(struct tree_iterator<USE_HINT> *it,
 		tuple_ref(tuple);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static inline void
-tree_iterator_set_current_hint(struct tree_iterator<USE_HINT> *it, hint_t hint)
+tree_iterator_set_current_hint(struct tree_iterator<USE_HINT, FAST_OFFSET> *it,
+			       hint_t hint)
 {
 	if (!USE_HINT)
 		return;
@@ -312,9 +378,9 @@ tree_iterator_set_current_hint(struct tree_iterator<USE_HINT> *it, hint_t hint)
 	it->current.set_hint(hint);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static inline void
-tree_iterator_set_current(struct tree_iterator<USE_HINT> *it,
+tree_iterator_set_current(struct tree_iterator<USE_HINT, FAST_OFFSET> *it,
 			  struct memtx_tree_data<USE_HINT> *cur)
 {
 	if (cur != NULL) {
@@ -326,24 +392,25 @@ tree_iterator_set_current(struct tree_iterator<USE_HINT> *it,
 	}
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static void
 tree_iterator_free(struct iterator *iterator);
 
-template <bool USE_HINT>
-static inline struct tree_iterator<USE_HINT> *
+template <bool USE_HINT, bool FAST_OFFSET>
+static inline struct tree_iterator<USE_HINT, FAST_OFFSET> *
 get_tree_iterator(struct iterator *it)
 {
-	assert(it->free == &tree_iterator_free<USE_HINT>);
-	return (struct tree_iterator<USE_HINT> *) it;
+	assert((it->free == &tree_iterator_free<USE_HINT, FAST_OFFSET>));
+	return (struct tree_iterator<USE_HINT, FAST_OFFSET> *) it;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static void
 tree_iterator_free(struct iterator *iterator)
 {
-	struct tree_iterator<USE_HINT> *it = get_tree_iterator<USE_HINT>(iterator);
-	tree_iterator_set_current<USE_HINT>(it, NULL);
+	struct tree_iterator<USE_HINT, FAST_OFFSET> *it =
+		get_tree_iterator<USE_HINT, FAST_OFFSET>(iterator);
+	tree_iterator_set_current<USE_HINT, FAST_OFFSET>(it, NULL);
 	mempool_free(it->pool, it);
 }
 
@@ -364,13 +431,15 @@ tree_iterator_set_dummie(struct iterator *iterator)
 		iterator->next = tree_iterator_dummie;
 }
 
-template <bool UNCHANGED, bool USE_HINT>
+template <bool UNCHANGED, bool USE_HINT, bool FAST_OFFSET>
 static int
 tree_iterator_next_raw_base(struct iterator *iterator, struct tuple **ret)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)iterator->index;
-	struct tree_iterator<USE_HINT> *it = get_tree_iterator<USE_HINT>(iterator);
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)
+		iterator->index;
+	struct tree_iterator<USE_HINT, FAST_OFFSET> *it =
+		get_tree_iterator<USE_HINT, FAST_OFFSET>(iterator);
 	assert(it->current.tuple != NULL);
 	struct memtx_tree_data<USE_HINT> *check =
 		memtx_tree_iterator_get_elem(&index->tree, &it->tree_iterator);
@@ -382,7 +451,7 @@ tree_iterator_next_raw_base(struct iterator *iterator, struct tuple **ret)
 	}
 	struct memtx_tree_data<USE_HINT> *res =
 		memtx_tree_iterator_get_elem(&index->tree, &it->tree_iterator);
-	tree_iterator_set_current<USE_HINT>(it, res);
+	tree_iterator_set_current<USE_HINT, FAST_OFFSET>(it, res);
 	*ret = it->current.tuple;
 	if (*ret == NULL)
 		tree_iterator_set_dummie<UNCHANGED>(iterator);
@@ -400,13 +469,15 @@ tree_iterator_next_raw_base(struct iterator *iterator, struct tuple **ret)
 	return 0;
 }
 
-template <bool UNCHANGED, bool USE_HINT>
+template <bool UNCHANGED, bool USE_HINT, bool FAST_OFFSET>
 static int
 tree_iterator_prev_raw_base(struct iterator *iterator, struct tuple **ret)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)iterator->index;
-	struct tree_iterator<USE_HINT> *it = get_tree_iterator<USE_HINT>(iterator);
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)
+		iterator->index;
+	struct tree_iterator<USE_HINT, FAST_OFFSET> *it =
+		get_tree_iterator<USE_HINT, FAST_OFFSET>(iterator);
 	assert(it->current.tuple != NULL);
 	struct memtx_tree_data<USE_HINT> *check =
 		memtx_tree_iterator_get_elem(&index->tree, &it->tree_iterator);
@@ -419,7 +490,7 @@ tree_iterator_prev_raw_base(struct iterator *iterator, struct tuple **ret)
 	tuple_ref(successor);
 	struct memtx_tree_data<USE_HINT> *res =
 		memtx_tree_iterator_get_elem(&index->tree, &it->tree_iterator);
-	tree_iterator_set_current<USE_HINT>(it, res);
+	tree_iterator_set_current<USE_HINT, FAST_OFFSET>(it, res);
 	*ret = it->current.tuple;
 	if (*ret == NULL)
 		tree_iterator_set_dummie<UNCHANGED>(iterator);
@@ -438,13 +509,15 @@ tree_iterator_prev_raw_base(struct iterator *iterator, struct tuple **ret)
 	return 0;
 }
 
-template <bool UNCHANGED, bool USE_HINT>
+template <bool UNCHANGED, bool USE_HINT, bool FAST_OFFSET>
 static int
 tree_iterator_next_equal_raw_base(struct iterator *iterator, struct tuple **ret)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)iterator->index;
-	struct tree_iterator<USE_HINT> *it = get_tree_iterator<USE_HINT>(iterator);
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)
+		iterator->index;
+	struct tree_iterator<USE_HINT, FAST_OFFSET> *it =
+		get_tree_iterator<USE_HINT, FAST_OFFSET>(iterator);
 	assert(it->current.tuple != NULL);
 	struct memtx_tree_data<USE_HINT> *check =
 		memtx_tree_iterator_get_elem(&index->tree, &it->tree_iterator);
@@ -465,7 +538,7 @@ tree_iterator_next_equal_raw_base(struct iterator *iterator, struct tuple **ret)
 				   it->key_data.part_count,
 				   it->key_data.hint,
 				   index->base.def->key_def) != 0) {
-		tree_iterator_set_current<USE_HINT>(it, NULL);
+		tree_iterator_set_current<USE_HINT, FAST_OFFSET>(it, NULL);
 		tree_iterator_set_dummie<UNCHANGED>(iterator);
 		*ret = NULL;
 		/*
@@ -479,7 +552,7 @@ tree_iterator_next_equal_raw_base(struct iterator *iterator, struct tuple **ret)
 				   it->key_data.key, it->key_data.part_count);
 /*********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND END**********/
 	} else {
-		tree_iterator_set_current<USE_HINT>(it, res);
+		tree_iterator_set_current<USE_HINT, FAST_OFFSET>(it, res);
 		*ret = res->tuple;
 
 /********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND START*********/
@@ -494,13 +567,15 @@ tree_iterator_next_equal_raw_base(struct iterator *iterator, struct tuple **ret)
 	return 0;
 }
 
-template <bool UNCHANGED, bool USE_HINT>
+template <bool UNCHANGED, bool USE_HINT, bool FAST_OFFSET>
 static int
 tree_iterator_prev_equal_raw_base(struct iterator *iterator, struct tuple **ret)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)iterator->index;
-	struct tree_iterator<USE_HINT> *it = get_tree_iterator<USE_HINT>(iterator);
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)
+		iterator->index;
+	struct tree_iterator<USE_HINT, FAST_OFFSET> *it =
+		get_tree_iterator<USE_HINT, FAST_OFFSET>(iterator);
 	assert(it->current.tuple != NULL);
 	struct memtx_tree_data<USE_HINT> *check =
 		memtx_tree_iterator_get_elem(&index->tree, &it->tree_iterator);
@@ -522,7 +597,7 @@ tree_iterator_prev_equal_raw_base(struct iterator *iterator, struct tuple **ret)
 				   it->key_data.part_count,
 				   it->key_data.hint,
 				   index->base.def->key_def) != 0) {
-		tree_iterator_set_current<USE_HINT>(it, NULL);
+		tree_iterator_set_current<USE_HINT, FAST_OFFSET>(it, NULL);
 		tree_iterator_set_dummie<UNCHANGED>(iterator);
 		*ret = NULL;
 
@@ -535,7 +610,7 @@ tree_iterator_prev_equal_raw_base(struct iterator *iterator, struct tuple **ret)
 				   it->key_data.key, it->key_data.part_count);
 /*********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND END**********/
 	} else {
-		tree_iterator_set_current<USE_HINT>(it, res);
+		tree_iterator_set_current<USE_HINT, FAST_OFFSET>(it, res);
 		*ret = res->tuple;
 
 /********MVCC TRANSACTION MANAGER STORY GARBAGE COLLECTION BOUND START*********/
@@ -552,22 +627,25 @@ tree_iterator_prev_equal_raw_base(struct iterator *iterator, struct tuple **ret)
 }
 
 #define WRAP_ITERATOR_METHOD(name)						\
-template <bool UNCHANGED, bool USE_HINT>					\
+template <bool UNCHANGED, bool USE_HINT, bool FAST_OFFSET>			\
 static int									\
 name(struct iterator *iterator, struct tuple **ret)				\
 {										\
-	memtx_tree_t<USE_HINT> *tree =						\
-		&((struct memtx_tree_index<USE_HINT> *)iterator->index)->tree;	\
-	struct tree_iterator<USE_HINT> *it =   					\
-		get_tree_iterator<USE_HINT>(iterator);				\
-	memtx_tree_iterator_t<USE_HINT> *ti = &it->tree_iterator;		\
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =			\
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)		\
+		iterator->index;						\
+	memtx_tree_t<USE_HINT, FAST_OFFSET> *tree = &index->tree;		\
+	struct tree_iterator<USE_HINT, FAST_OFFSET> *it =			\
+		get_tree_iterator<USE_HINT, FAST_OFFSET>(iterator);		\
+	memtx_tree_iterator_t<USE_HINT, FAST_OFFSET> *ti = &it->tree_iterator;	\
 	struct index *idx = iterator->index;					\
 	bool is_multikey = iterator->index->def->key_def->is_multikey;		\
 	struct txn *txn = in_txn();						\
 	struct space *space = space_by_id(iterator->space_id);			\
 	bool is_rw = txn != NULL;						\
 	do {									\
-		int rc = name##_base<UNCHANGED, USE_HINT>(iterator, ret);	\
+		int rc = name##_base<UNCHANGED, USE_HINT, FAST_OFFSET>(		\
+				iterator, ret);					\
 		if (rc != 0 || *ret == NULL)					\
 			return rc;						\
 		uint32_t mk_index = 0;						\
@@ -592,33 +670,38 @@ WRAP_ITERATOR_METHOD(tree_iterator_prev_equal_raw);
 
 #undef WRAP_ITERATOR_METHOD
 
-template <bool UNCHANGED, bool USE_HINT>
+template <bool UNCHANGED, bool USE_HINT, bool FAST_OFFSET>
 static void
-tree_iterator_set_next_method(struct tree_iterator<USE_HINT> *it)
+tree_iterator_set_next_method(struct tree_iterator<USE_HINT, FAST_OFFSET> *it)
 {
 	assert(it->current.tuple != NULL);
 	switch (it->type) {
 	case ITER_EQ:
 		it->base.next_raw =
-			tree_iterator_next_equal_raw<UNCHANGED, USE_HINT>;
+			tree_iterator_next_equal_raw<UNCHANGED, USE_HINT,
+						     FAST_OFFSET>;
 		break;
 	case ITER_REQ:
 		it->base.next_raw =
-			tree_iterator_prev_equal_raw<UNCHANGED, USE_HINT>;
+			tree_iterator_prev_equal_raw<UNCHANGED, USE_HINT,
+						     FAST_OFFSET>;
 		break;
 	case ITER_ALL:
 		it->base.next_raw =
-			tree_iterator_next_raw<UNCHANGED, USE_HINT>;
+			tree_iterator_next_raw<UNCHANGED, USE_HINT,
+					       FAST_OFFSET>;
 		break;
 	case ITER_LT:
 	case ITER_LE:
 		it->base.next_raw =
-			tree_iterator_prev_raw<UNCHANGED, USE_HINT>;
+			tree_iterator_prev_raw<UNCHANGED, USE_HINT,
+					       FAST_OFFSET>;
 		break;
 	case ITER_GE:
 	case ITER_GT:
 		it->base.next_raw =
-			tree_iterator_next_raw<UNCHANGED, USE_HINT>;
+			tree_iterator_next_raw<UNCHANGED, USE_HINT,
+					       FAST_OFFSET>;
 		break;
 	default:
 		/* The type was checked in initIterator */
@@ -628,16 +711,18 @@ tree_iterator_set_next_method(struct tree_iterator<USE_HINT> *it)
 			it->base.next_raw : memtx_iterator_next;
 }
 
-template <bool UNCHANGED, bool USE_HINT>
+template <bool UNCHANGED, bool USE_HINT, bool FAST_OFFSET>
 static int
 tree_iterator_start_raw(struct iterator *iterator, struct tuple **ret)
 {
 	*ret = NULL;
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)iterator->index;
-	struct tree_iterator<USE_HINT> *it = get_tree_iterator<USE_HINT>(iterator);
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)
+		iterator->index;
+	struct tree_iterator<USE_HINT, FAST_OFFSET> *it =
+		get_tree_iterator<USE_HINT, FAST_OFFSET>(iterator);
 	tree_iterator_set_dummie<UNCHANGED>(iterator);
-	memtx_tree_t<USE_HINT> *tree = &index->tree;
+	memtx_tree_t<USE_HINT, FAST_OFFSET> *tree = &index->tree;
 	enum iterator_type type = it->type;
 	struct txn *txn = in_txn();
 	struct space *space = space_by_id(iterator->space_id);
@@ -738,20 +823,161 @@ tree_iterator_start_raw(struct iterator *iterator, struct tuple **ret)
 	return 0;
 }
 
+/**
+ * Find the range [*begin, *end) of positions of the tree elements
+ * visited by an iterator of type @a type with key @a key_data.
+ * The positions are computed in O(log n) in trees of indexes with
+ * the fast_offset option.
+ */
+template <bool USE_HINT, bool FAST_OFFSET>
+static void
+memtx_tree_index_offset_range(memtx_tree_t<USE_HINT, FAST_OFFSET> *tree,
+			      enum iterator_type type,
+			      struct memtx_tree_key_data<USE_HINT> *key_data,
+			      size_t *begin, size_t *end)
+{
+	*begin = 0;
+	*end = memtx_tree_size(tree);
+	if (key_data->key == NULL)
+		return;
+	switch (type) {
+	case ITER_EQ:
+	case ITER_REQ:
+		memtx_tree_lower_bound_get_offset(tree, key_data, NULL, begin);
+		memtx_tree_upper_bound_get_offset(tree, key_data, NULL, end);
+		break;
+	case ITER_ALL:
+	case ITER_GE:
+		memtx_tree_lower_bound_get_offset(tree, key_data, NULL, begin);
+		break;
+	case ITER_GT:
+		memtx_tree_upper_bound_get_offset(tree, key_data, NULL, begin);
+		break;
+	case ITER_LT:
+		memtx_tree_lower_bound_get_offset(tree, key_data, NULL, end);
+		break;
+	case ITER_LE:
+		memtx_tree_upper_bound_get_offset(tree, key_data, NULL, end);
+		break;
+	default:
+		unreachable();
+	}
+}
+
+/**
+ * Implementation of iterator::skip for indexes with the fast_offset
+ * option: instead of stepping over @a count tuples one by one, find
+ * the position of the last skipped one by its offset in the tree.
+ * Only used when the MVCC engine is off, since otherwise some tuples
+ * may be invisible and must not be counted.
+ */
+template <bool UNCHANGED, bool USE_HINT, bool FAST_OFFSET>
+static int
+tree_iterator_skip(struct iterator *iterator, uint32_t count)
+{
+	assert(FAST_OFFSET && !memtx_tx_manager_use_mvcc_engine);
+	assert(iterator->next_raw ==
+	       (tree_iterator_start_raw<UNCHANGED, USE_HINT, FAST_OFFSET>));
+	if (count == 0)
+		return 0;
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)
+		iterator->index;
+	struct tree_iterator<USE_HINT, FAST_OFFSET> *it =
+		get_tree_iterator<USE_HINT, FAST_OFFSET>(iterator);
+	memtx_tree_t<USE_HINT, FAST_OFFSET> *tree = &index->tree;
+	size_t begin, end;
+	memtx_tree_index_offset_range<USE_HINT, FAST_OFFSET>(
+		tree, it->type, &it->key_data, &begin, &end);
+	if (end - begin <= count) {
+		tree_iterator_set_dummie<UNCHANGED>(iterator);
+		return 0;
+	}
+	/*
+	 * Position the iterator at the last skipped element, so that
+	 * the next call of next() steps to the first one to return.
+	 */
+	size_t pos = iterator_type_is_reverse(it->type) ?
+		     end - count : begin + count - 1;
+	it->tree_iterator = memtx_tree_iterator_at(tree, pos);
+	struct memtx_tree_data<USE_HINT> *res =
+		memtx_tree_iterator_get_elem(tree, &it->tree_iterator);
+	assert(res != NULL);
+	tree_iterator_set_current(it, res);
+	tree_iterator_set_next_method<UNCHANGED>(it);
+	return 0;
+}
+
+/**
+ * Implementation of iterator::start_after: position a fresh iterator
+ * at the element preceding the first one to return, so that next()
+ * continues from there as usual.
+ */
+template <bool UNCHANGED, bool USE_HINT, bool FAST_OFFSET>
+static int
+tree_iterator_start_after(struct iterator *iterator, const char *key,
+			  uint32_t part_count)
+{
+	assert(iterator->next_raw ==
+	       (tree_iterator_start_raw<UNCHANGED, USE_HINT, FAST_OFFSET>));
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)
+		iterator->index;
+	struct tree_iterator<USE_HINT, FAST_OFFSET> *it =
+		get_tree_iterator<USE_HINT, FAST_OFFSET>(iterator);
+	memtx_tree_t<USE_HINT, FAST_OFFSET> *tree = &index->tree;
+	struct key_def *cmp_def = memtx_tree_cmp_def(tree);
+	/*
+	 * The position contains all parts of the index cmp_def, but
+	 * a unique index without nullable parts is compared by its
+	 * key_def only, which identifies a tuple as well.
+	 */
+	part_count = MIN(part_count, cmp_def->part_count);
+	struct memtx_tree_key_data<USE_HINT> key_data;
+	key_data.key = key;
+	key_data.part_count = part_count;
+	if (USE_HINT)
+		key_data.set_hint(key_hint(key, part_count, cmp_def));
+	memtx_tree_iterator_t<USE_HINT, FAST_OFFSET> tree_iterator;
+	if (iterator_type_is_reverse(it->type)) {
+		/* The first element following the position. */
+		tree_iterator = memtx_tree_lower_bound(tree, &key_data, NULL);
+	} else {
+		/* The last element preceding or equal to the position. */
+		tree_iterator = memtx_tree_upper_bound(tree, &key_data, NULL);
+		memtx_tree_iterator_prev(tree, &tree_iterator);
+	}
+	struct memtx_tree_data<USE_HINT> *res =
+		memtx_tree_iterator_get_elem(tree, &tree_iterator);
+	if (res == NULL) {
+		/*
+		 * All the elements follow the position (or precede it
+		 * in case of a reverse iterator) so start as usual.
+		 */
+		return 0;
+	}
+	it->tree_iterator = tree_iterator;
+	tree_iterator_set_current(it, res);
+	tree_iterator_set_next_method<UNCHANGED>(it);
+	/* Skipping is only supported for fresh iterators. */
+	iterator->skip = NULL;
+	return 0;
+}
+
 /* }}} */
 
 /* {{{ MemtxTree  **********************************************************/
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static void
-memtx_tree_index_free(struct memtx_tree_index<USE_HINT> *index)
+memtx_tree_index_free(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index)
 {
 	memtx_tree_destroy(&index->tree);
 	free(index->build_array);
 	free(index);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static void
 memtx_tree_index_gc_run(struct memtx_gc_task *task, bool *done)
 {
@@ -765,10 +991,10 @@ memtx_tree_index_gc_run(struct memtx_gc_task *task, bool *done)
 	enum { YIELD_LOOPS = 10 };
 #endif
 
-	struct memtx_tree_index<USE_HINT> *index = container_of(task,
-			struct memtx_tree_index<USE_HINT>, gc_task);
-	memtx_tree_t<USE_HINT> *tree = &index->tree;
-	memtx_tree_iterator_t<USE_HINT> *itr = &index->gc_iterator;
+	typedef struct memtx_tree_index<USE_HINT, FAST_OFFSET> index_t;
+	index_t *index = container_of(task, index_t, gc_task);
+	memtx_tree_t<USE_HINT, FAST_OFFSET> *tree = &index->tree;
+	memtx_tree_iterator_t<USE_HINT, FAST_OFFSET> *itr = &index->gc_iterator;
 
 	unsigned int loops = 0;
 	while (!memtx_tree_iterator_is_invalid(itr)) {
@@ -784,32 +1010,32 @@ memtx_tree_index_gc_run(struct memtx_gc_task *task, bool *done)
 	*done = true;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static void
 memtx_tree_index_gc_free(struct memtx_gc_task *task)
 {
-	struct memtx_tree_index<USE_HINT> *index = container_of(task,
-			struct memtx_tree_index<USE_HINT>, gc_task);
+	typedef struct memtx_tree_index<USE_HINT, FAST_OFFSET> index_t;
+	index_t *index = container_of(task, index_t, gc_task);
 	memtx_tree_index_free(index);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static struct memtx_gc_task_vtab * get_memtx_tree_index_gc_vtab()
 {
 	static memtx_gc_task_vtab tab =
 	{
-		.run = memtx_tree_index_gc_run<USE_HINT>,
-		.free = memtx_tree_index_gc_free<USE_HINT>,
+		.run = memtx_tree_index_gc_run<USE_HINT, FAST_OFFSET>,
+		.free = memtx_tree_index_gc_free<USE_HINT, FAST_OFFSET>,
 	};
 	return &tab;
 };
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static void
 memtx_tree_index_destroy(struct index *base)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)base;
 	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
 	if (base->def->iid == 0) {
 		/*
@@ -817,7 +1043,8 @@ memtx_tree_index_destroy(struct index *base)
 		 * in the index, which may take a while. Schedule a
 		 * background task in order not to block tx thread.
 		 */
-		index->gc_task.vtab = get_memtx_tree_index_gc_vtab<USE_HINT>();
+		index->gc_task.vtab =
+			get_memtx_tree_index_gc_vtab<USE_HINT, FAST_OFFSET>();
 		index->gc_iterator = memtx_tree_iterator_first(&index->tree);
 		memtx_engine_schedule_gc(memtx, &index->gc_task);
 	} else {
@@ -829,12 +1056,12 @@ memtx_tree_index_destroy(struct index *base)
 	}
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static void
 memtx_tree_index_update_def(struct index *base)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)base;
 	struct index_def *def = base->def;
 	/*
 	 * We use extended key def for non-unique and nullable
@@ -854,57 +1081,72 @@ memtx_tree_index_depends_on_pk(struct index *base)
 	return !def->opts.is_unique || def->key_def->is_nullable;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static ssize_t
 memtx_tree_index_size(struct index *base)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)base;
 	struct space *space = space_by_id(base->def->space_id);
 	/* Substract invisible count. */
 	return memtx_tree_size(&index->tree) -
 	       memtx_tx_index_invisible_count(in_txn(), space, base);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static ssize_t
 memtx_tree_index_bsize(struct index *base)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)base;
 	return memtx_tree_mem_used(&index->tree);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static int
 memtx_tree_index_random(struct index *base, uint32_t rnd, struct tuple **result)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)base;
 	struct memtx_tree_data<USE_HINT> *res = memtx_tree_random(&index->tree, rnd);
 	*result = res != NULL ? res->tuple : NULL;
 	return memtx_prepare_result_tuple(result);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static ssize_t
 memtx_tree_index_count(struct index *base, enum iterator_type type,
 		       const char *key, uint32_t part_count)
 {
 	if (type == ITER_ALL)
-		return memtx_tree_index_size<USE_HINT>(base); /* optimization */
-	return generic_index_count(base, type, key, part_count);
+		/* optimization */
+		return memtx_tree_index_size<USE_HINT, FAST_OFFSET>(base);
+	if (!FAST_OFFSET || memtx_tx_manager_use_mvcc_engine ||
+	    type > ITER_GT)
+		return generic_index_count(base, type, key, part_count);
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)base;
+	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
+	struct memtx_tree_key_data<USE_HINT> key_data;
+	key_data.key = part_count > 0 ? key : NULL;
+	key_data.part_count = part_count;
+	if (USE_HINT)
+		key_data.set_hint(key_hint(key, part_count, cmp_def));
+	size_t begin, end;
+	memtx_tree_index_offset_range<USE_HINT, FAST_OFFSET>(
+		&index->tree, type, &key_data, &begin, &end);
+	return end - begin;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static int
 memtx_tree_index_get_raw(struct index *base, const char *key,
 			 uint32_t part_count, struct tuple **result)
 {
 	assert(base->def->opts.is_unique &&
 	       part_count == base->def->key_def->part_count);
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)base;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	struct txn *txn = in_txn();
 	struct space *space = space_by_id(base->def->space_id);
@@ -929,14 +1171,14 @@ memtx_tree_index_get_raw(struct index *base, const char *key,
 	return 0;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static int
 memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 			 struct tuple *new_tuple, enum dup_replace_mode mode,
 			 struct tuple **result, struct tuple **successor)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)base;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	if (new_tuple) {
 		struct memtx_tree_data<USE_HINT> new_data;
@@ -1000,7 +1242,8 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
  * by all it's multikey indexes.
  */
 static int
-memtx_tree_index_replace_multikey_one(struct memtx_tree_index<true> *index,
+memtx_tree_index_replace_multikey_one(struct memtx_tree_index<true, false>
+						*index,
 			struct tuple *old_tuple, struct tuple *new_tuple,
 			enum dup_replace_mode mode, hint_t hint,
 			struct memtx_tree_data<true> *replaced_data,
@@ -1062,7 +1305,8 @@ memtx_tree_index_replace_multikey_one(struct memtx_tree_index<true> *index,
  * delete operation is fault-tolerant.
  */
 static void
-memtx_tree_index_replace_multikey_rollback(struct memtx_tree_index<true> *index,
+memtx_tree_index_replace_multikey_rollback(struct memtx_tree_index<true, false>
+						*index,
 			struct tuple *new_tuple, struct tuple *replaced_tuple,
 			int err_multikey_idx)
 {
@@ -1140,8 +1384,8 @@ memtx_tree_index_replace_multikey(struct index *base, struct tuple *old_tuple,
 			struct tuple *new_tuple, enum dup_replace_mode mode,
 			struct tuple **result, struct tuple **successor)
 {
-	struct memtx_tree_index<true> *index =
-		(struct memtx_tree_index<true> *)base;
+	struct memtx_tree_index<true, false> *index =
+		(struct memtx_tree_index<true, false> *)base;
 
 	/* MUTLIKEY doesn't support successor for now. */
 	*successor = NULL;
@@ -1253,7 +1497,8 @@ func_key_undo_new(struct region *region)
  * return a given index object in it's original state.
  */
 static void
-memtx_tree_func_index_replace_rollback(struct memtx_tree_index<true> *index,
+memtx_tree_func_index_replace_rollback(struct memtx_tree_index<true, false>
+						*index,
 				       struct rlist *old_keys,
 				       struct rlist *new_keys)
 {
@@ -1286,8 +1531,8 @@ memtx_tree_func_index_replace(struct index *base, struct tuple *old_tuple,
 	/* FUNC doesn't support successor for now. */
 	*successor = NULL;
 
-	struct memtx_tree_index<true> *index =
-		(struct memtx_tree_index<true> *)base;
+	struct memtx_tree_index<true, false> *index =
+		(struct memtx_tree_index<true, false> *)base;
 	struct index_def *index_def = index->base.def;
 	assert(index_def->key_def->for_func_index);
 
@@ -1407,13 +1652,13 @@ end:
 	return rc;
 }
 
-template <bool UNCHANGED, bool USE_HINT>
+template <bool UNCHANGED, bool USE_HINT, bool FAST_OFFSET>
 static struct iterator *
 memtx_tree_index_create_iterator(struct index *base, enum iterator_type type,
 				 const char *key, uint32_t part_count)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)base;
 	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 
@@ -1433,18 +1678,25 @@ memtx_tree_index_create_iterator(struct index *base, enum iterator_type type,
 		key = NULL;
 	}
 
-	struct tree_iterator<USE_HINT> *it = (struct tree_iterator<USE_HINT> *)
+	struct tree_iterator<USE_HINT, FAST_OFFSET> *it =
+		(struct tree_iterator<USE_HINT, FAST_OFFSET> *)
 		mempool_alloc(&memtx->iterator_pool);
 	if (it == NULL) {
-		diag_set(OutOfMemory, sizeof(struct tree_iterator<USE_HINT>),
+		diag_set(OutOfMemory, sizeof(*it),
 			 "memtx_tree_index", "iterator");
 		return NULL;
 	}
 	iterator_create(&it->base, base);
 	it->pool = &memtx->iterator_pool;
-	it->base.next_raw = tree_iterator_start_raw<UNCHANGED, USE_HINT>;
+	it->base.next_raw =
+		tree_iterator_start_raw<UNCHANGED, USE_HINT, FAST_OFFSET>;
 	it->base.next = UNCHANGED ? it->base.next_raw : memtx_iterator_next;
-	it->base.free = tree_iterator_free<USE_HINT>;
+	it->base.free = tree_iterator_free<USE_HINT, FAST_OFFSET>;
+	if (FAST_OFFSET && !memtx_tx_manager_use_mvcc_engine)
+		it->base.skip =
+			tree_iterator_skip<UNCHANGED, USE_HINT, FAST_OFFSET>;
+	it->base.start_after =
+		tree_iterator_start_after<UNCHANGED, USE_HINT, FAST_OFFSET>;
 	it->type = type;
 	it->key_data.key = key;
 	it->key_data.part_count = part_count;
@@ -1458,22 +1710,22 @@ memtx_tree_index_create_iterator(struct index *base, enum iterator_type type,
 	return (struct iterator *)it;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static void
 memtx_tree_index_begin_build(struct index *base)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)base;
 	assert(memtx_tree_size(&index->tree) == 0);
-	(void)index;
+	index->is_build_array_sorted = false;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static int
 memtx_tree_index_reserve(struct index *base, uint32_t size_hint)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)base;
 	if (size_hint < index->build_array_alloc_size)
 		return 0;
 	struct memtx_tree_data<USE_HINT> *tmp =
@@ -1489,10 +1741,11 @@ memtx_tree_index_reserve(struct index *base, uint32_t size_hint)
 	return 0;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 /** Initialize the next element of the index build_array. */
 static int
-memtx_tree_index_build_array_append(struct memtx_tree_index<USE_HINT> *index,
+memtx_tree_index_build_array_append(
+		struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index,
 				    struct tuple *tuple, hint_t hint)
 {
 	if (index->build_array == NULL) {
@@ -1528,14 +1781,14 @@ memtx_tree_index_build_array_append(struct memtx_tree_index<USE_HINT> *index,
 	return 0;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static int
 memtx_tree_index_build_next(struct index *base, struct tuple *tuple)
 {
 	if (index_filter_tuple(base, tuple) == NULL)
 		return 0;
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)base;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	return memtx_tree_index_build_array_append(index, tuple,
 						   tuple_hint(tuple, cmp_def));
@@ -1544,7 +1797,8 @@ memtx_tree_index_build_next(struct index *base, struct tuple *tuple)
 static int
 memtx_tree_index_build_next_multikey(struct index *base, struct tuple *tuple)
 {
-	struct memtx_tree_index<true> *index = (struct memtx_tree_index<true> *)base;
+	struct memtx_tree_index<true, false> *index =
+		(struct memtx_tree_index<true, false> *)base;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	uint32_t multikey_count = tuple_multikey_count(tuple, cmp_def);
 	for (uint32_t multikey_idx = 0; multikey_idx < multikey_count;
@@ -1559,7 +1813,8 @@ memtx_tree_index_build_next_multikey(struct index *base, struct tuple *tuple)
 static int
 memtx_tree_func_index_build_next(struct index *base, struct tuple *tuple)
 {
-	struct memtx_tree_index<true> *index = (struct memtx_tree_index<true> *)base;
+	struct memtx_tree_index<true, false> *index =
+		(struct memtx_tree_index<true, false> *)base;
 	struct index_def *index_def = index->base.def;
 	assert(index_def->key_def->for_func_index);
 
@@ -1594,9 +1849,10 @@ error:
  * of equal tuples (in terms of index's cmp_def and have same
  * tuple pointer). The build_array is expected to be sorted.
  */
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static void
-memtx_tree_index_build_array_deduplicate(struct memtx_tree_index<USE_HINT> *index,
+memtx_tree_index_build_array_deduplicate(
+		struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index,
 			void (*destroy)(const char *hint))
 {
 	if (index->build_array_size == 0)
@@ -1629,16 +1885,28 @@ memtx_tree_index_build_array_deduplicate(struct memtx_tree_index<USE_HINT> *inde
 	index->build_array_size = w_idx + 1;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static void
-memtx_tree_index_end_build(struct index *base)
+memtx_tree_index_sort_build_array_tpl(
+		struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	qsort_arg(index->build_array, index->build_array_size,
 		  sizeof(index->build_array[0]),
 		  memtx_tree_qcompare<USE_HINT>, cmp_def);
+	index->is_build_array_sorted = true;
+}
+
+template <bool USE_HINT, bool FAST_OFFSET>
+static void
+memtx_tree_index_end_build(struct index *base)
+{
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)base;
+	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
+	if (!index->is_build_array_sorted)
+		memtx_tree_index_sort_build_array_tpl<USE_HINT, FAST_OFFSET>(
+			index);
 	if (cmp_def->is_multikey) {
 		/*
 		 * Multikey index may have equal(in terms of
@@ -1647,10 +1915,11 @@ memtx_tree_index_end_build(struct index *base)
 		 * the following memtx_tree_build assumes that
 		 * all keys are unique.
 		 */
-		memtx_tree_index_build_array_deduplicate<USE_HINT>(index, NULL);
+		memtx_tree_index_build_array_deduplicate<USE_HINT, FAST_OFFSET>(
+			index, NULL);
 	} else if (cmp_def->for_func_index) {
-		memtx_tree_index_build_array_deduplicate<USE_HINT>(index,
-							 func_index_key_free);
+		memtx_tree_index_build_array_deduplicate<USE_HINT, FAST_OFFSET>(
+			index, func_index_key_free);
 	}
 	memtx_tree_build(&index->tree, index->build_array,
 			 index->build_array_size);
@@ -1659,23 +1928,26 @@ memtx_tree_index_end_build(struct index *base)
 	index->build_array = NULL;
 	index->build_array_size = 0;
 	index->build_array_alloc_size = 0;
+	index->is_build_array_sorted = false;
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 struct tree_snapshot_iterator {
 	struct snapshot_iterator base;
-	struct memtx_tree_index<USE_HINT> *index;
-	memtx_tree_iterator_t<USE_HINT> tree_iterator;
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index;
+	memtx_tree_iterator_t<USE_HINT, FAST_OFFSET> tree_iterator;
 	struct memtx_tx_snapshot_cleaner cleaner;
 };
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static void
 tree_snapshot_iterator_free(struct snapshot_iterator *iterator)
 {
-	assert(iterator->free == &tree_snapshot_iterator_free<USE_HINT>);
-	struct tree_snapshot_iterator<USE_HINT> *it =
-		(struct tree_snapshot_iterator<USE_HINT> *)iterator;
+	assert((iterator->free ==
+		&tree_snapshot_iterator_free<USE_HINT, FAST_OFFSET>));
+	struct tree_snapshot_iterator<USE_HINT, FAST_OFFSET> *it =
+		(struct tree_snapshot_iterator<USE_HINT, FAST_OFFSET> *)
+		iterator;
 	memtx_leave_delayed_free_mode((struct memtx_engine *)
 				      it->index->base.engine);
 	memtx_tree_iterator_destroy(&it->index->tree, &it->tree_iterator);
@@ -1684,15 +1956,17 @@ tree_snapshot_iterator_free(struct snapshot_iterator *iterator)
 	free(iterator);
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static int
 tree_snapshot_iterator_next(struct snapshot_iterator *iterator,
 			    const char **data, uint32_t *size)
 {
-	assert(iterator->free == &tree_snapshot_iterator_free<USE_HINT>);
-	struct tree_snapshot_iterator<USE_HINT> *it =
-		(struct tree_snapshot_iterator<USE_HINT> *)iterator;
-	memtx_tree_t<USE_HINT> *tree = &it->index->tree;
+	assert((iterator->free ==
+		&tree_snapshot_iterator_free<USE_HINT, FAST_OFFSET>));
+	struct tree_snapshot_iterator<USE_HINT, FAST_OFFSET> *it =
+		(struct tree_snapshot_iterator<USE_HINT, FAST_OFFSET> *)
+		iterator;
+	memtx_tree_t<USE_HINT, FAST_OFFSET> *tree = &it->index->tree;
 
 	while (true) {
 		struct memtx_tree_data<USE_HINT> *res =
@@ -1722,18 +1996,17 @@ tree_snapshot_iterator_next(struct snapshot_iterator *iterator,
  * index modifications will not affect the iteration results.
  * Must be destroyed by iterator->free after usage.
  */
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static struct snapshot_iterator *
 memtx_tree_index_create_snapshot_iterator(struct index *base)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)base;
-	struct tree_snapshot_iterator<USE_HINT> *it =
-		(struct tree_snapshot_iterator<USE_HINT> *)
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)base;
+	struct tree_snapshot_iterator<USE_HINT, FAST_OFFSET> *it =
+		(struct tree_snapshot_iterator<USE_HINT, FAST_OFFSET> *)
 		calloc(1, sizeof(*it));
 	if (it == NULL) {
-		diag_set(OutOfMemory,
-			 sizeof(struct tree_snapshot_iterator<USE_HINT>),
+		diag_set(OutOfMemory, sizeof(*it),
 			 "memtx_tree_index", "create_snapshot_iterator");
 		return NULL;
 	}
@@ -1741,8 +2014,8 @@ memtx_tree_index_create_snapshot_iterator(struct index *base)
 	struct space *space = space_cache_find(base->def->space_id);
 	memtx_tx_snapshot_cleaner_create(&it->cleaner, space);
 
-	it->base.free = tree_snapshot_iterator_free<USE_HINT>;
-	it->base.next = tree_snapshot_iterator_next<USE_HINT>;
+	it->base.free = tree_snapshot_iterator_free<USE_HINT, FAST_OFFSET>;
+	it->base.next = tree_snapshot_iterator_next<USE_HINT, FAST_OFFSET>;
 	it->index = index;
 	index_ref(base);
 	it->tree_iterator = memtx_tree_iterator_first(&index->tree);
@@ -1758,7 +2031,7 @@ memtx_tree_index_create_snapshot_iterator(struct index *base)
  * key defintion is not completely initialized at that moment).
  */
 static const struct index_vtab memtx_tree_disabled_index_vtab = {
-	/* .destroy = */ memtx_tree_index_destroy<true>,
+	/* .destroy = */ memtx_tree_index_destroy<true, false>,
 	/* .commit_create = */ generic_index_commit_create,
 	/* .abort_create = */ generic_index_abort_create,
 	/* .commit_modify = */ generic_index_commit_modify,
@@ -1775,6 +2048,7 @@ static const struct index_vtab memtx_tree_disabled_index_vtab = {
 	/* .count = */ generic_index_count,
 	/* .get_raw = */ generic_index_get_raw,
 	/* .get = */ generic_index_get,
+	/* .get_many = */ generic_index_get_many,
 	/* .replace = */ disabled_index_replace,
 	/* .create_iterator = */ generic_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -1803,17 +2077,21 @@ enum memtx_tree_vtab_type {
 };
 
 /**
- * Get index vtab by @a TYPE, @a UNCHANGED and @a USE_HINT, template
- * version. USE_HINT == false is only allowed for general index type.
+ * Get index vtab by @a TYPE, @a UNCHANGED, @a USE_HINT and
+ * @a FAST_OFFSET, template version. USE_HINT == false and
+ * FAST_OFFSET == true are only allowed for general index type.
  * If UNCHANGED == true iterator->next and index->get functions are
  * the same as it's raw versions.
  */
-template <memtx_tree_vtab_type TYPE, bool UNCHANGED, bool USE_HINT = true>
+template <memtx_tree_vtab_type TYPE, bool UNCHANGED, bool USE_HINT = true,
+	  bool FAST_OFFSET = false>
 static const struct index_vtab *
 get_memtx_tree_index_vtab(void)
 {
 	static_assert(USE_HINT || TYPE == MEMTX_TREE_VTAB_GENERAL,
 		      "Multikey and func indexes must use hints");
+	static_assert(!FAST_OFFSET || TYPE == MEMTX_TREE_VTAB_GENERAL,
+		      "Multikey and func indexes can't use fast offset");
 
 	if (TYPE == MEMTX_TREE_VTAB_DISABLED)
 		return &memtx_tree_disabled_index_vtab;
@@ -1821,52 +2099,74 @@ get_memtx_tree_index_vtab(void)
 	const bool is_mk = TYPE == MEMTX_TREE_VTAB_MULTIKEY;
 	const bool is_func = TYPE == MEMTX_TREE_VTAB_FUNC;
 	static const struct index_vtab vtab = {
-		/* .destroy = */ memtx_tree_index_destroy<USE_HINT>,
+		/* .destroy = */
+			memtx_tree_index_destroy<USE_HINT, FAST_OFFSET>,
 		/* .commit_create = */ generic_index_commit_create,
 		/* .abort_create = */ generic_index_abort_create,
 		/* .commit_modify = */ generic_index_commit_modify,
 		/* .commit_drop = */ generic_index_commit_drop,
-		/* .update_def = */ memtx_tree_index_update_def<USE_HINT>,
+		/* .update_def = */
+			memtx_tree_index_update_def<USE_HINT, FAST_OFFSET>,
 		/* .depends_on_pk = */ memtx_tree_index_depends_on_pk,
 		/* .def_change_requires_rebuild = */
 			memtx_index_def_change_requires_rebuild,
-		/* .size = */ memtx_tree_index_size<USE_HINT>,
-		/* .bsize = */ memtx_tree_index_bsize<USE_HINT>,
+		/* .size = */ memtx_tree_index_size<USE_HINT, FAST_OFFSET>,
+		/* .bsize = */ memtx_tree_index_bsize<USE_HINT, FAST_OFFSET>,
 		/* .min = */ generic_index_min,
 		/* .max = */ generic_index_max,
-		/* .random = */ memtx_tree_index_random<USE_HINT>,
-		/* .count = */ memtx_tree_index_count<USE_HINT>,
-		/* .get_raw */ memtx_tree_index_get_raw<USE_HINT>,
-		/* .get = */ UNCHANGED ? memtx_tree_index_get_raw<USE_HINT> :
+		/* .random = */ memtx_tree_index_random<USE_HINT, FAST_OFFSET>,
+		/* .count = */ memtx_tree_index_count<USE_HINT, FAST_OFFSET>,
+		/* .get_raw */ memtx_tree_index_get_raw<USE_HINT, FAST_OFFSET>,
+		/* .get = */ UNCHANGED ?
+			memtx_tree_index_get_raw<USE_HINT, FAST_OFFSET> :
 			memtx_index_get,
+		/* .get_many = */ generic_index_get_many,
 		/* .replace = */ is_mk ? memtx_tree_index_replace_multikey :
 				 is_func ? memtx_tree_func_index_replace :
-				 memtx_tree_index_replace<USE_HINT>,
+				 memtx_tree_index_replace<USE_HINT,
+							  FAST_OFFSET>,
 		/* .create_iterator = */
-			memtx_tree_index_create_iterator<UNCHANGED, USE_HINT>,
+			memtx_tree_index_create_iterator<UNCHANGED, USE_HINT,
+							 FAST_OFFSET>,
 		/* .create_snapshot_iterator = */
-			memtx_tree_index_create_snapshot_iterator<USE_HINT>,
+			memtx_tree_index_create_snapshot_iterator<USE_HINT,
+								  FAST_OFFSET>,
 		/* .stat = */ generic_index_stat,
 		/* .compact = */ generic_index_compact,
 		/* .reset_stat = */ generic_index_reset_stat,
-		/* .begin_build = */ memtx_tree_index_begin_build<USE_HINT>,
-		/* .reserve = */ memtx_tree_index_reserve<USE_HINT>,
+		/* .begin_build = */
+			memtx_tree_index_begin_build<USE_HINT, FAST_OFFSET>,
+		/* .reserve = */
+			memtx_tree_index_reserve<USE_HINT, FAST_OFFSET>,
 		/* .build_next = */ is_mk ? memtx_tree_index_build_next_multikey :
 				    is_func ? memtx_tree_func_index_build_next :
-				    memtx_tree_index_build_next<USE_HINT>,
-		/* .end_build = */ memtx_tree_index_end_build<USE_HINT>,
+				    memtx_tree_index_build_next<USE_HINT,
+								FAST_OFFSET>,
+		/* .end_build = */
+			memtx_tree_index_end_build<USE_HINT, FAST_OFFSET>,
 	};
 	return &vtab;
 }
 
 /**
- * Get index vtab by @a type and @a use_hint, argument version.
- * @a use_hint is ignored for every type except MEMTX_TREE_VTAB_GENERAL.
+ * Get index vtab by @a type, @a use_hint and @a fast_offset, argument
+ * version. @a use_hint is ignored for every type except
+ * MEMTX_TREE_VTAB_GENERAL, @a fast_offset may be set only for it.
  */
 static const struct index_vtab *
 get_memtx_tree_index_vtab(memtx_tree_vtab_type type, bool unchanged,
-			  bool use_hint)
+			  bool use_hint, bool fast_offset)
 {
+	static const index_vtab *fast_offset_choice[2][2] = {
+		{get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_GENERAL, false, false, true>(),
+		 get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_GENERAL, false, true, true>()},
+		{get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_GENERAL, true, false, true>(),
+		 get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_GENERAL, true, true, true>()}
+	};
+	if (fast_offset) {
+		assert(type == MEMTX_TREE_VTAB_GENERAL);
+		return fast_offset_choice[unchanged][use_hint];
+	}
 	static const index_vtab *choice[MEMTX_TREE_VTAB_TYPE_COUNT][2][2] = {
 		{{get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_GENERAL, false, false>(),
 		  get_memtx_tree_index_vtab<MEMTX_TREE_VTAB_GENERAL, false, true>()},
@@ -1888,13 +2188,13 @@ get_memtx_tree_index_vtab(memtx_tree_vtab_type type, bool unchanged,
 	return choice[type][unchanged][use_hint];
 }
 
-template <bool USE_HINT>
+template <bool USE_HINT, bool FAST_OFFSET>
 static struct index *
 memtx_tree_index_new_tpl(struct memtx_engine *memtx, struct index_def *def,
 			 const struct index_vtab *vtab)
 {
-	struct memtx_tree_index<USE_HINT> *index =
-		(struct memtx_tree_index<USE_HINT> *)
+	struct memtx_tree_index<USE_HINT, FAST_OFFSET> *index =
+		(struct memtx_tree_index<USE_HINT, FAST_OFFSET> *)
 		calloc(1, sizeof(*index));
 	if (index == NULL) {
 		diag_set(OutOfMemory, sizeof(*index),
@@ -1920,10 +2220,11 @@ memtx_tree_index_new_tpl(struct memtx_engine *memtx, struct index_def *def,
 static void
 memtx_tree_choose_type_and_hint(struct index_def *def,
 				memtx_tree_vtab_type *type,
-				bool *use_hint)
+				bool *use_hint, bool *fast_offset)
 {
 	*type = MEMTX_TREE_VTAB_GENERAL;
 	*use_hint = true; /* Force hints for multikey and func indexes. */
+	*fast_offset = false;
 	if (def->key_def->for_func_index) {
 		if (def->key_def->func_index_func == NULL)
 			*type = MEMTX_TREE_VTAB_DISABLED;
@@ -1933,6 +2234,7 @@ memtx_tree_choose_type_and_hint(struct index_def *def,
 		*type = MEMTX_TREE_VTAB_MULTIKEY;
 	} else {
 		*use_hint = def->opts.hint;
+		*fast_offset = def->opts.fast_offset;
 	}
 }
 
@@ -1941,20 +2243,54 @@ memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def)
 {
 	const struct index_vtab *vtab;
 	memtx_tree_vtab_type type;
-	bool use_hint;
-	memtx_tree_choose_type_and_hint(def, &type, &use_hint);
-	vtab = get_memtx_tree_index_vtab(type, true, use_hint);
+	bool use_hint, fast_offset;
+	memtx_tree_choose_type_and_hint(def, &type, &use_hint, &fast_offset);
+	vtab = get_memtx_tree_index_vtab(type, true, use_hint, fast_offset);
+	if (fast_offset) {
+		if (use_hint)
+			return memtx_tree_index_new_tpl<true, true>(memtx, def,
+								    vtab);
+		else
+			return memtx_tree_index_new_tpl<false, true>(memtx, def,
+								     vtab);
+	}
 	if (use_hint)
-		return memtx_tree_index_new_tpl<true>(memtx, def, vtab);
+		return memtx_tree_index_new_tpl<true, false>(memtx, def, vtab);
 	else
-		return memtx_tree_index_new_tpl<false>(memtx, def, vtab);
+		return memtx_tree_index_new_tpl<false, false>(memtx, def, vtab);
 }
 
 void
 memtx_tree_index_set_vtab(struct index *index, bool unchanged)
 {
 	memtx_tree_vtab_type type;
-	bool use_hint;
-	memtx_tree_choose_type_and_hint(index->def, &type, &use_hint);
-	index->vtab = get_memtx_tree_index_vtab(type, unchanged, use_hint);
+	bool use_hint, fast_offset;
+	memtx_tree_choose_type_and_hint(index->def, &type, &use_hint,
+					&fast_offset);
+	index->vtab = get_memtx_tree_index_vtab(type, unchanged, use_hint,
+						fast_offset);
+}
+
+void
+memtx_tree_index_sort_build_array(struct index *index)
+{
+	memtx_tree_vtab_type type;
+	bool use_hint, fast_offset;
+	memtx_tree_choose_type_and_hint(index->def, &type, &use_hint,
+					&fast_offset);
+	if (type == MEMTX_TREE_VTAB_DISABLED)
+		return;
+	if (use_hint && fast_offset) {
+		memtx_tree_index_sort_build_array_tpl<true, true>(
+			(struct memtx_tree_index<true, true> *)index);
+	} else if (fast_offset) {
+		memtx_tree_index_sort_build_array_tpl<false, true>(
+			(struct memtx_tree_index<false, true> *)index);
+	} else if (use_hint) {
+		memtx_tree_index_sort_build_array_tpl<true, false>(
+			(struct memtx_tree_index<true, false> *)index);
+	} else {
+		memtx_tree_index_sort_build_array_tpl<false, false>(
+			(struct memtx_tree_index<false, false> *)index);
+	}
 }
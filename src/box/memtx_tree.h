@@ -51,6 +51,16 @@ memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def);
 void
 memtx_tree_index_set_vtab(struct index *index, bool unchanged);
 
+/**
+ * Sort the array of tuples collected by index_build_next() so
+ * that the following index_end_build() only has to construct the
+ * tree. Doesn't touch anything but the build array of @a index,
+ * hence may be called from any thread, including concurrently for
+ * different indexes.
+ */
+void
+memtx_tree_index_sort_build_array(struct index *index);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -0,0 +1,131 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "mp_skip.h"
+
+#include <stdbool.h>
+
+#include "cpu_feature.h"
+#include "msgpuck.h"
+#include "trivia/config.h"
+#include "trivia/util.h"
+
+/*
+ * The vectorized implementations read the whole aligned block
+ * containing the current position. This never crosses a page
+ * boundary, but it is still an out-of-bounds read for ASAN and
+ * a use of uninitialized memory for Valgrind.
+ */
+#if defined(__SSE2__) && defined(NVALGRIND)
+#define MP_SKIP_SIMD 1
+#include <immintrin.h>
+#endif
+
+static void
+mp_skip_generic(const char **data, uint32_t count)
+{
+	for (; count > 0; count--)
+		mp_next(data);
+}
+
+mp_skip_f mp_skip_impl = mp_skip_generic;
+
+#if defined(MP_SKIP_SIMD)
+
+/**
+ * Check if a MessagePack value is encoded in one byte: positive
+ * fixint (0x00..0x7f), negative fixint (0xe0..0xff), nil (0xc0),
+ * false (0xc2) or true (0xc3). As signed bytes, fixints are
+ * exactly the values greater than -33.
+ */
+static inline bool
+mp_is_single_byte(char c)
+{
+	return (int8_t)c > -33 || c == (char)0xc0 || (c | 1) == (char)0xc3;
+}
+
+/** Bitmask of single-byte values in a 16-byte block. */
+static inline uint32_t
+mp_single_byte_mask_sse2(__m128i v)
+{
+	__m128i m = _mm_cmpgt_epi8(v, _mm_set1_epi8(-33));
+	m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8((char)0xc0)));
+	v = _mm_or_si128(v, _mm_set1_epi8(1));
+	m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8((char)0xc3)));
+	return (uint32_t)_mm_movemask_epi8(m);
+}
+
+__attribute__((no_sanitize_address)) static void
+mp_skip_sse2(const char **data, uint32_t count)
+{
+	const char *pos = *data;
+	while (count > 0) {
+		if (!mp_is_single_byte(*pos)) {
+			mp_next(&pos);
+			count--;
+			continue;
+		}
+		uintptr_t offset = (uintptr_t)pos & 15;
+		__m128i v = _mm_load_si128((const __m128i *)(pos - offset));
+		uint32_t mask = mp_single_byte_mask_sse2(v) >> offset;
+		/* Bit 16 - offset is always clear in mask. */
+		uint32_t n = MIN((uint32_t)__builtin_ctz(~mask), count);
+		pos += n;
+		count -= n;
+	}
+	*data = pos;
+}
+
+#if defined(HAVE_CPUID)
+
+/** Bitmask of single-byte values in a 32-byte block. */
+__attribute__((target("avx2"))) static inline uint64_t
+mp_single_byte_mask_avx2(__m256i v)
+{
+	__m256i m = _mm256_cmpgt_epi8(v, _mm256_set1_epi8(-33));
+	m = _mm256_or_si256(m, _mm256_cmpeq_epi8(
+		v, _mm256_set1_epi8((char)0xc0)));
+	v = _mm256_or_si256(v, _mm256_set1_epi8(1));
+	m = _mm256_or_si256(m, _mm256_cmpeq_epi8(
+		v, _mm256_set1_epi8((char)0xc3)));
+	return (uint32_t)_mm256_movemask_epi8(m);
+}
+
+__attribute__((target("avx2"), no_sanitize_address)) static void
+mp_skip_avx2(const char **data, uint32_t count)
+{
+	const char *pos = *data;
+	while (count > 0) {
+		if (!mp_is_single_byte(*pos)) {
+			mp_next(&pos);
+			count--;
+			continue;
+		}
+		uintptr_t offset = (uintptr_t)pos & 31;
+		__m256i v = _mm256_load_si256((const __m256i *)(pos - offset));
+		uint64_t mask = mp_single_byte_mask_avx2(v) >> offset;
+		/* Bit 32 - offset is always clear in mask. */
+		uint32_t n = MIN((uint32_t)__builtin_ctzll(~mask), count);
+		pos += n;
+		count -= n;
+	}
+	*data = pos;
+}
+
+#endif /* defined(HAVE_CPUID) */
+
+#endif /* defined(MP_SKIP_SIMD) */
+
+void
+mp_skip_init(void)
+{
+#if defined(MP_SKIP_SIMD)
+	mp_skip_impl = mp_skip_sse2;
+#if defined(HAVE_CPUID)
+	if (avx2_enabled_cpu())
+		mp_skip_impl = mp_skip_avx2;
+#endif
+#endif
+}
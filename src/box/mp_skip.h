@@ -0,0 +1,44 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+typedef void (*mp_skip_f)(const char **data, uint32_t count);
+
+/*
+ * Pointer to an architecture-specific implementation of
+ * mp_skip(). Set by mp_skip_init().
+ */
+extern mp_skip_f mp_skip_impl;
+
+/**
+ * Skip @a count MessagePack values. Equivalent to calling mp_next()
+ * @a count times, but on x86 skips runs of single-byte values (small
+ * integers, nil and booleans) with one SIMD comparison.
+ *
+ * Unlike mp_next(), may read up to 31 bytes past the last skipped
+ * value, but never crosses a 32 byte aligned boundary doing so, so
+ * it's safe to call on any valid MessagePack data.
+ */
+static inline void
+mp_skip(const char **data, uint32_t count)
+{
+	if (count > 0)
+		mp_skip_impl(data, count);
+}
+
+/** Select the mp_skip() implementation supported by the CPU. */
+void
+mp_skip_init(void);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
@@ -0,0 +1,645 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "read_view_scan.h"
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "coio_task.h"
+#include "diag.h"
+#include "errcode.h"
+#include "fiber.h"
+#include "index.h"
+#include "memtx_tx.h"
+#include "mp_extension_types.h"
+#include "msgpuck.h"
+#include "space.h"
+#include "trivia/util.h"
+#include "tuple_compare.h"
+#include "tuple_format.h"
+#include "txn.h"
+
+enum {
+	/** Max number of tuples read by a worker thread at once. */
+	READ_VIEW_SCAN_BATCH_TUPLES = 16 * 1024,
+	/** Max size of the rows returned by a worker thread at once. */
+	READ_VIEW_SCAN_BATCH_SIZE = 1024 * 1024,
+};
+
+const char *read_view_scan_op_strs[] = {
+	/* [READ_VIEW_SCAN_EQ] = */ "==",
+	/* [READ_VIEW_SCAN_NE] = */ "~=",
+	/* [READ_VIEW_SCAN_LT] = */ "<",
+	/* [READ_VIEW_SCAN_LE] = */ "<=",
+	/* [READ_VIEW_SCAN_GT] = */ ">",
+	/* [READ_VIEW_SCAN_GE] = */ ">=",
+};
+
+const char *read_view_scan_func_strs[] = {
+	/* [READ_VIEW_SCAN_COUNT] = */ "count",
+	/* [READ_VIEW_SCAN_SUM] = */ "sum",
+	/* [READ_VIEW_SCAN_MIN] = */ "min",
+	/* [READ_VIEW_SCAN_MAX] = */ "max",
+};
+
+/** State of an aggregate. */
+struct read_view_scan_agg_state {
+	/** Number of values aggregated so far. */
+	uint64_t count;
+	/**
+	 * Integer part of SUM. It is in the range [INT64_MIN,
+	 * UINT64_MAX] and stored as unsigned unless is_int_neg.
+	 */
+	int64_t int_sum;
+	/** Set if int_sum is negative. */
+	bool is_int_neg;
+	/** Floating point part of SUM. */
+	double double_sum;
+	/** Set if SUM got a floating point value. */
+	bool is_double;
+	/** MIN or MAX value so far, points to tuple data. */
+	const char *value;
+};
+
+struct read_view_scan {
+	/** Iterator over the read view of the primary index. */
+	struct snapshot_iterator *iterator;
+	/** Definition of the scan, points to def_buf. */
+	struct read_view_scan_def def;
+	/** Memory for the arrays and values of the definition. */
+	char *def_buf;
+	/** Number of leading fields of a tuple the scan accesses. */
+	uint32_t field_map_size;
+	/** Positions of the leading fields of the current tuple. */
+	const char **field_map;
+	/** States of the aggregates. */
+	struct read_view_scan_agg_state *agg_states;
+	/** Number of rows returned by the worker threads so far. */
+	uint64_t row_count;
+	/** Rows of the last batch, MessagePack arrays. */
+	char *buf;
+	/** Size of the rows of the last batch. */
+	size_t buf_size;
+	/** Size of the memory allocated for buf. */
+	size_t buf_capacity;
+	/** Position of the next row to return in buf. */
+	size_t buf_pos;
+	/** Set when the read view has no more tuples to scan. */
+	bool is_eof;
+};
+
+/**
+ * Check if a value can be compared with other values the way
+ * SCALAR index parts compare them.
+ */
+static bool
+read_view_scan_value_is_scalar(const char *data)
+{
+	switch (mp_typeof(*data)) {
+	case MP_UINT:
+	case MP_INT:
+	case MP_STR:
+	case MP_BIN:
+	case MP_BOOL:
+	case MP_FLOAT:
+	case MP_DOUBLE:
+		return true;
+	case MP_EXT: {
+		int8_t type;
+		mp_decode_extl(&data, &type);
+		return type == MP_DECIMAL || type == MP_UUID ||
+		       type == MP_DATETIME;
+	}
+	default:
+		return false;
+	}
+}
+
+/** Copy a definition to memory allocated for a scan. */
+static int
+read_view_scan_copy_def(struct read_view_scan *scan,
+			const struct read_view_scan_def *def)
+{
+	size_t values_size = 0;
+	for (uint32_t i = 0; i < def->filter_count; i++) {
+		const char *value = def->filters[i].value;
+		if (!read_view_scan_value_is_scalar(value)) {
+			diag_set(ClientError, ER_ILLEGAL_PARAMS,
+				 "read view scan filter value must be scalar");
+			return -1;
+		}
+		const char *value_end = value;
+		mp_next(&value_end);
+		values_size += value_end - value;
+	}
+	size_t filters_size = def->filter_count * sizeof(*def->filters);
+	size_t aggregates_size =
+		def->aggregate_count * sizeof(*def->aggregates);
+	size_t fields_size = def->field_count * sizeof(*def->fields);
+	size_t size = filters_size + aggregates_size + fields_size +
+		      values_size;
+	char *buf = malloc(size);
+	if (buf == NULL && size > 0) {
+		diag_set(OutOfMemory, size, "malloc", "def_buf");
+		return -1;
+	}
+	scan->def = *def;
+	scan->def_buf = buf;
+	struct read_view_scan_filter *filters =
+		(struct read_view_scan_filter *)buf;
+	memcpy(filters, def->filters, filters_size);
+	scan->def.filters = filters;
+	buf += filters_size;
+	memcpy(buf, def->aggregates, aggregates_size);
+	scan->def.aggregates = (struct read_view_scan_aggregate *)buf;
+	buf += aggregates_size;
+	memcpy(buf, def->fields, fields_size);
+	scan->def.fields = (uint32_t *)buf;
+	buf += fields_size;
+	for (uint32_t i = 0; i < def->filter_count; i++) {
+		const char *value_end = filters[i].value;
+		mp_next(&value_end);
+		size_t value_size = value_end - filters[i].value;
+		memcpy(buf, filters[i].value, value_size);
+		filters[i].value = buf;
+		buf += value_size;
+	}
+	return 0;
+}
+
+bool
+read_view_scan_is_available(void)
+{
+	if (memtx_tx_manager_use_mvcc_engine)
+		return false;
+	struct txn *txn = in_txn();
+	return txn == NULL || stailq_empty(&txn->stmts);
+}
+
+/**
+ * Check if a read view scan can be used in the current context.
+ * Returns 0 if it can, -1 and sets diag otherwise.
+ */
+static int
+read_view_scan_check_available(void)
+{
+	if (memtx_tx_manager_use_mvcc_engine) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Read view scan",
+			 "memtx transaction manager");
+		return -1;
+	}
+	if (!read_view_scan_is_available()) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Read view scan",
+			 "transactions with changes");
+		return -1;
+	}
+	return 0;
+}
+
+struct read_view_scan *
+read_view_scan_new(struct space *space, const struct read_view_scan_def *def)
+{
+	assert(def->aggregate_count == 0 || def->field_count == 0);
+	if (read_view_scan_check_available() != 0)
+		return NULL;
+	if (!space_is_memtx(space)) {
+		diag_set(ClientError, ER_UNSUPPORTED, space->engine->name,
+			 "read view scan");
+		return NULL;
+	}
+	struct index *pk = index_find(space, 0);
+	if (pk == NULL)
+		return NULL;
+	struct read_view_scan *scan = calloc(1, sizeof(*scan));
+	if (scan == NULL) {
+		diag_set(OutOfMemory, sizeof(*scan), "calloc", "scan");
+		return NULL;
+	}
+	if (read_view_scan_copy_def(scan, def) != 0)
+		goto fail;
+	uint32_t field_map_size = 0;
+	for (uint32_t i = 0; i < def->filter_count; i++)
+		field_map_size = MAX(field_map_size, def->filters[i].fieldno + 1);
+	for (uint32_t i = 0; i < def->field_count; i++)
+		field_map_size = MAX(field_map_size, def->fields[i] + 1);
+	for (uint32_t i = 0; i < def->aggregate_count; i++) {
+		uint32_t fieldno = def->aggregates[i].fieldno;
+		if (fieldno != READ_VIEW_SCAN_ALL_FIELDS)
+			field_map_size = MAX(field_map_size, fieldno + 1);
+	}
+	scan->field_map_size = field_map_size;
+	size_t size = field_map_size * sizeof(scan->field_map[0]);
+	scan->field_map = malloc(size);
+	if (scan->field_map == NULL && size > 0) {
+		diag_set(OutOfMemory, size, "malloc", "field_map");
+		goto fail;
+	}
+	size = def->aggregate_count * sizeof(scan->agg_states[0]);
+	scan->agg_states = calloc(1, size);
+	if (scan->agg_states == NULL && size > 0) {
+		diag_set(OutOfMemory, size, "calloc", "agg_states");
+		goto fail;
+	}
+	scan->iterator = index_create_snapshot_iterator(pk);
+	if (scan->iterator == NULL)
+		goto fail;
+	return scan;
+fail:
+	read_view_scan_delete(scan);
+	return NULL;
+}
+
+void
+read_view_scan_delete(struct read_view_scan *scan)
+{
+	if (scan->iterator != NULL)
+		scan->iterator->free(scan->iterator);
+	free(scan->buf);
+	free(scan->agg_states);
+	free(scan->field_map);
+	free(scan->def_buf);
+	free(scan);
+}
+
+/** Reserve space for @a size bytes at the end of the batch buffer. */
+static char *
+read_view_scan_reserve(struct read_view_scan *scan, size_t size)
+{
+	size_t needed = scan->buf_size + size;
+	if (needed > scan->buf_capacity) {
+		size_t capacity = MAX(scan->buf_capacity * 2, 16 * 1024);
+		while (capacity < needed)
+			capacity *= 2;
+		char *buf = realloc(scan->buf, capacity);
+		if (buf == NULL) {
+			diag_set(OutOfMemory, capacity, "realloc", "buf");
+			return NULL;
+		}
+		scan->buf = buf;
+		scan->buf_capacity = capacity;
+	}
+	return scan->buf + scan->buf_size;
+}
+
+/** Return the size of a field, or of NULL if it's missing. */
+static size_t
+read_view_scan_field_size(const char *field)
+{
+	if (field == NULL)
+		return mp_sizeof_nil();
+	const char *field_end = field;
+	mp_next(&field_end);
+	return field_end - field;
+}
+
+/** Encode a field, or NULL if it's missing. */
+static char *
+read_view_scan_encode_field(char *pos, const char *field)
+{
+	if (field == NULL)
+		return mp_encode_nil(pos);
+	size_t size = read_view_scan_field_size(field);
+	memcpy(pos, field, size);
+	return pos + size;
+}
+
+/** Fill the field map with positions of the fields of a tuple. */
+static void
+read_view_scan_locate_fields(struct read_view_scan *scan, const char *data)
+{
+	uint32_t field_count = mp_decode_array(&data);
+	uint32_t count = MIN(field_count, scan->field_map_size);
+	uint32_t i;
+	for (i = 0; i < count; i++) {
+		scan->field_map[i] = data;
+		mp_next(&data);
+	}
+	for (; i < scan->field_map_size; i++)
+		scan->field_map[i] = NULL;
+}
+
+/** Check if the current tuple satisfies all filters. */
+static bool
+read_view_scan_filter(struct read_view_scan *scan)
+{
+	for (uint32_t i = 0; i < scan->def.filter_count; i++) {
+		const struct read_view_scan_filter *filter =
+			&scan->def.filters[i];
+		const char *field = scan->field_map[filter->fieldno];
+		if (field == NULL || !read_view_scan_value_is_scalar(field))
+			return false;
+		int rc = tuple_compare_scalar(field, filter->value);
+		bool is_match;
+		switch (filter->op) {
+		case READ_VIEW_SCAN_EQ:
+			is_match = rc == 0;
+			break;
+		case READ_VIEW_SCAN_NE:
+			is_match = rc != 0;
+			break;
+		case READ_VIEW_SCAN_LT:
+			is_match = rc < 0;
+			break;
+		case READ_VIEW_SCAN_LE:
+			is_match = rc <= 0;
+			break;
+		case READ_VIEW_SCAN_GT:
+			is_match = rc > 0;
+			break;
+		case READ_VIEW_SCAN_GE:
+			is_match = rc >= 0;
+			break;
+		default:
+			unreachable();
+		}
+		if (!is_match)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Add an integer to the integer part of SUM. Both are in the range
+ * [INT64_MIN, UINT64_MAX] and stored as unsigned unless negative.
+ * Returns -1 on overflow.
+ */
+static int
+read_view_scan_add_int(struct read_view_scan_agg_state *state, int64_t value,
+		       bool is_neg)
+{
+	if (state->is_int_neg && is_neg) {
+		int64_t res;
+		if (__builtin_add_overflow(state->int_sum, value, &res))
+			return -1;
+		state->int_sum = res;
+	} else if (!state->is_int_neg && !is_neg) {
+		uint64_t res;
+		if (__builtin_add_overflow((uint64_t)state->int_sum,
+					   (uint64_t)value, &res))
+			return -1;
+		state->int_sum = res;
+	} else {
+		/*
+		 * The sum of a non-negative and a negative number
+		 * always fits in the range and is computed correctly
+		 * modulo 2^64.
+		 */
+		uint64_t pos = is_neg ? state->int_sum : value;
+		int64_t neg = is_neg ? value : state->int_sum;
+		uint64_t neg_abs = (uint64_t)(-(neg + 1)) + 1;
+		state->int_sum = (int64_t)(pos + (uint64_t)neg);
+		state->is_int_neg = pos < neg_abs;
+	}
+	return 0;
+}
+
+/** Update the aggregates with the current tuple. */
+static int
+read_view_scan_aggregate(struct read_view_scan *scan)
+{
+	for (uint32_t i = 0; i < scan->def.aggregate_count; i++) {
+		const struct read_view_scan_aggregate *agg =
+			&scan->def.aggregates[i];
+		struct read_view_scan_agg_state *state = &scan->agg_states[i];
+		if (agg->fieldno == READ_VIEW_SCAN_ALL_FIELDS) {
+			assert(agg->func == READ_VIEW_SCAN_COUNT);
+			state->count++;
+			continue;
+		}
+		const char *field = scan->field_map[agg->fieldno];
+		if (field == NULL || mp_typeof(*field) == MP_NIL)
+			continue;
+		switch (agg->func) {
+		case READ_VIEW_SCAN_COUNT:
+			break;
+		case READ_VIEW_SCAN_SUM: {
+			const char *pos = field;
+			int rc = 0;
+			switch (mp_typeof(*field)) {
+			case MP_UINT:
+				rc = read_view_scan_add_int(
+					state, mp_decode_uint(&pos), false);
+				break;
+			case MP_INT:
+				rc = read_view_scan_add_int(
+					state, mp_decode_int(&pos), true);
+				break;
+			case MP_FLOAT:
+				state->double_sum += mp_decode_float(&pos);
+				state->is_double = true;
+				break;
+			case MP_DOUBLE:
+				state->double_sum += mp_decode_double(&pos);
+				state->is_double = true;
+				break;
+			default:
+				diag_set(ClientError, ER_FIELD_TYPE,
+					 int2str(agg->fieldno +
+						 TUPLE_INDEX_BASE),
+					 "number", mp_type_strs[mp_typeof(*field)]);
+				return -1;
+			}
+			if (rc != 0) {
+				diag_set(ClientError,
+					 ER_UPDATE_INTEGER_OVERFLOW, '+',
+					 int2str(agg->fieldno +
+						 TUPLE_INDEX_BASE));
+				return -1;
+			}
+			break;
+		}
+		case READ_VIEW_SCAN_MIN:
+		case READ_VIEW_SCAN_MAX: {
+			if (!read_view_scan_value_is_scalar(field))
+				continue;
+			if (state->value == NULL) {
+				state->value = field;
+				break;
+			}
+			int rc = tuple_compare_scalar(field, state->value);
+			if (agg->func == READ_VIEW_SCAN_MIN ? rc < 0 : rc > 0)
+				state->value = field;
+			break;
+		}
+		default:
+			unreachable();
+		}
+		state->count++;
+	}
+	return 0;
+}
+
+/** Append the row of the aggregate values to the batch buffer. */
+static int
+read_view_scan_add_aggregate_row(struct read_view_scan *scan)
+{
+	uint32_t count = scan->def.aggregate_count;
+	size_t size = mp_sizeof_array(count);
+	for (uint32_t i = 0; i < count; i++) {
+		struct read_view_scan_agg_state *state = &scan->agg_states[i];
+		size += MAX(mp_sizeof_uint(UINT64_MAX), mp_sizeof_double(0)) +
+			read_view_scan_field_size(state->value);
+	}
+	char *pos = read_view_scan_reserve(scan, size);
+	if (pos == NULL)
+		return -1;
+	char *begin = pos;
+	pos = mp_encode_array(pos, count);
+	for (uint32_t i = 0; i < count; i++) {
+		const struct read_view_scan_aggregate *agg =
+			&scan->def.aggregates[i];
+		struct read_view_scan_agg_state *state = &scan->agg_states[i];
+		switch (agg->func) {
+		case READ_VIEW_SCAN_COUNT:
+			pos = mp_encode_uint(pos, state->count);
+			break;
+		case READ_VIEW_SCAN_SUM:
+			if (state->count == 0) {
+				pos = mp_encode_nil(pos);
+			} else if (state->is_double) {
+				double sum = state->double_sum;
+				if (state->is_int_neg)
+					sum += state->int_sum;
+				else
+					sum += (uint64_t)state->int_sum;
+				pos = mp_encode_double(pos, sum);
+			} else if (state->is_int_neg) {
+				pos = mp_encode_int(pos, state->int_sum);
+			} else {
+				pos = mp_encode_uint(pos, state->int_sum);
+			}
+			break;
+		case READ_VIEW_SCAN_MIN:
+		case READ_VIEW_SCAN_MAX:
+			if (state->value == NULL)
+				pos = mp_encode_nil(pos);
+			else
+				pos = read_view_scan_encode_field(pos,
+								  state->value);
+			break;
+		default:
+			unreachable();
+		}
+	}
+	scan->buf_size += pos - begin;
+	scan->row_count++;
+	return 0;
+}
+
+/** Append the current tuple or its projection to the batch buffer. */
+static int
+read_view_scan_add_row(struct read_view_scan *scan, const char *data,
+		       uint32_t data_size)
+{
+	if (scan->def.field_count == 0) {
+		char *pos = read_view_scan_reserve(scan, data_size);
+		if (pos == NULL)
+			return -1;
+		memcpy(pos, data, data_size);
+		scan->buf_size += data_size;
+		scan->row_count++;
+		return 0;
+	}
+	uint32_t count = scan->def.field_count;
+	size_t size = mp_sizeof_array(count);
+	for (uint32_t i = 0; i < count; i++) {
+		const char *field = scan->field_map[scan->def.fields[i]];
+		size += read_view_scan_field_size(field);
+	}
+	char *pos = read_view_scan_reserve(scan, size);
+	if (pos == NULL)
+		return -1;
+	pos = mp_encode_array(pos, count);
+	for (uint32_t i = 0; i < count; i++) {
+		const char *field = scan->field_map[scan->def.fields[i]];
+		pos = read_view_scan_encode_field(pos, field);
+	}
+	scan->buf_size += size;
+	scan->row_count++;
+	return 0;
+}
+
+/**
+ * Process the next batch of tuples of the read view. Rows to
+ * return are stored in the batch buffer. Doesn't access anything
+ * but the scan and the read view, so it may be called from any
+ * thread.
+ */
+static int
+read_view_scan_batch(struct read_view_scan *scan)
+{
+	assert(!scan->is_eof);
+	scan->buf_size = 0;
+	scan->buf_pos = 0;
+	bool is_aggregate = scan->def.aggregate_count > 0;
+	for (int i = 0; i < READ_VIEW_SCAN_BATCH_TUPLES; i++) {
+		if (!is_aggregate && scan->row_count >= scan->def.limit) {
+			scan->is_eof = true;
+			return 0;
+		}
+		if (scan->buf_size >= READ_VIEW_SCAN_BATCH_SIZE)
+			return 0;
+		const char *data;
+		uint32_t size;
+		if (scan->iterator->next(scan->iterator, &data, &size) != 0)
+			return -1;
+		if (data == NULL) {
+			scan->is_eof = true;
+			break;
+		}
+		read_view_scan_locate_fields(scan, data);
+		if (!read_view_scan_filter(scan))
+			continue;
+		int rc = is_aggregate ? read_view_scan_aggregate(scan) :
+			 read_view_scan_add_row(scan, data, size);
+		if (rc != 0)
+			return -1;
+	}
+	if (scan->is_eof && is_aggregate && scan->def.limit > 0)
+		return read_view_scan_add_aggregate_row(scan);
+	return 0;
+}
+
+static ssize_t
+read_view_scan_batch_f(va_list ap)
+{
+	struct read_view_scan *scan = va_arg(ap, struct read_view_scan *);
+	return read_view_scan_batch(scan);
+}
+
+int
+read_view_scan_next(struct read_view_scan *scan, const char **row)
+{
+	while (scan->buf_pos == scan->buf_size) {
+		if (scan->is_eof) {
+			*row = NULL;
+			return 0;
+		}
+		if (fiber_is_cancelled()) {
+			diag_set(FiberIsCancelled);
+			return -1;
+		}
+		if (read_view_scan_check_available() != 0)
+			return -1;
+		struct txn *txn = in_txn();
+		int rc;
+		if (txn != NULL && !txn_has_flag(txn, TXN_CAN_YIELD)) {
+			/* A yield would abort the transaction. */
+			rc = read_view_scan_batch(scan);
+		} else {
+			rc = coio_call(read_view_scan_batch_f, scan);
+		}
+		if (rc != 0)
+			return -1;
+	}
+	const char *pos = scan->buf + scan->buf_pos;
+	*row = pos;
+	mp_next(&pos);
+	scan->buf_pos = pos - scan->buf;
+	return 0;
+}
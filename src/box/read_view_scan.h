@@ -0,0 +1,155 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+/*
+ * Full scan of a memtx space over a read view, run in the coio
+ * worker thread pool (see box.cfg.worker_pool_threads).
+ *
+ * A scan opens a snapshot iterator over the primary index of a
+ * space in the tx thread. The iterator sees the data as of the
+ * moment the scan was created, like the one used for checkpoints,
+ * and is safe to use from another thread. Tuples are then read,
+ * filtered, projected and aggregated by a worker thread in batches
+ * while the calling fiber waits and the tx thread serves other
+ * requests. If the current transaction doesn't allow yields, the
+ * batches are processed in the tx thread instead.
+ *
+ * Only raw MessagePack is accessed by the worker threads, so the
+ * filters and aggregates work on field numbers and compare values
+ * the way SCALAR index parts do, without collations.
+ *
+ * A read view doesn't see changes made by the current transaction
+ * and isn't tracked by the memtx transaction manager, so a scan
+ * can't be used in a transaction that has changed anything or if
+ * the manager is enabled.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct space;
+struct read_view_scan;
+
+/** Comparison operator of a read view scan filter. */
+enum read_view_scan_op {
+	READ_VIEW_SCAN_EQ,
+	READ_VIEW_SCAN_NE,
+	READ_VIEW_SCAN_LT,
+	READ_VIEW_SCAN_LE,
+	READ_VIEW_SCAN_GT,
+	READ_VIEW_SCAN_GE,
+	read_view_scan_op_MAX,
+};
+
+/** Names of the filter operators, e.g. "==" or "<". */
+extern const char *read_view_scan_op_strs[];
+
+/** Aggregate function of a read view scan. */
+enum read_view_scan_func {
+	READ_VIEW_SCAN_COUNT,
+	READ_VIEW_SCAN_SUM,
+	READ_VIEW_SCAN_MIN,
+	READ_VIEW_SCAN_MAX,
+	read_view_scan_func_MAX,
+};
+
+/** Names of the aggregate functions, e.g. "count". */
+extern const char *read_view_scan_func_strs[];
+
+/**
+ * A condition a tuple must satisfy to be returned by a scan:
+ * <field> <op> <value>. A tuple with a NULL, missing or
+ * non-scalar field never satisfies it.
+ */
+struct read_view_scan_filter {
+	/** Number of the field to check, 0-based. */
+	uint32_t fieldno;
+	/** Comparison operator. */
+	enum read_view_scan_op op;
+	/** MessagePack value to compare the field with. */
+	const char *value;
+};
+
+/**
+ * An aggregate computed over the tuples satisfying the filters.
+ * NULL and missing fields are skipped. SUM and MIN/MAX return NULL
+ * if there are no other values.
+ */
+struct read_view_scan_aggregate {
+	/** Aggregate function. */
+	enum read_view_scan_func func;
+	/**
+	 * Number of the field to aggregate, 0-based. Set to
+	 * READ_VIEW_SCAN_ALL_FIELDS to count the tuples.
+	 */
+	uint32_t fieldno;
+};
+
+enum {
+	/** Pseudo field number: COUNT counts whole tuples. */
+	READ_VIEW_SCAN_ALL_FIELDS = UINT32_MAX,
+};
+
+/** Definition of a read view scan. */
+struct read_view_scan_def {
+	/** Conditions a tuple must satisfy, all of them. */
+	const struct read_view_scan_filter *filters;
+	/** Number of filters. */
+	uint32_t filter_count;
+	/**
+	 * Numbers of the fields, 0-based, a row returned by the scan
+	 * consists of. If there are no fields and no aggregates,
+	 * whole tuples are returned.
+	 */
+	const uint32_t *fields;
+	/** Number of fields. */
+	uint32_t field_count;
+	/**
+	 * Aggregates. If there are any, the scan returns a single
+	 * row of their values and @a fields must be empty.
+	 */
+	const struct read_view_scan_aggregate *aggregates;
+	/** Number of aggregates. */
+	uint32_t aggregate_count;
+	/** Max number of rows to return. */
+	uint64_t limit;
+};
+
+/**
+ * Check if a read view scan can be used in the current context,
+ * see the comment at the top of the file.
+ */
+bool
+read_view_scan_is_available(void);
+
+/**
+ * Open a read view of a memtx space and create a scan over it.
+ * The definition is copied. Returns NULL and sets diag on error.
+ */
+struct read_view_scan *
+read_view_scan_new(struct space *space, const struct read_view_scan_def *def);
+
+/** Close the read view and delete a scan. */
+void
+read_view_scan_delete(struct read_view_scan *scan);
+
+/**
+ * Return the next row of a scan, a MessagePack array, or NULL if
+ * there are no more rows. The row stays valid until the next call.
+ * Yields while the worker thread processes a batch of tuples.
+ * Fails if the scan can't be used in the current context anymore.
+ * Returns 0 on success, -1 and sets diag on error.
+ */
+int
+read_view_scan_next(struct read_view_scan *scan, const char **row);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
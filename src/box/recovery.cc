@@ -41,7 +41,9 @@
 #include "replication.h"
 #include "session.h"
 #include "coio_file.h"
+#include "xlog_reader.h"
 #include "error.h"
+#include "errinj.h"
 
 /*
  * Recovery subsystem
@@ -112,6 +114,8 @@ recovery_new(const char *wal_dirname, bool force_recovery,
 
 	r->watcher = NULL;
 	rlist_create(&r->on_close_log);
+	r->use_reader_thread = false;
+	r->is_hot_standby = false;
 
 	guard.is_active = false;
 	return r;
@@ -235,6 +239,47 @@ recovery_delete(struct recovery *r)
 	free(r);
 }
 
+/**
+ * Apply a row read from a WAL file unless it has already been
+ * applied. If @a request is not NULL and its header is set, it
+ * is the DML request decoded from the row.
+ */
+static void
+recovery_apply_row(struct recovery *r, struct xstream *stream,
+		   struct xrow_header *row, struct request *request)
+{
+	int64_t current_lsn = vclock_get(&r->vclock, row->replica_id);
+	if (row->lsn <= current_lsn)
+		return; /* already applied, skip */
+
+	/*
+	 * All rows in xlog files have an assigned replica
+	 * id. The only exception are local rows, which
+	 * are signed with a zero replica id.
+	 */
+	assert(row->replica_id != 0 || row->group_id == GROUP_LOCAL);
+	/*
+	 * We can promote the vclock either before or
+	 * after xstream_write(): it only makes any impact
+	 * in case of forced recovery, when we skip the
+	 * failed row anyway.
+	 */
+	vclock_follow_xrow(&r->vclock, row);
+	int rc;
+	if (request != NULL && request->header != NULL)
+		rc = xstream_write_request(stream, request);
+	else
+		rc = xstream_write(stream, row);
+	if (rc != 0) {
+		if (!r->wal_dir.force_recovery)
+			diag_raise();
+
+		say_error("skipping row {%u: %lld}",
+			  (unsigned)row->replica_id, (long long)row->lsn);
+		diag_log();
+	}
+}
+
 /**
  * Read all rows in a file starting from the last position.
  * Advance the position. If end of file is reached,
@@ -267,32 +312,151 @@ recover_xlog(struct recovery *r, struct xstream *stream,
 		if (stop_vclock != NULL &&
 		    r->vclock.signature >= stop_vclock->signature)
 			return;
-		int64_t current_lsn = vclock_get(&r->vclock, row.replica_id);
-		if (row.lsn <= current_lsn)
-			continue; /* already applied, skip */
+		recovery_apply_row(r, stream, &row, NULL);
+	}
+}
 
-		/*
-		 * All rows in xlog files have an assigned replica
-		 * id. The only exception are local rows, which
-		 * are signed with a zero replica id.
-		 */
-		assert(row.replica_id != 0 || row.group_id == GROUP_LOCAL);
-		/*
-		 * We can promote the vclock either before or
-		 * after xstream_write(): it only makes any impact
-		 * in case of forced recovery, when we skip the
-		 * failed row anyway.
-		 */
-		vclock_follow_xrow(&r->vclock, &row);
-		if (xstream_write(stream, &row) != 0) {
-			if (!r->wal_dir.force_recovery)
-				diag_raise();
-
-			say_error("skipping row {%u: %lld}",
-				  (unsigned)row.replica_id, (long long)row.lsn);
-			diag_log();
+enum {
+	/**
+	 * Max number of WAL files read by reader threads at the same
+	 * time: while the rows of one file are applied, the files
+	 * following it are read ahead.
+	 */
+	RECOVERY_READERS_MAX = 2,
+};
+
+/** Reader threads of the WAL files that are going to be applied. */
+struct recovery_readers {
+	/**
+	 * Ring buffer of readers, in the order of the files.
+	 * Allocated when the first reader is started.
+	 */
+	struct xlog_reader *readers;
+	/** Files read by the readers. */
+	struct vclock *vclocks[RECOVERY_READERS_MAX];
+	/** Index of the reader of the file to be applied next. */
+	int first;
+	/** Number of running readers. */
+	int count;
+};
+
+static void
+recovery_readers_create(struct recovery_readers *readers)
+{
+	readers->readers = NULL;
+	readers->first = 0;
+	readers->count = 0;
+}
+
+/** Stop the reader of the file to be applied next. */
+static void
+recovery_readers_pop(struct recovery_readers *readers)
+{
+	assert(readers->count > 0);
+	xlog_reader_stop(&readers->readers[readers->first]);
+	readers->first = (readers->first + 1) % RECOVERY_READERS_MAX;
+	readers->count--;
+}
+
+static void
+recovery_readers_destroy(struct recovery_readers *readers)
+{
+	while (readers->count > 0)
+		recovery_readers_pop(readers);
+	free(readers->readers);
+}
+
+/**
+ * Check if a WAL file may be read by a reader thread. The last
+ * file isn't in hot standby mode, because it is being written by
+ * the master and is followed by the tx thread after recovery.
+ */
+static bool
+recovery_can_use_reader(struct recovery *r, struct vclock *clock)
+{
+	return r->use_reader_thread &&
+	       (!r->is_hot_standby ||
+		vclockset_next(&r->wal_dir.index, clock) != NULL);
+}
+
+/**
+ * Make sure reader threads are running for the given file and
+ * for the files following it, up to RECOVERY_READERS_MAX files.
+ */
+static void
+recovery_readers_fill(struct recovery *r, struct recovery_readers *readers,
+		      struct vclock *clock)
+{
+	if (readers->readers == NULL) {
+		readers->readers = (struct xlog_reader *)
+			xcalloc(RECOVERY_READERS_MAX,
+				sizeof(struct xlog_reader));
+	}
+	if (readers->count > 0) {
+		int last = (readers->first + readers->count - 1) %
+			   RECOVERY_READERS_MAX;
+		clock = vclockset_next(&r->wal_dir.index,
+				       readers->vclocks[last]);
+	}
+	for (; clock != NULL && readers->count < RECOVERY_READERS_MAX &&
+	       recovery_can_use_reader(r, clock);
+	     clock = vclockset_next(&r->wal_dir.index, clock)) {
+		int i = (readers->first + readers->count) %
+			RECOVERY_READERS_MAX;
+		const char *filename = xdir_format_filename(
+			&r->wal_dir, vclock_sum(clock), NONE);
+		if (xlog_reader_start(&readers->readers[i], filename,
+				      r->wal_dir.force_recovery, 0) != 0)
+			diag_raise();
+		readers->vclocks[i] = clock;
+		readers->count++;
+#ifndef NDEBUG
+		++errinj(ERRINJ_WAL_READER_COUNT, ERRINJ_INT)->iparam;
+#endif
+	}
+}
+
+/**
+ * Apply the rows of the current WAL file read and decoded by
+ * a reader thread, which was started by recovery_readers_fill().
+ * The file must have just been opened. The tx thread only applies
+ * the rows.
+ */
+static void
+recover_xlog_in_thread(struct recovery *r, struct xstream *stream,
+		       struct recovery_readers *readers)
+{
+	assert(readers->count > 0);
+	assert(vclock_sum(readers->vclocks[readers->first]) ==
+	       vclock_sum(&r->cursor.meta.vclock));
+	struct xlog_reader *reader = &readers->readers[readers->first];
+	struct xrow_header *rows;
+	struct request *requests;
+	int row_count;
+	while (true) {
+		if (xlog_reader_next(reader, &rows, &requests,
+				     &row_count) != 0)
+			diag_raise();
+		if (row_count == 0)
+			break;
+		for (int i = 0; i < row_count; i++) {
+			if (++stream->row_count % WAL_ROWS_PER_YIELD == 0)
+				xstream_yield(stream);
+			if (stream->row_count % 100000 == 0) {
+				say_info_ratelimited("%.1fM rows processed",
+						     stream->row_count / 1e6);
+			}
+			recovery_apply_row(r, stream, &rows[i], &requests[i]);
 		}
 	}
+	/*
+	 * The cursor opened by the tx thread was only used to check
+	 * the file meta. Mark it as read up to the end so that the
+	 * file is closed as if it was read by the tx thread.
+	 */
+	if (reader->is_eof)
+		r->cursor.state = XLOG_CURSOR_EOF;
+	recovery_readers_pop(readers);
 }
 
 /**
@@ -311,10 +475,16 @@ recover_remaining_wals(struct recovery *r, struct xstream *stream,
 		       const struct vclock *stop_vclock, bool scan_dir)
 {
 	struct vclock *clock;
+	struct recovery_readers readers;
 
 	if (scan_dir)
 		xdir_scan_xc(&r->wal_dir, true);
 
+	recovery_readers_create(&readers);
+	auto readers_guard = make_scoped_guard([&]{
+		recovery_readers_destroy(&readers);
+	});
+
 	if (xlog_cursor_is_open(&r->cursor)) {
 		/* If there's a WAL open, recover from it first. */
 		assert(!xlog_cursor_is_eof(&r->cursor));
@@ -351,6 +521,12 @@ recover_remaining_wals(struct recovery *r, struct xstream *stream,
 
 		say_info("recover from `%s'", r->cursor.name);
 
+		if (stop_vclock == NULL &&
+		    recovery_can_use_reader(r, clock)) {
+			recovery_readers_fill(r, &readers, clock);
+			recover_xlog_in_thread(r, stream, &readers);
+			continue;
+		}
 recover_current_wal:
 		recover_xlog(r, stream, stop_vclock);
 	}
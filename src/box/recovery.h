@@ -56,6 +56,17 @@ struct recovery {
 	struct fiber *watcher;
 	/** List of triggers invoked when the current WAL is closed. */
 	struct rlist on_close_log;
+	/**
+	 * If set, WAL files are read and decoded on separate threads
+	 * while the rows read before are applied by the caller.
+	 */
+	bool use_reader_thread;
+	/**
+	 * Set if the WAL directory is written by another instance,
+	 * which is followed in hot standby mode. The last WAL file
+	 * is read by the tx thread then.
+	 */
+	bool is_hot_standby;
 };
 
 struct recovery *
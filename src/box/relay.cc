@@ -44,6 +44,7 @@
 #include "engine.h"
 #include "gc.h"
 #include "iostream.h"
+#include "iproto_compression.h"
 #include "iproto_constants.h"
 #include "recovery.h"
 #include "replication.h"
@@ -58,6 +59,15 @@
 #include "raft.h"
 
 #include <stdlib.h>
+#include <msgpuck.h>
+
+enum {
+	/**
+	 * Size of the rows a compressed relay buffers before
+	 * compressing them into one packet, see relay_flush().
+	 */
+	RELAY_COMPRESSION_BATCH_SIZE = 64 * 1024,
+};
 
 /**
  * Cbus message to send status updates from relay to tx thread.
@@ -120,6 +130,14 @@ struct relay {
 	struct replica *replica;
 	/** WAL event watcher. */
 	struct wal_watcher wal_watcher;
+	/** Reader of the in-memory WAL tail. */
+	struct wal_tail_cursor wal_tail;
+	/**
+	 * Set if the relay has caught up with the WAL writer and
+	 * sends rows from the in-memory WAL tail instead of
+	 * reading them from xlog files.
+	 */
+	bool is_in_wal_tail;
 	/** Relay reader cond. */
 	struct fiber_cond reader_cond;
 	/** Relay diagnostics. */
@@ -135,6 +153,21 @@ struct relay {
 	 * is passed by the replica on subscribe.
 	 */
 	uint32_t id_filter;
+	/** Features supported by the replica as sent on subscribe. */
+	struct iproto_features features;
+	/**
+	 * Compressor of the rows sent to the replica or zstream is
+	 * NULL if the rows are sent uncompressed. Used only by the
+	 * subscribe relay thread.
+	 */
+	struct iproto_compressor compressor;
+	/**
+	 * Rows to be compressed into one packet on the next flush,
+	 * see relay_flush().
+	 */
+	struct ibuf rowbuf;
+	/** Buffer for compressed rows. */
+	struct ibuf zbuf;
 	/**
 	 * Local vclock at the moment of subscribe, used to check
 	 * dataset on the other side and send missing data rows if any.
@@ -237,6 +270,8 @@ relay_txn_lag(const struct relay *relay)
 static void
 relay_send(struct relay *relay, struct xrow_header *packet);
 static void
+relay_flush(struct relay *relay);
+static void
 relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row);
 static void
 relay_send_row(struct xstream *stream, struct xrow_header *row);
@@ -298,6 +333,7 @@ relay_yield_and_send_heartbeat(struct xstream *stream)
 	    replication_timeout) {
 		relay_send_heartbeat(relay);
 	}
+	relay_flush(relay);
 	fiber_sleep(0);
 }
 
@@ -653,6 +689,73 @@ relay_set_error(struct relay *relay, struct error *e)
 		diag_set_error(&relay->diag, e);
 }
 
+/**
+ * Recreate the recovery object of the relay so that it starts
+ * reading xlog files from the given vclock. The current xlog file
+ * is closed without invoking the on_close_log triggers.
+ */
+static void
+relay_reset_recovery(struct relay *relay, const struct vclock *vclock)
+{
+	struct recovery *r = recovery_new(wal_dir(), false, vclock);
+	rlist_swap(&relay->r->on_close_log, &r->on_close_log);
+	recovery_delete(relay->r);
+	relay->r = r;
+}
+
+/**
+ * Switch the relay to sending rows from the in-memory WAL tail
+ * if the tail stores all rows the relay hasn't sent yet.
+ */
+static void
+relay_try_enter_wal_tail(struct relay *relay)
+{
+	assert(!relay->is_in_wal_tail);
+	if (wal_tail_cursor_create(&relay->wal_tail, &relay->r->vclock) != 0)
+		return;
+	/* The current xlog file isn't needed anymore. */
+	relay_reset_recovery(relay, &relay->r->vclock);
+	relay->is_in_wal_tail = true;
+}
+
+static void
+relay_leave_wal_tail(struct relay *relay)
+{
+	wal_tail_cursor_destroy(&relay->wal_tail);
+	relay->is_in_wal_tail = false;
+}
+
+/**
+ * Send new rows from the in-memory WAL tail. Returns 0 on success,
+ * 1 if the relay has fallen behind the tail and has to switch back
+ * to reading xlog files.
+ */
+static int
+relay_send_wal_tail(struct relay *relay)
+{
+	assert(relay->is_in_wal_tail);
+	struct recovery *r = relay->r;
+	const char *data, *data_end;
+	while (true) {
+		if (wal_tail_cursor_next(&relay->wal_tail,
+					 &data, &data_end) != 0)
+			return 1;
+		if (data == NULL)
+			return 0;
+		while (data < data_end) {
+			uint32_t len = mp_decode_uint(&data);
+			struct xrow_header row;
+			xrow_header_decode_xc(&row, &data, data + len, true);
+			if (++relay->stream.row_count % WAL_ROWS_PER_YIELD == 0)
+				xstream_yield(&relay->stream);
+			if (row.lsn <= vclock_get(&r->vclock, row.replica_id))
+				continue; /* already sent, skip */
+			vclock_follow_xrow(&r->vclock, &row);
+			xstream_write_xc(&relay->stream, &row);
+		}
+	}
+}
+
 static void
 relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 {
@@ -670,8 +773,28 @@ relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 		return;
 	}
 	try {
+		bool scan_dir = (events & WAL_EVENT_ROTATE) != 0;
+		if (relay->is_in_wal_tail) {
+			if (relay_send_wal_tail(relay) == 0) {
+				/*
+				 * No xlog file is read in this mode so let
+				 * the garbage collector know that the relay
+				 * is done with the rotated one.
+				 */
+				if (scan_dir)
+					trigger_run_xc(&relay->r->on_close_log,
+						       NULL);
+				relay_flush(relay);
+				return;
+			}
+			relay_leave_wal_tail(relay);
+			relay_reset_recovery(relay, &relay->r->vclock);
+			scan_dir = true;
+		}
 		recover_remaining_wals(relay->r, &relay->stream, NULL,
-				       (events & WAL_EVENT_ROTATE) != 0);
+				       scan_dir);
+		relay_try_enter_wal_tail(relay);
+		relay_flush(relay);
 	} catch (Exception *e) {
 		relay_set_error(relay, e);
 		fiber_cancel(fiber());
@@ -727,6 +850,7 @@ relay_send_heartbeat(struct relay *relay)
 	xrow_encode_timestamp(&row, instance_id, ev_now(loop()));
 	try {
 		relay_send(relay, &row);
+		relay_flush(relay);
 	} catch (Exception *e) {
 		relay_set_error(relay, e);
 		fiber_cancel(fiber());
@@ -831,6 +955,19 @@ relay_subscribe_f(va_list ap)
 	coio_enable();
 	relay_set_cord_name(relay->io->fd);
 
+	/* Compress the stream if the replica supports it. */
+	int level = iproto_compression_level;
+	if (level > 0 && iproto_features_test(&relay->features,
+					      IPROTO_FEATURE_COMPRESSION)) {
+		if (iproto_compressor_create(&relay->compressor, level) == 0) {
+			ibuf_create(&relay->rowbuf, &cord()->slabc,
+				    RELAY_COMPRESSION_BATCH_SIZE);
+			ibuf_create(&relay->zbuf, &cord()->slabc, 16 * 1024);
+		} else {
+			diag_log();
+		}
+	}
+
 	/* Create cpipe to tx for propagating vclock. */
 	cbus_endpoint_create(&relay->endpoint, tt_sprintf("relay_%p", relay),
 			     fiber_schedule_cb, fiber());
@@ -852,6 +989,8 @@ relay_subscribe_f(va_list ap)
 		trigger_add(&relay->r->on_close_log, &on_close_log);
 
 	/* Setup WAL watcher for sending new rows to the replica. */
+	relay->is_in_wal_tail = false;
+	relay->wal_tail.batch = NULL;
 	wal_set_watcher(&relay->wal_watcher, relay->endpoint.name,
 			relay_process_wal_event, cbus_process);
 
@@ -931,6 +1070,7 @@ relay_subscribe_f(va_list ap)
 	 */
 	trigger_clear(&on_close_log);
 	wal_clear_watcher(&relay->wal_watcher, cbus_process);
+	relay_leave_wal_tail(relay);
 
 	/* Join ack reader fiber. */
 	fiber_cancel(reader);
@@ -941,6 +1081,13 @@ relay_subscribe_f(va_list ap)
 		    NULL, NULL, cbus_process);
 	cbus_endpoint_destroy(&relay->endpoint, cbus_process);
 
+	if (relay->compressor.zstream != NULL) {
+		iproto_compressor_destroy(&relay->compressor);
+		relay->compressor.zstream = NULL;
+		ibuf_destroy(&relay->rowbuf);
+		ibuf_destroy(&relay->zbuf);
+	}
+
 	relay_exit(relay);
 
 	/*
@@ -959,7 +1106,8 @@ relay_subscribe_f(va_list ap)
 void
 relay_subscribe(struct replica *replica, struct iostream *io, uint64_t sync,
 		struct vclock *replica_clock, uint32_t replica_version_id,
-		uint32_t replica_id_filter)
+		uint32_t replica_id_filter,
+		const struct iproto_features *replica_features)
 {
 	assert(replica->anon || replica->id != REPLICA_ID_NIL);
 	struct relay *relay = replica->relay;
@@ -996,6 +1144,7 @@ relay_subscribe(struct replica *replica, struct iostream *io, uint64_t sync,
 	relay->version_id = replica_version_id;
 
 	relay->id_filter = replica_id_filter;
+	relay->features = *replica_features;
 
 	int rc = cord_costart(&relay->cord, "subscribe",
 			      relay_subscribe_f, relay);
@@ -1005,6 +1154,62 @@ relay_subscribe(struct replica *replica, struct iostream *io, uint64_t sync,
 		diag_raise();
 }
 
+/**
+ * Write the rows buffered since the last flush to the replica,
+ * wrapping them into one IPROTO_COMPRESSED packet unless they're
+ * too small to bother. Does nothing if the stream isn't compressed.
+ */
+static void
+relay_flush(struct relay *relay)
+{
+	if (relay->compressor.zstream == NULL)
+		return;
+	struct ibuf *rowbuf = &relay->rowbuf;
+	size_t size = ibuf_used(rowbuf);
+	if (size == 0)
+		return;
+	if (size < iproto_compression_min_size) {
+		if (coio_write_timeout(relay->io, rowbuf->rpos, size,
+				       TIMEOUT_INFINITY) < 0)
+			diag_raise();
+		ibuf_reset(rowbuf);
+		return;
+	}
+	struct ibuf *zbuf = &relay->zbuf;
+	ibuf_reset(zbuf);
+	struct iovec iov = {rowbuf->rpos, size};
+	if (iproto_compressor_begin(&relay->compressor, zbuf) != 0 ||
+	    iproto_compressor_write(&relay->compressor, &iov, 1, zbuf) != 0 ||
+	    iproto_compressor_end(&relay->compressor, zbuf) != 0)
+		diag_raise();
+	ibuf_reset(rowbuf);
+	if (coio_write_timeout(relay->io, zbuf->rpos, ibuf_used(zbuf),
+			       TIMEOUT_INFINITY) < 0)
+		diag_raise();
+}
+
+/**
+ * Buffer a row to be compressed together with the following ones,
+ * see relay_flush(). The rows are flushed once there are enough of
+ * them and whenever the relay is about to wait or yield.
+ */
+static void
+relay_write_compressed(struct relay *relay, const struct xrow_header *packet)
+{
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_to_iovec_xc(packet, iov);
+	for (int i = 0; i < iovcnt; i++) {
+		void *data = ibuf_alloc(&relay->rowbuf, iov[i].iov_len);
+		if (data == NULL) {
+			tnt_raise(OutOfMemory, iov[i].iov_len,
+				  "ibuf_alloc", "row");
+		}
+		memcpy(data, iov[i].iov_base, iov[i].iov_len);
+	}
+	if (ibuf_used(&relay->rowbuf) >= RELAY_COMPRESSION_BATCH_SIZE)
+		relay_flush(relay);
+}
+
 static void
 relay_send(struct relay *relay, struct xrow_header *packet)
 {
@@ -1012,7 +1217,10 @@ relay_send(struct relay *relay, struct xrow_header *packet)
 
 	packet->sync = relay->sync;
 	relay->last_row_time = ev_monotonic_now(loop());
-	coio_write_xrow(relay->io, packet);
+	if (relay->compressor.zstream != NULL)
+		relay_write_compressed(relay, packet);
+	else
+		coio_write_xrow(relay->io, packet);
 	fiber_gc();
 
 	struct errinj *inj = errinj(ERRINJ_RELAY_TIMEOUT, ERRINJ_DOUBLE);
@@ -1062,11 +1270,10 @@ relay_restart_recovery(struct relay *relay)
 	struct vclock restart_vclock;
 	vclock_copy(&restart_vclock, &relay->recv_vclock);
 	vclock_reset(&restart_vclock, 0, vclock_get(&relay->r->vclock, 0));
-	struct recovery *r = recovery_new(wal_dir(), false, &restart_vclock);
-	rlist_swap(&relay->r->on_close_log, &r->on_close_log);
-	recovery_delete(relay->r);
-	relay->r = r;
+	relay_leave_wal_tail(relay);
+	relay_reset_recovery(relay, &restart_vclock);
 	recover_remaining_wals(relay->r, &relay->stream, NULL, true);
+	relay_try_enter_wal_tail(relay);
 }
 
 /**
@@ -1088,6 +1295,7 @@ relay_raft_msg_push(struct cmsg *base)
 		relay_send(msg->relay, &row);
 		if (msg->req.state == RAFT_STATE_LEADER)
 			relay_restart_recovery(msg->relay);
+		relay_flush(msg->relay);
 	} catch (Exception *e) {
 		relay_set_error(msg->relay, e);
 		fiber_cancel(fiber());
@@ -38,6 +38,7 @@ extern "C" {
 #endif /* defined(__cplusplus) */
 
 struct iostream;
+struct iproto_features;
 struct relay;
 struct replica;
 struct tt_uuid;
@@ -141,6 +142,7 @@ relay_final_join(struct iostream *io, uint64_t sync,
 void
 relay_subscribe(struct replica *replica, struct iostream *io, uint64_t sync,
 		struct vclock *replica_vclock, uint32_t replica_version_id,
-		uint32_t replica_id_filter);
+		uint32_t replica_id_filter,
+		const struct iproto_features *replica_features);
 
 #endif /* TARANTOOL_REPLICATION_RELAY_H_INCLUDED */
@@ -116,6 +116,8 @@ enum {
 	BOX_FUNC_INDEX_ID = 372,
 	/** Space id of _session_settings. */
 	BOX_SESSION_SETTINGS_ID = 380,
+	/** Space id of _sql_stat. */
+	BOX_SQL_STAT_ID = 388,
 	/** End of the reserved range of system spaces. */
 	BOX_SYSTEM_ID_MAX = 511,
 	BOX_ID_NIL = 2147483647
@@ -47,9 +47,11 @@ const char *session_setting_strs[SESSION_SETTING_COUNT] = {
 	"sql_full_column_names",
 	"sql_full_metadata",
 	"sql_parser_debug",
+	"sql_read_view_scan",
 	"sql_recursive_triggers",
 	"sql_reverse_unordered_selects",
 	"sql_select_debug",
+	"sql_vdbe_batch",
 	"sql_vdbe_debug",
 };
 
@@ -273,6 +275,7 @@ static const struct index_vtab session_settings_index_vtab = {
 	/* .count = */ generic_index_count,
 	/* .get_raw = */ generic_index_get_raw,
 	/* .get = */ session_settings_index_get,
+	/* .get_many = */ generic_index_get_many,
 	/* .replace = */ generic_index_replace,
 	/* .create_iterator = */ session_settings_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -422,6 +425,7 @@ session_settings_space_create_index(struct space *space, struct index_def *def)
 const struct space_vtab session_settings_space_vtab = {
 	/* .destroy = */ session_settings_space_destroy,
 	/* .bsize = */ generic_space_bsize,
+	/* .stat = */ generic_space_stat,
 	/* .execute_replace = */ session_settings_space_execute_replace,
 	/* .execute_delete = */ session_settings_space_execute_delete,
 	/* .execute_update = */ session_settings_space_execute_update,
@@ -48,9 +48,11 @@ enum {
 	SESSION_SETTING_SQL_FULL_COLUMN_NAMES,
 	SESSION_SETTING_SQL_FULL_METADATA,
 	SESSION_SETTING_SQL_PARSER_DEBUG,
+	SESSION_SETTING_SQL_READ_VIEW_SCAN,
 	SESSION_SETTING_SQL_RECURSIVE_TRIGGERS,
 	SESSION_SETTING_SQL_REVERSE_UNORDERED_SELECTS,
 	SESSION_SETTING_SQL_SELECT_DEBUG,
+	SESSION_SETTING_SQL_VDBE_BATCH,
 	SESSION_SETTING_SQL_VDBE_DEBUG,
 	SESSION_SETTING_SQL_END,
 	/**
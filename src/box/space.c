@@ -49,6 +49,7 @@
 #include "assoc.h"
 #include "constraint_id.h"
 #include "box.h"
+#include "info/info.h"
 
 int
 access_check_space(struct space *space, user_access_t access)
@@ -592,6 +593,7 @@ space_execute_dml(struct space *space, struct txn *txn,
 	default:
 		*result = NULL;
 	}
+	space->change_count++;
 	return 0;
 }
 
@@ -671,6 +673,14 @@ generic_space_bsize(struct space *space)
 	return 0;
 }
 
+void
+generic_space_stat(struct space *space, struct info_handler *h)
+{
+	info_begin(h);
+	info_append_int(h, "bsize", space_bsize(space));
+	info_end(h);
+}
+
 int
 generic_space_ephemeral_replace(struct space *space, const char *tuple,
 				const char *tuple_end)
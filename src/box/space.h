@@ -59,6 +59,8 @@ struct space_vtab {
 	void (*destroy)(struct space *);
 	/** Return binary size of a space. */
 	size_t (*bsize)(struct space *);
+	/** Report space statistics (space:stat()). */
+	void (*stat)(struct space *, struct info_handler *);
 
 	int (*execute_replace)(struct space *, struct txn *,
 			       struct request *, struct tuple **result);
@@ -189,6 +191,11 @@ struct space {
 	char *sequence_path;
 	/** Enable/disable triggers. */
 	bool run_triggers;
+	/**
+	 * Number of DML requests executed on the space. Used to
+	 * find out when SQL statistics of its indexes get stale.
+	 */
+	uint64_t change_count;
 	/**
 	 * Space format or NULL if space does not have format
 	 * (sysview engine, for example).
@@ -364,6 +371,13 @@ index_find_unique(struct space *space, uint32_t index_id)
 size_t
 space_bsize(struct space *space);
 
+/** Report space statistics (space:stat()). */
+static inline void
+space_stat(struct space *space, struct info_handler *h)
+{
+	space->vtab->stat(space, h);
+}
+
 /** Get definition of the n-th index of the space. */
 struct index_def *
 space_index_def(struct space *space, int n);
@@ -567,6 +581,7 @@ space_pop_constraint_id(struct space *space, const char *name);
  * Virtual method stubs.
  */
 size_t generic_space_bsize(struct space *);
+void generic_space_stat(struct space *, struct info_handler *);
 int generic_space_ephemeral_replace(struct space *, const char *, const char *);
 int generic_space_ephemeral_delete(struct space *, const char *);
 int generic_space_ephemeral_rowid_next(struct space *, uint64_t *);
@@ -79,6 +79,12 @@ struct space_opts {
 	 * which should speed up writes, but may also slow down reads.
 	 */
 	bool defer_deletes;
+	/**
+	 * Max number of bytes tuples and indexes of the space may
+	 * occupy in memory. Inserting a tuple that would make the
+	 * space exceed the quota fails. 0 means no limit.
+	 */
+	int64_t memory_quota;
 	/** SQL statement that produced this space. */
 	char *sql;
 };
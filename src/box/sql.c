@@ -62,7 +62,8 @@ static const char nil_key[] = { 0x90 }; /* Empty MsgPack array. */
 
 static const uint32_t default_sql_flags = SQL_EnableTrigger
 					  | SQL_AutoIndex
-					  | SQL_RecTriggers;
+					  | SQL_RecTriggers
+					  | SQL_VdbeBatch;
 
 void
 sql_init(void)
@@ -0,0 +1,318 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "batch_scan.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "box/index.h"
+#include "box/space.h"
+#include "box/tuple.h"
+#include "box/txn.h"
+#include "diag.h"
+#include "sqlInt.h"
+#include "mem.h"
+#include "vdbeInt.h"
+#include "trivia/util.h"
+
+struct sql_batch_scan {
+	/** Definition of the scan. */
+	const struct sql_batch_scan_def *def;
+	/** Scanned space. */
+	struct space *space;
+	/** Iterator over the primary index. */
+	struct iterator *iterator;
+	/** Tuples of the current batch, referenced. */
+	struct tuple *tuples[SQL_BATCH_SCAN_SIZE];
+	/** Number of tuples in the current batch. */
+	uint32_t tuple_count;
+	/** Positions of the selected tuples of the current batch. */
+	uint32_t selection[SQL_BATCH_SCAN_SIZE];
+	/** Number of selected tuples. */
+	uint32_t selection_size;
+	/**
+	 * Column vectors, SQL_BATCH_SCAN_SIZE MEMs for each field
+	 * of the definition. An element is valid only if its tuple
+	 * is selected and the column is decoded.
+	 */
+	struct Mem *columns;
+	/** Set for the column vectors decoded for the current batch. */
+	bool *is_decoded;
+	/** Set when the iterator has no more tuples. */
+	bool is_eof;
+};
+
+struct sql_batch_scan *
+sql_batch_scan_new(struct space *space, const struct sql_batch_scan_def *def)
+{
+	struct index *pk = index_find(space, 0);
+	if (pk == NULL)
+		return NULL;
+	struct sql_batch_scan *scan = malloc(sizeof(*scan));
+	if (scan == NULL) {
+		diag_set(OutOfMemory, sizeof(*scan), "malloc", "scan");
+		return NULL;
+	}
+	scan->def = def;
+	scan->space = space;
+	scan->iterator = NULL;
+	scan->tuple_count = 0;
+	scan->selection_size = 0;
+	scan->is_eof = false;
+	uint32_t count = def->field_count * SQL_BATCH_SCAN_SIZE;
+	size_t size = count * sizeof(scan->columns[0]) +
+		      def->field_count * sizeof(scan->is_decoded[0]);
+	scan->columns = malloc(size);
+	if (scan->columns == NULL && size > 0) {
+		diag_set(OutOfMemory, size, "malloc", "columns");
+		free(scan);
+		return NULL;
+	}
+	for (uint32_t i = 0; i < count; i++)
+		mem_create(&scan->columns[i]);
+	scan->is_decoded = (bool *)(scan->columns + count);
+	struct txn *txn = NULL;
+	struct txn_ro_savepoint svp;
+	if (space->def->id != 0 && txn_begin_ro_stmt(space, &txn, &svp) != 0)
+		goto fail;
+	scan->iterator = index_create_iterator(pk, ITER_ALL, NULL, 0);
+	if (scan->iterator == NULL) {
+		if (txn != NULL)
+			txn_rollback_stmt(txn);
+		goto fail;
+	}
+	if (txn != NULL)
+		txn_commit_ro_stmt(txn, &svp);
+	return scan;
+fail:
+	sql_batch_scan_delete(scan);
+	return NULL;
+}
+
+/** Release the tuples of the current batch. */
+static void
+sql_batch_scan_release(struct sql_batch_scan *scan)
+{
+	for (uint32_t i = 0; i < scan->tuple_count; i++)
+		tuple_unref(scan->tuples[i]);
+	scan->tuple_count = 0;
+	scan->selection_size = 0;
+}
+
+void
+sql_batch_scan_delete(struct sql_batch_scan *scan)
+{
+	sql_batch_scan_release(scan);
+	if (scan->iterator != NULL)
+		iterator_delete(scan->iterator);
+	uint32_t count = scan->def->field_count * SQL_BATCH_SCAN_SIZE;
+	for (uint32_t i = 0; i < count; i++)
+		mem_destroy(&scan->columns[i]);
+	free(scan->columns);
+	free(scan);
+}
+
+/**
+ * Fetch the next batch of tuples from the iterator and select all
+ * of them. The iterator may yield, so the tuples are referenced.
+ */
+static int
+sql_batch_scan_fetch(struct sql_batch_scan *scan)
+{
+	sql_batch_scan_release(scan);
+	while (scan->tuple_count < SQL_BATCH_SCAN_SIZE) {
+		struct tuple *tuple;
+		if (iterator_next(scan->iterator, &tuple) != 0)
+			return -1;
+		if (tuple == NULL) {
+			scan->is_eof = true;
+			break;
+		}
+		tuple_ref(tuple);
+		scan->selection[scan->tuple_count] = scan->tuple_count;
+		scan->tuples[scan->tuple_count++] = tuple;
+	}
+	scan->selection_size = scan->tuple_count;
+	for (uint32_t i = 0; i < scan->def->field_count; i++)
+		scan->is_decoded[i] = false;
+	return 0;
+}
+
+/**
+ * Return a column vector, decoding it for the selected tuples
+ * first if needed. The MEMs are set the way OP_Column sets them.
+ */
+static struct Mem *
+sql_batch_scan_column(struct sql_batch_scan *scan, uint32_t column)
+{
+	struct Mem *mems = &scan->columns[column * SQL_BATCH_SCAN_SIZE];
+	if (scan->is_decoded[column])
+		return mems;
+	uint32_t fieldno = scan->def->fields[column];
+	enum field_type type = scan->space->def->fields[fieldno].type;
+	uint32_t flags = 0;
+	if (type == FIELD_TYPE_ANY)
+		flags = MEM_Any;
+	else if (type == FIELD_TYPE_SCALAR)
+		flags = MEM_Scalar;
+	else if (type == FIELD_TYPE_NUMBER)
+		flags = MEM_Number;
+	for (uint32_t i = 0; i < scan->selection_size; i++) {
+		uint32_t pos = scan->selection[i];
+		struct Mem *mem = &mems[pos];
+		mem_set_null(mem);
+		const char *field = tuple_field(scan->tuples[pos], fieldno);
+		if (field == NULL)
+			continue;
+		uint32_t size;
+		if (mem_from_mp(mem, field, &size) != 0)
+			return NULL;
+		if (!mem_is_null(mem))
+			mem->flags |= flags;
+	}
+	scan->is_decoded[column] = true;
+	return mems;
+}
+
+/**
+ * Deselect the tuples that don't satisfy a filter. NULL never
+ * satisfies a filter.
+ */
+static int
+sql_batch_scan_filter(struct sql_batch_scan *scan,
+		      const struct sql_batch_scan_filter *filter,
+		      const struct Mem *value)
+{
+	if (mem_is_null(value)) {
+		scan->selection_size = 0;
+		return 0;
+	}
+	struct Mem *mems = sql_batch_scan_column(scan, filter->column);
+	if (mems == NULL)
+		return -1;
+	uint32_t size = 0;
+	for (uint32_t i = 0; i < scan->selection_size; i++) {
+		uint32_t pos = scan->selection[i];
+		if (mem_is_null(&mems[pos]))
+			continue;
+		int cmp;
+		if (!filter->is_value_left) {
+			if (mem_cmp(&mems[pos], value, &cmp,
+				    filter->coll) != 0)
+				return -1;
+		} else {
+			if (mem_cmp(value, &mems[pos], &cmp,
+				    filter->coll) != 0)
+				return -1;
+			cmp = cmp < 0 ? 1 : cmp > 0 ? -1 : 0;
+		}
+		bool is_match;
+		switch (filter->op) {
+		case TK_EQ:
+			is_match = cmp == 0;
+			break;
+		case TK_NE:
+			is_match = cmp != 0;
+			break;
+		case TK_LT:
+			is_match = cmp < 0;
+			break;
+		case TK_LE:
+			is_match = cmp <= 0;
+			break;
+		case TK_GT:
+			is_match = cmp > 0;
+			break;
+		case TK_GE:
+			is_match = cmp >= 0;
+			break;
+		default:
+			unreachable();
+		}
+		if (is_match)
+			scan->selection[size++] = pos;
+	}
+	scan->selection_size = size;
+	return 0;
+}
+
+/**
+ * Update an aggregate with the selected tuples. A copy of the
+ * argument is cast to the type of the function parameter as
+ * OP_ApplyType does, the column vector may be shared with other
+ * aggregates.
+ */
+static int
+sql_batch_scan_aggregate(struct sql_batch_scan *scan,
+			 const struct sql_batch_scan_agg *agg,
+			 struct Mem *regs)
+{
+	struct func_sql_builtin *func = (struct func_sql_builtin *)agg->func;
+	struct sql_context ctx;
+	ctx.pOut = &regs[agg->reg];
+	ctx.func = agg->func;
+	ctx.coll = agg->coll;
+	ctx.is_aborted = false;
+	ctx.skipFlag = 0;
+	if (agg->column == SQL_BATCH_SCAN_NO_COLUMN) {
+		for (uint32_t i = 0; i < scan->selection_size; i++) {
+			func->call(&ctx, 0, NULL);
+			if (ctx.is_aborted)
+				return -1;
+		}
+		return 0;
+	}
+	struct Mem *mems = sql_batch_scan_column(scan, agg->column);
+	if (mems == NULL)
+		return -1;
+	enum field_type type = func->param_list[0];
+	struct Mem arg;
+	mem_create(&arg);
+	int rc = 0;
+	for (uint32_t i = 0; i < scan->selection_size; i++) {
+		mem_copy_as_ephemeral(&arg, &mems[scan->selection[i]]);
+		if (mem_cast_implicit(&arg, type) != 0) {
+			diag_set(ClientError, ER_SQL_TYPE_MISMATCH,
+				 mem_str(&arg), field_type_strs[type]);
+			rc = -1;
+			break;
+		}
+		func->call(&ctx, 1, &arg);
+		if (ctx.is_aborted) {
+			rc = -1;
+			break;
+		}
+	}
+	mem_destroy(&arg);
+	return rc;
+}
+
+int
+sql_batch_scan_next(struct sql_batch_scan *scan, const struct Mem *values,
+		    struct Mem *regs, bool *is_eof)
+{
+	if (scan->is_eof) {
+		sql_batch_scan_release(scan);
+		*is_eof = true;
+		return 0;
+	}
+	if (sql_batch_scan_fetch(scan) != 0)
+		return -1;
+	const struct sql_batch_scan_def *def = scan->def;
+	for (uint32_t i = 0; i < def->filter_count &&
+			     scan->selection_size > 0; i++) {
+		if (sql_batch_scan_filter(scan, &def->filters[i],
+					  &values[i]) != 0)
+			return -1;
+	}
+	for (uint32_t i = 0; i < def->agg_count &&
+			     scan->selection_size > 0; i++) {
+		if (sql_batch_scan_aggregate(scan, &def->aggs[i], regs) != 0)
+			return -1;
+	}
+	*is_eof = false;
+	return 0;
+}
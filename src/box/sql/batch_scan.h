@@ -0,0 +1,122 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+/*
+ * Batched full scan of a space used by the SQL executor to compute
+ * aggregates without GROUP BY over the rows satisfying simple
+ * filters, e.g. SELECT sum(a) FROM t WHERE b > ?.
+ *
+ * Instead of running the VDBE loop once per row, the scan fetches
+ * a batch of up to SQL_BATCH_SCAN_SIZE tuples from the iterator
+ * over the primary index at once. The fields the filters and the
+ * aggregates need are decoded into column vectors, arrays of MEMs
+ * with an element per tuple of the batch. A filter is evaluated
+ * over a whole column vector and narrows the selection vector, the
+ * positions of the tuples of the batch that satisfy all filters
+ * applied so far. A field is only decoded for the selected tuples.
+ * Finally, each aggregate is updated with the selected elements of
+ * its column vector.
+ *
+ * The values are compared and aggregated by the same functions the
+ * VDBE opcodes use, so the results, including errors, are the same
+ * as those of the row-at-a-time loop.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct Mem;
+struct coll;
+struct func;
+struct space;
+struct sql_batch_scan;
+
+enum {
+	/** Max number of tuples in a batch. */
+	SQL_BATCH_SCAN_SIZE = 1024,
+	/** Pseudo column number of an aggregate without arguments. */
+	SQL_BATCH_SCAN_NO_COLUMN = UINT32_MAX,
+};
+
+/** A condition a tuple must satisfy: <column> <op> <value>. */
+struct sql_batch_scan_filter {
+	/** Column vector to compare. */
+	uint32_t column;
+	/** Comparison: TK_EQ, TK_NE, TK_LT, TK_LE, TK_GT or TK_GE. */
+	int op;
+	/** Collation to compare strings with or NULL. */
+	struct coll *coll;
+	/**
+	 * Set if the value is the left operand of the comparison
+	 * as written in the query. The operands are then passed to
+	 * mem_cmp() in this order, so that a type mismatch is
+	 * reported the same way.
+	 */
+	bool is_value_left;
+};
+
+/** An aggregate updated with the tuples satisfying the filters. */
+struct sql_batch_scan_agg {
+	/**
+	 * Column vector passed to the function, or
+	 * SQL_BATCH_SCAN_NO_COLUMN if it has no arguments.
+	 */
+	uint32_t column;
+	/** Built-in SQL aggregate function. */
+	struct func *func;
+	/** Collation passed to the function or NULL. */
+	struct coll *coll;
+	/** Accumulator register. */
+	int reg;
+};
+
+/** Definition of a batched scan, see OP_BatchOpen. */
+struct sql_batch_scan_def {
+	/** Numbers of the fields of the column vectors, 0-based. */
+	uint32_t *fields;
+	/** Number of column vectors. */
+	uint32_t field_count;
+	/** Conditions a tuple must satisfy, all of them. */
+	struct sql_batch_scan_filter *filters;
+	/** Number of filters. */
+	uint32_t filter_count;
+	/** Aggregates to update. */
+	struct sql_batch_scan_agg *aggs;
+	/** Number of aggregates. */
+	uint32_t agg_count;
+};
+
+/**
+ * Create a batched scan of the primary index of a space. The
+ * definition isn't copied and must outlive the scan. Returns NULL
+ * and sets diag on error.
+ */
+struct sql_batch_scan *
+sql_batch_scan_new(struct space *space, const struct sql_batch_scan_def *def);
+
+/** Delete a scan and release the tuples of its last batch. */
+void
+sql_batch_scan_delete(struct sql_batch_scan *scan);
+
+/**
+ * Fetch the next batch of tuples, filter it and update the
+ * aggregates with the tuples that satisfy the filters. The values
+ * of the filters are stored in @a values, the accumulators are
+ * taken from the VDBE registers @a regs. Sets @a is_eof if there
+ * are no more tuples. May yield. Returns 0 on success, -1 and sets
+ * diag on error.
+ */
+int
+sql_batch_scan_next(struct sql_batch_scan *scan, const struct Mem *values,
+		    struct Mem *regs, bool *is_eof);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
@@ -3630,6 +3630,8 @@ static struct sql_option_metadata sql_session_opts[] = {
 	{FIELD_TYPE_BOOLEAN, SQL_FullMetadata},
 	/** SESSION_SETTING_SQL_PARSER_DEBUG */
 	{FIELD_TYPE_BOOLEAN, SQL_SqlTrace | PARSER_TRACE_FLAG},
+	/** SESSION_SETTING_SQL_READ_VIEW_SCAN */
+	{FIELD_TYPE_BOOLEAN, SQL_ReadViewScan},
 	/** SESSION_SETTING_SQL_RECURSIVE_TRIGGERS */
 	{FIELD_TYPE_BOOLEAN, SQL_RecTriggers},
 	/** SESSION_SETTING_SQL_REVERSE_UNORDERED_SELECTS */
@@ -3637,6 +3639,8 @@ static struct sql_option_metadata sql_session_opts[] = {
 	/** SESSION_SETTING_SQL_SELECT_DEBUG */
 	{FIELD_TYPE_BOOLEAN,
 	 SQL_SqlTrace | SQL_SelectTrace | SQL_WhereTrace},
+	/** SESSION_SETTING_SQL_VDBE_BATCH */
+	{FIELD_TYPE_BOOLEAN, SQL_VdbeBatch},
 	/** SESSION_SETTING_SQL_VDBE_DEBUG */
 	{FIELD_TYPE_BOOLEAN,
 	 SQL_SqlTrace | SQL_VdbeListing | SQL_VdbeTrace},
@@ -0,0 +1,310 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "hash_agg.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "msgpuck.h"
+#include "qsort_arg.h"
+#include "small/region.h"
+
+#include "box/key_def.h"
+#include "diag.h"
+#include "fiber.h"
+#include "sqlInt.h"
+#include "mem.h"
+#include "trivia/util.h"
+
+size_t sql_hash_agg_memory = 64 * 1024 * 1024;
+
+/** A group stored in a hash table. */
+struct sql_hash_agg_group {
+	/** Hash of the key. */
+	uint32_t hash;
+	/** Key of the group, MessagePack array of the GROUP BY values. */
+	char *key;
+	/** State of the group, state_size registers. */
+	struct Mem state[0];
+};
+
+/** A key to look up in a hash table. */
+struct sql_hash_agg_key {
+	/** MessagePack array of the key values. */
+	const char *data;
+	/** Hash of the key. */
+	uint32_t hash;
+};
+
+static inline bool
+sql_hash_agg_group_equal(const struct sql_hash_agg_group *a,
+			 const struct sql_hash_agg_group *b,
+			 struct key_def *key_def)
+{
+	return a->hash == b->hash &&
+	       key_compare(a->key, HINT_NONE, b->key, HINT_NONE, key_def) == 0;
+}
+
+static inline bool
+sql_hash_agg_key_equal(const struct sql_hash_agg_key *a,
+		       const struct sql_hash_agg_group *b,
+		       struct key_def *key_def)
+{
+	return a->hash == b->hash &&
+	       key_compare(a->data, HINT_NONE, b->key, HINT_NONE, key_def) == 0;
+}
+
+#define mh_name _sql_hash_agg
+#define mh_key_t const struct sql_hash_agg_key *
+#define mh_node_t struct sql_hash_agg_group *
+#define mh_arg_t struct key_def *
+#define mh_hash(a, arg) ((*(a))->hash)
+#define mh_hash_key(a, arg) ((a)->hash)
+#define mh_cmp(a, b, arg) (!sql_hash_agg_group_equal(*(a), *(b), (arg)))
+#define mh_cmp_key(a, b, arg) (!sql_hash_agg_key_equal((a), *(b), (arg)))
+#define MH_SOURCE
+#include "salad/mhash.h"
+
+struct sql_hash_agg {
+	/** Definition of the group key. */
+	struct key_def *key_def;
+	/** Number of registers in a group state. */
+	uint32_t state_size;
+	/** Memory limit, in bytes. */
+	size_t memory_limit;
+	/** Set once the memory limit is exceeded. */
+	bool is_full;
+	/** Memory for groups. */
+	struct region arena;
+	/** Memory allocated by the registers stored in groups. */
+	size_t state_used;
+	/** Hash table of groups. */
+	struct mh_sql_hash_agg_t *hash;
+	/** All groups, in insertion order until sorted. */
+	struct sql_hash_agg_group **groups;
+	/** Number of groups. */
+	uint32_t group_count;
+	/** Number of groups the array has space for. */
+	uint32_t group_capacity;
+	/** Group the hash table is positioned at. */
+	struct sql_hash_agg_group *curr;
+	/** Position of the current group in the sorted array. */
+	uint32_t curr_pos;
+};
+
+struct sql_hash_agg *
+sql_hash_agg_new(const struct key_part_def *parts, uint32_t part_count,
+		 uint32_t state_size, uint32_t size_hint, size_t memory_limit)
+{
+	assert(part_count > 0);
+	struct region *region = &fiber()->gc;
+	size_t svp = region_used(region);
+	size_t size;
+	struct key_part_def *key_parts =
+		region_alloc_array(region, typeof(*key_parts), part_count,
+				   &size);
+	if (key_parts == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc_array", "key_parts");
+		return NULL;
+	}
+	memcpy(key_parts, parts, size);
+	for (uint32_t i = 0; i < part_count; i++) {
+		/*
+		 * A GROUP BY value may be of any type compatible with
+		 * the type of its expression, e.g. an integer may be
+		 * produced by a DOUBLE expression.
+		 */
+		key_parts[i].fieldno = i;
+		key_parts[i].type = FIELD_TYPE_SCALAR;
+		key_parts[i].is_nullable = true;
+	}
+	struct key_def *key_def = key_def_new(key_parts, part_count, false);
+	region_truncate(region, svp);
+	if (key_def == NULL)
+		return NULL;
+	struct sql_hash_agg *agg = malloc(sizeof(*agg));
+	if (agg == NULL) {
+		diag_set(OutOfMemory, sizeof(*agg), "malloc", "agg");
+		key_def_delete(key_def);
+		return NULL;
+	}
+	agg->key_def = key_def;
+	agg->state_size = state_size;
+	agg->memory_limit = memory_limit;
+	agg->is_full = false;
+	region_create(&agg->arena, cord_slab_cache());
+	agg->state_used = 0;
+	agg->hash = mh_sql_hash_agg_new();
+	if (size_hint > 0)
+		mh_sql_hash_agg_reserve(agg->hash, size_hint, key_def);
+	agg->groups = NULL;
+	agg->group_count = 0;
+	agg->group_capacity = 0;
+	agg->curr = NULL;
+	agg->curr_pos = 0;
+	return agg;
+}
+
+void
+sql_hash_agg_delete(struct sql_hash_agg *agg)
+{
+	for (uint32_t i = 0; i < agg->group_count; i++) {
+		struct sql_hash_agg_group *group = agg->groups[i];
+		for (uint32_t j = 0; j < agg->state_size; j++)
+			mem_destroy(&group->state[j]);
+	}
+	free(agg->groups);
+	mh_sql_hash_agg_delete(agg->hash);
+	region_destroy(&agg->arena);
+	key_def_delete(agg->key_def);
+	free(agg);
+}
+
+/** Return the amount of memory used by a hash table. */
+static size_t
+sql_hash_agg_used(struct sql_hash_agg *agg)
+{
+	return region_used(&agg->arena) + agg->state_used +
+	       mh_sql_hash_agg_memsize(agg->hash) +
+	       agg->group_capacity * sizeof(agg->groups[0]);
+}
+
+void
+sql_hash_agg_find(struct sql_hash_agg *agg, const char *key, bool *found)
+{
+	const char *key_parts = key;
+	mp_decode_array(&key_parts);
+	struct sql_hash_agg_key lookup = {
+		key, key_hash(key_parts, agg->key_def)
+	};
+	struct mh_sql_hash_agg_t *hash = agg->hash;
+	mh_int_t pos = mh_sql_hash_agg_find(hash, &lookup, agg->key_def);
+	agg->curr = pos != mh_end(hash) ? *mh_sql_hash_agg_node(hash, pos) :
+		    NULL;
+	*found = agg->curr != NULL;
+}
+
+int
+sql_hash_agg_insert(struct sql_hash_agg *agg, const char *key,
+		    const char *key_end, bool *inserted)
+{
+	if (agg->is_full || sql_hash_agg_used(agg) > agg->memory_limit) {
+		agg->is_full = true;
+		*inserted = false;
+		return 0;
+	}
+	if (agg->group_count == agg->group_capacity) {
+		uint32_t capacity = MAX(agg->group_capacity * 2, 16);
+		size_t size = capacity * sizeof(agg->groups[0]);
+		struct sql_hash_agg_group **groups = realloc(agg->groups, size);
+		if (groups == NULL) {
+			diag_set(OutOfMemory, size, "realloc", "groups");
+			return -1;
+		}
+		agg->groups = groups;
+		agg->group_capacity = capacity;
+	}
+	uint32_t key_size = key_end - key;
+	size_t state_size = agg->state_size * sizeof(struct Mem);
+	size_t size = sizeof(struct sql_hash_agg_group) + state_size +
+		      key_size;
+	struct sql_hash_agg_group *group =
+		region_aligned_alloc(&agg->arena, size, alignof(*group));
+	if (group == NULL) {
+		diag_set(OutOfMemory, size, "region_aligned_alloc", "group");
+		return -1;
+	}
+	for (uint32_t i = 0; i < agg->state_size; i++)
+		mem_create(&group->state[i]);
+	group->key = (char *)group->state + state_size;
+	memcpy(group->key, key, key_size);
+	const char *key_parts = key;
+	mp_decode_array(&key_parts);
+	group->hash = key_hash(key_parts, agg->key_def);
+	const struct sql_hash_agg_group **put_group =
+		(const struct sql_hash_agg_group **)&group;
+	mh_sql_hash_agg_put(agg->hash, put_group, NULL, agg->key_def);
+	agg->groups[agg->group_count++] = group;
+	agg->curr = group;
+	*inserted = true;
+	return 0;
+}
+
+void
+sql_hash_agg_load(struct sql_hash_agg *agg, struct Mem *state)
+{
+	assert(agg->curr != NULL);
+	struct Mem *group_state = agg->curr->state;
+	for (uint32_t i = 0; i < agg->state_size; i++) {
+		assert(agg->state_used >= (size_t)group_state[i].szMalloc);
+		agg->state_used -= group_state[i].szMalloc;
+		mem_move(&state[i], &group_state[i]);
+	}
+}
+
+int
+sql_hash_agg_store(struct sql_hash_agg *agg, struct Mem *state)
+{
+	assert(agg->curr != NULL);
+	struct Mem *group_state = agg->curr->state;
+	for (uint32_t i = 0; i < agg->state_size; i++) {
+		/*
+		 * Ephemeral values point to data that may be gone by
+		 * the time the group is updated again, so copy them.
+		 */
+		if (mem_is_ephemeral(&state[i])) {
+			if (mem_copy(&group_state[i], &state[i]) != 0)
+				return -1;
+			mem_set_null(&state[i]);
+		} else {
+			mem_move(&group_state[i], &state[i]);
+		}
+		agg->state_used += group_state[i].szMalloc;
+	}
+	return 0;
+}
+
+static int
+sql_hash_agg_group_cmp(const void *a, const void *b, void *arg)
+{
+	const struct sql_hash_agg_group *group_a =
+		*(const struct sql_hash_agg_group **)a;
+	const struct sql_hash_agg_group *group_b =
+		*(const struct sql_hash_agg_group **)b;
+	struct key_def *key_def = arg;
+	return key_compare(group_a->key, HINT_NONE, group_b->key, HINT_NONE,
+			   key_def);
+}
+
+bool
+sql_hash_agg_sort(struct sql_hash_agg *agg)
+{
+	qsort_arg(agg->groups, agg->group_count, sizeof(agg->groups[0]),
+		  sql_hash_agg_group_cmp, agg->key_def);
+	agg->curr_pos = 0;
+	agg->curr = agg->group_count > 0 ? agg->groups[0] : NULL;
+	return agg->curr != NULL;
+}
+
+bool
+sql_hash_agg_next(struct sql_hash_agg *agg)
+{
+	assert(agg->curr_pos < agg->group_count);
+	if (++agg->curr_pos == agg->group_count) {
+		agg->curr = NULL;
+		return false;
+	}
+	agg->curr = agg->groups[agg->curr_pos];
+	return true;
+}
+
+const char *
+sql_hash_agg_key(struct sql_hash_agg *agg)
+{
+	assert(agg->curr != NULL);
+	return agg->curr->key;
+}
@@ -0,0 +1,122 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+/*
+ * In-memory hash table used by the SQL executor to compute
+ * aggregates with GROUP BY without sorting the input rows.
+ *
+ * The table maps a group key, which is a MessagePack array of
+ * GROUP BY values, to the state of the group: the values of the
+ * aggregate accumulator registers (see struct AggInfo). For each
+ * input row, the state of its group is moved to the registers,
+ * updated by the aggregate functions and moved back. When all rows
+ * are processed, the groups are sorted by key and their states are
+ * moved to the registers one by one to produce the result rows.
+ *
+ * New groups aren't added once the memory used by the table
+ * exceeds the limit. Rows of such groups are passed to the sorter,
+ * as they would be without the hash table, while rows of groups
+ * that are already in the table keep being aggregated in it. So
+ * a group is either in the table or in the sorter, never in both.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct Mem;
+struct key_part_def;
+struct sql_hash_agg;
+
+enum {
+	/**
+	 * Approximate amount of memory used by a hash table per
+	 * group in addition to the group state, in bytes.
+	 */
+	SQL_HASH_AGG_GROUP_OVERHEAD = 64,
+};
+
+/**
+ * Max amount of memory a hash table may use before new groups are
+ * passed to the sorter, in bytes. Zero disables hash aggregation.
+ * Set by box.cfg.sql_hash_agg_memory.
+ */
+extern size_t sql_hash_agg_memory;
+
+/**
+ * Create an empty hash table for groups with keys described by
+ * @a parts and states of @a state_size registers. Space for
+ * @a size_hint groups is reserved in advance. Returns NULL and
+ * sets diag on error.
+ */
+struct sql_hash_agg *
+sql_hash_agg_new(const struct key_part_def *parts, uint32_t part_count,
+		 uint32_t state_size, uint32_t size_hint, size_t memory_limit);
+
+/** Delete a hash table. */
+void
+sql_hash_agg_delete(struct sql_hash_agg *agg);
+
+/**
+ * Position a hash table at the group with the given key, which
+ * is a MessagePack array of part_count values. Sets @a found to
+ * false if there is no such group.
+ */
+void
+sql_hash_agg_find(struct sql_hash_agg *agg, const char *key, bool *found);
+
+/**
+ * Add a group with the given key, which must not be in a hash
+ * table yet, and position the table at it. The state of the new
+ * group is all NULLs. Sets @a inserted to false and doesn't add
+ * the group if the memory limit has ever been exceeded. Returns 0
+ * on success, -1 and sets diag on error.
+ */
+int
+sql_hash_agg_insert(struct sql_hash_agg *agg, const char *key,
+		    const char *key_end, bool *inserted);
+
+/**
+ * Move the state of the group a hash table is positioned at to
+ * the given registers. The group state is set to NULLs.
+ */
+void
+sql_hash_agg_load(struct sql_hash_agg *agg, struct Mem *state);
+
+/**
+ * Move the given registers to the state of the group a hash table
+ * is positioned at. The registers are set to NULLs. Returns 0 on
+ * success, -1 and sets diag on error.
+ */
+int
+sql_hash_agg_store(struct sql_hash_agg *agg, struct Mem *state);
+
+/**
+ * Sort the groups of a hash table by key and position the table
+ * at the first one. Returns false if the table is empty.
+ */
+bool
+sql_hash_agg_sort(struct sql_hash_agg *agg);
+
+/**
+ * Advance a hash table to the next group in the order set by
+ * the last sql_hash_agg_sort(). Returns false if there are no more
+ * groups.
+ */
+bool
+sql_hash_agg_next(struct sql_hash_agg *agg);
+
+/** Return the key of the group a hash table is positioned at. */
+const char *
+sql_hash_agg_key(struct sql_hash_agg *agg);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
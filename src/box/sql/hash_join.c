@@ -0,0 +1,336 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "hash_join.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "msgpuck.h"
+#include "small/region.h"
+
+#include "box/index.h"
+#include "box/key_def.h"
+#include "box/space.h"
+#include "box/tuple.h"
+#include "diag.h"
+#include "fiber.h"
+#include "sqlInt.h"
+#include "tarantoolInt.h"
+#include "trivia/util.h"
+
+size_t sql_hash_join_memory = 64 * 1024 * 1024;
+
+/** A row stored in a hash table. */
+struct sql_hash_join_entry {
+	/** Next row with the same key. */
+	struct sql_hash_join_entry *next;
+	/**
+	 * Last row with the same key. Only valid for the first row,
+	 * which is the one stored in the hash table.
+	 */
+	struct sql_hash_join_entry *last;
+	/** Hash of the key. */
+	uint32_t hash;
+	/** Size of the key. */
+	uint32_t key_size;
+	/** Size of the row. */
+	uint32_t data_size;
+	/**
+	 * The key, which is a MessagePack array of the key fields,
+	 * followed by the row.
+	 */
+	char key[0];
+};
+
+/** A key to look up in a hash table. */
+struct sql_hash_join_key {
+	/** MessagePack array of the key fields. */
+	const char *data;
+	/** Hash of the key. */
+	uint32_t hash;
+};
+
+static inline bool
+sql_hash_join_entry_equal(const struct sql_hash_join_entry *a,
+			  const struct sql_hash_join_entry *b,
+			  struct key_def *key_def)
+{
+	return a->hash == b->hash &&
+	       key_compare(a->key, HINT_NONE, b->key, HINT_NONE, key_def) == 0;
+}
+
+static inline bool
+sql_hash_join_key_equal(const struct sql_hash_join_key *a,
+			const struct sql_hash_join_entry *b,
+			struct key_def *key_def)
+{
+	return a->hash == b->hash &&
+	       key_compare(a->data, HINT_NONE, b->key, HINT_NONE, key_def) == 0;
+}
+
+#define mh_name _sql_hash_join
+#define mh_key_t const struct sql_hash_join_key *
+#define mh_node_t struct sql_hash_join_entry *
+#define mh_arg_t struct key_def *
+#define mh_hash(a, arg) ((*(a))->hash)
+#define mh_hash_key(a, arg) ((a)->hash)
+#define mh_cmp(a, b, arg) (!sql_hash_join_entry_equal(*(a), *(b), (arg)))
+#define mh_cmp_key(a, b, arg) (!sql_hash_join_key_equal((a), *(b), (arg)))
+#define MH_SOURCE
+#include "salad/mhash.h"
+
+struct sql_hash_join {
+	/** Description of the rows, used to create the ephemeral space. */
+	const struct sql_space_info *info;
+	/** Definition of the key, i.e. the leading fields of a row. */
+	struct key_def *key_def;
+	/** Memory limit, in bytes. */
+	size_t memory_limit;
+	/** Memory for rows. */
+	struct region arena;
+	/** Hash table of rows. NULL after the rows were spilled. */
+	struct mh_sql_hash_join_t *hash;
+	/** Row the hash table is positioned at. */
+	struct sql_hash_join_entry *curr;
+	/** Ephemeral space holding the rows after they were spilled. */
+	struct space *space;
+	/** Iterator over the ephemeral space matching the last key. */
+	struct iterator *it;
+	/** Tuple the iterator is positioned at, referenced. */
+	struct tuple *tuple;
+};
+
+struct sql_hash_join *
+sql_hash_join_new(const struct sql_space_info *info, uint32_t key_part_count,
+		  size_t memory_limit)
+{
+	assert(key_part_count > 0 && key_part_count <= info->field_count);
+	struct region *region = &fiber()->gc;
+	size_t svp = region_used(region);
+	size_t size;
+	struct key_part_def *parts = region_alloc_array(region, typeof(*parts),
+							key_part_count, &size);
+	if (parts == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc_array", "parts");
+		return NULL;
+	}
+	for (uint32_t i = 0; i < key_part_count; i++) {
+		parts[i] = key_part_def_default;
+		parts[i].fieldno = i;
+		parts[i].type = info->types[i];
+		parts[i].coll_id = info->coll_ids[i];
+		parts[i].is_nullable = true;
+	}
+	struct key_def *key_def = key_def_new(parts, key_part_count, false);
+	region_truncate(region, svp);
+	if (key_def == NULL)
+		return NULL;
+	struct sql_hash_join *join = malloc(sizeof(*join));
+	if (join == NULL) {
+		diag_set(OutOfMemory, sizeof(*join), "malloc", "join");
+		key_def_delete(key_def);
+		return NULL;
+	}
+	join->info = info;
+	join->key_def = key_def;
+	join->memory_limit = memory_limit;
+	region_create(&join->arena, cord_slab_cache());
+	join->hash = mh_sql_hash_join_new();
+	join->curr = NULL;
+	join->space = NULL;
+	join->it = NULL;
+	join->tuple = NULL;
+	return join;
+}
+
+void
+sql_hash_join_delete(struct sql_hash_join *join)
+{
+	if (join->tuple != NULL)
+		tuple_unref(join->tuple);
+	if (join->it != NULL)
+		iterator_delete(join->it);
+	if (join->space != NULL)
+		space_delete(join->space);
+	if (join->hash != NULL)
+		mh_sql_hash_join_delete(join->hash);
+	region_destroy(&join->arena);
+	key_def_delete(join->key_def);
+	free(join);
+}
+
+/** Return the amount of memory used by a hash table. */
+static size_t
+sql_hash_join_used(struct sql_hash_join *join)
+{
+	return region_used(&join->arena) +
+	       mh_sql_hash_join_memsize(join->hash);
+}
+
+/**
+ * Move all rows of a hash table to an ephemeral space with a tree
+ * index and free the memory used by the hash table.
+ */
+static int
+sql_hash_join_spill(struct sql_hash_join *join)
+{
+	assert(join->space == NULL);
+	struct space *space = sql_ephemeral_space_new(join->info);
+	if (space == NULL)
+		return -1;
+	struct mh_sql_hash_join_t *hash = join->hash;
+	mh_int_t i;
+	mh_foreach(hash, i) {
+		struct sql_hash_join_entry *entry =
+			*mh_sql_hash_join_node(hash, i);
+		for (; entry != NULL; entry = entry->next) {
+			const char *data = entry->key + entry->key_size;
+			if (tarantoolsqlEphemeralInsert(
+					space, data,
+					data + entry->data_size) != 0) {
+				space_delete(space);
+				return -1;
+			}
+		}
+	}
+	mh_sql_hash_join_delete(hash);
+	join->hash = NULL;
+	region_free(&join->arena);
+	join->space = space;
+	return 0;
+}
+
+int
+sql_hash_join_insert(struct sql_hash_join *join, const char *data,
+		     const char *data_end)
+{
+	assert(join->curr == NULL && join->it == NULL);
+	if (join->space != NULL)
+		return tarantoolsqlEphemeralInsert(join->space, data, data_end);
+	uint32_t key_part_count = join->key_def->part_count;
+	/* Key fields go first in a row, so the key is a prefix of it. */
+	const char *key = data;
+	uint32_t field_count = mp_decode_array(&key);
+	assert(field_count >= key_part_count);
+	(void)field_count;
+	const char *key_end = key;
+	for (uint32_t i = 0; i < key_part_count; i++)
+		mp_next(&key_end);
+	uint32_t key_size = mp_sizeof_array(key_part_count) + key_end - key;
+	uint32_t data_size = data_end - data;
+	size_t size = sizeof(struct sql_hash_join_entry) + key_size +
+		      data_size;
+	struct sql_hash_join_entry *entry =
+		region_aligned_alloc(&join->arena, size, alignof(*entry));
+	if (entry == NULL) {
+		diag_set(OutOfMemory, size, "region_aligned_alloc", "entry");
+		return -1;
+	}
+	char *p = mp_encode_array(entry->key, key_part_count);
+	memcpy(p, key, key_end - key);
+	memcpy(entry->key + key_size, data, data_size);
+	entry->next = NULL;
+	entry->last = entry;
+	entry->hash = key_hash(key, join->key_def);
+	entry->key_size = key_size;
+	entry->data_size = data_size;
+
+	struct mh_sql_hash_join_t *hash = join->hash;
+	struct sql_hash_join_key lookup = {entry->key, entry->hash};
+	mh_int_t pos = mh_sql_hash_join_find(hash, &lookup, join->key_def);
+	if (pos != mh_end(hash)) {
+		struct sql_hash_join_entry *first =
+			*mh_sql_hash_join_node(hash, pos);
+		first->last->next = entry;
+		first->last = entry;
+	} else {
+		const struct sql_hash_join_entry **put_entry =
+			(const struct sql_hash_join_entry **)&entry;
+		mh_sql_hash_join_put(hash, put_entry, NULL, join->key_def);
+	}
+	if (sql_hash_join_used(join) > join->memory_limit)
+		return sql_hash_join_spill(join);
+	return 0;
+}
+
+/** Advance the ephemeral space iterator to the next tuple. */
+static int
+sql_hash_join_next_tuple(struct sql_hash_join *join, bool *found)
+{
+	assert(join->it != NULL);
+	if (join->tuple != NULL) {
+		tuple_unref(join->tuple);
+		join->tuple = NULL;
+	}
+	struct tuple *tuple;
+	if (iterator_next(join->it, &tuple) != 0)
+		return -1;
+	*found = tuple != NULL;
+	if (tuple != NULL) {
+		tuple_ref(tuple);
+		join->tuple = tuple;
+	}
+	return 0;
+}
+
+int
+sql_hash_join_seek(struct sql_hash_join *join, const char *key, bool *found)
+{
+	if (join->space != NULL) {
+		if (join->it != NULL)
+			iterator_delete(join->it);
+		uint32_t part_count = mp_decode_array(&key);
+		assert(part_count == join->key_def->part_count);
+		join->it = index_create_iterator(space_index(join->space, 0),
+						 ITER_EQ, key, part_count);
+		if (join->it == NULL)
+			return -1;
+		return sql_hash_join_next_tuple(join, found);
+	}
+	const char *key_parts = key;
+	mp_decode_array(&key_parts);
+	struct sql_hash_join_key lookup = {
+		key, key_hash(key_parts, join->key_def)
+	};
+	struct mh_sql_hash_join_t *hash = join->hash;
+	mh_int_t pos = mh_sql_hash_join_find(hash, &lookup, join->key_def);
+	join->curr = pos != mh_end(hash) ?
+		     *mh_sql_hash_join_node(hash, pos) : NULL;
+	*found = join->curr != NULL;
+	return 0;
+}
+
+int
+sql_hash_join_next(struct sql_hash_join *join, bool *found)
+{
+	if (join->space != NULL)
+		return sql_hash_join_next_tuple(join, found);
+	assert(join->curr != NULL);
+	join->curr = join->curr->next;
+	*found = join->curr != NULL;
+	return 0;
+}
+
+const char *
+sql_hash_join_data(struct sql_hash_join *join, uint32_t *size)
+{
+	if (join->space != NULL) {
+		assert(join->tuple != NULL);
+		*size = tuple_bsize(join->tuple);
+		return tuple_data(join->tuple);
+	}
+	assert(join->curr != NULL);
+	*size = join->curr->data_size;
+	return join->curr->key + join->curr->key_size;
+}
+
+enum field_type
+sql_hash_join_field_type(struct sql_hash_join *join, uint32_t fieldno)
+{
+	assert(fieldno < join->info->field_count);
+	return join->info->types[fieldno];
+}
@@ -0,0 +1,128 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+/*
+ * In-memory hash table used by the SQL executor to join a table
+ * on equality terms when there's no index to look up the rows.
+ *
+ * The table is built once from the rows of the inner table of the
+ * join and then probed for each row of the outer table. Rows are
+ * MessagePack arrays laid out the same way as the rows of an
+ * ephemeral index (see constructAutomaticIndex()): key fields go
+ * first, then other fields used by the query, then a row id. Rows
+ * with equal keys are returned in the order they were inserted.
+ *
+ * If the memory used by the table exceeds the limit, all rows are
+ * moved to an ephemeral space with a tree index over all fields,
+ * and further lookups are served by the tree index, so a query
+ * never uses much more memory than the automatic index would.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "box/field_def.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct sql_space_info;
+struct sql_hash_join;
+
+enum {
+	/**
+	 * Approximate amount of memory used by a hash table per
+	 * row in addition to the row itself, in bytes.
+	 */
+	SQL_HASH_JOIN_ROW_OVERHEAD = 64,
+};
+
+/**
+ * Max amount of memory a hash join may use before falling back on
+ * an ephemeral index, in bytes. Zero disables hash joins.
+ * Set by box.cfg.sql_hash_join_memory.
+ */
+extern size_t sql_hash_join_memory;
+
+/**
+ * Return true if values of the given type can be used as a hash
+ * table key, i.e. values that compare equal always have the same
+ * hash. It isn't so for decimals and datetimes, which have several
+ * encodings of the same value, and for types that may store them.
+ */
+static inline bool
+sql_hash_join_key_type_is_supported(enum field_type type)
+{
+	switch (type) {
+	case FIELD_TYPE_UNSIGNED:
+	case FIELD_TYPE_STRING:
+	case FIELD_TYPE_DOUBLE:
+	case FIELD_TYPE_INTEGER:
+	case FIELD_TYPE_BOOLEAN:
+	case FIELD_TYPE_VARBINARY:
+	case FIELD_TYPE_UUID:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Create an empty hash table for rows described by @a info, with
+ * the first @a key_part_count fields used as the key. The info
+ * must stay valid until the table is deleted. Returns NULL and
+ * sets diag on error.
+ */
+struct sql_hash_join *
+sql_hash_join_new(const struct sql_space_info *info, uint32_t key_part_count,
+		  size_t memory_limit);
+
+/** Delete a hash table. */
+void
+sql_hash_join_delete(struct sql_hash_join *join);
+
+/**
+ * Add a row to a hash table. Returns 0 on success, -1 and sets
+ * diag on error.
+ */
+int
+sql_hash_join_insert(struct sql_hash_join *join, const char *data,
+		     const char *data_end);
+
+/**
+ * Position a hash table at the first row matching the given key,
+ * which is a MessagePack array of key_part_count fields. Sets
+ * @a found to false if there is no such row. Returns 0 on success,
+ * -1 and sets diag on error.
+ */
+int
+sql_hash_join_seek(struct sql_hash_join *join, const char *key, bool *found);
+
+/**
+ * Advance a hash table to the next row matching the key passed to
+ * the last sql_hash_join_seek(). Sets @a found to false if there
+ * are no more such rows. Returns 0 on success, -1 and sets diag on
+ * error.
+ */
+int
+sql_hash_join_next(struct sql_hash_join *join, bool *found);
+
+/**
+ * Return the row a hash table is positioned at and store its size
+ * in @a size.
+ */
+const char *
+sql_hash_join_data(struct sql_hash_join *join, uint32_t *size);
+
+/** Return the type of the given field of the rows of a hash table. */
+enum field_type
+sql_hash_join_field_type(struct sql_hash_join *join, uint32_t fieldno);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
@@ -38,8 +38,12 @@
 #include "tarantoolInt.h"
 #include "mem.h"
 #include "vdbeInt.h"
+#include "batch_scan.h"
+#include "hash_agg.h"
+#include "hash_join.h"
 #include "box/box.h"
 #include "box/coll_id_cache.h"
+#include "box/read_view_scan.h"
 #include "box/schema.h"
 
 /*
@@ -5716,6 +5720,108 @@ updateAccumulator(Parse * pParse, AggInfo * pAggInfo)
 	}
 }
 
+/**
+ * Estimate the number of groups the GROUP BY terms split
+ * @a row_est input rows into, as LogEst. If the terms are the
+ * leading columns of an index of the only source table, the
+ * index statistics are used. Otherwise the number of groups is
+ * guessed the same way as the number of rows of an aggregate
+ * query output (see sqlSelect()).
+ */
+static LogEst
+sql_group_by_est(struct SrcList *src, struct ExprList *group_by,
+		 LogEst row_est)
+{
+	assert(sqlLogEst(100) == 66);
+	LogEst est = MIN(row_est, 66);
+	if (src->nSrc != 1 || src->a[0].space == NULL)
+		return MAX(est, 0);
+	struct SrcList_item *item = &src->a[0];
+	struct space *space = item->space;
+	if (space->def->opts.is_view || space->index_map == NULL)
+		return MAX(est, 0);
+	uint32_t count = group_by->nExpr;
+	for (uint32_t i = 0; i < count; i++) {
+		struct Expr *expr = group_by->a[i].pExpr;
+		if ((expr->op != TK_COLUMN_REF && expr->op != TK_AGG_COLUMN) ||
+		    expr->iTable != item->iCursor)
+			return MAX(est, 0);
+	}
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct index_def *def = space->index[i]->def;
+		if (def->key_def->part_count < count)
+			continue;
+		/* Check that the index key starts with the terms. */
+		uint32_t j;
+		for (j = 0; j < count; j++) {
+			uint32_t fieldno = def->key_def->parts[j].fieldno;
+			uint32_t k;
+			for (k = 0; k < count; k++) {
+				if (group_by->a[k].pExpr->iColumn ==
+				    (int)fieldno)
+					break;
+			}
+			if (k == count)
+				break;
+		}
+		if (j < count)
+			continue;
+		est = sql_space_tuple_log_count(space) -
+		      index_field_tuple_est(def, count);
+		est = MIN(est, row_est);
+		break;
+	}
+	return MAX(est, 0);
+}
+
+/**
+ * Check whether GROUP BY should be computed with a hash table
+ * rather than by sorting the input rows (see hash_agg.h).
+ *
+ * The group key types must hash equal values equally, DISTINCT
+ * aggregates are not supported since their ephemeral spaces
+ * can't be stored along with the group state, and the estimated
+ * number of groups must fit in box.cfg.sql_hash_agg_memory.
+ */
+static bool
+select_group_by_use_hash(struct AggInfo *agg_info,
+			 struct sql_key_info *key_info, LogEst group_est)
+{
+	if (sql_hash_agg_memory == 0)
+		return false;
+	for (uint32_t i = 0; i < key_info->part_count; i++) {
+		if (!sql_hash_join_key_type_is_supported(key_info->parts[i].type))
+			return false;
+	}
+	for (int i = 0; i < agg_info->nFunc; i++) {
+		if (agg_info->aFunc[i].iDistinct >= 0)
+			return false;
+	}
+	size_t group_size = (agg_info->mxReg - agg_info->mnReg + 1) *
+			    sizeof(struct Mem) + SQL_HASH_AGG_GROUP_OVERHEAD;
+	return sqlLogEstToInt(group_est) <= sql_hash_agg_memory / group_size;
+}
+
+/*
+ * Unless an "EXPLAIN QUERY PLAN" command is being processed, this function
+ * is a no-op. Otherwise, it adds a single row of output to the EQP result,
+ * where the caption is of the form:
+ *
+ *   "USE HASH TABLE FOR xxx"
+ *
+ * where xxx is either "DISTINCT" or "GROUP BY".
+ */
+static void
+explain_hash_table(struct Parse *parse, const char *usage)
+{
+	if (parse->explain == 2) {
+		char *msg = sqlMPrintf(parse->db, "USE HASH TABLE FOR %s",
+				       usage);
+		sqlVdbeAddOp4(parse->pVdbe, OP_Explain, parse->iSelectId, 0, 0,
+			      msg, P4_DYNAMIC);
+	}
+}
+
 /**
  * Add a single OP_Explain instruction to the VDBE to explain
  * a simple count(*) query ("SELECT count(*) FROM <tab>").
@@ -5763,6 +5869,541 @@ vdbe_code_raise_on_multiple_rows(struct Parse *parser, int limit_reg, int end_ma
 	sqlReleaseTempReg(parser, r1);
 }
 
+/**
+ * Check if SQL compares values of a field with a literal the same
+ * way a read view scan does, i.e. as a SCALAR index part without a
+ * collation.
+ */
+static bool
+read_view_scan_literal_is_compatible(const struct Expr *literal,
+				     const struct field_def *field)
+{
+	if (field->coll_id != COLL_NONE)
+		return false;
+	bool is_neg = literal->op == TK_UMINUS;
+	if (is_neg)
+		literal = literal->pLeft;
+	switch (literal->op) {
+	case TK_INTEGER:
+	case TK_FLOAT:
+		return field->type == FIELD_TYPE_INTEGER ||
+		       field->type == FIELD_TYPE_UNSIGNED ||
+		       field->type == FIELD_TYPE_DOUBLE ||
+		       field->type == FIELD_TYPE_NUMBER;
+	case TK_STRING:
+		return !is_neg && field->type == FIELD_TYPE_STRING;
+	case TK_TRUE:
+	case TK_FALSE:
+		return !is_neg && field->type == FIELD_TYPE_BOOLEAN;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Check if a WHERE clause is an AND of comparisons of fields of
+ * the table of @a cursor with literals, and return the number of
+ * the comparisons or -1 if it isn't. If @a filters is not NULL,
+ * store the comparisons in it as read view scan filters and
+ * generate code storing the literals in registers starting from
+ * @a reg.
+ */
+static int
+read_view_scan_where(struct Parse *parse, struct Expr *where, int cursor,
+		     struct space_def *def,
+		     struct read_view_scan_filter *filters, int reg)
+{
+	if (where == NULL)
+		return 0;
+	if (where->op == TK_AND) {
+		int left = read_view_scan_where(parse, where->pLeft, cursor,
+						def, filters, reg);
+		if (left < 0)
+			return -1;
+		int right = read_view_scan_where(parse, where->pRight, cursor,
+						 def, filters == NULL ? NULL :
+						 filters + left, reg + left);
+		if (right < 0)
+			return -1;
+		return left + right;
+	}
+	enum read_view_scan_op op;
+	/* Operator to use if the literal is on the left. */
+	enum read_view_scan_op swapped_op;
+	switch (where->op) {
+	case TK_EQ:
+		op = swapped_op = READ_VIEW_SCAN_EQ;
+		break;
+	case TK_NE:
+		op = swapped_op = READ_VIEW_SCAN_NE;
+		break;
+	case TK_LT:
+		op = READ_VIEW_SCAN_LT;
+		swapped_op = READ_VIEW_SCAN_GT;
+		break;
+	case TK_LE:
+		op = READ_VIEW_SCAN_LE;
+		swapped_op = READ_VIEW_SCAN_GE;
+		break;
+	case TK_GT:
+		op = READ_VIEW_SCAN_GT;
+		swapped_op = READ_VIEW_SCAN_LT;
+		break;
+	case TK_GE:
+		op = READ_VIEW_SCAN_GE;
+		swapped_op = READ_VIEW_SCAN_LE;
+		break;
+	default:
+		return -1;
+	}
+	struct Expr *column = where->pLeft;
+	struct Expr *literal = where->pRight;
+	if (column->op != TK_COLUMN_REF) {
+		column = where->pRight;
+		literal = where->pLeft;
+		op = swapped_op;
+	}
+	if (column->op != TK_COLUMN_REF || column->iTable != cursor ||
+	    column->iColumn < 0 ||
+	    !read_view_scan_literal_is_compatible(
+			literal, &def->fields[column->iColumn]))
+		return -1;
+	if (filters != NULL) {
+		filters->fieldno = column->iColumn;
+		filters->op = op;
+		filters->value = NULL;
+		sqlExprCode(parse, literal, reg);
+	}
+	return 1;
+}
+
+/**
+ * Check if all expressions of a result list are fields of the
+ * table of @a cursor and store their numbers in @a fields.
+ */
+static bool
+read_view_scan_fields(struct ExprList *list, int cursor, uint32_t *fields)
+{
+	for (int i = 0; i < list->nExpr; i++) {
+		struct Expr *expr = list->a[i].pExpr;
+		if (expr->op != TK_COLUMN_REF || expr->iTable != cursor ||
+		    expr->iColumn < 0)
+			return false;
+		fields[i] = expr->iColumn;
+	}
+	return true;
+}
+
+/**
+ * Check if all expressions of a result list are aggregates a read
+ * view scan computes the same way SQL does, and store them in
+ * @a aggregates.
+ */
+static bool
+read_view_scan_aggregates(struct ExprList *list, int cursor,
+			  struct space_def *def,
+			  struct read_view_scan_aggregate *aggregates)
+{
+	for (int i = 0; i < list->nExpr; i++) {
+		struct Expr *expr = list->a[i].pExpr;
+		if (expr->op != TK_AGG_FUNCTION ||
+		    (expr->flags & EP_Distinct) != 0 ||
+		    ExprHasProperty(expr, EP_xIsSelect))
+			return false;
+		struct ExprList *args = expr->x.pList;
+		const char *name = expr->u.zToken;
+		if (sqlStrICmp(name, "count") == 0) {
+			aggregates[i].func = READ_VIEW_SCAN_COUNT;
+		} else if (sqlStrICmp(name, "sum") == 0) {
+			aggregates[i].func = READ_VIEW_SCAN_SUM;
+		} else if (sqlStrICmp(name, "min") == 0) {
+			aggregates[i].func = READ_VIEW_SCAN_MIN;
+		} else if (sqlStrICmp(name, "max") == 0) {
+			aggregates[i].func = READ_VIEW_SCAN_MAX;
+		} else {
+			return false;
+		}
+		if (args == NULL || args->nExpr == 0) {
+			if (aggregates[i].func != READ_VIEW_SCAN_COUNT)
+				return false;
+			aggregates[i].fieldno = READ_VIEW_SCAN_ALL_FIELDS;
+			continue;
+		}
+		struct Expr *arg = args->a[0].pExpr;
+		if (args->nExpr != 1 || arg->op != TK_COLUMN_REF ||
+		    arg->iTable != cursor || arg->iColumn < 0)
+			return false;
+		aggregates[i].fieldno = arg->iColumn;
+		struct field_def *field = &def->fields[arg->iColumn];
+		switch (aggregates[i].func) {
+		case READ_VIEW_SCAN_COUNT:
+			break;
+		case READ_VIEW_SCAN_SUM:
+			if (field->type != FIELD_TYPE_INTEGER &&
+			    field->type != FIELD_TYPE_UNSIGNED &&
+			    field->type != FIELD_TYPE_DOUBLE)
+				return false;
+			break;
+		default:
+			if (field->coll_id != COLL_NONE)
+				return false;
+			if (field->type != FIELD_TYPE_INTEGER &&
+			    field->type != FIELD_TYPE_UNSIGNED &&
+			    field->type != FIELD_TYPE_DOUBLE &&
+			    field->type != FIELD_TYPE_NUMBER &&
+			    field->type != FIELD_TYPE_STRING &&
+			    field->type != FIELD_TYPE_BOOLEAN &&
+			    field->type != FIELD_TYPE_VARBINARY)
+				return false;
+			break;
+		}
+	}
+	return true;
+}
+
+/**
+ * Generate code for a SELECT that scans a single memtx table with
+ * an AND of comparisons of fields with literals in WHERE and either
+ * fields or simple aggregates in the result list. The table is
+ * scanned over a read view by the worker threads, so that long
+ * scans don't block the tx thread. Used if the sql_read_view_scan
+ * session setting is set and a read view scan is available in the
+ * current context, see read_view_scan_is_available().
+ *
+ * @param parse Parsing context.
+ * @param select SELECT to generate code for.
+ * @param dest Destination of the result rows.
+ * @retval true if the code was generated.
+ * @retval false if the SELECT isn't of the supported form.
+ */
+static bool
+select_code_read_view_scan(struct Parse *parse, struct Select *select,
+			   struct SelectDest *dest)
+{
+	if (!read_view_scan_is_available() ||
+	    dest->eDest != SRT_Output || select->pPrior != NULL ||
+	    select->pGroupBy != NULL || select->pHaving != NULL ||
+	    select->pOrderBy != NULL ||
+	    (select->selFlags & SF_Distinct) != 0 ||
+	    select->pSrc->nSrc != 1)
+		return false;
+	struct SrcList_item *src = &select->pSrc->a[0];
+	struct space *space = src->space;
+	if (src->pSelect != NULL || src->fg.isIndexedBy || space == NULL ||
+	    space->def->opts.is_view || !space_is_memtx(space) ||
+	    space_index(space, 0) == NULL)
+		return false;
+	struct space_def *space_def = space->def;
+	int cursor = src->iCursor;
+	int filter_count = read_view_scan_where(parse, select->pWhere, cursor,
+						space_def, NULL, 0);
+	if (filter_count < 0)
+		return false;
+	struct ExprList *list = select->pEList;
+	bool is_aggregate = (select->selFlags & SF_Aggregate) != 0;
+	size_t filters_size = filter_count * sizeof(struct read_view_scan_filter);
+	size_t size = sizeof(struct read_view_scan_def) + filters_size +
+		      list->nExpr * sizeof(struct read_view_scan_aggregate);
+	struct sql *db = parse->db;
+	struct read_view_scan_def *def = sqlDbMallocZero(db, size);
+	if (def == NULL)
+		return false;
+	struct read_view_scan_filter *filters =
+		(struct read_view_scan_filter *)(def + 1);
+	def->filters = filters;
+	def->filter_count = filter_count;
+	def->limit = UINT64_MAX;
+	void *result = (char *)filters + filters_size;
+	if (is_aggregate) {
+		struct read_view_scan_aggregate *aggregates = result;
+		if (!read_view_scan_aggregates(list, cursor, space_def,
+					       aggregates) ||
+		    /* SELECT count(*) FROM t doesn't need a scan. */
+		    (filter_count == 0 && list->nExpr == 1 &&
+		     aggregates[0].fieldno == READ_VIEW_SCAN_ALL_FIELDS)) {
+			sqlDbFree(db, def);
+			return false;
+		}
+		def->aggregates = aggregates;
+		def->aggregate_count = list->nExpr;
+	} else {
+		uint32_t *fields = result;
+		if (!read_view_scan_fields(list, cursor, fields)) {
+			sqlDbFree(db, def);
+			return false;
+		}
+		def->fields = fields;
+		def->field_count = list->nExpr;
+	}
+	struct Vdbe *v = sqlGetVdbe(parse);
+	int end = sqlVdbeMakeLabel(v);
+	computeLimitRegisters(parse, select, end);
+	int reg_filters = parse->nMem + 1;
+	parse->nMem += filter_count;
+	read_view_scan_where(parse, select->pWhere, cursor, space_def,
+			     filters, reg_filters);
+	int reg_result = parse->nMem + 1;
+	parse->nMem += list->nExpr;
+	if (parse->explain == 2) {
+		char *msg = sqlMPrintf(db, "SCAN TABLE %s USING READ VIEW",
+				       space_def->name);
+		sqlVdbeAddOp4(v, OP_Explain, parse->iSelectId, 0, 0, msg,
+			      P4_DYNAMIC);
+	}
+	sqlVdbeAddOp4(v, OP_ReadViewOpen, cursor, space_def->id, reg_filters,
+		      (char *)def, P4_READ_VIEW_SCAN);
+	int loop = sqlVdbeAddOp3(v, OP_ReadViewNext, cursor, end, reg_result);
+	codeOffset(v, select->iOffset, loop);
+	sqlVdbeAddOp2(v, OP_ResultRow, reg_result, list->nExpr);
+	if (select->iLimit != 0)
+		sqlVdbeAddOp2(v, OP_DecrJumpZero, select->iLimit, end);
+	sqlVdbeGoto(v, loop);
+	sqlVdbeResolveLabel(v, end);
+	sqlVdbeAddOp1(v, OP_Close, cursor);
+	return true;
+}
+
+/**
+ * Check if a field of a space is a part of one of its indexes, so
+ * that a condition on it or its MIN/MAX may be served by an index
+ * lookup.
+ */
+static bool
+batch_scan_field_is_indexed(struct space *space, uint32_t fieldno)
+{
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct key_def *key_def = space->index[i]->def->key_def;
+		for (uint32_t j = 0; j < key_def->part_count; j++) {
+			if (key_def->parts[j].fieldno == fieldno)
+				return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Return the number of the column vector of a field of a batched
+ * scan, adding it to the definition if needed.
+ */
+static uint32_t
+batch_scan_column(struct sql_batch_scan_def *def, uint32_t fieldno)
+{
+	for (uint32_t i = 0; i < def->field_count; i++) {
+		if (def->fields[i] == fieldno)
+			return i;
+	}
+	def->fields[def->field_count] = fieldno;
+	return def->field_count++;
+}
+
+/** Check if an expression is a value a batched scan filter takes. */
+static bool
+batch_scan_value_is_supported(const struct Expr *expr)
+{
+	if (expr->op == TK_UMINUS) {
+		expr = expr->pLeft;
+		return expr->op == TK_INTEGER || expr->op == TK_FLOAT;
+	}
+	switch (expr->op) {
+	case TK_INTEGER:
+	case TK_FLOAT:
+	case TK_STRING:
+	case TK_BLOB:
+	case TK_TRUE:
+	case TK_FALSE:
+	case TK_NULL:
+	case TK_VARIABLE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Check if a WHERE clause is an AND of comparisons of non-indexed
+ * fields of the table of @a cursor with literals or parameters,
+ * and return the number of the comparisons or -1 if it isn't. If
+ * @a def is not NULL, add the comparisons to it as filters and
+ * generate code storing the values in registers starting from
+ * @a reg.
+ */
+static int
+batch_scan_where(struct Parse *parse, struct Expr *where, int cursor,
+		 struct space *space, struct sql_batch_scan_def *def, int reg)
+{
+	if (where == NULL)
+		return 0;
+	if (where->op == TK_AND) {
+		int left = batch_scan_where(parse, where->pLeft, cursor, space,
+					    def, reg);
+		if (left < 0)
+			return -1;
+		int right = batch_scan_where(parse, where->pRight, cursor,
+					     space, def, reg + left);
+		if (right < 0)
+			return -1;
+		return left + right;
+	}
+	int op = where->op;
+	if (op != TK_EQ && op != TK_NE && op != TK_LT && op != TK_LE &&
+	    op != TK_GT && op != TK_GE)
+		return -1;
+	struct Expr *column = where->pLeft;
+	struct Expr *value = where->pRight;
+	bool is_value_left = column->op != TK_COLUMN_REF;
+	if (is_value_left) {
+		column = where->pRight;
+		value = where->pLeft;
+		/* Make it <column> <op> <value>. */
+		if (op == TK_LT)
+			op = TK_GT;
+		else if (op == TK_LE)
+			op = TK_GE;
+		else if (op == TK_GT)
+			op = TK_LT;
+		else if (op == TK_GE)
+			op = TK_LE;
+	}
+	if (column->op != TK_COLUMN_REF || column->iTable != cursor ||
+	    column->iColumn < 0 || !batch_scan_value_is_supported(value) ||
+	    batch_scan_field_is_indexed(space, column->iColumn))
+		return -1;
+	if (def != NULL) {
+		uint32_t id;
+		if (sql_binary_compare_coll_seq(parse, where->pLeft,
+						where->pRight, &id) != 0)
+			return -1;
+		struct sql_batch_scan_filter *filter =
+			&def->filters[def->filter_count++];
+		filter->column = batch_scan_column(def, column->iColumn);
+		filter->op = op;
+		filter->coll = coll_by_id(id)->coll;
+		filter->is_value_left = is_value_left;
+		sqlExprCode(parse, value, reg);
+	}
+	return 1;
+}
+
+/**
+ * Check if all aggregates of a SELECT are built-in functions of
+ * at most one field of the table of @a cursor, and add them to
+ * @a def. Returns false if they aren't.
+ */
+static bool
+batch_scan_aggregates(struct Parse *parse, struct AggInfo *agg_info,
+		      int cursor, struct space *space, u8 minmax_flag,
+		      struct sql_batch_scan_def *def)
+{
+	for (int i = 0; i < agg_info->nFunc; i++) {
+		struct AggInfo_func *agg_func = &agg_info->aFunc[i];
+		struct func *func = agg_func->func;
+		if (func->def->language != FUNC_LANGUAGE_SQL_BUILTIN ||
+		    agg_func->iDistinct >= 0)
+			return false;
+		struct sql_batch_scan_agg *agg = &def->aggs[def->agg_count++];
+		agg->func = func;
+		agg->coll = NULL;
+		agg->reg = agg_func->iMem;
+		struct ExprList *args = agg_func->pExpr->x.pList;
+		if (args == NULL || args->nExpr == 0) {
+			agg->column = SQL_BATCH_SCAN_NO_COLUMN;
+			continue;
+		}
+		struct Expr *arg = args->a[0].pExpr;
+		if (args->nExpr != 1 || arg->op != TK_AGG_COLUMN ||
+		    arg->iTable != cursor || arg->iColumn < 0)
+			return false;
+		/* MIN/MAX of an indexed field is looked up in the index. */
+		if (minmax_flag != WHERE_ORDERBY_NORMAL &&
+		    batch_scan_field_is_indexed(space, arg->iColumn))
+			return false;
+		agg->column = batch_scan_column(def, arg->iColumn);
+		if (sql_func_flag_is_set(func, SQL_FUNC_NEEDCOLL)) {
+			bool unused;
+			uint32_t id;
+			if (sql_expr_coll(parse, arg, &unused, &id,
+					  &agg->coll) != 0)
+				return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Generate code updating the accumulators of an aggregate SELECT
+ * without GROUP BY by a batched scan of its only table, see
+ * batch_scan.h. The table must be scanned in full and the WHERE
+ * clause must be an AND of comparisons of fields with literals or
+ * parameters. Used unless the sql_vdbe_batch session setting is
+ * cleared.
+ *
+ * @param parse Parsing context.
+ * @param select SELECT to generate code for.
+ * @param agg_info Aggregates of the SELECT.
+ * @param minmax_flag Result of minMaxQuery() for the SELECT.
+ * @retval true if the code was generated.
+ * @retval false if the SELECT isn't of the supported form.
+ */
+static bool
+select_code_batch_scan(struct Parse *parse, struct Select *select,
+		       struct AggInfo *agg_info, u8 minmax_flag)
+{
+	if (agg_info->nAccumulator != 0 || agg_info->nFunc == 0 ||
+	    select->pSrc->nSrc != 1)
+		return false;
+	struct SrcList_item *src = &select->pSrc->a[0];
+	struct space *space = src->space;
+	if (src->pSelect != NULL || src->fg.isIndexedBy || space == NULL ||
+	    space->def->opts.is_view || space_index(space, 0) == NULL)
+		return false;
+	int cursor = src->iCursor;
+	int filter_count = batch_scan_where(parse, select->pWhere, cursor,
+					    space, NULL, 0);
+	if (filter_count < 0)
+		return false;
+	uint32_t field_count = filter_count + agg_info->nFunc;
+	size_t size = sizeof(struct sql_batch_scan_def) +
+		      field_count * sizeof(uint32_t) +
+		      filter_count * sizeof(struct sql_batch_scan_filter) +
+		      agg_info->nFunc * sizeof(struct sql_batch_scan_agg);
+	struct sql *db = parse->db;
+	struct sql_batch_scan_def *def = sqlDbMallocZero(db, size);
+	if (def == NULL)
+		return false;
+	def->filters = (struct sql_batch_scan_filter *)(def + 1);
+	def->aggs = (struct sql_batch_scan_agg *)(def->filters + filter_count);
+	def->fields = (uint32_t *)(def->aggs + agg_info->nFunc);
+	if (!batch_scan_aggregates(parse, agg_info, cursor, space,
+				   minmax_flag, def)) {
+		sqlDbFree(db, def);
+		return false;
+	}
+	struct Vdbe *v = sqlGetVdbe(parse);
+	int reg_values = parse->nMem + 1;
+	parse->nMem += filter_count;
+	batch_scan_where(parse, select->pWhere, cursor, space, def,
+			 reg_values);
+	if (parse->is_aborted) {
+		sqlDbFree(db, def);
+		return true;
+	}
+	assert(def->filter_count == (uint32_t)filter_count);
+	if (parse->explain == 2) {
+		char *msg = sqlMPrintf(db, "SCAN TABLE %s IN BATCHES",
+				       space->def->name);
+		sqlVdbeAddOp4(v, OP_Explain, parse->iSelectId, 0, 0, msg,
+			      P4_DYNAMIC);
+	}
+	int end = sqlVdbeMakeLabel(v);
+	sqlVdbeAddOp4(v, OP_BatchOpen, cursor, space->def->id, 0,
+		      (char *)def, P4_BATCH_SCAN);
+	int loop = sqlVdbeAddOp3(v, OP_BatchNext, cursor, end, reg_values);
+	sqlVdbeGoto(v, loop);
+	sqlVdbeResolveLabel(v, end);
+	sqlVdbeAddOp1(v, OP_Close, cursor);
+	return true;
+}
+
 /*
  * Generate code for the SELECT statement given in the p argument.
  *
@@ -5912,6 +6553,13 @@ sqlSelect(Parse * pParse,		/* The parser context */
 		return rc;
 	}
 
+	if ((pParse->sql_flags & SQL_ReadViewScan) != 0 &&
+	    select_code_read_view_scan(pParse, p, pDest)) {
+		pEList = p->pEList;
+		rc = pParse->is_aborted;
+		goto select_end;
+	}
+
 	/* Generate code for all sub-queries in the FROM clause
 	 */
 	for (i = 0; i < pTabList->nSrc; i++) {
@@ -6345,6 +6993,17 @@ sqlSelect(Parse * pParse,		/* The parser context */
 			int addrSortingIdx;	/* The OP_OpenEphemeral for the sorting index */
 			int addrReset;	/* Subroutine for resetting the accumulator */
 			int regReset;	/* Return address register for reset subroutine */
+			int addrHashAgg;	/* The OP_HashAggOpen for the hash table */
+			int hashAggIdx;	/* Cursor of the GROUP BY hash table */
+			/* Number of the accumulator registers. */
+			int nAggReg = sAggInfo.mxReg - sAggInfo.mnReg + 1;
+			/* True if groups are collected in the hash table. */
+			bool useHash = false;
+			/* Set to 1 once a row is passed to the sorter. */
+			int regSpilled;
+			int addrSpilledInit;
+			/* Sorter column marking groups of the hash table. */
+			int iMarkCol = 0;
 
 			/* If there is a GROUP BY clause we might need a sorting index to
 			 * implement it.  Allocate that sorting index now.  If it turns out
@@ -6359,6 +7018,18 @@ sqlSelect(Parse * pParse,		/* The parser context */
 					      sAggInfo.sortingIdx,
 					      sAggInfo.nSortingColumn, 0,
 					      (char *)key_info, P4_KEYINFO);
+			/*
+			 * The groups may also be collected in a hash table
+			 * instead of sorting the rows. The decision is made
+			 * once the row count is estimated, the instruction is
+			 * converted into a Noop if the table isn't used.
+			 */
+			hashAggIdx = pParse->nTab++;
+			addrHashAgg =
+			    sqlVdbeAddOp4(v, OP_HashAggOpen, hashAggIdx,
+					  nAggReg, 0,
+					  (char *)sql_key_info_ref(key_info),
+					  P4_KEYINFO);
 
 			/* Initialize memory locations used by GROUP BY aggregate processing
 			 */
@@ -6376,6 +7047,9 @@ sqlSelect(Parse * pParse,		/* The parser context */
 			VdbeComment((v, "clear abort flag"));
 			sqlVdbeAddOp2(v, OP_Integer, 0, iUseFlag);
 			VdbeComment((v, "indicate accumulator empty"));
+			regSpilled = ++pParse->nMem;
+			addrSpilledInit = sqlVdbeAddOp2(v, OP_Integer, 0,
+							regSpilled);
 			sqlVdbeAddOp3(v, OP_Null, 0, iAMem,
 					  iAMem + pGroupBy->nExpr - 1);
 
@@ -6409,12 +7083,27 @@ sqlSelect(Parse * pParse,		/* The parser context */
 				int regRecord;
 				int nCol;
 				int nGroupBy;
-
-				explainTempTable(pParse,
-						 (sDistinct.isTnct
-						  && (p->
-						      selFlags & SF_Distinct) ==
-						  0) ? "DISTINCT" : "GROUP BY");
+				const char *zUsage =
+					sDistinct.isTnct &&
+					(p->selFlags & SF_Distinct) == 0 ?
+					"DISTINCT" : "GROUP BY";
+				LogEst nGroupEst =
+					sql_group_by_est(pTabList, pGroupBy,
+							 sqlWhereOutputRowCount(pWInfo));
+
+				useHash = select_group_by_use_hash(&sAggInfo,
+								   key_info,
+								   nGroupEst);
+				if (useHash) {
+					explain_hash_table(pParse, zUsage);
+					uint64_t nGroup =
+						sqlLogEstToInt(nGroupEst);
+					sqlVdbeChangeP3(v, addrHashAgg,
+							MIN(nGroup, INT32_MAX));
+				} else {
+					explainTempTable(pParse, zUsage);
+					sqlVdbeChangeToNoop(v, addrHashAgg);
+				}
 
 				groupBySort = 1;
 				nGroupBy = pGroupBy->nExpr;
@@ -6426,10 +7115,57 @@ sqlSelect(Parse * pParse,		/* The parser context */
 						j++;
 					}
 				}
+				/*
+				 * If the hash table is used, rows of the groups
+				 * that don't fit in it are passed to the sorter,
+				 * followed by one row for each group of the hash
+				 * table. The latter are marked with 1 in the last
+				 * column, see the sorter loop below.
+				 */
+				if (useHash)
+					iMarkCol = nCol++;
+				else
+					sqlVdbeChangeToNoop(v, addrSpilledInit);
 				regBase = sqlGetTempRange(pParse, nCol);
 				sqlExprCacheClear(pParse);
 				sqlExprCodeExprList(pParse, pGroupBy,
 							regBase, 0, 0);
+				if (useHash) {
+					int addrLoad = sqlVdbeMakeLabel(v);
+					int addrUpdate = sqlVdbeMakeLabel(v);
+					int addrSpill = sqlVdbeMakeLabel(v);
+					sqlVdbeAddOp3(v, OP_HashAggFind,
+						      hashAggIdx, addrLoad,
+						      regBase);
+					VdbeCoverage(v);
+					sqlVdbeAddOp3(v, OP_HashAggInsert,
+						      hashAggIdx, addrSpill,
+						      regBase);
+					VdbeCoverage(v);
+					sqlVdbeAddOp2(v, OP_Gosub, regReset,
+						      addrReset);
+					VdbeComment((v, "new group"));
+					sqlVdbeGoto(v, addrUpdate);
+					sqlVdbeResolveLabel(v, addrLoad);
+					sqlVdbeAddOp2(v, OP_HashAggLoad,
+						      hashAggIdx,
+						      sAggInfo.mnReg);
+					sqlVdbeResolveLabel(v, addrUpdate);
+					updateAccumulator(pParse, &sAggInfo);
+					if (pParse->is_aborted)
+						goto select_end;
+					sqlVdbeAddOp2(v, OP_HashAggStore,
+						      hashAggIdx,
+						      sAggInfo.mnReg);
+					sqlVdbeGoto(v,
+						    sqlWhereContinueLabel(pWInfo));
+					sqlVdbeResolveLabel(v, addrSpill);
+					sqlExprCacheClear(pParse);
+					sqlVdbeAddOp2(v, OP_Integer, 1,
+						      regSpilled);
+					sqlVdbeAddOp2(v, OP_Integer, 0,
+						      regBase + iMarkCol);
+				}
 				j = nGroupBy;
 				for (i = 0; i < sAggInfo.nColumn; i++) {
 					struct AggInfo_col *pCol =
@@ -6451,6 +7187,73 @@ sqlSelect(Parse * pParse,		/* The parser context */
 				sqlReleaseTempReg(pParse, regRecord);
 				sqlReleaseTempRange(pParse, regBase, nCol);
 				sqlWhereEnd(pWInfo);
+				if (useHash) {
+					int addrMark = sqlVdbeMakeLabel(v);
+					int addrMarkEnd = sqlVdbeMakeLabel(v);
+					int addrGroup;
+					sqlVdbeAddOp2(v, OP_IfPos, regSpilled,
+						      addrMark);
+					VdbeCoverage(v);
+					/*
+					 * All groups are in the hash table, output
+					 * them in GROUP BY order.
+					 */
+					sqlVdbeAddOp2(v, OP_HashAggSort,
+						      hashAggIdx, addrEnd);
+					VdbeCoverage(v);
+					addrGroup = sqlVdbeAddOp2(v,
+								  OP_HashAggLoad,
+								  hashAggIdx,
+								  sAggInfo.mnReg);
+					sqlVdbeAddOp2(v, OP_Integer, 1,
+						      iUseFlag);
+					sqlVdbeAddOp2(v, OP_Gosub,
+						      regOutputRow,
+						      addrOutputRow);
+					VdbeComment((v, "output one row"));
+					sqlVdbeAddOp2(v, OP_IfPos, iAbortFlag,
+						      addrEnd);
+					VdbeCoverage(v);
+					sqlVdbeAddOp2(v, OP_HashAggNext,
+						      hashAggIdx, addrGroup);
+					VdbeCoverage(v);
+					sqlVdbeGoto(v, addrEnd);
+					/*
+					 * Some rows were passed to the sorter, add
+					 * a marker row for each group of the hash
+					 * table so that all groups come out of the
+					 * sorter in GROUP BY order.
+					 */
+					sqlVdbeResolveLabel(v, addrMark);
+					sqlVdbeAddOp2(v, OP_HashAggSort,
+						      hashAggIdx, addrMarkEnd);
+					VdbeCoverage(v);
+					regBase = sqlGetTempRange(pParse, nCol);
+					regRecord = sqlGetTempReg(pParse);
+					addrGroup = sqlVdbeAddOp2(v,
+								  OP_HashAggKey,
+								  hashAggIdx,
+								  regBase);
+					if (iMarkCol > nGroupBy) {
+						sqlVdbeAddOp3(v, OP_Null, 0,
+							      regBase + nGroupBy,
+							      regBase + iMarkCol - 1);
+					}
+					sqlVdbeAddOp2(v, OP_Integer, 1,
+						      regBase + iMarkCol);
+					sqlVdbeAddOp3(v, OP_MakeRecord, regBase,
+						      nCol, regRecord);
+					sqlVdbeAddOp2(v, OP_SorterInsert,
+						      sAggInfo.sortingIdx,
+						      regRecord);
+					sqlVdbeAddOp2(v, OP_HashAggNext,
+						      hashAggIdx, addrGroup);
+					VdbeCoverage(v);
+					sqlReleaseTempReg(pParse, regRecord);
+					sqlReleaseTempRange(pParse, regBase,
+							    nCol);
+					sqlVdbeResolveLabel(v, addrMarkEnd);
+				}
 				sAggInfo.sortingIdxPTab = sortPTab =
 				    pParse->nTab++;
 				sortOut = sqlGetTempReg(pParse);
@@ -6538,9 +7341,39 @@ sqlSelect(Parse * pParse,		/* The parser context */
 			 * the current row
 			 */
 			sqlVdbeJumpHere(v, addr1);
-			updateAccumulator(pParse, &sAggInfo);
-			if (pParse->is_aborted)
-				goto select_end;
+			if (useHash) {
+				/*
+				 * A marker row stands for a group of the hash
+				 * table, which has no other rows in the sorter.
+				 * Take the group state from the hash table.
+				 */
+				int regMark = sqlGetTempReg(pParse);
+				int addrMark = sqlVdbeMakeLabel(v);
+				int addrFound = sqlVdbeMakeLabel(v);
+				int addrAccumEnd = sqlVdbeMakeLabel(v);
+				sqlVdbeAddOp3(v, OP_Column, sortPTab, iMarkCol,
+					      regMark);
+				sqlVdbeAddOp2(v, OP_IfPos, regMark, addrMark);
+				VdbeCoverage(v);
+				sqlReleaseTempReg(pParse, regMark);
+				updateAccumulator(pParse, &sAggInfo);
+				if (pParse->is_aborted)
+					goto select_end;
+				sqlVdbeGoto(v, addrAccumEnd);
+				sqlVdbeResolveLabel(v, addrMark);
+				sqlVdbeAddOp3(v, OP_HashAggFind, hashAggIdx,
+					      addrFound, iBMem);
+				VdbeCoverage(v);
+				sqlVdbeGoto(v, addrAccumEnd);
+				sqlVdbeResolveLabel(v, addrFound);
+				sqlVdbeAddOp2(v, OP_HashAggLoad, hashAggIdx,
+					      sAggInfo.mnReg);
+				sqlVdbeResolveLabel(v, addrAccumEnd);
+			} else {
+				updateAccumulator(pParse, &sAggInfo);
+				if (pParse->is_aborted)
+					goto select_end;
+			}
 			sqlVdbeAddOp2(v, OP_Integer, 1, iUseFlag);
 			VdbeComment((v, "indicate data in accumulator"));
 
@@ -6554,6 +7387,8 @@ sqlSelect(Parse * pParse,		/* The parser context */
 			} else {
 				sqlWhereEnd(pWInfo);
 				sqlVdbeChangeToNoop(v, addrSortingIdx);
+				sqlVdbeChangeToNoop(v, addrHashAgg);
+				sqlVdbeChangeToNoop(v, addrSpilledInit);
 			}
 
 			/* Output the final row of result
@@ -6696,27 +7531,37 @@ sqlSelect(Parse * pParse,		/* The parser context */
 				 * of output.
 				 */
 				resetAccumulator(pParse, &sAggInfo);
-				pWInfo =
-				    sqlWhereBegin(pParse, pTabList, pWhere,
-						      pMinMax, 0, flag, 0);
-				if (pWInfo == 0) {
-					sql_expr_list_delete(db, pDel);
-					goto select_end;
-				}
-				updateAccumulator(pParse, &sAggInfo);
-				if (pParse->is_aborted)
-					goto select_end;
-				assert(pMinMax == 0 || pMinMax->nExpr == 1);
-				if (sqlWhereIsOrdered(pWInfo) > 0) {
-					sqlVdbeGoto(v,
-							sqlWhereBreakLabel
-							(pWInfo));
-					VdbeComment((v, "%s() by index",
-						     (flag ==
-						      WHERE_ORDERBY_MIN ? "min"
-						      : "max")));
+				if ((pParse->sql_flags & SQL_VdbeBatch) != 0 &&
+				    select_code_batch_scan(pParse, p, &sAggInfo,
+							   flag)) {
+					if (pParse->is_aborted) {
+						sql_expr_list_delete(db, pDel);
+						goto select_end;
+					}
+				} else {
+					pWInfo = sqlWhereBegin(pParse, pTabList,
+							       pWhere, pMinMax,
+							       0, flag, 0);
+					if (pWInfo == 0) {
+						sql_expr_list_delete(db, pDel);
+						goto select_end;
+					}
+					updateAccumulator(pParse, &sAggInfo);
+					if (pParse->is_aborted)
+						goto select_end;
+					assert(pMinMax == 0 ||
+					       pMinMax->nExpr == 1);
+					if (sqlWhereIsOrdered(pWInfo) > 0) {
+						sqlVdbeGoto(v,
+							    sqlWhereBreakLabel
+							    (pWInfo));
+						VdbeComment((v, "%s() by index",
+							     (flag ==
+							      WHERE_ORDERBY_MIN ?
+							      "min" : "max")));
+					}
+					sqlWhereEnd(pWInfo);
 				}
-				sqlWhereEnd(pWInfo);
 				finalizeAggFunctions(pParse, &sAggInfo);
 				sql_expr_list_delete(db, pDel);
 			}
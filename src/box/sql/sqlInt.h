@@ -1056,6 +1056,8 @@ struct sql {
 #define SQL_EnableTrigger  0x01000000	/* True to enable triggers */
 #define SQL_DeferFKs       0x02000000	/* Defer all FK constraints */
 #define SQL_VdbeEQP        0x08000000	/* Debug EXPLAIN QUERY PLAN */
+#define SQL_ReadViewScan   0x10000000	/* Scan read views in workers */
+#define SQL_VdbeBatch      0x20000000	/* Aggregate full scans in batches */
 #define SQL_FullMetadata   0x04000000	/* Display optional properties
 					 * (nullability, autoincrement, alias)
 					 * in metadata.
@@ -4044,38 +4046,49 @@ sql_expr_new_column(struct sql *db, struct SrcList *src_list, int src_idx,
 
 int sqlExprCheckIN(Parse *, Expr *);
 
-/* TODO: Enable this function when stat-tables will be revived. */
-static inline int
-sqlStat4ProbeSetValue(struct Parse *parse, ...)
-{
-	(void)parse;
-	unreachable();
-	return 0;
-}
+/**
+ * Append values of the literals of @a expr, which is a scalar or
+ * a vector of @a elem_count elements, to the record @a rec used to
+ * probe the statistics of index @a idx, starting with field
+ * @a field_no. The record is allocated if *@a rec is NULL. A NULL
+ * @a expr stands for NULL. Stops at the first element that isn't
+ * a literal of a type compatible with the index part and sets
+ * @a extract_count to the number of values appended.
+ *
+ * @retval 0 Success, even if no value was appended.
+ * @retval -1 Memory error.
+ */
+int
+sqlStat4ProbeSetValue(struct Parse *parse, struct index_def *idx,
+		      struct UnpackedRecord **rec, struct Expr *expr,
+		      int elem_count, int field_no, int *extract_count);
 
-/* TODO: Enable this function when stat-tables will be revived. */
-static inline int
-sqlStat4ValueFromExpr(struct Parse *parse, ...)
-{
-	(void)parse;
-	unreachable();
-	return 0;
-}
+/**
+ * Extract the value of a literal compatible with a column of type
+ * @a type into a new value. Sets *@a val to NULL if the value
+ * can't be extracted.
+ *
+ * @retval 0 Success.
+ * @retval -1 Memory error.
+ */
+int
+sqlStat4ValueFromExpr(struct Parse *parse, struct Expr *expr,
+		      enum field_type type, struct Mem **val);
 
-/* TODO: Enable this function when stat-tables will be revived. */
-static inline void
-sqlStat4ProbeFree(struct UnpackedRecord *rec)
-{
-	(void)rec;
-}
+/** Free a record allocated by sqlStat4ProbeSetValue(). */
+void
+sqlStat4ProbeFree(struct UnpackedRecord *rec);
 
-/* TODO: Enable this function when stat-tables will be revived. */
-static inline int
-sql_stat4_column(struct sql *db, ...)
-{
-	(void)db;
-	return 0;
-}
+/**
+ * Extract field @a col_num of a MsgPack array @a record into
+ * *@a res, allocating a new value if it is NULL.
+ *
+ * @retval 0 Success.
+ * @retval -1 Memory error.
+ */
+int
+sql_stat4_column(struct sql *db, const char *record, uint32_t col_num,
+		 struct Mem **res);
 
 /*
  * The interface to the LEMON-generated parser
@@ -49,6 +49,9 @@
 #include "mem.h"
 #include "vdbeInt.h"
 #include "tarantoolInt.h"
+#include "batch_scan.h"
+#include "hash_agg.h"
+#include "hash_join.h"
 
 #include "msgpuck/msgpuck.h"
 #include "mpstream/mpstream.h"
@@ -57,6 +60,7 @@
 #include "box/space.h"
 #include "box/sequence.h"
 #include "box/session_settings.h"
+#include "box/read_view_scan.h"
 
 #ifdef SQL_DEBUG
 
@@ -1928,6 +1932,12 @@ case OP_Column: {
 			} else {
 				goto op_column_out;
 			}
+		} else if (pC->eCurType == CURTYPE_HASH_JOIN) {
+			uint32_t size;
+			const char *data =
+				sql_hash_join_data(pC->uc.hash_join, &size);
+			vdbe_field_ref_prepare_data(&pC->field_ref, data,
+						    size);
 		} else {
 			pCrsr = pC->uc.pCursor;
 			assert(pC->eCurType==CURTYPE_TARANTOOL);
@@ -1941,7 +1951,8 @@ case OP_Column: {
 		pC->cacheStatus = p->cacheCtr;
 	}
 	assert(pC->eCurType == CURTYPE_TARANTOOL ||
-	       pC->eCurType == CURTYPE_PSEUDO);
+	       pC->eCurType == CURTYPE_PSEUDO ||
+	       pC->eCurType == CURTYPE_HASH_JOIN);
 	struct Mem *default_val_mem =
 		pOp->p4type == P4_MEM ? pOp->p4.pMem : NULL;
 	if (vdbe_field_ref_fetch(&pC->field_ref, p2, pDest) != 0)
@@ -1958,6 +1969,8 @@ case OP_Column: {
 	/* Currently PSEUDO cursor does not have info about field types. */
 	if (pC->eCurType == CURTYPE_TARANTOOL)
 		field_type = pC->uc.pCursor->space->def->fields[p2].type;
+	else if (pC->eCurType == CURTYPE_HASH_JOIN)
+		field_type = sql_hash_join_field_type(pC->uc.hash_join, p2);
 	if (field_type == FIELD_TYPE_ANY)
 		pDest->flags |= MEM_Any;
 	else if (field_type == FIELD_TYPE_SCALAR)
@@ -2440,6 +2453,439 @@ case OP_OpenPseudo: {
 	break;
 }
 
+/* Opcode: HashJoinOpen P1 P2 * P4 *
+ * Synopsis: key=P2 fields
+ *
+ * Open a new cursor P1 on an empty hash table used to join a
+ * table on equality terms. P4 describes the rows inserted in the
+ * table, the first P2 fields of a row form its key.
+ *
+ * If the table grows larger than box.cfg.sql_hash_join_memory,
+ * its rows are moved to an ephemeral space, which is used for
+ * lookups after that.
+ */
+case OP_HashJoinOpen: {
+	assert(pOp->p1 >= 0);
+	assert(pOp->p2 > 0);
+	assert(pOp->p4type == P4_DYNAMIC);
+	struct sql_space_info *info = pOp->p4.space_info;
+	assert(info != NULL);
+	struct VdbeCursor *cur = allocateCursor(p, pOp->p1, info->field_count,
+						CURTYPE_HASH_JOIN);
+	if (cur == NULL)
+		goto no_mem;
+	cur->nullRow = 1;
+	cur->uc.hash_join = sql_hash_join_new(info, pOp->p2,
+					      sql_hash_join_memory);
+	if (cur->uc.hash_join == NULL)
+		goto abort_due_to_error;
+	break;
+}
+
+/* Opcode: HashJoinInsert P1 P2 * * *
+ * Synopsis: hash[P1]+=r[P2]
+ *
+ * Insert the row stored in register P2, which was built by
+ * OP_MakeRecord, in the hash table of cursor P1.
+ */
+case OP_HashJoinInsert: {
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_HASH_JOIN);
+	pIn2 = &aMem[pOp->p2];
+	assert(mem_is_bin(pIn2));
+	if (sql_hash_join_insert(cur->uc.hash_join, pIn2->z,
+				 pIn2->z + pIn2->n) != 0)
+		goto abort_due_to_error;
+	break;
+}
+
+/* Opcode: HashJoinSeek P1 P2 P3 P4 *
+ * Synopsis: key=r[P3@P4]
+ *
+ * Position cursor P1 at the first row of its hash table whose key
+ * is equal to the P4 values stored in registers starting from P3.
+ * If there's no such row, jump to P2.
+ */
+case OP_HashJoinSeek: {       /* jump, in3 */
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_HASH_JOIN);
+	struct sql_hash_join *join = cur->uc.hash_join;
+	uint32_t len = pOp->p4.i;
+	assert(pOp->p4type == P4_INT32);
+	struct Mem *mems = &aMem[pOp->p3];
+	cur->nullRow = 1;
+	cur->cacheStatus = CACHE_STALE;
+	for (uint32_t i = 0; i < len; ++i) {
+		enum field_type type = sql_hash_join_field_type(join, i);
+		struct Mem *mem = &mems[i];
+		if (mem_is_field_compatible(mem, type))
+			continue;
+		if (!sql_type_is_numeric(type) || !mem_is_num(mem)) {
+			diag_set(ClientError, ER_SQL_TYPE_MISMATCH,
+				 mem_str(mem), field_type_strs[type]);
+			goto abort_due_to_error;
+		}
+		/*
+		 * Nothing is equal to the value if it can't be
+		 * converted to the key type precisely.
+		 */
+		if (mem_cast_implicit_number(mem, type) != 0) {
+			VdbeBranchTaken(1, 2);
+			goto jump_to_p2;
+		}
+	}
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	uint32_t size;
+	const char *key = mem_encode_array(mems, len, &size, region);
+	if (key == NULL)
+		goto abort_due_to_error;
+	bool found;
+	rc = sql_hash_join_seek(join, key, &found);
+	region_truncate(region, used);
+	if (rc != 0)
+		goto abort_due_to_error;
+	VdbeBranchTaken(!found, 2);
+	if (!found)
+		goto jump_to_p2;
+	cur->nullRow = 0;
+	break;
+}
+
+/* Opcode: HashJoinNext P1 P2 * * *
+ *
+ * Advance cursor P1 to the next row of its hash table with the key
+ * passed to the last OP_HashJoinSeek and jump to P2. If there are
+ * no more such rows, fall through to the next instruction.
+ */
+case OP_HashJoinNext: {       /* jump */
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_HASH_JOIN);
+	/* The cursor is moved to a null row by LEFT JOIN. */
+	if (cur->nullRow)
+		break;
+	bool found;
+	if (sql_hash_join_next(cur->uc.hash_join, &found) != 0)
+		goto abort_due_to_error;
+	cur->cacheStatus = CACHE_STALE;
+	VdbeBranchTaken(found, 2);
+	if (!found) {
+		cur->nullRow = 1;
+		break;
+	}
+	goto jump_to_p2;
+}
+
+/* Opcode: HashAggOpen P1 P2 P3 P4 *
+ * Synopsis: state=P2 registers
+ *
+ * Open a new cursor P1 on an empty hash table used to compute
+ * aggregates with GROUP BY. P4 describes the group key, the state
+ * of a group consists of P2 registers. Space for P3 groups is
+ * reserved in advance.
+ *
+ * Once the table grows larger than box.cfg.sql_hash_agg_memory,
+ * no new groups are added to it, see OP_HashAggInsert.
+ */
+case OP_HashAggOpen: {
+	assert(pOp->p1 >= 0);
+	assert(pOp->p2 >= 0);
+	assert(pOp->p4type == P4_KEYINFO);
+	struct sql_key_info *key_info = pOp->p4.key_info;
+	struct VdbeCursor *cur = allocateCursor(p, pOp->p1,
+						key_info->part_count,
+						CURTYPE_HASH_AGG);
+	if (cur == NULL)
+		goto no_mem;
+	cur->uc.hash_agg = sql_hash_agg_new(key_info->parts,
+					    key_info->part_count, pOp->p2,
+					    pOp->p3, sql_hash_agg_memory);
+	if (cur->uc.hash_agg == NULL)
+		goto abort_due_to_error;
+	break;
+}
+
+/* Opcode: HashAggFind P1 P2 P3 * *
+ * Synopsis: key=r[P3..]
+ *
+ * Position cursor P1 at the group of its hash table whose key is
+ * equal to the values stored in registers starting from P3 and
+ * jump to P2. If there's no such group, fall through to the next
+ * instruction.
+ */
+case OP_HashAggFind: {       /* jump */
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_HASH_AGG);
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	uint32_t size;
+	const char *key = mem_encode_array(&aMem[pOp->p3], cur->nField,
+					   &size, region);
+	if (key == NULL)
+		goto abort_due_to_error;
+	bool found;
+	sql_hash_agg_find(cur->uc.hash_agg, key, &found);
+	region_truncate(region, used);
+	VdbeBranchTaken(found, 2);
+	if (found)
+		goto jump_to_p2;
+	break;
+}
+
+/* Opcode: HashAggInsert P1 P2 P3 * *
+ * Synopsis: key=r[P3..]
+ *
+ * Add a group with the key stored in registers starting from P3
+ * to the hash table of cursor P1 and position the cursor at it.
+ * The group must not be in the table. If the table has exceeded
+ * its memory limit, jump to P2 without adding the group.
+ */
+case OP_HashAggInsert: {       /* jump */
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_HASH_AGG);
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	uint32_t size;
+	const char *key = mem_encode_array(&aMem[pOp->p3], cur->nField,
+					   &size, region);
+	if (key == NULL)
+		goto abort_due_to_error;
+	bool inserted;
+	rc = sql_hash_agg_insert(cur->uc.hash_agg, key, key + size,
+				 &inserted);
+	region_truncate(region, used);
+	if (rc != 0)
+		goto abort_due_to_error;
+	VdbeBranchTaken(!inserted, 2);
+	if (!inserted)
+		goto jump_to_p2;
+	break;
+}
+
+/* Opcode: HashAggLoad P1 P2 * * *
+ * Synopsis: r[P2..]=state
+ *
+ * Move the state of the group cursor P1 is positioned at to
+ * registers starting from P2.
+ */
+case OP_HashAggLoad: {
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_HASH_AGG);
+	sql_hash_agg_load(cur->uc.hash_agg, &aMem[pOp->p2]);
+	break;
+}
+
+/* Opcode: HashAggStore P1 P2 * * *
+ * Synopsis: state=r[P2..]
+ *
+ * Move registers starting from P2 to the state of the group
+ * cursor P1 is positioned at.
+ */
+case OP_HashAggStore: {
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_HASH_AGG);
+	if (sql_hash_agg_store(cur->uc.hash_agg, &aMem[pOp->p2]) != 0)
+		goto abort_due_to_error;
+	break;
+}
+
+/* Opcode: HashAggSort P1 P2 * * *
+ *
+ * Sort the groups of the hash table of cursor P1 by key and
+ * position the cursor at the first one. If the table is empty,
+ * jump to P2.
+ */
+case OP_HashAggSort: {       /* jump */
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_HASH_AGG);
+	bool found = sql_hash_agg_sort(cur->uc.hash_agg);
+	VdbeBranchTaken(!found, 2);
+	if (!found)
+		goto jump_to_p2;
+	break;
+}
+
+/* Opcode: HashAggNext P1 P2 * * *
+ *
+ * Advance cursor P1 to the next group of its hash table in the
+ * order set by OP_HashAggSort and jump to P2. If there are no
+ * more groups, fall through to the next instruction.
+ */
+case OP_HashAggNext: {       /* jump */
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_HASH_AGG);
+	bool found = sql_hash_agg_next(cur->uc.hash_agg);
+	VdbeBranchTaken(found, 2);
+	if (found)
+		goto jump_to_p2;
+	break;
+}
+
+/* Opcode: HashAggKey P1 P2 * * *
+ * Synopsis: r[P2..]=key
+ *
+ * Store the key of the group cursor P1 is positioned at in
+ * registers starting from P2.
+ */
+case OP_HashAggKey: {
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_HASH_AGG);
+	const char *key = sql_hash_agg_key(cur->uc.hash_agg);
+	uint32_t len = mp_decode_array(&key);
+	assert(len == (uint32_t)cur->nField);
+	for (uint32_t i = 0; i < len; i++) {
+		uint32_t size;
+		if (mem_from_mp(&aMem[pOp->p2 + i], key, &size) != 0)
+			goto abort_due_to_error;
+		key += size;
+	}
+	break;
+}
+
+/* Opcode: ReadViewOpen P1 P2 P3 P4 *
+ * Synopsis: space id = P2, filter values = r[P3..]
+ *
+ * Open a read view of space P2 and a new cursor P1 on a scan of
+ * it described by P4. The values the filters of the scan compare
+ * fields with are stored in registers starting from P3. The scan
+ * is run by the worker threads, see read_view_scan.h.
+ */
+case OP_ReadViewOpen: {
+	assert(pOp->p1 >= 0);
+	assert(pOp->p4type == P4_READ_VIEW_SCAN);
+	if (box_schema_version() != p->schema_ver) {
+		p->expired = 1;
+		diag_set(ClientError, ER_SQL_EXECUTE, "schema version has "\
+			 "changed: need to re-compile SQL statement");
+		goto abort_due_to_error;
+	}
+	struct space *space = space_by_id(pOp->p2);
+	assert(space != NULL);
+	if (access_check_space(space, PRIV_R) != 0)
+		goto abort_due_to_error;
+	struct read_view_scan_def def = *pOp->p4.read_view_scan_def;
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	if (def.filter_count > 0) {
+		size_t size;
+		struct read_view_scan_filter *filters =
+			region_alloc_array(region, typeof(*filters),
+					   def.filter_count, &size);
+		if (filters == NULL) {
+			diag_set(OutOfMemory, size, "region_alloc_array",
+				 "filters");
+			goto abort_due_to_error;
+		}
+		uint32_t values_size;
+		const char *values = mem_encode_array(&aMem[pOp->p3],
+						      def.filter_count,
+						      &values_size, region);
+		if (values == NULL) {
+			region_truncate(region, used);
+			goto abort_due_to_error;
+		}
+		mp_decode_array(&values);
+		for (uint32_t i = 0; i < def.filter_count; i++) {
+			filters[i] = def.filters[i];
+			filters[i].value = values;
+			mp_next(&values);
+		}
+		def.filters = filters;
+	}
+	struct VdbeCursor *cur = allocateCursor(p, pOp->p1,
+						def.field_count +
+						def.aggregate_count,
+						CURTYPE_READ_VIEW);
+	if (cur == NULL) {
+		region_truncate(region, used);
+		goto no_mem;
+	}
+	cur->uc.read_view_scan = read_view_scan_new(space, &def);
+	region_truncate(region, used);
+	if (cur->uc.read_view_scan == NULL)
+		goto abort_due_to_error;
+	break;
+}
+
+/* Opcode: ReadViewNext P1 P2 P3 * *
+ * Synopsis: r[P3..]=row
+ *
+ * Store the next row of the read view scan of cursor P1 in
+ * registers starting from P3. If there are no more rows, jump
+ * to P2. Yields while a worker thread scans the read view.
+ */
+case OP_ReadViewNext: {       /* jump */
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_READ_VIEW);
+	const char *row;
+	if (read_view_scan_next(cur->uc.read_view_scan, &row) != 0)
+		goto abort_due_to_error;
+	VdbeBranchTaken(row == NULL, 2);
+	if (row == NULL)
+		goto jump_to_p2;
+	uint32_t count = mp_decode_array(&row);
+	assert(count == (uint32_t)cur->nField);
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t size;
+		if (mem_from_mp(&aMem[pOp->p3 + i], row, &size) != 0)
+			goto abort_due_to_error;
+		row += size;
+	}
+	break;
+}
+
+/* Opcode: BatchOpen P1 P2 * P4 *
+ * Synopsis: space id = P2
+ *
+ * Open a new cursor P1 on a batched scan of the primary index of
+ * space P2 described by P4, see batch_scan.h.
+ */
+case OP_BatchOpen: {
+	assert(pOp->p1 >= 0);
+	assert(pOp->p4type == P4_BATCH_SCAN);
+	if (box_schema_version() != p->schema_ver) {
+		p->expired = 1;
+		diag_set(ClientError, ER_SQL_EXECUTE, "schema version has "\
+			 "changed: need to re-compile SQL statement");
+		goto abort_due_to_error;
+	}
+	struct space *space = space_by_id(pOp->p2);
+	assert(space != NULL);
+	if (access_check_space(space, PRIV_R) != 0)
+		goto abort_due_to_error;
+	struct VdbeCursor *cur = allocateCursor(p, pOp->p1, 0,
+						CURTYPE_BATCH_SCAN);
+	if (cur == NULL)
+		goto no_mem;
+	cur->uc.batch_scan = sql_batch_scan_new(space,
+						pOp->p4.batch_scan_def);
+	if (cur->uc.batch_scan == NULL)
+		goto abort_due_to_error;
+	break;
+}
+
+/* Opcode: BatchNext P1 P2 P3 * *
+ * Synopsis: filter values = r[P3..]
+ *
+ * Fetch the next batch of tuples of the batched scan of cursor P1
+ * and update the aggregate accumulators of the scan with those of
+ * them that satisfy its filters. The values the filters compare
+ * fields with are stored in registers starting from P3. If there
+ * are no more tuples, jump to P2.
+ */
+case OP_BatchNext: {       /* jump */
+	struct VdbeCursor *cur = p->apCsr[pOp->p1];
+	assert(cur != NULL && cur->eCurType == CURTYPE_BATCH_SCAN);
+	bool is_eof;
+	if (sql_batch_scan_next(cur->uc.batch_scan, &aMem[pOp->p3], aMem,
+				&is_eof) != 0)
+		goto abort_due_to_error;
+	VdbeBranchTaken(is_eof, 2);
+	if (is_eof)
+		goto jump_to_p2;
+	break;
+}
+
 /* Opcode: Close P1 * * * *
  *
  * Close a cursor previously opened as P1.  If P1 is not
@@ -99,6 +99,10 @@ struct VdbeOp {
 		struct sql_space_info *space_info;
 		/** P4 contains address of decimal. */
 		decimal_t *dec;
+		/** Definition of a read view scan, see OP_ReadViewOpen. */
+		struct read_view_scan_def *read_view_scan_def;
+		/** Definition of a batched scan, see OP_BatchOpen. */
+		struct sql_batch_scan_def *batch_scan_def;
 	} p4;
 #ifdef SQL_ENABLE_EXPLAIN_COMMENTS
 	char *zComment;		/* Comment to improve readability */
@@ -150,6 +154,10 @@ struct SubProgram {
 #define P4_PTR      (-18)	/* P4 is a generic pointer */
 #define P4_KEYINFO  (-19)       /* P4 is a pointer to sql_key_info structure. */
 #define P4_SPACEPTR (-20)       /* P4 is a space pointer */
+/** P4 is a pointer to a read_view_scan_def allocated with sqlMalloc(). */
+#define P4_READ_VIEW_SCAN (-21)
+/** P4 is a pointer to a sql_batch_scan_def allocated with sqlMalloc(). */
+#define P4_BATCH_SCAN (-22)
 
 /* Error message codes for OP_Halt */
 #define P5_ConstraintNotNull 1
@@ -60,6 +60,10 @@ typedef struct VdbeSorter VdbeSorter;
 #define CURTYPE_TARANTOOL   0
 #define CURTYPE_SORTER      1
 #define CURTYPE_PSEUDO      2
+#define CURTYPE_HASH_JOIN   3
+#define CURTYPE_HASH_AGG    4
+#define CURTYPE_READ_VIEW   5
+#define CURTYPE_BATCH_SCAN  6
 
 /*
  * A VdbeCursor is an superclass (a wrapper) for various cursor objects:
@@ -68,6 +72,10 @@ typedef struct VdbeSorter VdbeSorter;
  *          -  On either an ephemeral or ordinary space
  *      * A sorter
  *      * A one-row "pseudotable" stored in a single register
+ *      * A hash table built for a hash join
+ *      * A hash table of GROUP BY groups
+ *      * A scan of a read view of a space
+ *      * A batched scan of a space
  */
 typedef struct VdbeCursor VdbeCursor;
 struct VdbeCursor {
@@ -99,6 +107,14 @@ struct VdbeCursor {
 		BtCursor *pCursor;	/* CURTYPE_TARANTOOL */
 		int pseudoTableReg;	/* CURTYPE_PSEUDO. Reg holding content. */
 		VdbeSorter *pSorter;	/* CURTYPE_SORTER. Sorter object */
+		/** CURTYPE_HASH_JOIN. Hash table. */
+		struct sql_hash_join *hash_join;
+		/** CURTYPE_HASH_AGG. Hash table. */
+		struct sql_hash_agg *hash_agg;
+		/** CURTYPE_READ_VIEW. Read view scan. */
+		struct read_view_scan *read_view_scan;
+		/** CURTYPE_BATCH_SCAN. Batched scan. */
+		struct sql_batch_scan *batch_scan;
 	} uc;
 	/** Info about keys needed by index cursors. */
 	struct key_def *key_def;
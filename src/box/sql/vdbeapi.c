@@ -650,6 +650,18 @@ sql_stmt_busy(const struct sql_stmt *stmt)
 	return v->magic == VDBE_MAGIC_RUN && v->pc >= 0;
 }
 
+bool
+sql_stmt_uses_read_view(const struct sql_stmt *stmt)
+{
+	assert(stmt != NULL);
+	const struct Vdbe *v = (const struct Vdbe *) stmt;
+	for (int i = 0; i < v->nOp; i++) {
+		if (v->aOp[i].opcode == OP_ReadViewOpen)
+			return true;
+	}
+	return false;
+}
+
 /*
  * Return a pointer to the next prepared statement after pStmt associated
  * with database connection pDb.  If pStmt is NULL, return the first
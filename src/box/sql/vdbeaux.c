@@ -37,6 +37,7 @@
 #include "coll/coll.h"
 #include "box/session.h"
 #include "box/schema.h"
+#include "box/read_view_scan.h"
 #include "box/tuple_format.h"
 #include "box/txn.h"
 #include "msgpuck/msgpuck.h"
@@ -44,6 +45,9 @@
 #include "mem.h"
 #include "vdbeInt.h"
 #include "tarantoolInt.h"
+#include "batch_scan.h"
+#include "hash_agg.h"
+#include "hash_join.h"
 #include "box/execute.h"
 
 /*
@@ -597,7 +601,9 @@ freeP4(sql * db, int p4type, void *p4)
 	case P4_INT64:
 	case P4_UINT64:
 	case P4_DYNAMIC:
-	case P4_INTARRAY:{
+	case P4_INTARRAY:
+	case P4_READ_VIEW_SCAN:
+	case P4_BATCH_SCAN:{
 			sqlDbFree(db, p4);
 			break;
 		}
@@ -1115,6 +1121,20 @@ displayP4(Op * pOp, char *zTemp, int nTemp)
 		sqlXPrintf(&x, "space<name=%s>", space_name(pOp->p4.space));
 		break;
 	}
+	case P4_READ_VIEW_SCAN: {
+		struct read_view_scan_def *def = pOp->p4.read_view_scan_def;
+		sqlXPrintf(&x, "scan<filters=%u,fields=%u,aggregates=%u>",
+			   def->filter_count, def->field_count,
+			   def->aggregate_count);
+		break;
+	}
+	case P4_BATCH_SCAN: {
+		struct sql_batch_scan_def *def = pOp->p4.batch_scan_def;
+		sqlXPrintf(&x, "batch<fields=%u,filters=%u,aggregates=%u>",
+			   def->field_count, def->filter_count,
+			   def->agg_count);
+		break;
+	}
 	default:{
 			zP4 = pOp->p4.z;
 			if (zP4 == 0) {
@@ -1587,6 +1607,22 @@ sqlVdbeFreeCursor(Vdbe * p, VdbeCursor * pCx)
 		sql_cursor_close(pCx->uc.pCursor);
 			break;
 		}
+	case CURTYPE_HASH_JOIN:
+		if (pCx->uc.hash_join != NULL)
+			sql_hash_join_delete(pCx->uc.hash_join);
+		break;
+	case CURTYPE_HASH_AGG:
+		if (pCx->uc.hash_agg != NULL)
+			sql_hash_agg_delete(pCx->uc.hash_agg);
+		break;
+	case CURTYPE_READ_VIEW:
+		if (pCx->uc.read_view_scan != NULL)
+			read_view_scan_delete(pCx->uc.read_view_scan);
+		break;
+	case CURTYPE_BATCH_SCAN:
+		if (pCx->uc.batch_scan != NULL)
+			sql_batch_scan_delete(pCx->uc.batch_scan);
+		break;
 	}
 }
 
@@ -43,6 +43,7 @@
 #include "mem.h"
 #include "vdbeInt.h"
 #include "whereInt.h"
+#include "hash_join.h"
 #include "box/coll_id_cache.h"
 #include "box/schema.h"
 
@@ -711,6 +712,39 @@ termCanDriveIndex(WhereTerm * pTerm,	/* WHERE clause term to check */
 	return 1;
 }
 
+/**
+ * Return true if the WHERE clause term, which can drive an
+ * automatic index, can also be used as a hash join key.
+ */
+static bool
+termCanDriveHashJoin(struct WhereTerm *term, struct SrcList_item *src)
+{
+	enum field_type type =
+		src->space->def->fields[term->u.leftColumn].type;
+	return sql_hash_join_key_type_is_supported(type);
+}
+
+/**
+ * Return true if a hash table built over all tuples of the given
+ * space is expected to fit in the hash join memory limit. If the
+ * size of the space is unknown, assume that it fits: the hash
+ * table falls back on an ephemeral index anyway if it doesn't.
+ */
+static bool
+where_hash_join_fits(struct space *space)
+{
+	if (sql_hash_join_memory == 0)
+		return false;
+	if (space->def->opts.is_view || space->index_map == NULL)
+		return true;
+	struct index *pk = space_index(space, 0);
+	if (pk == NULL)
+		return true;
+	size_t size = space_bsize(space) +
+		      index_size(pk) * SQL_HASH_JOIN_ROW_OVERHEAD;
+	return size <= sql_hash_join_memory;
+}
+
 /**
  * Generate a code that will create a tuple, which is supposed to be inserted
  * in the ephemeral index space. The created tuple consists of rowid and
@@ -720,12 +754,14 @@ termCanDriveIndex(WhereTerm * pTerm,	/* WHERE clause term to check */
  * @param key_def The index key description.
  * @param cursor Cursor of source space from which values for tuple are fetched.
  * @param reg_out Register to contain the created tuple.
- * @param reg_eph Register holding pointer to ephemeral index.
+ * @param reg_eph Register holding pointer to ephemeral index or 0 if
+ *        the tuple is inserted in a hash table.
+ * @param hash_cursor Cursor of the hash table, used if @a reg_eph is 0.
  */
 static void
 vdbe_emit_ephemeral_index_tuple(struct Parse *parse,
 				const struct key_def *key_def, int cursor,
-				int reg_out, int reg_eph)
+				int reg_out, int reg_eph, int hash_cursor)
 {
 	assert(reg_out != 0);
 	struct Vdbe *v = parse->pVdbe;
@@ -735,7 +771,13 @@ vdbe_emit_ephemeral_index_tuple(struct Parse *parse,
 		uint32_t tabl_col = key_def->parts[j].fieldno;
 		sqlVdbeAddOp3(v, OP_Column, cursor, tabl_col, reg_base + j);
 	}
-	sqlVdbeAddOp2(v, OP_NextIdEphemeral, reg_eph, reg_base + col_cnt);
+	if (reg_eph != 0) {
+		sqlVdbeAddOp2(v, OP_NextIdEphemeral, reg_eph,
+			      reg_base + col_cnt);
+	} else {
+		sqlVdbeAddOp2(v, OP_Sequence, hash_cursor,
+			      reg_base + col_cnt);
+	}
 	sqlVdbeAddOp3(v, OP_MakeRecord, reg_base, col_cnt + 1, reg_out);
 	sqlReleaseTempRange(parse, reg_base, col_cnt + 1);
 }
@@ -747,6 +789,9 @@ vdbe_emit_ephemeral_index_tuple(struct Parse *parse,
  * an "ephemeral index". The PK definition of ephemeral index contains all of
  * its fields. Also, this functions set up the WhereLevel object pLevel so
  * that the code generator makes use of ephemeral index.
+ *
+ * If the loop is a hash join, the same rows are inserted in a hash table
+ * keyed by the fields that match the WHERE clause terms instead.
  */
 static void
 constructAutomaticIndex(Parse * pParse,			/* The parsing context */
@@ -783,9 +828,11 @@ constructAutomaticIndex(Parse * pParse,			/* The parsing context */
 	nKeyCol = 0;
 	pWCEnd = &pWC->a[pWC->nTerm];
 	pLoop = pLevel->pWLoop;
+	bool is_hash_join = (pLoop->wsFlags & WHERE_HASH_JOIN) != 0;
 	idxCols = 0;
 	for (pTerm = pWC->a; pTerm < pWCEnd; pTerm++) {
-		if (termCanDriveIndex(pTerm, pSrc, notReady)) {
+		if (termCanDriveIndex(pTerm, pSrc, notReady) &&
+		    (!is_hash_join || termCanDriveHashJoin(pTerm, pSrc))) {
 			int iCol = pTerm->u.leftColumn;
 			Bitmask cMask =
 			    iCol >= BMS ? MASKBIT(BMS - 1) : MASKBIT(iCol);
@@ -804,6 +851,8 @@ constructAutomaticIndex(Parse * pParse,			/* The parsing context */
 	pLoop->nEq = pLoop->nLTerm = nKeyCol;
 	pLoop->wsFlags = WHERE_COLUMN_EQ | WHERE_IDX_ONLY | WHERE_INDEXED
 	    | WHERE_AUTO_INDEX;
+	if (is_hash_join)
+		pLoop->wsFlags |= WHERE_HASH_JOIN;
 
 	/* Count the number of additional columns needed to create a
 	 * covering index.  A "covering index" is an index that contains all
@@ -836,7 +885,8 @@ constructAutomaticIndex(Parse * pParse,			/* The parsing context */
 		return;
 	}
 	for (pTerm = pWC->a; pTerm < pWCEnd; pTerm++) {
-		if (termCanDriveIndex(pTerm, pSrc, notReady)) {
+		if (termCanDriveIndex(pTerm, pSrc, notReady) &&
+		    (!is_hash_join || termCanDriveHashJoin(pTerm, pSrc))) {
 			int iCol = pTerm->u.leftColumn;
 			Bitmask cMask =
 			    iCol >= BMS ? MASKBIT(BMS - 1) : MASKBIT(iCol);
@@ -925,10 +975,17 @@ constructAutomaticIndex(Parse * pParse,			/* The parsing context */
 		pParse->is_aborted = true;
 		return;
 	}
-	int reg_eph = sqlGetTempReg(pParse);
-	sqlVdbeAddOp4(v, OP_OpenTEphemeral, reg_eph, 0, 0, (char *)info,
-		      P4_DYNAMIC);
-	sqlVdbeAddOp3(v, OP_IteratorOpen, pLevel->iIdxCur, 0, reg_eph);
+	int reg_eph = 0;
+	if (is_hash_join) {
+		sqlVdbeAddOp4(v, OP_HashJoinOpen, pLevel->iIdxCur,
+			      pLoop->nEq, 0, (char *)info, P4_DYNAMIC);
+	} else {
+		reg_eph = sqlGetTempReg(pParse);
+		sqlVdbeAddOp4(v, OP_OpenTEphemeral, reg_eph, 0, 0,
+			      (char *)info, P4_DYNAMIC);
+		sqlVdbeAddOp3(v, OP_IteratorOpen, pLevel->iIdxCur, 0,
+			      reg_eph);
+	}
 	VdbeComment((v, "for %s", space->def->name));
 
 	/* Fill the automatic index with content */
@@ -939,14 +996,20 @@ constructAutomaticIndex(Parse * pParse,			/* The parsing context */
 	VdbeCoverage(v);
 	regRecord = sqlGetTempReg(pParse);
 	vdbe_emit_ephemeral_index_tuple(pParse, idx_def->key_def, cursor,
-					regRecord, reg_eph);
-	sqlVdbeAddOp2(v, OP_IdxInsert, regRecord, reg_eph);
+					regRecord, reg_eph, pLevel->iIdxCur);
+	if (is_hash_join) {
+		sqlVdbeAddOp2(v, OP_HashJoinInsert, pLevel->iIdxCur,
+			      regRecord);
+	} else {
+		sqlVdbeAddOp2(v, OP_IdxInsert, regRecord, reg_eph);
+	}
 	sqlVdbeAddOp2(v, OP_Next, cursor, addrTop + 1);
 	VdbeCoverage(v);
 	sqlVdbeChangeP5(v, SQL_STMTSTATUS_AUTOINDEX);
 	sqlVdbeJumpHere(v, addrTop);
 	sqlReleaseTempReg(pParse, regRecord);
-	sqlReleaseTempReg(pParse, reg_eph);
+	if (reg_eph != 0)
+		sqlReleaseTempReg(pParse, reg_eph);
 	sqlExprCachePop(pParse);
 
 	/* Jump here when skipping the initialization */
@@ -1563,13 +1626,11 @@ whereRangeScanEst(Parse * pParse,	/* Parsing & code generating context */
  * "x IS NULL" instead of "x=VALUE".
  *
  * Write the estimated row count into *pnRow and return 0.
- * If unable to make an estimate, leave *pnRow unchanged and return
- * non-zero.
+ * If unable to make an estimate, because the value isn't a literal,
+ * leave *pnRow unchanged and return 0.
  *
- * This routine can fail if it is unable to load a collating sequence
- * required for string comparison, or if unable to allocate memory
- * for a UTF conversion required for comparison.  The error is stored
- * in the pParse structure.
+ * This routine can fail if it is unable to allocate memory for
+ * the value. The error is stored in the pParse structure.
  */
 static int
 whereEqualScanEst(Parse * pParse,	/* Parsing & code generating context */
@@ -1585,14 +1646,15 @@ whereEqualScanEst(Parse * pParse,	/* Parsing & code generating context */
 
 	assert(nEq >= 1);
 	assert(nEq <= (int) p->key_def->part_count);
-	assert(pBuilder->nRecValid == (nEq - 1));
+	/* Values of the previous parts couldn't be extracted. */
+	if (pBuilder->nRecValid < nEq - 1)
+		return 0;
 
 	rc = sqlStat4ProbeSetValue(pParse, p, &pRec, pExpr, 1, nEq - 1,
 				       &bOk);
 	pBuilder->pRec = pRec;
-	if (rc != 0)
+	if (rc != 0 || bOk == 0)
 		return rc;
-	assert(bOk != 0);
 	pBuilder->nRecValid = nEq;
 
 	whereKeyStats(pParse, p, pRec, 0, a);
@@ -2887,6 +2949,7 @@ tnt_error:
 		/* Generate auto-index WhereLoops */
 		WhereTerm *pTerm;
 		WhereTerm *pWCEnd = pWC->a + pWC->nTerm;
+		bool hash_join_fits = where_hash_join_fits(space);
 		for (pTerm = pWC->a; rc == 0 && pTerm < pWCEnd; pTerm++) {
 			if (pTerm->prereqRight & pNew->maskSelf)
 				continue;
@@ -2896,12 +2959,6 @@ tnt_error:
 				pNew->index_def = NULL;
 				pNew->nLTerm = 1;
 				pNew->aLTerm[0] = pTerm;
-				/*
-				 * TODO: At the moment we have decided to use
-				 * this formula, but it is quite aggressive and
-				 * needs tuning.
-				 */
-				pNew->rSetup = rLogSize + rSize;
 				/* TUNING: Each index lookup yields 20 rows in the table.  This
 				 * is more than the usual guess of 10 rows, since we have no way
 				 * of knowing how selective the index will ultimately be.  It would
@@ -2909,10 +2966,33 @@ tnt_error:
 				 */
 				pNew->nOut = 43;
 				assert(43 == sqlLogEst(20));
-				pNew->rRun =
-				    sqlLogEstAdd(rLogSize, pNew->nOut);
-				pNew->wsFlags = WHERE_AUTO_INDEX;
 				pNew->prereq = mPrereq | pTerm->prereqRight;
+				/*
+				 * TODO: At the moment we have decided to use
+				 * this formula, but it is quite aggressive and
+				 * needs tuning.
+				 */
+				pNew->rSetup = rLogSize + rSize;
+				if (hash_join_fits &&
+				    termCanDriveHashJoin(pTerm, pSrc)) {
+					/*
+					 * A hash table is looked up in
+					 * constant time. The setup cost is
+					 * left the same as for an ephemeral
+					 * index, because the hash table
+					 * turns into one if it runs out of
+					 * memory, and because compatible
+					 * loops must have the same setup
+					 * cost, see whereLoopFindLesser().
+					 */
+					pNew->rRun = pNew->nOut;
+					pNew->wsFlags = WHERE_AUTO_INDEX |
+							WHERE_HASH_JOIN;
+				} else {
+					pNew->rRun =
+					    sqlLogEstAdd(rLogSize, pNew->nOut);
+					pNew->wsFlags = WHERE_AUTO_INDEX;
+				}
 				rc = whereLoopInsert(pBuilder, pNew);
 			}
 		}
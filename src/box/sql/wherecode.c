@@ -219,7 +219,9 @@ sqlWhereExplainOneScan(Parse * pParse,	/* Parse context */
 
 			assert(!(flags & WHERE_AUTO_INDEX)
 			       || (flags & WHERE_IDX_ONLY));
-			if ((flags & WHERE_AUTO_INDEX) != 0) {
+			if ((flags & WHERE_HASH_JOIN) != 0) {
+				zFmt = "HASH JOIN";
+			} else if ((flags & WHERE_AUTO_INDEX) != 0) {
 				zFmt = "EPHEMERAL INDEX";
 			} else if (idx_def->iid == 0) {
 				if (isSearch) {
@@ -951,6 +953,17 @@ sqlWhereCodeOneLoopStart(WhereInfo * pWInfo,	/* Complete information about the W
 			 * above has already left the cursor sitting on the correct row,
 			 * so no further seeking is needed
 			 */
+		} else if ((pLoop->wsFlags & WHERE_HASH_JOIN) != 0) {
+			/*
+			 * A hash table can only be looked up by the
+			 * whole key, and the rows it returns match
+			 * the key, so there's no end of range check.
+			 */
+			assert(pRangeStart == NULL && pRangeEnd == NULL);
+			assert(nConstraint == nEq && !bRev);
+			sqlVdbeAddOp4Int(v, OP_HashJoinSeek, iIdxCur, addrNxt,
+					 regBase, nEq);
+			VdbeCoverage(v);
 		} else {
 			op = aStartOp[(start_constraints << 2) +
 				      (startEq << 1) + bRev];
@@ -1004,7 +1017,7 @@ sqlWhereCodeOneLoopStart(WhereInfo * pWInfo,	/* Complete information about the W
 		pLevel->p2 = sqlVdbeCurrentAddr(v);
 
 		/* Check if the index cursor is past the end of the range. */
-		if (nConstraint) {
+		if (nConstraint && (pLoop->wsFlags & WHERE_HASH_JOIN) == 0) {
 			op = aEndOp[bRev * 2 + endEq];
 			sqlVdbeAddOp4Int(v, op, iIdxCur, addrNxt, regBase,
 					     nConstraint);
@@ -1039,6 +1052,8 @@ sqlWhereCodeOneLoopStart(WhereInfo * pWInfo,	/* Complete information about the W
 		/* Record the instruction used to terminate the loop. */
 		if (pLoop->wsFlags & WHERE_ONEROW) {
 			pLevel->op = OP_Noop;
+		} else if ((pLoop->wsFlags & WHERE_HASH_JOIN) != 0) {
+			pLevel->op = OP_HashJoinNext;
 		} else if (bRev) {
 			pLevel->op = OP_Prev;
 		} else {
@@ -0,0 +1,766 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "sql_stat.h"
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "coio_task.h"
+#include "diag.h"
+#include "errcode.h"
+#include "fiber.h"
+#include "index.h"
+#include "index_def.h"
+#include "key_def.h"
+#include "mpstream/mpstream.h"
+#include "msgpuck.h"
+#include "schema.h"
+#include "small/region.h"
+#include "space.h"
+#include "sql/sqlInt.h"
+#include "trivia/util.h"
+#include "tuple.h"
+#include "tuple_compare.h"
+#include "txn.h"
+
+enum {
+	/** Max number of regular histogram samples of an index. */
+	SQL_STAT_SAMPLE_COUNT_MAX = 24,
+	/** Max number of keys read by the collector at once. */
+	SQL_STAT_BATCH_SIZE = 16 * 1024,
+};
+
+double sql_stat_refresh_ratio = 0;
+
+/** A histogram sample being collected. */
+struct sql_stat_sample {
+	/** Key, a MessagePack array of the index key parts. */
+	char *key;
+	/** Size of the key. */
+	uint32_t key_size;
+	/**
+	 * Number of keys equal to the sample in the first 1, 2, ...
+	 * parts, or 0 while the collector hasn't read them all.
+	 */
+	uint64_t *eq;
+	/** Number of keys less than the sample in the first parts. */
+	uint64_t *lt;
+	/** Number of distinct keys less than the sample in them. */
+	uint64_t *dlt;
+};
+
+struct sql_stat_collector {
+	/** Iterator over the read view of the index. */
+	struct snapshot_iterator *iterator;
+	/** Copy of the index key definition. */
+	struct key_def *key_def;
+	/** Number of keys between two regular samples. */
+	uint64_t sample_step;
+	/** Number of keys read so far. */
+	uint64_t row_count;
+	/** The last key read. */
+	char *last_key;
+	/** Size of the memory allocated for the last key. */
+	uint32_t last_key_capacity;
+	/** Number of distinct values of the first 1, 2, ... parts. */
+	uint64_t *ndv;
+	/**
+	 * Number of the first key that has the same first 1, 2, ...
+	 * parts as the last one.
+	 */
+	uint64_t *run_start;
+	/** Regular samples plus one for NULL. */
+	struct sql_stat_sample samples[SQL_STAT_SAMPLE_COUNT_MAX + 1];
+	/** Number of samples taken so far. */
+	uint32_t sample_count;
+	/** Set if all keys have been read. */
+	bool is_eof;
+};
+
+/**
+ * Return a description of an index the statistics can't be
+ * collected for, or NULL if they can.
+ */
+static const char *
+sql_stat_unsupported(struct space *space, struct index *index)
+{
+	if (index->def->type != TREE)
+		return index_type_strs[index->def->type];
+	if (index->def->key_def->is_multikey)
+		return "multikey index";
+	if (index->def->key_def->for_func_index)
+		return "functional index";
+	if (space_is_vinyl(space) && index->def->iid != 0)
+		return "vinyl secondary index";
+	if (!space_is_memtx(space) && !space_is_vinyl(space))
+		return space->engine->name;
+	return NULL;
+}
+
+static int
+sql_stat_check_index(struct space *space, struct index *index)
+{
+	const char *what = sql_stat_unsupported(space, index);
+	if (what != NULL) {
+		diag_set(ClientError, ER_UNSUPPORTED, what, "SQL statistics");
+		return -1;
+	}
+	return 0;
+}
+
+static int
+sql_stat_collector_create(struct sql_stat_collector *c, struct index *index)
+{
+	memset(c, 0, sizeof(*c));
+	c->key_def = key_def_dup(index->def->key_def);
+	if (c->key_def == NULL)
+		return -1;
+	uint32_t part_count = c->key_def->part_count;
+	size_t size = 2 * part_count * sizeof(c->ndv[0]);
+	c->ndv = calloc(1, size);
+	if (c->ndv == NULL) {
+		diag_set(OutOfMemory, size, "calloc", "ndv");
+		goto fail;
+	}
+	c->run_start = c->ndv + part_count;
+	c->sample_step = MAX(index_size(index) / SQL_STAT_SAMPLE_COUNT_MAX, 1);
+	c->iterator = index_create_snapshot_iterator(index);
+	if (c->iterator == NULL)
+		goto fail;
+	return 0;
+fail:
+	free(c->ndv);
+	key_def_delete(c->key_def);
+	return -1;
+}
+
+static void
+sql_stat_collector_destroy(struct sql_stat_collector *c)
+{
+	c->iterator->free(c->iterator);
+	for (uint32_t i = 0; i < c->sample_count; i++)
+		free(c->samples[i].eq);
+	free(c->last_key);
+	free(c->ndv);
+	key_def_delete(c->key_def);
+}
+
+/**
+ * A run of keys with the same first @a part_no + 1 parts has
+ * ended: count the keys equal to the samples taken from it.
+ */
+static void
+sql_stat_collector_end_run(struct sql_stat_collector *c, uint32_t part_no)
+{
+	for (uint32_t i = c->sample_count; i > 0; i--) {
+		struct sql_stat_sample *sample = &c->samples[i - 1];
+		if (sample->eq[part_no] != 0)
+			break;
+		sample->eq[part_no] = c->row_count - sample->lt[part_no];
+	}
+}
+
+/**
+ * Check if the next key should be sampled. @a common_len is the
+ * number of leading parts it shares with the previous key.
+ */
+static bool
+sql_stat_collector_needs_sample(struct sql_stat_collector *c,
+				const char *key, uint32_t common_len)
+{
+	uint32_t last_part = c->key_def->part_count - 1;
+	/* Keys of samples must be distinct. */
+	if (c->sample_count > 0 &&
+	    c->samples[c->sample_count - 1].lt[last_part] ==
+	    c->run_start[last_part])
+		return false;
+	mp_decode_array(&key);
+	if (common_len == 0 && mp_typeof(*key) == MP_NIL)
+		return c->sample_count < lengthof(c->samples);
+	return c->sample_count < SQL_STAT_SAMPLE_COUNT_MAX &&
+	       c->row_count % c->sample_step == c->sample_step / 2;
+}
+
+static int
+sql_stat_collector_add_sample(struct sql_stat_collector *c, const char *key,
+			      uint32_t key_size)
+{
+	uint32_t part_count = c->key_def->part_count;
+	size_t size = 3 * part_count * sizeof(uint64_t) + key_size;
+	uint64_t *counts = malloc(size);
+	if (counts == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "sample");
+		return -1;
+	}
+	struct sql_stat_sample *sample = &c->samples[c->sample_count++];
+	sample->eq = counts;
+	sample->lt = counts + part_count;
+	sample->dlt = counts + 2 * part_count;
+	sample->key = (char *)(counts + 3 * part_count);
+	sample->key_size = key_size;
+	memcpy(sample->key, key, key_size);
+	for (uint32_t i = 0; i < part_count; i++) {
+		sample->eq[i] = 0;
+		sample->lt[i] = c->run_start[i];
+		sample->dlt[i] = c->ndv[i] - 1;
+	}
+	return 0;
+}
+
+/** Account the next key of the index, in the index order. */
+static int
+sql_stat_collector_add(struct sql_stat_collector *c, const char *key,
+		       uint32_t key_size)
+{
+	uint32_t part_count = c->key_def->part_count;
+	uint32_t common_len = c->row_count == 0 ? 0 :
+		key_common_prefix_len(key, c->last_key, c->key_def);
+	for (uint32_t i = common_len; i < part_count; i++) {
+		sql_stat_collector_end_run(c, i);
+		c->ndv[i]++;
+		c->run_start[i] = c->row_count;
+	}
+	if (sql_stat_collector_needs_sample(c, key, common_len) &&
+	    sql_stat_collector_add_sample(c, key, key_size) != 0)
+		return -1;
+	if (key_size > c->last_key_capacity) {
+		uint32_t capacity = MAX(key_size, 2 * c->last_key_capacity);
+		char *last_key = realloc(c->last_key, capacity);
+		if (last_key == NULL) {
+			diag_set(OutOfMemory, capacity, "realloc", "key");
+			return -1;
+		}
+		c->last_key = last_key;
+		c->last_key_capacity = capacity;
+	}
+	memcpy(c->last_key, key, key_size);
+	c->row_count++;
+	return 0;
+}
+
+/**
+ * Read the next batch of keys of the index. Doesn't access
+ * anything but the collector and the read view, so it may be
+ * called from any thread if the index is a memtx one.
+ */
+static int
+sql_stat_collector_batch(struct sql_stat_collector *c)
+{
+	assert(!c->is_eof);
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	int rc = 0;
+	for (int i = 0; i < SQL_STAT_BATCH_SIZE; i++) {
+		const char *data;
+		uint32_t size;
+		if (c->iterator->next(c->iterator, &data, &size) != 0) {
+			rc = -1;
+			break;
+		}
+		if (data == NULL) {
+			for (uint32_t j = 0; j < c->key_def->part_count; j++)
+				sql_stat_collector_end_run(c, j);
+			c->is_eof = true;
+			break;
+		}
+		uint32_t key_size;
+		const char *key = tuple_extract_key_raw(data, data + size,
+							c->key_def,
+							MULTIKEY_NONE,
+							&key_size);
+		if (key == NULL ||
+		    sql_stat_collector_add(c, key, key_size) != 0) {
+			rc = -1;
+			break;
+		}
+		region_truncate(region, used);
+	}
+	region_truncate(region, used);
+	return rc;
+}
+
+static ssize_t
+sql_stat_collector_batch_f(va_list ap)
+{
+	struct sql_stat_collector *c = va_arg(ap, struct sql_stat_collector *);
+	return sql_stat_collector_batch(c);
+}
+
+/**
+ * Create index statistics given the number of keys in the index
+ * followed by the average number of keys with the same first 1,
+ * 2, ... parts, and the histogram samples sorted by key.
+ */
+static struct index_stat *
+sql_stat_new(uint32_t part_count, const uint32_t *tuple_stat1,
+	     const struct index_sample *samples, uint32_t sample_count)
+{
+	size_t size = index_stat_sizeof(samples, sample_count, part_count);
+	struct index_stat *stat = calloc(1, size);
+	if (stat == NULL) {
+		diag_set(OutOfMemory, size, "calloc", "stat");
+		return NULL;
+	}
+	/* The layout must match index_stat_dup(). */
+	size_t array_size = part_count * sizeof(uint32_t);
+	char *pos = (char *)(stat + 1);
+	stat->tuple_stat1 = (uint32_t *)pos;
+	pos += array_size + sizeof(uint32_t);
+	stat->tuple_log_est = (log_est_t *)pos;
+	pos += array_size + sizeof(uint32_t);
+	stat->avg_eq = (uint32_t *)pos;
+	pos += array_size;
+	stat->samples = (struct index_sample *)pos;
+	pos += sample_count * sizeof(struct index_sample);
+	stat->sample_count = sample_count;
+	stat->sample_field_count = part_count;
+	for (uint32_t i = 0; i < sample_count; i++) {
+		struct index_sample *sample = &stat->samples[i];
+		sample->eq = (uint32_t *)pos;
+		memcpy(sample->eq, samples[i].eq, array_size);
+		pos += array_size;
+		sample->lt = (uint32_t *)pos;
+		memcpy(sample->lt, samples[i].lt, array_size);
+		pos += array_size;
+		sample->dlt = (uint32_t *)pos;
+		memcpy(sample->dlt, samples[i].dlt, array_size);
+		pos += array_size;
+		sample->sample_key = pos;
+		sample->key_size = samples[i].key_size;
+		memcpy(pos, samples[i].sample_key, samples[i].key_size);
+		pos += samples[i].key_size;
+	}
+	for (uint32_t i = 0; i <= part_count; i++) {
+		stat->tuple_stat1[i] = tuple_stat1[i];
+		stat->tuple_log_est[i] = sqlLogEst(tuple_stat1[i]);
+	}
+	/*
+	 * Keys that aren't sampled are assumed to be evenly
+	 * distributed among the distinct values not sampled.
+	 */
+	uint64_t row_count = tuple_stat1[0];
+	for (uint32_t i = 0; i < part_count; i++) {
+		uint64_t distinct = row_count / MAX(tuple_stat1[i + 1], 1);
+		uint64_t eq_sum = 0;
+		uint64_t sampled = 0;
+		for (uint32_t j = 0; j < sample_count; j++) {
+			if (j == sample_count - 1 ||
+			    samples[j].dlt[i] != samples[j + 1].dlt[i]) {
+				eq_sum += samples[j].eq[i];
+				sampled++;
+			}
+		}
+		uint64_t avg_eq = 1;
+		if (distinct > sampled && row_count > eq_sum)
+			avg_eq = (row_count - eq_sum) / (distinct - sampled);
+		stat->avg_eq[i] = MIN(MAX(avg_eq, 1), UINT32_MAX);
+	}
+	return stat;
+}
+
+/** Build index statistics from the keys read by a collector. */
+static struct index_stat *
+sql_stat_collector_finish(struct sql_stat_collector *c)
+{
+	assert(c->is_eof);
+	uint32_t part_count = c->key_def->part_count;
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	struct index_stat *stat = NULL;
+	size_t size;
+	uint32_t *counts = region_alloc_array(region, uint32_t,
+					      (3 * c->sample_count + 1) *
+					      part_count + 1, &size);
+	struct index_sample *samples =
+		region_alloc_array(region, struct index_sample,
+				   c->sample_count, &size);
+	if (counts == NULL || samples == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc_array", "samples");
+		goto out;
+	}
+	uint32_t *tuple_stat1 = counts;
+	counts += part_count + 1;
+	tuple_stat1[0] = MIN(c->row_count, UINT32_MAX);
+	for (uint32_t i = 0; i < part_count; i++) {
+		uint64_t avg = c->ndv[i] == 0 ? 1 :
+			       DIV_ROUND_UP(c->row_count, c->ndv[i]);
+		tuple_stat1[i + 1] = MIN(avg, UINT32_MAX);
+	}
+	for (uint32_t i = 0; i < c->sample_count; i++) {
+		struct sql_stat_sample *src = &c->samples[i];
+		struct index_sample *dst = &samples[i];
+		dst->sample_key = src->key;
+		dst->key_size = src->key_size;
+		dst->eq = counts;
+		dst->lt = counts + part_count;
+		dst->dlt = counts + 2 * part_count;
+		counts += 3 * part_count;
+		for (uint32_t j = 0; j < part_count; j++) {
+			dst->eq[j] = MIN(src->eq[j], UINT32_MAX);
+			dst->lt[j] = MIN(src->lt[j], UINT32_MAX);
+			dst->dlt[j] = MIN(src->dlt[j], UINT32_MAX);
+		}
+	}
+	stat = sql_stat_new(part_count, tuple_stat1, samples, c->sample_count);
+out:
+	region_truncate(region, used);
+	return stat;
+}
+
+static void
+sql_stat_encode_error(void *error_ctx)
+{
+	*(bool *)error_ctx = true;
+}
+
+static void
+sql_stat_encode_counts(struct mpstream *stream, const char *name,
+		       const uint32_t *counts, uint32_t count)
+{
+	mpstream_encode_str(stream, name);
+	mpstream_encode_array(stream, count);
+	for (uint32_t i = 0; i < count; i++)
+		mpstream_encode_uint(stream, counts[i]);
+}
+
+/** Encode index statistics as a tuple of the _sql_stat space. */
+static struct tuple *
+sql_stat_tuple_new(uint32_t space_id, uint32_t index_id,
+		   const struct index_stat *stat)
+{
+	uint32_t part_count = stat->sample_field_count;
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	bool is_error = false;
+	struct mpstream stream;
+	mpstream_init(&stream, region, region_reserve_cb, region_alloc_cb,
+		      sql_stat_encode_error, &is_error);
+	mpstream_encode_array(&stream, 3);
+	mpstream_encode_uint(&stream, space_id);
+	mpstream_encode_uint(&stream, index_id);
+	mpstream_encode_map(&stream, 2);
+	sql_stat_encode_counts(&stream, "tuple_stat1", stat->tuple_stat1,
+			       part_count + 1);
+	mpstream_encode_str(&stream, "samples");
+	mpstream_encode_array(&stream, stat->sample_count);
+	for (uint32_t i = 0; i < stat->sample_count; i++) {
+		const struct index_sample *sample = &stat->samples[i];
+		mpstream_encode_map(&stream, 4);
+		mpstream_encode_str(&stream, "key");
+		mpstream_memcpy(&stream, sample->sample_key, sample->key_size);
+		sql_stat_encode_counts(&stream, "eq", sample->eq, part_count);
+		sql_stat_encode_counts(&stream, "lt", sample->lt, part_count);
+		sql_stat_encode_counts(&stream, "dlt", sample->dlt,
+				       part_count);
+	}
+	mpstream_flush(&stream);
+	struct tuple *tuple = NULL;
+	if (is_error) {
+		diag_set(OutOfMemory, stream.pos - stream.buf,
+			 "mpstream_flush", "stream");
+		goto out;
+	}
+	size_t size = region_used(region) - used;
+	const char *data = region_join(region, size);
+	if (data == NULL) {
+		diag_set(OutOfMemory, size, "region_join", "data");
+		goto out;
+	}
+	tuple = tuple_new(tuple_format_runtime, data, data + size);
+out:
+	region_truncate(region, used);
+	return tuple;
+}
+
+/** Replace the statistics of an index. */
+static void
+sql_stat_install(struct index *index, struct index_stat *stat)
+{
+	free(index->def->opts.stat);
+	index->def->opts.stat = stat;
+}
+
+struct tuple *
+sql_stat_collect(uint32_t space_id, uint32_t index_id)
+{
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return NULL;
+	struct index *index = index_find(space, index_id);
+	if (index == NULL || sql_stat_check_index(space, index) != 0)
+		return NULL;
+	struct sql_stat_collector collector;
+	if (sql_stat_collector_create(&collector, index) != 0)
+		return NULL;
+	uint64_t change_count = space->change_count;
+	bool is_memtx = space_is_memtx(space);
+	struct tuple *tuple = NULL;
+	struct index_stat *stat = NULL;
+	while (!collector.is_eof) {
+		if (fiber_is_cancelled()) {
+			diag_set(FiberIsCancelled);
+			goto out;
+		}
+		struct txn *txn = in_txn();
+		int rc;
+		if (!is_memtx ||
+		    (txn != NULL && !txn_has_flag(txn, TXN_CAN_YIELD))) {
+			/*
+			 * Vinyl can only be read from the tx thread,
+			 * and a yield would abort the transaction.
+			 */
+			rc = sql_stat_collector_batch(&collector);
+		} else {
+			rc = coio_call(sql_stat_collector_batch_f,
+				       &collector);
+		}
+		if (rc != 0)
+			goto out;
+	}
+	/* The index could be dropped or altered while it was read. */
+	space = space_cache_find(space_id);
+	if (space == NULL || space_index(space, index_id) != index ||
+	    key_part_cmp(index->def->key_def->parts,
+			 index->def->key_def->part_count,
+			 collector.key_def->parts,
+			 collector.key_def->part_count) != 0) {
+		if (space != NULL) {
+			diag_set(ClientError, ER_NO_SUCH_INDEX_ID, index_id,
+				 space_name(space));
+		}
+		goto out;
+	}
+	stat = sql_stat_collector_finish(&collector);
+	if (stat == NULL)
+		goto out;
+	stat->change_count = change_count;
+	tuple = sql_stat_tuple_new(space_id, index_id, stat);
+	if (tuple == NULL) {
+		free(stat);
+		goto out;
+	}
+	sql_stat_install(index, stat);
+out:
+	sql_stat_collector_destroy(&collector);
+	return tuple;
+}
+
+static int
+sql_stat_decode_error(void)
+{
+	diag_set(ClientError, ER_INVALID_MSGPACK, "SQL statistics");
+	return -1;
+}
+
+/** Decode an array of @a count unsigned integers. */
+static int
+sql_stat_decode_counts(const char **data, uint32_t *counts, uint32_t count)
+{
+	if (mp_typeof(**data) != MP_ARRAY || mp_decode_array(data) != count)
+		return sql_stat_decode_error();
+	for (uint32_t i = 0; i < count; i++) {
+		if (mp_typeof(**data) != MP_UINT)
+			return sql_stat_decode_error();
+		counts[i] = MIN(mp_decode_uint(data), UINT32_MAX);
+	}
+	return 0;
+}
+
+static int
+sql_stat_decode_sample(const char **data, struct key_def *key_def,
+		       struct index_sample *sample)
+{
+	uint32_t part_count = key_def->part_count;
+	if (mp_typeof(**data) != MP_MAP)
+		return sql_stat_decode_error();
+	uint32_t size = mp_decode_map(data);
+	uint32_t found = 0;
+	for (uint32_t i = 0; i < size; i++) {
+		if (mp_typeof(**data) != MP_STR)
+			return sql_stat_decode_error();
+		uint32_t len;
+		const char *name = mp_decode_str(data, &len);
+		uint32_t *counts;
+		if (len == strlen("key") && memcmp(name, "key", len) == 0) {
+			const char *key = *data;
+			if (mp_typeof(*key) != MP_ARRAY ||
+			    mp_decode_array(data) != part_count ||
+			    key_validate_parts(key_def, *data, part_count,
+					       true, data) != 0)
+				return sql_stat_decode_error();
+			sample->sample_key = (char *)key;
+			sample->key_size = *data - key;
+			found |= 1;
+			continue;
+		} else if (len == strlen("eq") && memcmp(name, "eq", len) == 0) {
+			counts = sample->eq;
+			found |= 2;
+		} else if (len == strlen("lt") && memcmp(name, "lt", len) == 0) {
+			counts = sample->lt;
+			found |= 4;
+		} else if (len == strlen("dlt") &&
+			   memcmp(name, "dlt", len) == 0) {
+			counts = sample->dlt;
+			found |= 8;
+		} else {
+			return sql_stat_decode_error();
+		}
+		if (sql_stat_decode_counts(data, counts, part_count) != 0)
+			return -1;
+	}
+	return found == 15 ? 0 : sql_stat_decode_error();
+}
+
+int
+sql_stat_load(struct tuple *tuple)
+{
+	const char *data = tuple_data(tuple);
+	uint32_t space_id, index_id;
+	if (mp_decode_array(&data) != 3 || mp_typeof(*data) != MP_UINT)
+		return sql_stat_decode_error();
+	space_id = mp_decode_uint(&data);
+	if (mp_typeof(*data) != MP_UINT)
+		return sql_stat_decode_error();
+	index_id = mp_decode_uint(&data);
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return -1;
+	struct index *index = index_find(space, index_id);
+	if (index == NULL || sql_stat_check_index(space, index) != 0)
+		return -1;
+	struct key_def *key_def = index->def->key_def;
+	uint32_t part_count = key_def->part_count;
+	if (mp_typeof(*data) != MP_MAP || mp_decode_map(&data) != 2)
+		return sql_stat_decode_error();
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	int rc = -1;
+	size_t size;
+	uint32_t *tuple_stat1 = region_alloc_array(region, uint32_t,
+						   part_count + 1, &size);
+	if (tuple_stat1 == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc_array",
+			 "tuple_stat1");
+		goto out;
+	}
+	struct index_sample *samples = NULL;
+	uint32_t sample_count = 0;
+	bool has_tuple_stat1 = false;
+	bool has_samples = false;
+	for (uint32_t i = 0; i < 2; i++) {
+		if (mp_typeof(*data) != MP_STR)
+			goto decode_error;
+		uint32_t len;
+		const char *name = mp_decode_str(&data, &len);
+		if (len == strlen("tuple_stat1") &&
+		    memcmp(name, "tuple_stat1", len) == 0) {
+			if (sql_stat_decode_counts(&data, tuple_stat1,
+						   part_count + 1) != 0)
+				goto out;
+			has_tuple_stat1 = true;
+			continue;
+		}
+		if (len != strlen("samples") ||
+		    memcmp(name, "samples", len) != 0 ||
+		    mp_typeof(*data) != MP_ARRAY)
+			goto decode_error;
+		sample_count = mp_decode_array(&data);
+		if (has_samples ||
+		    sample_count > SQL_STAT_SAMPLE_COUNT_MAX + 1)
+			goto decode_error;
+		has_samples = true;
+		samples = region_alloc_array(region, struct index_sample,
+					     sample_count, &size);
+		uint32_t *counts = region_alloc_array(region, uint32_t,
+						      3 * sample_count *
+						      part_count, &size);
+		if (samples == NULL || counts == NULL) {
+			diag_set(OutOfMemory, size, "region_alloc_array",
+				 "samples");
+			goto out;
+		}
+		for (uint32_t j = 0; j < sample_count; j++) {
+			struct index_sample *sample = &samples[j];
+			sample->eq = counts;
+			sample->lt = counts + part_count;
+			sample->dlt = counts + 2 * part_count;
+			counts += 3 * part_count;
+			if (sql_stat_decode_sample(&data, key_def,
+						   sample) != 0)
+				goto out;
+			/* The planner relies on samples being sorted. */
+			if (j > 0 && key_compare(samples[j - 1].sample_key,
+						 HINT_NONE,
+						 sample->sample_key,
+						 HINT_NONE, key_def) >= 0)
+				goto decode_error;
+		}
+	}
+	if (!has_tuple_stat1 || !has_samples)
+		goto decode_error;
+	struct index_stat *stat = sql_stat_new(part_count, tuple_stat1,
+					       samples, sample_count);
+	if (stat == NULL)
+		goto out;
+	stat->change_count = space->change_count;
+	sql_stat_install(index, stat);
+	rc = 0;
+	goto out;
+decode_error:
+	sql_stat_decode_error();
+out:
+	region_truncate(region, used);
+	return rc;
+}
+
+struct sql_stat_foreach_stale_ctx {
+	sql_stat_stale_f cb;
+	void *arg;
+};
+
+/** Check if the statistics of an index are missing or stale. */
+static bool
+sql_stat_is_stale(struct space *space, struct index *index)
+{
+	struct index_stat *stat = index->def->opts.stat;
+	if (stat == NULL)
+		return index_size(index) > 0;
+	/* The counter is reset when the space is altered. */
+	uint64_t changes = space->change_count;
+	if (changes >= stat->change_count)
+		changes -= stat->change_count;
+	return changes > 0 &&
+	       changes >= sql_stat_refresh_ratio * stat->tuple_stat1[0];
+}
+
+static int
+sql_stat_foreach_stale_in_space(struct space *space, void *arg)
+{
+	struct sql_stat_foreach_stale_ctx *ctx = arg;
+	if (space_is_system(space))
+		return 0;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct index *index = space->index[i];
+		if (sql_stat_unsupported(space, index) != NULL ||
+		    !sql_stat_is_stale(space, index))
+			continue;
+		int rc = ctx->cb(space_id(space), index->def->iid, ctx->arg);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
+int
+sql_stat_foreach_stale(sql_stat_stale_f cb, void *arg)
+{
+	if (sql_stat_refresh_ratio == 0)
+		return 0;
+	struct sql_stat_foreach_stale_ctx ctx = {cb, arg};
+	return space_foreach(sql_stat_foreach_stale_in_space, &ctx);
+}
@@ -0,0 +1,81 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+/*
+ * Statistics of index key distribution used by the SQL query
+ * planner, see struct index_stat.
+ *
+ * Statistics of an index are collected by a full scan of its read
+ * view, so the index is never locked. A memtx index is scanned by a
+ * coio worker thread, a vinyl one by the calling fiber. The scan
+ * yields the exact number of distinct values of each key prefix and
+ * an equi-depth histogram of the keys: samples taken at regular
+ * intervals, each with the number of keys less than and equal to
+ * it. NULL keys, if any, get a sample of their own, which gives the
+ * null fraction of the first key part.
+ *
+ * Only TREE indexes are supported, except for multikey and
+ * functional ones. Only the primary index of a vinyl space is
+ * supported, because secondary vinyl indexes don't store full
+ * tuples.
+ *
+ * Statistics are stored in the _sql_stat space and recollected in
+ * the background once the number of changes of the space exceeds
+ * box.cfg.sql_stat_refresh_ratio of the number of its rows, see
+ * box/lua/sql_stat.lua.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct tuple;
+
+/**
+ * Fraction of the rows of a space that must change for the SQL
+ * statistics of its indexes to get stale, box.cfg option. If 0,
+ * the statistics are never collected in the background.
+ */
+extern double sql_stat_refresh_ratio;
+
+/**
+ * Collect statistics of an index and install them for use by the
+ * planner. Yields. Returns the statistics as a tuple of the
+ * _sql_stat space: {space_id, index_id, stat}. The tuple isn't
+ * referenced. Returns NULL and sets diag on error.
+ */
+struct tuple *
+sql_stat_collect(uint32_t space_id, uint32_t index_id);
+
+/**
+ * Install statistics stored in a tuple of the _sql_stat space.
+ * Returns 0 on success, -1 and sets diag if the tuple is malformed
+ * or doesn't match the index.
+ */
+int
+sql_stat_load(struct tuple *tuple);
+
+/**
+ * Callback for sql_stat_foreach_stale(). If it returns non-zero,
+ * the iteration stops and the value is returned.
+ */
+typedef int
+(*sql_stat_stale_f)(uint32_t space_id, uint32_t index_id, void *arg);
+
+/**
+ * Call @a cb for each supported index of a non-system space that
+ * has no statistics while being non-empty or whose statistics are
+ * stale according to sql_stat_refresh_ratio.
+ */
+int
+sql_stat_foreach_stale(sql_stat_stale_f cb, void *arg);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
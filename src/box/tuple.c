@@ -288,6 +288,7 @@ int
 tuple_init(field_name_hash_f hash)
 {
 	tuple_format_init();
+	mp_skip_init();
 	field_name_hash = hash;
 	/*
 	 * Create a format for runtime tuples
@@ -388,8 +389,7 @@ tuple_field_go_to_index(const char **field, uint64_t index)
 		uint32_t count = mp_decode_array(field);
 		if (index >= count)
 			return -1;
-		for (; index > 0; --index)
-			mp_next(field);
+		mp_skip(field, index);
 		return 0;
 	} else if (type == MP_MAP) {
 		index += TUPLE_INDEX_BASE;
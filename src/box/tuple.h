@@ -37,6 +37,7 @@
 #include "tt_static.h"
 #include "tt_uuid.h"
 #include "tuple_format.h"
+#include "mp_skip.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -825,8 +826,7 @@ parse:
 		field_count = mp_decode_array(&tuple);
 		if (unlikely(fieldno >= field_count))
 			return NULL;
-		for (uint32_t k = 0; k < fieldno; k++)
-			mp_next(&tuple);
+		mp_skip(&tuple, fieldno);
 		if (path != NULL &&
 		    unlikely(tuple_go_to_path(&tuple, path, path_len,
 					      multikey_idx) != 0))
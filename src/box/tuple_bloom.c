@@ -42,6 +42,7 @@
 #include "key_def.h"
 #include "tuple.h"
 #include "salad/bloom.h"
+#include "salad/split_bloom.h"
 #include "trivia/util.h"
 #include <PMurHash.h>
 
@@ -154,14 +155,14 @@ tuple_bloom_new(struct tuple_bloom_builder *builder, double fpr)
 {
 	uint32_t part_count = builder->part_count;
 	size_t size = sizeof(struct tuple_bloom) +
-			part_count * sizeof(struct bloom);
+			part_count * sizeof(union tuple_bloom_part);
 	struct tuple_bloom *bloom = malloc(size);
 	if (bloom == NULL) {
 		diag_set(OutOfMemory, size, "malloc", "tuple bloom");
 		return NULL;
 	}
 
-	bloom->is_legacy = false;
+	bloom->format = TUPLE_BLOOM_FORMAT_SPLIT;
 	bloom->part_count = 0;
 
 	for (uint32_t i = 0; i < part_count; i++) {
@@ -177,17 +178,19 @@ tuple_bloom_new(struct tuple_bloom_builder *builder, double fpr)
 		 */
 		double part_fpr = fpr;
 		for (uint32_t j = 0; j < i; j++)
-			part_fpr /= bloom_fpr(&bloom->parts[j], count);
+			part_fpr /= split_bloom_fpr(&bloom->parts[j].split,
+						    count);
 		part_fpr = MIN(part_fpr, 0.5);
-		if (bloom_create(&bloom->parts[i], count, part_fpr) != 0) {
-			diag_set(OutOfMemory, 0, "bloom_create",
+		struct split_bloom *part = &bloom->parts[i].split;
+		if (split_bloom_create(part, count, part_fpr) != 0) {
+			diag_set(OutOfMemory, 0, "split_bloom_create",
 				 "tuple bloom part");
 			tuple_bloom_delete(bloom);
 			return NULL;
 		}
 		bloom->part_count++;
 		for (uint32_t k = 0; k < count; k++)
-			bloom_add(&bloom->parts[i], hash_arr->values[k]);
+			split_bloom_add(part, hash_arr->values[k]);
 	}
 	return bloom;
 }
@@ -195,19 +198,36 @@ tuple_bloom_new(struct tuple_bloom_builder *builder, double fpr)
 void
 tuple_bloom_delete(struct tuple_bloom *bloom)
 {
-	for (uint32_t i = 0; i < bloom->part_count; i++)
-		bloom_destroy(&bloom->parts[i]);
+	for (uint32_t i = 0; i < bloom->part_count; i++) {
+		if (bloom->format == TUPLE_BLOOM_FORMAT_SPLIT)
+			split_bloom_destroy(&bloom->parts[i].split);
+		else
+			bloom_destroy(&bloom->parts[i].classic);
+	}
 	free(bloom);
 }
 
+/**
+ * Check if a partial key hash was stored in a tuple bloom filter.
+ */
+static inline bool
+tuple_bloom_part_maybe_has(const struct tuple_bloom *bloom, uint32_t part_no,
+			   uint32_t hash)
+{
+	const union tuple_bloom_part *part = &bloom->parts[part_no];
+	if (likely(bloom->format == TUPLE_BLOOM_FORMAT_SPLIT))
+		return split_bloom_maybe_has(&part->split, hash);
+	return bloom_maybe_has(&part->classic, hash);
+}
+
 bool
 tuple_bloom_maybe_has(const struct tuple_bloom *bloom, struct tuple *tuple,
 		      struct key_def *key_def, int multikey_idx)
 {
 	assert(!key_def->is_multikey || multikey_idx != MULTIKEY_NONE);
 
-	if (bloom->is_legacy) {
-		return bloom_maybe_has(&bloom->parts[0],
+	if (bloom->format == TUPLE_BLOOM_FORMAT_LEGACY) {
+		return bloom_maybe_has(&bloom->parts[0].classic,
 				       tuple_hash(tuple, key_def));
 	}
 
@@ -222,7 +242,7 @@ tuple_bloom_maybe_has(const struct tuple_bloom *bloom, struct tuple *tuple,
 						  &key_def->parts[i],
 						  multikey_idx);
 		uint32_t hash = PMurHash32_Result(h, carry, total_size);
-		if (!bloom_maybe_has(&bloom->parts[i], hash))
+		if (!tuple_bloom_part_maybe_has(bloom, i, hash))
 			return false;
 	}
 	return true;
@@ -233,10 +253,10 @@ tuple_bloom_maybe_has_key(const struct tuple_bloom *bloom,
 			  const char *key, uint32_t part_count,
 			  struct key_def *key_def)
 {
-	if (bloom->is_legacy) {
+	if (bloom->format == TUPLE_BLOOM_FORMAT_LEGACY) {
 		if (part_count < key_def->part_count)
 			return true;
-		return bloom_maybe_has(&bloom->parts[0],
+		return bloom_maybe_has(&bloom->parts[0].classic,
 				       key_hash(key, key_def));
 	}
 
@@ -251,45 +271,74 @@ tuple_bloom_maybe_has_key(const struct tuple_bloom *bloom,
 		total_size += tuple_hash_field(&h, &carry, &key,
 					       key_def->parts[i].coll);
 		uint32_t hash = PMurHash32_Result(h, carry, total_size);
-		if (!bloom_maybe_has(&bloom->parts[i], hash))
+		if (!tuple_bloom_part_maybe_has(bloom, i, hash))
 			return false;
 	}
 	return true;
 }
 
 static size_t
-tuple_bloom_sizeof_part(const struct bloom *part)
+tuple_bloom_sizeof_part(const struct tuple_bloom *bloom, uint32_t part_no)
 {
+	const union tuple_bloom_part *part = &bloom->parts[part_no];
 	size_t size = 0;
 	size += mp_sizeof_array(3);
-	size += mp_sizeof_uint(part->table_size);
-	size += mp_sizeof_uint(part->hash_count);
-	size += mp_sizeof_bin(bloom_store_size(part));
+	if (bloom->format == TUPLE_BLOOM_FORMAT_SPLIT) {
+		size += mp_sizeof_uint(part->split.block_count);
+		size += mp_sizeof_uint(part->split.block_words);
+		size += mp_sizeof_bin(split_bloom_store_size(&part->split));
+	} else {
+		size += mp_sizeof_uint(part->classic.table_size);
+		size += mp_sizeof_uint(part->classic.hash_count);
+		size += mp_sizeof_bin(bloom_store_size(&part->classic));
+	}
 	return size;
 }
 
 static char *
-tuple_bloom_encode_part(const struct bloom *part, char *buf)
+tuple_bloom_encode_part(const struct tuple_bloom *bloom, uint32_t part_no,
+			char *buf)
 {
+	const union tuple_bloom_part *part = &bloom->parts[part_no];
 	buf = mp_encode_array(buf, 3);
-	buf = mp_encode_uint(buf, part->table_size);
-	buf = mp_encode_uint(buf, part->hash_count);
-	buf = mp_encode_binl(buf, bloom_store_size(part));
-	buf = bloom_store(part, buf);
+	if (bloom->format == TUPLE_BLOOM_FORMAT_SPLIT) {
+		buf = mp_encode_uint(buf, part->split.block_count);
+		buf = mp_encode_uint(buf, part->split.block_words);
+		buf = mp_encode_binl(buf, split_bloom_store_size(&part->split));
+		buf = split_bloom_store(&part->split, buf);
+	} else {
+		buf = mp_encode_uint(buf, part->classic.table_size);
+		buf = mp_encode_uint(buf, part->classic.hash_count);
+		buf = mp_encode_binl(buf, bloom_store_size(&part->classic));
+		buf = bloom_store(&part->classic, buf);
+	}
 	return buf;
 }
 
 static int
-tuple_bloom_decode_part(struct bloom *part, const char **data)
+tuple_bloom_decode_part(struct tuple_bloom *bloom, uint32_t part_no,
+			const char **data)
 {
+	union tuple_bloom_part *part = &bloom->parts[part_no];
 	memset(part, 0, sizeof(*part));
 	if (mp_decode_array(data) != 3)
 		unreachable();
-	part->table_size = mp_decode_uint(data);
-	part->hash_count = mp_decode_uint(data);
-	size_t store_size = mp_decode_binl(data);
-	assert(store_size == bloom_store_size(part));
-	if (bloom_load_table(part, *data) != 0) {
+	size_t store_size;
+	int rc;
+	if (bloom->format == TUPLE_BLOOM_FORMAT_SPLIT) {
+		part->split.block_count = mp_decode_uint(data);
+		part->split.block_words = mp_decode_uint(data);
+		store_size = mp_decode_binl(data);
+		assert(store_size == split_bloom_store_size(&part->split));
+		rc = split_bloom_load_table(&part->split, *data);
+	} else {
+		part->classic.table_size = mp_decode_uint(data);
+		part->classic.hash_count = mp_decode_uint(data);
+		store_size = mp_decode_binl(data);
+		assert(store_size == bloom_store_size(&part->classic));
+		rc = bloom_load_table(&part->classic, *data);
+	}
+	if (rc != 0) {
 		diag_set(OutOfMemory, store_size, "bloom_load_table",
 			 "tuple bloom part");
 		return -1;
@@ -304,7 +353,7 @@ tuple_bloom_size(const struct tuple_bloom *bloom)
 	size_t size = 0;
 	size += mp_sizeof_array(bloom->part_count);
 	for (uint32_t i = 0; i < bloom->part_count; i++)
-		size += tuple_bloom_sizeof_part(&bloom->parts[i]);
+		size += tuple_bloom_sizeof_part(bloom, i);
 	return size;
 }
 
@@ -313,13 +362,14 @@ tuple_bloom_encode(const struct tuple_bloom *bloom, char *buf)
 {
 	buf = mp_encode_array(buf, bloom->part_count);
 	for (uint32_t i = 0; i < bloom->part_count; i++)
-		buf = tuple_bloom_encode_part(&bloom->parts[i], buf);
+		buf = tuple_bloom_encode_part(bloom, i, buf);
 	return buf;
 }
 
 struct tuple_bloom *
-tuple_bloom_decode(const char **data)
+tuple_bloom_decode(const char **data, enum tuple_bloom_format format)
 {
+	assert(format != TUPLE_BLOOM_FORMAT_LEGACY);
 	uint32_t part_count = mp_decode_array(data);
 	struct tuple_bloom *bloom = malloc(sizeof(*bloom) +
 			part_count * sizeof(*bloom->parts));
@@ -330,11 +380,11 @@ tuple_bloom_decode(const char **data)
 		return NULL;
 	}
 
-	bloom->is_legacy = false;
+	bloom->format = format;
 	bloom->part_count = 0;
 
 	for (uint32_t i = 0; i < part_count; i++) {
-		if (tuple_bloom_decode_part(&bloom->parts[i], data) != 0) {
+		if (tuple_bloom_decode_part(bloom, i, data) != 0) {
 			tuple_bloom_delete(bloom);
 			return NULL;
 		}
@@ -354,7 +404,7 @@ tuple_bloom_decode_legacy(const char **data)
 		return NULL;
 	}
 
-	bloom->is_legacy = true;
+	bloom->format = TUPLE_BLOOM_FORMAT_LEGACY;
 	bloom->part_count = 1;
 
 	if (mp_decode_array(data) != 4)
@@ -362,12 +412,13 @@ tuple_bloom_decode_legacy(const char **data)
 	if (mp_decode_uint(data) != 0) /* version */
 		unreachable();
 
-	bloom->parts[0].table_size = mp_decode_uint(data);
-	bloom->parts[0].hash_count = mp_decode_uint(data);
+	struct bloom *part = &bloom->parts[0].classic;
+	part->table_size = mp_decode_uint(data);
+	part->hash_count = mp_decode_uint(data);
 
 	size_t store_size = mp_decode_binl(data);
-	assert(store_size == bloom_store_size(&bloom->parts[0]));
-	if (bloom_load_table(&bloom->parts[0], *data) != 0) {
+	assert(store_size == bloom_store_size(part));
+	if (bloom_load_table(part, *data) != 0) {
 		diag_set(OutOfMemory, store_size, "bloom_load_table",
 			 "tuple bloom part");
 		free(bloom);
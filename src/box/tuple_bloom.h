@@ -35,6 +35,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include "salad/bloom.h"
+#include "salad/split_bloom.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -43,6 +44,30 @@ extern "C" {
 struct tuple;
 struct key_def;
 
+/** Format of a tuple bloom filter. */
+enum tuple_bloom_format {
+	/**
+	 * Legacy bloom filter that stores hashes only for full
+	 * keys (see tuple_bloom_decode_legacy).
+	 */
+	TUPLE_BLOOM_FORMAT_LEGACY,
+	/** Classic bloom filter per each partial key. */
+	TUPLE_BLOOM_FORMAT_CLASSIC,
+	/**
+	 * Split block bloom filter per each partial key. This is
+	 * the format of new bloom filters.
+	 */
+	TUPLE_BLOOM_FORMAT_SPLIT,
+};
+
+/** Bloom filter of a partial key. */
+union tuple_bloom_part {
+	/** TUPLE_BLOOM_FORMAT_LEGACY, TUPLE_BLOOM_FORMAT_CLASSIC. */
+	struct bloom classic;
+	/** TUPLE_BLOOM_FORMAT_SPLIT. */
+	struct split_bloom split;
+};
+
 /**
  * Tuple bloom filter.
  *
@@ -52,16 +77,12 @@ struct key_def;
  * of false positive results.
  */
 struct tuple_bloom {
-	/**
-	 * If the following flag is set, this is a legacy
-	 * bloom filter that stores hashes only for full keys
-	 * (see tuple_bloom_decode_legacy).
-	 */
-	bool is_legacy;
+	/** Format of the bloom filters. */
+	enum tuple_bloom_format format;
 	/** Number of key parts. */
 	uint32_t part_count;
 	/** Array of bloom filters, one per each partial key. */
-	struct bloom parts[0];
+	union tuple_bloom_part parts[0];
 };
 
 /**
@@ -214,10 +235,12 @@ tuple_bloom_encode(const struct tuple_bloom *bloom, char *buf);
  * Decode a tuple bloom filter from MsgPack.
  * @param data - pointer to buffer storing encoded bloom filter;
  *  on success it is advanced by the number of decoded bytes
+ * @param format - format of the encoded bloom filter, either
+ *  TUPLE_BLOOM_FORMAT_CLASSIC or TUPLE_BLOOM_FORMAT_SPLIT
  * @return the decoded bloom on success or NULL on OOM
  */
 struct tuple_bloom *
-tuple_bloom_decode(const char **data);
+tuple_bloom_decode(const char **data, enum tuple_bloom_format format);
 
 /**
  * Decode a legacy bloom filter from MsgPack.
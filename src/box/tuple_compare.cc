@@ -455,6 +455,12 @@ mp_compare_scalar_coll(const char *field_a, const char *field_b,
 	return mp_compare_scalar_with_type(field_a, type_a, field_b, type_b);
 }
 
+int
+tuple_compare_scalar(const char *field_a, const char *field_b)
+{
+	return mp_compare_scalar(field_a, field_b);
+}
+
 /**
  * @brief Compare two fields parts using a type definition
  * @param field_a field
@@ -928,6 +934,33 @@ key_compare(const char *key_a, hint_t key_a_hint,
 	}
 }
 
+uint32_t
+key_common_prefix_len(const char *key_a, const char *key_b,
+		      struct key_def *key_def)
+{
+	uint32_t part_count_a = mp_decode_array(&key_a);
+	uint32_t part_count_b = mp_decode_array(&key_b);
+	uint32_t part_count = MIN(part_count_a, part_count_b);
+	assert(part_count <= key_def->part_count);
+	struct key_part *part = key_def->parts;
+	for (uint32_t i = 0; i < part_count; i++, part++) {
+		enum mp_type a_type = mp_typeof(*key_a);
+		enum mp_type b_type = mp_typeof(*key_b);
+		if (a_type == MP_NIL || b_type == MP_NIL) {
+			if (a_type != b_type)
+				return i;
+		} else if (tuple_compare_field_with_type(key_a, a_type,
+							 key_b, b_type,
+							 part->type,
+							 part->coll) != 0) {
+			return i;
+		}
+		mp_next(&key_a);
+		mp_next(&key_b);
+	}
+	return part_count;
+}
+
 template <bool is_nullable, bool has_optional_parts>
 static int
 tuple_compare_sequential(struct tuple *tuple_a, hint_t tuple_a_hint,
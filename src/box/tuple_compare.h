@@ -76,6 +76,27 @@ typedef uint64_t hint_t;
 void
 key_def_set_compare_func(struct key_def *def);
 
+/**
+ * Compare two MessagePack values the way a SCALAR index part
+ * without a collation does. Both values must be scalars: numbers,
+ * strings, binaries, booleans, UUIDs or datetimes.
+ * @retval 0  if field_a == field_b
+ * @retval <0 if field_a < field_b
+ * @retval >0 if field_a > field_b
+ */
+int
+tuple_compare_scalar(const char *field_a, const char *field_b);
+
+/**
+ * Return the number of leading parts two keys are equal in.
+ * The keys are MessagePack arrays of parts of @a key_def, as
+ * returned by tuple_extract_key(), and may be partial. NULLs
+ * are equal to each other.
+ */
+uint32_t
+key_common_prefix_len(const char *key_a, const char *key_b,
+		      struct key_def *key_def);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -499,3 +499,37 @@ tuple_validate_key_parts(struct key_def *key_def, struct tuple *tuple)
 	}
 	return 0;
 }
+
+int
+tuple_validate_key_parts_raw(struct key_def *key_def, const char *tuple)
+{
+	assert(!key_def->is_multikey);
+	uint32_t field_count = mp_decode_array(&tuple);
+	for (uint32_t idx = 0; idx < key_def->part_count; idx++) {
+		struct key_part *part = &key_def->parts[idx];
+		const char *field = NULL;
+		if (part->fieldno < field_count) {
+			field = tuple;
+			for (uint32_t i = 0; i < part->fieldno; i++)
+				mp_next(&field);
+			if (part->path != NULL &&
+			    tuple_go_to_path(&field, part->path,
+					     part->path_len,
+					     MULTIKEY_NONE) != 0)
+				unreachable();
+		}
+		if (field == NULL) {
+			if (key_part_is_nullable(part))
+				continue;
+			diag_set(ClientError, ER_FIELD_MISSING,
+				 tt_sprintf("[%d]%.*s",
+					    part->fieldno + TUPLE_INDEX_BASE,
+					    part->path_len, part->path));
+			return -1;
+		}
+		if (key_part_validate(part->type, field, idx,
+				      key_part_is_nullable(part)) != 0)
+			return -1;
+	}
+	return 0;
+}
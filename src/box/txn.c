@@ -35,6 +35,7 @@
 #include "tuple.h"
 #include "journal.h"
 #include <fiber.h>
+#include "clock.h"
 #include "xrow.h"
 #include "errinj.h"
 #include "iproto_constants.h"
@@ -976,7 +977,11 @@ txn_commit(struct txn *txn)
 	}
 
 	fiber_set_txn(fiber(), NULL);
-	if (journal_write(req) != 0)
+	uint64_t wal_start_time = clock_monotonic64();
+	int rc = journal_write(req);
+	fiber()->storage.net.wal_wait_time +=
+		clock_monotonic64() - wal_start_time;
+	if (rc != 0)
 		goto rollback_io;
 	if (req->res < 0) {
 		diag_set_journal_res(req->res);
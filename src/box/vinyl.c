@@ -54,6 +54,7 @@
 #include <small/lsregion.h>
 #include <small/region.h>
 #include <small/mempool.h>
+#include <qsort_arg.h>
 
 #include "coio_task.h"
 #include "cbus.h"
@@ -65,6 +66,7 @@
 #include "engine.h"
 #include "space.h"
 #include "index.h"
+#include "port.h"
 #include "schema.h"
 #include "xstream.h"
 #include "info/info.h"
@@ -82,6 +84,12 @@ enum { VY_YIELD_LOOPS = 128 };
 enum { VY_YIELD_LOOPS = 2 };
 #endif
 
+/**
+ * Max number of fibers executing lookups of a single
+ * index.get_many() request concurrently.
+ */
+enum { VY_GET_MANY_FIBERS_MAX = 32 };
+
 struct vy_squash_queue;
 
 enum vy_status {
@@ -296,11 +304,24 @@ vy_info_append_memory(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "tx", vy_tx_manager_mem_used(env->xm));
 	info_append_int(h, "level0", lsregion_used(&env->mem_env.allocator));
 	info_append_int(h, "tuple_cache", env->cache_env.mem_used);
+	info_append_int(h, "page_cache", env->run_env.page_cache.mem_used);
 	info_append_int(h, "page_index", env->lsm_env.page_index_size);
 	info_append_int(h, "bloom_filter", env->lsm_env.bloom_size);
 	info_table_end(h); /* memory */
 }
 
+static void
+vy_info_append_page_cache(struct vy_env *env, struct info_handler *h)
+{
+	struct vy_page_cache *cache = &env->run_env.page_cache;
+	info_table_begin(h, "page_cache");
+	info_append_int(h, "lookup", cache->stat.lookup);
+	info_append_int(h, "hit", cache->stat.hit);
+	info_append_int(h, "put", cache->stat.put);
+	info_append_int(h, "evict", cache->stat.evict);
+	info_table_end(h); /* page_cache */
+}
+
 static void
 vy_info_append_disk(struct vy_env *env, struct info_handler *h)
 {
@@ -319,6 +340,7 @@ vinyl_engine_stat(struct engine *engine, struct info_handler *h)
 	info_begin(h);
 	vy_info_append_tx(env, h);
 	vy_info_append_memory(env, h);
+	vy_info_append_page_cache(env, h);
 	vy_info_append_disk(env, h);
 	vy_info_append_scheduler(env, h);
 	vy_info_append_regulator(env, h);
@@ -590,6 +612,11 @@ vinyl_engine_check_space_def(struct space_def *def)
 			 def->name, "engine does not support temporary flag");
 		return -1;
 	}
+	if (def->opts.memory_quota != 0) {
+		diag_set(ClientError, ER_ALTER_SPACE,
+			 def->name, "engine does not support memory quota");
+		return -1;
+	}
 	return 0;
 }
 
@@ -2584,8 +2611,8 @@ vy_squash_schedule(struct vy_lsm *lsm, struct vy_entry entry,
 		   void /* struct vy_env */ *arg);
 
 static struct vy_env *
-vy_env_new(const char *path, size_t memory,
-	   int read_threads, int write_threads, bool force_recovery)
+vy_env_new(const char *path, size_t memory, int read_threads,
+	   bool use_io_uring, int write_threads, bool force_recovery)
 {
 	struct vy_env *e = malloc(sizeof(*e));
 	if (unlikely(e == NULL)) {
@@ -2631,7 +2658,7 @@ vy_env_new(const char *path, size_t memory,
 	mempool_create(&e->iterator_pool, slab_cache,
 	               sizeof(struct vinyl_iterator));
 	vy_cache_env_create(&e->cache_env, slab_cache);
-	vy_run_env_create(&e->run_env, read_threads);
+	vy_run_env_create(&e->run_env, read_threads, use_io_uring);
 	vy_log_init(e->path);
 	return e;
 
@@ -2683,11 +2710,12 @@ vy_env_complete_recovery(struct vy_env *env)
 }
 
 struct engine *
-vinyl_engine_new(const char *dir, size_t memory,
-		 int read_threads, int write_threads, bool force_recovery)
+vinyl_engine_new(const char *dir, size_t memory, int read_threads,
+		 bool use_io_uring, int write_threads, bool force_recovery)
 {
 	struct vy_env *env = vy_env_new(dir, memory, read_threads,
-					write_threads, force_recovery);
+					use_io_uring, write_threads,
+					force_recovery);
 	if (env == NULL)
 		return NULL;
 
@@ -2710,6 +2738,13 @@ vinyl_engine_set_cache(struct engine *engine, size_t quota)
 	vy_cache_env_set_quota(&env->cache_env, quota);
 }
 
+void
+vinyl_engine_set_page_cache(struct engine *engine, size_t quota)
+{
+	struct vy_env *env = vy_env(engine);
+	vy_run_env_set_page_cache_quota(&env->run_env, quota);
+}
+
 int
 vinyl_engine_set_memory(struct engine *engine, size_t size)
 {
@@ -3658,6 +3693,21 @@ vinyl_iterator_free(struct iterator *base)
 	mempool_free(it->pool, it);
 }
 
+static int
+vinyl_iterator_start_after(struct iterator *base, const char *key,
+			   uint32_t part_count)
+{
+	assert(base->start_after == vinyl_iterator_start_after);
+	struct vinyl_iterator *it = (struct vinyl_iterator *)base;
+	struct vy_lsm *lsm = vy_lsm(base->index);
+	struct vy_entry last = vy_entry_key_new(lsm->env->key_format,
+						lsm->cmp_def, key, part_count);
+	if (last.stmt == NULL)
+		return -1;
+	vy_read_iterator_start_after(&it->iterator, last);
+	return 0;
+}
+
 static struct iterator *
 vinyl_index_create_iterator(struct index *base, enum iterator_type type,
 			    const char *key, uint32_t part_count)
@@ -3696,6 +3746,7 @@ vinyl_index_create_iterator(struct index *base, enum iterator_type type,
 	else
 		it->base.next = vinyl_iterator_secondary_next;
 	it->base.free = vinyl_iterator_free;
+	it->base.start_after = vinyl_iterator_start_after;
 	it->pool = &env->iterator_pool;
 
 	if (tx != NULL) {
@@ -3812,6 +3863,191 @@ vinyl_index_get(struct index *index, const char *key,
 	return 0;
 }
 
+/** Key looked up by vinyl_index_get_many(). */
+struct vy_get_many_key {
+	/** Key statement. */
+	struct vy_entry entry;
+	/** Position of the key in the request. */
+	uint32_t pos;
+};
+
+/** State shared by fibers executing vinyl_index_get_many(). */
+struct vy_get_many_ctx {
+	struct vy_lsm *lsm;
+	struct vy_tx *tx;
+	const struct vy_read_view **rv;
+	/** Keys sorted in the index order. */
+	struct vy_get_many_key *keys;
+	uint32_t key_count;
+	/** Index of the next key to look up. */
+	uint32_t next_key;
+	/** Found tuples, in the request order. */
+	struct tuple **results;
+	/** Set if any lookup failed. */
+	bool is_failed;
+};
+
+static int
+vy_get_many_key_cmp(const void *a, const void *b, void *arg)
+{
+	const struct vy_get_many_key *key_a = a;
+	const struct vy_get_many_key *key_b = b;
+	struct key_def *cmp_def = arg;
+	return vy_entry_compare(key_a->entry, key_b->entry, cmp_def);
+}
+
+/**
+ * Look up keys one by one until there are no more keys left.
+ * Keys that can be found in memory are looked up without yielding
+ * so the fiber proceeds to the next key immediately. Otherwise the
+ * fiber waits for a page read while other fibers keep going.
+ */
+static int
+vy_get_many_worker(struct vy_get_many_ctx *ctx)
+{
+	while (!ctx->is_failed && ctx->next_key < ctx->key_count) {
+		struct vy_get_many_key *key = &ctx->keys[ctx->next_key++];
+		if (vy_get(ctx->lsm, ctx->tx, ctx->rv, key->entry.stmt,
+			   &ctx->results[key->pos]) != 0) {
+			ctx->is_failed = true;
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int
+vy_get_many_f(va_list ap)
+{
+	struct vy_get_many_ctx *ctx = va_arg(ap, struct vy_get_many_ctx *);
+	return vy_get_many_worker(ctx);
+}
+
+/**
+ * Batched point lookup. Keys are sorted so that lookups of
+ * neighboring keys hit the same ranges, bloom filters and pages
+ * one after another, and then looked up by several fibers at once
+ * so that page reads for different keys are executed concurrently
+ * by the reader threads instead of waiting for each other.
+ */
+static int
+vinyl_index_get_many(struct index *index, const char *keys,
+		     uint32_t key_count, struct port *port)
+{
+	assert(index->def->opts.is_unique);
+
+	struct vy_lsm *lsm = vy_lsm(index);
+	struct vy_env *env = vy_env(index->engine);
+	struct vy_tx *tx = in_txn() ? in_txn()->engine_tx : NULL;
+	const struct vy_read_view **rv = (tx != NULL ? vy_tx_read_view(tx) :
+					  &env->xm->p_global_read_view);
+
+	if (tx != NULL && tx->state == VINYL_TX_ABORT) {
+		diag_set(ClientError, ER_TRANSACTION_CONFLICT);
+		return -1;
+	}
+	if (key_count == 0)
+		return 0;
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t size;
+	struct vy_get_many_key *sorted_keys = region_alloc_array(
+		region, typeof(sorted_keys[0]), key_count, &size);
+	if (sorted_keys == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc_array", "keys");
+		return -1;
+	}
+	struct tuple **results = region_alloc_array(
+		region, typeof(results[0]), key_count, &size);
+	if (results == NULL) {
+		region_truncate(region, region_svp);
+		diag_set(OutOfMemory, size, "region_alloc_array", "results");
+		return -1;
+	}
+	memset(results, 0, key_count * sizeof(results[0]));
+
+	int rc = -1;
+	uint32_t key_stmt_count = 0;
+	for (uint32_t i = 0; i < key_count; i++) {
+		uint32_t part_count = mp_decode_array(&keys);
+		struct tuple *stmt = vy_key_new(lsm->env->key_format,
+						keys, part_count);
+		if (stmt == NULL)
+			goto out;
+		for (uint32_t j = 0; j < part_count; j++)
+			mp_next(&keys);
+		sorted_keys[i].entry.stmt = stmt;
+		sorted_keys[i].entry.hint = vy_stmt_hint(stmt, lsm->cmp_def);
+		sorted_keys[i].pos = i;
+		key_stmt_count++;
+	}
+	qsort_arg(sorted_keys, key_count, sizeof(sorted_keys[0]),
+		  vy_get_many_key_cmp, lsm->cmp_def);
+
+	struct vy_get_many_ctx ctx = {
+		.lsm = lsm,
+		.tx = tx,
+		.rv = rv,
+		.keys = sorted_keys,
+		.key_count = key_count,
+		.next_key = 0,
+		.results = results,
+		.is_failed = false,
+	};
+	/*
+	 * Make sure the LSM tree isn't deleted while we are
+	 * reading from it.
+	 */
+	vy_lsm_ref(lsm);
+	/*
+	 * Two fibers per reader thread are enough to keep all the
+	 * threads busy: while a thread is reading a page for one
+	 * fiber, the other one is processing the previous page.
+	 */
+	uint32_t fiber_count = MIN(key_count, (uint32_t)VY_GET_MANY_FIBERS_MAX);
+	fiber_count = MIN(fiber_count, 2 * (uint32_t)
+			  env->run_env.reader_pool_size);
+	struct fiber *fibers[VY_GET_MANY_FIBERS_MAX];
+	uint32_t started = 0;
+	for (uint32_t i = 1; i < fiber_count; i++) {
+		struct fiber *f = fiber_new("vinyl.get_many", vy_get_many_f);
+		if (f == NULL) {
+			/* Proceed with fibers that have been started. */
+			diag_clear(diag_get());
+			break;
+		}
+		fiber_set_joinable(f, true);
+		fiber_start(f, &ctx);
+		fibers[started++] = f;
+	}
+	rc = vy_get_many_worker(&ctx);
+	for (uint32_t i = 0; i < started; i++) {
+		if (fiber_join(fibers[i]) != 0)
+			rc = -1;
+	}
+	vy_lsm_unref(lsm);
+	if (rc != 0)
+		goto out;
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (results[i] == NULL)
+			continue;
+		if (port_c_add_tuple(port, results[i]) != 0) {
+			rc = -1;
+			goto out;
+		}
+	}
+out:
+	for (uint32_t i = 0; i < key_stmt_count; i++)
+		tuple_unref(sorted_keys[i].entry.stmt);
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (results[i] != NULL)
+			tuple_unref(results[i]);
+	}
+	region_truncate(region, region_svp);
+	return rc;
+}
+
 /*** }}} Cursor */
 
 /* {{{ Index build */
@@ -4565,6 +4801,7 @@ static const struct engine_vtab vinyl_engine_vtab = {
 static const struct space_vtab vinyl_space_vtab = {
 	/* .destroy = */ vinyl_space_destroy,
 	/* .bsize = */ vinyl_space_bsize,
+	/* .stat = */ generic_space_stat,
 	/* .execute_replace = */ vinyl_space_execute_replace,
 	/* .execute_delete = */ vinyl_space_execute_delete,
 	/* .execute_update = */ vinyl_space_execute_update,
@@ -4603,6 +4840,7 @@ static const struct index_vtab vinyl_index_vtab = {
 	/* .count = */ generic_index_count,
 	/* .get_raw = */ generic_index_get_raw,
 	/* .get = */ vinyl_index_get,
+	/* .get_many = */ vinyl_index_get_many,
 	/* .replace = */ generic_index_replace,
 	/* .create_iterator = */ vinyl_index_create_iterator,
 	/* .create_snapshot_iterator = */
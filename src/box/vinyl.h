@@ -41,9 +41,13 @@ extern "C" {
 struct info_handler;
 struct engine;
 
+/**
+ * Create a vinyl engine. If @a use_io_uring is set, reader threads
+ * read run files through io_uring, provided it's supported.
+ */
 struct engine *
-vinyl_engine_new(const char *dir, size_t memory,
-		 int read_threads, int write_threads, bool force_recovery);
+vinyl_engine_new(const char *dir, size_t memory, int read_threads,
+		 bool use_io_uring, int write_threads, bool force_recovery);
 
 /**
  * Vinyl engine statistics (box.stat.vinyl()).
@@ -57,6 +61,12 @@ vinyl_engine_stat(struct engine *engine, struct info_handler *handler);
 void
 vinyl_engine_set_cache(struct engine *engine, size_t quota);
 
+/**
+ * Update vinyl page cache size.
+ */
+void
+vinyl_engine_set_page_cache(struct engine *engine, size_t quota);
+
 /**
  * Update vinyl memory size.
  */
@@ -94,11 +104,11 @@ vinyl_engine_set_snap_io_rate_limit(struct engine *engine, double limit);
 #include "diag.h"
 
 static inline struct engine *
-vinyl_engine_new_xc(const char *dir, size_t memory,
-		    int read_threads, int write_threads, bool force_recovery)
+vinyl_engine_new_xc(const char *dir, size_t memory, int read_threads,
+		    bool use_io_uring, int write_threads, bool force_recovery)
 {
 	struct engine *vinyl;
-	vinyl = vinyl_engine_new(dir, memory, read_threads,
+	vinyl = vinyl_engine_new(dir, memory, read_threads, use_io_uring,
 				 write_threads, force_recovery);
 	if (vinyl == NULL)
 		diag_raise();
@@ -405,7 +405,7 @@ vy_read_iterator_advance(struct vy_read_iterator *itr)
 	 * Restore the iterator position if the LSM tree has changed
 	 * since the last iteration or this is the first iteration.
 	 */
-	if (itr->last.stmt == NULL ||
+	if (itr->last.stmt == NULL || itr->curr_range == NULL ||
 	    itr->mem_list_version != itr->lsm->mem_list_version ||
 	    itr->range_tree_version != itr->lsm->range_tree_version ||
 	    itr->range_version != itr->curr_range->version) {
@@ -667,6 +667,16 @@ vy_read_iterator_open(struct vy_read_iterator *itr, struct vy_lsm *lsm,
 
 }
 
+void
+vy_read_iterator_start_after(struct vy_read_iterator *itr,
+			     struct vy_entry last)
+{
+	assert(itr->last.stmt == NULL);
+	assert(itr->curr_range == NULL);
+	itr->last = last;
+	itr->is_started_after = true;
+}
+
 /**
  * Restart the read iterator from the position following
  * the last statement returned to the user. Called when
@@ -853,8 +863,13 @@ vy_read_iterator_cache_add(struct vy_read_iterator *itr, struct vy_entry entry)
 		itr->last_cached = vy_entry_none();
 		return;
 	}
-	vy_cache_add(&itr->lsm->cache, entry, itr->last_cached,
-		     itr->key, itr->iterator_type);
+	if (itr->is_started_after) {
+		/* Nothing is known about statements preceding the entry. */
+		itr->is_started_after = false;
+	} else {
+		vy_cache_add(&itr->lsm->cache, entry, itr->last_cached,
+			     itr->key, itr->iterator_type);
+	}
 	if (entry.stmt != NULL)
 		tuple_ref(entry.stmt);
 	if (itr->last_cached.stmt != NULL)
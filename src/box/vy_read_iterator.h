@@ -70,6 +70,14 @@ struct vy_read_iterator {
 	 * vy_read_iterator_cache_add().
 	 */
 	struct vy_entry last_cached;
+	/**
+	 * Set if the iteration was started after a given statement,
+	 * see vy_read_iterator_start_after(). Statements between the
+	 * search key and the first returned statement are unknown
+	 * then, so the latter must not be linked to the key in the
+	 * cache.
+	 */
+	bool is_started_after;
 	/**
 	 * Copy of lsm->range_tree_version.
 	 * Used for detecting range tree changes.
@@ -135,6 +143,18 @@ vy_read_iterator_open(struct vy_read_iterator *itr, struct vy_lsm *lsm,
 		      struct vy_tx *tx, enum iterator_type iterator_type,
 		      struct vy_entry key, const struct vy_read_view **rv);
 
+/**
+ * Make the iterator return statements following the given one,
+ * as if it had been returned by the iterator. Must be called
+ * before the first call of vy_read_iterator_next().
+ * @param itr   Read iterator.
+ * @param last  Statement to start after. May be a key.
+ *              The iterator takes the reference to it.
+ */
+void
+vy_read_iterator_start_after(struct vy_read_iterator *itr,
+			     struct vy_entry last);
+
 /**
  * Get the next statement with another key, or start the iterator,
  * if it wasn't started.
@@ -34,7 +34,9 @@
 
 #include "fiber.h"
 #include "fiber_cond.h"
+#include "fiber_pool.h"
 #include "fio.h"
+#include "io_ring.h"
 #include "cbus.h"
 #include "memory.h"
 #include "coio_file.h"
@@ -74,6 +76,12 @@ const char *vy_file_suffix[] = {
 /* sync run and index files very 16 MB */
 #define VY_RUN_SYNC_INTERVAL (1 << 24)
 
+/**
+ * Max number of requests handled by a reader thread concurrently
+ * if it reads files through io_uring.
+ */
+#define VY_RUN_READER_FIBER_POOL_SIZE 64
+
 /**
  * We read runs in background threads so as not to stall tx.
  * This structure represents such a thread.
@@ -85,6 +93,8 @@ struct vy_run_reader {
 	struct cpipe reader_pipe;
 	/** Pipe from the reader thread to tx. */
 	struct cpipe tx_pipe;
+	/** Read files through io_uring, see vy_run_env::use_io_uring. */
+	bool use_io_uring;
 };
 
 /** Cbus task for vinyl page read. */
@@ -124,13 +134,39 @@ static int
 vy_run_reader_f(va_list ap)
 {
 	struct vy_run_reader *reader = va_arg(ap, struct vy_run_reader *);
-	struct cbus_endpoint endpoint;
+	bool use_io_uring = reader->use_io_uring;
 
 	cpipe_create(&reader->tx_pipe, "tx_prio");
-	cbus_endpoint_create(&endpoint, cord_name(cord()),
-			     fiber_schedule_cb, fiber());
-	cbus_loop(&endpoint);
-	cbus_endpoint_destroy(&endpoint, cbus_process);
+	if (use_io_uring && io_ring_init() != 0) {
+		diag_log();
+		say_warn("%s failed to set up io_uring, "
+			 "falling back to blocking reads", cord_name(cord()));
+		use_io_uring = false;
+	}
+	/*
+	 * Requests are handled until the reader pipe is destroyed,
+	 * see vy_run_env_stop_readers(): destroying an endpoint
+	 * waits for all pipes connected to it to be destroyed.
+	 */
+	if (use_io_uring) {
+		/*
+		 * Handle each request in its own fiber so that
+		 * reads issued by different requests are submitted
+		 * to io_uring in one system call and the thread
+		 * decodes a page while others are being read.
+		 */
+		struct fiber_pool pool;
+		fiber_pool_create(&pool, cord_name(cord()),
+				  VY_RUN_READER_FIBER_POOL_SIZE,
+				  FIBER_POOL_IDLE_TIMEOUT);
+		fiber_pool_destroy(&pool);
+		io_ring_destroy();
+	} else {
+		struct cbus_endpoint endpoint;
+		cbus_endpoint_create(&endpoint, cord_name(cord()),
+				     fiber_schedule_cb, fiber());
+		cbus_endpoint_destroy(&endpoint, cbus_process);
+	}
 	cpipe_destroy(&reader->tx_pipe);
 	return 0;
 }
@@ -151,6 +187,7 @@ vy_run_env_start_readers(struct vy_run_env *env)
 		struct vy_run_reader *reader = &env->reader_pool[i];
 		char name[FIBER_NAME_MAX];
 
+		reader->use_io_uring = env->use_io_uring;
 		snprintf(name, sizeof(name), "vinyl.reader.%d", i);
 		if (cord_costart(&reader->cord, name,
 				 vy_run_reader_f, reader) != 0)
@@ -166,8 +203,10 @@ vy_run_env_stop_readers(struct vy_run_env *env)
 {
 	for (int i = 0; i < env->reader_pool_size; i++) {
 		struct vy_run_reader *reader = &env->reader_pool[i];
-		tt_pthread_cancel(reader->cord.id);
-		tt_pthread_join(reader->cord.id, NULL);
+		/* The reader exits once its pipe is destroyed. */
+		cpipe_destroy(&reader->reader_pipe);
+		if (cord_join(&reader->cord) != 0)
+			panic("failed to join vinyl reader thread");
 	}
 	free(env->reader_pool);
 }
@@ -176,10 +215,13 @@ vy_run_env_stop_readers(struct vy_run_env *env)
  * Initialize vinyl run environment
  */
 void
-vy_run_env_create(struct vy_run_env *env, int read_threads)
+vy_run_env_create(struct vy_run_env *env, int read_threads,
+		  bool use_io_uring)
 {
 	memset(env, 0, sizeof(*env));
+	rlist_create(&env->page_cache.lru);
 	env->reader_pool_size = read_threads;
+	env->use_io_uring = use_io_uring;
 	tt_pthread_key_create(&env->zdctx_key, vy_free_zdctx);
 	mempool_create(&env->read_task_pool, cord_slab_cache(),
 		       sizeof(struct vy_page_read_task));
@@ -290,9 +332,17 @@ vy_run_new(struct vy_run_env *env, int64_t id)
 	return run;
 }
 
+static void
+vy_page_cache_drop_run(struct vy_page_cache *cache, struct vy_run *run);
+
 static void
 vy_run_clear(struct vy_run *run)
 {
+	if (run->cached_pages != NULL) {
+		vy_page_cache_drop_run(&run->env->page_cache, run);
+		free(run->cached_pages);
+		run->cached_pages = NULL;
+	}
 	if (run->page_info != NULL) {
 		uint32_t page_no;
 		for (page_no = 0; page_no < run->info.page_count; ++page_no)
@@ -680,7 +730,14 @@ vy_run_info_decode(struct vy_run_info *run_info,
 				return -1;
 			break;
 		case VY_RUN_INFO_BLOOM:
-			run_info->bloom = tuple_bloom_decode(&pos);
+			run_info->bloom = tuple_bloom_decode(
+				&pos, TUPLE_BLOOM_FORMAT_CLASSIC);
+			if (run_info->bloom == NULL)
+				return -1;
+			break;
+		case VY_RUN_INFO_BLOOM_SPLIT:
+			run_info->bloom = tuple_bloom_decode(
+				&pos, TUPLE_BLOOM_FORMAT_SPLIT);
 			if (run_info->bloom == NULL)
 				return -1;
 			break;
@@ -714,6 +771,8 @@ vy_page_new(const struct vy_page_info *page_info)
 	}
 	page->unpacked_size = page_info->unpacked_size;
 	page->row_count = page_info->row_count;
+	page->refs = 1;
+	page->run = NULL;
 	page->row_index = calloc(page_info->row_count, sizeof(uint32_t));
 	if (page->row_index == NULL) {
 		diag_set(OutOfMemory, page_info->row_count * sizeof(uint32_t),
@@ -748,6 +807,134 @@ vy_page_delete(struct vy_page *page)
 	free(page);
 }
 
+static inline void
+vy_page_ref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	page->refs++;
+}
+
+static inline void
+vy_page_unref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	if (--page->refs == 0)
+		vy_page_delete(page);
+}
+
+/** Return the size of memory occupied by a page. */
+static inline size_t
+vy_page_mem_size(struct vy_page *page)
+{
+	return sizeof(*page) + page->unpacked_size +
+	       page->row_count * sizeof(page->row_index[0]);
+}
+
+/** Remove a page from the page cache. */
+static void
+vy_page_cache_evict(struct vy_page_cache *cache, struct vy_page *page)
+{
+	struct vy_run *run = page->run;
+	assert(run != NULL);
+	assert(run->cached_pages[page->page_no] == page);
+	run->cached_pages[page->page_no] = NULL;
+	page->run = NULL;
+	rlist_del_entry(page, in_lru);
+	assert(cache->mem_used >= vy_page_mem_size(page));
+	cache->mem_used -= vy_page_mem_size(page);
+	cache->stat.evict++;
+	vy_page_unref(page);
+}
+
+/** Evict least recently used pages until the cache fits in the quota. */
+static void
+vy_page_cache_shrink(struct vy_page_cache *cache)
+{
+	while (cache->mem_used > cache->mem_quota) {
+		assert(!rlist_empty(&cache->lru));
+		struct vy_page *page = rlist_last_entry(&cache->lru,
+							struct vy_page,
+							in_lru);
+		vy_page_cache_evict(cache, page);
+	}
+}
+
+/** Remove all pages of a run from the page cache. */
+static void
+vy_page_cache_drop_run(struct vy_page_cache *cache, struct vy_run *run)
+{
+	for (uint32_t i = 0; i < run->info.page_count; i++) {
+		struct vy_page *page = run->cached_pages[i];
+		if (page != NULL)
+			vy_page_cache_evict(cache, page);
+	}
+}
+
+/**
+ * Look up a page in the page cache. Returns NULL if the page
+ * isn't cached. The returned page must be unreferenced by
+ * the caller.
+ */
+static struct vy_page *
+vy_page_cache_get(struct vy_page_cache *cache, struct vy_run *run,
+		  uint32_t page_no)
+{
+	if (cache->mem_quota == 0)
+		return NULL;
+	cache->stat.lookup++;
+	if (run->cached_pages == NULL)
+		return NULL;
+	struct vy_page *page = run->cached_pages[page_no];
+	if (page == NULL)
+		return NULL;
+	cache->stat.hit++;
+	rlist_move_entry(&cache->lru, page, in_lru);
+	vy_page_ref(page);
+	return page;
+}
+
+/**
+ * Add a page read from a run file to the page cache.
+ * Failure to cache a page is not an error.
+ */
+static void
+vy_page_cache_put(struct vy_page_cache *cache, struct vy_run *run,
+		  struct vy_page *page)
+{
+	assert(page->run == NULL);
+	size_t size = vy_page_mem_size(page);
+	if (size > cache->mem_quota)
+		return;
+	if (run->cached_pages == NULL) {
+		run->cached_pages = calloc(run->info.page_count,
+					   sizeof(run->cached_pages[0]));
+		if (run->cached_pages == NULL)
+			return;
+	}
+	struct vy_page *old_page = run->cached_pages[page->page_no];
+	if (old_page != NULL) {
+		/*
+		 * The same page could have been read by another
+		 * fiber while we were waiting for disk.
+		 */
+		vy_page_cache_evict(cache, old_page);
+	}
+	run->cached_pages[page->page_no] = page;
+	page->run = run;
+	vy_page_ref(page);
+	rlist_add_entry(&cache->lru, page, in_lru);
+	cache->mem_used += size;
+	cache->stat.put++;
+	vy_page_cache_shrink(cache);
+}
+
+void
+vy_run_env_set_page_cache_quota(struct vy_run_env *env, size_t quota)
+{
+	env->page_cache.mem_quota = quota;
+	vy_page_cache_shrink(&env->page_cache);
+}
+
 static int
 vy_page_xrow(struct vy_page *page, uint32_t stmt_no,
 	     struct xrow_header *xrow)
@@ -834,9 +1021,9 @@ vy_run_iterator_stop(struct vy_run_iterator *itr)
 		itr->curr = vy_entry_none();
 	}
 	if (itr->curr_page != NULL) {
-		vy_page_delete(itr->curr_page);
+		vy_page_unref(itr->curr_page);
 		if (itr->prev_page != NULL)
-			vy_page_delete(itr->prev_page);
+			vy_page_unref(itr->prev_page);
 		itr->curr_page = itr->prev_page = NULL;
 	}
 }
@@ -899,7 +1086,10 @@ vy_page_read(struct vy_page *page, const struct vy_page_info *page_info,
 		diag_set(OutOfMemory, page_info->size, "region gc", "page");
 		return -1;
 	}
-	ssize_t readen = fio_pread(run->fd, data, page_info->size,
+	ssize_t readen = io_ring_is_enabled() ?
+			 io_ring_pread(run->fd, data, page_info->size,
+				       page_info->offset) :
+			 fio_pread(run->fd, data, page_info->size,
 				   page_info->offset);
 	ERROR_INJECT(ERRINJ_VYRUN_DATA_READ, {
 		readen = -1;
@@ -998,7 +1188,9 @@ vy_page_read_cb(struct cbus_call_msg *base)
 
 /**
  * Read a page from disk given its number.
- * The function caches two most recently read pages.
+ * The function caches two most recently read pages. Pages are
+ * also looked up in and added to the page cache shared by all
+ * run iterators, see vy_page_cache.
  *
  * @retval 0 success
  * @retval -1 critical error
@@ -1022,6 +1214,16 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		SWAP(itr->prev_page, itr->curr_page);
 		page = itr->curr_page;
 	}
+	if (page == NULL) {
+		page = vy_page_cache_get(&env->page_cache, slice->run,
+					 page_no);
+		if (page != NULL) {
+			if (itr->prev_page != NULL)
+				vy_page_unref(itr->prev_page);
+			itr->prev_page = itr->curr_page;
+			itr->curr_page = page;
+		}
+	}
 	if (page != NULL) {
 		if (key.stmt != NULL)
 			*pos_in_page = vy_page_find_key(page, key, itr->cmp_def,
@@ -1068,10 +1270,11 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 
 	/* Update cache */
 	if (itr->prev_page != NULL)
-		vy_page_delete(itr->prev_page);
+		vy_page_unref(itr->prev_page);
 	itr->prev_page = itr->curr_page;
 	itr->curr_page = page;
 	page->page_no = page_no;
+	vy_page_cache_put(&env->page_cache, slice->run, page);
 
 	/* Update read statistics. */
 	itr->stat->read.rows += page_info->row_count;
@@ -1966,6 +2169,18 @@ vy_stmt_stat_encode(const struct vy_stmt_stat *stat, char *buf)
 	return buf;
 }
 
+/**
+ * Return the key a bloom filter is stored under in run info.
+ * Old versions ignore unknown keys, so they just don't use split
+ * block bloom filters of the runs written by new versions.
+ */
+static enum vy_run_info_key
+vy_run_info_bloom_key(const struct tuple_bloom *bloom)
+{
+	return bloom->format == TUPLE_BLOOM_FORMAT_SPLIT ?
+	       VY_RUN_INFO_BLOOM_SPLIT : VY_RUN_INFO_BLOOM;
+}
+
 /**
  * Encode vy_run_info as xrow
  * Allocates using region alloc
@@ -2001,9 +2216,10 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 		mp_sizeof_uint(run_info->max_lsn);
 	size += mp_sizeof_uint(VY_RUN_INFO_PAGE_COUNT) +
 		mp_sizeof_uint(run_info->page_count);
-	if (run_info->bloom != NULL)
-		size += mp_sizeof_uint(VY_RUN_INFO_BLOOM) +
-			tuple_bloom_size(run_info->bloom);
+	if (run_info->bloom != NULL) {
+		size += mp_sizeof_uint(vy_run_info_bloom_key(run_info->bloom));
+		size += tuple_bloom_size(run_info->bloom);
+	}
 	size += mp_sizeof_uint(VY_RUN_INFO_STMT_STAT) +
 		vy_stmt_stat_sizeof(&run_info->stmt_stat);
 
@@ -2029,7 +2245,8 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	pos = mp_encode_uint(pos, VY_RUN_INFO_PAGE_COUNT);
 	pos = mp_encode_uint(pos, run_info->page_count);
 	if (run_info->bloom != NULL) {
-		pos = mp_encode_uint(pos, VY_RUN_INFO_BLOOM);
+		pos = mp_encode_uint(pos,
+				     vy_run_info_bloom_key(run_info->bloom));
 		pos = tuple_bloom_encode(run_info->bloom, pos);
 	}
 	pos = mp_encode_uint(pos, VY_RUN_INFO_STMT_STAT);
@@ -52,6 +52,35 @@ extern "C" {
 struct vy_history;
 struct vy_run_reader;
 
+/** Page cache statistics. */
+struct vy_page_cache_stat {
+	/** Number of lookups in the cache. */
+	int64_t lookup;
+	/** Number of lookups that found a page in the cache. */
+	int64_t hit;
+	/** Number of pages added to the cache. */
+	int64_t put;
+	/** Number of pages evicted from the cache. */
+	int64_t evict;
+};
+
+/**
+ * Cache of decompressed run pages shared by all LSM trees.
+ * Pages are looked up by run and page number and evicted in
+ * LRU order when the cache size exceeds the configured quota.
+ * Accessed only from the tx thread.
+ */
+struct vy_page_cache {
+	/** Cached pages, the most recently used first. */
+	struct rlist lru;
+	/** Size of memory occupied by cached pages. */
+	size_t mem_used;
+	/** Max memory size that can be used for cached pages. */
+	size_t mem_quota;
+	/** Cache statistics. */
+	struct vy_page_cache_stat stat;
+};
+
 /** Part of vinyl environment for run read/write */
 struct vy_run_env {
 	/** Write rate limit, in bytes per second. */
@@ -60,6 +89,8 @@ struct vy_run_env {
 	struct mempool read_task_pool;
 	/** Key for thread-local ZSTD context */
 	pthread_key_t zdctx_key;
+	/** Cache of pages read from run files. */
+	struct vy_page_cache page_cache;
 	/** Pool of threads used for reading run files. */
 	struct vy_run_reader *reader_pool;
 	/** Number of threads in the reader pool. */
@@ -69,6 +100,11 @@ struct vy_run_env {
 	 * processing the next read request.
 	 */
 	int next_reader;
+	/**
+	 * If set, reader threads read run files through io_uring
+	 * and handle each request in a separate fiber.
+	 */
+	bool use_io_uring;
 	/**
 	 * We need this flag during compaction in order to determine we can
 	 * unconditionally remove unused runs' files in-place.
@@ -126,6 +162,11 @@ struct vy_run {
 	struct vy_run_info info;
 	/** Info about the run pages stored in the index file. */
 	struct vy_page_info *page_info;
+	/**
+	 * Pages of this run stored in the page cache, indexed by
+	 * page number. Allocated on demand, see vy_page_cache.
+	 */
+	struct vy_page **cached_pages;
 	/** Run data file. */
 	int fd;
 	/** Unique ID of this run. */
@@ -302,6 +343,18 @@ struct vy_page {
 	uint32_t *row_index;
 	/** Pointer to the page data. */
 	char *data;
+	/**
+	 * Number of references to the page. A page is referenced
+	 * by each run iterator that keeps it and by the page cache.
+	 */
+	int refs;
+	/**
+	 * Run the page belongs to if the page is stored in
+	 * the page cache, NULL otherwise.
+	 */
+	struct vy_run *run;
+	/** Link in vy_page_cache::lru. */
+	struct rlist in_lru;
 };
 
 /**
@@ -310,9 +363,12 @@ struct vy_page {
  * @param read_threads - max number of background threads to
  * use for disk reads; note background threads are not used
  * until vy_run_env_enable_coio() is called.
+ * @param use_io_uring - read files through io_uring in
+ * background threads, if supported.
  */
 void
-vy_run_env_create(struct vy_run_env *env, int read_threads);
+vy_run_env_create(struct vy_run_env *env, int read_threads,
+		  bool use_io_uring);
 
 /**
  * Destroy vinyl run environment
@@ -335,6 +391,13 @@ vy_run_env_destroy(struct vy_run_env *env);
 void
 vy_run_env_enable_coio(struct vy_run_env *env);
 
+/**
+ * Set the max size of memory that can be used for caching
+ * run pages. Evicts pages from the cache if necessary.
+ */
+void
+vy_run_env_set_page_cache_quota(struct vy_run_env *env, size_t quota);
+
 /**
  * Return the size of a run bloom filter.
  */
@@ -30,8 +30,13 @@
  */
 #include "wal.h"
 
+#include <dirent.h>
+#include <sys/stat.h>
+#include <tarantool_eio.h>
+
 #include "fiber.h"
 #include "fio.h"
+#include "io_ring.h"
 #include "errinj.h"
 #include "error.h"
 #include "exception.h"
@@ -42,6 +47,13 @@
 #include "cbus.h"
 #include "coio_task.h"
 #include "replication.h"
+#include "tt_pthread.h"
+#include "bit/bit.h"
+#include "info/info.h"
+#include "tt_static.h"
+
+/** Suffix of spare WAL files, appended to the WAL file name. */
+static const char wal_spare_suffix[] = ".spare";
 
 enum {
 	/**
@@ -75,6 +87,78 @@ wal_write_none_async(struct journal *, struct journal_entry *);
 static int
 wal_write_none(struct journal *, struct journal_entry *);
 
+/**
+ * A batch of rows appended to the in-memory WAL tail by a single
+ * WAL write. Rows are stored encoded, each prefixed with a fixheader,
+ * exactly as they are sent over the network.
+ */
+struct wal_tail_batch {
+	/** Link in wal_tail::batches. */
+	struct rlist in_tail;
+	/** Sequence number of the batch in the tail. */
+	int64_t seq;
+	/**
+	 * Number of references to the batch. The tail holds one
+	 * until the batch is evicted, a reader holds one while
+	 * it is processing the rows stored in the batch.
+	 */
+	int refs;
+	/** WAL vclock after writing the batch. */
+	struct vclock vclock;
+	/** Size of the encoded rows. */
+	size_t size;
+	/** Encoded rows. */
+	char data[0];
+};
+
+/**
+ * Bounded in-memory tail of the WAL. Batches are appended by
+ * the WAL thread and read by relay threads so all members are
+ * protected by the mutex.
+ */
+struct wal_tail {
+	pthread_mutex_t mutex;
+	/** Batches, from the oldest to the newest. */
+	struct rlist batches;
+	/** Total size of the stored batches. */
+	size_t size;
+	/** Max total size of the stored batches, 0 if disabled. */
+	size_t max_size;
+	/** Sequence number to assign to the next batch. */
+	int64_t next_seq;
+	/**
+	 * WAL vclock preceding the oldest row stored in the tail.
+	 * All rows written after it are stored in the tail.
+	 */
+	struct vclock vclock;
+	/**
+	 * Set if the vclock is valid. Cleared when the tail is
+	 * disabled, set again on the next append.
+	 */
+	bool is_valid;
+};
+
+enum {
+	/**
+	 * Number of buckets in the commit group size histogram.
+	 * Bucket i counts groups of [2^i, 2^(i+1)) entries, the
+	 * last one counts all larger groups.
+	 */
+	WAL_STAT_GROUP_SIZE_BUCKETS = 16,
+};
+
+/** WAL writer statistics. */
+struct wal_stat {
+	/** Number of commit groups written to disk. */
+	int64_t writes;
+	/** Number of journal entries written to disk. */
+	int64_t entries;
+	/** Histogram of commit group sizes, in entries. */
+	int64_t group_size[WAL_STAT_GROUP_SIZE_BUCKETS];
+	/** Total time spent writing and syncing commit groups. */
+	double write_time;
+};
+
 /*
  * WAL writer - maintain a Write Ahead Log for every change
  * in the data state.
@@ -112,6 +196,8 @@ struct wal_writer
 	int64_t wal_max_size;
 	/** Another one - wal_mode */
 	enum wal_mode wal_mode;
+	/** Write files through io_uring. */
+	bool use_io_uring;
 	/** wal_dir, from the configuration file. */
 	struct xdir wal_dir;
 	/** 'wal' thread doing the writes. */
@@ -170,6 +256,72 @@ struct wal_writer
 	 * Used for replication relays.
 	 */
 	struct rlist watchers;
+	/**
+	 * In-memory tail of the WAL. Relays that have caught up
+	 * with the writer stream new rows from it rather than
+	 * re-read them from the current WAL file.
+	 */
+	struct wal_tail tail;
+	/**
+	 * Write requests received from TX and not written yet.
+	 * They are written and synced to disk in one go, see
+	 * wal_write_commit_group().
+	 */
+	struct stailq commit_group;
+	/** Number of journal entries in the commit group. */
+	int commit_group_entries;
+	/** Approximate size of the commit group when encoded. */
+	size_t commit_group_len;
+	/** Time when the first request joined the commit group. */
+	double commit_group_start;
+	/**
+	 * A setting from instance configuration - wal_commit_delay.
+	 * Max time a request may wait for other requests to join
+	 * the commit group.
+	 */
+	double commit_delay;
+	/**
+	 * A setting from instance configuration - wal_commit_min_batch.
+	 * Once the commit group has this many entries, it's written
+	 * without waiting. 0 means no limit.
+	 */
+	int commit_min_batch;
+	/**
+	 * Moving average of the time it takes to write and sync
+	 * a commit group. In the fsync mode, the commit delay never
+	 * exceeds it.
+	 */
+	double write_time_avg;
+	/** WAL write statistics, see box.stat.wal(). */
+	struct wal_stat stat;
+	/**
+	 * A setting from instance configuration -
+	 * wal_recycle_segments. Max number of spare WAL files.
+	 */
+	int recycle_max;
+	/** Spare WAL files ready for reuse, see struct wal_spare. */
+	struct stailq spares;
+	/** Number of files in the spare list. */
+	int spare_count;
+	/** Number of files being prepared for reuse. */
+	int spare_pending;
+};
+
+/**
+ * A garbage collected WAL file that is zero-filled to the full
+ * WAL size and kept for reuse as a new WAL file. Appends to such
+ * a file never change its size, so syncing it doesn't involve
+ * file system metadata updates.
+ */
+struct wal_spare {
+	/** Link in wal_writer::spares. */
+	struct stailq_entry in_spares;
+	/** Path of the spare file. */
+	char path[PATH_MAX];
+	/** Path of the WAL file the spare is made of. */
+	char src_path[PATH_MAX];
+	/** Min size of the spare file. */
+	off_t size;
 };
 
 struct wal_msg {
@@ -210,14 +362,256 @@ wal_dir(void)
 	return wal_writer_singleton.wal_dir.dirname;
 }
 
+static void
+wal_tail_create(struct wal_tail *tail)
+{
+	tt_pthread_mutex_init(&tail->mutex, NULL);
+	rlist_create(&tail->batches);
+	tail->size = 0;
+	tail->max_size = 0;
+	tail->next_seq = 0;
+	vclock_create(&tail->vclock);
+	tail->is_valid = false;
+}
+
+/** Drop a reference to a batch. Called under the tail mutex. */
+static void
+wal_tail_batch_unref(struct wal_tail_batch *batch)
+{
+	assert(batch->refs > 0);
+	if (--batch->refs == 0)
+		free(batch);
+}
+
+/**
+ * Evict the oldest batches from the tail until its size fits
+ * in the given limit. Called under the tail mutex.
+ */
+static void
+wal_tail_evict(struct wal_tail *tail, size_t max_size)
+{
+	while (tail->size > max_size) {
+		assert(!rlist_empty(&tail->batches));
+		struct wal_tail_batch *batch = rlist_first_entry(
+			&tail->batches, struct wal_tail_batch, in_tail);
+		rlist_del_entry(batch, in_tail);
+		tail->size -= batch->size;
+		vclock_copy(&tail->vclock, &batch->vclock);
+		wal_tail_batch_unref(batch);
+	}
+}
+
+static void
+wal_tail_destroy(struct wal_tail *tail)
+{
+	/*
+	 * Batches pinned by readers are freed when unreferenced
+	 * so the mutex is left intact.
+	 */
+	tt_pthread_mutex_lock(&tail->mutex);
+	wal_tail_evict(tail, 0);
+	tail->is_valid = false;
+	tt_pthread_mutex_unlock(&tail->mutex);
+}
+
+/**
+ * Append rows of the journal entries committed by the given
+ * WAL messages to the tail. @vclock_begin is the WAL vclock
+ * before the entries were written, @vclock_end is the vclock
+ * after that.
+ */
+static void
+wal_tail_append(struct wal_tail *tail, struct stailq *msgs,
+		const struct vclock *vclock_begin,
+		const struct vclock *vclock_end)
+{
+	tt_pthread_mutex_lock(&tail->mutex);
+	size_t max_size = tail->max_size;
+	tt_pthread_mutex_unlock(&tail->mutex);
+	if (max_size == 0)
+		return;
+
+	struct region *region = &fiber()->gc;
+	struct wal_msg *msg;
+	struct journal_entry *entry;
+	int row_count = 0;
+	stailq_foreach_entry(msg, msgs, base.fifo) {
+		stailq_foreach_entry(entry, &msg->commit, fifo)
+			row_count += entry->n_rows;
+	}
+	if (row_count == 0)
+		return;
+	size_t iov_size;
+	struct iovec *iov = region_alloc_array(region, typeof(iov[0]),
+					       row_count * XROW_IOVMAX,
+					       &iov_size);
+	if (iov == NULL) {
+		diag_set(OutOfMemory, iov_size, "region_alloc_array", "iov");
+		goto fail;
+	}
+	int iovcnt = 0;
+	size_t size = 0;
+	stailq_foreach_entry(msg, msgs, base.fifo) {
+		stailq_foreach_entry(entry, &msg->commit, fifo) {
+			for (int i = 0; i < entry->n_rows; i++) {
+				int rc = xrow_to_iovec(entry->rows[i],
+						       iov + iovcnt);
+				if (rc < 0)
+					goto fail;
+				for (int j = iovcnt; j < iovcnt + rc; j++)
+					size += iov[j].iov_len;
+				iovcnt += rc;
+			}
+		}
+	}
+	struct wal_tail_batch *batch = NULL;
+	if (size <= max_size) {
+		batch = malloc(sizeof(*batch) + size);
+		if (batch == NULL) {
+			diag_set(OutOfMemory, sizeof(*batch) + size,
+				 "malloc", "struct wal_tail_batch");
+			goto fail;
+		}
+		char *data = batch->data;
+		for (int i = 0; i < iovcnt; i++) {
+			memcpy(data, iov[i].iov_base, iov[i].iov_len);
+			data += iov[i].iov_len;
+		}
+		batch->refs = 1;
+		batch->size = size;
+		vclock_copy(&batch->vclock, vclock_end);
+	}
+	tt_pthread_mutex_lock(&tail->mutex);
+	if (!tail->is_valid) {
+		vclock_copy(&tail->vclock, vclock_begin);
+		tail->is_valid = true;
+	}
+	if (batch != NULL) {
+		batch->seq = tail->next_seq++;
+		rlist_add_tail_entry(&tail->batches, batch, in_tail);
+		tail->size += size;
+		wal_tail_evict(tail, tail->max_size);
+	} else {
+		/* The batch doesn't fit, skip it. */
+		wal_tail_evict(tail, 0);
+		vclock_copy(&tail->vclock, vclock_end);
+	}
+	tt_pthread_mutex_unlock(&tail->mutex);
+	return;
+fail:
+	/*
+	 * The tail must not have gaps so drop it. Relays will
+	 * fall back on reading xlog files.
+	 */
+	diag_log();
+	diag_clear(diag_get());
+	tt_pthread_mutex_lock(&tail->mutex);
+	wal_tail_evict(tail, 0);
+	tail->is_valid = false;
+	tt_pthread_mutex_unlock(&tail->mutex);
+}
+
+void
+wal_set_tail_size(int64_t size)
+{
+	struct wal_tail *tail = &wal_writer_singleton.tail;
+	tt_pthread_mutex_lock(&tail->mutex);
+	tail->max_size = size;
+	wal_tail_evict(tail, size);
+	if (size == 0)
+		tail->is_valid = false;
+	tt_pthread_mutex_unlock(&tail->mutex);
+}
+
+int
+wal_tail_cursor_create(struct wal_tail_cursor *cursor,
+		       const struct vclock *vclock)
+{
+	struct wal_tail *tail = &wal_writer_singleton.tail;
+	cursor->batch = NULL;
+	tt_pthread_mutex_lock(&tail->mutex);
+	int cmp = vclock_compare(&tail->vclock, vclock);
+	if (!tail->is_valid || cmp > 0 || cmp == VCLOCK_ORDER_UNDEFINED) {
+		tt_pthread_mutex_unlock(&tail->mutex);
+		return 1;
+	}
+	/* Skip batches that don't have any rows past the vclock. */
+	cursor->seq = tail->next_seq;
+	struct wal_tail_batch *batch;
+	rlist_foreach_entry(batch, &tail->batches, in_tail) {
+		cmp = vclock_compare(&batch->vclock, vclock);
+		if (cmp > 0 || cmp == VCLOCK_ORDER_UNDEFINED) {
+			cursor->seq = batch->seq;
+			break;
+		}
+	}
+	tt_pthread_mutex_unlock(&tail->mutex);
+	return 0;
+}
+
+int
+wal_tail_cursor_next(struct wal_tail_cursor *cursor,
+		     const char **data, const char **data_end)
+{
+	struct wal_tail *tail = &wal_writer_singleton.tail;
+	int rc = 0;
+	*data = *data_end = NULL;
+	tt_pthread_mutex_lock(&tail->mutex);
+	if (cursor->batch != NULL) {
+		wal_tail_batch_unref(cursor->batch);
+		cursor->batch = NULL;
+	}
+	struct wal_tail_batch *batch;
+	/* Readers are usually close to the newest batch. */
+	rlist_foreach_entry_reverse(batch, &tail->batches, in_tail) {
+		if (batch->seq > cursor->seq)
+			continue;
+		if (batch->seq == cursor->seq) {
+			batch->refs++;
+			cursor->batch = batch;
+			cursor->seq++;
+			*data = batch->data;
+			*data_end = batch->data + batch->size;
+		}
+		break;
+	}
+	if (cursor->batch == NULL && cursor->seq < tail->next_seq)
+		rc = 1; /* The batch has been evicted. */
+	tt_pthread_mutex_unlock(&tail->mutex);
+	return rc;
+}
+
+void
+wal_tail_cursor_destroy(struct wal_tail_cursor *cursor)
+{
+	struct wal_tail *tail = &wal_writer_singleton.tail;
+	if (cursor->batch == NULL)
+		return;
+	tt_pthread_mutex_lock(&tail->mutex);
+	wal_tail_batch_unref(cursor->batch);
+	tt_pthread_mutex_unlock(&tail->mutex);
+	cursor->batch = NULL;
+}
+
 static void
 wal_write_to_disk(struct cmsg *msg);
 
+static void
+wal_write_commit_group(struct wal_writer *writer);
+
 static void
 tx_complete_batch(struct cmsg *msg);
 
+/**
+ * A request is queued to the commit group by the WAL thread.
+ * Once the group is written, it's sent back to TX by the
+ * response route.
+ */
 static struct cmsg_hop wal_request_route[] = {
-	{wal_write_to_disk, &wal_writer_singleton.tx_prio_pipe},
+	{wal_write_to_disk, NULL},
+};
+
+static struct cmsg_hop wal_response_route[] = {
 	{tx_complete_batch, NULL},
 };
 
@@ -320,6 +714,8 @@ static void
 wal_complete_rollback(struct cmsg *base)
 {
 	(void) base;
+	/* Requests queued before this message must be rolled back. */
+	wal_write_commit_group(&wal_writer_singleton);
 	/* WAL-thread can try writing transactions again. */
 	wal_writer_singleton.is_in_rollback = false;
 }
@@ -406,6 +802,211 @@ tx_notify_checkpoint(struct cmsg *msg)
 	free(msg);
 }
 
+/* {{{ Spare WAL files */
+
+/**
+ * Make a spare file of a garbage collected WAL file: rename it,
+ * overwrite it with zeros up to the required size, and sync it.
+ * Runs in a coio thread. The file is renamed to a temporary name
+ * first so that a partially filled file is removed on restart.
+ */
+static void
+wal_spare_prepare_f(eio_req *req)
+{
+	struct wal_spare *spare = (struct wal_spare *)req->data;
+	static const char zeros[64 * 1024];
+	char tmp_path[PATH_MAX];
+	snprintf(tmp_path, sizeof(tmp_path), "%s%s", spare->path,
+		 inprogress_suffix);
+	struct stat st;
+	int fd = -1;
+	req->result = -1;
+	if (rename(spare->src_path, tmp_path) != 0)
+		goto error;
+	fd = open(tmp_path, O_WRONLY);
+	if (fd < 0)
+		goto error_unlink;
+	if (fstat(fd, &st) != 0)
+		goto error_close;
+	off_t size = MAX(st.st_size, spare->size);
+	for (off_t pos = 0; pos < size; ) {
+		size_t len = MIN(size - pos, (off_t)sizeof(zeros));
+		ssize_t rc = pwrite(fd, zeros, len, pos);
+		if (rc < 0)
+			goto error_close;
+		pos += rc;
+	}
+	if (fdatasync(fd) != 0)
+		goto error_close;
+	if (close(fd) != 0 || rename(tmp_path, spare->path) != 0)
+		goto error_unlink;
+	req->result = 0;
+	return;
+error_close:
+	req->errorno = errno;
+	close(fd);
+	unlink(tmp_path);
+	return;
+error_unlink:
+	req->errorno = errno;
+	unlink(tmp_path);
+	return;
+error:
+	req->errorno = errno;
+}
+
+static int
+wal_spare_prepare_complete(eio_req *req)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_spare *spare = (struct wal_spare *)req->data;
+	assert(writer->spare_pending > 0);
+	writer->spare_pending--;
+	if (req->result != 0) {
+		errno = req->errorno;
+		say_syserror("failed to recycle %s", spare->src_path);
+		free(spare);
+		return 0;
+	}
+	say_info("recycled %s", spare->src_path);
+	if (writer->spare_count >= writer->recycle_max) {
+		/* The limit was lowered while the file was prepared. */
+		if (unlink(spare->path) != 0)
+			say_syserror("error while removing %s", spare->path);
+		free(spare);
+		return 0;
+	}
+	stailq_add_tail_entry(&writer->spares, spare, in_spares);
+	writer->spare_count++;
+	return 0;
+}
+
+/**
+ * Instead of removing WAL files older than the given signature,
+ * turn them into spare files, while the number of spare files
+ * is less than the configured limit.
+ */
+static void
+wal_recycle_garbage(struct wal_writer *writer, int64_t signature)
+{
+	struct xdir *dir = &writer->wal_dir;
+	struct vclock *vclock;
+	while (writer->spare_count + writer->spare_pending <
+	       writer->recycle_max &&
+	       (vclock = vclockset_first(&dir->index)) != NULL &&
+	       vclock_sum(vclock) < signature) {
+		struct wal_spare *spare = malloc(sizeof(*spare));
+		if (spare == NULL) {
+			say_warn("failed to allocate spare WAL file");
+			return;
+		}
+		const char *filename = xdir_format_filename(
+			dir, vclock_sum(vclock), NONE);
+		snprintf(spare->src_path, sizeof(spare->src_path), "%s",
+			 filename);
+		snprintf(spare->path, sizeof(spare->path), "%s%s",
+			 filename, wal_spare_suffix);
+		spare->size = writer->wal_max_size;
+		vclockset_remove(&dir->index, vclock);
+		free(vclock);
+		writer->spare_pending++;
+		eio_custom(wal_spare_prepare_f, EIO_PRI_DEFAULT,
+			   wal_spare_prepare_complete, spare);
+	}
+}
+
+/** Remove spare files exceeding the configured limit. */
+static void
+wal_trim_spares(struct wal_writer *writer)
+{
+	while (writer->spare_count > writer->recycle_max) {
+		struct wal_spare *spare = stailq_shift_entry(
+			&writer->spares, struct wal_spare, in_spares);
+		writer->spare_count--;
+		if (unlink(spare->path) != 0)
+			say_syserror("error while removing %s", spare->path);
+		else
+			say_info("removed %s", spare->path);
+		free(spare);
+	}
+}
+
+/**
+ * Create a new WAL file, reusing a spare file if there is one.
+ */
+static int
+wal_create_xlog(struct wal_writer *writer)
+{
+	if (!stailq_empty(&writer->spares)) {
+		struct wal_spare *spare = stailq_shift_entry(
+			&writer->spares, struct wal_spare, in_spares);
+		writer->spare_count--;
+		int rc = xdir_create_xlog_preallocated(&writer->wal_dir,
+						       &writer->current_wal,
+						       &writer->vclock,
+						       spare->path);
+		if (rc != 0) {
+			diag_log();
+			say_warn("failed to reuse %s, creating a new WAL file",
+				 spare->path);
+			diag_clear(diag_get());
+		}
+		free(spare);
+		if (rc == 0)
+			return 0;
+	}
+	return xdir_create_xlog(&writer->wal_dir, &writer->current_wal,
+				&writer->vclock);
+}
+
+/**
+ * Collect spare files left in the WAL directory since the last
+ * run. Files that were being prepared are removed.
+ */
+static void
+wal_scan_spares(struct wal_writer *writer)
+{
+	const char *dirname = writer->wal_dir.dirname;
+	DIR *dh = opendir(dirname);
+	if (dh == NULL) {
+		if (errno != ENOENT)
+			say_syserror("error reading directory '%s'", dirname);
+		return;
+	}
+	char spare_ext[16];
+	snprintf(spare_ext, sizeof(spare_ext), "%s%s",
+		 writer->wal_dir.filename_ext, wal_spare_suffix);
+	struct dirent *dent;
+	while ((dent = readdir(dh)) != NULL) {
+		char *ext = strchr(dent->d_name, '.');
+		if (ext == NULL || strncmp(ext, spare_ext,
+					   strlen(spare_ext)) != 0)
+			continue;
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/%s", dirname, dent->d_name);
+		if (strcmp(ext + strlen(spare_ext), inprogress_suffix) == 0) {
+			if (unlink(path) < 0)
+				say_syserror("error while removing %s", path);
+			continue;
+		}
+		if (ext[strlen(spare_ext)] != '\0')
+			continue;
+		struct wal_spare *spare = malloc(sizeof(*spare));
+		if (spare == NULL) {
+			say_warn("failed to allocate spare WAL file");
+			break;
+		}
+		snprintf(spare->path, sizeof(spare->path), "%s", path);
+		spare->src_path[0] = '\0';
+		spare->size = 0;
+		stailq_add_tail_entry(&writer->spares, spare, in_spares);
+		writer->spare_count++;
+	}
+	closedir(dh);
+}
+
+/* }}} Spare WAL files */
+
 /**
  * Initialize WAL writer context. Even though it's a singleton,
  * encapsulate the details just in case we may use
@@ -414,12 +1015,13 @@ tx_notify_checkpoint(struct cmsg *msg)
 static void
 wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 		  const char *wal_dirname, int64_t wal_max_size,
-		  const struct tt_uuid *instance_uuid,
+		  const struct tt_uuid *instance_uuid, bool use_io_uring,
 		  wal_on_garbage_collection_f on_garbage_collection,
 		  wal_on_checkpoint_threshold_f on_checkpoint_threshold)
 {
 	writer->wal_mode = wal_mode;
 	writer->wal_max_size = wal_max_size;
+	writer->use_io_uring = use_io_uring;
 
 	journal_create(&writer->base,
 		       wal_mode == WAL_NONE ?
@@ -431,12 +1033,26 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 	opts.sync_is_async = true;
 	xdir_create(&writer->wal_dir, wal_dirname, XLOG, instance_uuid, &opts);
 	xlog_clear(&writer->current_wal);
-	if (wal_mode == WAL_FSYNC)
-		writer->wal_dir.open_wflags |= O_SYNC;
 
 	stailq_create(&writer->rollback);
 	writer->is_in_rollback = false;
 
+	stailq_create(&writer->commit_group);
+	writer->commit_group_entries = 0;
+	writer->commit_group_len = 0;
+	writer->commit_group_start = 0;
+	writer->commit_delay = 0;
+	writer->commit_min_batch = 0;
+	writer->write_time_avg = 0;
+	memset(&writer->stat, 0, sizeof(writer->stat));
+
+	writer->recycle_max = 0;
+	stailq_create(&writer->spares);
+	writer->spare_count = 0;
+	writer->spare_pending = 0;
+	if (wal_mode != WAL_NONE)
+		wal_scan_spares(writer);
+
 	writer->checkpoint_wal_size = 0;
 	writer->checkpoint_threshold = INT64_MAX;
 	writer->checkpoint_triggered = false;
@@ -450,12 +1066,17 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 
 	mempool_create(&writer->msg_pool, &cord()->slabc,
 		       sizeof(struct wal_msg));
+	wal_tail_create(&writer->tail);
 }
 
 /** Destroy a WAL writer structure. */
 static void
 wal_writer_destroy(struct wal_writer *writer)
 {
+	struct wal_spare *spare, *tmp;
+	stailq_foreach_entry_safe(spare, tmp, &writer->spares, in_spares)
+		free(spare);
+	wal_tail_destroy(&writer->tail);
 	xdir_destroy(&writer->wal_dir);
 }
 
@@ -535,13 +1156,14 @@ wal_open(struct wal_writer *writer)
 int
 wal_init(enum wal_mode wal_mode, const char *wal_dirname,
 	 int64_t wal_max_size, const struct tt_uuid *instance_uuid,
+	 bool use_io_uring,
 	 wal_on_garbage_collection_f on_garbage_collection,
 	 wal_on_checkpoint_threshold_f on_checkpoint_threshold)
 {
 	/* Initialize the state. */
 	struct wal_writer *writer = &wal_writer_singleton;
 	wal_writer_create(writer, wal_mode, wal_dirname, wal_max_size,
-			  instance_uuid, on_garbage_collection,
+			  instance_uuid, use_io_uring, on_garbage_collection,
 			  on_checkpoint_threshold);
 
 	/* Start WAL thread. */
@@ -604,6 +1226,7 @@ wal_sync_f(struct cbus_call_msg *data)
 {
 	struct wal_vclock_msg *msg = (struct wal_vclock_msg *) data;
 	struct wal_writer *writer = &wal_writer_singleton;
+	wal_write_commit_group(writer);
 	if (writer->is_in_rollback) {
 		/* We're rolling back a failed write. */
 		diag_set(ClientError, ER_CASCADE_ROLLBACK);
@@ -647,6 +1270,7 @@ wal_begin_checkpoint_f(struct cbus_call_msg *data)
 {
 	struct wal_checkpoint *msg = (struct wal_checkpoint *) data;
 	struct wal_writer *writer = &wal_writer_singleton;
+	wal_write_commit_group(writer);
 	if (writer->is_in_rollback) {
 		/*
 		 * We're rolling back a failed write and so
@@ -771,6 +1395,142 @@ wal_set_checkpoint_threshold(int64_t threshold)
 	fiber_set_cancellable(cancellable);
 }
 
+struct wal_set_commit_group_msg {
+	struct cbus_call_msg base;
+	double commit_delay;
+	int commit_min_batch;
+};
+
+static int
+wal_set_commit_delay_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_set_commit_group_msg *msg;
+	msg = (struct wal_set_commit_group_msg *)data;
+	writer->commit_delay = msg->commit_delay;
+	return 0;
+}
+
+void
+wal_set_commit_delay(double delay)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_set_commit_group_msg msg;
+	msg.commit_delay = delay;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+		  &msg.base, wal_set_commit_delay_f, NULL,
+		  TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+static int
+wal_set_commit_min_batch_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_set_commit_group_msg *msg;
+	msg = (struct wal_set_commit_group_msg *)data;
+	writer->commit_min_batch = msg->commit_min_batch;
+	return 0;
+}
+
+void
+wal_set_commit_min_batch(int min_batch)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_set_commit_group_msg msg;
+	msg.commit_min_batch = min_batch;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+		  &msg.base, wal_set_commit_min_batch_f, NULL,
+		  TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+struct wal_set_recycle_segments_msg {
+	struct cbus_call_msg base;
+	int recycle_max;
+};
+
+static int
+wal_set_recycle_segments_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_set_recycle_segments_msg *msg;
+	msg = (struct wal_set_recycle_segments_msg *)data;
+	writer->recycle_max = msg->recycle_max;
+	wal_trim_spares(writer);
+	return 0;
+}
+
+void
+wal_set_recycle_segments(int count)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_set_recycle_segments_msg msg;
+	msg.recycle_max = count;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+		  &msg.base, wal_set_recycle_segments_f, NULL,
+		  TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+struct wal_stat_msg {
+	struct cbus_call_msg base;
+	struct wal_stat stat;
+	double write_time_avg;
+};
+
+static int
+wal_get_stat_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_stat_msg *msg = (struct wal_stat_msg *)data;
+	msg->stat = writer->stat;
+	msg->write_time_avg = writer->write_time_avg;
+	return 0;
+}
+
+void
+wal_stat_info(struct info_handler *h)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_stat_msg msg;
+	memset(&msg.stat, 0, sizeof(msg.stat));
+	msg.write_time_avg = 0;
+	if (writer->wal_mode != WAL_NONE) {
+		bool cancellable = fiber_set_cancellable(false);
+		cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+			  &msg.base, wal_get_stat_f, NULL, TIMEOUT_INFINITY);
+		fiber_set_cancellable(cancellable);
+	}
+	struct wal_stat *stat = &msg.stat;
+	info_begin(h);
+	info_append_int(h, "writes", stat->writes);
+	info_append_int(h, "entries", stat->entries);
+	info_append_double(h, "write_time", stat->write_time);
+	info_append_double(h, "write_time_avg", msg.write_time_avg);
+	/*
+	 * The key of a histogram bucket is the min number of
+	 * entries in a commit group accounted in it.
+	 */
+	info_table_begin(h, "group_size");
+	for (int i = 0; i < WAL_STAT_GROUP_SIZE_BUCKETS; i++) {
+		if (stat->group_size[i] != 0)
+			info_append_int(h, tt_sprintf("%d", 1 << i),
+					stat->group_size[i]);
+	}
+	info_table_end(h);
+	info_end(h);
+}
+
 void
 wal_set_queue_max_size(int64_t size)
 {
@@ -804,9 +1564,11 @@ wal_collect_garbage_f(struct cbus_call_msg *data)
 		 */
 		vclock = vclockset_psearch(&writer->wal_dir.index, vclock);
 	}
-	if (vclock != NULL)
+	if (vclock != NULL) {
+		wal_recycle_garbage(writer, vclock_sum(vclock));
 		xdir_collect_garbage(&writer->wal_dir, vclock_sum(vclock),
 				     XDIR_GC_ASYNC);
+	}
 
 	return 0;
 }
@@ -862,8 +1624,7 @@ wal_opt_rotate(struct wal_writer *writer)
 	if (xlog_is_open(&writer->current_wal))
 		return 0;
 
-	if (xdir_create_xlog(&writer->wal_dir, &writer->current_wal,
-			     &writer->vclock) != 0)
+	if (wal_create_xlog(writer) != 0)
 		return -1;
 	/*
 	 * Keep track of the new WAL vclock. Required for garbage
@@ -1031,25 +1792,115 @@ wal_assign_lsn(struct vclock *vclock_diff, struct vclock *base,
 		(*row)->tsn = tsn;
 }
 
+/**
+ * Queue a batch of write requests received from TX to the commit
+ * group. The group is written by the WAL writer main loop once
+ * there are no more messages to process and the commit delay
+ * expires, see wal_commit_group_timeout().
+ */
 static void
 wal_write_to_disk(struct cmsg *msg)
 {
 	struct wal_writer *writer = &wal_writer_singleton;
 	struct wal_msg *wal_msg = (struct wal_msg *) msg;
+	struct journal_entry *entry;
+	if (stailq_empty(&wal_msg->commit))
+		panic("Attempted to write an empty batch to WAL");
+
+	if (stailq_empty(&writer->commit_group))
+		writer->commit_group_start = ev_monotonic_now(loop());
+	stailq_foreach_entry(entry, &wal_msg->commit, fifo)
+		writer->commit_group_entries++;
+	writer->commit_group_len += wal_msg->approx_len;
+	/*
+	 * Sic: the message is still linked in the cbus output
+	 * list, but cbus_process() iterates over it safely.
+	 */
+	stailq_add_tail_entry(&writer->commit_group, wal_msg, base.fifo);
+}
+
+/**
+ * Return the time the WAL writer may wait for more requests
+ * to join the commit group before writing it.
+ */
+static double
+wal_commit_group_timeout(struct wal_writer *writer)
+{
+	if (stailq_empty(&writer->commit_group))
+		return TIMEOUT_INFINITY;
+	if (writer->is_in_rollback || writer->commit_delay == 0)
+		return 0;
+	if (writer->commit_min_batch > 0 &&
+	    writer->commit_group_entries >= writer->commit_min_batch)
+		return 0;
+	double delay = writer->commit_delay;
+	/*
+	 * Don't wait longer than it takes to write and sync
+	 * a group: on a fast disk the delay would only add
+	 * latency, because requests arriving during the sync
+	 * join the next group anyway.
+	 */
+	if (writer->wal_mode == WAL_FSYNC)
+		delay = MIN(delay, writer->write_time_avg);
+	double timeout = writer->commit_group_start + delay -
+			 ev_monotonic_now(loop());
+	return MAX(timeout, 0.0);
+}
+
+/** Account a commit group written to disk in the WAL statistics. */
+static void
+wal_stat_account(struct wal_writer *writer, int entries, double write_time)
+{
+	struct wal_stat *stat = &writer->stat;
+	stat->writes++;
+	stat->entries += entries;
+	stat->write_time += write_time;
+	assert(entries > 0);
+	int bucket = 31 - bit_clz_u32(entries);
+	stat->group_size[MIN(bucket, WAL_STAT_GROUP_SIZE_BUCKETS - 1)]++;
+	/* Exponential moving average, see wal_commit_group_timeout(). */
+	if (writer->write_time_avg == 0)
+		writer->write_time_avg = write_time;
+	else
+		writer->write_time_avg = 0.875 * writer->write_time_avg +
+					 0.125 * write_time;
+}
+
+/**
+ * Write all requests of the commit group to disk, using as few
+ * write and sync calls as possible, and send them back to TX.
+ */
+static void
+wal_write_commit_group(struct wal_writer *writer)
+{
+	if (stailq_empty(&writer->commit_group))
+		return;
+
+	struct stailq group;
+	stailq_create(&group);
+	stailq_concat(&group, &writer->commit_group);
+	int group_entries = writer->commit_group_entries;
+	size_t group_len = writer->commit_group_len;
+	writer->commit_group_entries = 0;
+	writer->commit_group_len = 0;
+
 	int err_code = JOURNAL_ENTRY_ERR_UNKNOWN;
+	struct wal_msg *wal_msg, *next_msg;
+	struct wal_msg *last_committed_msg = NULL;
 	struct stailq_entry *last_committed = NULL;
 	struct journal_entry *entry;
 	struct error *error;
-	if (stailq_empty(&wal_msg->commit))
-		panic("Attempted to write an empty batch to WAL");
+	double write_start = ev_monotonic_time();
 
 	/*
-	 * Track all vclock changes made by this batch into
+	 * Track all vclock changes made by this group into
 	 * vclock_diff variable and then apply it into writers'
 	 * vclock after each xlog flush.
 	 */
 	struct vclock vclock_diff;
 	vclock_create(&vclock_diff);
+	struct vclock vclock_begin;
+	vclock_copy(&vclock_begin, &writer->vclock);
 
 	ERROR_INJECT_SLEEP(ERRINJ_WAL_DELAY);
 
@@ -1072,7 +1923,7 @@ wal_write_to_disk(struct cmsg *msg)
 	}
 
 	/* Ensure there's enough disk space before writing anything. */
-	if (wal_fallocate(writer, wal_msg->approx_len) != 0) {
+	if (wal_fallocate(writer, group_len) != 0) {
 		err_code = JOURNAL_ENTRY_ERR_IO;
 		goto done;
 	}
@@ -1099,36 +1950,67 @@ wal_write_to_disk(struct cmsg *msg)
 	 */
 
 	struct xlog *l = &writer->current_wal;
+	off_t offset_begin = l->offset;
+	int64_t wal_size_begin = writer->checkpoint_wal_size;
 
 	/*
-	 * Iterate over requests (transactions)
+	 * Iterate over requests (transactions) of all messages
+	 * of the group.
 	 */
 	int rc;
-	stailq_foreach_entry(entry, &wal_msg->commit, fifo) {
-		wal_assign_lsn(&vclock_diff, &writer->vclock, entry);
-		entry->res = vclock_sum(&vclock_diff) +
-			     vclock_sum(&writer->vclock);
-		rc = xlog_write_entry(l, entry);
-		if (rc < 0) {
-			err_code = JOURNAL_ENTRY_ERR_IO;
-			goto done;
-		}
-		if (rc > 0) {
-			writer->checkpoint_wal_size += rc;
-			last_committed = &entry->fifo;
-			vclock_merge(&writer->vclock, &vclock_diff);
+	stailq_foreach_entry(wal_msg, &group, base.fifo) {
+		stailq_foreach_entry(entry, &wal_msg->commit, fifo) {
+			wal_assign_lsn(&vclock_diff, &writer->vclock, entry);
+			entry->res = vclock_sum(&vclock_diff) +
+				     vclock_sum(&writer->vclock);
+			rc = xlog_write_entry(l, entry);
+			if (rc < 0) {
+				err_code = JOURNAL_ENTRY_ERR_IO;
+				goto done;
+			}
+			if (rc > 0) {
+				writer->checkpoint_wal_size += rc;
+				last_committed_msg = wal_msg;
+				last_committed = &entry->fifo;
+				vclock_merge(&writer->vclock, &vclock_diff);
+			}
+			/* rc == 0: the write is buffered in xlog_tx */
 		}
-		/* rc == 0: the write is buffered in xlog_tx */
+		/* Remember the vclock after the message is written. */
+		struct vclock vclock_msg_diff;
+		vclock_copy(&vclock_msg_diff, &vclock_diff);
+		vclock_copy(&wal_msg->vclock, &writer->vclock);
+		vclock_merge(&wal_msg->vclock, &vclock_msg_diff);
 	}
-	rc = xlog_flush(l);
+	/*
+	 * In the fsync mode the WAL file isn't opened with O_SYNC,
+	 * instead the whole group is synced along with the flush.
+	 * If the sync fails, nothing written by the group is
+	 * durable, so the file is truncated and all the requests
+	 * are rolled back.
+	 */
+	if (writer->wal_mode == WAL_FSYNC)
+		rc = xlog_flush_datasync(l, offset_begin);
+	else
+		rc = xlog_flush(l);
 	if (rc < 0) {
-		err_code= JOURNAL_ENTRY_ERR_IO;
+		err_code = JOURNAL_ENTRY_ERR_IO;
+		if (writer->wal_mode == WAL_FSYNC) {
+			last_committed_msg = NULL;
+			last_committed = NULL;
+			vclock_copy(&writer->vclock, &vclock_begin);
+			writer->checkpoint_wal_size = wal_size_begin;
+		}
 		goto done;
 	}
 
 	writer->checkpoint_wal_size += rc;
-	last_committed = stailq_last(&wal_msg->commit);
+	last_committed_msg = stailq_last_entry(&group, struct wal_msg,
+					       base.fifo);
+	last_committed = stailq_last(&last_committed_msg->commit);
 	vclock_merge(&writer->vclock, &vclock_diff);
+	wal_stat_account(writer, group_entries,
+			 ev_monotonic_time() - write_start);
 
 	/*
 	 * Notify TX if the checkpoint threshold has been exceeded.
@@ -1160,35 +2042,48 @@ done:
 		diag_clear(diag_get());
 	}
 	/*
-	 * Remember the vclock of the last successfully written row so
-	 * that we can update replicaset.vclock once this message gets
-	 * back to tx.
-	 */
-	vclock_copy(&wal_msg->vclock, &writer->vclock);
-	/*
-	 * We need to start rollback from the first request
-	 * following the last committed request. If
-	 * last_commit_req is NULL, it means we have committed
-	 * nothing, and need to start rollback from the first
-	 * request. Otherwise we rollback from the first request.
+	 * All requests of the messages preceding the one containing
+	 * the last committed request are committed. We need to start
+	 * rollback from the first request following the last committed
+	 * request. If last_committed_msg is NULL, it means we have
+	 * committed nothing, and need to roll back all requests.
 	 */
-	struct stailq rollback;
-	stailq_cut_tail(&wal_msg->commit, last_committed, &rollback);
-
-	if (!stailq_empty(&rollback)) {
+	bool is_committed = last_committed_msg != NULL;
+	stailq_foreach_entry(wal_msg, &group, base.fifo) {
+		struct stailq_entry *last = NULL;
+		if (wal_msg == last_committed_msg) {
+			last = last_committed;
+			is_committed = false;
+		} else if (is_committed) {
+			continue;
+		}
+		/*
+		 * Remember the vclock of the last successfully written
+		 * row so that we can update replicaset.vclock once this
+		 * message gets back to tx.
+		 */
+		vclock_copy(&wal_msg->vclock, &writer->vclock);
+		struct stailq rollback;
+		stailq_cut_tail(&wal_msg->commit, last, &rollback);
+		if (stailq_empty(&rollback))
+			continue;
 		assert(err_code != JOURNAL_ENTRY_ERR_UNKNOWN);
-		/* Update status of the successfully committed requests. */
+		/* Update status of the requests to roll back. */
 		stailq_foreach_entry(entry, &rollback, fifo)
 			entry->res = err_code;
 		/* Rollback unprocessed requests */
 		stailq_concat(&wal_msg->rollback, &rollback);
 		wal_begin_rollback();
-	} else {
-		assert(err_code == JOURNAL_ENTRY_ERR_UNKNOWN);
 	}
+	wal_tail_append(&writer->tail, &group, &vclock_begin,
+			&writer->vclock);
 	fiber_gc();
 	wal_notify_watchers(writer, WAL_EVENT_WRITE);
 	ERROR_INJECT_SLEEP(ERRINJ_RELAY_FASTER_THAN_TX);
+	stailq_foreach_entry_safe(wal_msg, next_msg, &group, base.fifo) {
+		cmsg_init(&wal_msg->base, wal_response_route);
+		cpipe_push(&writer->tx_prio_pipe, &wal_msg->base);
+	}
 }
 
 /** WAL writer main loop.  */
@@ -1201,6 +2096,16 @@ wal_writer_f(va_list ap)
 	/** Initialize eio in this thread */
 	coio_enable();
 
+	/*
+	 * With io_uring, a commit group is written and synced
+	 * with one system call, see xlog_flush_datasync().
+	 */
+	if (writer->use_io_uring && io_ring_init() != 0) {
+		diag_log();
+		say_warn("WAL thread failed to set up io_uring, "
+			 "falling back to writev");
+	}
+
 	struct cbus_endpoint endpoint;
 	cbus_endpoint_create(&endpoint, "wal", fiber_schedule_cb, fiber());
 	/*
@@ -1210,7 +2115,26 @@ wal_writer_f(va_list ap)
 	 */
 	cpipe_create(&writer->tx_prio_pipe, "tx_prio");
 
-	cbus_loop(&endpoint);
+	/*
+	 * Process messages until there are no more of them, then
+	 * write the accumulated commit group, possibly waiting for
+	 * more requests to join it, see wal_commit_group_timeout().
+	 */
+	while (true) {
+		cbus_process(&endpoint);
+		if (fiber_is_cancelled())
+			break;
+		double timeout = wal_commit_group_timeout(writer);
+		if (timeout == 0) {
+			wal_write_commit_group(writer);
+			continue;
+		}
+		if (timeout == TIMEOUT_INFINITY)
+			fiber_yield();
+		else
+			fiber_yield_timeout(timeout);
+	}
+	wal_write_commit_group(writer);
 
 	/*
 	 * Create a new empty WAL on shutdown so that we don't
@@ -1235,6 +2159,7 @@ wal_writer_f(va_list ap)
 	if (xlog_is_open(&vy_log_writer.xlog))
 		xlog_close(&vy_log_writer.xlog, false);
 
+	io_ring_destroy();
 	cpipe_destroy(&writer->tx_prio_pipe);
 	return 0;
 }
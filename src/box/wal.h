@@ -38,6 +38,7 @@
 #include "vclock/vclock.h"
 
 struct fiber;
+struct info_handler;
 struct wal_writer;
 struct tt_uuid;
 
@@ -97,11 +98,14 @@ typedef void (*wal_on_garbage_collection_f)(const struct vclock *vclock);
 typedef void (*wal_on_checkpoint_threshold_f)(void);
 
 /**
- * Start WAL thread and initialize WAL writer.
+ * Start WAL thread and initialize WAL writer. If @a use_io_uring
+ * is set, the WAL thread writes and syncs files through io_uring,
+ * provided it's supported.
  */
 int
 wal_init(enum wal_mode wal_mode, const char *wal_dirname,
 	 int64_t wal_max_size, const struct tt_uuid *instance_uuid,
+	 bool use_io_uring,
 	 wal_on_garbage_collection_f on_garbage_collection,
 	 wal_on_checkpoint_threshold_f on_checkpoint_threshold);
 
@@ -256,6 +260,35 @@ wal_commit_checkpoint(struct wal_checkpoint *checkpoint);
 void
 wal_set_checkpoint_threshold(int64_t threshold);
 
+/**
+ * Set the max time a WAL write request may wait for other
+ * requests to be written and synced together with it.
+ */
+void
+wal_set_commit_delay(double delay);
+
+/**
+ * Set the number of journal entries, accumulation of which
+ * makes the WAL thread write them without waiting for the
+ * commit delay to expire. 0 means no limit.
+ */
+void
+wal_set_commit_min_batch(int min_batch);
+
+/**
+ * Set the max number of garbage collected WAL files kept as
+ * zero-filled spare files to be reused for new WAL files.
+ * 0 means garbage collected WAL files are removed.
+ */
+void
+wal_set_recycle_segments(int count);
+
+/**
+ * Dump WAL write statistics to the given info handler.
+ */
+void
+wal_stat_info(struct info_handler *h);
+
 /**
  * Set the pending write limit in bytes. Once the limit is reached, new
  * writes are blocked until some previous writes succeed.
@@ -263,6 +296,57 @@ wal_set_checkpoint_threshold(int64_t threshold);
 void
 wal_set_queue_max_size(int64_t size);
 
+/**
+ * Set the max size of the in-memory WAL tail, in bytes.
+ * 0 disables the tail.
+ */
+void
+wal_set_tail_size(int64_t size);
+
+struct wal_tail_batch;
+
+/**
+ * A reader of the in-memory WAL tail. The tail stores rows
+ * recently written to the WAL so that relays that have caught
+ * up with the WAL writer don't need to re-read them from disk.
+ * Safe to use from any thread.
+ */
+struct wal_tail_cursor {
+	/** Sequence number of the next batch to read. */
+	int64_t seq;
+	/** The batch returned last, pinned until the next call. */
+	struct wal_tail_batch *batch;
+};
+
+/**
+ * Position a cursor right after the given vclock.
+ * Returns 0 on success, 1 if the tail doesn't store all
+ * rows written after the given vclock.
+ */
+int
+wal_tail_cursor_create(struct wal_tail_cursor *cursor,
+		       const struct vclock *vclock);
+
+/**
+ * Get the next batch of rows from the tail. Each row is encoded
+ * with a fixheader, see xrow_to_iovec(). The data stays valid
+ * until the next call or cursor destruction. Rows preceding
+ * the vclock the cursor was created at may be returned and
+ * should be skipped by the caller.
+ *
+ * Returns 0 on success, with @data set to NULL if there are no
+ * more rows. Returns 1 if the next batch has already been
+ * evicted from the tail, in which case the reader has to
+ * fall back on reading xlog files.
+ */
+int
+wal_tail_cursor_next(struct wal_tail_cursor *cursor,
+		     const char **data, const char **data_end);
+
+/** Release the batch pinned by a cursor. */
+void
+wal_tail_cursor_destroy(struct wal_tail_cursor *cursor);
+
 /**
  * Remove WAL files that are not needed by consumers reading
  * rows at @vclock or newer.
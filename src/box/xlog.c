@@ -31,12 +31,14 @@
 #include "xlog.h"
 #include <dirent.h>
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <ctype.h>
 
 #include "fiber.h"
 #include "exception.h"
 #include "crc32.h"
 #include "fio.h"
+#include "io_ring.h"
 #include <tarantool_eio.h>
 #include <msgpuck.h>
 
@@ -47,6 +49,7 @@
 #include "iproto_constants.h"
 #include "errinj.h"
 #include "trivia/util.h"
+#include "tt_pthread.h"
 
 /*
  * FALLOC_FL_KEEP_SIZE flag has existed since fallocate() was
@@ -88,6 +91,11 @@ enum {
 	 * Maybe this should be a configuration option.
 	 */
 	XLOG_TX_COMPRESS_THRESHOLD = 2 * 1024,
+	/**
+	 * Max number of encoded blocks accumulated before they
+	 * are written through io_uring, see xlog::pending.
+	 */
+	XLOG_PENDING_MAX = 8,
 };
 
 const struct xlog_opts xlog_opts_default = {
@@ -114,6 +122,7 @@ enum {
 #define VCLOCK_KEY "VClock"
 #define VERSION_KEY "Version"
 #define PREV_VCLOCK_KEY "PrevVClock"
+#define PREALLOCATED_KEY "Preallocated"
 
 static const char v13[] = "0.13";
 static const char v12[] = "0.12";
@@ -167,6 +176,8 @@ xlog_meta_format(const struct xlog_meta *meta, char *buf, int size)
 		SNPRINT(total, snprintf, buf, size, PREV_VCLOCK_KEY ": %s\n",
 			vclock_to_string(&meta->prev_vclock));
 	}
+	if (meta->is_preallocated)
+		SNPRINT(total, snprintf, buf, size, PREALLOCATED_KEY ": true\n");
 	SNPRINT(total, snprintf, buf, size, "\n");
 	assert(total > 0);
 	return total;
@@ -308,6 +319,13 @@ xlog_meta_parse(struct xlog_meta *meta, const char **data,
 			 */
 			if (parse_vclock(val, val_end, &meta->prev_vclock) != 0)
 				return -1;
+		} else if (xlog_meta_key_equal(key, key_end,
+					       PREALLOCATED_KEY)) {
+			/*
+			 * Preallocated: true
+			 */
+			meta->is_preallocated =
+				xlog_meta_key_equal(val, val_end, "true");
 		} else if (xlog_meta_key_equal(key, key_end, VERSION_KEY)) {
 			/* Ignore Version: for now */
 		} else {
@@ -793,6 +811,20 @@ xlog_init(struct xlog *xlog, const struct xlog_opts *opts)
 	xlog->is_autocommit = true;
 	obuf_create(&xlog->obuf, &cord()->slabc, XLOG_TX_AUTOCOMMIT_THRESHOLD);
 	obuf_create(&xlog->zbuf, &cord()->slabc, XLOG_TX_AUTOCOMMIT_THRESHOLD);
+	if (io_ring_is_enabled()) {
+		xlog->pending = calloc(XLOG_PENDING_MAX,
+				       sizeof(*xlog->pending));
+		if (xlog->pending == NULL) {
+			diag_set(OutOfMemory,
+				 XLOG_PENDING_MAX * sizeof(*xlog->pending),
+				 "calloc", "xlog pending blocks");
+			return -1;
+		}
+		for (int i = 0; i < XLOG_PENDING_MAX; i++) {
+			obuf_create(&xlog->pending[i], &cord()->slabc,
+				    XLOG_TX_AUTOCOMMIT_THRESHOLD);
+		}
+	}
 	if (!opts->no_compression) {
 		xlog->zctx = ZSTD_createCCtx();
 		if (xlog->zctx == NULL) {
@@ -818,17 +850,29 @@ xlog_destroy(struct xlog *xlog)
 	assert(xlog->zbuf.slabc == &cord()->slabc);
 	obuf_destroy(&xlog->obuf);
 	obuf_destroy(&xlog->zbuf);
+	if (xlog->pending != NULL) {
+		assert(xlog->pending_count == 0);
+		for (int i = 0; i < XLOG_PENDING_MAX; i++)
+			obuf_destroy(&xlog->pending[i]);
+		free(xlog->pending);
+	}
 	ZSTD_freeCCtx(xlog->zctx);
 	TRASH(xlog);
 	xlog->fd = -1;
 }
 
-int
-xlog_create(struct xlog *xlog, const char *name, int flags,
-	    const struct xlog_meta *meta, const struct xlog_opts *opts)
+/**
+ * Create a new xlog file. If @a spare is not NULL, the file is
+ * made of the given zero-filled file rather than created anew.
+ */
+static int
+xlog_create_impl(struct xlog *xlog, const char *name, int flags,
+		 const struct xlog_meta *meta, const struct xlog_opts *opts,
+		 const char *spare)
 {
 	char meta_buf[XLOG_META_LEN_MAX];
 	int meta_len;
+	struct stat st;
 
 	/*
 	 * Check whether a file with this name already exists.
@@ -854,7 +898,21 @@ xlog_create(struct xlog *xlog, const char *name, int flags,
 		goto err;
 	}
 
-	flags |= O_RDWR | O_CREAT | O_EXCL;
+	if (spare != NULL) {
+		/*
+		 * Take over the spare file. Rename it first so that
+		 * it is removed on restart if we fail to finish.
+		 */
+		if (rename(spare, xlog->filename) != 0) {
+			diag_set(SystemError, "failed to rename '%s' file",
+				 spare);
+			goto err;
+		}
+		xlog->meta.is_preallocated = true;
+		flags |= O_RDWR;
+	} else {
+		flags |= O_RDWR | O_CREAT | O_EXCL;
+	}
 
 	/*
 	 * Open the <lsn>.<suffix>.inprogress file.
@@ -889,6 +947,16 @@ xlog_create(struct xlog *xlog, const char *name, int flags,
 	}
 
 	xlog->offset = meta_len; /* first log starts after meta */
+	if (spare != NULL) {
+		if (fstat(xlog->fd, &st) != 0) {
+			diag_set(SystemError, "failed to stat file '%s'",
+				 xlog->filename);
+			goto err_write;
+		}
+		/* The rest of the file is zero-filled. */
+		if (st.st_size > xlog->offset)
+			xlog->allocated = st.st_size - xlog->offset;
+	}
 	return 0;
 err_write:
 	close(xlog->fd);
@@ -899,6 +967,76 @@ err:
 	return -1;
 }
 
+int
+xlog_create(struct xlog *xlog, const char *name, int flags,
+	    const struct xlog_meta *meta, const struct xlog_opts *opts)
+{
+	return xlog_create_impl(xlog, name, flags, meta, opts, NULL);
+}
+
+/**
+ * Overwrite the file data from @a offset up to @a end with zeros.
+ */
+static int
+xlog_write_zeros(int fd, off_t offset, off_t end)
+{
+	static const char zeros[4096];
+	for (off_t pos = offset; pos < end; ) {
+		size_t len = MIN(end - pos, (off_t)sizeof(zeros));
+		ssize_t rc = pwrite(fd, zeros, len, pos);
+		if (rc < 0)
+			return -1;
+		pos += rc;
+	}
+	return 0;
+}
+
+static int
+xlog_erase_torn_tx(struct xlog *xlog, off_t file_size);
+
+/**
+ * Position a preallocated xlog file opened for appending at
+ * the end of valid data and erase the EOF marker or a torn tx
+ * if any.
+ */
+static int
+xlog_find_data_end(struct xlog *xlog)
+{
+	struct xlog_cursor cursor;
+	if (xlog_cursor_openfd(&cursor, xlog->fd, xlog->filename) != 0)
+		return -1;
+	struct xrow_header row;
+	int rc;
+	while ((rc = xlog_cursor_next(&cursor, &row, false)) == 0)
+		;
+	xlog->offset = xlog_cursor_pos(&cursor);
+	bool is_eof = xlog_cursor_is_eof(&cursor);
+	xlog_cursor_close(&cursor, true);
+	if (rc < 0)
+		return -1;
+	if (is_eof) {
+		const log_magic_t zero = 0;
+		if (pwrite(xlog->fd, &zero, sizeof(zero),
+			   xlog->offset) != sizeof(zero)) {
+			diag_set(SystemError, "failed to erase EOF marker "
+				 "in file '%s'", xlog->filename);
+			return -1;
+		}
+	}
+	struct stat st;
+	if (fstat(xlog->fd, &st) != 0 ||
+	    lseek(xlog->fd, xlog->offset, SEEK_SET) < 0) {
+		diag_set(SystemError, "failed to seek file '%s'",
+			 xlog->filename);
+		return -1;
+	}
+	if (!is_eof && xlog_erase_torn_tx(xlog, st.st_size) != 0)
+		return -1;
+	if (st.st_size > xlog->offset)
+		xlog->allocated = st.st_size - xlog->offset;
+	return 0;
+}
+
 int
 xlog_open(struct xlog *xlog, const char *name, const struct xlog_opts *opts)
 {
@@ -936,6 +1074,12 @@ xlog_open(struct xlog *xlog, const char *name, const struct xlog_opts *opts)
 		goto err_read;
 	}
 
+	if (xlog->meta.is_preallocated) {
+		if (xlog_find_data_end(xlog) != 0)
+			goto err_read;
+		return 0;
+	}
+
 	/* Check if the file has EOF marker. */
 	xlog->offset = fio_lseek(xlog->fd, -(off_t)sizeof(magic), SEEK_END);
 	if (xlog->offset < 0)
@@ -995,9 +1139,9 @@ xdir_touch_xlog(struct xdir *dir, const struct vclock *vclock)
  * In case of error, writes a message to the error log
  * and sets errno.
  */
-int
-xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
-		 const struct vclock *vclock)
+static int
+xdir_create_xlog_impl(struct xdir *dir, struct xlog *xlog,
+		      const struct vclock *vclock, const char *spare)
 {
 	int64_t signature = vclock_sum(vclock);
 	assert(signature >= 0);
@@ -1016,8 +1160,8 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 			 vclock, prev_vclock);
 
 	const char *filename = xdir_format_filename(dir, signature, NONE);
-	if (xlog_create(xlog, filename, dir->open_wflags, &meta,
-			&dir->opts) != 0)
+	if (xlog_create_impl(xlog, filename, dir->open_wflags, &meta,
+			     &dir->opts, spare) != 0)
 		return -1;
 
 	/* Rename xlog file */
@@ -1031,6 +1175,20 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 	return 0;
 }
 
+int
+xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
+		 const struct vclock *vclock)
+{
+	return xdir_create_xlog_impl(dir, xlog, vclock, NULL);
+}
+
+int
+xdir_create_xlog_preallocated(struct xdir *dir, struct xlog *xlog,
+			      const struct vclock *vclock, const char *spare)
+{
+	return xdir_create_xlog_impl(dir, xlog, vclock, spare);
+}
+
 ssize_t
 xlog_fallocate(struct xlog *log, size_t len)
 {
@@ -1067,31 +1225,26 @@ xlog_fallocate(struct xlog *log, size_t len)
 }
 
 /**
- * Write a sequence of uncompressed xrow objects.
- *
- * @retval -1 error
- * @retval >= 0 the number of bytes written
+ * Populate the fixheader of a block of uncompressed xrow objects
+ * accumulated in @a obuf. The space for the fixheader is reserved
+ * when the first row is added to the buffer.
  */
-static off_t
-xlog_tx_write_plain(struct xlog *log)
+static void
+xlog_tx_encode_plain(struct obuf *obuf)
 {
-	/**
-	 * We created an obuf savepoint at start of xlog_tx,
-	 * now populate it with data.
-	 */
-	char *fixheader = (char *)log->obuf.iov[0].iov_base;
+	char *fixheader = (char *)obuf->iov[0].iov_base;
 	*(log_magic_t *)fixheader = row_marker;
 	char *data = fixheader + sizeof(log_magic_t);
 
 	data = mp_encode_uint(data,
-			      obuf_size(&log->obuf) - XLOG_FIXHEADER_SIZE);
+			      obuf_size(obuf) - XLOG_FIXHEADER_SIZE);
 	/* Encode crc32 for previous row */
 	data = mp_encode_uint(data, 0);
 	/* Encode crc32 for current row */
 	uint32_t crc32c = 0;
 	struct iovec *iov;
 	size_t offset = XLOG_FIXHEADER_SIZE;
-	for (iov = log->obuf.iov; iov->iov_len; ++iov) {
+	for (iov = obuf->iov; iov->iov_len; ++iov) {
 		crc32c = crc32_calc(crc32c,
 				    (char *)iov->iov_base + offset,
 				    iov->iov_len - offset);
@@ -1110,46 +1263,39 @@ xlog_tx_write_plain(struct xlog *log)
 			data += padding - 1;
 		}
 	}
-
-	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
-		diag_set(ClientError, ER_INJECTION, "xlog write injection");
-		return -1;
-	});
-
-	ssize_t written = fio_writevn(log->fd, log->obuf.iov, log->obuf.pos + 1);
-	if (written < 0) {
-		diag_set(SystemError, "failed to write to '%s' file",
-			 log->filename);
-		return -1;
-	}
-	return obuf_size(&log->obuf);
 }
 
 /**
- * Write a compressed block of xrow objects.
- * @retval -1  error
- * @retval >= 0 the number of bytes written
+ * Compress a block of xrow objects accumulated in @a obuf
+ * to @a zbuf using @a zctx and populate its fixheader.
+ *
+ * @retval -1 error, @a zbuf is left in undefined state
+ * @retval 0 success
  */
-static off_t
-xlog_tx_write_zstd(struct xlog *log)
+static int
+xlog_tx_encode_zstd(struct obuf *obuf, struct obuf *zbuf, ZSTD_CCtx *zctx)
 {
-	char *fixheader = (char *)obuf_alloc(&log->zbuf,
-					     XLOG_FIXHEADER_SIZE);
+	char *fixheader = (char *)obuf_alloc(zbuf, XLOG_FIXHEADER_SIZE);
+	if (fixheader == NULL) {
+		diag_set(OutOfMemory, XLOG_FIXHEADER_SIZE, "runtime arena",
+			 "compression buffer");
+		return -1;
+	}
 
 	uint32_t crc32c = 0;
 	struct iovec *iov;
 	/* 3 is compression level. */
-	ZSTD_compressBegin(log->zctx, 3);
+	ZSTD_compressBegin(zctx, 3);
 	size_t offset = XLOG_FIXHEADER_SIZE;
-	for (iov = log->obuf.iov; iov->iov_len; ++iov) {
+	for (iov = obuf->iov; iov->iov_len; ++iov) {
 		/* Estimate max output buffer size. */
 		size_t zmax_size = ZSTD_compressBound(iov->iov_len - offset);
 		/* Allocate a destination buffer. */
-		void *zdst = obuf_reserve(&log->zbuf, zmax_size);
+		void *zdst = obuf_reserve(zbuf, zmax_size);
 		if (!zdst) {
 			diag_set(OutOfMemory, zmax_size, "runtime arena",
 				  "compression buffer");
-			goto error;
+			return -1;
 		}
 		size_t (*fcompress)(ZSTD_CCtx *, void *, size_t,
 				    const void *, size_t);
@@ -1157,22 +1303,22 @@ xlog_tx_write_zstd(struct xlog *log)
 		 * If it's the last iov or the last
 		 * log has 0 bytes, end the stream.
 		 */
-		if (iov == log->obuf.iov + log->obuf.pos ||
+		if (iov == obuf->iov + obuf->pos ||
 		    !(iov + 1)->iov_len) {
 			fcompress = ZSTD_compressEnd;
 		} else {
 			fcompress = ZSTD_compressContinue;
 		}
-		size_t zsize = fcompress(log->zctx, zdst, zmax_size,
+		size_t zsize = fcompress(zctx, zdst, zmax_size,
 					 (char *)iov->iov_base + offset,
 					 iov->iov_len - offset);
 		if (ZSTD_isError(zsize)) {
 			diag_set(ClientError, ER_COMPRESSION,
 				 ZSTD_getErrorName(zsize));
-			goto error;
+			return -1;
 		}
 		/* Advance output buffer to the end of compressed data. */
-		obuf_alloc(&log->zbuf, zsize);
+		obuf_alloc(zbuf, zsize);
 		/* Update crc32c */
 		crc32c = crc32_calc(crc32c, (char *)zdst, zsize);
 		/* Discount fixheader size for all iovs after first. */
@@ -1183,7 +1329,7 @@ xlog_tx_write_zstd(struct xlog *log)
 	char *data;
 	data = fixheader + sizeof(log_magic_t);
 	data = mp_encode_uint(data,
-			      obuf_size(&log->zbuf) - XLOG_FIXHEADER_SIZE);
+			      obuf_size(zbuf) - XLOG_FIXHEADER_SIZE);
 	/* Encode crc32 for previous row */
 	data = mp_encode_uint(data, 0);
 	/* Encode crc32 for current row */
@@ -1198,26 +1344,62 @@ xlog_tx_write_zstd(struct xlog *log)
 			data += padding - 1;
 		}
 	}
+	return 0;
+}
 
+/**
+ * Write an encoded block of xrow objects to the log file.
+ *
+ * @retval -1 error
+ * @retval >= 0 the number of bytes written
+ */
+static ssize_t
+xlog_tx_write_buf(struct xlog *log, struct obuf *buf)
+{
 	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
 		diag_set(ClientError, ER_INJECTION, "xlog write injection");
-		obuf_reset(&log->zbuf);
-		goto error;
+		return -1;
 	});
 
-	ssize_t written;
-	written = fio_writevn(log->fd, log->zbuf.iov,
-			      log->zbuf.pos + 1);
+	ssize_t written = fio_writevn(log->fd, buf->iov, buf->pos + 1);
 	if (written < 0) {
 		diag_set(SystemError, "failed to write to '%s' file",
 			 log->filename);
-		goto error;
+		return -1;
 	}
-	obuf_reset(&log->zbuf);
 	return written;
-error:
+}
+
+/**
+ * Write a sequence of uncompressed xrow objects.
+ *
+ * @retval -1 error
+ * @retval >= 0 the number of bytes written
+ */
+static off_t
+xlog_tx_write_plain(struct xlog *log)
+{
+	/**
+	 * We created an obuf savepoint at start of xlog_tx,
+	 * now populate it with data.
+	 */
+	xlog_tx_encode_plain(&log->obuf);
+	return xlog_tx_write_buf(log, &log->obuf);
+}
+
+/**
+ * Write a compressed block of xrow objects.
+ * @retval -1  error
+ * @retval >= 0 the number of bytes written
+ */
+static off_t
+xlog_tx_write_zstd(struct xlog *log)
+{
+	ssize_t written = -1;
+	if (xlog_tx_encode_zstd(&log->obuf, &log->zbuf, log->zctx) == 0)
+		written = xlog_tx_write_buf(log, &log->zbuf);
 	obuf_reset(&log->zbuf);
-	return -1;
+	return written;
 }
 
 /* file syncing and posix_fadvise() should be rounded by a page boundary */
@@ -1226,37 +1408,53 @@ error:
 #define SYNC_ROUND_UP(size)	(SYNC_ROUND_DOWN(size + SYNC_MASK))
 
 /**
- * Writes xlog batch to file
+ * Discard data written to the log file at and after @a offset,
+ * up to @a end, and position the file at @a offset. A regular
+ * file is truncated. A preallocated file must keep its size, so
+ * the discarded data is overwritten with zeros instead, which
+ * readers take for the end of data.
  */
-static ssize_t
-xlog_tx_write(struct xlog *log)
+static void
+xlog_discard(struct xlog *log, off_t offset, off_t end)
 {
-	if (obuf_size(&log->obuf) == XLOG_FIXHEADER_SIZE)
-		return 0;
-	ssize_t written;
-
-	if (!log->opts.no_compression &&
-	    obuf_size(&log->obuf) >= XLOG_TX_COMPRESS_THRESHOLD) {
-		written = xlog_tx_write_zstd(log);
-	} else {
-		written = xlog_tx_write_plain(log);
+	if (lseek(log->fd, offset, SEEK_SET) < 0)
+		panic_syserror("failed to seek xlog after write error");
+	if (!log->meta.is_preallocated) {
+		if (ftruncate(log->fd, offset) != 0)
+			panic_syserror("failed to truncate xlog "
+				       "after write error");
+		log->allocated = 0;
+		return;
 	}
-	ERROR_INJECT(ERRINJ_WAL_WRITE, {
-		diag_set(ClientError, ER_INJECTION, "xlog write injection");
-		written = -1;
-	});
+	if (xlog_write_zeros(log->fd, offset, end) != 0)
+		panic_syserror("failed to discard xlog data "
+			       "after write error");
+	if (log->offset > offset)
+		log->allocated += log->offset - offset;
+}
 
-	obuf_reset(&log->obuf);
+/**
+ * Account a block of @a rows xrow objects written to the log
+ * file and sync the file if needed. If the write failed, truncate
+ * the file to the end of the last successfully written block.
+ * @a size is the max size of the block.
+ *
+ * @retval -1 the block wasn't written
+ * @retval >= 0 the number of bytes written
+ */
+static ssize_t
+xlog_tx_complete(struct xlog *log, ssize_t written, size_t size,
+		 int64_t rows)
+{
 	/*
 	 * Simplify recovery after a temporary write failure:
 	 * truncate the file to the best known good write
-	 * position.
+	 * position. In a preallocated file, the whole failed
+	 * block is erased, because data left after the rows
+	 * written later would be taken for corruption.
 	 */
 	if (written < 0) {
-		if (lseek(log->fd, log->offset, SEEK_SET) < 0 ||
-		    ftruncate(log->fd, log->offset) != 0)
-			panic_syserror("failed to truncate xlog after write error");
-		log->allocated = 0;
+		xlog_discard(log, log->offset, log->offset + size);
 		return -1;
 	}
 	if (log->allocated > (size_t)written)
@@ -1264,8 +1462,7 @@ xlog_tx_write(struct xlog *log)
 	else
 		log->allocated = 0;
 	log->offset += written;
-	log->rows += log->tx_rows;
-	log->tx_rows = 0;
+	log->rows += rows;
 	if ((log->opts.sync_interval && log->offset >=
 	    (off_t)(log->synced_size + log->opts.sync_interval)) ||
 	    (log->opts.rate_limit && log->offset >=
@@ -1307,60 +1504,188 @@ xlog_tx_write(struct xlog *log)
 	return written;
 }
 
-/*
- * Add a row to a log and possibly flush the log.
+/**
+ * Write the pending blocks, see xlog::pending, and, if @a sync is
+ * set, flush the file data to disk, all in one system call.
+ *
+ * @retval -1 error
+ * @retval >= 0 the number of bytes written
+ */
+static ssize_t
+xlog_write_pending(struct xlog *log, bool sync)
+{
+	struct iovec iov[XLOG_PENDING_MAX * (SMALL_OBUF_IOV_MAX + 1)];
+	int iovcnt = 0;
+	for (int i = 0; i < log->pending_count; i++) {
+		struct obuf *buf = &log->pending[i];
+		memcpy(iov + iovcnt, buf->iov, (buf->pos + 1) * sizeof(*iov));
+		iovcnt += buf->pos + 1;
+	}
+	ssize_t written = -1;
+	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
+		diag_set(ClientError, ER_INJECTION, "xlog write injection");
+		goto out;
+	});
+	written = io_ring_writev(log->fd, iov, iovcnt, sync);
+	if (written < 0) {
+		diag_set(SystemError, "failed to write to '%s' file",
+			 log->filename);
+	}
+	ERROR_INJECT(ERRINJ_WAL_WRITE, {
+		diag_set(ClientError, ER_INJECTION, "xlog write injection");
+		written = -1;
+	});
+out:
+	for (int i = 0; i < log->pending_count; i++)
+		obuf_reset(&log->pending[i]);
+	size_t size = log->pending_size;
+	int64_t rows = log->pending_rows;
+	log->pending_count = 0;
+	log->pending_size = 0;
+	log->pending_rows = 0;
+	return xlog_tx_complete(log, written, size, rows);
+}
+
+/**
+ * Encode the rows accumulated in the output buffer as a block and
+ * add it to the pending blocks instead of writing it. The blocks
+ * are written once there are too many of them or on flush.
+ *
+ * @retval -1 error
+ * @retval >= 0 the number of bytes written
+ */
+static ssize_t
+xlog_tx_defer(struct xlog *log)
+{
+	size_t size = obuf_size(&log->obuf);
+	struct obuf *block = &log->obuf;
+	if (!log->opts.no_compression &&
+	    size >= XLOG_TX_COMPRESS_THRESHOLD) {
+		if (xlog_tx_encode_zstd(&log->obuf, &log->zbuf,
+					log->zctx) != 0) {
+			obuf_reset(&log->zbuf);
+			obuf_reset(&log->obuf);
+			log->tx_rows = 0;
+			return -1;
+		}
+		block = &log->zbuf;
+		size = XLOG_FIXHEADER_SIZE + ZSTD_compressBound(size);
+	} else {
+		xlog_tx_encode_plain(&log->obuf);
+	}
+	/* Take the block, leaving an empty buffer in its place. */
+	SWAP(*block, log->pending[log->pending_count]);
+	log->pending_count++;
+	log->pending_size += size;
+	log->pending_rows += log->tx_rows;
+	log->tx_rows = 0;
+	obuf_reset(&log->obuf);
+	if (log->pending_count < XLOG_PENDING_MAX)
+		return 0;
+	return xlog_write_pending(log, false);
+}
+
+/**
+ * Writes xlog batch to file
+ */
+static ssize_t
+xlog_tx_write(struct xlog *log)
+{
+	if (obuf_size(&log->obuf) == XLOG_FIXHEADER_SIZE)
+		return 0;
+	if (log->pending != NULL)
+		return xlog_tx_defer(log);
+	ssize_t written;
+	size_t size = obuf_size(&log->obuf);
+
+	if (!log->opts.no_compression &&
+	    obuf_size(&log->obuf) >= XLOG_TX_COMPRESS_THRESHOLD) {
+		written = xlog_tx_write_zstd(log);
+		size = XLOG_FIXHEADER_SIZE + ZSTD_compressBound(size);
+	} else {
+		written = xlog_tx_write_plain(log);
+	}
+	ERROR_INJECT(ERRINJ_WAL_WRITE, {
+		diag_set(ClientError, ER_INJECTION, "xlog write injection");
+		written = -1;
+	});
+
+	obuf_reset(&log->obuf);
+	if (xlog_tx_complete(log, written, size, log->tx_rows) < 0)
+		return -1;
+	log->tx_rows = 0;
+	return written;
+}
+
+/**
+ * Encode a row and append it to a block of rows accumulated
+ * in @a obuf.
  *
  * @retval  -1 error, check diag.
- * @retval >=0 the number of bytes written to buffer.
+ * @retval >=0 the number of bytes appended to the buffer.
  */
-ssize_t
-xlog_write_row(struct xlog *log, const struct xrow_header *packet)
+static ssize_t
+xlog_tx_append_row(struct obuf *obuf, const struct xrow_header *packet)
 {
 	/*
 	 * Automatically reserve space for a fixheader when adding
 	 * the first row in * a log. The fixheader is populated
 	 * at write. @sa xlog_tx_write().
 	 */
-	if (obuf_size(&log->obuf) == 0) {
-		if (!obuf_alloc(&log->obuf, XLOG_FIXHEADER_SIZE)) {
+	if (obuf_size(obuf) == 0) {
+		if (!obuf_alloc(obuf, XLOG_FIXHEADER_SIZE)) {
 			diag_set(OutOfMemory, XLOG_FIXHEADER_SIZE,
 				  "runtime arena", "xlog tx output buffer");
 			return -1;
 		}
 	}
 
-	struct obuf_svp svp = obuf_create_svp(&log->obuf);
-	size_t page_offset = obuf_size(&log->obuf);
+	struct obuf_svp svp = obuf_create_svp(obuf);
+	size_t page_offset = obuf_size(obuf);
 	/** encode row into iovec */
 	struct iovec iov[XROW_IOVMAX];
 	/** don't write sync to the disk */
 	int iovcnt = xrow_header_encode(packet, 0, iov, 0);
 	if (iovcnt < 0) {
-		obuf_rollback_to_svp(&log->obuf, &svp);
+		obuf_rollback_to_svp(obuf, &svp);
 		return -1;
 	}
 	for (int i = 0; i < iovcnt; ++i) {
 		struct errinj *inj = errinj(ERRINJ_WAL_WRITE_PARTIAL,
 					    ERRINJ_INT);
 		if (inj != NULL && inj->iparam >= 0 &&
-		    obuf_size(&log->obuf) > (size_t)inj->iparam) {
+		    obuf_size(obuf) > (size_t)inj->iparam) {
 			diag_set(ClientError, ER_INJECTION,
 				 "xlog write injection");
-			obuf_rollback_to_svp(&log->obuf, &svp);
+			obuf_rollback_to_svp(obuf, &svp);
 			return -1;
 		};
-		if (obuf_dup(&log->obuf, iov[i].iov_base, iov[i].iov_len) <
+		if (obuf_dup(obuf, iov[i].iov_base, iov[i].iov_len) <
 		    iov[i].iov_len) {
 			diag_set(OutOfMemory, XLOG_FIXHEADER_SIZE,
 				  "runtime arena", "xlog tx output buffer");
-			obuf_rollback_to_svp(&log->obuf, &svp);
+			obuf_rollback_to_svp(obuf, &svp);
 			return -1;
 		}
 	}
 	assert(iovcnt <= XROW_IOVMAX);
+	return obuf_size(obuf) - page_offset;
+}
+
+/*
+ * Add a row to a log and possibly flush the log.
+ *
+ * @retval  -1 error, check diag.
+ * @retval >=0 the number of bytes written to buffer.
+ */
+ssize_t
+xlog_write_row(struct xlog *log, const struct xrow_header *packet)
+{
+	ssize_t row_size = xlog_tx_append_row(&log->obuf, packet);
+	if (row_size < 0)
+		return -1;
 	log->tx_rows++;
 
-	size_t row_size = obuf_size(&log->obuf) - page_offset;
 	if (log->is_autocommit &&
 	    obuf_size(&log->obuf) >= XLOG_TX_AUTOCOMMIT_THRESHOLD &&
 	    xlog_tx_write(log) < 0)
@@ -1417,9 +1742,239 @@ ssize_t
 xlog_flush(struct xlog *log)
 {
 	assert(log->is_autocommit);
-	if (log->obuf.used == 0)
+	if (log->pending == NULL) {
+		if (log->obuf.used == 0)
+			return 0;
+		return xlog_tx_write(log);
+	}
+	ssize_t written = 0;
+	if (log->obuf.used > 0)
+		written = xlog_tx_defer(log);
+	if (written < 0)
+		return -1;
+	if (log->pending_count == 0)
+		return written;
+	ssize_t rc = xlog_write_pending(log, false);
+	if (rc < 0)
+		return -1;
+	return written + rc;
+}
+
+ssize_t
+xlog_flush_datasync(struct xlog *log, off_t offset)
+{
+	assert(log->is_autocommit);
+	ssize_t written, rc;
+	if (log->pending == NULL) {
+		written = xlog_flush(log);
+		if (written < 0)
+			goto error;
+		if (xlog_datasync(log, offset) != 0)
+			return -1;
+		return written;
+	}
+	ERROR_INJECT(ERRINJ_WAL_SYNC_DISK, {
+		if (xlog_flush(log) >= 0)
+			diag_set(ClientError, ER_INJECTION,
+				 "xlog sync injection");
+		goto error;
+	});
+	written = 0;
+	if (log->obuf.used > 0)
+		written = xlog_tx_defer(log);
+	if (written < 0)
+		goto error;
+	/*
+	 * Write the rest of the blocks along with the sync, which
+	 * also covers the blocks written when there were too many
+	 * of them.
+	 */
+	rc = xlog_write_pending(log, true);
+	if (rc < 0)
+		goto error;
+	return written + rc;
+error:
+	assert(offset <= log->offset);
+	xlog_discard(log, offset, log->offset);
+	log->offset = offset;
+	return -1;
+}
+
+void
+xlog_stream_group_create(struct xlog_stream_group *group, struct xlog *log,
+			 int64_t first_lsn)
+{
+	group->log = log;
+	tt_pthread_mutex_init(&group->mutex, NULL);
+	tt_pthread_cond_init(&group->cond, NULL);
+	group->next_lsn = first_lsn;
+	group->next_block = 0;
+	group->write_block = 0;
+}
+
+void
+xlog_stream_group_destroy(struct xlog_stream_group *group)
+{
+	tt_pthread_cond_destroy(&group->cond);
+	tt_pthread_mutex_destroy(&group->mutex);
+}
+
+int
+xlog_stream_create(struct xlog_stream *stream,
+		   struct xlog_stream_group *group)
+{
+	stream->group = group;
+	stream->rows = NULL;
+	stream->row_count = 0;
+	stream->row_capacity = 0;
+	stream->zctx = NULL;
+	if (!group->log->opts.no_compression) {
+		stream->zctx = ZSTD_createCCtx();
+		if (stream->zctx == NULL) {
+			diag_set(ClientError, ER_COMPRESSION,
+				 "failed to create context");
+			return -1;
+		}
+	}
+	obuf_create(&stream->data, &cord()->slabc,
+		    XLOG_TX_AUTOCOMMIT_THRESHOLD);
+	obuf_create(&stream->obuf, &cord()->slabc,
+		    XLOG_TX_AUTOCOMMIT_THRESHOLD);
+	obuf_create(&stream->zbuf, &cord()->slabc,
+		    XLOG_TX_AUTOCOMMIT_THRESHOLD);
+	return 0;
+}
+
+void
+xlog_stream_destroy(struct xlog_stream *stream)
+{
+	assert(stream->obuf.slabc == &cord()->slabc);
+	free(stream->rows);
+	obuf_destroy(&stream->data);
+	obuf_destroy(&stream->obuf);
+	obuf_destroy(&stream->zbuf);
+	ZSTD_freeCCtx(stream->zctx);
+	TRASH(stream);
+}
+
+static void
+xlog_stream_unlock_cb(void *mutex)
+{
+	tt_pthread_mutex_unlock((pthread_mutex_t *)mutex);
+}
+
+/**
+ * Encode the rows accumulated by a stream into a block, numbering
+ * them, and write it to the log file. Only numbering the rows and
+ * writing the block are done under the mutex: blocks are encoded
+ * and compressed in parallel and then written in the order their
+ * rows were numbered.
+ */
+static ssize_t
+xlog_stream_write(struct xlog_stream *stream)
+{
+	struct xlog_stream_group *group = stream->group;
+	struct xlog *log = group->log;
+	if (stream->row_count == 0)
 		return 0;
-	return xlog_tx_write(log);
+	tt_pthread_mutex_lock(&group->mutex);
+	int64_t lsn = group->next_lsn;
+	int64_t block = group->next_block++;
+	group->next_lsn += stream->row_count;
+	tt_pthread_mutex_unlock(&group->mutex);
+
+	ssize_t written = -1;
+	struct obuf *buf = &stream->obuf;
+	for (int i = 0; i < stream->row_count; i++) {
+		stream->rows[i].lsn = lsn++;
+		if (xlog_tx_append_row(buf, &stream->rows[i]) < 0)
+			goto write;
+	}
+	if (!log->opts.no_compression &&
+	    obuf_size(buf) >= XLOG_TX_COMPRESS_THRESHOLD) {
+		if (xlog_tx_encode_zstd(buf, &stream->zbuf,
+					stream->zctx) != 0)
+			goto write;
+		buf = &stream->zbuf;
+	} else {
+		xlog_tx_encode_plain(buf);
+	}
+	written = 0;
+write:
+	tt_pthread_mutex_lock(&group->mutex);
+	/*
+	 * Don't leave the mutex locked if the thread is cancelled
+	 * while waiting or writing, otherwise other streams would
+	 * block on it forever and couldn't be cancelled.
+	 */
+	pthread_cleanup_push(xlog_stream_unlock_cb, &group->mutex);
+	while (group->write_block != block)
+		tt_pthread_cond_wait(&group->cond, &group->mutex);
+	/*
+	 * A block that failed to encode still takes its turn so
+	 * that the blocks following it aren't blocked forever.
+	 */
+	if (written == 0) {
+		written = xlog_tx_write_buf(log, buf);
+		written = xlog_tx_complete(log, written, obuf_size(buf),
+					   stream->row_count);
+	}
+	group->write_block++;
+	tt_pthread_cond_broadcast(&group->cond);
+	pthread_cleanup_pop(1);
+	obuf_reset(&stream->data);
+	obuf_reset(&stream->obuf);
+	obuf_reset(&stream->zbuf);
+	stream->row_count = 0;
+	return written;
+}
+
+ssize_t
+xlog_stream_write_row(struct xlog_stream *stream,
+		      const struct xrow_header *packet)
+{
+	if (stream->row_count == stream->row_capacity) {
+		int capacity = MAX(stream->row_capacity * 2, 64);
+		size_t size = capacity * sizeof(stream->rows[0]);
+		struct xrow_header *rows =
+			(struct xrow_header *)realloc(stream->rows, size);
+		if (rows == NULL) {
+			diag_set(OutOfMemory, size, "realloc", "rows");
+			return -1;
+		}
+		stream->rows = rows;
+		stream->row_capacity = capacity;
+	}
+	/* The caller may reuse the row body, copy it. */
+	size_t size = 0;
+	for (int i = 0; i < packet->bodycnt; i++)
+		size += packet->body[i].iov_len;
+	char *body = (char *)obuf_alloc(&stream->data, size);
+	if (body == NULL) {
+		diag_set(OutOfMemory, size, "runtime arena",
+			 "xlog stream row body");
+		return -1;
+	}
+	struct xrow_header *row = &stream->rows[stream->row_count++];
+	*row = *packet;
+	row->bodycnt = 1;
+	row->body[0].iov_base = body;
+	row->body[0].iov_len = size;
+	for (int i = 0; i < packet->bodycnt; i++) {
+		memcpy(body, packet->body[i].iov_base,
+		       packet->body[i].iov_len);
+		body += packet->body[i].iov_len;
+	}
+	if (obuf_size(&stream->data) >= XLOG_TX_AUTOCOMMIT_THRESHOLD &&
+	    xlog_stream_write(stream) < 0)
+		return -1;
+	return size;
+}
+
+ssize_t
+xlog_stream_flush(struct xlog_stream *stream)
+{
+	return xlog_stream_write(stream);
 }
 
 static int
@@ -1453,6 +2008,23 @@ xlog_sync(struct xlog *l)
 	return 0;
 }
 
+int
+xlog_datasync(struct xlog *l, off_t offset)
+{
+	ERROR_INJECT(ERRINJ_WAL_SYNC_DISK, {
+		diag_set(ClientError, ER_INJECTION, "xlog sync injection");
+		goto error;
+	});
+	if (fdatasync(l->fd) == 0)
+		return 0;
+	diag_set(SystemError, "failed to sync '%s' file", l->filename);
+error:
+	assert(offset <= l->offset);
+	xlog_discard(l, offset, l->offset);
+	l->offset = offset;
+	return -1;
+}
+
 static int
 xlog_write_eof(struct xlog *l)
 {
@@ -1465,8 +2037,11 @@ xlog_write_eof(struct xlog *l)
 	 * Free disk space preallocated with xlog_fallocate().
 	 * Don't write the eof marker if this fails, otherwise
 	 * we'll get "data after eof marker" error on recovery.
+	 * A preallocated file keeps its size so that it can be
+	 * recycled.
 	 */
-	if (l->allocated > 0 && ftruncate(l->fd, l->offset) < 0) {
+	if (l->allocated > 0 && !l->meta.is_preallocated &&
+	    ftruncate(l->fd, l->offset) < 0) {
 		diag_set(SystemError, "ftruncate() failed");
 		return -1;
 	}
@@ -1691,6 +2266,39 @@ xlog_fixheader_decode(struct xlog_fixheader *fixheader,
 	return 0;
 }
 
+/**
+ * Erase a torn tx at the end of data of a preallocated xlog file
+ * opened for appending, see xlog_cursor_tx_is_torn(). Otherwise
+ * its remains would follow the rows appended to the file and be
+ * taken for corruption.
+ */
+static int
+xlog_erase_torn_tx(struct xlog *xlog, off_t file_size)
+{
+	char buf[XLOG_FIXHEADER_SIZE];
+	ssize_t len = fio_pread(xlog->fd, buf, sizeof(buf), xlog->offset);
+	if (len < 0) {
+		diag_set(SystemError, "failed to read file '%s'",
+			 xlog->filename);
+		return -1;
+	}
+	off_t end = xlog->offset + len;
+	struct xlog_fixheader fixheader;
+	const char *pos = buf;
+	ssize_t rc = xlog_fixheader_decode(&fixheader, &pos, buf + len);
+	if (rc == 0)
+		end += fixheader.len;
+	else if (rc < 0)
+		diag_clear(diag_get());
+	if (xlog_write_zeros(xlog->fd, xlog->offset,
+			     MIN(end, file_size)) != 0) {
+		diag_set(SystemError, "failed to erase torn data "
+			 "in file '%s'", xlog->filename);
+		return -1;
+	}
+	return 0;
+}
+
 int
 xlog_tx_decode(const char *data, const char *data_end,
 	       char *rows, char *rows_end, ZSTD_DStream *zdctx)
@@ -1749,55 +2357,68 @@ xlog_tx_decode(const char *data, const char *data_end,
 }
 
 /**
+ * Decode the fixheader of a tx and validate the tx checksum.
+ * On success *data is set to the tx data following the fixheader.
+ *
  * @retval -1 error
  * @retval 0 success
  * @retval >0 how many bytes we will have for continue
  */
-ssize_t
-xlog_tx_cursor_create(struct xlog_tx_cursor *tx_cursor,
-		      const char **data, const char *data_end,
-		      ZSTD_DStream *zdctx)
+static ssize_t
+xlog_tx_check(struct xlog_fixheader *fixheader, const char **data,
+	      const char *data_end)
 {
 	const char *rpos = *data;
-	struct xlog_fixheader fixheader;
 	ssize_t to_load;
-	to_load = xlog_fixheader_decode(&fixheader, &rpos, data_end);
+	to_load = xlog_fixheader_decode(fixheader, &rpos, data_end);
 	if (to_load != 0)
 		return to_load;
 
 	/* Check that buffer has enough bytes */
-	if ((data_end - rpos) < (ptrdiff_t)fixheader.len)
-		return fixheader.len - (data_end - rpos);
+	if ((data_end - rpos) < (ptrdiff_t)fixheader->len)
+		return fixheader->len - (data_end - rpos);
 
 	ERROR_INJECT(ERRINJ_XLOG_GARBAGE, {
-		*((char *)rpos + fixheader.len / 2) = ~*((char *)rpos + fixheader.len / 2);
+		*((char *)rpos + fixheader->len / 2) = ~*((char *)rpos + fixheader->len / 2);
 	});
 
 	/* Validate checksum */
-	if (crc32_calc(0, rpos, fixheader.len) != fixheader.crc32c) {
+	if (crc32_calc(0, rpos, fixheader->len) != fixheader->crc32c) {
 		diag_set(XlogError, "tx checksum mismatch");
 		return -1;
 	}
-	data_end = rpos + fixheader.len;
+	*data = rpos;
+	return 0;
+}
 
+/**
+ * Copy or decompress the data of a checked tx to a tx cursor.
+ *
+ * @retval -1 error
+ * @retval 0 success
+ */
+static int
+xlog_tx_cursor_unpack(struct xlog_tx_cursor *tx_cursor,
+		      const struct xlog_fixheader *fixheader,
+		      const char *rpos, ZSTD_DStream *zdctx)
+{
+	const char *data_end = rpos + fixheader->len;
 	ibuf_create(&tx_cursor->rows, &cord()->slabc,
 		    XLOG_TX_AUTOCOMMIT_THRESHOLD);
-	if (fixheader.magic == row_marker) {
-		void *dst = ibuf_alloc(&tx_cursor->rows, fixheader.len);
+	if (fixheader->magic == row_marker) {
+		void *dst = ibuf_alloc(&tx_cursor->rows, fixheader->len);
 		if (dst == NULL) {
-			diag_set(OutOfMemory, fixheader.len,
+			diag_set(OutOfMemory, fixheader->len,
 				 "runtime", "xlog rows buffer");
 			ibuf_destroy(&tx_cursor->rows);
 			return -1;
 		}
-		memcpy(dst, rpos, fixheader.len);
-		*data = (char *)rpos + fixheader.len;
-		assert(*data <= data_end);
+		memcpy(dst, rpos, fixheader->len);
 		tx_cursor->size = ibuf_used(&tx_cursor->rows);
 		return 0;
 	};
 
-	assert(fixheader.magic == zrow_marker);
+	assert(fixheader->magic == zrow_marker);
 	ZSTD_initDStream(zdctx);
 	int rc;
 	do {
@@ -1811,15 +2432,51 @@ xlog_tx_cursor_create(struct xlog_tx_cursor *tx_cursor,
 	} while ((rc = xlog_cursor_decompress(&tx_cursor->rows.wpos,
 					      tx_cursor->rows.end, &rpos,
 					      data_end, zdctx)) == 1);
-	if (rc != 0)
+	if (rc != 0) {
+		ibuf_destroy(&tx_cursor->rows);
 		return -1;
+	}
+	assert(rpos == data_end);
+	tx_cursor->size = ibuf_used(&tx_cursor->rows);
+	return 0;
+}
 
-	*data = rpos;
+/**
+ * @retval -1 error
+ * @retval 0 success
+ * @retval >0 how many bytes we will have for continue
+ */
+ssize_t
+xlog_tx_cursor_create(struct xlog_tx_cursor *tx_cursor,
+		      const char **data, const char *data_end,
+		      ZSTD_DStream *zdctx)
+{
+	const char *rpos = *data;
+	struct xlog_fixheader fixheader;
+	ssize_t to_load = xlog_tx_check(&fixheader, &rpos, data_end);
+	if (to_load != 0)
+		return to_load;
+	if (xlog_tx_cursor_unpack(tx_cursor, &fixheader, rpos, zdctx) != 0)
+		return -1;
+	*data = rpos + fixheader.len;
 	assert(*data <= data_end);
-	tx_cursor->size = ibuf_used(&tx_cursor->rows);
 	return 0;
 }
 
+int
+xlog_tx_cursor_create_raw(struct xlog_tx_cursor *tx_cursor,
+			  const char *data, const char *data_end,
+			  ZSTD_DStream *zdctx)
+{
+	struct xlog_fixheader fixheader;
+	ssize_t rc = xlog_fixheader_decode(&fixheader, &data, data_end);
+	if (rc < 0)
+		return -1;
+	assert(rc == 0);
+	assert(data + fixheader.len == data_end);
+	return xlog_tx_cursor_unpack(tx_cursor, &fixheader, data, zdctx);
+}
+
 int
 xlog_tx_cursor_next_row(struct xlog_tx_cursor *tx_cursor,
 		        struct xrow_header *xrow)
@@ -1875,8 +2532,68 @@ xlog_cursor_find_tx_magic(struct xlog_cursor *i)
 	return 0;
 }
 
-int
-xlog_cursor_next_tx(struct xlog_cursor *i)
+/**
+ * Check if @a size bytes at @a offset from the cursor position
+ * are all zero. Bytes past the end of the file count as zero.
+ *
+ * @retval 1 the bytes are zero
+ * @retval 0 there's a non-zero byte
+ * @retval -1 read error
+ */
+static int
+xlog_cursor_is_zero(struct xlog_cursor *i, size_t offset, size_t size)
+{
+	if (xlog_cursor_ensure(i, offset + size) < 0)
+		return -1;
+	size_t used = ibuf_used(&i->rbuf);
+	if (used <= offset)
+		return 1;
+	const char *pos = i->rbuf.rpos + offset;
+	const char *end = i->rbuf.rpos + MIN(used, offset + size);
+	for (; pos < end; pos++) {
+		if (*pos != 0)
+			return 0;
+	}
+	return 1;
+}
+
+/**
+ * Check if a broken tx at the cursor position in a preallocated
+ * file is followed by zeros. Such a tx is being written right now
+ * or was torn by a crash, because the file is written sequentially
+ * and was zero-filled beforehand. A broken tx followed by data is
+ * corruption.
+ *
+ * @retval 1 the tx is torn
+ * @retval 0 the tx is corrupted
+ * @retval -1 read error
+ */
+static int
+xlog_cursor_tx_is_torn(struct xlog_cursor *i)
+{
+	/*
+	 * If the fixheader is broken, the tx length is unknown,
+	 * but a torn fixheader must be followed by zeros, too.
+	 */
+	size_t tx_size = XLOG_FIXHEADER_SIZE;
+	struct xlog_fixheader fixheader;
+	const char *pos = i->rbuf.rpos;
+	if (xlog_fixheader_decode(&fixheader, &pos, i->rbuf.wpos) == 0)
+		tx_size += fixheader.len;
+	return xlog_cursor_is_zero(i, tx_size, XLOG_FIXHEADER_SIZE);
+}
+
+/**
+ * Read the next tx to the cursor buffer and validate its checksum.
+ * On success the tx starts at the current read position and its
+ * fixheader is decoded to @a fixheader.
+ *
+ * @retval 0 success
+ * @retval 1 eof
+ * @retval -1 error, check diag
+ */
+static int
+xlog_cursor_read_tx(struct xlog_cursor *i, struct xlog_fixheader *fixheader)
 {
 	int rc;
 	assert(xlog_cursor_is_open(i));
@@ -1891,11 +2608,26 @@ xlog_cursor_next_tx(struct xlog_cursor *i)
 		/* eof marker found */
 		goto eof_found;
 	}
+	if (i->meta.is_preallocated && load_u32(i->rbuf.rpos) == 0) {
+		/*
+		 * The rest of a preallocated file is zero-filled.
+		 * A zero magic followed by data is corruption.
+		 */
+		rc = xlog_cursor_is_zero(i, 0, XLOG_FIXHEADER_SIZE);
+		if (rc < 0)
+			return -1;
+		if (rc > 0)
+			goto data_end;
+		diag_set(XlogError, "invalid magic: 0x0");
+		return -1;
+	}
 
 	ssize_t to_load;
-	while ((to_load = xlog_tx_cursor_create(&i->tx_cursor,
-						(const char **)&i->rbuf.rpos,
-						i->rbuf.wpos, i->zdctx)) > 0) {
+	while (true) {
+		const char *rpos = i->rbuf.rpos;
+		to_load = xlog_tx_check(fixheader, &rpos, i->rbuf.wpos);
+		if (to_load <= 0)
+			break;
 		/* not enough data in read buffer */
 		int rc = xlog_cursor_ensure(i, ibuf_used(&i->rbuf) + to_load);
 		if (rc < 0)
@@ -1903,16 +2635,46 @@ xlog_cursor_next_tx(struct xlog_cursor *i)
 		if (rc > 0)
 			return 1;
 	}
-	if (to_load < 0)
+	if (to_load < 0) {
+		/*
+		 * A torn tx at the end of data of a preallocated
+		 * file is the same as a truncated tx at the end of
+		 * a regular file.
+		 */
+		if (i->meta.is_preallocated &&
+		    diag_last_error(diag_get())->type == &type_XlogError) {
+			rc = xlog_cursor_tx_is_torn(i);
+			if (rc < 0)
+				return -1;
+			if (rc > 0) {
+				diag_clear(diag_get());
+				goto data_end;
+			}
+		}
 		return -1;
-
-	i->state = XLOG_CURSOR_TX;
+	}
 	return 0;
+data_end:
+	/*
+	 * The rest of a preallocated file is zero-filled. Drop
+	 * what was read after the end of data so that rows that
+	 * are appended later are re-read from the file.
+	 */
+	if (i->fd >= 0) {
+		i->read_offset = xlog_cursor_pos(i);
+		ibuf_reset(&i->rbuf);
+	}
+	return 1;
 eof_found:
 	/*
 	 * A eof marker is read, check that there is no
-	 * more data in the file.
+	 * more data in the file. A preallocated file is
+	 * zero-filled after the marker.
 	 */
+	if (i->meta.is_preallocated) {
+		i->state = XLOG_CURSOR_EOF;
+		return 1;
+	}
 	rc = xlog_cursor_ensure(i, sizeof(log_magic_t) + sizeof(char));
 
 	if (rc < 0)
@@ -1927,6 +2689,37 @@ eof_found:
 	return 1;
 }
 
+int
+xlog_cursor_next_tx(struct xlog_cursor *i)
+{
+	struct xlog_fixheader fixheader;
+	int rc = xlog_cursor_read_tx(i, &fixheader);
+	if (rc != 0)
+		return rc;
+	const char *rpos = i->rbuf.rpos + XLOG_FIXHEADER_SIZE;
+	if (xlog_tx_cursor_unpack(&i->tx_cursor, &fixheader, rpos,
+				  i->zdctx) != 0)
+		return -1;
+	i->rbuf.rpos = (char *)rpos + fixheader.len;
+	i->state = XLOG_CURSOR_TX;
+	return 0;
+}
+
+int
+xlog_cursor_next_tx_raw(struct xlog_cursor *i, const char **data,
+			const char **data_end)
+{
+	assert(i->state != XLOG_CURSOR_TX);
+	struct xlog_fixheader fixheader;
+	int rc = xlog_cursor_read_tx(i, &fixheader);
+	if (rc != 0)
+		return rc;
+	*data = i->rbuf.rpos;
+	*data_end = i->rbuf.rpos + XLOG_FIXHEADER_SIZE + fixheader.len;
+	i->rbuf.rpos = (char *)*data_end;
+	return 0;
+}
+
 int
 xlog_cursor_next_row(struct xlog_cursor *cursor, struct xrow_header *xrow)
 {
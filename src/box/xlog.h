@@ -30,6 +30,7 @@
  * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  */
+#include <pthread.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include <sys/stat.h>
@@ -319,6 +320,13 @@ struct xlog_meta {
 	 * directory for missing WALs.
 	 */
 	struct vclock prev_vclock;
+	/**
+	 * Text file header: set if the file was zero-filled
+	 * to its full size before the header was written.
+	 * The end of data in such a file is not the end of
+	 * the file, but the first zero fixheader.
+	 */
+	bool is_preallocated;
 };
 
 /**
@@ -395,6 +403,19 @@ struct xlog {
 	 * Compressed output buffer
 	 */
 	struct obuf zbuf;
+	/**
+	 * Encoded blocks of rows not written to the file yet.
+	 * Allocated only if the file is written by a thread with
+	 * an io_uring instance: then the blocks are accumulated
+	 * until xlog_flush() and written with one system call.
+	 */
+	struct obuf *pending;
+	/** Number of blocks in @pending. */
+	int pending_count;
+	/** Max size of the blocks in @pending, see xlog_tx_write(). */
+	size_t pending_size;
+	/** Number of rows in the blocks in @pending. */
+	int64_t pending_rows;
 	/**
 	 * Synced file size
 	 */
@@ -434,6 +455,19 @@ int
 xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 		 const struct vclock *vclock);
 
+/**
+ * Create a new file in the same way as xdir_create_xlog(),
+ * but reuse the zero-filled file @a spare for it instead of
+ * creating a new one, so that writes don't change the file
+ * size. The spare file is renamed.
+ *
+ * @retval 0 if OK
+ * @retval -1 if error
+ */
+int
+xdir_create_xlog_preallocated(struct xdir *dir, struct xlog *xlog,
+			      const struct vclock *vclock, const char *spare);
+
 /**
  * Create new xlog writer based on fd.
  * @param fd            file descriptor
@@ -538,6 +572,117 @@ xlog_tx_rollback(struct xlog *log);
 ssize_t
 xlog_flush(struct xlog *log);
 
+/**
+ * Flush buffered rows like xlog_flush() and flush the data written
+ * to the file to disk like xlog_datasync(). If the file is written
+ * through io_uring, the writes and the sync are submitted at once.
+ * On failure the file is truncated to @a offset.
+ *
+ * @retval -1 error
+ * @retval >= 0 the number of bytes written
+ */
+ssize_t
+xlog_flush_datasync(struct xlog *log, off_t offset);
+
+/**
+ * Streams of rows written to the same xlog file concurrently,
+ * see xlog_stream. Blocks of rows are written to the file in the
+ * order in which the streams flush them, and rows are numbered
+ * when a block is flushed, so row LSNs grow in the file order.
+ */
+struct xlog_stream_group {
+	/** The log the streams write to. */
+	struct xlog *log;
+	/** Protects the members below and writes to the log. */
+	pthread_mutex_t mutex;
+	/** Signaled when a block is written to the log. */
+	pthread_cond_t cond;
+	/** LSN of the first row of the next flushed block. */
+	int64_t next_lsn;
+	/** Sequence number of the next flushed block. */
+	int64_t next_block;
+	/** Sequence number of the next block to write to the log. */
+	int64_t write_block;
+};
+
+/**
+ * Create a group of streams writing to @a log. Rows written by
+ * the streams are numbered starting from @a first_lsn.
+ */
+void
+xlog_stream_group_create(struct xlog_stream_group *group, struct xlog *log,
+			 int64_t first_lsn);
+
+void
+xlog_stream_group_destroy(struct xlog_stream_group *group);
+
+/**
+ * A stream of rows written to an xlog file concurrently with
+ * other streams of the same file. Each stream accumulates rows
+ * in its own buffer, encodes and compresses them with its own
+ * context, so streams running in different threads encode and
+ * compress rows in parallel and only serialize writes of the
+ * finished blocks to the file. Rows of different streams are
+ * interleaved in the file at block granularity.
+ *
+ * A stream must be used in the thread that created it. The log
+ * must not be written directly while it has active streams.
+ */
+struct xlog_stream {
+	/** The streams writing to the same log. */
+	struct xlog_stream_group *group;
+	/** Rows added since the last flush, encoded at flush. */
+	struct xrow_header *rows;
+	/** Number of rows in the rows array. */
+	int row_count;
+	/** Capacity of the rows array. */
+	int row_capacity;
+	/** Copies of the bodies of the rows. */
+	struct obuf data;
+	/** Output buffer, works as row accumulator. */
+	struct obuf obuf;
+	/** The context of zstd compression. */
+	ZSTD_CCtx *zctx;
+	/** Compressed output buffer. */
+	struct obuf zbuf;
+};
+
+/**
+ * Create a stream writing to the log of @a group.
+ *
+ * @retval 0 success
+ * @retval -1 error, diag is set
+ */
+int
+xlog_stream_create(struct xlog_stream *stream,
+		   struct xlog_stream_group *group);
+
+/**
+ * Destroy a stream. Rows that haven't been flushed are lost.
+ */
+void
+xlog_stream_destroy(struct xlog_stream *stream);
+
+/**
+ * Add a row to a stream and write the accumulated rows to the
+ * log file if the stream buffer is full. The row LSN is ignored,
+ * it's assigned when the row is written, see xlog_stream_group.
+ *
+ * @retval count of bytes added to the buffer
+ * @retval -1 for error
+ */
+ssize_t
+xlog_stream_write_row(struct xlog_stream *stream,
+		      const struct xrow_header *packet);
+
+/**
+ * Write rows accumulated by a stream to the log file.
+ *
+ * @retval count of written bytes
+ * @retval -1 for error
+ */
+ssize_t
+xlog_stream_flush(struct xlog_stream *stream);
 
 /**
  * Sync a log file. The exact action is defined
@@ -549,6 +694,17 @@ xlog_flush(struct xlog *log);
 int
 xlog_sync(struct xlog *l);
 
+/**
+ * Synchronously flush the data written to a log file to disk.
+ * On failure the data written after @a offset may be lost, so
+ * the file is truncated to it.
+ *
+ * @retval 0 success
+ * @retval -1 error
+ */
+int
+xlog_datasync(struct xlog *l, off_t offset);
+
 /**
  * Close the log file and free xlog object.
  *
@@ -591,6 +747,19 @@ xlog_tx_cursor_create(struct xlog_tx_cursor *cursor,
 		      const char **data, const char *data_end,
 		      ZSTD_DStream *zdctx);
 
+/**
+ * Create xlog tx iterator from a tx returned by
+ * xlog_cursor_next_tx_raw(). The tx checksum isn't checked
+ * again.
+ *
+ * @retval 0 for Ok
+ * @retval -1 for error
+ */
+int
+xlog_tx_cursor_create_raw(struct xlog_tx_cursor *tx_cursor,
+			  const char *data, const char *data_end,
+			  ZSTD_DStream *zdctx);
+
 /**
  * Destroy xlog tx cursor and free all associated memory
  * including parsed xrows
@@ -750,6 +919,21 @@ xlog_cursor_close(struct xlog_cursor *cursor, bool reuse_fd);
 int
 xlog_cursor_next_tx(struct xlog_cursor *cursor);
 
+/**
+ * Read next tx from xlog and validate its checksum without
+ * decompressing it, so that it can be decompressed by another
+ * thread with xlog_tx_cursor_create_raw(). The tx, including its
+ * fixheader, is returned in @a data and @a data_end, which point
+ * to the cursor buffer and are valid until the next call.
+ * @param cursor cursor
+ * @retval 0 succes
+ * @retval 1 eof
+ * retval -1 error, check diag
+ */
+int
+xlog_cursor_next_tx_raw(struct xlog_cursor *cursor, const char **data,
+			const char **data_end);
+
 /**
  * Fetch next xrow from current xlog tx
  *
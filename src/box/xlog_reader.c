@@ -0,0 +1,658 @@
+/*
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "xlog_reader.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "error.h"
+#include "fiber.h"
+#include "iproto_constants.h"
+#include "say.h"
+#include "trivia/util.h"
+#include "xrow.h"
+
+enum {
+	/** Max number of rows or txs in a batch read by a reader. */
+	XLOG_READER_BATCH_ROWS = 1024,
+	/** Max size of txs in a batch read by an xlog reader. */
+	XLOG_READER_BATCH_SIZE = 1024 * 1024,
+	/**
+	 * Max number of txs or errors in a batch: each step of
+	 * reading adds at most two of them, see xlog_reader_read_tx().
+	 */
+	XLOG_READER_BATCH_ITEMS = 2 * XLOG_READER_BATCH_ROWS + 2,
+};
+
+/** Number of messages allocated for a reader. */
+static inline int
+xlog_reader_msg_capacity(struct xlog_reader *reader)
+{
+	return 2 * MAX(reader->thread_count, 1);
+}
+
+/**
+ * Check if an error found by a reader thread must stop reading,
+ * because it can't be skipped even with force_recovery.
+ */
+static inline bool
+xlog_reader_error_is_fatal(struct xlog_reader *reader, struct error *e)
+{
+	return !reader->read_past_errors || e->type != &type_XlogError;
+}
+
+/**
+ * Move the last error from diag to a batch at the current
+ * position. Returns -1 if reading must be stopped.
+ */
+static int
+xlog_reader_add_error(struct xlog_reader_msg *msg)
+{
+	struct error *e = diag_last_error(diag_get());
+	assert(e != NULL);
+	assert(msg->error_count < XLOG_READER_BATCH_ITEMS);
+	struct xlog_reader_error *error = &msg->errors[msg->error_count++];
+	error->row_count = msg->row_count;
+	error->error = e;
+	error_ref(e);
+	diag_clear(diag_get());
+	return xlog_reader_error_is_fatal(msg->reader, e) ? -1 : 0;
+}
+
+/**
+ * Move the last error from diag to a batch as a tx read by
+ * the reader thread. If the batch is decoded by a decoder thread,
+ * the error is moved to the batch errors by the decoder, so that
+ * its position among the rows is known. Returns -1 if reading
+ * must be stopped.
+ */
+static int
+xlog_reader_add_read_error(struct xlog_reader_msg *msg)
+{
+	if (msg->decoder == NULL)
+		return xlog_reader_add_error(msg);
+	struct error *e = diag_last_error(diag_get());
+	assert(e != NULL);
+	assert(msg->tx_count < XLOG_READER_BATCH_ITEMS);
+	struct xlog_reader_tx *tx = &msg->txs[msg->tx_count++];
+	tx->data = NULL;
+	tx->data_end = NULL;
+	tx->error = e;
+	error_ref(e);
+	diag_clear(diag_get());
+	return xlog_reader_error_is_fatal(msg->reader, e) ? -1 : 0;
+}
+
+/**
+ * Decode the body of a DML row to a request so that the tx thread
+ * doesn't have to. If the row isn't a DML request or can't be
+ * decoded, request::header is set to NULL and the row is left for
+ * the tx thread to decode, so that errors are reported by it in
+ * the same way as for rows read inline.
+ */
+static void
+xlog_reader_decode_dml(struct xrow_header *row, struct request *request)
+{
+	if (!iproto_type_is_dml(row->type) ||
+	    xrow_decode_dml(row, request,
+			    dml_request_key_map(row->type)) != 0) {
+		diag_clear(diag_get());
+		request->header = NULL;
+	}
+}
+
+/** Add a row to a batch. Returns -1 and sets diag on error. */
+static int
+xlog_reader_add_row(struct xlog_reader_msg *msg, struct xrow_header *row)
+{
+	if (msg->row_count == msg->row_capacity) {
+		int capacity = MAX(msg->row_capacity * 2,
+				   XLOG_READER_BATCH_ROWS);
+		size_t size = capacity * sizeof(msg->rows[0]);
+		struct xrow_header *rows =
+			(struct xrow_header *)realloc(msg->rows, size);
+		if (rows == NULL) {
+			diag_set(OutOfMemory, size, "realloc", "rows");
+			return -1;
+		}
+		msg->rows = rows;
+		size = capacity * sizeof(msg->requests[0]);
+		struct request *requests =
+			(struct request *)realloc(msg->requests, size);
+		if (requests == NULL) {
+			diag_set(OutOfMemory, size, "realloc", "requests");
+			return -1;
+		}
+		msg->requests = requests;
+		msg->row_capacity = capacity;
+	}
+	/* The tx buffer is freed after decoding, copy row bodies. */
+	for (int i = 0; i < row->bodycnt; i++) {
+		size_t len = row->body[i].iov_len;
+		void *body = region_alloc(&msg->region, len);
+		if (body == NULL) {
+			diag_set(OutOfMemory, len, "region_alloc",
+				 "row body");
+			return -1;
+		}
+		memcpy(body, row->body[i].iov_base, len);
+		row->body[i].iov_base = body;
+	}
+	msg->rows[msg->row_count] = *row;
+	xlog_reader_decode_dml(&msg->rows[msg->row_count],
+			       &msg->requests[msg->row_count]);
+	msg->row_count++;
+	return 0;
+}
+
+/**
+ * Decompress and decode the rows of a tx and add them to a batch.
+ * A corrupted tx is added to the batch as an error, the rows that
+ * precede the corruption are kept. Returns -1 if reading must be
+ * stopped.
+ */
+static int
+xlog_reader_decode_tx(struct xlog_reader_msg *msg, const char *data,
+		      const char *data_end, ZSTD_DStream *zdctx)
+{
+	struct xlog_tx_cursor tx_cursor;
+	if (xlog_tx_cursor_create_raw(&tx_cursor, data, data_end,
+				      zdctx) != 0)
+		return xlog_reader_add_error(msg);
+	int rc;
+	struct xrow_header row;
+	while ((rc = xlog_tx_cursor_next_row(&tx_cursor, &row)) == 0) {
+		if (xlog_reader_add_row(msg, &row) != 0) {
+			rc = -1;
+			break;
+		}
+	}
+	xlog_tx_cursor_destroy(&tx_cursor);
+	if (rc < 0)
+		return xlog_reader_add_error(msg);
+	return 0;
+}
+
+/**
+ * Read the next tx of the file to a batch. If the batch is
+ * decoded by the reader thread, the tx is decoded right away,
+ * otherwise it's copied to be decoded by a decoder thread.
+ * A corrupted tx is added to the batch as an error and skipped
+ * like xlog_cursor_next() does.
+ *
+ * @retval  0 success
+ * @retval  1 no more txs
+ * @retval -1 reading must be stopped, the error is added to
+ *            the batch
+ */
+static int
+xlog_reader_read_tx(struct xlog_reader_msg *msg, size_t *size)
+{
+	struct xlog_cursor *cursor = &msg->reader->cursor;
+	const char *data, *data_end;
+	int rc = xlog_cursor_next_tx_raw(cursor, &data, &data_end);
+	if (rc > 0)
+		return 1;
+	if (rc < 0) {
+		if (xlog_reader_add_read_error(msg) != 0)
+			return -1;
+		rc = xlog_cursor_find_tx_magic(cursor);
+		if (rc < 0) {
+			xlog_reader_add_read_error(msg);
+			return -1;
+		}
+		return rc;
+	}
+	*size += data_end - data;
+	if (msg->decoder == NULL)
+		return xlog_reader_decode_tx(msg, data, data_end,
+					     cursor->zdctx);
+	char *copy = (char *)region_alloc(&msg->tx_region, data_end - data);
+	if (copy == NULL) {
+		diag_set(OutOfMemory, data_end - data, "region_alloc", "tx");
+		xlog_reader_add_read_error(msg);
+		return -1;
+	}
+	memcpy(copy, data, data_end - data);
+	assert(msg->tx_count < XLOG_READER_BATCH_ITEMS);
+	struct xlog_reader_tx *tx = &msg->txs[msg->tx_count++];
+	tx->data = copy;
+	tx->data_end = copy + (data_end - data);
+	tx->error = NULL;
+	return 0;
+}
+
+/** Free what was read to a message before. */
+static void
+xlog_reader_msg_reset(struct xlog_reader_msg *msg)
+{
+	for (int i = 0; i < msg->tx_count; i++) {
+		if (msg->txs[i].error != NULL)
+			error_unref(msg->txs[i].error);
+	}
+	for (int i = 0; i < msg->error_count; i++)
+		error_unref(msg->errors[i].error);
+	msg->tx_count = 0;
+	msg->error_count = 0;
+	msg->row_count = 0;
+}
+
+/** Create the region of a message in the thread decoding it. */
+static void
+xlog_reader_msg_prepare(struct xlog_reader_msg *msg)
+{
+	if (!msg->is_region_created) {
+		region_create(&msg->region, &cord()->slabc);
+		msg->is_region_created = true;
+	}
+	region_free(&msg->region);
+}
+
+/** Fill a message with rows or txs. Runs in the reader thread. */
+static void
+xlog_reader_read_f(struct cmsg *base)
+{
+	struct xlog_reader_msg *msg = (struct xlog_reader_msg *)base;
+	struct xlog_reader *reader = msg->reader;
+	xlog_reader_msg_reset(msg);
+	region_free(&msg->tx_region);
+	if (msg->decoder == NULL)
+		xlog_reader_msg_prepare(msg);
+	if (reader->is_done) {
+		msg->is_done = true;
+		return;
+	}
+	if (!xlog_cursor_is_open(&reader->cursor) &&
+	    xlog_cursor_open(&reader->cursor, reader->filename) != 0) {
+		xlog_reader_add_read_error(msg);
+		goto done;
+	}
+	size_t size = 0;
+	for (int i = 0; i < XLOG_READER_BATCH_ROWS &&
+	     size < XLOG_READER_BATCH_SIZE &&
+	     msg->row_count < XLOG_READER_BATCH_ROWS; i++) {
+		int rc = xlog_reader_read_tx(msg, &size);
+		if (rc < 0)
+			goto done;
+		if (rc > 0) {
+			msg->is_eof = xlog_cursor_is_eof(&reader->cursor);
+			goto done;
+		}
+	}
+	return;
+done:
+	if (xlog_cursor_is_open(&reader->cursor))
+		xlog_cursor_close(&reader->cursor, false);
+	reader->is_done = true;
+	msg->is_done = true;
+}
+
+/** Decode txs of a message. Runs in a decoder thread. */
+static void
+xlog_reader_decode_f(struct cmsg *base)
+{
+	struct xlog_reader_msg *msg = (struct xlog_reader_msg *)base;
+	xlog_reader_msg_prepare(msg);
+	for (int i = 0; i < msg->tx_count; i++) {
+		struct xlog_reader_tx *tx = &msg->txs[i];
+		if (tx->error != NULL) {
+			/* Move the error to the batch errors. */
+			assert(msg->error_count < XLOG_READER_BATCH_ITEMS);
+			struct xlog_reader_error *error =
+				&msg->errors[msg->error_count++];
+			error->row_count = msg->row_count;
+			error->error = tx->error;
+			tx->error = NULL;
+			if (xlog_reader_error_is_fatal(msg->reader,
+						       error->error))
+				break;
+			continue;
+		}
+		if (xlog_reader_decode_tx(msg, tx->data, tx->data_end,
+					  msg->decoder->zdctx) != 0)
+			break;
+	}
+}
+
+/** Return a message to the tx thread. */
+static void
+xlog_reader_complete_f(struct cmsg *base)
+{
+	struct xlog_reader_msg *msg = (struct xlog_reader_msg *)base;
+	msg->is_busy = false;
+	fiber_cond_signal(&msg->reader->cond);
+}
+
+/** Destroy the regions of the messages decoded by a thread. */
+static void
+xlog_reader_destroy_regions(struct xlog_reader *reader,
+			    struct xlog_reader_decoder *decoder)
+{
+	for (int i = 0; i < xlog_reader_msg_capacity(reader); i++) {
+		struct xlog_reader_msg *msg = &reader->msgs[i];
+		if (msg->decoder == decoder && msg->is_region_created) {
+			region_destroy(&msg->region);
+			msg->is_region_created = false;
+		}
+	}
+}
+
+/** Decoder thread function. */
+static int
+xlog_reader_decoder_f(va_list ap)
+{
+	struct xlog_reader_decoder *decoder =
+		va_arg(ap, struct xlog_reader_decoder *);
+	struct cbus_endpoint endpoint;
+
+	cpipe_create(&decoder->tx_pipe, "tx_prio");
+	cbus_endpoint_create(&endpoint, cord_name(cord()),
+			     fiber_schedule_cb, fiber());
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	cpipe_destroy(&decoder->tx_pipe);
+	xlog_reader_destroy_regions(decoder->reader, decoder);
+	return 0;
+}
+
+/**
+ * Start decoder threads and connect to them. Runs in the reader
+ * thread.
+ */
+static void
+xlog_reader_start_decoders(struct xlog_reader *reader)
+{
+	for (; reader->decoder_count < reader->thread_count;
+	     reader->decoder_count++) {
+		struct xlog_reader_decoder *decoder =
+			&reader->decoders[reader->decoder_count];
+		decoder->zdctx = ZSTD_createDStream();
+		if (decoder->zdctx == NULL) {
+			diag_set(OutOfMemory, 0, "ZSTD_createDStream",
+				 "zdctx");
+			diag_log();
+			break;
+		}
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "%s.%d", cord_name(cord()),
+			 reader->decoder_count);
+		decoder->reader = reader;
+		if (cord_costart(&decoder->cord, name, xlog_reader_decoder_f,
+				 decoder) != 0) {
+			ZSTD_freeDStream(decoder->zdctx);
+			diag_log();
+			break;
+		}
+		cpipe_create(&decoder->pipe, name);
+	}
+}
+
+/** Stop decoder threads. Runs in the reader thread. */
+static void
+xlog_reader_stop_decoders(struct xlog_reader *reader)
+{
+	for (int i = 0; i < reader->decoder_count; i++) {
+		struct xlog_reader_decoder *decoder = &reader->decoders[i];
+		cbus_stop_loop(&decoder->pipe);
+		cpipe_destroy(&decoder->pipe);
+		if (cord_cojoin(&decoder->cord) != 0)
+			panic("failed to join xlog decoder thread");
+		ZSTD_freeDStream(decoder->zdctx);
+	}
+}
+
+/** Reader thread function. */
+static int
+xlog_reader_f(va_list ap)
+{
+	struct xlog_reader *reader = va_arg(ap, struct xlog_reader *);
+	struct cbus_endpoint endpoint;
+
+	for (int i = 0; i < xlog_reader_msg_capacity(reader); i++)
+		region_create(&reader->msgs[i].tx_region, &cord()->slabc);
+	xlog_reader_start_decoders(reader);
+	cpipe_create(&reader->tx_pipe, "tx_prio");
+	/*
+	 * The tx thread starts sending messages once the endpoint
+	 * is created, so decoders must have been started by then.
+	 */
+	cbus_endpoint_create(&endpoint, cord_name(cord()),
+			     fiber_schedule_cb, fiber());
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	xlog_reader_stop_decoders(reader);
+	cpipe_destroy(&reader->tx_pipe);
+	if (xlog_cursor_is_open(&reader->cursor))
+		xlog_cursor_close(&reader->cursor, false);
+	xlog_reader_destroy_regions(reader, NULL);
+	for (int i = 0; i < xlog_reader_msg_capacity(reader); i++)
+		region_destroy(&reader->msgs[i].tx_region);
+	return 0;
+}
+
+/** Send a message to the reader thread to fill it with rows. */
+static void
+xlog_reader_push(struct xlog_reader *reader, struct xlog_reader_msg *msg)
+{
+	assert(!msg->is_busy);
+	cmsg_init(&msg->base, msg->route);
+	msg->is_busy = true;
+	cpipe_push(&reader->reader_pipe, &msg->base);
+}
+
+/** Wait for a message to return from the reader thread. */
+static void
+xlog_reader_wait(struct xlog_reader *reader, struct xlog_reader_msg *msg)
+{
+	while (msg->is_busy)
+		fiber_cond_wait(&reader->cond);
+}
+
+/**
+ * Set up the messages once the reader thread has started the
+ * decoder threads: each decoder gets two messages, so that it
+ * can decode one of them while the tx thread applies the other.
+ */
+static void
+xlog_reader_create_msgs(struct xlog_reader *reader)
+{
+	reader->msg_count = 2 * MAX(reader->decoder_count, 1);
+	for (int i = 0; i < reader->msg_count; i++) {
+		struct xlog_reader_msg *msg = &reader->msgs[i];
+		struct cmsg_hop *route = msg->route;
+		if (reader->decoder_count == 0) {
+			msg->decoder = NULL;
+			route[0].f = xlog_reader_read_f;
+			route[0].pipe = &reader->tx_pipe;
+			route[1].f = xlog_reader_complete_f;
+			route[1].pipe = NULL;
+		} else {
+			struct xlog_reader_decoder *decoder =
+				&reader->decoders[i % reader->decoder_count];
+			msg->decoder = decoder;
+			route[0].f = xlog_reader_read_f;
+			route[0].pipe = &decoder->pipe;
+			route[1].f = xlog_reader_decode_f;
+			route[1].pipe = &decoder->tx_pipe;
+			route[2].f = xlog_reader_complete_f;
+			route[2].pipe = NULL;
+		}
+	}
+}
+
+/** Free the messages and the decoders of a reader. */
+static void
+xlog_reader_free_msgs(struct xlog_reader *reader)
+{
+	for (int i = 0; i < xlog_reader_msg_capacity(reader); i++) {
+		struct xlog_reader_msg *msg = &reader->msgs[i];
+		xlog_reader_msg_reset(msg);
+		free(msg->txs);
+		free(msg->rows);
+		free(msg->requests);
+		free(msg->errors);
+	}
+	free(reader->msgs);
+	free(reader->decoders);
+}
+
+int
+xlog_reader_start(struct xlog_reader *reader, const char *filename,
+		  bool force_recovery, int thread_count)
+{
+	strlcpy(reader->filename, filename, sizeof(reader->filename));
+	reader->force_recovery = force_recovery;
+	reader->read_past_errors = force_recovery;
+	reader->is_done = false;
+	reader->is_eof = false;
+	reader->thread_count = MAX(thread_count, 0);
+	reader->decoder_count = 0;
+	reader->msg_count = 0;
+	reader->last = NULL;
+	reader->row_pos = 0;
+	reader->error_pos = 0;
+	reader->next = 0;
+	memset(&reader->cursor, 0, sizeof(reader->cursor));
+	reader->cursor.state = XLOG_CURSOR_CLOSED;
+	reader->decoders = NULL;
+	int msg_count = xlog_reader_msg_capacity(reader);
+	reader->msgs = (struct xlog_reader_msg *)
+		xcalloc(msg_count, sizeof(reader->msgs[0]));
+	if (reader->thread_count > 0) {
+		reader->decoders = (struct xlog_reader_decoder *)
+			xcalloc(reader->thread_count,
+				sizeof(reader->decoders[0]));
+	}
+	/*
+	 * The reader thread must not fail to store a tx or an error,
+	 * so the arrays are allocated for the largest batch.
+	 */
+	for (int i = 0; i < msg_count; i++) {
+		struct xlog_reader_msg *msg = &reader->msgs[i];
+		msg->reader = reader;
+		msg->txs = (struct xlog_reader_tx *)
+			xcalloc(XLOG_READER_BATCH_ITEMS, sizeof(msg->txs[0]));
+		msg->errors = (struct xlog_reader_error *)
+			xcalloc(XLOG_READER_BATCH_ITEMS,
+				sizeof(msg->errors[0]));
+	}
+	fiber_cond_create(&reader->cond);
+	/*
+	 * Readers may run concurrently, and the name of a reader
+	 * thread is also the name of its endpoint, which must be
+	 * unique.
+	 */
+	static unsigned reader_id;
+	char name[FIBER_NAME_MAX];
+	snprintf(name, sizeof(name), "xlog_reader.%u", reader_id++);
+	if (cord_costart(&reader->cord, name, xlog_reader_f, reader) != 0) {
+		fiber_cond_destroy(&reader->cond);
+		xlog_reader_free_msgs(reader);
+		return -1;
+	}
+	/* Blocks until the reader thread has started the decoders. */
+	cpipe_create(&reader->reader_pipe, name);
+	xlog_reader_create_msgs(reader);
+	for (int i = 0; i < reader->msg_count; i++)
+		xlog_reader_push(reader, &reader->msgs[i]);
+	return 0;
+}
+
+int
+xlog_reader_next(struct xlog_reader *reader, struct xrow_header **rows,
+		 struct request **requests, int *row_count)
+{
+	while (true) {
+		struct xlog_reader_msg *msg = reader->last;
+		if (msg == NULL)
+			goto next_msg;
+		if (reader->error_pos < msg->error_count &&
+		    msg->errors[reader->error_pos].row_count ==
+		    reader->row_pos) {
+			struct error *e = msg->errors[reader->error_pos].error;
+			if (!reader->force_recovery ||
+			    !reader->read_past_errors ||
+			    e->type != &type_XlogError) {
+				diag_set_error(diag_get(), e);
+				return -1;
+			}
+			reader->error_pos++;
+			say_error("skipping corrupted data in `%s': %s",
+				  reader->filename, e->errmsg);
+			continue;
+		}
+		if (reader->row_pos < msg->row_count) {
+			int end = msg->row_count;
+			if (reader->error_pos < msg->error_count)
+				end = msg->errors[reader->error_pos].row_count;
+			*rows = &msg->rows[reader->row_pos];
+			*requests = &msg->requests[reader->row_pos];
+			*row_count = end - reader->row_pos;
+			reader->row_pos = end;
+			return 0;
+		}
+		if (msg->is_done) {
+			/*
+			 * The reader is done with the file and all
+			 * the rows have been returned.
+			 */
+			*rows = NULL;
+			*requests = NULL;
+			*row_count = 0;
+			reader->is_eof = msg->is_eof;
+			return 0;
+		}
+		/* The rows of the last message have been applied. */
+		xlog_reader_push(reader, msg);
+next_msg:
+		msg = &reader->msgs[reader->next];
+		reader->next = (reader->next + 1) % reader->msg_count;
+		xlog_reader_wait(reader, msg);
+		reader->last = msg;
+		reader->row_pos = 0;
+		reader->error_pos = 0;
+	}
+}
+
+void
+xlog_reader_stop(struct xlog_reader *reader)
+{
+	for (int i = 0; i < reader->msg_count; i++)
+		xlog_reader_wait(reader, &reader->msgs[i]);
+	cbus_stop_loop(&reader->reader_pipe);
+	cpipe_destroy(&reader->reader_pipe);
+	if (cord_cojoin(&reader->cord) != 0)
+		panic("failed to join xlog reader thread");
+	xlog_reader_free_msgs(reader);
+	fiber_cond_destroy(&reader->cond);
+}
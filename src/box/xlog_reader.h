@@ -0,0 +1,231 @@
+#ifndef TARANTOOL_BOX_XLOG_READER_H_INCLUDED
+#define TARANTOOL_BOX_XLOG_READER_H_INCLUDED
+/*
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <limits.h>
+#include <stdbool.h>
+
+#include "cbus.h"
+#include "diag.h"
+#include "fiber_cond.h"
+#include "small/region.h"
+#include "xlog.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct request;
+struct xrow_header;
+struct xlog_reader;
+struct xlog_reader_decoder;
+
+/** An error found by a reader at some position of a batch. */
+struct xlog_reader_error {
+	/** Number of rows of the batch that precede the error. */
+	int row_count;
+	/** The error. */
+	struct error *error;
+};
+
+/** A tx read from a file by a reader thread, not decoded yet. */
+struct xlog_reader_tx {
+	/** The tx, including its fixheader. NULL if it was corrupted. */
+	const char *data;
+	/** End of the tx. */
+	const char *data_end;
+	/** The error that occurred on reading the tx, if any. */
+	struct error *error;
+};
+
+/** A batch of rows read from a file by reader threads. */
+struct xlog_reader_msg {
+	struct cmsg base;
+	struct xlog_reader *reader;
+	/** Route of the message. */
+	struct cmsg_hop route[3];
+	/**
+	 * The thread decoding the batch. NULL if the batch is
+	 * decoded by the reader thread.
+	 */
+	struct xlog_reader_decoder *decoder;
+	/** Memory for txs, owned by the reader thread. */
+	struct region tx_region;
+	/** Txs read from the file and passed to the decoder. */
+	struct xlog_reader_tx *txs;
+	/** Number of txs. */
+	int tx_count;
+	/**
+	 * Memory for row bodies, owned by the thread decoding
+	 * the batch.
+	 */
+	struct region region;
+	/** Set if the region has been created. */
+	bool is_region_created;
+	/** Rows read from the file. */
+	struct xrow_header *rows;
+	/**
+	 * DML requests decoded from the rows, one per row. A request
+	 * whose header is NULL wasn't decoded.
+	 */
+	struct request *requests;
+	/** Number of rows in the batch. */
+	int row_count;
+	/** Capacity of the rows and requests arrays. */
+	int row_capacity;
+	/** Errors found in the batch, in the file order. */
+	struct xlog_reader_error *errors;
+	/** Number of errors. */
+	int error_count;
+	/** Set while the message is being processed by the reader. */
+	bool is_busy;
+	/** Set if there are no more rows to read. */
+	bool is_done;
+	/** Set if the reader has read the end of file marker. */
+	bool is_eof;
+};
+
+/** A thread decompressing and decoding txs read by a reader. */
+struct xlog_reader_decoder {
+	/** The reader the decoder works for. */
+	struct xlog_reader *reader;
+	/** The decoder thread. */
+	struct cord cord;
+	/** A pipe from the reader thread to the decoder thread. */
+	struct cpipe pipe;
+	/** A pipe from the decoder thread to the tx thread. */
+	struct cpipe tx_pipe;
+	/** The context of zstd decompression. */
+	ZSTD_DStream *zdctx;
+};
+
+/**
+ * A thread that reads, decompresses and decodes rows of an xlog
+ * file, including DML request bodies, while the tx thread is
+ * applying the rows read before.
+ *
+ * Messages travel between the tx thread and the reader: while
+ * the tx thread is applying one of them, the reader fills the
+ * others. The reader may start decoder threads: then it only
+ * reads txs from the file and validates their checksums, and
+ * txs are decompressed and decoded by the decoders in parallel.
+ * Messages are still returned to the tx thread in the file order.
+ *
+ * The reader sends messages back to the "tx_prio" endpoint so
+ * it may only be used by the tx thread once the endpoint exists.
+ */
+struct xlog_reader {
+	/** The reader thread. */
+	struct cord cord;
+	/** A pipe from the tx thread to the reader thread. */
+	struct cpipe reader_pipe;
+	/** A pipe from the reader thread to the tx thread. */
+	struct cpipe tx_pipe;
+	/** Path to the file. */
+	char filename[PATH_MAX];
+	/**
+	 * Skip corrupted data instead of stopping. May be changed
+	 * between xlog_reader_next() calls and applies to the data
+	 * following the rows returned so far. May be set only if it
+	 * was set on start.
+	 */
+	bool force_recovery;
+	/**
+	 * Value of force_recovery on start. If set, reader threads
+	 * read on past corrupted data, leaving the decision whether
+	 * to skip it to the tx thread.
+	 */
+	bool read_past_errors;
+	/** The file cursor, used by the reader thread only. */
+	struct xlog_cursor cursor;
+	/** Set if the reader thread is done with the file. */
+	bool is_done;
+	/** Set if the end of file marker has been read. */
+	bool is_eof;
+	/** Decoder threads. */
+	struct xlog_reader_decoder *decoders;
+	/** Number of decoder threads to start. */
+	int thread_count;
+	/** Number of started decoder threads. */
+	int decoder_count;
+	/** Messages carrying rows to the tx thread. */
+	struct xlog_reader_msg *msgs;
+	/** Number of messages in use. */
+	int msg_count;
+	/** The message returned by the last xlog_reader_next(). */
+	struct xlog_reader_msg *last;
+	/** Number of rows of the last message returned so far. */
+	int row_pos;
+	/** Number of errors of the last message processed so far. */
+	int error_pos;
+	/** Index of the message to return next. */
+	int next;
+	/** Signalled when a message returns to the tx thread. */
+	struct fiber_cond cond;
+};
+
+/**
+ * Start a thread reading rows from the given file. The file is
+ * opened by the reader thread. If @a thread_count is positive,
+ * the reader starts as many decoder threads. Failure to start
+ * a decoder isn't fatal - the rest decode its share of txs.
+ */
+int
+xlog_reader_start(struct xlog_reader *reader, const char *filename,
+		  bool force_recovery, int thread_count);
+
+/**
+ * Get the next batch of rows read from the file along with DML
+ * requests decoded from them, see xlog_reader_msg::requests.
+ * Rows returned by the previous call are freed. On end of file
+ * returns 0 and sets @a row_count to 0, xlog_reader::is_eof tells
+ * if the end of file marker was read.
+ *
+ * Corrupted data is skipped if xlog_reader::force_recovery is
+ * set, otherwise an error is returned, after which the reader
+ * must be stopped.
+ *
+ * @retval  0 success
+ * @retval -1 read error, diag is set
+ */
+int
+xlog_reader_next(struct xlog_reader *reader, struct xrow_header **rows,
+		 struct request **requests, int *row_count);
+
+/** Stop the reader threads and free the reader resources. */
+void
+xlog_reader_stop(struct xlog_reader *reader);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_XLOG_READER_H_INCLUDED */
@@ -679,6 +679,33 @@ iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 	memcpy(pos + IPROTO_HEADER_LEN, &body, sizeof(body));
 }
 
+int
+iproto_reply_select_with_position(struct obuf *buf, struct obuf_svp *svp,
+				  uint64_t sync, uint32_t schema_version,
+				  uint32_t count, const char *pos,
+				  const char *pos_end)
+{
+	if (pos == NULL) {
+		iproto_reply_select(buf, svp, sync, schema_version, count);
+		return 0;
+	}
+	uint32_t pos_len = pos_end - pos;
+	size_t size = mp_sizeof_uint(IPROTO_POSITION) +
+		      mp_sizeof_str(pos_len);
+	char *data = (char *)obuf_alloc(buf, size);
+	if (data == NULL) {
+		diag_set(OutOfMemory, size, "obuf_alloc", "data");
+		return -1;
+	}
+	data = mp_encode_uint(data, IPROTO_POSITION);
+	data = mp_encode_str(data, pos, pos_len);
+	iproto_reply_select(buf, svp, sync, schema_version, count);
+	char *body = (char *)obuf_svp_to_ptr(buf, svp) + IPROTO_HEADER_LEN;
+	/* The body map has two keys: IPROTO_DATA and IPROTO_POSITION. */
+	*body = 0x82;
+	return 0;
+}
+
 int
 xrow_decode_sql(const struct xrow_header *row, struct sql_request *request)
 {
@@ -866,6 +893,16 @@ error:
 			request->tuple_meta = value;
 			request->tuple_meta_end = data;
 			break;
+		case IPROTO_AFTER_POSITION: {
+			uint32_t len;
+			request->after_position = mp_decode_str(&value, &len);
+			request->after_position_end =
+				request->after_position + len;
+			break;
+		}
+		case IPROTO_FETCH_POSITION:
+			request->fetch_position = mp_decode_bool(&value);
+			break;
 		default:
 			break;
 		}
@@ -1679,11 +1716,14 @@ xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
 		      const struct vclock *vclock, bool anon,
-		      uint32_t id_filter)
+		      uint32_t id_filter,
+		      const struct iproto_features *features)
 {
 	memset(row, 0, sizeof(*row));
 	size_t size = XROW_BODY_LEN_MAX +
 		      mp_sizeof_vclock_ignore0(vclock);
+	if (features != NULL)
+		size += mp_sizeof_iproto_features(features);
 	char *buf = (char *) region_alloc(&fiber()->gc, size);
 	if (buf == NULL) {
 		diag_set(OutOfMemory, size, "region_alloc", "buf");
@@ -1691,7 +1731,8 @@ xrow_encode_subscribe(struct xrow_header *row,
 	}
 	char *data = buf;
 	int filter_size = bit_count_u32(id_filter);
-	data = mp_encode_map(data, filter_size != 0 ? 6 : 5);
+	data = mp_encode_map(data, 5 + (filter_size != 0) +
+				   (features != NULL));
 	data = mp_encode_uint(data, IPROTO_CLUSTER_UUID);
 	data = xrow_encode_uuid(data, replicaset_uuid);
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
@@ -1713,6 +1754,10 @@ xrow_encode_subscribe(struct xrow_header *row,
 			data = mp_encode_uint(data, id);
 		}
 	}
+	if (features != NULL) {
+		data = mp_encode_uint(data, IPROTO_FEATURES);
+		data = mp_encode_iproto_features(data, features);
+	}
 	assert(data <= buf + size);
 	row->body[0].iov_base = buf;
 	row->body[0].iov_len = (data - buf);
@@ -1725,7 +1770,8 @@ int
 xrow_decode_subscribe(const struct xrow_header *row,
 		      struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
-		      uint32_t *version_id, bool *anon, uint32_t *id_filter)
+		      uint32_t *version_id, bool *anon, uint32_t *id_filter,
+		      struct iproto_features *features)
 {
 	if (row->bodycnt == 0) {
 		diag_set(ClientError, ER_INVALID_MSGPACK, "request body");
@@ -1750,6 +1796,8 @@ xrow_decode_subscribe(const struct xrow_header *row,
 		*anon = false;
 	if (id_filter != NULL)
 		*id_filter = 0;
+	if (features != NULL)
+		iproto_features_create(features);
 
 	uint32_t map_size = mp_decode_map(&d);
 	for (uint32_t i = 0; i < map_size; i++) {
@@ -1825,6 +1873,16 @@ id_filter_decode_err:		xrow_on_decode_err(row, ER_INVALID_MSGPACK,
 				*id_filter |= 1 << val;
 			}
 			break;
+		case IPROTO_FEATURES:
+			if (features == NULL)
+				goto skip;
+			if (mp_typeof(*d) != MP_ARRAY ||
+			    mp_decode_iproto_features(&d, features) != 0) {
+				xrow_on_decode_err(row, ER_INVALID_MSGPACK,
+						   "invalid FEATURES");
+				return -1;
+			}
+			break;
 		default: skip:
 			mp_next(&d); /* value */
 		}
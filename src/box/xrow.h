@@ -194,6 +194,11 @@ struct request {
 	/** Tuple metadata. */
 	const char *tuple_meta;
 	const char *tuple_meta_end;
+	/** Position to start SELECT after (MsgPack string data). */
+	const char *after_position;
+	const char *after_position_end;
+	/** Return the position of the last selected tuple. */
+	bool fetch_position;
 	/** Base field offset for UPDATE/UPSERT, e.g. 0 for C and 1 for Lua. */
 	int index_base;
 };
@@ -476,6 +481,7 @@ xrow_encode_register(struct xrow_header *row,
  * @param anon Whether it is an anonymous subscribe request or not.
  * @param id_filter A List of replica ids to skip rows from
  *		    when feeding a replica.
+ * @param features Features supported by the replica or NULL.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
@@ -485,7 +491,8 @@ xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
 		      const struct vclock *vclock, bool anon,
-		      uint32_t id_filter);
+		      uint32_t id_filter,
+		      const struct iproto_features *features);
 
 /**
  * Decode SUBSCRIBE command.
@@ -497,6 +504,7 @@ xrow_encode_subscribe(struct xrow_header *row,
  * @param[out] anon Whether it is an anonymous subscribe.
  * @param[out] id_filter A list of ids to skip rows from when
  *			 feeding a replica.
+ * @param[out] features Features supported by the replica.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
@@ -505,7 +513,8 @@ int
 xrow_decode_subscribe(const struct xrow_header *row,
 		      struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
-		      uint32_t *version_id, bool *anon, uint32_t *id_filter);
+		      uint32_t *version_id, bool *anon, uint32_t *id_filter,
+		      struct iproto_features *features);
 
 /**
  * Encode JOIN command.
@@ -532,7 +541,7 @@ xrow_decode_join(const struct xrow_header *row, struct tt_uuid *instance_uuid,
 		 uint32_t *version_id)
 {
 	return xrow_decode_subscribe(row, NULL, instance_uuid, NULL, version_id,
-				     NULL, NULL);
+				     NULL, NULL, NULL);
 }
 
 /**
@@ -551,7 +560,7 @@ xrow_decode_register(const struct xrow_header *row,
 		     uint32_t *version_id)
 {
 	return xrow_decode_subscribe(row, NULL, instance_uuid, vclock,
-				     version_id, NULL, NULL);
+				     version_id, NULL, NULL, NULL);
 }
 
 /**
@@ -576,7 +585,8 @@ xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock);
 static inline int
 xrow_decode_vclock(const struct xrow_header *row, struct vclock *vclock)
 {
-	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL, NULL, NULL);
+	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL, NULL, NULL,
+				     NULL);
 }
 
 /**
@@ -608,7 +618,7 @@ xrow_decode_subscribe_response(const struct xrow_header *row,
 			       struct vclock *vclock)
 {
 	return xrow_decode_subscribe(row, replicaset_uuid, NULL, vclock, NULL,
-				     NULL, NULL);
+				     NULL, NULL, NULL);
 }
 
 /**
@@ -682,6 +692,19 @@ void
 iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 		    uint32_t schema_version, uint32_t count);
 
+/**
+ * Same as iproto_reply_select(), but also appends IPROTO_POSITION
+ * to the response body unless @a pos is NULL.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+iproto_reply_select_with_position(struct obuf *buf, struct obuf_svp *svp,
+				  uint64_t sync, uint32_t schema_version,
+				  uint32_t count, const char *pos,
+				  const char *pos_end);
+
 /**
  * Encode iproto header with IPROTO_OK response code.
  * @param out Encode to.
@@ -1042,10 +1065,11 @@ xrow_encode_subscribe_xc(struct xrow_header *row,
 			 const struct tt_uuid *replicaset_uuid,
 			 const struct tt_uuid *instance_uuid,
 			 const struct vclock *vclock, bool anon,
-			 uint32_t id_filter)
+			 uint32_t id_filter,
+			 const struct iproto_features *features)
 {
 	if (xrow_encode_subscribe(row, replicaset_uuid, instance_uuid,
-				  vclock, anon, id_filter) != 0)
+				  vclock, anon, id_filter, features) != 0)
 		diag_raise();
 }
 
@@ -1055,11 +1079,11 @@ xrow_decode_subscribe_xc(const struct xrow_header *row,
 			 struct tt_uuid *replicaset_uuid,
 			 struct tt_uuid *instance_uuid, struct vclock *vclock,
 			 uint32_t *replica_version_id, bool *anon,
-			 uint32_t *id_filter)
+			 uint32_t *id_filter, struct iproto_features *features)
 {
 	if (xrow_decode_subscribe(row, replicaset_uuid, instance_uuid,
 				  vclock, replica_version_id, anon,
-				  id_filter) != 0)
+				  id_filter, features) != 0)
 		diag_raise();
 }
 
@@ -31,6 +31,7 @@
 
 #include "xstream.h"
 #include "exception.h"
+#include "xrow.h"
 
 int
 xstream_write(struct xstream *stream, struct xrow_header *row)
@@ -42,3 +43,16 @@ xstream_write(struct xstream *stream, struct xrow_header *row)
 	}
 	return 0;
 }
+
+int
+xstream_write_request(struct xstream *stream, struct request *request)
+{
+	if (stream->write_request == NULL)
+		return xstream_write(stream, request->header);
+	try {
+		stream->write_request(stream, request);
+	} catch (Exception *e) {
+		return -1;
+	}
+	return 0;
+}
@@ -38,6 +38,7 @@
 extern "C" {
 #endif /* defined(__cplusplus) */
 
+struct request;
 struct xrow_header;
 struct xstream;
 
@@ -49,8 +50,16 @@ typedef void (*xstream_yield_f)(struct xstream *);
 
 typedef void (*xstream_write_f)(struct xstream *, struct xrow_header *);
 
+/**
+ * A type for a callback writing a DML request that has already been
+ * decoded from a row, see xstream_write_request().
+ */
+typedef void (*xstream_write_request_f)(struct xstream *, struct request *);
+
 struct xstream {
 	xstream_write_f write;
+	/** Optional, rows are passed to xstream::write if not set. */
+	xstream_write_request_f write_request;
 	xstream_yield_f yield;
 	uint64_t row_count;
 };
@@ -60,6 +69,7 @@ xstream_create(struct xstream *xstream, xstream_write_f write,
 	       xstream_yield_f yield)
 {
 	xstream->write = write;
+	xstream->write_request = NULL;
 	xstream->yield = yield;
 	xstream->row_count = 0;
 }
@@ -80,6 +90,13 @@ xstream_reset(struct xstream *stream)
 int
 xstream_write(struct xstream *stream, struct xrow_header *row);
 
+/**
+ * Write a DML request decoded from request::header. Streams that
+ * don't accept decoded requests get the row.
+ */
+int
+xstream_write_request(struct xstream *stream, struct request *request);
+
 #if defined(__cplusplus)
 } /* extern C */
 
@@ -0,0 +1,55 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "hdr_histogram.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "trivia/util.h"
+
+void
+hdr_histogram_create(struct hdr_histogram *hist)
+{
+	memset(hist, 0, sizeof(*hist));
+}
+
+uint64_t
+hdr_histogram_bucket_max(int bucket)
+{
+	assert(bucket >= 0 && bucket < HDR_HISTOGRAM_BUCKET_COUNT);
+	if (bucket < HDR_HISTOGRAM_SUB_COUNT)
+		return bucket;
+	if (bucket == HDR_HISTOGRAM_BUCKET_COUNT - 1)
+		return UINT64_MAX;
+	int shift = bucket / HDR_HISTOGRAM_SUB_COUNT - 1;
+	uint64_t sub = bucket % HDR_HISTOGRAM_SUB_COUNT;
+	return ((HDR_HISTOGRAM_SUB_COUNT + sub + 1) << shift) - 1;
+}
+
+void
+hdr_histogram_merge(struct hdr_histogram *dst,
+		    const struct hdr_histogram *src)
+{
+	for (int i = 0; i < HDR_HISTOGRAM_BUCKET_COUNT; i++)
+		dst->buckets[i] += src->buckets[i];
+	dst->count += src->count;
+	dst->sum += src->sum;
+	dst->max = MAX(dst->max, src->max);
+}
+
+uint64_t
+hdr_histogram_percentile(const struct hdr_histogram *hist, double pct)
+{
+	if (hist->count == 0)
+		return 0;
+	uint64_t count = 0;
+	for (int i = 0; i < HDR_HISTOGRAM_BUCKET_COUNT; i++) {
+		count += hist->buckets[i];
+		if (count * 100.0 >= hist->count * pct && count > 0)
+			return MIN(hdr_histogram_bucket_max(i), hist->max);
+	}
+	return hist->max;
+}
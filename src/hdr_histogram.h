@@ -0,0 +1,117 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+/*
+ * High dynamic range histogram.
+ *
+ * Unlike struct histogram (see histogram.h), the bucket boundaries
+ * are fixed: values below HDR_HISTOGRAM_SUB_COUNT have a bucket
+ * each, and every power of two above is split into
+ * HDR_HISTOGRAM_SUB_COUNT equal buckets, so the relative error of
+ * a value estimate never exceeds 1 / HDR_HISTOGRAM_SUB_COUNT. The
+ * bucket of a value is found with a few bit operations, without
+ * searching, so collecting a value is cheap enough for hot paths.
+ *
+ * The histogram is not thread-safe: it's supposed to be updated by
+ * one thread, and merged with others by the reader.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "bit/bit.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+enum {
+	/** Log2 of the number of buckets per power of two. */
+	HDR_HISTOGRAM_SUB_BITS = 3,
+	/** Number of buckets per power of two. */
+	HDR_HISTOGRAM_SUB_COUNT = 1 << HDR_HISTOGRAM_SUB_BITS,
+	/**
+	 * Values not less than 2 ^ HDR_HISTOGRAM_MAX_BITS are
+	 * accounted in the last bucket.
+	 */
+	HDR_HISTOGRAM_MAX_BITS = 32,
+	/** Number of buckets in a histogram. */
+	HDR_HISTOGRAM_BUCKET_COUNT = (HDR_HISTOGRAM_MAX_BITS -
+				      HDR_HISTOGRAM_SUB_BITS + 1) *
+				     HDR_HISTOGRAM_SUB_COUNT,
+};
+
+struct hdr_histogram {
+	/** Number of collected values. */
+	uint64_t count;
+	/** Sum of collected values. */
+	uint64_t sum;
+	/** Max collected value. */
+	uint64_t max;
+	/** Number of collected values per bucket. */
+	uint64_t buckets[HDR_HISTOGRAM_BUCKET_COUNT];
+};
+
+/** Initialize an empty histogram. */
+void
+hdr_histogram_create(struct hdr_histogram *hist);
+
+/** Remove all values from a histogram. */
+static inline void
+hdr_histogram_reset(struct hdr_histogram *hist)
+{
+	hdr_histogram_create(hist);
+}
+
+/** Return the number of the bucket a value is accounted in. */
+static inline int
+hdr_histogram_bucket(uint64_t value)
+{
+	if (value < HDR_HISTOGRAM_SUB_COUNT)
+		return value;
+	if (value >> HDR_HISTOGRAM_MAX_BITS != 0)
+		return HDR_HISTOGRAM_BUCKET_COUNT - 1;
+	int shift = 63 - bit_clz_u64(value) - HDR_HISTOGRAM_SUB_BITS;
+	return (shift + 1) * HDR_HISTOGRAM_SUB_COUNT +
+	       (int)(value >> shift) - HDR_HISTOGRAM_SUB_COUNT;
+}
+
+/**
+ * Return the max value accounted in a bucket. The last bucket
+ * is unbounded, UINT64_MAX is returned for it.
+ */
+uint64_t
+hdr_histogram_bucket_max(int bucket);
+
+/** Update a histogram with a new value. */
+static inline void
+hdr_histogram_collect(struct hdr_histogram *hist, uint64_t value)
+{
+	hist->buckets[hdr_histogram_bucket(value)]++;
+	hist->count++;
+	hist->sum += value;
+	if (hist->max < value)
+		hist->max = value;
+}
+
+/** Add all values collected in @src to @dst. */
+void
+hdr_histogram_merge(struct hdr_histogram *dst,
+		    const struct hdr_histogram *src);
+
+/**
+ * Estimate a percentile, i.e. the value below which the given
+ * percentage of values fall. Returns the max value of the bucket
+ * the percentile falls in, but not greater than the max collected
+ * value. Returns 0 if the histogram is empty.
+ */
+uint64_t
+hdr_histogram_percentile(const struct hdr_histogram *hist, double pct);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
@@ -31,6 +31,7 @@
 #include "cbus.h"
 
 #include <limits.h>
+#include <pmatomic.h>
 #include "fiber.h"
 #include "trigger.h"
 
@@ -83,6 +84,144 @@ cbus_find_endpoint(struct cbus *bus, const char *name)
 	return endpoint;
 }
 
+/**
+ * Append a list of entries to the endpoint queue. May be called
+ * by many producers concurrently.
+ */
+static inline void
+cbus_endpoint_link(struct cbus_endpoint *endpoint,
+		   struct stailq_entry *first, struct stailq_entry *last)
+{
+	assert(last->next == NULL);
+	struct stailq_entry *prev = pm_atomic_exchange(&endpoint->head, last);
+	/*
+	 * Until the previous head is linked to the new entries,
+	 * the consumer can't fetch them nor the previous head.
+	 * The store must not be reordered with the following
+	 * load of is_idle, see cbus_endpoint_set_idle().
+	 */
+	pm_atomic_store(&prev->next, first);
+}
+
+/**
+ * Push messages to the endpoint queue and empty the list.
+ * Returns true if the consumer must be notified.
+ */
+static bool
+cbus_endpoint_push(struct cbus_endpoint *endpoint, struct stailq *input)
+{
+	assert(!stailq_empty(input));
+	cbus_endpoint_link(endpoint, stailq_first(input), stailq_last(input));
+	stailq_create(input);
+	/*
+	 * The messages are linked before is_idle is checked,
+	 * while the consumer sets is_idle before checking the
+	 * queue, see cbus_endpoint_set_idle(), so either the
+	 * consumer sees the new messages or we see it idle.
+	 * Only the first producer to see it idle notifies it.
+	 */
+	return pm_atomic_load(&endpoint->is_idle) != 0 &&
+	       pm_atomic_exchange(&endpoint->is_idle, 0) != 0;
+}
+
+/**
+ * Check if the endpoint queue has messages, possibly not
+ * completely linked yet. Must be called by the consumer.
+ */
+static bool
+cbus_endpoint_is_empty(struct cbus_endpoint *endpoint)
+{
+	return endpoint->tail == &endpoint->stub &&
+	       pm_atomic_load(&endpoint->head) == &endpoint->stub;
+}
+
+/**
+ * Called by the consumer after it has fetched all messages
+ * linked to the queue. Let producers know that the consumer
+ * needs to be notified of new messages. If a producer linked
+ * messages before it could see the flag, notify the consumer
+ * on its behalf.
+ */
+static void
+cbus_endpoint_set_idle(struct cbus_endpoint *endpoint)
+{
+	pm_atomic_store(&endpoint->is_idle, 1);
+	if (pm_atomic_load(&endpoint->tail->next) != NULL &&
+	    pm_atomic_exchange(&endpoint->is_idle, 0) != 0)
+		ev_async_send(endpoint->consumer, &endpoint->async);
+}
+
+/**
+ * Move all messages linked to the endpoint queue to the output.
+ * Returns true if any messages were fetched.
+ */
+static bool
+cbus_endpoint_take(struct cbus_endpoint *endpoint, struct stailq *output)
+{
+	struct stailq_entry *stub = &endpoint->stub;
+	struct stailq_entry *tail = endpoint->tail;
+	struct stailq_entry *next;
+	bool taken = false;
+	next = pm_atomic_load_explicit(&tail->next, pm_memory_order_acquire);
+	if (tail == stub) {
+		if (next == NULL)
+			return false;
+		tail = next;
+		next = pm_atomic_load_explicit(&tail->next,
+					       pm_memory_order_acquire);
+	}
+	while (true) {
+		if (next == NULL) {
+			/*
+			 * The tail is either the last message or a
+			 * producer hasn't linked it to its messages
+			 * yet, in which case the producer will notify
+			 * the consumer once it has linked them.
+			 */
+			if (tail != pm_atomic_load(&endpoint->head))
+				break;
+			/* Put the stub after the last message to take it. */
+			stub->next = NULL;
+			cbus_endpoint_link(endpoint, stub, stub);
+			next = pm_atomic_load_explicit(&tail->next,
+						       pm_memory_order_acquire);
+			if (next == NULL)
+				break;
+		}
+		stailq_add_tail(output, tail);
+		taken = true;
+		tail = next;
+		if (tail == stub) {
+			next = pm_atomic_load_explicit(&stub->next,
+						       pm_memory_order_acquire);
+			if (next == NULL)
+				break;
+			tail = next;
+		}
+		next = pm_atomic_load_explicit(&tail->next,
+					       pm_memory_order_acquire);
+	}
+	endpoint->tail = tail;
+	return taken;
+}
+
+void
+cbus_endpoint_fetch(struct cbus_endpoint *endpoint, struct stailq *output)
+{
+	cbus_endpoint_take(endpoint, output);
+	cbus_endpoint_set_idle(endpoint);
+}
+
+bool
+cbus_endpoint_fetch_awake(struct cbus_endpoint *endpoint,
+			  struct stailq *output)
+{
+	if (cbus_endpoint_take(endpoint, output))
+		return true;
+	cbus_endpoint_set_idle(endpoint);
+	return false;
+}
+
 static void
 cpipe_flush_cb(ev_loop * /* loop */, struct ev_async *watcher,
 	       int /* events */);
@@ -156,11 +295,11 @@ cpipe_destroy(struct cpipe *pipe)
 	 * delivered.
 	 */
 	tt_pthread_mutex_lock(&endpoint->mutex);
+	/* Add the pipe shutdown message as the last one. */
+	stailq_add_tail_entry(&pipe->input, poison, msg.fifo);
 	/* Flush input */
-	stailq_concat(&endpoint->output, &pipe->input);
+	cbus_endpoint_push(endpoint, &pipe->input);
 	pipe->n_input = 0;
-	/* Add the pipe shutdown message as the last one. */
-	stailq_add_tail_entry(&endpoint->output, poison, msg.fifo);
 	/* Count statistics */
 	rmean_collect(cbus.stats, CBUS_STAT_EVENTS, 1);
 	/*
@@ -227,7 +366,10 @@ cbus_endpoint_create(struct cbus_endpoint *endpoint, const char *name,
 	endpoint->n_pipes = 0;
 	fiber_cond_create(&endpoint->cond);
 	tt_pthread_mutex_init(&endpoint->mutex, NULL);
-	stailq_create(&endpoint->output);
+	endpoint->stub.next = NULL;
+	endpoint->head = &endpoint->stub;
+	endpoint->tail = &endpoint->stub;
+	endpoint->is_idle = 1;
 	ev_async_init(&endpoint->async,
 		      (void (*)(ev_loop *, struct ev_async *, int)) fetch_cb);
 	endpoint->async.data = fetch_data;
@@ -261,7 +403,7 @@ cbus_endpoint_destroy(struct cbus_endpoint *endpoint,
 	while (true) {
 		if (process_cb)
 			process_cb(endpoint);
-		if (endpoint->n_pipes == 0 && stailq_empty(&endpoint->output))
+		if (endpoint->n_pipes == 0 && cbus_endpoint_is_empty(endpoint))
 			break;
 		 fiber_cond_wait(&endpoint->cond);
 	}
@@ -290,8 +432,6 @@ cpipe_flush_cb(ev_loop *loop, struct ev_async *watcher, int events)
 		return;
 
 	trigger_run(&pipe->on_flush, pipe);
-	/* Trigger task processing when the queue becomes non-empty. */
-	bool output_was_empty;
 
 	/*
 	 * We need to set a thread cancellation guard, because
@@ -304,14 +444,11 @@ cpipe_flush_cb(ev_loop *loop, struct ev_async *watcher, int events)
 	int old_cancel_state;
 	tt_pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancel_state);
 
-	tt_pthread_mutex_lock(&endpoint->mutex);
-	output_was_empty = stailq_empty(&endpoint->output);
 	/** Flush input */
-	stailq_concat(&endpoint->output, &pipe->input);
-	tt_pthread_mutex_unlock(&endpoint->mutex);
-
+	bool need_wakeup = cbus_endpoint_push(endpoint, &pipe->input);
 	pipe->n_input = 0;
-	if (output_was_empty) {
+	/* Trigger task processing when the queue becomes non-empty. */
+	if (need_wakeup) {
 		/* Count statistics */
 		rmean_collect(cbus.stats, CBUS_STAT_EVENTS, 1);
 
@@ -661,7 +798,20 @@ void
 cbus_loop(struct cbus_endpoint *endpoint)
 {
 	while (true) {
-		cbus_process(endpoint);
+		/*
+		 * Process messages until the queue is empty so that
+		 * producers don't notify us while we're awake.
+		 */
+		struct stailq output;
+		stailq_create(&output);
+		while (cbus_endpoint_fetch_awake(endpoint, &output)) {
+			struct cmsg *msg, *msg_next;
+			stailq_foreach_entry_safe(msg, msg_next, &output, fifo)
+				cmsg_deliver(msg);
+			stailq_create(&output);
+			if (fiber_is_cancelled())
+				break;
+		}
 		if (fiber_is_cancelled())
 			break;
 		fiber_yield();
@@ -118,7 +118,8 @@ struct cpipe {
 	/**
 	 * When pushing messages, keep the staged input size under
 	 * this limit (speeds up message delivery and reduces
-	 * latency, while still keeping the bus mutex cold enough).
+	 * latency, while still keeping the number of consumer
+	 * wakeups low enough).
 	 */
 	int max_input;
 	/**
@@ -166,7 +167,7 @@ cpipe_destroy(struct cpipe *pipe);
  * Otherwise, the messages flushed once per event loop iteration.
  *
  * @todo: collect bus stats per second and adjust max_input once
- * a second to keep the mutex cold regardless of the message load,
+ * a second to keep wakeups rare regardless of the message load,
  * while still keeping the latency low if there are few
  * long-to-process messages.
  */
@@ -255,10 +256,37 @@ struct cbus_endpoint {
 	char name[FIBER_NAME_MAX];
 	/** Member of cbus->endpoints */
 	struct rlist in_cbus;
-	/** The lock around the pipe. */
+	/**
+	 * Incoming messages form a lock-free multi-producer
+	 * single-consumer queue linked through cmsg::fifo.
+	 * Producers append messages by swapping the queue head,
+	 * which points to the last message, and then linking the
+	 * previous head to the new messages. The consumer takes
+	 * messages from the queue tail. The stub entry keeps the
+	 * queue non-empty, so that the consumer never takes the
+	 * last message while a producer may link to it.
+	 */
+	struct stailq_entry *head;
+	/** The first not fetched entry, owned by the consumer. */
+	struct stailq_entry *tail;
+	/** Stub entry of the message queue. */
+	struct stailq_entry stub;
+	/**
+	 * Set by the consumer when it has fetched all messages
+	 * and cleared by the first producer to push new ones,
+	 * which notifies the consumer. So the consumer is
+	 * notified only when the queue becomes non-empty.
+	 * A consumer draining the queue with
+	 * cbus_endpoint_fetch_awake() keeps it cleared until
+	 * it finds the queue empty, so producers don't notify
+	 * a consumer that is awake anyway.
+	 */
+	int is_idle;
+	/**
+	 * Keeps the endpoint alive while a pipe being destroyed
+	 * notifies the consumer, see cpipe_destroy().
+	 */
 	pthread_mutex_t mutex;
-	/** A queue with incoming messages. */
-	struct stailq output;
 	/** Consumer cord loop */
 	ev_loop *consumer;
 	/** Async to notify the consumer */
@@ -270,15 +298,23 @@ struct cbus_endpoint {
 };
 
 /**
- * Fetch incomming messages to output
+ * Fetch incomming messages to output. Must be called by the
+ * consumer.
+ */
+void
+cbus_endpoint_fetch(struct cbus_endpoint *endpoint, struct stailq *output);
+
+/**
+ * Fetch incoming messages to output like cbus_endpoint_fetch(),
+ * but if there are any, don't let producers notify the consumer
+ * of new messages. Returns true if any messages were fetched, in
+ * which case the consumer must call this function again after
+ * processing them. The consumer is notified of new messages
+ * again after a call that finds the queue empty.
  */
-static inline void
-cbus_endpoint_fetch(struct cbus_endpoint *endpoint, struct stailq *output)
-{
-	tt_pthread_mutex_lock(&endpoint->mutex);
-	stailq_concat(output, &endpoint->output);
-	tt_pthread_mutex_unlock(&endpoint->mutex);
-}
+bool
+cbus_endpoint_fetch_awake(struct cbus_endpoint *endpoint,
+			  struct stailq *output);
 
 /** Initialize the global singleton bus. */
 void
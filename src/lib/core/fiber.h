@@ -650,6 +650,11 @@ struct fiber {
 		 */
 		struct {
 			uint64_t sync;
+			/**
+			 * Time the current iproto request has spent
+			 * waiting for WAL writes, in nanoseconds.
+			 */
+			uint64_t wal_wait_time;
 		} net;
 	} storage;
 	/** An object to wait for incoming message or a reader. */
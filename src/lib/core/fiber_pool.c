@@ -73,6 +73,13 @@ restart:
 		 */
 		fiber_on_stop(f);
 	}
+	/*
+	 * Fetch messages pushed while the pool was busy. Producers
+	 * don't notify the pool until it finds the queue empty.
+	 */
+	if (!fiber_is_cancelled() &&
+	    cbus_endpoint_fetch_awake(&pool->endpoint, output))
+		goto restart;
 	/** Put the current fiber into a fiber cache. */
 	if (!fiber_is_cancelled() && (msg != NULL ||
 	    ev_monotonic_now(loop) - last_active_at < pool->idle_timeout)) {
@@ -120,8 +127,8 @@ fiber_pool_cb(ev_loop *loop, struct ev_watcher *watcher, int events)
 	(void) loop;
 	(void) events;
 	struct fiber_pool *pool = (struct fiber_pool *) watcher->data;
-	/** Fetch messages */
-	cbus_endpoint_fetch(&pool->endpoint, &pool->output);
+	/** Fetch messages, workers fetch the rest, see fiber_pool_f(). */
+	cbus_endpoint_fetch_awake(&pool->endpoint, &pool->output);
 
 	struct stailq *output = &pool->output;
 	while (! stailq_empty(output)) {
@@ -133,6 +140,13 @@ fiber_pool_cb(ev_loop *loop, struct ev_watcher *watcher, int events)
 			f = fiber_new(cord_name(cord()), fiber_pool_f);
 			if (f == NULL) {
 				diag_log();
+				/*
+				 * No worker is going to fetch messages,
+				 * let producers notify the pool again.
+				 */
+				if (pool->size == 0)
+					cbus_endpoint_fetch(&pool->endpoint,
+							    output);
 				break;
 			}
 			fiber_start(f, pool);
@@ -196,5 +210,6 @@ fiber_pool_destroy(struct fiber_pool *pool)
 	while (pool->size > 0)
 		fiber_cond_wait(&pool->worker_cond);
 	fiber_cond_destroy(&pool->worker_cond);
+	ev_timer_stop(pool->consumer, &pool->idle_timer);
 }
 
@@ -0,0 +1,564 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "io_ring.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "diag.h"
+#include "errinj.h"
+#include "fiber.h"
+#include "trivia/config.h"
+#include "trivia/util.h"
+
+#if defined(HAVE_IO_URING)
+
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+enum {
+	/** Max number of requests queued for submission. */
+	IO_RING_ENTRIES = 256,
+	/** Max number of linked requests submitted by io_ring_writev(). */
+	IO_RING_CHAIN_MAX = 16,
+};
+
+/** A request submitted to an io_uring instance. */
+struct io_ring_request {
+	/** Fiber waiting for the request, NULL if the thread is blocked. */
+	struct fiber *fiber;
+	/** Result of the operation: >= 0 on success, -errno on error. */
+	int res;
+	/** Set when the request is complete. */
+	bool is_done;
+};
+
+struct io_ring {
+	/** io_uring file descriptor. */
+	int fd;
+	/** Event fd signalled by the kernel on request completion. */
+	int event_fd;
+	/** Memory shared with the kernel. */
+	void *sq_ptr;
+	size_t sq_size;
+	void *cq_ptr;
+	size_t cq_size;
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+	/** Submission ring. */
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned *sq_array;
+	unsigned sq_mask;
+	unsigned sq_entries;
+	/**
+	 * Tail of the submission ring including requests that
+	 * have been queued, but not yet passed to the kernel.
+	 */
+	unsigned sqe_tail;
+	/** Completion ring. */
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	struct io_uring_cqe *cqes;
+	unsigned cq_mask;
+	/** Reaps completed requests when the event fd is signalled. */
+	struct ev_io complete_watcher;
+	/** Submits queued requests before the event loop blocks. */
+	struct ev_prepare submit_watcher;
+};
+
+/** io_uring instance of the current thread. */
+static __thread struct io_ring *cord_io_ring = NULL;
+
+static void
+io_ring_request_complete(struct io_ring_request *req, int res)
+{
+	req->res = res;
+	req->is_done = true;
+	if (req->fiber != NULL)
+		fiber_wakeup(req->fiber);
+}
+
+/** Process all requests completed by the kernel. */
+static void
+io_ring_reap(struct io_ring *ring)
+{
+	unsigned head = *ring->cq_head;
+	unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+	for (; head != tail; head++) {
+		struct io_uring_cqe *cqe = &ring->cqes[head & ring->cq_mask];
+		io_ring_request_complete(
+			(struct io_ring_request *)(uintptr_t)cqe->user_data,
+			cqe->res);
+	}
+	__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/**
+ * Pass queued requests to the kernel and, if @a wait is set, wait
+ * for at least one request to complete. If the kernel refuses to
+ * accept the requests, complete them with an error.
+ */
+static void
+io_ring_submit(struct io_ring *ring, bool wait)
+{
+	__atomic_store_n(ring->sq_tail, ring->sqe_tail, __ATOMIC_RELEASE);
+	unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+	unsigned to_submit = ring->sqe_tail - head;
+	if (to_submit == 0 && !wait)
+		return;
+	while (syscall(__NR_io_uring_enter, ring->fd, to_submit, wait ? 1 : 0,
+		       wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0) < 0) {
+		if (errno == EINTR)
+			continue;
+		if (errno == EBUSY || errno == EAGAIN) {
+			/* The completion ring is full. */
+			io_ring_reap(ring);
+			continue;
+		}
+		int err = errno;
+		head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+		for (; head != ring->sqe_tail; head++) {
+			struct io_uring_sqe *sqe =
+				&ring->sqes[head & ring->sq_mask];
+			io_ring_request_complete(
+				(struct io_ring_request *)(uintptr_t)
+				sqe->user_data, -err);
+		}
+		ring->sqe_tail = *ring->sq_head;
+		__atomic_store_n(ring->sq_tail, ring->sqe_tail,
+				 __ATOMIC_RELEASE);
+		break;
+	}
+}
+
+/**
+ * Get a slot for a new request in the submission ring. If the ring
+ * is full, pass the queued requests to the kernel first.
+ */
+static struct io_uring_sqe *
+io_ring_get_sqe(struct io_ring *ring)
+{
+	unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+	if (ring->sqe_tail - head >= ring->sq_entries) {
+		io_ring_submit(ring, false);
+		head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+		assert(ring->sqe_tail - head < ring->sq_entries);
+	}
+	unsigned idx = ring->sqe_tail++ & ring->sq_mask;
+	ring->sq_array[idx] = idx;
+	struct io_uring_sqe *sqe = &ring->sqes[idx];
+	memset(sqe, 0, sizeof(*sqe));
+	return sqe;
+}
+
+/** Wait for a queued request to complete. */
+static void
+io_ring_wait(struct io_ring_request *req)
+{
+	/*
+	 * The kernel may write to the request buffer until
+	 * the request completes so ignore spurious wakeups.
+	 */
+	while (!req->is_done)
+		fiber_yield();
+}
+
+/**
+ * Submit queued requests and wait for @a count requests starting
+ * at @a reqs to complete, blocking the thread.
+ */
+static void
+io_ring_wait_blocking(struct io_ring *ring, struct io_ring_request *reqs,
+		      int count)
+{
+	for (int i = 0; i < count; i++) {
+		while (!reqs[i].is_done) {
+			io_ring_submit(ring, true);
+			io_ring_reap(ring);
+		}
+	}
+}
+
+static void
+io_ring_complete_cb(ev_loop *loop, struct ev_io *watcher, int events)
+{
+	(void)loop;
+	(void)events;
+	struct io_ring *ring = watcher->data;
+	uint64_t value;
+	/* Reset the counter. The fd is non-blocking. */
+	while (read(ring->event_fd, &value, sizeof(value)) < 0 &&
+	       errno == EINTR) {
+	}
+	io_ring_reap(ring);
+}
+
+static void
+io_ring_submit_cb(ev_loop *loop, struct ev_prepare *watcher, int events)
+{
+	(void)loop;
+	(void)events;
+	struct io_ring *ring = watcher->data;
+	io_ring_submit(ring, false);
+}
+
+static void
+io_ring_delete(struct io_ring *ring)
+{
+	if (ring->sqes != NULL)
+		munmap(ring->sqes, ring->sqes_size);
+	if (ring->cq_ptr != NULL && ring->cq_ptr != ring->sq_ptr)
+		munmap(ring->cq_ptr, ring->cq_size);
+	if (ring->sq_ptr != NULL)
+		munmap(ring->sq_ptr, ring->sq_size);
+	if (ring->event_fd >= 0)
+		close(ring->event_fd);
+	if (ring->fd >= 0)
+		close(ring->fd);
+	free(ring);
+}
+
+/** Map a region of io_uring memory. Returns NULL on failure. */
+static void *
+io_ring_mmap(int fd, size_t size, off_t offset)
+{
+	void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_POPULATE, fd, offset);
+	if (ptr == MAP_FAILED) {
+		diag_set(SystemError, "failed to map io_uring memory");
+		return NULL;
+	}
+	return ptr;
+}
+
+int
+io_ring_init(void)
+{
+	assert(cord_io_ring == NULL);
+	struct io_ring *ring = calloc(1, sizeof(*ring));
+	if (ring == NULL) {
+		diag_set(OutOfMemory, sizeof(*ring), "calloc", "io_ring");
+		return -1;
+	}
+	ring->event_fd = -1;
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	ring->fd = syscall(__NR_io_uring_setup, IO_RING_ENTRIES, &params);
+	if (ring->fd < 0) {
+		diag_set(SystemError, "io_uring_setup failed");
+		goto fail;
+	}
+	/*
+	 * IORING_OP_READ we rely on was added in Linux 5.6 along
+	 * with this feature flag, which is the simplest way to
+	 * check for it.
+	 */
+	if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+		errno = ENOTSUP;
+		diag_set(SystemError, "io_uring is too old");
+		goto fail;
+	}
+	ring->sq_size = params.sq_off.array +
+			params.sq_entries * sizeof(unsigned);
+	ring->cq_size = params.cq_off.cqes +
+			params.cq_entries * sizeof(struct io_uring_cqe);
+	if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+		ring->sq_size = MAX(ring->sq_size, ring->cq_size);
+		ring->cq_size = ring->sq_size;
+	}
+	ring->sq_ptr = io_ring_mmap(ring->fd, ring->sq_size,
+				    IORING_OFF_SQ_RING);
+	if (ring->sq_ptr == NULL)
+		goto fail;
+	if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+		ring->cq_ptr = ring->sq_ptr;
+	} else {
+		ring->cq_ptr = io_ring_mmap(ring->fd, ring->cq_size,
+					    IORING_OFF_CQ_RING);
+		if (ring->cq_ptr == NULL)
+			goto fail;
+	}
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = io_ring_mmap(ring->fd, ring->sqes_size, IORING_OFF_SQES);
+	if (ring->sqes == NULL)
+		goto fail;
+
+	char *sq = ring->sq_ptr;
+	ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+	ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+	ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+	ring->sq_mask = *(unsigned *)(sq + params.sq_off.ring_mask);
+	ring->sq_entries = *(unsigned *)(sq + params.sq_off.ring_entries);
+	ring->sqe_tail = *ring->sq_tail;
+	char *cq = ring->cq_ptr;
+	ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+	ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+	ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+	ring->cq_mask = *(unsigned *)(cq + params.cq_off.ring_mask);
+
+	ring->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (ring->event_fd < 0) {
+		diag_set(SystemError, "eventfd failed");
+		goto fail;
+	}
+	if (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_EVENTFD,
+		    &ring->event_fd, 1) != 0) {
+		diag_set(SystemError, "failed to register io_uring eventfd");
+		goto fail;
+	}
+	ev_io_init(&ring->complete_watcher, io_ring_complete_cb,
+		   ring->event_fd, EV_READ);
+	ring->complete_watcher.data = ring;
+	ev_prepare_init(&ring->submit_watcher, io_ring_submit_cb);
+	ring->submit_watcher.data = ring;
+	ev_io_start(loop(), &ring->complete_watcher);
+	ev_prepare_start(loop(), &ring->submit_watcher);
+	cord_io_ring = ring;
+	return 0;
+fail:
+	io_ring_delete(ring);
+	return -1;
+}
+
+void
+io_ring_destroy(void)
+{
+	struct io_ring *ring = cord_io_ring;
+	if (ring == NULL)
+		return;
+	ev_io_stop(loop(), &ring->complete_watcher);
+	ev_prepare_stop(loop(), &ring->submit_watcher);
+	io_ring_delete(ring);
+	cord_io_ring = NULL;
+}
+
+bool
+io_ring_is_enabled(void)
+{
+	return cord_io_ring != NULL;
+}
+
+ssize_t
+io_ring_pread(int fd, void *buf, size_t count, off_t offset)
+{
+	struct io_ring *ring = cord_io_ring;
+	assert(ring != NULL);
+	size_t pos = 0;
+	while (pos < count) {
+		struct io_ring_request req = {fiber(), 0, false};
+		struct io_uring_sqe *sqe = io_ring_get_sqe(ring);
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = fd;
+		sqe->addr = (uintptr_t)((char *)buf + pos);
+		sqe->len = MIN(count - pos, (size_t)INT_MAX);
+		sqe->off = offset + pos;
+		sqe->user_data = (uintptr_t)&req;
+#ifndef NDEBUG
+		__atomic_add_fetch(&errinj(ERRINJ_IO_RING_READ_COUNT,
+					   ERRINJ_INT)->iparam, 1,
+				   __ATOMIC_RELAXED);
+#endif
+		io_ring_wait(&req);
+		if (req.res < 0) {
+			if (req.res == -EINTR || req.res == -EAGAIN)
+				continue;
+			errno = -req.res;
+			return -1;
+		}
+		if (req.res == 0)
+			break;
+		pos += req.res;
+	}
+	return pos;
+}
+
+/**
+ * Skip @a size written bytes of a vector: first of the remainder
+ * @a part of a partially written buffer, then of the buffers
+ * following it.
+ */
+static void
+io_ring_iov_advance(struct iovec *part, const struct iovec **iov,
+		    int *iovcnt, size_t size)
+{
+	size_t skip = MIN(size, part->iov_len);
+	part->iov_base = (char *)part->iov_base + skip;
+	part->iov_len -= skip;
+	size -= skip;
+	while (*iovcnt > 0 && size >= (*iov)->iov_len) {
+		size -= (*iov)->iov_len;
+		(*iov)++;
+		(*iovcnt)--;
+	}
+	if (size > 0) {
+		assert(*iovcnt > 0);
+		part->iov_base = (char *)(*iov)->iov_base + size;
+		part->iov_len = (*iov)->iov_len - size;
+		(*iov)++;
+		(*iovcnt)--;
+	}
+}
+
+ssize_t
+io_ring_writev(int fd, const struct iovec *iov, int iovcnt, bool sync)
+{
+	struct io_ring *ring = cord_io_ring;
+	assert(ring != NULL);
+	ssize_t total = 0;
+	/* Remainder of a partially written buffer. */
+	struct iovec part = {NULL, 0};
+	while (true) {
+		struct io_ring_request reqs[IO_RING_CHAIN_MAX];
+		/* Number of bytes each write is expected to write. */
+		size_t lens[IO_RING_CHAIN_MAX];
+		int count = 0;
+		const struct iovec *next = iov;
+		int left = iovcnt;
+		/*
+		 * Queue a chain of writes at the current file position
+		 * followed by a sync. The requests are linked so that
+		 * the kernel executes them in order and stops at the
+		 * first one that fails or writes less than requested.
+		 */
+		while ((count == 0 && part.iov_len > 0) ||
+		       (left > 0 && count < IO_RING_CHAIN_MAX - 1)) {
+			struct io_uring_sqe *sqe = io_ring_get_sqe(ring);
+			sqe->opcode = IORING_OP_WRITEV;
+			sqe->fd = fd;
+			sqe->off = (uint64_t)-1;
+			if (count == 0 && part.iov_len > 0) {
+				sqe->addr = (uintptr_t)&part;
+				sqe->len = 1;
+				lens[count] = part.iov_len;
+			} else {
+				int n = MIN(left, IOV_MAX);
+				sqe->addr = (uintptr_t)next;
+				sqe->len = n;
+				lens[count] = 0;
+				for (int i = 0; i < n; i++)
+					lens[count] += next[i].iov_len;
+				next += n;
+				left -= n;
+			}
+			sqe->flags = IOSQE_IO_LINK;
+			reqs[count] = (struct io_ring_request){NULL, 0, false};
+			sqe->user_data = (uintptr_t)&reqs[count];
+			count++;
+		}
+		int write_count = count;
+		bool chain_sync = sync && left == 0;
+		if (chain_sync) {
+			struct io_uring_sqe *sqe = io_ring_get_sqe(ring);
+			sqe->opcode = IORING_OP_FSYNC;
+			sqe->fd = fd;
+			sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+			reqs[count] = (struct io_ring_request){NULL, 0, false};
+			sqe->user_data = (uintptr_t)&reqs[count];
+			count++;
+		}
+		if (count == 0)
+			return total;
+		/* Terminate the chain. */
+		ring->sqes[(ring->sqe_tail - 1) & ring->sq_mask].flags &=
+			~IOSQE_IO_LINK;
+#ifndef NDEBUG
+		__atomic_add_fetch(&errinj(ERRINJ_IO_RING_WRITE_COUNT,
+					   ERRINJ_INT)->iparam, 1,
+				   __ATOMIC_RELAXED);
+#endif
+		io_ring_wait_blocking(ring, reqs, count);
+		/*
+		 * Account the data written by the chain. The requests
+		 * following a short or interrupted write are cancelled
+		 * and resubmitted by the next iteration.
+		 */
+		bool is_complete = true;
+		for (int i = 0; i < write_count; i++) {
+			int res = reqs[i].res;
+			if (res == -EINTR || res == -EAGAIN ||
+			    res == -ECANCELED) {
+				is_complete = false;
+				break;
+			}
+			if (res < 0) {
+				errno = -res;
+				return -1;
+			}
+			total += res;
+			io_ring_iov_advance(&part, &iov, &iovcnt, res);
+			if ((size_t)res < lens[i]) {
+				is_complete = false;
+				break;
+			}
+		}
+		if (!is_complete || !chain_sync)
+			continue;
+		int res = reqs[write_count].res;
+		if (res == 0)
+			return total;
+		if (res != -EINTR && res != -EAGAIN && res != -ECANCELED) {
+			errno = -res;
+			return -1;
+		}
+		/* Only the sync is left to resubmit. */
+		assert(iovcnt == 0 && part.iov_len == 0);
+	}
+}
+
+#else /* !defined(HAVE_IO_URING) */
+
+int
+io_ring_init(void)
+{
+	errno = ENOTSUP;
+	diag_set(SystemError, "io_uring is not supported");
+	return -1;
+}
+
+void
+io_ring_destroy(void)
+{
+}
+
+bool
+io_ring_is_enabled(void)
+{
+	return false;
+}
+
+ssize_t
+io_ring_pread(int fd, void *buf, size_t count, off_t offset)
+{
+	(void)fd;
+	(void)buf;
+	(void)count;
+	(void)offset;
+	unreachable();
+	errno = ENOTSUP;
+	return -1;
+}
+
+ssize_t
+io_ring_writev(int fd, const struct iovec *iov, int iovcnt, bool sync)
+{
+	(void)fd;
+	(void)iov;
+	(void)iovcnt;
+	(void)sync;
+	unreachable();
+	errno = ENOTSUP;
+	return -1;
+}
+
+#endif /* !defined(HAVE_IO_URING) */
@@ -0,0 +1,73 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+struct iovec;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * File I/O through a per-thread Linux io_uring instance.
+ *
+ * A thread that wants to use it calls io_ring_init(). Requests
+ * are queued to the submission ring and submitted in one system
+ * call per event loop iteration, right before the loop polls for
+ * events, so requests issued by different fibers are batched.
+ * Completions are reaped when the ring signals its event fd.
+ * A thread that owns the data it writes and can't proceed until
+ * it's written, like the WAL thread, may instead submit a chain
+ * of requests and block until they complete, see io_ring_writev().
+ *
+ * Like the rest of file I/O functions, the functions below follow
+ * the error reporting convention of the respective system calls.
+ */
+
+/**
+ * Set up an io_uring instance for the current thread. Fails with
+ * a SystemError if io_uring isn't supported by the kernel or
+ * Tarantool was built without io_uring support.
+ */
+int
+io_ring_init(void);
+
+/**
+ * Destroy the io_uring instance of the current thread, if any.
+ * There must be no requests in flight.
+ */
+void
+io_ring_destroy(void);
+
+/** Check if the current thread has an io_uring instance. */
+bool
+io_ring_is_enabled(void);
+
+/**
+ * Read up to @a count bytes at @a offset. The calling fiber yields
+ * until the read is complete. Retries on partial reads, like
+ * fio_pread(). Can't be cancelled.
+ */
+ssize_t
+io_ring_pread(int fd, void *buf, size_t count, off_t offset);
+
+/**
+ * Write @a iovcnt buffers at the current file position and, if
+ * @a sync is set, sync the file data. The writes and the sync are
+ * linked and submitted in one system call. Blocks the calling
+ * thread until they complete. Retries on partial writes, like
+ * fio_writevn(). Returns the number of bytes written. If a write
+ * or the sync fails, returns -1 and sets errno.
+ */
+ssize_t
+io_ring_writev(int fd, const struct iovec *iov, int iovcnt, bool sync);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
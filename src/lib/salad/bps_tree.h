@@ -158,6 +158,11 @@
  * struct bps_tree_iterator bps_tree_lower_bound_elem(tree, elem, exact);
  * struct bps_tree_iterator bps_tree_upper_bound_elem(tree, elem, exact);
  * size_t bps_tree_approxiamte_count(tree, key);
+ * struct bps_tree_iterator bps_tree_iterator_at(tree, offset);
+ * struct bps_tree_iterator bps_tree_lower_bound_get_offset(tree, key, exact,
+ *							   offset);
+ * struct bps_tree_iterator bps_tree_upper_bound_get_offset(tree, key, exact,
+ *							   offset);
  * bps_tree_elem_t *bps_tree_iterator_get_elem(tree, itr);
  * bool bps_tree_iterator_next(tree, itr);
  * bool bps_tree_iterator_prev(tree, itr);
@@ -302,6 +307,16 @@
  * #define BPS_BLOCK_LINEAR_SEARCH
  */
 
+/**
+ * A switch that makes every inner block store the number of elements
+ * in each of its child subtrees (subtree cardinality). It slightly
+ * reduces the fanout of inner blocks and adds a little overhead to
+ * insertion and deletion, but turns bps_tree_iterator_at and
+ * bps_tree_*_bound_get_offset into O(log(N)) operations (they are
+ * O(N / B) without it). To turn it on,
+ * #define BPS_INNER_CARD
+ */
+
 /**
  * A switch that enables collection of executions of different
  * branches of code. Used only for debug purposes, I hope you
@@ -389,6 +404,9 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_lower_bound_elem _api_name(lower_bound_elem)
 #define bps_tree_upper_bound_elem _api_name(upper_bound_elem)
 #define bps_tree_approximate_count _api_name(approximate_count)
+#define bps_tree_iterator_at _api_name(iterator_at)
+#define bps_tree_lower_bound_get_offset _api_name(lower_bound_get_offset)
+#define bps_tree_upper_bound_get_offset _api_name(upper_bound_get_offset)
 #define bps_tree_iterator_get_elem _api_name(iterator_get_elem)
 #define bps_tree_iterator_next _api_name(iterator_next)
 #define bps_tree_iterator_prev _api_name(iterator_prev)
@@ -426,6 +444,14 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_reserve_blocks _bps_tree(reserve_blocks)
 #define bps_tree_insert_first_elem _bps_tree(insert_first_elem)
 #define bps_tree_collect_path _bps_tree(collect_path)
+#define bps_tree_inner_card _bps_tree(inner_card)
+#define bps_tree_build_cards _bps_tree(build_cards)
+#define bps_tree_inner_set_child _bps_tree(inner_set_child)
+#define bps_tree_inner_move_children _bps_tree(inner_move_children)
+#define bps_tree_leaf_path_set_card _bps_tree(leaf_path_set_card)
+#define bps_tree_inner_path_set_card _bps_tree(inner_path_set_card)
+#define bps_tree_path_add_card _bps_tree(path_add_card)
+#define bps_tree_iterator_get_offset _bps_tree(iterator_get_offset)
 #define bps_tree_touch_leaf_path_max_elem _bps_tree(touch_leaf_path_max_elem)
 #define bps_tree_touch_path _bps_tree(touch_path_max_elem)
 #define bps_tree_process_replace _bps_tree(process_replace)
@@ -806,6 +832,52 @@ bps_tree_upper_bound_elem(const struct bps_tree *tree, bps_tree_elem_t key,
 static inline size_t
 bps_tree_approximate_count(const struct bps_tree *tree, bps_tree_key_t key);
 
+/**
+ * @brief Get an iterator to the element at the given position
+ * (counting from zero) in the tree.
+ * Has logarithmic complexity if BPS_INNER_CARD is defined and
+ * walks the list of leaves otherwise.
+ * @param tree - pointer to a tree
+ * @param offset - position of the element
+ * @return - Iterator to the element. Invalid if offset >= tree size.
+ */
+static inline struct bps_tree_iterator
+bps_tree_iterator_at(const struct bps_tree *tree, size_t offset);
+
+/**
+ * @brief Same as bps_tree_lower_bound, but also calculates the
+ * position of the found element in the tree.
+ * Has logarithmic complexity if BPS_INNER_CARD is defined and
+ * walks the list of leaves otherwise.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @param exact - see bps_tree_lower_bound
+ * @param[out] offset - number of elements that are less than the key
+ * @return - Lower-bound iterator. Invalid if all elements are less than key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_lower_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset);
+
+/**
+ * @brief Same as bps_tree_upper_bound, but also calculates the
+ * position of the found element in the tree.
+ * Has logarithmic complexity if BPS_INNER_CARD is defined and
+ * walks the list of leaves otherwise.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @param exact - see bps_tree_upper_bound
+ * @param[out] offset - number of elements that are less than or
+ *  equal to the key
+ * @return - Upper-bound iterator. Invalid if all elements are less or equal
+ *  than the key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_upper_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset);
+
 /**
  * @brief Get a pointer to the element pointed by iterator.
  *  If iterator is detected as broken, it is invalidated and NULL returned.
@@ -938,9 +1010,18 @@ enum bps_tree_max_sizes {
 		(BPS_TREE_BLOCK_SIZE - sizeof(struct bps_block)
 		 - 2 * sizeof(bps_tree_block_id_t) )
 		/ sizeof(bps_tree_elem_t),
+#ifdef BPS_INNER_CARD
+	/* Reserve space for alignment of the child_cards array. */
+	BPS_TREE_MAX_COUNT_IN_INNER =
+		(BPS_TREE_BLOCK_SIZE - sizeof(struct bps_block)
+		 - sizeof(size_t))
+		/ (sizeof(bps_tree_elem_t) + sizeof(bps_tree_block_id_t)
+		   + sizeof(size_t)),
+#else
 	BPS_TREE_MAX_COUNT_IN_INNER =
 		(BPS_TREE_BLOCK_SIZE - sizeof(struct bps_block))
 		/ (sizeof(bps_tree_elem_t) + sizeof(bps_tree_block_id_t)),
+#endif
 	BPS_TREE_MAX_DEPTH = 16
 };
 
@@ -977,7 +1058,8 @@ CT_ASSERT_G(sizeof(struct bps_leaf) <= BPS_TREE_BLOCK_SIZE);
  * copies of maximal elements of the corresponding subtrees. Only
  * last child subtree does not have corresponding element copy in
  * this array (but it has a copy of maximal element somewhere in
- * parent's arrays on in tree struct)
+ * parent's arrays on in tree struct). If BPS_INNER_CARD is defined,
+ * also contains an array of cardinalities of the child subtrees.
  */
 struct bps_inner {
 	/* Block header */
@@ -986,6 +1068,10 @@ struct bps_inner {
 	bps_tree_elem_t elems[BPS_TREE_MAX_COUNT_IN_INNER - 1];
 	/* Corresponding child IDs */
 	bps_tree_block_id_t child_ids[BPS_TREE_MAX_COUNT_IN_INNER];
+#ifdef BPS_INNER_CARD
+	/* Number of elements in the corresponding child subtrees */
+	size_t child_cards[BPS_TREE_MAX_COUNT_IN_INNER];
+#endif
 };
 
 /**
@@ -1035,6 +1121,14 @@ struct bps_inner_path_elem {
 	bps_tree_block_id_t max_elem_block_id;
 	/* Holder of max_elem_copy (pos) */
 	bps_tree_pos_t max_elem_pos;
+#ifdef BPS_INNER_CARD
+	/*
+	 * Pointer to the cardinality of a block that is not linked
+	 * to the parent yet (NULL for linked blocks, see
+	 * bps_tree_leaf_path_set_card)
+	 */
+	size_t *card_copy;
+#endif
 };
 
 /**
@@ -1059,8 +1153,25 @@ struct bps_leaf_path_elem {
 	bps_tree_block_id_t max_elem_block_id;
 	/* Holder of max_elem_copy (pos) */
 	bps_tree_pos_t max_elem_pos;
+#ifdef BPS_INNER_CARD
+	/*
+	 * Pointer to the cardinality of a block that is not linked
+	 * to the parent yet (NULL for linked blocks, see
+	 * bps_tree_leaf_path_set_card)
+	 */
+	size_t *card_copy;
+#endif
 };
 
+/**
+ * Zero initializer of a path element
+ */
+#ifdef BPS_INNER_CARD
+#define BPS_TREE_PATH_ELEM_ZERO {0, 0, 0, 0, 0, 0, 0, 0, 0}
+#else
+#define BPS_TREE_PATH_ELEM_ZERO {0, 0, 0, 0, 0, 0, 0, 0}
+#endif
+
 /**
  * @brief Tree construction. Fills struct bps_tree members.
  * @param tree - pointer to a tree
@@ -1107,6 +1218,15 @@ bps_tree_create(struct bps_tree *tree, bps_tree_arg_t arg,
 #endif
 }
 
+#ifdef BPS_INNER_CARD
+/**
+ * bps_tree_build_cards declaration. See definition for details.
+ */
+static inline size_t
+bps_tree_build_cards(struct bps_tree *tree, bps_tree_block_id_t block_id,
+		     bps_tree_block_id_t level);
+#endif
+
 /**
  * @brief Fills a new (asserted) tree with values from sorted array.
  *  Elements are copied from the array. Array is not checked to be sorted!
@@ -1246,6 +1366,9 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 	} else {
 		tree->root_id = root_if_inner_id;
 	}
+#ifdef BPS_INNER_CARD
+	bps_tree_build_cards(tree, tree->root_id, depth);
+#endif
 	return 0;
 }
 
@@ -1321,6 +1444,43 @@ bps_tree_touch_block(struct bps_tree *tree, bps_tree_block_id_t id)
 	return (struct bps_block *)matras_touch(&tree->matras, id);
 }
 
+#ifdef BPS_INNER_CARD
+/**
+ * @brief Get the number of elements in the subtree of an inner block.
+ */
+static inline size_t
+bps_tree_inner_card(const struct bps_inner *inner)
+{
+	size_t card = 0;
+	for (bps_tree_pos_t i = 0; i < inner->header.size; i++)
+		card += inner->child_cards[i];
+	return card;
+}
+
+/**
+ * @brief Recursively fill cardinalities of children of a subtree
+ * that was just built. Used by bps_tree_build.
+ * @param level - 1 for a leaf, 2 for its parent and so on.
+ * @return - number of elements in the subtree.
+ */
+static inline size_t
+bps_tree_build_cards(struct bps_tree *tree, bps_tree_block_id_t block_id,
+		     bps_tree_block_id_t level)
+{
+	struct bps_block *block = bps_tree_restore_block(tree, block_id);
+	if (level == 1)
+		return block->size;
+	struct bps_inner *inner = (struct bps_inner *)block;
+	size_t card = 0;
+	for (bps_tree_pos_t i = 0; i < inner->header.size; i++) {
+		inner->child_cards[i] = bps_tree_build_cards(tree,
+				inner->child_ids[i], level - 1);
+		card += inner->child_cards[i];
+	}
+	return card;
+}
+#endif
+
 /**
  * @brief Get a random element in a tree.
  * @param tree - pointer to a tree
@@ -1974,6 +2134,205 @@ bps_tree_approximate_count(const struct bps_tree *tree, bps_tree_key_t key)
 	return result;
 }
 
+#ifndef BPS_INNER_CARD
+/**
+ * @brief Calculate the position of the element pointed by an iterator
+ * in the tree by walking the list of leaves from the first one.
+ * @param tree - pointer to a tree
+ * @param itr - iterator, the tree size is returned for invalid one
+ * @return - number of elements that precede the iterator
+ */
+static inline size_t
+bps_tree_iterator_get_offset(const struct bps_tree *tree,
+			     const struct bps_tree_iterator *itr)
+{
+	if (itr->block_id == (bps_tree_block_id_t)(-1))
+		return tree->size;
+	size_t offset = itr->pos;
+	bps_tree_block_id_t block_id = tree->first_id;
+	while (block_id != itr->block_id) {
+		struct bps_leaf *leaf = (struct bps_leaf *)
+			bps_tree_restore_block(tree, block_id);
+		offset += leaf->header.size;
+		block_id = leaf->next_id;
+	}
+	return offset;
+}
+#endif
+
+/**
+ * @brief Get an iterator to the element at the given position
+ * (counting from zero) in the tree.
+ * @param tree - pointer to a tree
+ * @param offset - position of the element
+ * @return - Iterator to the element. Invalid if offset >= tree size.
+ */
+static inline struct bps_tree_iterator
+bps_tree_iterator_at(const struct bps_tree *tree, size_t offset)
+{
+	if (offset >= tree->size)
+		return bps_tree_invalid_iterator();
+	struct bps_tree_iterator res;
+	matras_head_read_view(&res.view);
+#ifdef BPS_INNER_CARD
+	struct bps_block *block = bps_tree_root(tree);
+	bps_tree_block_id_t block_id = tree->root_id;
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos = 0;
+		while (offset >= inner->child_cards[pos]) {
+			offset -= inner->child_cards[pos];
+			pos++;
+			assert(pos < inner->header.size);
+		}
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block(tree, block_id);
+	}
+	assert(offset < (size_t)block->size);
+#else
+	bps_tree_block_id_t block_id = tree->first_id;
+	struct bps_block *block = bps_tree_restore_block(tree, block_id);
+	while (offset >= (size_t)block->size) {
+		offset -= block->size;
+		block_id = ((struct bps_leaf *)block)->next_id;
+		block = bps_tree_restore_block(tree, block_id);
+	}
+#endif
+	res.block_id = block_id;
+	res.pos = (bps_tree_pos_t)offset;
+	return res;
+}
+
+/**
+ * @brief Same as bps_tree_lower_bound, but also calculates the
+ * position of the found element in the tree.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @param exact - see bps_tree_lower_bound
+ * @param[out] offset - number of elements that are less than the key
+ * @return - Lower-bound iterator. Invalid if all elements are less than key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_lower_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset)
+{
+#ifndef BPS_INNER_CARD
+	struct bps_tree_iterator res = bps_tree_lower_bound(tree, key, exact);
+	*offset = bps_tree_iterator_get_offset(tree, &res);
+	return res;
+#else
+	struct bps_tree_iterator res;
+	matras_head_read_view(&res.view);
+	bool local_result;
+	if (!exact)
+		exact = &local_result;
+	*exact = false;
+	*offset = 0;
+	if (tree->root_id == (bps_tree_block_id_t)(-1)) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	struct bps_block *block = bps_tree_root(tree);
+	bps_tree_block_id_t block_id = tree->root_id;
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_ins_point_key(tree, inner->elems,
+						  inner->header.size - 1,
+						  key, exact);
+		for (bps_tree_pos_t j = 0; j < pos; j++)
+			*offset += inner->child_cards[j];
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block(tree, block_id);
+	}
+
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_pos_t pos;
+	pos = bps_tree_find_ins_point_key(tree, leaf->elems, leaf->header.size,
+					  key, exact);
+	*offset += pos;
+	if (pos >= leaf->header.size) {
+		res.block_id = leaf->next_id;
+		res.pos = 0;
+	} else {
+		res.block_id = block_id;
+		res.pos = pos;
+	}
+	return res;
+#endif
+}
+
+/**
+ * @brief Same as bps_tree_upper_bound, but also calculates the
+ * position of the found element in the tree.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @param exact - see bps_tree_upper_bound
+ * @param[out] offset - number of elements that are less than or
+ *  equal to the key
+ * @return - Upper-bound iterator. Invalid if all elements are less or equal
+ *  than the key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_upper_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset)
+{
+#ifndef BPS_INNER_CARD
+	struct bps_tree_iterator res = bps_tree_upper_bound(tree, key, exact);
+	*offset = bps_tree_iterator_get_offset(tree, &res);
+	return res;
+#else
+	struct bps_tree_iterator res;
+	matras_head_read_view(&res.view);
+	bool local_result;
+	if (!exact)
+		exact = &local_result;
+	*exact = false;
+	*offset = 0;
+	bool exact_test;
+	if (tree->root_id == (bps_tree_block_id_t)(-1)) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	struct bps_block *block = bps_tree_root(tree);
+	bps_tree_block_id_t block_id = tree->root_id;
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_after_ins_point_key(tree, inner->elems,
+							inner->header.size - 1,
+							key, &exact_test);
+		if (exact_test)
+			*exact = true;
+		for (bps_tree_pos_t j = 0; j < pos; j++)
+			*offset += inner->child_cards[j];
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block(tree, block_id);
+	}
+
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_pos_t pos;
+	pos = bps_tree_find_after_ins_point_key(tree, leaf->elems,
+						leaf->header.size,
+						key, &exact_test);
+	if (exact_test)
+		*exact = true;
+	*offset += pos;
+	if (pos >= leaf->header.size) {
+		res.block_id = leaf->next_id;
+		res.pos = 0;
+	} else {
+		res.block_id = block_id;
+		res.pos = pos;
+	}
+	return res;
+#endif
+}
+
 /**
  * @brief Get a pointer to the element pointed by iterator.
  *  If iterator is detected as broken, it is invalidated and NULL returned.
@@ -2285,6 +2644,9 @@ bps_tree_collect_path(struct bps_tree *tree, bps_tree_elem_t new_elem,
 		path[i].max_elem_copy = max_elem_copy;
 		path[i].max_elem_block_id = max_elem_block_id;
 		path[i].max_elem_pos = max_elem_pos;
+#ifdef BPS_INNER_CARD
+		path[i].card_copy = NULL;
+#endif
 
 		if (pos < inner->header.size - 1) {
 			max_elem_copy = inner->elems + pos;
@@ -2314,6 +2676,9 @@ bps_tree_collect_path(struct bps_tree *tree, bps_tree_elem_t new_elem,
 	leaf_path_elem->max_elem_copy = max_elem_copy;
 	leaf_path_elem->max_elem_block_id = max_elem_block_id;
 	leaf_path_elem->max_elem_pos = max_elem_pos;
+#ifdef BPS_INNER_CARD
+	leaf_path_elem->card_copy = NULL;
+#endif
 }
 
 /**
@@ -2351,6 +2716,76 @@ bps_tree_touch_path(struct bps_tree *tree,
 	}
 }
 
+/**
+ * @brief Set the number of elements in the subtree of a leaf in its
+ * parent. If the leaf is not linked to the parent yet, the number is
+ * saved to card_copy. Does nothing unless BPS_INNER_CARD is defined.
+ */
+static inline void
+bps_tree_leaf_path_set_card(struct bps_leaf_path_elem *path_elem)
+{
+#ifdef BPS_INNER_CARD
+	if (path_elem->parent == NULL)
+		return;
+	size_t card = path_elem->block->header.size;
+	if (path_elem->card_copy != NULL)
+		*path_elem->card_copy = card;
+	else
+		path_elem->parent->block->child_cards[
+			path_elem->pos_in_parent] = card;
+#else
+	(void)path_elem;
+#endif
+}
+
+/**
+ * @brief Set the number of elements in the subtree of an inner block
+ * in its parent. See bps_tree_leaf_path_set_card.
+ */
+static inline void
+bps_tree_inner_path_set_card(struct bps_inner_path_elem *path_elem)
+{
+#ifdef BPS_INNER_CARD
+	if (path_elem->parent == NULL)
+		return;
+	size_t card = bps_tree_inner_card(path_elem->block);
+	if (path_elem->card_copy != NULL)
+		*path_elem->card_copy = card;
+	else
+		path_elem->parent->block->child_cards[
+			path_elem->pos_in_parent] = card;
+#else
+	(void)path_elem;
+#endif
+}
+
+/**
+ * @brief Add @a delta to cardinalities of all subtrees on the path
+ * from the root to a leaf. Called before an element is inserted
+ * into or deleted from the leaf, so the blocks that are restructured
+ * afterwards only need to recalculate cardinalities of themselves.
+ * Does nothing unless BPS_INNER_CARD is defined.
+ */
+static inline void
+bps_tree_path_add_card(struct bps_tree *tree,
+		       struct bps_leaf_path_elem *leaf_path_elem,
+		       int delta)
+{
+#ifdef BPS_INNER_CARD
+	bps_tree_touch_path(tree, leaf_path_elem);
+	bps_tree_pos_t pos = leaf_path_elem->pos_in_parent;
+	for (struct bps_inner_path_elem *path = leaf_path_elem->parent;
+	     path; path = path->parent) {
+		path->block->child_cards[pos] += delta;
+		pos = path->pos_in_parent;
+	}
+#else
+	(void)tree;
+	(void)leaf_path_elem;
+	(void)delta;
+#endif
+}
+
 /**
  * @brief Replace element by it's path and fill the *replaced argument
  */
@@ -2436,6 +2871,16 @@ bps_tree_debug_memmove(void *dst_arg, void *src_arg, size_t num,
 				assert(src < ((char *)src_inner->elems) +
 				       (BPS_TREE_MAX_COUNT_IN_INNER - 1) *
 				       sizeof(bps_tree_elem_t));
+#ifdef BPS_INNER_CARD
+			} else if (dst >= (char *)dst_inner->child_cards) {
+				assert(dst < ((char *)dst_inner->child_cards) +
+				       BPS_TREE_MAX_COUNT_IN_INNER *
+				       sizeof(size_t));
+				assert(src >= (char *)src_inner->child_cards);
+				assert(src < ((char *)src_inner->child_cards) +
+				       BPS_TREE_MAX_COUNT_IN_INNER *
+				       sizeof(size_t));
+#endif
 			} else {
 				assert(dst >= ((char *)dst_inner->child_ids));
 				assert(dst < ((char *)dst_inner->child_ids) +
@@ -2456,6 +2901,17 @@ bps_tree_debug_memmove(void *dst_arg, void *src_arg, size_t num,
 					(BPS_TREE_MAX_COUNT_IN_INNER - 1) *
 					sizeof(bps_tree_elem_t)) {
 				/* nothing to do due to if condition */
+#ifdef BPS_INNER_CARD
+			} else if (dst >= (char *)dst_inner->child_cards &&
+				   src >= (char *)src_inner->child_cards) {
+				assert(dst <= ((char *)dst_inner->child_cards) +
+				       BPS_TREE_MAX_COUNT_IN_INNER *
+				       sizeof(size_t));
+				assert(src >= (char *)src_inner->child_cards);
+				assert(src <= ((char *)src_inner->child_cards) +
+				       BPS_TREE_MAX_COUNT_IN_INNER *
+				       sizeof(size_t));
+#endif
 			} else {
 				assert(dst >= ((char *)dst_inner->child_ids));
 				assert(dst <= ((char *)dst_inner->child_ids) +
@@ -2473,6 +2929,41 @@ bps_tree_debug_memmove(void *dst_arg, void *src_arg, size_t num,
 }
 #endif
 
+/**
+ * @brief Set a child of an inner block.
+ * @param card - number of elements in the child subtree, ignored
+ *  unless BPS_INNER_CARD is defined.
+ */
+static inline void
+bps_tree_inner_set_child(struct bps_inner *inner, bps_tree_pos_t pos,
+			 bps_tree_block_id_t block_id, size_t card)
+{
+	inner->child_ids[pos] = block_id;
+#ifdef BPS_INNER_CARD
+	inner->child_cards[pos] = card;
+#else
+	(void)card;
+#endif
+}
+
+/**
+ * @brief Move a number of children (along with their cardinalities)
+ * from one position of an inner block to another position of the same
+ * or another inner block.
+ */
+static inline void
+bps_tree_inner_move_children(struct bps_inner *dst, bps_tree_pos_t dst_pos,
+			     struct bps_inner *src, bps_tree_pos_t src_pos,
+			     bps_tree_pos_t num)
+{
+	BPS_TREE_DATAMOVE(dst->child_ids + dst_pos, src->child_ids + src_pos,
+			  num, dst, src);
+#ifdef BPS_INNER_CARD
+	BPS_TREE_DATAMOVE(dst->child_cards + dst_pos,
+			  src->child_cards + src_pos, num, dst, src);
+#endif
+}
+
 /**
  * @breif Insert an element into leaf block. There must be enough space.
  */
@@ -2511,7 +3002,7 @@ static inline void
 bps_tree_insert_into_inner(struct bps_tree *tree,
 			   struct bps_inner_path_elem *inner_path_elem,
 			   bps_tree_block_id_t block_id, bps_tree_pos_t pos,
-			   bps_tree_elem_t max_elem)
+			   bps_tree_elem_t max_elem, size_t card)
 {
 	/* exclusive behaviuor for debug checks */
 	if (tree->root_id != (bps_tree_block_id_t) -1)
@@ -2527,15 +3018,14 @@ bps_tree_insert_into_inner(struct bps_tree *tree,
 		BPS_TREE_DATAMOVE(inner->elems + pos + 1, inner->elems + pos,
 				  inner->header.size - pos - 1, inner, inner);
 		inner->elems[pos] = max_elem;
-		BPS_TREE_DATAMOVE(inner->child_ids + pos + 1,
-				  inner->child_ids + pos,
-				  inner->header.size - pos, inner, inner);
+		bps_tree_inner_move_children(inner, pos + 1, inner, pos,
+					     inner->header.size - pos);
 	} else {
 		if (pos > 0)
 			inner->elems[pos - 1] = *inner_path_elem->max_elem_copy;
 		*inner_path_elem->max_elem_copy = max_elem;
 	}
-	inner->child_ids[pos] = block_id;
+	bps_tree_inner_set_child(inner, pos, block_id, card);
 
 	inner->header.size++;
 }
@@ -2591,9 +3081,8 @@ bps_tree_delete_from_inner(struct bps_tree *tree,
 	if (pos < inner->header.size - 1) {
 		BPS_TREE_DATAMOVE(inner->elems + pos, inner->elems + pos + 1,
 				  inner->header.size - 2 - pos, inner, inner);
-		BPS_TREE_DATAMOVE(inner->child_ids + pos,
-				  inner->child_ids + pos + 1,
-				  inner->header.size - 1 - pos, inner, inner);
+		bps_tree_inner_move_children(inner, pos, inner, pos + 1,
+					     inner->header.size - 1 - pos);
 	} else if (pos > 0) {
 		*inner_path_elem->max_elem_copy = inner->elems[pos - 1];
 	}
@@ -2636,6 +3125,8 @@ bps_tree_move_elems_to_right_leaf(struct bps_tree *tree,
 		*a_leaf_path_elem->max_elem_copy =
 			a->elems[a->header.size - 1];
 	*b_leaf_path_elem->max_elem_copy = b->elems[b->header.size - 1];
+	bps_tree_leaf_path_set_card(a_leaf_path_elem);
+	bps_tree_leaf_path_set_card(b_leaf_path_elem);
 }
 
 /**
@@ -2663,10 +3154,8 @@ bps_tree_move_elems_to_right_inner(struct bps_tree *tree,
 	assert(a->header.size >= num);
 	assert(b->header.size + num <= BPS_TREE_MAX_COUNT_IN_INNER);
 
-	BPS_TREE_DATAMOVE(b->child_ids + num, b->child_ids,
-			  b->header.size, b, b);
-	BPS_TREE_DATAMOVE(b->child_ids, a->child_ids + a->header.size - num,
-			  num, b, a);
+	bps_tree_inner_move_children(b, num, b, 0, b->header.size);
+	bps_tree_inner_move_children(b, 0, a, a->header.size - num, num);
 
 	if (!move_to_empty)
 		BPS_TREE_DATAMOVE(b->elems + num, b->elems,
@@ -2684,6 +3173,8 @@ bps_tree_move_elems_to_right_inner(struct bps_tree *tree,
 
 	a->header.size -= num;
 	b->header.size += num;
+	bps_tree_inner_path_set_card(a_inner_path_elem);
+	bps_tree_inner_path_set_card(b_inner_path_elem);
 }
 
 /**
@@ -2716,6 +3207,8 @@ bps_tree_move_elems_to_left_leaf(struct bps_tree *tree,
 	a->header.size += num;
 	b->header.size -= num;
 	*a_leaf_path_elem->max_elem_copy = a->elems[a->header.size - 1];
+	bps_tree_leaf_path_set_card(a_leaf_path_elem);
+	bps_tree_leaf_path_set_card(b_leaf_path_elem);
 }
 
 /**
@@ -2743,10 +3236,8 @@ bps_tree_move_elems_to_left_inner(struct bps_tree *tree,
 	assert(b->header.size >= num);
 	assert(a->header.size + num <= BPS_TREE_MAX_COUNT_IN_INNER);
 
-	BPS_TREE_DATAMOVE(a->child_ids + a->header.size, b->child_ids,
-			  num, a, b);
-	BPS_TREE_DATAMOVE(b->child_ids, b->child_ids + num,
-			  b->header.size - num, b, b);
+	bps_tree_inner_move_children(a, a->header.size, b, 0, num);
+	bps_tree_inner_move_children(b, 0, b, num, b->header.size - num);
 
 	if (!move_to_empty)
 		a->elems[a->header.size - 1] =
@@ -2763,6 +3254,8 @@ bps_tree_move_elems_to_left_inner(struct bps_tree *tree,
 
 	a->header.size += num;
 	b->header.size -= num;
+	bps_tree_inner_path_set_card(a_inner_path_elem);
+	bps_tree_inner_path_set_card(b_inner_path_elem);
 }
 
 /**
@@ -2830,6 +3323,8 @@ bps_tree_insert_and_move_elems_to_right_leaf(struct bps_tree *tree,
 	if (move_to_empty)
 		*b_leaf_path_elem->max_elem_copy =
 			b->elems[b->header.size - 1];
+	bps_tree_leaf_path_set_card(a_leaf_path_elem);
+	bps_tree_leaf_path_set_card(b_leaf_path_elem);
 	tree->size++;
 	return ret;
 }
@@ -2846,7 +3341,7 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 		struct bps_inner_path_elem *a_inner_path_elem,
 		struct bps_inner_path_elem *b_inner_path_elem,
 		bps_tree_pos_t num, bps_tree_block_id_t block_id,
-		bps_tree_pos_t pos, bps_tree_elem_t max_elem)
+		bps_tree_pos_t pos, bps_tree_elem_t max_elem, size_t card)
 {
 	/* exclusive behaviuor for debug checks */
 	if (tree->root_id != (bps_tree_block_id_t) -1) {
@@ -2867,8 +3362,7 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 	assert(pos >= 0);
 
 	if (!move_to_empty) {
-		BPS_TREE_DATAMOVE(b->child_ids + num, b->child_ids,
-				  b->header.size, b, b);
+		bps_tree_inner_move_children(b, num, b, 0, b->header.size);
 		BPS_TREE_DATAMOVE(b->elems + num, b->elems,
 				  b->header.size - 1, b, b);
 	}
@@ -2876,12 +3370,11 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 	bps_tree_pos_t mid_part_size = a->header.size - pos;
 	if (mid_part_size > num) {
 		/* In fact insert to 'a' block, to the internal position */
-		BPS_TREE_DATAMOVE(b->child_ids,
-				  a->child_ids + a->header.size - num,
-				  num, b, a);
-		BPS_TREE_DATAMOVE(a->child_ids + pos + 1, a->child_ids + pos,
-				  mid_part_size - num, a, a);
-		a->child_ids[pos] = block_id;
+		bps_tree_inner_move_children(b, 0,
+					     a, a->header.size - num, num);
+		bps_tree_inner_move_children(a, pos + 1,
+					     a, pos, mid_part_size - num);
+		bps_tree_inner_set_child(a, pos, block_id, card);
 
 		BPS_TREE_DATAMOVE(b->elems, a->elems + (a->header.size - num),
 				  num - 1, b, a);
@@ -2898,12 +3391,11 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 		a->elems[pos] = max_elem;
 	} else if (mid_part_size == num) {
 		/* In fact insert to 'a' block, to the last position */
-		BPS_TREE_DATAMOVE(b->child_ids,
-				  a->child_ids + a->header.size - num,
-				  num, b, a);
-		BPS_TREE_DATAMOVE(a->child_ids + pos + 1, a->child_ids + pos,
-				  mid_part_size - num, a, a);
-		a->child_ids[pos] = block_id;
+		bps_tree_inner_move_children(b, 0,
+					     a, a->header.size - num, num);
+		bps_tree_inner_move_children(a, pos + 1,
+					     a, pos, mid_part_size - num);
+		bps_tree_inner_set_child(a, pos, block_id, card);
 
 		BPS_TREE_DATAMOVE(b->elems, a->elems + (a->header.size - num),
 				  num - 1, b, a);
@@ -2917,12 +3409,12 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 	} else {
 		/* In fact insert to 'b' block */
 		bps_tree_pos_t new_pos = num - mid_part_size - 1;/* Can be 0 */
-		BPS_TREE_DATAMOVE(b->child_ids,
-				  a->child_ids + a->header.size - num + 1,
-				  new_pos, b, a);
-		b->child_ids[new_pos] = block_id;
-		BPS_TREE_DATAMOVE(b->child_ids + new_pos + 1,
-				  a->child_ids + pos, mid_part_size, b, a);
+		bps_tree_inner_move_children(b, 0,
+					     a, a->header.size - num + 1,
+					     new_pos);
+		bps_tree_inner_set_child(b, new_pos, block_id, card);
+		bps_tree_inner_move_children(b, new_pos + 1,
+					     a, pos, mid_part_size);
 
 		if (pos == a->header.size) {
 			/* +1 */
@@ -2967,6 +3459,8 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 
 	a->header.size -= (num - 1);
 	b->header.size += num;
+	bps_tree_inner_path_set_card(a_inner_path_elem);
+	bps_tree_inner_path_set_card(b_inner_path_elem);
 }
 
 /**
@@ -3033,6 +3527,8 @@ bps_tree_insert_and_move_elems_to_left_leaf(struct bps_tree *tree,
 	if (!move_all)
 		*b_leaf_path_elem->max_elem_copy =
 			b->elems[b->header.size - 1];
+	bps_tree_leaf_path_set_card(a_leaf_path_elem);
+	bps_tree_leaf_path_set_card(b_leaf_path_elem);
 	tree->size++;
 	return ret;
 }
@@ -3049,7 +3545,7 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 		struct bps_inner_path_elem *a_inner_path_elem,
 		struct bps_inner_path_elem *b_inner_path_elem, bps_tree_pos_t num,
 		bps_tree_block_id_t block_id, bps_tree_pos_t pos,
-		bps_tree_elem_t max_elem)
+		bps_tree_elem_t max_elem, size_t card)
 {
 	/* exclusive behaviuor for debug checks */
 	if (tree->root_id != (bps_tree_block_id_t) -1) {
@@ -3072,14 +3568,11 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 	if (pos >= num) {
 		/* In fact insert to 'b' block */
 		bps_tree_pos_t new_pos = pos - num; /* Can be 0 */
-		BPS_TREE_DATAMOVE(a->child_ids + a->header.size, b->child_ids,
-				  num, a, b);
-		BPS_TREE_DATAMOVE(b->child_ids, b->child_ids + num,
-				  new_pos, b, b);
-		b->child_ids[new_pos] = block_id;
-		BPS_TREE_DATAMOVE(b->child_ids + new_pos + 1,
-				  b->child_ids + pos,
-				  b->header.size - pos, b, b);
+		bps_tree_inner_move_children(a, a->header.size, b, 0, num);
+		bps_tree_inner_move_children(b, 0, b, num, new_pos);
+		bps_tree_inner_set_child(b, new_pos, block_id, card);
+		bps_tree_inner_move_children(b, new_pos + 1,
+					     b, pos, b->header.size - pos);
 
 		if (!move_to_empty)
 			a->elems[a->header.size - 1] =
@@ -3113,14 +3606,13 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 	} else {
 		/* In fact insert to 'a' block */
 		bps_tree_pos_t new_pos = a->header.size + pos; /* Can be 0 */
-		BPS_TREE_DATAMOVE(a->child_ids + a->header.size,
-				  b->child_ids, pos, a, b);
-		a->child_ids[new_pos] = block_id;
-		BPS_TREE_DATAMOVE(a->child_ids + new_pos + 1,
-				  b->child_ids + pos, num - 1 - pos, a, b);
+		bps_tree_inner_move_children(a, a->header.size, b, 0, pos);
+		bps_tree_inner_set_child(a, new_pos, block_id, card);
+		bps_tree_inner_move_children(a, new_pos + 1,
+					     b, pos, num - 1 - pos);
 		if (!move_all)
-			BPS_TREE_DATAMOVE(b->child_ids, b->child_ids + num - 1,
-					  b->header.size - num + 1, b, b);
+			bps_tree_inner_move_children(b, 0, b, num - 1,
+						     b->header.size - num + 1);
 
 		if (!move_to_empty)
 			a->elems[a->header.size - 1] =
@@ -3165,6 +3657,8 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 
 	a->header.size += num;
 	b->header.size -= (num - 1);
+	bps_tree_inner_path_set_card(a_inner_path_elem);
+	bps_tree_inner_path_set_card(b_inner_path_elem);
 }
 
 /**
@@ -3226,6 +3720,9 @@ bps_tree_collect_left_path_elem_leaf(struct bps_tree *tree,
 	new_path_elem->max_elem_copy =
 		parent->block->elems + new_path_elem->pos_in_parent;
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
+#ifdef BPS_INNER_CARD
+	new_path_elem->card_copy = NULL;
+#endif
 	return true;
 }
 
@@ -3253,6 +3750,9 @@ bps_tree_collect_left_path_elem_inner(struct bps_tree *tree,
 	new_path_elem->max_elem_copy = parent->block->elems +
 		new_path_elem->pos_in_parent;
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
+#ifdef BPS_INNER_CARD
+	new_path_elem->card_copy = NULL;
+#endif
 	return true;
 }
 
@@ -3282,6 +3782,9 @@ bps_tree_collect_right_ext_leaf(struct bps_tree *tree,
 		new_path_elem->max_elem_copy = parent->block->elems +
 			new_path_elem->pos_in_parent;
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
+#ifdef BPS_INNER_CARD
+	new_path_elem->card_copy = NULL;
+#endif
 	return true;
 }
 
@@ -3312,6 +3815,9 @@ bps_tree_collect_right_ext_inner(struct bps_tree *tree,
 		new_path_elem->max_elem_copy = parent->block->elems +
 			new_path_elem->pos_in_parent;
 	new_path_elem->insertion_point = (bps_tree_pos_t)(-1); /* unused */
+#ifdef BPS_INNER_CARD
+	new_path_elem->card_copy = NULL;
+#endif
 	return true;
 }
 
@@ -3358,7 +3864,7 @@ static int
 bps_tree_process_insert_inner(struct bps_tree *tree,
 			      struct bps_inner_path_elem *inner_path_elem,
 			      bps_tree_block_id_t block_id, bps_tree_pos_t pos,
-			      bps_tree_elem_t max_elem);
+			      bps_tree_elem_t max_elem, size_t card);
 
 /**
  * Basic inserted into leaf, dealing with spliting, merging and moving data
@@ -3380,10 +3886,10 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 	}
 	bps_tree_touch_path(tree, leaf_path_elem);
 
-	struct bps_leaf_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-			right_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-			left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-			right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0};
+	struct bps_leaf_path_elem left_ext = BPS_TREE_PATH_ELEM_ZERO,
+			right_ext = BPS_TREE_PATH_ELEM_ZERO,
+			left_left_ext = BPS_TREE_PATH_ELEM_ZERO,
+			right_right_ext = BPS_TREE_PATH_ELEM_ZERO;
 	bool has_left_ext =
 		bps_tree_collect_left_path_elem_leaf(tree, leaf_path_elem,
 						     &left_ext);
@@ -3510,6 +4016,10 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 	bps_tree_elem_t new_max_elem = tree->max_elem;
 	bps_tree_prepare_new_ext_leaf(leaf_path_elem, &new_path_elem, new_leaf,
 				      new_block_id, &new_max_elem);
+	size_t new_card = 0;
+#ifdef BPS_INNER_CARD
+	new_path_elem.card_copy = &new_card;
+#endif
 	if (has_left_ext && has_right_ext) {
 		/*
 		 * The block has MAX elems and +1 elem is inserted,
@@ -3728,8 +4238,10 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 		struct bps_inner *new_root = bps_tree_create_inner(tree,
 				&new_root_id);
 		new_root->header.size = 2;
-		new_root->child_ids[0] = tree->root_id;
-		new_root->child_ids[1] = new_block_id;
+		new_card = new_leaf->header.size;
+		bps_tree_inner_set_child(new_root, 0, tree->root_id,
+					 tree->size - new_card);
+		bps_tree_inner_set_child(new_root, 1, new_block_id, new_card);
 		new_root->elems[0] = tree->max_elem;
 		tree->root_id = new_root_id;
 		tree->max_elem = new_max_elem;
@@ -3746,7 +4258,7 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 	BPS_TREE_BRANCH_TRACE(tree, insert_leaf, 1 << 0xD);
 	return bps_tree_process_insert_inner(tree, leaf_path_elem->parent,
 			new_block_id, new_path_elem.pos_in_parent,
-			new_max_elem);
+			new_max_elem, new_card);
 }
 
 /**
@@ -3757,18 +4269,19 @@ static inline int
 bps_tree_process_insert_inner(struct bps_tree *tree,
 			      struct bps_inner_path_elem *inner_path_elem,
 			      bps_tree_block_id_t block_id,
-			      bps_tree_pos_t pos, bps_tree_elem_t max_elem)
+			      bps_tree_pos_t pos, bps_tree_elem_t max_elem,
+			      size_t card)
 {
 	if (bps_tree_inner_free_size(inner_path_elem->block)) {
 		bps_tree_insert_into_inner(tree, inner_path_elem,
-					   block_id, pos, max_elem);
+					   block_id, pos, max_elem, card);
 		BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x0);
 		return 0;
 	}
-	struct bps_inner_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0};
+	struct bps_inner_path_elem left_ext = BPS_TREE_PATH_ELEM_ZERO,
+		right_ext = BPS_TREE_PATH_ELEM_ZERO,
+		left_left_ext = BPS_TREE_PATH_ELEM_ZERO,
+		right_right_ext = BPS_TREE_PATH_ELEM_ZERO;
 	bool has_left_ext =
 		bps_tree_collect_left_path_elem_inner(tree, inner_path_elem,
 						      &left_ext);
@@ -3784,7 +4297,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 				bps_tree_inner_free_size(left_ext.block) / 2;
 			bps_tree_insert_and_move_elems_to_left_inner(tree,
 					&left_ext, inner_path_elem, move_count,
-					block_id, pos, max_elem);
+					block_id, pos, max_elem, card);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x1);
 			return 0;
 		} else if (bps_tree_inner_free_size(right_ext.block) > 0) {
@@ -3792,7 +4305,8 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 				bps_tree_inner_free_size(right_ext.block) / 2;
 			bps_tree_insert_and_move_elems_to_right_inner(tree,
 					inner_path_elem, &right_ext,
-					move_count, block_id, pos, max_elem);
+					move_count, block_id, pos, max_elem,
+					card);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x2);
 			return 0;
 		}
@@ -3802,7 +4316,8 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 				bps_tree_inner_free_size(left_ext.block) / 2;
 			bps_tree_insert_and_move_elems_to_left_inner(tree,
 					&left_ext, inner_path_elem,
-					move_count, block_id, pos, max_elem);
+					move_count, block_id, pos, max_elem,
+					card);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x3);
 			return 0;
 		}
@@ -3818,7 +4333,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 			move_count = 1 + move_count / 2;
 			bps_tree_insert_and_move_elems_to_left_inner(tree,
 					&left_ext, inner_path_elem, move_count,
-					block_id, pos, max_elem);
+					block_id, pos, max_elem, card);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x4);
 			return 0;
 		}
@@ -3828,7 +4343,8 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 				bps_tree_inner_free_size(right_ext.block) / 2;
 			bps_tree_insert_and_move_elems_to_right_inner(tree,
 					inner_path_elem, &right_ext,
-					move_count, block_id, pos, max_elem);
+					move_count, block_id, pos, max_elem,
+					card);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x5);
 			return 0;
 		}
@@ -3844,7 +4360,8 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 			move_count = 1 + move_count / 2;
 			bps_tree_insert_and_move_elems_to_right_inner(tree,
 					inner_path_elem, &right_ext,
-					move_count, block_id, pos, max_elem);
+					move_count, block_id, pos, max_elem,
+					card);
 			BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0x6);
 			return 0;
 		}
@@ -3858,6 +4375,10 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 	bps_tree_elem_t new_max_elem = tree->max_elem;
 	bps_tree_prepare_new_ext_inner(inner_path_elem, &new_path_elem,
 				       new_inner, new_block_id, &new_max_elem);
+	size_t new_card = 0;
+#ifdef BPS_INNER_CARD
+	new_path_elem.card_copy = &new_card;
+#endif
 	if (has_left_ext && has_right_ext) {
 		/*
 		 * The block has MAX elems and +1 elem is inserted,
@@ -3884,7 +4405,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 		bps_tree_move_elems_to_right_inner(tree,
 				&left_ext, inner_path_elem, mc2);
 		bps_tree_move_elems_to_left_inner(tree,
@@ -3919,7 +4440,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 		bps_tree_move_elems_to_right_inner(tree,
 				&left_ext, inner_path_elem, mc2);
 		bps_tree_move_elems_to_right_inner(tree,
@@ -3953,7 +4474,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 		bps_tree_move_elems_to_left_inner(tree,
 				&new_path_elem, &right_ext, mc2);
 		bps_tree_move_elems_to_left_inner(tree,
@@ -3985,7 +4506,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 		bps_tree_move_elems_to_right_inner(tree,
 				&left_ext, inner_path_elem, mc2);
 
@@ -4014,7 +4535,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 		bps_tree_move_elems_to_left_inner(tree,
 				&new_path_elem, &right_ext, mc2);
 
@@ -4042,14 +4563,18 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 
 		bps_tree_insert_and_move_elems_to_right_inner(tree,
 				inner_path_elem, &new_path_elem,
-				mc1, block_id, pos, max_elem);
+				mc1, block_id, pos, max_elem, card);
 
 		bps_tree_block_id_t new_root_id = (bps_tree_block_id_t)(-1);
 		struct bps_inner *new_root =
 			bps_tree_create_inner(tree, &new_root_id);
 		new_root->header.size = 2;
-		new_root->child_ids[0] = tree->root_id;
-		new_root->child_ids[1] = new_block_id;
+#ifdef BPS_INNER_CARD
+		new_card = bps_tree_inner_card(new_inner);
+#endif
+		bps_tree_inner_set_child(new_root, 0, tree->root_id,
+					 tree->size - new_card);
+		bps_tree_inner_set_child(new_root, 1, new_block_id, new_card);
 		new_root->elems[0] = tree->max_elem;
 		tree->root_id = new_root_id;
 		tree->max_elem = new_max_elem;
@@ -4061,7 +4586,7 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 	BPS_TREE_BRANCH_TRACE(tree, insert_inner, 1 << 0xD);
 	return bps_tree_process_insert_inner(tree, inner_path_elem->parent,
 			new_block_id, new_path_elem.pos_in_parent,
-			new_max_elem);
+			new_max_elem, new_card);
 }
 
 /**
@@ -4089,10 +4614,10 @@ bps_tree_process_delete_leaf(struct bps_tree *tree,
 
 	bps_tree_touch_path(tree, leaf_path_elem);
 
-	struct bps_leaf_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0};
+	struct bps_leaf_path_elem left_ext = BPS_TREE_PATH_ELEM_ZERO,
+		right_ext = BPS_TREE_PATH_ELEM_ZERO,
+		left_left_ext = BPS_TREE_PATH_ELEM_ZERO,
+		right_right_ext = BPS_TREE_PATH_ELEM_ZERO;
 	bool has_left_ext =
 		bps_tree_collect_left_path_elem_leaf(tree, leaf_path_elem,
 						     &left_ext);
@@ -4275,10 +4800,10 @@ bps_tree_process_delete_inner(struct bps_tree *tree,
 		return;
 	}
 
-	struct bps_inner_path_elem left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		left_left_ext = {0, 0, 0, 0, 0, 0, 0, 0},
-		right_right_ext = {0, 0, 0, 0, 0, 0, 0, 0};
+	struct bps_inner_path_elem left_ext = BPS_TREE_PATH_ELEM_ZERO,
+		right_ext = BPS_TREE_PATH_ELEM_ZERO,
+		left_left_ext = BPS_TREE_PATH_ELEM_ZERO,
+		right_right_ext = BPS_TREE_PATH_ELEM_ZERO;
 	bool has_left_ext =
 		bps_tree_collect_left_path_elem_inner(tree, inner_path_elem,
 						      &left_ext);
@@ -4476,9 +5001,13 @@ bps_tree_insert(struct bps_tree *tree, bps_tree_elem_t new_elem,
 			bps_tree_pos_t pos = leaf_path_elem.insertion_point;
 			*successor = leaf->elems[pos];
 		}
-		return bps_tree_process_insert_leaf(tree, &leaf_path_elem,
-						    new_elem, &unused1,
-						    &unused2);
+		bps_tree_path_add_card(tree, &leaf_path_elem, 1);
+		int rc = bps_tree_process_insert_leaf(tree, &leaf_path_elem,
+						      new_elem, &unused1,
+						      &unused2);
+		if (rc != 0)
+			bps_tree_path_add_card(tree, &leaf_path_elem, -1);
+		return rc;
 	}
 }
 
@@ -4511,10 +5040,13 @@ bps_tree_insert_get_iterator(struct bps_tree *tree, bps_tree_elem_t new_elem,
 					 replaced);
 		return 0;
 	} else {
+		bps_tree_path_add_card(tree, &leaf_path_elem, 1);
 		int rc = bps_tree_process_insert_leaf(tree, &leaf_path_elem,
 						      new_elem,
 						      &inserted_iterator->block_id,
 						      &inserted_iterator->pos);
+		if (rc != 0)
+			bps_tree_path_add_card(tree, &leaf_path_elem, -1);
 		matras_head_read_view(&inserted_iterator->view);
 		return rc;
 	}
@@ -4539,6 +5071,7 @@ bps_tree_delete(struct bps_tree *tree, bps_tree_elem_t elem)
 	if (!exact)
 		return -1;
 
+	bps_tree_path_add_card(tree, &leaf_path_elem, -1);
 	bps_tree_process_delete_leaf(tree, &leaf_path_elem);
 	return 0;
 }
@@ -4572,6 +5105,7 @@ bps_tree_delete_value(struct bps_tree *tree, bps_tree_elem_t elem,
 		return -1;
 	if (deleted_elem != NULL)
 		*deleted_elem = leaf->elems[leaf_path_elem.insertion_point];
+	bps_tree_path_add_card(tree, &leaf_path_elem, -1);
 	bps_tree_process_delete_leaf(tree, &leaf_path_elem);
 	return 0;
 }
@@ -4687,13 +5221,21 @@ bps_tree_debug_check_block(const struct bps_tree *tree, struct bps_block *block,
 				result |= 0x4000000;
 		}
 
-		for (bps_tree_pos_t i = 0; i < block->size; i++)
+		for (bps_tree_pos_t i = 0; i < block->size; i++) {
+			size_t count_before = *calc_count;
 			result |= bps_tree_debug_check_block(tree,
 				bps_tree_restore_block(tree,
 						       inner->child_ids[i]),
 				inner->child_ids[i], level - 1, calc_count,
 				expected_prev_id, expected_this_id,
 				check_fullness_next);
+#ifdef BPS_INNER_CARD
+			if (inner->child_cards[i] != *calc_count - count_before)
+				result |= 0x8000000;
+#else
+			(void)count_before;
+#endif
+		}
 		return result;
 	}
 }
@@ -4938,6 +5480,7 @@ bps_tree_debug_check_insert_into_leaf(struct bps_tree *tree, bool assertme)
 			path_elem.max_elem_copy = &max;
 			path_elem.max_elem_block_id = -1;
 			path_elem.max_elem_pos = -1;
+			path_elem.parent = NULL;
 
 			bps_tree_insert_into_leaf(tree, &path_elem, ins);
 
@@ -4993,6 +5536,7 @@ bps_tree_debug_check_delete_from_leaf(struct bps_tree *tree, bool assertme)
 			path_elem.max_elem_copy = &max;
 			path_elem.max_elem_block_id = -1;
 			path_elem.max_elem_pos = -1;
+			path_elem.parent = NULL;
 
 			bps_tree_delete_from_leaf(tree, &path_elem);
 
@@ -5065,10 +5609,12 @@ bps_tree_debug_check_move_to_right_leaf(struct bps_tree *tree, bool assertme)
 				a_path_elem.max_elem_copy = &ma;
 				a_path_elem.max_elem_block_id = -1;
 				a_path_elem.max_elem_pos = -1;
+				a_path_elem.parent = NULL;
 				b_path_elem.block = &b;
 				b_path_elem.max_elem_copy = &mb;
 				b_path_elem.max_elem_block_id = -1;
 				b_path_elem.max_elem_pos = -1;
+				b_path_elem.parent = NULL;
 				a_path_elem.block_id = 0;
 				b_path_elem.block_id = 0;
 
@@ -5168,10 +5714,12 @@ bps_tree_debug_check_move_to_left_leaf(struct bps_tree *tree, bool assertme)
 				a_path_elem.max_elem_copy = &ma;
 				a_path_elem.max_elem_block_id = -1;
 				a_path_elem.max_elem_pos = -1;
+				a_path_elem.parent = NULL;
 				b_path_elem.block = &b;
 				b_path_elem.max_elem_copy = &mb;
 				b_path_elem.max_elem_block_id = -1;
 				b_path_elem.max_elem_pos = -1;
+				b_path_elem.parent = NULL;
 				a_path_elem.block_id = 0;
 				b_path_elem.block_id = 0;
 
@@ -5279,10 +5827,12 @@ bps_tree_debug_check_insert_and_move_to_right_leaf(struct bps_tree *tree,
 					a_path_elem.max_elem_copy = &ma;
 					a_path_elem.max_elem_block_id = -1;
 					a_path_elem.max_elem_pos = -1;
+					a_path_elem.parent = NULL;
 					b_path_elem.block = &b;
 					b_path_elem.max_elem_copy = &mb;
 					b_path_elem.max_elem_block_id = -1;
 					b_path_elem.max_elem_pos = -1;
+					b_path_elem.parent = NULL;
 					a_path_elem.insertion_point = k;
 					a_path_elem.block_id = 0;
 					b_path_elem.block_id = 0;
@@ -5396,10 +5946,12 @@ bps_tree_debug_check_insert_and_move_to_left_leaf(struct bps_tree *tree,
 					a_path_elem.max_elem_copy = &ma;
 					a_path_elem.max_elem_block_id = -1;
 					a_path_elem.max_elem_pos = -1;
+					a_path_elem.parent = NULL;
 					b_path_elem.block = &b;
 					b_path_elem.max_elem_copy = &mb;
 					b_path_elem.max_elem_block_id = -1;
 					b_path_elem.max_elem_pos = -1;
+					b_path_elem.parent = NULL;
 					b_path_elem.insertion_point = k;
 					a_path_elem.block_id = 0;
 					b_path_elem.block_id = 0;
@@ -5494,6 +6046,7 @@ bps_tree_debug_check_insert_into_inner(struct bps_tree *tree, bool assertme)
 			path_elem.max_elem_copy = &max;
 			path_elem.max_elem_block_id = -1;
 			path_elem.max_elem_pos = -1;
+			path_elem.parent = NULL;
 
 			for (unsigned int k = 0; k < i; k++) {
 				if (k < j)
@@ -5513,7 +6066,7 @@ bps_tree_debug_check_insert_into_inner(struct bps_tree *tree, bool assertme)
 
 			bps_tree_insert_into_inner(tree, &path_elem,
 				(bps_tree_block_id_t) j, (bps_tree_pos_t) j,
-				ins);
+				ins, 0);
 
 			for (unsigned int k = 0; k <= i; k++) {
 				if (bps_tree_debug_get_elem_inner(&path_elem, k)
@@ -5562,6 +6115,7 @@ bps_tree_debug_check_delete_from_inner(struct bps_tree *tree, bool assertme)
 			path_elem.max_elem_copy = &max;
 			path_elem.max_elem_block_id = -1;
 			path_elem.max_elem_pos = -1;
+			path_elem.parent = NULL;
 
 			bps_tree_delete_from_inner(tree, &path_elem);
 
@@ -5622,10 +6176,12 @@ bps_tree_debug_check_move_to_right_inner(struct bps_tree *tree, bool assertme)
 				a_path_elem.max_elem_copy = &ma;
 				a_path_elem.max_elem_block_id = -1;
 				a_path_elem.max_elem_pos = -1;
+				a_path_elem.parent = NULL;
 				b_path_elem.block = &b;
 				b_path_elem.max_elem_copy = &mb;
 				b_path_elem.max_elem_block_id = -1;
 				b_path_elem.max_elem_pos = -1;
+				b_path_elem.parent = NULL;
 				a_path_elem.block_id = 0;
 				b_path_elem.block_id = 0;
 
@@ -5722,10 +6278,12 @@ bps_tree_debug_check_move_to_left_inner(struct bps_tree *tree, bool assertme)
 				a_path_elem.max_elem_copy = &ma;
 				a_path_elem.max_elem_block_id = -1;
 				a_path_elem.max_elem_pos = -1;
+				a_path_elem.parent = NULL;
 				b_path_elem.block = &b;
 				b_path_elem.max_elem_copy = &mb;
 				b_path_elem.max_elem_block_id = -1;
 				b_path_elem.max_elem_pos = -1;
+				b_path_elem.parent = NULL;
 				a_path_elem.block_id = 0;
 				b_path_elem.block_id = 0;
 
@@ -5828,10 +6386,12 @@ bps_tree_debug_check_insert_and_move_to_right_inner(struct bps_tree *tree,
 					a_path_elem.max_elem_copy = &ma;
 					a_path_elem.max_elem_block_id = -1;
 					a_path_elem.max_elem_pos = -1;
+					a_path_elem.parent = NULL;
 					b_path_elem.block = &b;
 					b_path_elem.max_elem_copy = &mb;
 					b_path_elem.max_elem_block_id = -1;
 					b_path_elem.max_elem_pos = -1;
+					b_path_elem.parent = NULL;
 					a_path_elem.block_id = 0;
 					b_path_elem.block_id = 0;
 
@@ -5868,7 +6428,7 @@ bps_tree_debug_check_insert_and_move_to_right_inner(struct bps_tree *tree,
 						tree, &a_path_elem,
 						&b_path_elem,
 						(bps_tree_pos_t) u, ikk,
-						(bps_tree_pos_t) k, ins);
+						(bps_tree_pos_t) k, ins, 0);
 
 					if (a.header.size
 						!= (bps_tree_pos_t) (i - u + 1)) {
@@ -5960,10 +6520,12 @@ bps_tree_debug_check_insert_and_move_to_left_inner(struct bps_tree *tree,
 					a_path_elem.max_elem_copy = &ma;
 					a_path_elem.max_elem_block_id = -1;
 					a_path_elem.max_elem_pos = -1;
+					a_path_elem.parent = NULL;
 					b_path_elem.block = &b;
 					b_path_elem.max_elem_copy = &mb;
 					b_path_elem.max_elem_block_id = -1;
 					b_path_elem.max_elem_pos = -1;
+					b_path_elem.parent = NULL;
 					a_path_elem.block_id = 0;
 					b_path_elem.block_id = 0;
 
@@ -5995,7 +6557,7 @@ bps_tree_debug_check_insert_and_move_to_left_inner(struct bps_tree *tree,
 						tree, &a_path_elem,
 						&b_path_elem,
 						(bps_tree_pos_t) u, ikk,
-						(bps_tree_pos_t) k, ins);
+						(bps_tree_pos_t) k, ins, 0);
 
 					if (a.header.size
 						!= (bps_tree_pos_t) (i + u)) {
@@ -6085,6 +6647,7 @@ bps_tree_debug_check_internal_functions(bool assertme)
 
 #undef BPS_TREE_MEMMOVE
 #undef BPS_TREE_DATAMOVE
+#undef BPS_TREE_PATH_ELEM_ZERO
 #undef BPS_TREE_BRANCH_TRACE
 
 /* {{{ Macros for custom naming of structs and functions */
@@ -6124,6 +6687,9 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_lower_bound_elem
 #undef bps_tree_upper_bound_elem
 #undef bps_tree_approximate_count
+#undef bps_tree_iterator_at
+#undef bps_tree_lower_bound_get_offset
+#undef bps_tree_upper_bound_get_offset
 #undef bps_tree_iterator_get_elem
 #undef bps_tree_iterator_next
 #undef bps_tree_iterator_prev
@@ -6160,6 +6726,14 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_reserve_blocks
 #undef bps_tree_insert_first_elem
 #undef bps_tree_collect_path
+#undef bps_tree_inner_card
+#undef bps_tree_build_cards
+#undef bps_tree_inner_set_child
+#undef bps_tree_inner_move_children
+#undef bps_tree_leaf_path_set_card
+#undef bps_tree_inner_path_set_card
+#undef bps_tree_path_add_card
+#undef bps_tree_iterator_get_offset
 #undef bps_tree_touch_leaf_path_max_elem
 #undef bps_tree_touch_path
 #undef bps_tree_process_replace
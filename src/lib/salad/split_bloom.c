@@ -0,0 +1,163 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include "split_bloom.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bit/bit.h"
+#include "trivia/util.h"
+
+/**
+ * Expected false positive rate of a filter with the given number
+ * of values per block and words per block. The number of values
+ * that land in a block follows the Poisson distribution, and each
+ * of them sets one of 32 bits in every word of the block.
+ */
+static double
+split_bloom_fpr_impl(double values_per_block, uint32_t block_words)
+{
+	double lambda = values_per_block;
+	if (lambda == 0)
+		return 0;
+	double spread = 12 * sqrt(lambda) + 12;
+	double begin = floor(MAX(lambda - spread, 0.0));
+	double end = ceil(lambda + spread);
+	double fpr = 0;
+	for (double i = begin; i <= end; i++) {
+		double p = exp(-lambda + i * log(lambda) - lgamma(i + 1));
+		double word_fpr = 1 - pow(1 - 1.0 / SPLIT_BLOOM_WORD_BITS, i);
+		fpr += p * pow(word_fpr, block_words);
+	}
+	return MIN(fpr, 1.0);
+}
+
+/**
+ * Find the minimal number of blocks of the given size necessary
+ * to store the given number of values with the given false positive
+ * rate.
+ */
+static uint32_t
+split_bloom_block_count(uint32_t number_of_values, double false_positive_rate,
+			uint32_t block_words)
+{
+	uint32_t block_bits = block_words * SPLIT_BLOOM_WORD_BITS;
+	/* Start from the size of the optimal classic bloom filter. */
+	double bit_count = number_of_values * -log2(false_positive_rate) /
+			   log(2);
+	uint64_t hi = MAX((uint64_t)ceil(bit_count / block_bits), 1ULL);
+	while (hi < UINT32_MAX &&
+	       split_bloom_fpr_impl((double)number_of_values / hi,
+				    block_words) > false_positive_rate)
+		hi = MIN(hi * 2, (uint64_t)UINT32_MAX);
+	uint64_t lo = 1;
+	while (lo < hi) {
+		uint64_t mid = (lo + hi) / 2;
+		if (split_bloom_fpr_impl((double)number_of_values / mid,
+					 block_words) > false_positive_rate)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return hi;
+}
+
+int
+split_bloom_create(struct split_bloom *bloom, uint32_t number_of_values,
+		   double false_positive_rate)
+{
+	/*
+	 * The table is allocated in cache lines anyway, so round
+	 * it up to the cache line size, and choose the block size
+	 * that gives the smallest table or, if there are several
+	 * such, the lowest false positive rate.
+	 */
+	uint64_t best_size = UINT64_MAX;
+	double best_fpr = 1;
+	for (uint32_t words = 1; words <= SPLIT_BLOOM_BLOCK_WORDS_MAX;
+	     words *= 2) {
+		uint32_t line_blocks = BLOOM_CACHE_LINE /
+				       (words * sizeof(*bloom->table));
+		uint64_t count = split_bloom_block_count(
+			number_of_values, false_positive_rate, words);
+		count = MIN((count + line_blocks - 1) / line_blocks *
+			    line_blocks, (uint64_t)UINT32_MAX / words);
+		uint64_t size = count * words;
+		double fpr = split_bloom_fpr_impl(
+			(double)number_of_values / count, words);
+		if (size < best_size || (size == best_size && fpr < best_fpr)) {
+			best_size = size;
+			best_fpr = fpr;
+			bloom->block_count = count;
+			bloom->block_words = words;
+		}
+	}
+	size_t size = split_bloom_store_size(bloom);
+	if (posix_memalign((void **)&bloom->table, BLOOM_CACHE_LINE,
+			   size) != 0)
+		return -1;
+	memset(bloom->table, 0, size);
+	return 0;
+}
+
+void
+split_bloom_destroy(struct split_bloom *bloom)
+{
+	free(bloom->table);
+}
+
+double
+split_bloom_fpr(const struct split_bloom *bloom, uint32_t number_of_values)
+{
+	return split_bloom_fpr_impl((double)number_of_values /
+				    bloom->block_count, bloom->block_words);
+}
+
+size_t
+split_bloom_store_size(const struct split_bloom *bloom)
+{
+	return (size_t)bloom->block_count * bloom->block_words *
+	       sizeof(*bloom->table);
+}
+
+char *
+split_bloom_store(const struct split_bloom *bloom, char *table)
+{
+	size_t word_count = (size_t)bloom->block_count * bloom->block_words;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	memcpy(table, bloom->table, word_count * sizeof(*bloom->table));
+	table += word_count * sizeof(*bloom->table);
+#else
+	for (size_t i = 0; i < word_count; i++) {
+		uint32_t word = bswap_u32(bloom->table[i]);
+		memcpy(table, &word, sizeof(word));
+		table += sizeof(word);
+	}
+#endif
+	return table;
+}
+
+int
+split_bloom_load_table(struct split_bloom *bloom, const char *table)
+{
+	assert(bloom->block_count > 0);
+	assert(bloom->block_words > 0 &&
+	       bloom->block_words <= SPLIT_BLOOM_BLOCK_WORDS_MAX &&
+	       (bloom->block_words & (bloom->block_words - 1)) == 0);
+	size_t size = split_bloom_store_size(bloom);
+	if (posix_memalign((void **)&bloom->table, BLOOM_CACHE_LINE,
+			   size) != 0)
+		return -1;
+	memcpy(bloom->table, table, size);
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+	size_t word_count = size / sizeof(*bloom->table);
+	for (size_t i = 0; i < word_count; i++)
+		bloom->table[i] = bswap_u32(bloom->table[i]);
+#endif
+	return 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#pragma once
+
+/*
+ * Split block bloom filter.
+ *
+ * The table is an array of small blocks, each consisting of
+ * block_words 32-bit words. A value is mapped to a single block
+ * and sets exactly one bit in each word of the block, so a lookup
+ * reads one block, which never crosses a cache line, and checks
+ * all the bits at once without data dependent branches.
+ *
+ * Compared to the classic bloom filter (see bloom.h), a split
+ * block filter needs slightly more bits for the same false
+ * positive rate, but a lookup doesn't depend on the number of
+ * hash functions.
+ *
+ *  Putze, F.; Sanders, P.; Singler, J. (2007),
+ *  "Cache-, Hash- and Space-Efficient Bloom Filters"
+ *  http://algo2.iti.kit.edu/singler/publications/cacheefficientbloomfilters-wea2007.pdf
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "salad/bloom.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+enum {
+	/** Max number of words in a block. */
+	SPLIT_BLOOM_BLOCK_WORDS_MAX = 8,
+	/** Number of bits in a block word. */
+	SPLIT_BLOOM_WORD_BITS = 32,
+};
+
+/**
+ * Split block bloom filter data structure.
+ */
+struct split_bloom {
+	/** Number of blocks in the table. */
+	uint32_t block_count;
+	/**
+	 * Number of words in a block, which is also the number of
+	 * bits set per value. A power of two not greater than
+	 * SPLIT_BLOOM_BLOCK_WORDS_MAX.
+	 */
+	uint16_t block_words;
+	/** Bit table, aligned by the cache line size. */
+	uint32_t *table;
+};
+
+/* {{{ API declaration */
+
+/**
+ * Allocate and initialize an instance of split block bloom filter.
+ * The block size is chosen so as to minimize the table size.
+ *
+ * @param bloom - structure to initialize
+ * @param number_of_values - estimated number of values to be added
+ * @param false_positive_rate - desired false positive rate
+ * @return 0 - OK, -1 - memory error
+ */
+int
+split_bloom_create(struct split_bloom *bloom, uint32_t number_of_values,
+		   double false_positive_rate);
+
+/**
+ * Free resources of the bloom filter.
+ *
+ * @param bloom - the bloom filter
+ */
+void
+split_bloom_destroy(struct split_bloom *bloom);
+
+/**
+ * Add a value into the data set.
+ * @param bloom - the bloom filter
+ * @param hash - hash of the value
+ */
+static void
+split_bloom_add(struct split_bloom *bloom, bloom_hash_t hash);
+
+/**
+ * Query for presence of a value in the data set.
+ * @param bloom - the bloom filter
+ * @param hash - hash of the value
+ * @return true - the value could be in data set; false - the value is
+ *  definitively not in data set
+ */
+static bool
+split_bloom_maybe_has(const struct split_bloom *bloom, bloom_hash_t hash);
+
+/**
+ * Return the expected false positive rate of a bloom filter.
+ * @param bloom - the bloom filter
+ * @param number_of_values - number of values stored in the filter
+ * @return - expected false positive rate
+ */
+double
+split_bloom_fpr(const struct split_bloom *bloom, uint32_t number_of_values);
+
+/**
+ * Calculate size of a buffer that is needed for storing bloom table.
+ * @param bloom - the bloom filter to store
+ * @return - Exact size
+ */
+size_t
+split_bloom_store_size(const struct split_bloom *bloom);
+
+/**
+ * Store bloom filter table to the given buffer. Words are stored
+ * in the little-endian byte order.
+ * Other struct split_bloom members must be stored manually.
+ * @param bloom - the bloom filter to store
+ * @param table - buffer to store to
+ * @return - end of written buffer
+ */
+char *
+split_bloom_store(const struct split_bloom *bloom, char *table);
+
+/**
+ * Allocate table and load it from given buffer.
+ * Other struct split_bloom members must be loaded manually.
+ *
+ * @param bloom - structure to load to
+ * @param table - data to load
+ * @return 0 - OK, -1 - memory error
+ */
+int
+split_bloom_load_table(struct split_bloom *bloom, const char *table);
+
+/* }}} API declaration */
+
+/* {{{ API definition */
+
+/**
+ * Odd multipliers used to derive independent bit numbers from
+ * a hash, one per block word.
+ */
+static const uint32_t split_bloom_salt[SPLIT_BLOOM_BLOCK_WORDS_MAX] = {
+	0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+	0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+/** Return the block a hash is mapped to. */
+static inline uint32_t *
+split_bloom_block(const struct split_bloom *bloom, bloom_hash_t hash)
+{
+	/* Map the hash to [0, block_count) without division. */
+	uint32_t block_no = ((uint64_t)hash * bloom->block_count) >> 32;
+	return bloom->table + (size_t)block_no * bloom->block_words;
+}
+
+/** Return the bit that a hash sets in the given block word. */
+static inline uint32_t
+split_bloom_word_mask(bloom_hash_t hash, uint32_t word_no)
+{
+	return 1U << ((hash * split_bloom_salt[word_no]) >> 27);
+}
+
+static inline void
+split_bloom_add(struct split_bloom *bloom, bloom_hash_t hash)
+{
+	uint32_t *block = split_bloom_block(bloom, hash);
+	for (uint32_t i = 0; i < bloom->block_words; i++)
+		block[i] |= split_bloom_word_mask(hash, i);
+}
+
+static inline bool
+split_bloom_maybe_has(const struct split_bloom *bloom, bloom_hash_t hash)
+{
+	const uint32_t *block = split_bloom_block(bloom, hash);
+#if defined(__SSE2__)
+	if (bloom->block_words >= 4) {
+		/*
+		 * Test four words per instruction: the value may be
+		 * in the set only if no bit of the mask is missing
+		 * from the block.
+		 */
+		__m128i missing = _mm_setzero_si128();
+		for (uint32_t i = 0; i < bloom->block_words; i += 4) {
+			__m128i mask = _mm_set_epi32(
+				split_bloom_word_mask(hash, i + 3),
+				split_bloom_word_mask(hash, i + 2),
+				split_bloom_word_mask(hash, i + 1),
+				split_bloom_word_mask(hash, i));
+			__m128i bits = _mm_load_si128(
+				(const __m128i *)(block + i));
+			missing = _mm_or_si128(missing,
+					       _mm_andnot_si128(bits, mask));
+		}
+		missing = _mm_cmpeq_epi8(missing, _mm_setzero_si128());
+		return _mm_movemask_epi8(missing) == 0xffff;
+	}
+#endif
+	uint32_t missing = 0;
+	for (uint32_t i = 0; i < bloom->block_words; i++)
+		missing |= split_bloom_word_mask(hash, i) & ~block[i];
+	return missing == 0;
+}
+
+/* }}} API definition */
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
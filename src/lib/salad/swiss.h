@@ -0,0 +1,966 @@
+/*
+ * *No header guard*: the header is allowed to be included twice
+ * with different sets of defines.
+ */
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright 2010-2022, Tarantool AUTHORS, please see AUTHORS file.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "small/matras.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Swiss table: a hash table with the same interface and the same
+ * incremental growth and read view semantics as light.h, but with
+ * a memory layout optimized for lookups.
+ *
+ * Values are stored in groups of SWISS_GROUP_SIZE slots. Every slot
+ * has a control byte, which is either SWISS_CTRL_EMPTY or the 7 high
+ * bits of the value hash, and the full 32-bit hash of the value.
+ * A lookup compares the control bytes of a whole group with one
+ * SIMD instruction and compares values only for slots with matching
+ * hashes, so it rarely has to dereference a value that doesn't match.
+ *
+ * The table is a linear hash of groups (buckets): it grows by one
+ * bucket at a time, splitting exactly one old bucket, so there's no
+ * latency spike on rehash. A bucket that doesn't fit into one group
+ * is continued with a chain of overflow groups. Slots are filled in
+ * order and deletion moves the last value of a chain to the freed
+ * slot, so all the groups of a chain except the last one are full
+ * and the occupied slots of the last group form a prefix.
+ *
+ * Buckets and overflow groups are stored in two matras instances,
+ * which makes it possible to freeze an iterator, see
+ * swiss_iterator_freeze().
+ */
+
+/**
+ * Additional user defined name that appended to prefix 'swiss'
+ * for all names of structs and functions in this header file.
+ * All names use pattern: swiss<SWISS_NAME>_<name of func/struct>
+ * May be empty, but still have to be defined (just #define SWISS_NAME)
+ */
+#ifndef SWISS_NAME
+#error "SWISS_NAME must be defined"
+#endif
+
+/**
+ * Data type that hash table holds.
+ */
+#ifndef SWISS_DATA_TYPE
+#error "SWISS_DATA_TYPE must be defined"
+#endif
+
+/**
+ * Data type that used to for finding values.
+ */
+#ifndef SWISS_KEY_TYPE
+#error "SWISS_KEY_TYPE must be defined"
+#endif
+
+/**
+ * Type of optional third parameter of comparing function.
+ * If not needed, simply use #define SWISS_CMP_ARG_TYPE int
+ */
+#ifndef SWISS_CMP_ARG_TYPE
+#error "SWISS_CMP_ARG_TYPE must be defined"
+#endif
+
+/**
+ * Data comparing function. Takes 3 parameters - value1, value2 and
+ * optional value that stored in hash table struct.
+ */
+#ifndef SWISS_EQUAL
+#error "SWISS_EQUAL must be defined"
+#endif
+
+/**
+ * Data comparing function. Takes 3 parameters - value, key and
+ * optional value that stored in hash table struct.
+ */
+#ifndef SWISS_EQUAL_KEY
+#error "SWISS_EQUAL_KEY must be defined"
+#endif
+
+/**
+ * Tools for name substitution:
+ */
+#ifndef CONCAT4
+#define CONCAT4_R(a, b, c, d) a##b##c##d
+#define CONCAT4(a, b, c, d) CONCAT4_R(a, b, c, d)
+#endif
+
+#ifdef _
+#error '_' must be undefinded!
+#endif
+#define SWISS(name) CONCAT4(swiss, SWISS_NAME, _, name)
+
+#ifndef SWISS_COMMON_DEFINED
+#define SWISS_COMMON_DEFINED
+
+enum {
+	/** Number of slots in a group. */
+	SWISS_GROUP_SIZE = 16,
+	/**
+	 * Max average number of values per bucket. When exceeded,
+	 * the table grows by one bucket.
+	 */
+	SWISS_BUCKET_LOAD = 12,
+};
+
+/** Control byte of a free slot. */
+static const uint8_t SWISS_CTRL_EMPTY = 0x80;
+
+/**
+ * The bit that distinguishes IDs of overflow groups from bucket
+ * numbers in swiss_group::next and internal group IDs.
+ */
+static const uint32_t SWISS_OVERFLOW_BIT = 0x80000000;
+
+/** Control byte of a slot storing a value with the given hash. */
+static inline uint8_t
+swiss_ctrl(uint32_t hash)
+{
+	return hash >> 25;
+}
+
+/** Bitmask of slots with the control byte equal to @a c. */
+static inline uint32_t
+swiss_ctrl_match(const uint8_t *ctrl, uint8_t c)
+{
+#if defined(__SSE2__)
+	__m128i v = _mm_loadu_si128((const __m128i *)ctrl);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < SWISS_GROUP_SIZE; i++)
+		mask |= (uint32_t)(ctrl[i] == c) << i;
+	return mask;
+#endif
+}
+
+/** Number of occupied slots in a group. */
+static inline uint32_t
+swiss_ctrl_count(const uint8_t *ctrl)
+{
+#if defined(__SSE2__)
+	__m128i v = _mm_loadu_si128((const __m128i *)ctrl);
+	uint32_t empty = _mm_movemask_epi8(v);
+#else
+	uint32_t empty = 0;
+	for (int i = 0; i < SWISS_GROUP_SIZE; i++)
+		empty |= (uint32_t)(ctrl[i] >> 7) << i;
+#endif
+	return __builtin_ctz(empty | (1U << SWISS_GROUP_SIZE));
+}
+
+#endif /* SWISS_COMMON_DEFINED */
+
+/**
+ * Size of group members, not including padding.
+ */
+#define SWISS_GROUP_DATA_SIZE \
+	((SWISS_GROUP_SIZE * (sizeof(uint32_t) + 1) + sizeof(uint32_t) + \
+	  __alignof__(SWISS_DATA_TYPE) - 1) / __alignof__(SWISS_DATA_TYPE) * \
+	 __alignof__(SWISS_DATA_TYPE) + \
+	 SWISS_GROUP_SIZE * sizeof(SWISS_DATA_TYPE))
+
+/**
+ * A group of slots. Used both for buckets and overflow groups.
+ */
+struct SWISS(group) {
+	/** Control bytes, see swiss_ctrl(). */
+	uint8_t ctrl[SWISS_GROUP_SIZE];
+	/**
+	 * ID of the next overflow group in chain, with the
+	 * SWISS_OVERFLOW_BIT set, or SWISS(end). For a free overflow
+	 * group, the ID of the next free one.
+	 */
+	uint32_t next;
+	/**
+	 * Hashes of the stored values. Go right after control bytes,
+	 * so that a lookup usually touches only one cache line before
+	 * it gets to the value.
+	 */
+	uint32_t hash[SWISS_GROUP_SIZE];
+	/** Stored values. */
+	SWISS_DATA_TYPE value[SWISS_GROUP_SIZE];
+	/** Round group size up to nearest power of two. */
+	uint8_t padding[(1 << (32 - __builtin_clz(SWISS_GROUP_DATA_SIZE - 1))) -
+			SWISS_GROUP_DATA_SIZE];
+};
+
+#undef SWISS_GROUP_DATA_SIZE
+
+/**
+ * Main struct for holding hash table
+ */
+struct SWISS(core) {
+	/** Count of values in hash table. */
+	uint32_t count;
+	/** Number of buckets (equal to buckets.head.block_count). */
+	uint32_t bucket_count;
+	/**
+	 * Smallest power of two not less than bucket_count,
+	 * minus one.
+	 */
+	uint32_t cover_mask;
+	/** ID of the first free overflow group or SWISS(end). */
+	uint32_t free_overflow;
+	/** Additional parameter for data comparison. */
+	SWISS_CMP_ARG_TYPE arg;
+	/** Bucket groups. */
+	struct matras buckets;
+	/** Overflow groups. */
+	struct matras overflow;
+};
+
+/**
+ * Iterator, for iterating all values in hash_table.
+ * It also may be used for restoring one value by key.
+ */
+struct SWISS(iterator) {
+	/** Current bucket. */
+	uint32_t bucket;
+	/**
+	 * Position in the bucket chain: number of the group in
+	 * chain multiplied by SWISS_GROUP_SIZE plus slot number.
+	 */
+	uint32_t pos;
+	/** Version of bucket memory for MVCC. */
+	struct matras_view view;
+	/** Version of overflow group memory for MVCC. */
+	struct matras_view overflow_view;
+};
+
+/**
+ * Type of functions for memory allocation and deallocation
+ */
+typedef void *(*SWISS(extent_alloc_t))(void *ctx);
+typedef void (*SWISS(extent_free_t))(void *ctx, void *extent);
+
+/**
+ * Special value of group IDs and iterator position that means
+ * "nothing".
+ */
+static const uint32_t SWISS(end) = 0xFFFFFFFF;
+
+/**
+ * Location of a value in the hash table.
+ */
+struct SWISS(cursor) {
+	/** Bucket of the chain. */
+	uint32_t bucket;
+	/** Number of the group in chain. */
+	uint32_t depth;
+	/** Internal ID of the group, see SWISS(group_get). */
+	uint32_t group_id;
+	/** The group. */
+	struct SWISS(group) *group;
+	/** Slot in the group. */
+	uint32_t slot;
+};
+
+/**
+ * @brief Hash table construction. Fills struct swiss members.
+ * @param ht - pointer to a hash table struct
+ * @param extent_size - size of allocating memory blocks
+ * @param extent_alloc_func - memory blocks allocation function
+ * @param extent_free_func - memory blocks allocation function
+ * @param alloc_ctx - argument passed to memory block allocator
+ * @param arg - optional parameter to save for comparing function
+ */
+static inline void
+SWISS(create)(struct SWISS(core) *ht, size_t extent_size,
+	      SWISS(extent_alloc_t) extent_alloc_func,
+	      SWISS(extent_free_t) extent_free_func,
+	      void *alloc_ctx, SWISS_CMP_ARG_TYPE arg)
+{
+	assert((sizeof(struct SWISS(group)) &
+		(sizeof(struct SWISS(group)) - 1)) == 0);
+	ht->count = 0;
+	ht->bucket_count = 0;
+	ht->cover_mask = 0;
+	ht->free_overflow = SWISS(end);
+	ht->arg = arg;
+	matras_create(&ht->buckets, extent_size, sizeof(struct SWISS(group)),
+		      extent_alloc_func, extent_free_func, alloc_ctx);
+	matras_create(&ht->overflow, extent_size, sizeof(struct SWISS(group)),
+		      extent_alloc_func, extent_free_func, alloc_ctx);
+}
+
+/**
+ * @brief Hash table destruction. Frees all allocated memory.
+ * @param ht - pointer to a hash table struct
+ */
+static inline void
+SWISS(destroy)(struct SWISS(core) *ht)
+{
+	matras_destroy(&ht->buckets);
+	matras_destroy(&ht->overflow);
+}
+
+/**
+ * Number of memory extents used by the hash table.
+ */
+static inline size_t
+SWISS(extent_count)(const struct SWISS(core) *ht)
+{
+	return matras_extent_count(&ht->buckets) +
+	       matras_extent_count(&ht->overflow);
+}
+
+/**
+ * Find the bucket where a value with the given hash is stored.
+ */
+static inline uint32_t
+SWISS(bucket)(const struct SWISS(core) *ht, uint32_t hash)
+{
+	uint32_t bucket = hash & ht->cover_mask;
+	if (bucket >= ht->bucket_count)
+		bucket &= ht->cover_mask >> 1;
+	return bucket;
+}
+
+/**
+ * Get a group by internal ID: a bucket number or an overflow group
+ * ID with SWISS_OVERFLOW_BIT set.
+ */
+static inline struct SWISS(group) *
+SWISS(group_get)(const struct SWISS(core) *ht, uint32_t id)
+{
+	if ((id & SWISS_OVERFLOW_BIT) != 0)
+		return (struct SWISS(group) *)
+			matras_get(&ht->overflow, id & ~SWISS_OVERFLOW_BIT);
+	return (struct SWISS(group) *)matras_get(&ht->buckets, id);
+}
+
+/**
+ * Same as SWISS(group_get), but prepares the group for
+ * modification. Returns NULL on memory error (only with frozen
+ * iterators).
+ */
+static inline struct SWISS(group) *
+SWISS(group_touch)(struct SWISS(core) *ht, uint32_t id)
+{
+	if ((id & SWISS_OVERFLOW_BIT) != 0)
+		return (struct SWISS(group) *)
+			matras_touch(&ht->overflow, id & ~SWISS_OVERFLOW_BIT);
+	return (struct SWISS(group) *)matras_touch(&ht->buckets, id);
+}
+
+/** Mark slots of a group starting from @a from free. */
+static inline void
+SWISS(group_clear)(struct SWISS(group) *group, uint32_t from)
+{
+	memset(group->ctrl + from, SWISS_CTRL_EMPTY, SWISS_GROUP_SIZE - from);
+}
+
+/** Copy a value from one slot to another. */
+static inline void
+SWISS(slot_move)(struct SWISS(group) *dst, uint32_t dst_slot,
+		 const struct SWISS(group) *src, uint32_t src_slot)
+{
+	dst->value[dst_slot] = src->value[src_slot];
+	dst->hash[dst_slot] = src->hash[src_slot];
+	dst->ctrl[dst_slot] = src->ctrl[src_slot];
+}
+
+/**
+ * Take an empty overflow group from the free list or allocate
+ * a new one. The group is ready for modification.
+ * Returns NULL on memory error.
+ */
+static inline struct SWISS(group) *
+SWISS(overflow_alloc)(struct SWISS(core) *ht, uint32_t *id)
+{
+	struct SWISS(group) *group;
+	if (ht->free_overflow != SWISS(end)) {
+		group = SWISS(group_touch)(ht, ht->free_overflow);
+		if (group == NULL)
+			return NULL;
+		*id = ht->free_overflow;
+		ht->free_overflow = group->next;
+	} else {
+		uint32_t pos;
+		if (matras_alloc(&ht->overflow, &pos) == NULL)
+			return NULL;
+		group = (struct SWISS(group) *)
+			matras_touch(&ht->overflow, pos);
+		if (group == NULL) {
+			matras_dealloc(&ht->overflow);
+			return NULL;
+		}
+		*id = pos | SWISS_OVERFLOW_BIT;
+	}
+	SWISS(group_clear)(group, 0);
+	group->next = SWISS(end);
+	return group;
+}
+
+/**
+ * Put an overflow group to the free list. The group must be
+ * prepared for modification.
+ */
+static inline void
+SWISS(overflow_free)(struct SWISS(core) *ht, uint32_t id,
+		     struct SWISS(group) *group)
+{
+	assert((id & SWISS_OVERFLOW_BIT) != 0);
+	SWISS(group_clear)(group, 0);
+	group->next = ht->free_overflow;
+	ht->free_overflow = id;
+}
+
+/**
+ * Find a value with the given hash and key, see SWISS(find_key).
+ * On success fills @a cursor and returns true.
+ */
+static inline bool
+SWISS(lookup_key)(const struct SWISS(core) *ht, uint32_t hash,
+		  SWISS_KEY_TYPE key, struct SWISS(cursor) *cursor)
+{
+	if (ht->count == 0)
+		return false;
+	uint8_t ctrl = swiss_ctrl(hash);
+	uint32_t id = SWISS(bucket)(ht, hash);
+	cursor->bucket = id;
+	cursor->depth = 0;
+	while (true) {
+		struct SWISS(group) *group = SWISS(group_get)(ht, id);
+		uint32_t match = swiss_ctrl_match(group->ctrl, ctrl);
+		while (match != 0) {
+			uint32_t slot = __builtin_ctz(match);
+			if (group->hash[slot] == hash &&
+			    SWISS_EQUAL_KEY((group->value[slot]), (key),
+					    (ht->arg))) {
+				cursor->group_id = id;
+				cursor->group = group;
+				cursor->slot = slot;
+				return true;
+			}
+			match &= match - 1;
+		}
+		id = group->next;
+		if (id == SWISS(end))
+			return false;
+		cursor->depth++;
+	}
+}
+
+/**
+ * Find a value with the given hash that is equal to @a value,
+ * see SWISS(find). On success fills @a cursor and returns true.
+ */
+static inline bool
+SWISS(lookup)(const struct SWISS(core) *ht, uint32_t hash,
+	      SWISS_DATA_TYPE value, struct SWISS(cursor) *cursor)
+{
+	if (ht->count == 0)
+		return false;
+	uint8_t ctrl = swiss_ctrl(hash);
+	uint32_t id = SWISS(bucket)(ht, hash);
+	cursor->bucket = id;
+	cursor->depth = 0;
+	while (true) {
+		struct SWISS(group) *group = SWISS(group_get)(ht, id);
+		uint32_t match = swiss_ctrl_match(group->ctrl, ctrl);
+		while (match != 0) {
+			uint32_t slot = __builtin_ctz(match);
+			if (group->hash[slot] == hash &&
+			    SWISS_EQUAL((group->value[slot]), (value),
+					(ht->arg))) {
+				cursor->group_id = id;
+				cursor->group = group;
+				cursor->slot = slot;
+				return true;
+			}
+			match &= match - 1;
+		}
+		id = group->next;
+		if (id == SWISS(end))
+			return false;
+		cursor->depth++;
+	}
+}
+
+/**
+ * @brief Find a record with given hash and key
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param key - key to find
+ * @return pointer to the found value or NULL if nothing found.
+ *  The pointer is valid until the next modification of the table.
+ */
+static inline SWISS_DATA_TYPE *
+SWISS(find_key)(const struct SWISS(core) *ht, uint32_t hash,
+		SWISS_KEY_TYPE key)
+{
+	struct SWISS(cursor) cursor;
+	if (!SWISS(lookup_key)(ht, hash, key, &cursor))
+		return NULL;
+	return &cursor.group->value[cursor.slot];
+}
+
+/**
+ * @brief Find a record with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param value - value to find
+ * @return pointer to the found value or NULL if nothing found.
+ *  The pointer is valid until the next modification of the table.
+ */
+static inline SWISS_DATA_TYPE *
+SWISS(find)(const struct SWISS(core) *ht, uint32_t hash,
+	    SWISS_DATA_TYPE value)
+{
+	struct SWISS(cursor) cursor;
+	if (!SWISS(lookup)(ht, hash, value, &cursor))
+		return NULL;
+	return &cursor.group->value[cursor.slot];
+}
+
+/**
+ * @brief Replace a record with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param value - value to find and replace
+ * @param replaced - pointer to a value that was stored in table
+ *  before replace
+ * @return 0 if replaced, 1 if nothing found or -1 on memory error
+ *  (only with frozen iterators)
+ */
+static inline int
+SWISS(replace)(struct SWISS(core) *ht, uint32_t hash,
+	       SWISS_DATA_TYPE value, SWISS_DATA_TYPE *replaced)
+{
+	struct SWISS(cursor) cursor;
+	if (!SWISS(lookup)(ht, hash, value, &cursor))
+		return 1;
+	struct SWISS(group) *group = SWISS(group_touch)(ht, cursor.group_id);
+	if (group == NULL)
+		return -1;
+	*replaced = group->value[cursor.slot];
+	group->value[cursor.slot] = value;
+	return 0;
+}
+
+/**
+ * Prepare the chain of bucket @a split_id for splitting: prepare all
+ * its groups for modification and reserve overflow groups for the
+ * values that move to the new bucket, linking them to @a new_group.
+ * Returns 0 on success, -1 on memory error.
+ */
+static inline int
+SWISS(split_prepare)(struct SWISS(core) *ht, uint32_t split_id,
+		     uint32_t new_id, uint32_t cover_mask,
+		     struct SWISS(group) *new_group)
+{
+	uint32_t move_count = 0;
+	for (uint32_t id = split_id; id != SWISS(end); ) {
+		struct SWISS(group) *group = SWISS(group_touch)(ht, id);
+		if (group == NULL)
+			return -1;
+		uint32_t count = swiss_ctrl_count(group->ctrl);
+		for (uint32_t slot = 0; slot < count; slot++) {
+			if ((group->hash[slot] & cover_mask) == new_id)
+				move_count++;
+		}
+		id = group->next;
+	}
+	struct SWISS(group) *tail = new_group;
+	for (uint32_t n = SWISS_GROUP_SIZE; n < move_count;
+	     n += SWISS_GROUP_SIZE) {
+		uint32_t id;
+		struct SWISS(group) *group = SWISS(overflow_alloc)(ht, &id);
+		if (group == NULL) {
+			id = new_group->next;
+			while (id != SWISS(end)) {
+				group = SWISS(group_get)(ht, id);
+				uint32_t next = group->next;
+				SWISS(overflow_free)(ht, id, group);
+				id = next;
+			}
+			new_group->next = SWISS(end);
+			return -1;
+		}
+		tail->next = id;
+		tail = group;
+	}
+	return 0;
+}
+
+/**
+ * Move the values of the chain of bucket @a split_id that belong to
+ * bucket @a new_id to @a new_group and its overflow groups, which
+ * must be prepared with SWISS(split_prepare). The values that stay
+ * are packed to the beginning of the chain and the rest of the chain
+ * is freed.
+ */
+static inline void
+SWISS(split)(struct SWISS(core) *ht, uint32_t split_id, uint32_t new_id,
+	     uint32_t cover_mask, struct SWISS(group) *new_group)
+{
+	struct SWISS(group) *dst = new_group;
+	uint32_t dst_slot = 0;
+	struct SWISS(group) *keep = SWISS(group_get)(ht, split_id);
+	uint32_t keep_slot = 0;
+	struct SWISS(group) *group = keep;
+	while (true) {
+		uint32_t count = swiss_ctrl_count(group->ctrl);
+		for (uint32_t slot = 0; slot < count; slot++) {
+			if ((group->hash[slot] & cover_mask) == new_id) {
+				if (dst_slot == SWISS_GROUP_SIZE) {
+					dst = SWISS(group_get)(ht, dst->next);
+					dst_slot = 0;
+				}
+				SWISS(slot_move)(dst, dst_slot++, group, slot);
+			} else {
+				if (keep_slot == SWISS_GROUP_SIZE) {
+					keep = SWISS(group_get)(ht, keep->next);
+					keep_slot = 0;
+				}
+				SWISS(slot_move)(keep, keep_slot++, group, slot);
+			}
+		}
+		if (group->next == SWISS(end))
+			break;
+		group = SWISS(group_get)(ht, group->next);
+	}
+	assert(dst->next == SWISS(end));
+	SWISS(group_clear)(keep, keep_slot);
+	uint32_t id = keep->next;
+	keep->next = SWISS(end);
+	while (id != SWISS(end)) {
+		group = SWISS(group_get)(ht, id);
+		uint32_t next = group->next;
+		SWISS(overflow_free)(ht, id, group);
+		id = next;
+	}
+}
+
+/**
+ * Add one bucket to the hash table, splitting one of the existing
+ * buckets. Returns 0 on success, -1 on memory error. On failure
+ * the table is left unchanged.
+ */
+static inline int
+SWISS(grow)(struct SWISS(core) *ht)
+{
+	uint32_t new_id;
+	if (matras_alloc(&ht->buckets, &new_id) == NULL)
+		return -1;
+	struct SWISS(group) *new_group = (struct SWISS(group) *)
+		matras_touch(&ht->buckets, new_id);
+	if (new_group == NULL) {
+		matras_dealloc(&ht->buckets);
+		return -1;
+	}
+	SWISS(group_clear)(new_group, 0);
+	new_group->next = SWISS(end);
+	assert(new_id == ht->bucket_count);
+	uint32_t cover_mask = ht->cover_mask;
+	if (new_id > cover_mask)
+		cover_mask = (cover_mask << 1) | 1;
+	if (new_id > 0) {
+		uint32_t split_id = new_id & (cover_mask >> 1);
+		if (SWISS(split_prepare)(ht, split_id, new_id, cover_mask,
+					 new_group) != 0) {
+			matras_dealloc(&ht->buckets);
+			return -1;
+		}
+		SWISS(split)(ht, split_id, new_id, cover_mask, new_group);
+	}
+	ht->bucket_count++;
+	ht->cover_mask = cover_mask;
+	return 0;
+}
+
+/**
+ * @brief Insert a record with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to insert
+ * @param value - value to insert
+ * @return 0 on success, -1 on memory error
+ */
+static inline int
+SWISS(insert)(struct SWISS(core) *ht, uint32_t hash, SWISS_DATA_TYPE value)
+{
+	if (ht->count >= (uint64_t)ht->bucket_count * SWISS_BUCKET_LOAD) {
+		if (SWISS(grow)(ht) != 0)
+			return -1;
+	}
+	uint32_t id = SWISS(bucket)(ht, hash);
+	struct SWISS(group) *group = SWISS(group_get)(ht, id);
+	while (group->next != SWISS(end)) {
+		id = group->next;
+		group = SWISS(group_get)(ht, id);
+	}
+	group = SWISS(group_touch)(ht, id);
+	if (group == NULL)
+		return -1;
+	uint32_t slot = swiss_ctrl_count(group->ctrl);
+	if (slot == SWISS_GROUP_SIZE) {
+		struct SWISS(group) *tail = SWISS(overflow_alloc)(ht, &id);
+		if (tail == NULL)
+			return -1;
+		group->next = id;
+		group = tail;
+		slot = 0;
+	}
+	group->value[slot] = value;
+	group->hash[slot] = hash;
+	group->ctrl[slot] = swiss_ctrl(hash);
+	ht->count++;
+	return 0;
+}
+
+/**
+ * Delete the value pointed by @a cursor. Returns 0 on success,
+ * -1 on memory error (only with frozen iterators).
+ */
+static inline int
+SWISS(delete_at)(struct SWISS(core) *ht, const struct SWISS(cursor) *cursor)
+{
+	/* Find the last group of the chain and its predecessor. */
+	uint32_t prev_id = SWISS(end);
+	uint32_t tail_id = cursor->bucket;
+	struct SWISS(group) *tail = SWISS(group_get)(ht, tail_id);
+	while (tail->next != SWISS(end)) {
+		prev_id = tail_id;
+		tail_id = tail->next;
+		tail = SWISS(group_get)(ht, tail_id);
+	}
+	uint32_t tail_slot = swiss_ctrl_count(tail->ctrl) - 1;
+	/* The last group becomes empty, unlink it. */
+	struct SWISS(group) *prev = NULL;
+	if (tail_slot == 0 && prev_id != SWISS(end)) {
+		prev = SWISS(group_touch)(ht, prev_id);
+		if (prev == NULL)
+			return -1;
+	}
+	struct SWISS(group) *group = SWISS(group_touch)(ht, cursor->group_id);
+	if (group == NULL)
+		return -1;
+	tail = SWISS(group_touch)(ht, tail_id);
+	if (tail == NULL)
+		return -1;
+	if (tail != group || tail_slot != cursor->slot)
+		SWISS(slot_move)(group, cursor->slot, tail, tail_slot);
+	tail->ctrl[tail_slot] = SWISS_CTRL_EMPTY;
+	if (prev != NULL) {
+		prev->next = SWISS(end);
+		SWISS(overflow_free)(ht, tail_id, tail);
+	}
+	ht->count--;
+	return 0;
+}
+
+/**
+ * @brief Delete a record from a hash table by that value and its hash.
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash of the value
+ * @param value - value to delete
+ * @return 0 if ok, 1 if not found or -1 on memory error
+ *  (only with frozen iterators)
+ */
+static inline int
+SWISS(delete_value)(struct SWISS(core) *ht, uint32_t hash,
+		    SWISS_DATA_TYPE value)
+{
+	struct SWISS(cursor) cursor;
+	if (!SWISS(lookup)(ht, hash, value, &cursor))
+		return 1;
+	return SWISS(delete_at)(ht, &cursor);
+}
+
+/**
+ * @brief Get a pseudo-random value from the hash table.
+ * @param ht - pointer to a hash table struct
+ * @param rnd - a random number
+ * @return pointer to a value or NULL if the table is empty
+ */
+static inline SWISS_DATA_TYPE *
+SWISS(random)(const struct SWISS(core) *ht, uint32_t rnd)
+{
+	if (ht->count == 0)
+		return NULL;
+	uint32_t bucket = rnd % ht->bucket_count;
+	while (true) {
+		struct SWISS(group) *group = SWISS(group_get)(ht, bucket);
+		uint32_t count = swiss_ctrl_count(group->ctrl);
+		if (count > 0)
+			return &group->value[(rnd / ht->bucket_count) % count];
+		if (++bucket == ht->bucket_count)
+			bucket = 0;
+	}
+}
+
+/**
+ * @brief Set iterator to the beginning of hash table
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ */
+static inline void
+SWISS(iterator_begin)(const struct SWISS(core) *ht, struct SWISS(iterator) *itr)
+{
+	(void)ht;
+	itr->bucket = 0;
+	itr->pos = 0;
+	matras_head_read_view(&itr->view);
+	matras_head_read_view(&itr->overflow_view);
+}
+
+/**
+ * @brief Set iterator to position determined by key
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ * @param hash - hash to find
+ * @param key - key to find
+ * @return true if the key is found, false otherwise (the iterator
+ *  is positioned at the end then)
+ */
+static inline bool
+SWISS(iterator_key)(const struct SWISS(core) *ht, struct SWISS(iterator) *itr,
+		    uint32_t hash, SWISS_KEY_TYPE key)
+{
+	matras_head_read_view(&itr->view);
+	matras_head_read_view(&itr->overflow_view);
+	struct SWISS(cursor) cursor;
+	if (!SWISS(lookup_key)(ht, hash, key, &cursor)) {
+		itr->bucket = SWISS(end);
+		itr->pos = 0;
+		return false;
+	}
+	itr->bucket = cursor.bucket;
+	itr->pos = cursor.depth * SWISS_GROUP_SIZE + cursor.slot;
+	return true;
+}
+
+/**
+ * @brief Get the value that iterator currently points to
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ * @return poiner to the value or NULL if iteration is complete
+ */
+static inline SWISS_DATA_TYPE *
+SWISS(iterator_get_and_next)(const struct SWISS(core) *ht,
+			     struct SWISS(iterator) *itr)
+{
+	const struct matras_view *view;
+	const struct matras_view *overflow_view;
+	if (matras_is_read_view_created(&itr->view)) {
+		view = &itr->view;
+		overflow_view = &itr->overflow_view;
+	} else {
+		view = &ht->buckets.head;
+		overflow_view = &ht->overflow.head;
+	}
+	while (itr->bucket < view->block_count) {
+		struct SWISS(group) *group = (struct SWISS(group) *)
+			matras_view_get(&ht->buckets, view, itr->bucket);
+		uint32_t depth = itr->pos / SWISS_GROUP_SIZE;
+		uint32_t slot = itr->pos % SWISS_GROUP_SIZE;
+		for (; depth > 0 && group != NULL; depth--) {
+			if (group->next == SWISS(end)) {
+				group = NULL;
+				break;
+			}
+			group = (struct SWISS(group) *)
+				matras_view_get(&ht->overflow, overflow_view,
+						group->next &
+						~SWISS_OVERFLOW_BIT);
+		}
+		if (group != NULL && slot < swiss_ctrl_count(group->ctrl)) {
+			itr->pos++;
+			return &group->value[slot];
+		}
+		itr->bucket++;
+		itr->pos = 0;
+	}
+	return NULL;
+}
+
+/**
+ * @brief Freezes state for given iterator. All following hash table
+ * modification will not apply to that iterator iteration. That
+ * iterator should be destroyed with a swiss_iterator_destroy call
+ * after usage.
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to freeze
+ */
+static inline void
+SWISS(iterator_freeze)(struct SWISS(core) *ht, struct SWISS(iterator) *itr)
+{
+	assert(!matras_is_read_view_created(&itr->view));
+	matras_create_read_view(&ht->buckets, &itr->view);
+	matras_create_read_view(&ht->overflow, &itr->overflow_view);
+}
+
+/**
+ * @brief Destroy an iterator that was frozen before. Useless for
+ * not frozen iterators.
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to destroy
+ */
+static inline void
+SWISS(iterator_destroy)(struct SWISS(core) *ht, struct SWISS(iterator) *itr)
+{
+	matras_destroy_read_view(&ht->buckets, &itr->view);
+	matras_destroy_read_view(&ht->overflow, &itr->overflow_view);
+}
+
+/*
+ * Selfcheck of the internal state of hash table. Used only for
+ * debugging. If return not zero, something went terribly wrong.
+ */
+static inline int
+SWISS(selfcheck)(const struct SWISS(core) *ht)
+{
+	int res = 0;
+	if (ht->bucket_count != ht->buckets.head.block_count)
+		res |= 1;
+	uint32_t count = 0;
+	for (uint32_t bucket = 0; bucket < ht->bucket_count; bucket++) {
+		struct SWISS(group) *group = SWISS(group_get)(ht, bucket);
+		while (true) {
+			uint32_t n = swiss_ctrl_count(group->ctrl);
+			for (uint32_t slot = 0; slot < SWISS_GROUP_SIZE;
+			     slot++) {
+				if (slot >= n) {
+					if (group->ctrl[slot] !=
+					    SWISS_CTRL_EMPTY)
+						res |= 2;
+					continue;
+				}
+				uint32_t hash = group->hash[slot];
+				if (group->ctrl[slot] != swiss_ctrl(hash))
+					res |= 4;
+				if (SWISS(bucket)(ht, hash) != bucket)
+					res |= 8;
+			}
+			count += n;
+			if (group->next == SWISS(end))
+				break;
+			if (n != SWISS_GROUP_SIZE)
+				res |= 16;
+			if ((group->next & SWISS_OVERFLOW_BIT) == 0)
+				res |= 32;
+			group = SWISS(group_get)(ht, group->next);
+		}
+	}
+	if (count != ht->count)
+		res |= 64;
+	return res;
+}
+
+#undef SWISS
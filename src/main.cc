@@ -74,6 +74,7 @@
 #include "title.h"
 #include <libutil.h>
 #include "box/lua/init.h" /* box_lua_init() */
+#include "box/lua/net_box_io.h"
 #include "box/session.h"
 #include "box/memtx_tx.h"
 #include "box/module_cache.h"
@@ -530,6 +531,9 @@ tarantool_free(void)
 	if (!cord_is_main())
 		return;
 
+	/* The net.box I/O thread uses the worker pool. */
+	netbox_io_free();
+
 	/* Shutdown worker pool. Waits until threads terminate. */
 	coio_shutdown();
 
@@ -175,6 +175,7 @@
 #cmakedefine HAVE_FALLOCATE 1
 #cmakedefine HAVE_MREMAP 1
 #cmakedefine HAVE_SYNC_FILE_RANGE 1
+#cmakedefine HAVE_IO_URING 1
 
 #cmakedefine HAVE_MSG_NOSIGNAL 1
 #cmakedefine HAVE_SO_NOSIGPIPE 1
@@ -0,0 +1,90 @@
+local net = require('net.box')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new({alias = 'default'})
+    cg.server:start()
+    cg.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        box.schema.user.grant('guest', 'super')
+    end)
+end)
+
+g.before_each(function(cg)
+    cg.server:exec(function()
+        local s = box.space.test
+        for i = 1, 200 do
+            -- Mix tuples copied to the output buffer and large
+            -- tuples written right from memory.
+            local size = i % 3 == 0 and 10 or i * 100
+            s:replace{i, string.rep(string.char(65 + i % 26), size)}
+        end
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.test_select = function(cg)
+    local expected = cg.server:exec(function()
+        return box.space.test:select()
+    end)
+    local c = net.connect(cg.server.net_box_uri)
+    local s = c.space.test
+    t.assert_equals(s:select(), expected)
+    t.assert_equals(s:select({}, {limit = 10}), {unpack(expected, 1, 10)})
+    t.assert_equals(s:select({150}, {iterator = 'ge'}),
+                    {unpack(expected, 150)})
+    local tuples, pos = s:select({}, {limit = 5, fetch_pos = true})
+    t.assert_equals(tuples, {unpack(expected, 1, 5)})
+    tuples = s:select({}, {limit = 5, after = pos})
+    t.assert_equals(tuples, {unpack(expected, 6, 10)})
+    c:close()
+end
+
+g.test_pipelined_select = function(cg)
+    local expected = cg.server:exec(function()
+        return box.space.test:select()
+    end)
+    local c = net.connect(cg.server.net_box_uri)
+    local s = c.space.test
+    local futures = {}
+    for i = 1, 20 do
+        futures[i] = s:select({}, {is_async = true})
+    end
+    -- Tuples replaced while the responses are being sent.
+    c:eval([[
+        for i = 1, 200 do
+            box.space.test:replace{i, 'x'}
+        end
+    ]])
+    for i = 1, 20 do
+        t.assert_equals(futures[i]:wait_result(), expected)
+    end
+    t.assert_equals(s:select({1}), {{1, 'x'}})
+    c:close()
+end
+
+-- Tuples written to the socket are released without waiting for
+-- the next request from the connection.
+g.test_idle_connection = function(cg)
+    local c = net.connect(cg.server.net_box_uri)
+    t.assert_equals(#c.space.test:select(), 200)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local used = box.slab.info().items_used
+        for i = 1, 200 do
+            box.space.test:delete{i}
+        end
+        -- The large tuples take more than 1 MB.
+        t.helpers.retrying({}, function()
+            t.assert_lt(box.slab.info().items_used, used - 1024 * 1024)
+        end)
+    end)
+    c:close()
+end
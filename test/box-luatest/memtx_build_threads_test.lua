@@ -0,0 +1,69 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all = function()
+    g.server = server:new{
+        alias   = 'default',
+        box_cfg = {memtx_build_threads = 4},
+    }
+    g.server:start()
+end
+
+g.after_all = function()
+    g.server:drop()
+end
+
+g.test_invalid_cfg = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_error_msg_contains(
+            "Can't set option 'memtx_build_threads' dynamically",
+            box.cfg, {memtx_build_threads = 2})
+    end)
+end
+
+g.test_parallel_build = function()
+    g.server:exec(function()
+        for i = 1, 3 do
+            local s = box.schema.create_space('test' .. i)
+            s:create_index('pk')
+            s:create_index('sk1', {parts = {{2, 'unsigned'}},
+                                   unique = false})
+            s:create_index('sk2', {parts = {{3, 'string'}}})
+            s:create_index('sk3', {type = 'hash', parts = {{3, 'string'}}})
+            s:create_index('mk', {parts = {{'[4][*]', 'unsigned'}},
+                                  unique = false})
+            box.begin()
+            for j = 1, 1000 do
+                s:insert{j, j % 7, tostring(2000 - j), {j, j + 1, j}}
+            end
+            box.commit()
+        end
+        box.snapshot()
+        -- Rows recovered from WAL must be indexed too.
+        for i = 1, 3 do
+            box.space['test' .. i]:insert{1001, 0, 'x', {1}}
+        end
+    end)
+    g.server:stop()
+    g.server:start()
+    g.server:exec(function()
+        local t = require('luatest')
+        for i = 1, 3 do
+            local s = box.space['test' .. i]
+            t.assert_equals(s.index.sk1:count(), 1001)
+            t.assert_equals(s.index.sk1:count(0), 143)
+            t.assert_equals(s.index.sk2:select({}, {limit = 2}),
+                            {{1000, 6, '1000', {1000, 1001, 1000}},
+                             {999, 5, '1001', {999, 1000, 999}}})
+            t.assert_equals(s.index.sk3:get('1500'),
+                            {500, 3, '1500', {500, 501, 500}})
+            t.assert_equals(s.index.mk:count(), 2001)
+            t.assert_equals(s.index.mk:select(1), {{1, 1, '1999', {1, 2, 1}},
+                                                   {1001, 0, 'x', {1}}})
+        end
+    end)
+    t.assert(g.server:grep_log('Sorting %d+ secondary indexes using 4 threads'))
+end
@@ -0,0 +1,84 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all = function()
+    g.server = server:new{
+        alias   = 'default',
+        box_cfg = {memtx_snap_threads = 4},
+    }
+    g.server:start()
+end
+
+g.after_all = function()
+    g.server:drop()
+end
+
+g.test_invalid_cfg = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_error_msg_contains(
+            "Incorrect value for option 'memtx_snap_threads'",
+            box.cfg, {memtx_snap_threads = 0})
+        t.assert_error_msg_contains(
+            "Incorrect value for option 'memtx_snap_threads'",
+            box.cfg, {memtx_snap_threads = 1000})
+        t.assert_equals(box.cfg.memtx_snap_threads, 4)
+    end)
+end
+
+g.test_parallel_snapshot = function()
+    g.server:exec(function()
+        for i = 1, 6 do
+            local s = box.schema.create_space('test' .. i)
+            s:create_index('pk')
+            s:create_index('sk', {parts = {{2, 'string'}}})
+            box.begin()
+            for j = 1, i * 1000 do
+                s:insert{j, tostring(j), string.rep('x', j % 200)}
+            end
+            box.commit()
+        end
+        local s = box.schema.create_space('test_vinyl', {engine = 'vinyl'})
+        s:create_index('pk')
+        s:insert{1}
+        box.snapshot()
+    end)
+    t.assert(g.server:grep_log('writing 6 spaces using 4 threads'))
+    -- A space created after the snapshot is recovered from WAL.
+    g.server:exec(function()
+        box.schema.create_space('test7'):create_index('pk')
+        box.space.test7:insert{1}
+    end)
+    g.server:stop()
+    g.server:start()
+    g.server:exec(function()
+        local t = require('luatest')
+        for i = 1, 6 do
+            local s = box.space['test' .. i]
+            t.assert_equals(s:count(), i * 1000)
+            t.assert_equals(s.index.sk:count(), i * 1000)
+            t.assert_equals(s:get(i * 1000),
+                            {i * 1000, tostring(i * 1000),
+                             string.rep('x', i * 1000 % 200)})
+        end
+        t.assert_equals(box.space.test_vinyl:select(), {{1}})
+        t.assert_equals(box.space.test7:select(), {{1}})
+    end)
+end
+
+g.test_single_thread = function()
+    g.server:exec(function()
+        box.cfg{memtx_snap_threads = 1}
+        box.space.test1:replace{1, 'a'}
+        box.snapshot()
+    end)
+    g.server:stop()
+    g.server:start()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.space.test1:get(1), {1, 'a'})
+        t.assert_equals(box.space.test6:count(), 6000)
+    end)
+end
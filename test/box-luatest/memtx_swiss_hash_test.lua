@@ -0,0 +1,74 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all = function()
+    g.server = server:new{
+        alias   = 'default',
+        box_cfg = {memtx_use_swiss_hash = true},
+    }
+    g.server:start()
+end
+
+g.after_all = function()
+    g.server:drop()
+end
+
+g.test_static_cfg = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_error_msg_contains(
+            "Can't set option 'memtx_use_swiss_hash' dynamically",
+            box.cfg, {memtx_use_swiss_hash = false})
+        t.assert_equals(box.cfg.memtx_use_swiss_hash, true)
+    end)
+end
+
+g.test_hash_index = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.create_space('test')
+        s:create_index('pk', {type = 'hash'})
+        s:create_index('sk', {type = 'hash', parts = {{2, 'string'}}})
+        for i = 1, 10000 do
+            s:insert{i, tostring(i)}
+        end
+        t.assert_equals(s:count(), 10000)
+        t.assert_equals(s:get(5000), {5000, '5000'})
+        t.assert_equals(s.index.sk:get('777'), {777, '777'})
+        t.assert_equals(s:get(10001), nil)
+        t.assert_equals(s:replace{5000, 'x'}, {5000, 'x'})
+        t.assert_equals(s.index.sk:get('5000'), nil)
+        t.assert_equals(s.index.sk:get('x'), {5000, 'x'})
+        t.assert_error_msg_contains('Duplicate key exists',
+                                    s.insert, s, {1, 'y'})
+        for i = 1, 10000, 2 do
+            s:delete(i)
+        end
+        t.assert_equals(s:count(), 5000)
+        t.assert_equals(s.index.sk:count(), 5000)
+        t.assert_equals(s:get(1), nil)
+        t.assert_equals(#s:select({}, {iterator = 'ALL'}), 5000)
+        t.assert_equals(s:select({42}, {iterator = 'EQ'}), {{42, '42'}})
+        -- GT iterates in hash order starting right after the key.
+        local all = s:select({}, {iterator = 'ALL'})
+        local gt = s:select({all[100][1]}, {iterator = 'GT'})
+        t.assert_equals(#gt, 4900)
+        t.assert_equals(gt[1], all[101])
+        t.assert_not_equals(s.index.pk:random(123), nil)
+        t.assert_gt(s.index.pk:bsize(), 0)
+        box.snapshot()
+        s:replace{2, 'two'}
+    end)
+    g.server:restart()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        t.assert_equals(s:count(), 5000)
+        t.assert_equals(s:get(2), {2, 'two'})
+        t.assert_equals(s.index.sk:get('two'), {2, 'two'})
+        t.assert_equals(s:get(5000), {5000, 'x'})
+        t.assert_equals(s:get(9999), nil)
+    end)
+end
@@ -0,0 +1,86 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all = function()
+    g.server = server:new{alias = 'default'}
+    g.server:start()
+end
+
+g.after_all = function()
+    g.server:drop()
+end
+
+g.after_each = function()
+    g.server:exec(function()
+        if box.space.test ~= nil then
+            box.space.test:drop()
+        end
+    end)
+end
+
+g.test_invalid_opts = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.create_space('test')
+        t.assert_error_msg_contains(
+            "fast_offset is only reasonable with memtx tree index",
+            s.create_index, s, 'pk', {type = 'hash', fast_offset = true})
+        s:create_index('pk')
+        t.assert_error_msg_contains(
+            "multikey index can't use fast_offset",
+            s.create_index, s, 'mk', {parts = {{'[2][*]', 'unsigned'}},
+                                      fast_offset = true})
+        local v = box.schema.create_space('test_vinyl', {engine = 'vinyl'})
+        t.assert_error_msg_contains(
+            "fast_offset is only reasonable with memtx tree index",
+            v.create_index, v, 'pk', {fast_offset = true})
+        v:drop()
+    end)
+end
+
+g.test_select_and_count = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.create_space('test')
+        s:create_index('pk')
+        s:create_index('sk', {parts = {{2, 'unsigned'}}, unique = false,
+                              fast_offset = true})
+        s:create_index('nh', {parts = {{2, 'unsigned'}}, unique = false,
+                              hint = false, fast_offset = true})
+        t.assert(s.index.sk.fast_offset)
+        t.assert_equals(s.index.pk.fast_offset, nil)
+        for i = 1, 1000 do
+            s:insert{i, i % 10}
+        end
+        for i = 1, 1000, 3 do
+            s:delete{i}
+        end
+        local iterators = {'EQ', 'REQ', 'ALL', 'GE', 'GT', 'LE', 'LT'}
+        for _, name in ipairs({'sk', 'nh'}) do
+            local idx = s.index[name]
+            for _, it in ipairs(iterators) do
+                for _, key in ipairs({{}, {0}, {5}, {9}, {10}}) do
+                    local all = idx:select(key, {iterator = it})
+                    t.assert_equals(idx:count(key, {iterator = it}), #all)
+                    for _, offset in ipairs({0, 1, 10, 99, 100, 1000}) do
+                        local opts = {iterator = it, offset = offset,
+                                      limit = 10}
+                        local expected = {}
+                        for i = offset + 1, math.min(offset + 10, #all) do
+                            table.insert(expected, all[i])
+                        end
+                        t.assert_equals(idx:select(key, opts), expected)
+                    end
+                end
+            end
+        end
+        -- The option can be changed by alter.
+        s.index.sk:alter({fast_offset = false})
+        t.assert_equals(s.index.sk.fast_offset, nil)
+        t.assert_equals(s.index.sk:count({5}, {iterator = 'GE'}), 334)
+        s.index.pk:alter({fast_offset = true})
+        t.assert_equals(#s.index.pk:select({}, {offset = 600}), 66)
+    end)
+end
@@ -0,0 +1,168 @@
+local fiber = require('fiber')
+local net = require('net.box')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function(cg)
+    cg.server = server:new({alias = 'master'})
+    cg.server:start()
+    cg.server:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        rawset(_G, 'echo', function(...) return ... end)
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function()
+        box.space.test:truncate()
+        box.cfg{net_compression_level = 0}
+    end)
+end)
+
+g.test_requests = function(cg)
+    local c = net.connect(cg.server.net_box_uri, {io_thread = true})
+    t.assert_equals(c.state, 'active')
+    t.assert(c:ping())
+    t.assert_equals({c:call('echo', {1, 'two', {3}})}, {1, 'two', {3}})
+    t.assert_equals(c:eval('return 1 + 1'), 2)
+    c.space.test:insert({1, 'a'})
+    c.space.test:replace({2, 'b'})
+    t.assert_equals(c.space.test:select(), {{1, 'a'}, {2, 'b'}})
+    t.assert_equals(c.space.test:get(2), {2, 'b'})
+    c.space.test:delete(1)
+    t.assert_equals(c.space.test:count(), 1)
+    c:close()
+    t.assert_equals(c.state, 'closed')
+end
+
+g.test_async_requests = function(cg)
+    local c = net.connect(cg.server.net_box_uri, {io_thread = true})
+    local futures = {}
+    for i = 1, 1000 do
+        futures[i] = c.space.test:insert({i, string.rep('x', i)},
+                                         {is_async = true})
+    end
+    for i = 1, 1000 do
+        t.assert_equals(futures[i]:wait_result(), {i, string.rep('x', i)})
+    end
+    t.assert_equals(c.space.test:count(), 1000)
+    c:close()
+end
+
+g.test_concurrent_fibers = function(cg)
+    local c = net.connect(cg.server.net_box_uri, {io_thread = true})
+    local results = {}
+    local fibers = {}
+    for i = 1, 10 do
+        fibers[i] = fiber.new(function()
+            fiber.self():set_joinable(true)
+            local sum = 0
+            for j = 1, 100 do
+                sum = sum + c:call('echo', {j})
+            end
+            results[i] = sum
+        end)
+    end
+    for i = 1, 10 do
+        fibers[i]:join()
+        t.assert_equals(results[i], 5050)
+    end
+    c:close()
+end
+
+g.test_large_payload = function(cg)
+    local c = net.connect(cg.server.net_box_uri, {io_thread = true})
+    local data = string.rep('x', 10 * 1024 * 1024)
+    t.assert_equals(c:call('echo', {data}), data)
+    c:close()
+end
+
+g.test_compression = function(cg)
+    cg.server:exec(function()
+        box.cfg{net_compression_level = 3}
+    end)
+    local c = net.connect(cg.server.net_box_uri, {io_thread = true})
+    local data = string.rep('abc', 10000)
+    for i = 1, 10 do
+        t.assert_equals(c:call('echo', {data, i}), data)
+    end
+    c:close()
+end
+
+g.test_close_wait = function(cg)
+    local c = net.connect(cg.server.net_box_uri, {io_thread = true})
+    for i = 1, 100 do
+        c.space.test:insert({i}, {is_async = true})
+    end
+    c:close()
+    t.helpers.retrying({}, function()
+        t.assert_equals(cg.server:exec(function()
+            return box.space.test:count()
+        end), 100)
+    end)
+end
+
+g.test_connect_error = function()
+    local c = net.connect('unix/:/no/such/socket', {io_thread = true})
+    t.assert_equals(c.state, 'error')
+    t.assert_str_contains(c.error, 'No such file or directory')
+    c:close()
+end
+
+g.test_ssl = function(cg)
+    t.assert_error_msg_equals(
+        'net.box I/O thread does not support SSL connections',
+        net.connect, {cg.server.net_box_uri, params = {transport = 'ssl'}},
+        {io_thread = true})
+end
+
+g.test_reconnect = function(cg)
+    local c = net.connect(cg.server.net_box_uri,
+                          {io_thread = true, reconnect_after = 0.1})
+    t.assert_equals(c:call('echo', {1}), 1)
+    cg.server:stop()
+    t.helpers.retrying({}, function()
+        t.assert_not_equals(c.state, 'active')
+    end)
+    cg.server:start()
+    t.assert(c:wait_connected(60))
+    t.assert_equals(c:call('echo', {2}), 2)
+    c:close()
+end
+
+-- The I/O thread stops reading when the tx thread lags behind and
+-- resumes when it catches up.
+g.test_slow_receiver = function(cg)
+    local c = net.connect(cg.server.net_box_uri, {io_thread = true})
+    local data = string.rep('x', 1024 * 1024)
+    local futures = {}
+    for i = 1, 64 do
+        futures[i] = c:call('echo', {data, i}, {is_async = true})
+    end
+    -- Let the server send the responses while the tx thread is busy.
+    fiber.sleep(0.1)
+    local deadline = fiber.clock() + 0.5
+    while fiber.clock() < deadline do end
+    for i = 1, 64 do
+        t.assert_equals(futures[i]:wait_result(), {data, i})
+    end
+    c:close()
+end
+
+-- The I/O thread is stopped at exit even if there are connections.
+g.test_exit = function(cg)
+    cg.server:exec(function()
+        local net = require('net.box')
+        rawset(_G, 'conn', net.connect(box.cfg.listen, {io_thread = true}))
+        _G.conn:call('echo', {string.rep('x', 1024 * 1024)},
+                     {is_async = true})
+    end)
+    cg.server:restart()
+    t.assert_equals(cg.server:exec(function() return 1 end), 1)
+end
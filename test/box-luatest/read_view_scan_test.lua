@@ -0,0 +1,247 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+
+local g = t.group('read_view_scan')
+
+g.before_all(function(cg)
+    cg.server = server:new{alias = 'default'}
+    cg.server:start()
+    cg.server:exec(function()
+        local s = box.schema.create_space('test', {format = {
+            {'id', 'unsigned'}, {'a', 'integer', is_nullable = true},
+            {'d', 'number', is_nullable = true},
+            {'s', 'string', is_nullable = true},
+        }})
+        s:create_index('pk')
+        for i = 1, 1000 do
+            s:insert{i, i % 10 - 5, i / 4, 'k' .. i % 7}
+        end
+        s:insert{1001, box.NULL, box.NULL, box.NULL}
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.test_lua = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        -- Whole tuples.
+        local res = s:read_view_scan({limit = 3})
+        t.assert_equals(#res, 3)
+        t.assert_equals(res[2]:totable(), s:get(2):totable())
+        t.assert_equals(#s:read_view_scan(), s:count())
+        -- Filters and projection.
+        res = s:read_view_scan({filter = {{'a', '==', 0}, {2, '~=', 'x'},
+                                          {'id', '<', 100}},
+                                fields = {'id', 4}})
+        local expected = {}
+        for _, tuple in s:pairs() do
+            if tuple.id < 100 and tuple.a == 0 then
+                table.insert(expected, {tuple.id, tuple.s})
+            end
+        end
+        t.assert_equals(#res, #expected)
+        for i, row in ipairs(res) do
+            t.assert_equals(row:totable(), expected[i])
+        end
+        res = s:read_view_scan({filter = {{'s', '>=', 'k6'}}, fields = {1}})
+        t.assert_equals(#res, 143)
+        -- Aggregates.
+        res = s:read_view_scan({aggregate = {{'count'}, {'count', 'a'},
+                                             {'sum', 'a'}, {'sum', 'd'},
+                                             {'min', 's'}, {'max', 'id'}}})
+        t.assert_equals(res[1]:totable(),
+                        {1001, 1000, -500, 1000 * 1001 / 8, 'k0', 1001})
+        res = s:read_view_scan({filter = {{'id', '>', 2000}},
+                                aggregate = {{'count'}, {'sum', 'a'},
+                                             {'min', 'a'}}})
+        t.assert_equals(res[1][1], 0)
+        t.assert(res[1][2] == nil and res[1][3] == nil)
+        t.assert_equals(s:read_view_scan({aggregate = {{'count'}},
+                                          limit = 0}), {})
+    end)
+end
+
+g.test_consistency = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local fiber = require('fiber')
+        local s = box.schema.create_space('tmp')
+        s:create_index('pk')
+        for i = 1, 100000 do
+            s:replace{i}
+        end
+        -- Changes made during a scan aren't visible to it.
+        local f = fiber.new(function()
+            return s:read_view_scan({aggregate = {{'count'}, {'sum', 1}}})
+        end)
+        f:set_joinable(true)
+        fiber.yield()
+        s:truncate()
+        local ok, res = f:join()
+        t.assert(ok)
+        t.assert_equals(res[1]:totable(), {100000, 100000 * 100001 / 2})
+        s:drop()
+    end)
+end
+
+g.test_errors = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        t.assert_error_msg_content_equals(
+            "Illegal parameters, filter[1]: unknown field 'x'",
+            s.read_view_scan, s, {filter = {{'x', '==', 1}}})
+        t.assert_error_msg_content_equals(
+            "Illegal parameters, filter[1]: unknown operator 'eq'",
+            s.read_view_scan, s, {filter = {{1, 'eq', 1}}})
+        t.assert_error_msg_content_equals(
+            "Illegal parameters, read view scan filter value must be scalar",
+            s.read_view_scan, s, {filter = {{1, '==', {1}}}})
+        t.assert_error_msg_content_equals(
+            "Illegal parameters, fields and aggregate can't be used together",
+            s.read_view_scan, s, {fields = {1}, aggregate = {{'count'}}})
+        t.assert_error_msg_content_equals(
+            "Illegal parameters, aggregate[1]: field is required for 'sum'",
+            s.read_view_scan, s, {aggregate = {{'sum'}}})
+        t.assert_error_msg_content_equals(
+            "Tuple field 4 type does not match one required by operation: " ..
+            "expected number, got string",
+            s.read_view_scan, s, {aggregate = {{'sum', 's'}}})
+        local v = box.schema.create_space('vinyl', {engine = 'vinyl'})
+        v:create_index('pk')
+        t.assert_error_msg_content_equals(
+            "vinyl does not support read view scan",
+            v.read_view_scan, v)
+        v:drop()
+    end)
+end
+
+g.test_sql = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        box.execute([[CREATE TABLE t(i INT PRIMARY KEY, a INT, d DOUBLE,
+                                     s STRING, c STRING COLLATE "unicode_ci",
+                                     b BOOLEAN);]])
+        for i = 1, 200 do
+            box.execute([[INSERT INTO t VALUES(?, ?, ?, ?, ?, ?);]],
+                        {i, i % 10 - 5, i / 4, 'k' .. i % 7, 'K' .. i % 3,
+                         i % 2 == 0})
+        end
+        box.execute([[INSERT INTO t VALUES(201, NULL, NULL, NULL, NULL,
+                                           NULL);]])
+        local queries = {
+            [[SELECT * FROM t;]],
+            [[SELECT s, i FROM t WHERE a >= 0 AND 100 > i;]],
+            [[SELECT i FROM t WHERE s = 'k3' AND b = TRUE LIMIT 5 OFFSET 2;]],
+            [[SELECT i FROM t WHERE d < 10.5 AND a <> -1;]],
+            [[SELECT count(*) FROM t WHERE a = -5;]],
+            [[SELECT count(a), sum(a), sum(d), min(s), max(i) FROM t;]],
+            [[SELECT max(d), min(a) FROM t WHERE i > 1000;]],
+        }
+        local function uses_read_view(sql)
+            local plan = box.execute('EXPLAIN QUERY PLAN ' .. sql).rows
+            for _, row in ipairs(plan) do
+                if row[4]:find('USING READ VIEW') then
+                    return true
+                end
+            end
+            return false
+        end
+        for _, sql in ipairs(queries) do
+            local expected = box.execute(sql).rows
+            t.assert_not(uses_read_view(sql), sql)
+            box.execute([[SET SESSION "sql_read_view_scan" = true;]])
+            t.assert(uses_read_view(sql), sql)
+            t.assert_equals(box.execute(sql).rows, expected, sql)
+            box.execute([[SET SESSION "sql_read_view_scan" = false;]])
+        end
+        queries = {
+            -- Simple count is O(1).
+            [[SELECT count(*) FROM t;]],
+            -- Collations.
+            [[SELECT i FROM t WHERE c = 'k1';]],
+            [[SELECT min(c) FROM t;]],
+            -- Expressions.
+            [[SELECT i + 1 FROM t;]],
+            [[SELECT i FROM t WHERE a + 1 = 0;]],
+            [[SELECT i FROM t WHERE a = 1 OR a = 2;]],
+            -- Ordering and grouping.
+            [[SELECT i FROM t ORDER BY a;]],
+            [[SELECT a, count(*) FROM t GROUP BY a;]],
+        }
+        box.execute([[SET SESSION "sql_read_view_scan" = true;]])
+        for _, sql in ipairs(queries) do
+            t.assert_not(uses_read_view(sql), sql)
+        end
+        box.execute([[SET SESSION "sql_read_view_scan" = false;]])
+        box.execute([[DROP TABLE t;]])
+    end)
+end
+
+-- A read view doesn't see changes of the current transaction, so
+-- SQL falls back to a regular scan and Lua raises an error.
+g.test_transaction = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        local sql = [[SELECT count(*) FROM "test" WHERE "id" > 1000;]]
+        box.execute([[SET SESSION "sql_read_view_scan" = true;]])
+        local stmt = box.prepare(sql)
+        box.begin()
+        -- No changes yet.
+        t.assert_equals(s:read_view_scan({filter = {{'id', '>', 1000}},
+                                          aggregate = {{'count'}}})[1][1], 1)
+        s:insert{1002}
+        t.assert_error_msg_content_equals(
+            "Read view scan does not support transactions with changes",
+            s.read_view_scan, s)
+        local plan = box.execute('EXPLAIN QUERY PLAN ' .. sql).rows
+        t.assert_not_str_contains(plan[1][4], 'USING READ VIEW')
+        t.assert_equals(box.execute(sql).rows, {{2}})
+        t.assert_equals(stmt:execute().rows, {{2}})
+        box.rollback()
+        t.assert_equals(stmt:execute().rows, {{1}})
+        stmt:unprepare()
+        box.execute([[SET SESSION "sql_read_view_scan" = false;]])
+    end)
+end
+
+local g_mvcc = t.group('read_view_scan_mvcc')
+
+g_mvcc.before_all(function(cg)
+    cg.server = server:new{
+        alias = 'default',
+        box_cfg = {memtx_use_mvcc_engine = true},
+    }
+    cg.server:start()
+end)
+
+g_mvcc.after_all(function(cg)
+    cg.server:drop()
+end)
+
+-- The memtx transaction manager doesn't track read views.
+g_mvcc.test_mvcc = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.create_space('test', {
+            format = {{'id', 'unsigned'}},
+        })
+        s:create_index('pk')
+        s:insert{1}
+        t.assert_error_msg_content_equals(
+            "Read view scan does not support memtx transaction manager",
+            s.read_view_scan, s)
+        box.execute([[SET SESSION "sql_read_view_scan" = true;]])
+        local sql = [[SELECT * FROM "test" WHERE "id" > 0;]]
+        local plan = box.execute('EXPLAIN QUERY PLAN ' .. sql).rows
+        t.assert_not_str_contains(plan[1][4], 'USING READ VIEW')
+        t.assert_equals(box.execute(sql).rows, {{1}})
+        box.execute([[SET SESSION "sql_read_view_scan" = false;]])
+        s:drop()
+    end)
+end
@@ -0,0 +1,208 @@
+local msgpack = require('msgpack')
+local net = require('net.box')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+
+local g = t.group('select_after', t.helpers.matrix({
+    engine = {'memtx', 'vinyl'},
+}))
+
+g.before_all(function(cg)
+    cg.server = server:new({alias = 'master'})
+    cg.server:start()
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.before_each(function(cg)
+    cg.server:exec(function(engine)
+        local s = box.schema.space.create('test', {engine = engine})
+        s:create_index('pk')
+        s:create_index('sk', {parts = {{2, 'unsigned'}}, unique = false})
+        for i = 1, 20 do
+            s:insert{i, i % 3}
+        end
+    end, {cg.params.engine})
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function()
+        box.space.test:drop()
+    end)
+end)
+
+g.test_select = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        local function paginate(index, key, opts)
+            local result = {}
+            local tuples, pos
+            repeat
+                opts.after = pos
+                tuples, pos = index:select(key, opts)
+                for _, tuple in ipairs(tuples) do
+                    table.insert(result, tuple)
+                end
+            until #tuples < opts.limit
+            return result
+        end
+        local cases = {
+            {s.index.pk, {}, {iterator = 'ge'}},
+            {s.index.pk, {}, {iterator = 'le'}},
+            {s.index.pk, {5}, {iterator = 'gt'}},
+            {s.index.pk, {15}, {iterator = 'lt'}},
+            {s.index.sk, {1}, {iterator = 'eq'}},
+            {s.index.sk, {1}, {iterator = 'req'}},
+            {s.index.sk, {1}, {iterator = 'ge'}},
+        }
+        for _, case in ipairs(cases) do
+            local index, key, opts = unpack(case)
+            local expected = index:select(key, opts)
+            for _, limit in ipairs({1, 3, 7}) do
+                opts.limit = limit
+                opts.fetch_pos = true
+                t.assert_equals(paginate(index, key, opts), expected)
+            end
+        end
+
+        -- The position of the last tuple is returned.
+        local tuples, pos = s:select({}, {limit = 2, fetch_pos = true})
+        t.assert_equals(tuples, {{1, 1}, {2, 2}})
+        t.assert_equals(pos, s.index.pk:tuple_pos(tuples[2]))
+        -- The position is left as is if nothing is selected.
+        tuples, pos = s:select({100}, {iterator = 'ge', fetch_pos = true})
+        t.assert_equals(tuples, {})
+        t.assert_equals(pos, nil)
+        tuples, pos = s:select({}, {after = {20}, fetch_pos = true})
+        t.assert_equals(tuples, {})
+        t.assert_equals(pos, nil)
+
+        -- A tuple can be passed instead of a position.
+        t.assert_equals(s:select({}, {after = {17}}), {{18, 0}, {19, 1},
+                                                       {20, 2}})
+        t.assert_equals(s:select({}, {after = s:get(17)}), {{18, 0}, {19, 1},
+                                                           {20, 2}})
+        t.assert_equals(s.index.sk:select({2}, {after = {14, 2}}),
+                        {{17, 2}, {20, 2}})
+        -- Offset is applied after the position.
+        t.assert_equals(s:select({}, {after = {17}, offset = 1}),
+                        {{19, 1}, {20, 2}})
+        -- A position preceding the iteration range is ignored.
+        t.assert_equals(s:select({18}, {iterator = 'ge', after = {2}}),
+                        {{18, 0}, {19, 1}, {20, 2}})
+        t.assert_equals(s:select({18}, {iterator = 'gt', after = {18}}),
+                        {{19, 1}, {20, 2}})
+        -- The position of a deleted tuple is still valid.
+        s:delete{18}
+        t.assert_equals(s:select({}, {after = {17}}), {{19, 1}, {20, 2}})
+    end)
+end
+
+g.test_pairs = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        local function collect(index, key, opts)
+            local result = {}
+            for _, tuple in index:pairs(key, opts) do
+                table.insert(result, tuple)
+            end
+            return result
+        end
+        t.assert_equals(collect(s.index.pk, {}, {after = {17}}),
+                        {{18, 0}, {19, 1}, {20, 2}})
+        t.assert_equals(collect(s.index.pk, {4}, {iterator = 'lt',
+                                                  after = {2}}),
+                        {{1, 1}})
+        local pos = s.index.sk:tuple_pos({11, 2})
+        t.assert_equals(collect(s.index.sk, {2}, {after = pos}),
+                        {{14, 2}, {17, 2}, {20, 2}})
+    end)
+end
+
+-- A unique secondary index without nullable parts compares tuples by
+-- its key_def while a position contains the primary key parts too.
+g.test_unique_secondary = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        local uk = s:create_index('uk', {parts = {{3, 'unsigned'}}})
+        for i = 1, 20 do
+            s:replace{i, i % 3, 100 - i}
+        end
+        local pos = uk:tuple_pos(s:get(5))
+        t.assert_equals(uk:select({}, {after = pos, limit = 2}),
+                        {{4, 1, 96}, {3, 0, 97}})
+        t.assert_equals(uk:select({}, {after = pos, limit = 2,
+                                       iterator = 'lt'}),
+                        {{6, 0, 94}, {7, 1, 93}})
+        t.assert_equals(uk:select({90}, {after = {95, 5}, iterator = 'gt'}),
+                        {{4, 1, 96}, {3, 0, 97}, {2, 2, 98}, {1, 1, 99}})
+        local tuples
+        tuples, pos = uk:select({}, {limit = 19, fetch_pos = true})
+        t.assert_equals(#tuples, 19)
+        t.assert_equals(uk:select({}, {after = pos}), {{1, 1, 99}})
+    end)
+end
+
+g.test_invalid_position = function(cg)
+    cg.server:exec(function(engine)
+        local t = require('luatest')
+        local msgpack = require('msgpack')
+        local s = box.space.test
+        local errmsg = 'Illegal parameters, Invalid iterator position'
+        t.assert_error_msg_equals(errmsg, s.select, s, {},
+                                  {after = msgpack.encode({'a'})})
+        t.assert_error_msg_equals(errmsg, s.select, s, {},
+                                  {after = msgpack.encode({1, 2})})
+        t.assert_error_msg_equals(errmsg, s.select, s, {},
+                                  {after = 'garbage'})
+        t.assert_error_msg_equals(errmsg, s.index.sk.select, s.index.sk,
+                                  {}, {after = msgpack.encode({1})})
+        t.assert_error_msg_equals(
+            "Illegal parameters, options parameter 'after' should be " ..
+            "of type string, table, tuple",
+            s.select, s, {}, {after = 1})
+        t.assert_error_msg_equals(
+            "Illegal parameters, options parameter 'fetch_pos' should be " ..
+            "of type boolean",
+            s.select, s, {}, {fetch_pos = 1})
+        t.assert_error_msg_contains(
+            "Tuple field [2] required by space format is missing",
+            s.index.sk.tuple_pos, s.index.sk, {1})
+        if engine == 'memtx' then
+            local h = s:create_index('h', {type = 'hash'})
+            t.assert_error_msg_contains(
+                'does not support pagination',
+                h.select, h, {}, {fetch_pos = true})
+            t.assert_error_msg_contains(
+                'does not support pagination',
+                h.pairs, h, {}, {after = {1}})
+        end
+    end, {cg.params.engine})
+end
+
+g.test_net_box = function(cg)
+    local c = net.connect(cg.server.net_box_uri)
+    local s = c.space.test
+    local tuples, pos = s:select({}, {limit = 2, fetch_pos = true})
+    t.assert_equals(tuples, {{1, 1}, {2, 2}})
+    t.assert_equals(pos, cg.server:exec(function()
+        return box.space.test.index.pk:tuple_pos({2})
+    end))
+    tuples, pos = s:select({}, {limit = 2, after = pos, fetch_pos = true})
+    t.assert_equals(tuples, {{3, 0}, {4, 1}})
+    t.assert_equals(s.index.sk:select({0}, {limit = 2,
+                                           after = msgpack.encode({0, 3})}),
+                    {{6, 0}, {9, 0}})
+    tuples, pos = s:select({100}, {iterator = 'ge', fetch_pos = true})
+    t.assert_equals(tuples, {})
+    t.assert_equals(pos, nil)
+    t.assert_error_msg_contains(
+        "'fetch_pos' is not supported with 'is_async' or 'buffer' options",
+        s.select, s, {}, {fetch_pos = true, is_async = true})
+    c:close()
+end
@@ -0,0 +1,165 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+
+local g = t.group('space_memory_quota')
+
+g.before_all(function(cg)
+    cg.server = server:new{alias = 'default'}
+    cg.server:start()
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function()
+        for _, name in ipairs({'test', 'other'}) do
+            if box.space[name] ~= nil then
+                box.space[name]:drop()
+            end
+        end
+    end)
+end)
+
+g.test_stat = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.create_space('test')
+        s:create_index('pk')
+        s:create_index('sk', {parts = {2, 'unsigned'}})
+        local stat = s:stat()
+        t.assert_equals(stat.bsize, 0)
+        t.assert_equals(stat.memory.tuples_estimate, 0)
+        t.assert_equals(stat.memory.quota, 0)
+        for i = 1, 100 do
+            s:insert{i, i, string.rep('x', 100)}
+        end
+        stat = s:stat()
+        t.assert_equals(stat.bsize, s:bsize())
+        t.assert_gt(stat.memory.tuples_estimate, stat.bsize)
+        t.assert_equals(stat.memory.indexes,
+                        s.index.pk:bsize() + s.index.sk:bsize())
+        t.assert_equals(stat.memory.total_estimate,
+                        stat.memory.tuples_estimate + stat.memory.indexes)
+        s:truncate()
+        t.assert_equals(s:stat().memory.tuples_estimate, 0)
+        t.assert_error_msg_contains("usage space.stat(space_id)",
+                                    box.internal.space.stat)
+    end)
+end
+
+g.test_quota = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local quota = 256 * 1024
+        local s = box.schema.create_space('test', {memory_quota = quota})
+        s:create_index('pk')
+        local other = box.schema.create_space('other')
+        other:create_index('pk')
+        t.assert_equals(s:stat().memory.quota, quota)
+        local data = string.rep('x', 1000)
+        local ok, err
+        local count = 0
+        repeat
+            count = count + 1
+            ok, err = pcall(s.insert, s, {count, data})
+        until not ok
+        t.assert_equals(err.code, box.error.SPACE_MEMORY_QUOTA)
+        t.assert_str_contains(err.message, "in space 'test': " ..
+                              "memory quota of 262144 bytes exceeded")
+        t.assert_equals(s:len(), count - 1)
+        -- Other spaces are not affected.
+        for i = 1, count do
+            other:insert{i, data}
+        end
+        -- Deletes and updates that don't grow tuples still work.
+        s:delete{1}
+        s:update({2}, {{'=', 2, 'y'}})
+        s:insert{count, data}
+        t.assert_error_msg_contains('memory quota', s.update, s, {3},
+                                    {{'=', 2, string.rep(data, 5)}})
+        -- Raising the quota allows inserting more.
+        s:alter{memory_quota = quota * 2}
+        t.assert_equals(s:stat().memory.quota, quota * 2)
+        s:insert{count + 1, data}
+        -- Zero means no limit.
+        s:alter{memory_quota = 0}
+        for i = count + 2, count * 3 do
+            s:insert{i, data}
+        end
+        t.assert_gt(s:stat().memory.total_estimate, quota * 2)
+        t.assert_error_msg_contains('memory_quota must be non-negative',
+                                    s.alter, s, {memory_quota = -1})
+        -- The quota isn't checked on rollback.
+        s:alter{memory_quota = 1}
+        box.begin()
+        s:delete{count + 1}
+        box.rollback()
+        t.assert_equals(s:get{count + 1}[2], data)
+    end)
+end
+
+-- A tuple replaced by REPLACE or UPSERT is subtracted from the space
+-- memory even if it isn't given explicitly.
+g.test_replace_at_quota = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.create_space('test', {memory_quota = 64 * 1024})
+        s:create_index('pk')
+        s:create_index('sk', {parts = {2, 'string'}, unique = false})
+        local data = string.rep('x', 1000)
+        local count = 0
+        while pcall(s.insert, s, {count + 1, data}) do
+            count = count + 1
+        end
+        for i = 1, count do
+            s:replace{i, string.rep('y', 1000)}
+        end
+        s:upsert({1, data}, {{'=', 2, string.rep('z', 1000)}})
+        t.assert_equals(s:len(), count)
+        t.assert_equals(s:get(1)[2], string.rep('z', 1000))
+        t.assert_error_msg_contains('memory quota', s.replace, s,
+                                    {count + 1, data})
+        t.assert_error_msg_contains('memory quota', s.replace, s,
+                                    {1, string.rep(data, 2)})
+        t.assert_equals(s:len(), count)
+        t.assert_equals(s:get(1)[2], string.rep('z', 1000))
+    end)
+end
+
+g.test_vinyl = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        t.assert_error_msg_contains('engine does not support memory quota',
+                                    box.schema.create_space, 'test',
+                                    {engine = 'vinyl', memory_quota = 1000})
+    end)
+end
+
+g.test_recovery = function(cg)
+    cg.server:exec(function()
+        local s = box.schema.create_space('test', {memory_quota = 100000})
+        s:create_index('pk')
+        for i = 1, 10 do
+            s:insert{i, string.rep('x', 100)}
+        end
+        box.snapshot()
+        for i = 11, 20 do
+            s:insert{i, string.rep('x', 100)}
+        end
+    end)
+    local stat = cg.server:exec(function()
+        return box.space.test:stat()
+    end)
+    cg.server:stop()
+    cg.server:start()
+    cg.server:exec(function(stat)
+        local t = require('luatest')
+        local new_stat = box.space.test:stat()
+        t.assert_equals(new_stat.bsize, stat.bsize)
+        t.assert_equals(new_stat.memory.tuples_estimate,
+                        stat.memory.tuples_estimate)
+        t.assert_equals(new_stat.memory.quota, 100000)
+    end, {stat})
+end
@@ -0,0 +1,98 @@
+local net = require('net.box')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+
+local g = t.group('stat_latency')
+
+g.before_all(function(cg)
+    cg.server = server:new{alias = 'default'}
+    cg.server:start()
+    cg.server:exec(function()
+        local s = box.schema.create_space('test')
+        s:create_index('pk')
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.before_each(function(cg)
+    cg.server:exec(function()
+        box.stat.reset()
+    end)
+end)
+
+g.test_latency = function(cg)
+    local conn = net.connect(cg.server.net_box_uri)
+    for i = 1, 10 do
+        conn.space.test:replace{i}
+        conn.space.test:select{i}
+    end
+    conn:eval([[require('fiber').sleep(0.01)]])
+    conn:close()
+    cg.server:exec(function()
+        local t = require('luatest')
+        local stat
+        t.helpers.retrying({}, function()
+            stat = box.stat.latency()
+            t.assert_equals(stat.REPLACE.total.count, 10)
+            -- net.box also fetches the schema with SELECTs.
+            t.assert_ge(stat.SELECT.total.count, 10)
+            t.assert_equals(stat.EVAL.total.count, 1)
+        end)
+        t.assert_equals(stat.INSERT, nil)
+        local stages = {'queue', 'tx', 'wal', 'net', 'total'}
+        for _, stage in ipairs(stages) do
+            local s = stat.REPLACE[stage]
+            t.assert_equals(s.count, 10, stage)
+            t.assert_le(s.p50, s.p90, stage)
+            t.assert_le(s.p90, s.p99, stage)
+            t.assert_le(s.p99, s['p99.9'], stage)
+            t.assert_le(s['p99.9'], s.max, stage)
+            t.assert_le(s.max, s.sum, stage)
+            t.assert_equals(s.buckets, nil)
+        end
+        -- SELECT doesn't wait for WAL.
+        t.assert_equals(stat.SELECT.wal.count, 0)
+        t.assert_equals(stat.SELECT.tx.count, stat.SELECT.total.count)
+        -- EVAL sleeps for 10 ms in tx.
+        t.assert_ge(stat.EVAL.tx.max, 0.009)
+        t.assert_ge(stat.EVAL.total.max, stat.EVAL.tx.max)
+    end)
+end
+
+g.test_percentiles_and_buckets = function(cg)
+    local conn = net.connect(cg.server.net_box_uri)
+    for i = 1, 10 do
+        conn:call('tostring', {i})
+    end
+    conn:close()
+    cg.server:exec(function()
+        local t = require('luatest')
+        local stat
+        t.helpers.retrying({}, function()
+            stat = box.stat.latency({percentiles = {25, 100},
+                                     buckets = true})
+            t.assert_equals(stat.CALL.total.count, 10)
+        end)
+        local s = stat.CALL.total
+        t.assert_equals(s.p50, nil)
+        t.assert_le(s.p25, s.p100)
+        t.assert_equals(s.p100, s.max)
+        local count = 0
+        local prev = 0
+        for _, b in ipairs(s.buckets) do
+            t.assert_gt(b.le, prev)
+            t.assert_gt(b.count, 0)
+            prev = b.le
+            count = count + b.count
+        end
+        t.assert_equals(count, 10)
+        t.assert_gt(prev, s.max)
+        t.assert_error_msg_contains('percentile must be in (0, 100]',
+                                    box.stat.latency, {percentiles = {0}})
+        box.stat.reset()
+        t.assert_equals(box.stat.latency(), {})
+    end)
+end
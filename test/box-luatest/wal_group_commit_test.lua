@@ -0,0 +1,146 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+
+local g = t.group('wal_group_commit', t.helpers.matrix({
+    wal_mode = {'write', 'fsync'},
+}))
+
+g.before_all(function(cg)
+    cg.server = server:new{
+        alias   = 'default',
+        box_cfg = {wal_mode = cg.params.wal_mode},
+    }
+    cg.server:start()
+    cg.server:exec(function()
+        local s = box.schema.create_space('test')
+        s:create_index('pk')
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function()
+        box.cfg{wal_commit_delay = 0, wal_commit_min_batch = 0}
+        box.space.test:truncate()
+    end)
+end)
+
+g.test_cfg = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.cfg.wal_commit_delay, 0)
+        t.assert_equals(box.cfg.wal_commit_min_batch, 0)
+        t.assert_error_msg_contains(
+            "Incorrect value for option 'wal_commit_delay'",
+            box.cfg, {wal_commit_delay = -1})
+        t.assert_error_msg_contains(
+            "Incorrect value for option 'wal_commit_min_batch'",
+            box.cfg, {wal_commit_min_batch = -1})
+        box.cfg{wal_commit_delay = 0.01, wal_commit_min_batch = 10}
+        t.assert_equals(box.cfg.wal_commit_delay, 0.01)
+        t.assert_equals(box.cfg.wal_commit_min_batch, 10)
+    end)
+end
+
+-- Transactions committed in different event loop iterations are
+-- written to disk in one group if they arrive within the commit delay.
+g.test_group_commit = function(cg)
+    t.skip_if(cg.params.wal_mode ~= 'write',
+              'the delay is capped by the sync time in the fsync mode')
+    cg.server:exec(function()
+        local t = require('luatest')
+        local fiber = require('fiber')
+        -- Commits `count` transactions from different fibers, one per
+        -- `interval` seconds, and returns the number of WAL writes.
+        local function commit(count, interval)
+            local stat = box.stat.wal()
+            local fibers = {}
+            for i = 1, count do
+                local f = fiber.new(function()
+                    fiber.sleep(i * interval)
+                    box.space.test:replace{i}
+                end)
+                f:set_joinable(true)
+                table.insert(fibers, f)
+            end
+            for _, f in ipairs(fibers) do
+                t.assert((f:join()))
+            end
+            local new_stat = box.stat.wal()
+            t.assert_equals(new_stat.entries - stat.entries, count)
+            return new_stat.writes - stat.writes
+        end
+        -- Without the delay, each transaction is written separately.
+        t.assert_equals(commit(10, 0.02), 10)
+        -- With the delay, transactions are coalesced until the group
+        -- reaches the min batch size.
+        box.cfg{wal_commit_delay = 10, wal_commit_min_batch = 10}
+        t.assert_equals(commit(10, 0.02), 1)
+        box.cfg{wal_commit_min_batch = 5}
+        t.assert_equals(commit(10, 0.02), 2)
+        -- Without the min batch size, the group waits for the delay.
+        box.cfg{wal_commit_delay = 0.5, wal_commit_min_batch = 0}
+        t.assert_equals(commit(10, 0.02), 1)
+        t.assert_equals(box.space.test:count(), 10)
+    end)
+end
+
+g.test_stat = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local stat = box.stat.wal()
+        box.space.test:replace{1}
+        local new_stat = box.stat.wal()
+        t.assert_equals(new_stat.writes, stat.writes + 1)
+        t.assert_equals(new_stat.entries, stat.entries + 1)
+        t.assert_equals(new_stat.group_size['1'],
+                        (stat.group_size['1'] or 0) + 1)
+        t.assert_ge(new_stat.write_time, stat.write_time)
+        t.assert_gt(new_stat.write_time_avg, 0)
+    end)
+end
+
+-- A failed group sync rolls back all transactions of the group.
+g.test_sync_error = function(cg)
+    t.skip_if(cg.params.wal_mode ~= 'fsync', 'fsync mode only')
+    t.skip_if(not cg.server:exec(function()
+        return pcall(box.error.injection.get, 'ERRINJ_WAL_SYNC_DISK')
+    end), 'error injections are disabled')
+    cg.server:exec(function()
+        local t = require('luatest')
+        box.error.injection.set('ERRINJ_WAL_SYNC_DISK', true)
+        t.assert_error_msg_contains('Failed to write to disk',
+                                    box.space.test.replace,
+                                    box.space.test, {1})
+        box.error.injection.set('ERRINJ_WAL_SYNC_DISK', false)
+        t.assert_equals(box.space.test:select(), {})
+        box.space.test:replace{2}
+        t.assert_equals(box.space.test:select(), {{2}})
+    end)
+end
+
+-- Rows written by a group survive restart.
+g.test_recovery = function(cg)
+    cg.server:exec(function()
+        local fiber = require('fiber')
+        box.cfg{wal_commit_delay = 0.05}
+        local fibers = {}
+        for i = 1, 50 do
+            local f = fiber.new(box.space.test.replace, box.space.test, {i})
+            f:set_joinable(true)
+            table.insert(fibers, f)
+        end
+        for _, f in ipairs(fibers) do
+            f:join()
+        end
+    end)
+    cg.server:stop()
+    cg.server:start()
+    cg.server:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.space.test:count(), 50)
+    end)
+end
@@ -0,0 +1,74 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+
+local g = t.group()
+
+g.before_all = function()
+    g.server = server:new{
+        alias   = 'default',
+        box_cfg = {wal_max_size = 16 * 1024},
+    }
+    g.server:start()
+end
+
+g.after_all = function()
+    g.server:drop()
+end
+
+g.test_recovery = function()
+    g.server:exec(function()
+        local s = box.schema.create_space('test')
+        s:create_index('pk')
+        s:create_index('sk', {parts = {{2, 'string'}}})
+        box.snapshot()
+        for i = 1, 1000 do
+            s:insert{i, tostring(i), string.rep('x', i % 100)}
+        end
+        for i = 1, 100 do
+            box.begin()
+            for j = 1, 10 do
+                s:replace{i * 10 + j, 'tx' .. i .. '_' .. j}
+            end
+            s:delete{i}
+            box.commit()
+        end
+        for i = 1, 1000, 2 do
+            s:update(i, {{'=', 3, 'y'}})
+        end
+    end)
+    local expected = g.server:exec(function()
+        return box.space.test:select()
+    end)
+    t.assert_gt(#g.server:exec(function()
+        return require('fio').glob(box.cfg.wal_dir .. '/*.xlog')
+    end), 2)
+    local is_debug = g.server:exec(function()
+        return pcall(box.error.injection.get, 'ERRINJ_WAL_READER_COUNT')
+    end)
+    local function check(is_thread_used)
+        g.server:exec(function(expected, is_debug, is_thread_used)
+            local t = require('luatest')
+            local s = box.space.test
+            t.assert_equals(s:select(), expected)
+            t.assert_equals(s.index.sk:count(), #expected)
+            if is_debug then
+                -- All WAL files, including the last one, are read
+                -- by reader threads.
+                local count = box.error.injection.get(
+                    'ERRINJ_WAL_READER_COUNT')
+                if is_thread_used then
+                    t.assert_gt(count, 0)
+                else
+                    t.assert_equals(count, 0)
+                end
+            end
+        end, {expected, is_debug, is_thread_used})
+    end
+    g.server:restart()
+    check(true)
+    if is_debug then
+        g.server.env = {ERRINJ_WAL_READER_DISABLE = 'true'}
+        g.server:restart()
+        check(false)
+    end
+end
@@ -0,0 +1,293 @@
+local fio = require('fio')
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local xlog = require('xlog')
+
+local g = t.group('wal_recycle')
+
+g.before_all(function(cg)
+    cg.server = server:new{
+        alias   = 'default',
+        box_cfg = {
+            wal_max_size = 16 * 1024,
+            wal_recycle_segments = 2,
+            wal_cleanup_delay = 0,
+            checkpoint_count = 1,
+        },
+    }
+    cg.server:start()
+    cg.server:exec(function()
+        local s = box.schema.create_space('test')
+        s:create_index('pk')
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.test_cfg = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.cfg.wal_recycle_segments, 2)
+        t.assert_error_msg_contains(
+            "Incorrect value for option 'wal_recycle_segments'",
+            box.cfg, {wal_recycle_segments = -1})
+    end)
+end
+
+-- Garbage collected WAL files are turned into spare files, which
+-- are reused for new WAL files, and data written to reused files
+-- is recovered after restart.
+g.test_recycle = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local fio = require('fio')
+        local function spare_files()
+            return fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog.spare'))
+        end
+        local s = box.space.test
+        local pad = string.rep('x', 1024)
+        for i = 1, 100 do
+            s:replace{i, pad}
+        end
+        box.snapshot()
+        t.helpers.retrying({}, function()
+            t.assert_equals(#spare_files(), 2)
+        end)
+        for i = 101, 200 do
+            s:replace{i, pad}
+        end
+        t.assert_equals(#spare_files(), 0)
+    end)
+    cg.server:stop()
+    cg.server:start()
+    cg.server:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.space.test:count(), 200)
+        t.assert_equals(box.space.test:get(200)[1], 200)
+    end)
+end
+
+-- Extra spare files are removed when the limit is lowered.
+g.test_trim = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local fio = require('fio')
+        local function spare_files()
+            return fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog.spare'))
+        end
+        local s = box.space.test
+        local pad = string.rep('y', 1024)
+        for i = 1, 100 do
+            s:replace{i, pad}
+        end
+        box.snapshot()
+        t.helpers.retrying({}, function()
+            t.assert_equals(#spare_files(), 2)
+        end)
+        box.cfg{wal_recycle_segments = 1}
+        t.assert_equals(#spare_files(), 1)
+        box.cfg{wal_recycle_segments = 0}
+        t.assert_equals(#spare_files(), 0)
+        box.cfg{wal_recycle_segments = 2}
+    end)
+end
+
+-- Damaged recycled WAL files: only a zero-filled tail is treated as
+-- the end of data, any other damage is reported.
+local g_damage = t.group('wal_recycle_damage')
+
+local master_cfg = {
+    wal_max_size = 16 * 1024,
+    wal_recycle_segments = 2,
+    wal_cleanup_delay = 0,
+    checkpoint_count = 1,
+    replication_timeout = 0.1,
+}
+
+local function wait_replica_sync(cg)
+    local vclock = cg.master:get_vclock()
+    vclock[0] = nil
+    cg.replica:wait_vclock(vclock)
+end
+
+g_damage.before_each(function(cg)
+    cg.master = server:new{alias = 'master', box_cfg = master_cfg}
+    cg.master:start()
+    cg.master:exec(function()
+        local t = require('luatest')
+        local fio = require('fio')
+        box.schema.user.grant('guest', 'replication')
+        local s = box.schema.create_space('test')
+        s:create_index('pk')
+        local pad = string.rep('x', 1024)
+        for i = 1, 100 do
+            s:replace{i, pad}
+        end
+        box.snapshot()
+        t.helpers.retrying({}, function()
+            local files = fio.glob(fio.pathjoin(box.cfg.wal_dir,
+                                                '*.xlog.spare'))
+            t.assert_equals(#files, 2)
+        end)
+    end)
+    -- The replica joins after the snapshot so that it doesn't hold
+    -- the files that are turned into spare files.
+    cg.replica = server:new{
+        alias = 'replica',
+        box_cfg = {
+            replication = cg.master.net_box_uri,
+            replication_timeout = 0.1,
+            replication_sync_timeout = 0.1,
+        },
+    }
+    cg.replica:start()
+    wait_replica_sync(cg)
+    cg.replica:stop()
+    -- The rows are written to recycled files and relayed from disk
+    -- when the replica is restarted.
+    cg.master:exec(function()
+        local s = box.space.test
+        local pad = string.rep('x', 1024)
+        for i = 101, 130 do
+            s:replace{i, pad}
+        end
+    end)
+end)
+
+g_damage.after_each(function(cg)
+    cg.replica:drop()
+    cg.master:drop()
+end)
+
+-- Returns the path to the last WAL file, which is a recycled one.
+local function last_xlog(instance)
+    local files = fio.glob(fio.pathjoin(instance.workdir, '*.xlog'))
+    table.sort(files)
+    local path = files[#files]
+    local data = fio.open(path, {'O_RDONLY'}):read(512)
+    t.assert_str_contains(data, 'Preallocated: true')
+    return path
+end
+
+-- Kills the server without letting it finalize the current WAL file.
+local function crash(instance)
+    instance.process:kill('KILL')
+    t.helpers.retrying({}, function()
+        t.assert_not(instance.process:is_alive())
+    end)
+    instance.process = nil
+    if instance.net_box ~= nil then
+        instance.net_box:close()
+        instance.net_box = nil
+    end
+end
+
+-- Overwrites the file contents at the given offset.
+local function overwrite(path, offset, data)
+    local fh = fio.open(path, {'O_RDWR'})
+    fh:pwrite(data, offset)
+    fh:close()
+end
+
+-- Returns the offset of the first transaction in a WAL file.
+local function first_tx_offset(path)
+    local data = fio.open(path, {'O_RDONLY'}):read(512)
+    return data:find('\n\n', 1, true) + 1
+end
+
+-- Returns the offset right after the last written byte of a file.
+local function data_end_offset(path)
+    local data = fio.open(path, {'O_RDONLY'}):read()
+    local pos = #data
+    while pos > 0 and data:byte(pos) == 0 do
+        pos = pos - 1
+    end
+    return pos
+end
+
+-- A transaction torn by a crash is dropped on recovery and erased,
+-- so that rows appended to the file later are recovered and relayed.
+g_damage.test_torn_tx = function(cg)
+    local path = last_xlog(cg.master)
+    crash(cg.master)
+    overwrite(path, data_end_offset(path) - 8, string.rep('\0', 8))
+    local count = 0
+    for _ in xlog.pairs(path) do
+        count = count + 1
+    end
+    t.assert_gt(count, 0)
+
+    cg.master:start()
+    cg.master:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        t.assert_equals(s:count(), 129)
+        t.assert_equals(s:get(130), nil)
+        local pad = string.rep('y', 1024)
+        for i = 130, 135 do
+            s:replace{i, pad}
+        end
+    end)
+    cg.master:restart()
+    cg.master:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.space.test:count(), 135)
+        t.assert_equals(box.space.test:get(135)[2], string.rep('y', 1024))
+    end)
+
+    cg.replica:start()
+    wait_replica_sync(cg)
+    cg.replica:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.space.test:count(), 135)
+        t.assert_equals(box.space.test:get(135)[2], string.rep('y', 1024))
+    end)
+end
+
+-- A corrupted transaction in the middle of a recycled file isn't
+-- mistaken for the end of data.
+g_damage.test_corrupted_tx = function(cg)
+    local path = last_xlog(cg.master)
+    local offset = first_tx_offset(path) + 32
+    overwrite(path, offset, 'garbage')
+
+    -- Relay reads the file from disk.
+    cg.replica:start()
+    cg.replica:exec(function()
+        local t = require('luatest')
+        t.helpers.retrying({}, function()
+            local upstream = box.info.replication[1].upstream
+            t.assert_equals(upstream.status, 'stopped')
+            t.assert_str_contains(upstream.message, 'checksum mismatch')
+        end)
+        t.assert_lt(box.space.test:count(), 130)
+    end)
+    cg.replica:stop()
+
+    t.assert_error_msg_contains('checksum mismatch', function()
+        for _ in xlog.pairs(path) do end
+    end)
+
+    crash(cg.master)
+    cg.master:start({wait_for_readiness = false})
+    t.helpers.retrying({}, function()
+        t.assert(cg.master:grep_log('checksum mismatch', nil, {
+            filename = fio.pathjoin(cg.master.workdir,
+                                               'master.log'),
+        }))
+    end)
+    t.helpers.retrying({}, function()
+        t.assert_not(cg.master.process:is_alive())
+    end)
+    cg.master.process = nil
+
+    cg.master.box_cfg.force_recovery = true
+    cg.master:start()
+    cg.master:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.space.test:get(130)[1], 130)
+        t.assert_lt(box.space.test:count(), 130)
+    end)
+end
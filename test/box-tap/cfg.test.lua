@@ -6,7 +6,7 @@ local socket = require('socket')
 local fio = require('fio')
 local uuid = require('uuid')
 local msgpack = require('msgpack')
-test:plan(109)
+test:plan(115)
 
 --------------------------------------------------------------------------------
 -- Invalid values
@@ -25,6 +25,8 @@ invalid('memtx_min_tuple_size', 0)
 invalid('memtx_min_tuple_size', -1)
 invalid('memtx_min_tuple_size', 1048281)
 invalid('memtx_min_tuple_size', 1000000000)
+invalid('memtx_snap_threads', 0)
+invalid('memtx_snap_threads', 257)
 invalid('replication', '//guest@localhost:3301')
 invalid('replication_timeout', -1)
 invalid('replication_timeout', 0)
@@ -50,6 +52,10 @@ invalid('vinyl_run_size_ratio', 1)
 invalid('vinyl_bloom_fpr', 0)
 invalid('vinyl_bloom_fpr', 1.1)
 invalid('wal_queue_max_size', -1)
+invalid('wal_tail_size', -1)
+invalid('net_compression_level', -1)
+invalid('net_compression_level', 23)
+invalid('net_compression_min_size', -1)
 
 local function invalid_combinations(name, val)
     local status, result = pcall(box.cfg, val)
@@ -0,0 +1,157 @@
+local t = require('luatest')
+local net = require('net.box')
+local cluster = require('test.luatest_helpers.cluster')
+local server = require('test.luatest_helpers.server')
+
+local g = t.group('net_compression')
+
+g.before_all(function(cg)
+    cg.cluster = cluster:new({})
+    cg.master = cg.cluster:build_server({
+        alias = 'master',
+        box_cfg = {
+            replication_timeout = 0.1,
+            net_compression_level = 3,
+        },
+    })
+    cg.replica = cg.cluster:build_server({
+        alias = 'replica',
+        box_cfg = {
+            replication = {server.build_instance_uri('master')},
+            replication_timeout = 0.1,
+            read_only = true,
+        },
+    })
+    cg.cluster:add_server(cg.master)
+    cg.cluster:add_server(cg.replica)
+    cg.cluster:start()
+    cg.master:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+        box.schema.user.grant('guest', 'super')
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.cluster.servers = nil
+    cg.cluster:drop()
+end)
+
+local function fill(cg, first, last)
+    cg.master:exec(function(first, last)
+        local s = box.space.test
+        for i = first, last do
+            -- Mix rows below and above the compression threshold.
+            local size = i % 2 == 0 and 10 or i * 100
+            s:replace{i, string.rep(string.char(65 + i % 26), size)}
+        end
+    end, {first, last})
+end
+
+local function check_replica(cg)
+    local vclock = cg.master:get_vclock()
+    vclock[0] = nil
+    cg.replica:wait_vclock(vclock)
+    local expected = cg.master:exec(function()
+        return box.space.test:select()
+    end)
+    t.assert_equals(cg.replica:exec(function()
+        return box.space.test:select()
+    end), expected)
+end
+
+g.test_invalid_cfg = function(cg)
+    cg.master:exec(function()
+        local t = require('luatest')
+        t.assert_error_msg_contains(
+            "Incorrect value for option 'net_compression_level'",
+            box.cfg, {net_compression_level = 23})
+        t.assert_error_msg_contains(
+            "Incorrect value for option 'net_compression_min_size'",
+            box.cfg, {net_compression_min_size = -1})
+    end)
+end
+
+g.test_net_box = function(cg)
+    fill(cg, 1, 100)
+    local expected = cg.master:exec(function()
+        return box.space.test:select()
+    end)
+    local c = net.connect(cg.master.net_box_uri)
+    t.assert(c.peer_protocol_features.compression)
+    t.assert_equals(c.space.test:select(), expected)
+    for i = 1, 100, 7 do
+        t.assert_equals(c.space.test:get(i), expected[i])
+    end
+    -- Concurrent requests.
+    local futures = {}
+    for i = 1, 10 do
+        futures[i] = c.space.test:select({}, {is_async = true,
+                                              limit = i * 10})
+    end
+    for i = 1, 10 do
+        t.assert_equals(futures[i]:wait_result(),
+                        {unpack(expected, 1, i * 10)})
+    end
+    c:close()
+    -- Compression disabled on the server.
+    cg.master:exec(function() box.cfg{net_compression_level = 0} end)
+    c = net.connect(cg.master.net_box_uri)
+    t.assert_equals(c.space.test:select(), expected)
+    c:close()
+    cg.master:exec(function() box.cfg{net_compression_level = 3} end)
+end
+
+g.test_replication = function(cg)
+    fill(cg, 101, 200)
+    check_replica(cg)
+    -- Rows sent on resubscribe start a new compressed stream.
+    cg.replica:stop()
+    fill(cg, 201, 300)
+    cg.replica:start()
+    check_replica(cg)
+    t.assert_equals(cg.replica:exec(function()
+        return box.info.replication[1].upstream.status
+    end), 'follow')
+end
+
+local function compressed_count(server)
+    local function get()
+        local ok, count = pcall(box.error.injection.get,
+                                'ERRINJ_IPROTO_COMPRESSED_COUNT')
+        return ok and count or nil
+    end
+    if server == nil then
+        return get()
+    end
+    return server:exec(get)
+end
+
+-- Small rows sent at once are compressed into one packet.
+g.test_replication_batch = function(cg)
+    t.skip_if(compressed_count(cg.replica) == nil,
+              'error injections are disabled')
+    check_replica(cg)
+    local count = compressed_count(cg.replica)
+    cg.master:exec(function()
+        box.begin()
+        for i = 1001, 1100 do
+            box.space.test:replace{i, string.rep('x', 10)}
+        end
+        box.commit()
+    end)
+    check_replica(cg)
+    local received = compressed_count(cg.replica) - count
+    t.assert_gt(received, 0)
+    t.assert_lt(received, 10)
+end
+
+g.test_net_box_compressed = function(cg)
+    t.skip_if(compressed_count() == nil, 'error injections are disabled')
+    fill(cg, 1, 100)
+    local count = compressed_count()
+    local c = net.connect(cg.master.net_box_uri)
+    t.assert_equals(#c.space.test:select({}, {limit = 100}), 100)
+    c:close()
+    t.assert_gt(compressed_count(), count)
+end
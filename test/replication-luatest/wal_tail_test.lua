@@ -0,0 +1,92 @@
+local t = require('luatest')
+local cluster = require('test.luatest_helpers.cluster')
+local server = require('test.luatest_helpers.server')
+
+local g = t.group('wal_tail')
+
+g.before_all(function(cg)
+    cg.cluster = cluster:new({})
+    cg.master = cg.cluster:build_server({
+        alias = 'master',
+        box_cfg = {
+            replication_timeout = 0.1,
+            wal_tail_size = 64 * 1024,
+        },
+    })
+    cg.replica = cg.cluster:build_server({
+        alias = 'replica',
+        box_cfg = {
+            replication = {server.build_instance_uri('master')},
+            replication_timeout = 0.1,
+            read_only = true,
+        },
+    })
+    cg.cluster:add_server(cg.master)
+    cg.cluster:add_server(cg.replica)
+    cg.cluster:start()
+    cg.master:exec(function()
+        local s = box.schema.space.create('test')
+        s:create_index('pk')
+    end)
+end)
+
+g.after_all(function(cg)
+    cg.cluster.servers = nil
+    cg.cluster:drop()
+end)
+
+local function fill(cg, first, last, size)
+    cg.master:exec(function(first, last, size)
+        local s = box.space.test
+        for i = first, last do
+            s:replace{i, string.rep('x', size)}
+        end
+    end, {first, last, size})
+end
+
+local function check(cg)
+    local vclock = cg.master:get_vclock()
+    vclock[0] = nil
+    cg.replica:wait_vclock(vclock)
+    local count = cg.master:exec(function() return box.space.test:count() end)
+    t.assert_equals(cg.replica:exec(function()
+        return box.space.test:count()
+    end), count)
+    t.assert_equals(cg.replica:exec(function()
+        return box.info.replication[1].upstream.status
+    end), 'follow')
+end
+
+g.test_invalid_cfg = function(cg)
+    cg.master:exec(function()
+        local t = require('luatest')
+        t.assert_error_msg_contains(
+            "Incorrect value for option 'wal_tail_size'",
+            box.cfg, {wal_tail_size = -1})
+    end)
+end
+
+g.test_replication = function(cg)
+    -- Rows fit in the tail.
+    fill(cg, 1, 100, 10)
+    check(cg)
+    -- Batches larger than the tail are skipped.
+    fill(cg, 101, 110, 100 * 1024)
+    check(cg)
+    -- The relay falls behind the tail while the replica is down.
+    cg.replica:stop()
+    fill(cg, 111, 1000, 1024)
+    cg.replica:start()
+    check(cg)
+    -- The tail is disabled and enabled back.
+    cg.master:exec(function() box.cfg{wal_tail_size = 0} end)
+    fill(cg, 1001, 1100, 10)
+    check(cg)
+    cg.master:exec(function() box.cfg{wal_tail_size = 64 * 1024} end)
+    fill(cg, 1101, 1200, 10)
+    check(cg)
+    -- WAL rotation.
+    cg.master:exec(function() box.snapshot() end)
+    fill(cg, 1201, 1300, 10)
+    check(cg)
+end
@@ -0,0 +1,113 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({alias = 'batch_scan'})
+    g.server:start()
+    g.server:exec(function()
+        box.execute([[CREATE TABLE t(i INT PRIMARY KEY, a INT, b INT,
+                                     d DOUBLE, s STRING COLLATE "unicode_ci",
+                                     c INT);]])
+        box.execute([[CREATE INDEX tc ON t(c);]])
+        box.begin()
+        for i = 1, 3000 do
+            box.execute([[INSERT INTO t VALUES(?, ?, ?, ?, ?, ?);]],
+                        {i, i % 7 ~= 0 and i % 100 or nil, i % 50,
+                         i % 4 + (i % 3) * 0.5,
+                         (i % 2 == 0 and 'k' or 'K') .. i % 9, i % 10})
+        end
+        box.commit()
+    end)
+end)
+
+g.after_all(function()
+    g.server:exec(function()
+        box.execute([[DROP TABLE t;]])
+    end)
+    g.server:stop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        box.session.settings.sql_vdbe_batch = true
+    end)
+end)
+
+g.test_batch_scan = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local queries = {
+            {[[SELECT sum(a), count(*), count(a) FROM t;]]},
+            {[[SELECT sum(a), min(b), max(d) FROM t WHERE b > ?;]], {25}},
+            {[[SELECT avg(a), total(d) FROM t WHERE ? <= b AND a <> 3;]],
+             {10}},
+            {[[SELECT min(s), max(s), count(*) FROM t WHERE s = 'k1';]]},
+            {[[SELECT count(*) FROM t WHERE d < -1.5;]]},
+            {[[SELECT sum(a) FROM t WHERE b = ?;]], {box.NULL}},
+        }
+        for _, q in ipairs(queries) do
+            local sql, args = q[1], q[2]
+            local plan = box.execute('EXPLAIN QUERY PLAN ' .. sql, args).rows
+            t.assert_equals(plan[1][4], 'SCAN TABLE T IN BATCHES', sql)
+            local res = box.execute(sql, args).rows
+
+            box.session.settings.sql_vdbe_batch = false
+            plan = box.execute('EXPLAIN QUERY PLAN ' .. sql, args).rows
+            t.assert_not_equals(plan[1][4], 'SCAN TABLE T IN BATCHES', sql)
+            t.assert_equals(box.execute(sql, args).rows, res, sql)
+            box.session.settings.sql_vdbe_batch = true
+        end
+    end)
+end)
+
+g.test_batch_scan_unsupported = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local queries = {
+            -- The filter can use an index.
+            [[SELECT sum(a) FROM t WHERE c = 1;]],
+            -- min() of an indexed column.
+            [[SELECT min(i) FROM t;]],
+            -- DISTINCT aggregate.
+            [[SELECT count(DISTINCT a) FROM t;]],
+            -- Not a plain comparison of a column with a value.
+            [[SELECT sum(a) FROM t WHERE a + 1 > 2;]],
+            [[SELECT sum(a) FROM t WHERE a > 2 OR b > 2;]],
+            -- Aggregate of an expression.
+            [[SELECT sum(a + b) FROM t;]],
+            -- GROUP BY.
+            [[SELECT b, sum(a) FROM t GROUP BY b;]],
+        }
+        for _, sql in ipairs(queries) do
+            local plan = box.execute('EXPLAIN QUERY PLAN ' .. sql).rows
+            for _, row in ipairs(plan) do
+                t.assert_not_equals(row[4], 'SCAN TABLE T IN BATCHES', sql)
+            end
+        end
+    end)
+end)
+
+g.test_batch_scan_errors = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        box.execute([[CREATE TABLE t1(i INT PRIMARY KEY, a INT, s STRING);]])
+        box.execute([[INSERT INTO t1 VALUES(1, 9223372036854775807, 'a'),
+                                           (2, 1, 'b');]])
+        local queries = {
+            {[[SELECT sum(a) FROM t1;]]},
+            {[[SELECT count(*) FROM t1 WHERE s > ?;]], {1}},
+            {[[SELECT sum(s) FROM t1;]]},
+        }
+        for _, q in ipairs(queries) do
+            local sql, args = q[1], q[2]
+            local _, err = box.execute(sql, args)
+            t.assert(err ~= nil, sql)
+            box.session.settings.sql_vdbe_batch = false
+            local _, err2 = box.execute(sql, args)
+            t.assert_equals(err.message, err2.message, sql)
+            box.session.settings.sql_vdbe_batch = true
+        end
+        box.execute([[DROP TABLE t1;]])
+    end)
+end)
@@ -0,0 +1,121 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({alias = 'hash_agg'})
+    g.server:start()
+    g.server:exec(function()
+        box.execute([[CREATE TABLE t(i INT PRIMARY KEY, a INT, d DOUBLE,
+                                     s STRING COLLATE "unicode_ci");]])
+        for i = 1, 100 do
+            box.execute([[INSERT INTO t VALUES(?, ?, ?, ?);]],
+                        {i, i % 10, i % 4 + (i % 3) * 0.5,
+                         (i % 2 == 0 and 'k' or 'K') .. i % 7})
+        end
+        box.execute([[INSERT INTO t VALUES(101, NULL, NULL, NULL);]])
+        box.execute([[INSERT INTO t VALUES(102, NULL, 1, NULL);]])
+    end)
+end)
+
+g.after_all(function()
+    g.server:exec(function()
+        box.execute([[DROP TABLE t;]])
+    end)
+    g.server:stop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        box.cfg{sql_hash_agg_memory = 64 * 1024 * 1024}
+    end)
+end)
+
+g.test_hash_agg = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local queries = {
+            [[SELECT a, count(*), sum(i), min(i) FROM t GROUP BY a;]],
+            [[SELECT d, count(*), avg(i) FROM t GROUP BY d;]],
+            [[SELECT upper(s), a, max(i), total(d) FROM t GROUP BY s, a;]],
+            [[SELECT a, sum(i) FROM t WHERE i > 20 GROUP BY a
+              HAVING sum(i) > 400 ORDER BY a DESC;]],
+            [[SELECT a, i % 3 AS b, count(*) FROM t GROUP BY a, b
+              LIMIT 5;]],
+        }
+        for _, sql in ipairs(queries) do
+            local plan = box.execute('EXPLAIN QUERY PLAN ' .. sql).rows
+            local uses_hash = false
+            for _, row in ipairs(plan) do
+                if row[4] == 'USE HASH TABLE FOR GROUP BY' then
+                    uses_hash = true
+                end
+            end
+            t.assert(uses_hash, sql)
+            local res = box.execute(sql).rows
+            t.assert(#res > 0, sql)
+
+            box.cfg{sql_hash_agg_memory = 0}
+            plan = box.execute('EXPLAIN QUERY PLAN ' .. sql).rows
+            for _, row in ipairs(plan) do
+                t.assert_not(row[4]:find('HASH TABLE'), sql)
+            end
+            t.assert_equals(box.execute(sql).rows, res, sql)
+            box.cfg{sql_hash_agg_memory = 64 * 1024 * 1024}
+        end
+    end)
+end
+
+g.test_hash_agg_not_used = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local queries = {
+            -- DISTINCT aggregates.
+            [[SELECT a, count(DISTINCT s) FROM t GROUP BY a;]],
+            -- Values that may have several encodings.
+            [[SELECT CAST(d AS NUMBER), count(*) FROM t
+              GROUP BY CAST(d AS NUMBER);]],
+        }
+        for _, sql in ipairs(queries) do
+            local plan = box.execute('EXPLAIN QUERY PLAN ' .. sql).rows
+            for _, row in ipairs(plan) do
+                t.assert_not(row[4]:find('HASH TABLE'), sql)
+            end
+        end
+    end)
+end
+
+g.test_hash_agg_spill = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local sql = [[SELECT upper(s), a, count(*), sum(i) FROM t
+                      GROUP BY s, a;]]
+        local expected = box.execute(sql).rows
+        -- Rows of new groups are passed to the sorter if the limit
+        -- is exceeded after the statement was prepared.
+        local stmt = box.prepare(sql)
+        box.cfg{sql_hash_agg_memory = 1}
+        t.assert_equals(stmt:execute().rows, expected)
+        box.cfg{sql_hash_agg_memory = 1024}
+        t.assert_equals(stmt:execute().rows, expected)
+        stmt:unprepare()
+        -- The limit is also checked when the statement is prepared.
+        box.cfg{sql_hash_agg_memory = 1}
+        local plan = box.execute('EXPLAIN QUERY PLAN ' .. sql).rows
+        for _, row in ipairs(plan) do
+            t.assert_not(row[4]:find('HASH TABLE'))
+        end
+        t.assert_equals(box.execute(sql).rows, expected)
+    end)
+end
+
+g.test_hash_agg_memory_cfg = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.cfg.sql_hash_agg_memory, 64 * 1024 * 1024)
+        t.assert_error_msg_content_equals(
+            "Incorrect value for option 'sql_hash_agg_memory': " ..
+            "must be non-negative",
+            box.cfg, {sql_hash_agg_memory = -1})
+    end)
+end
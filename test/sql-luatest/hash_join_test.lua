@@ -0,0 +1,105 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({alias = 'hash_join'})
+    g.server:start()
+    g.server:exec(function()
+        box.execute([[CREATE TABLE t1(i INT PRIMARY KEY, a INT,
+                                      s STRING COLLATE "unicode_ci");]])
+        box.execute([[CREATE TABLE t2(i INT PRIMARY KEY, b INT, d DOUBLE,
+                                      s STRING COLLATE "unicode_ci");]])
+        for i = 1, 100 do
+            box.execute([[INSERT INTO t1 VALUES(?, ?, ?);]],
+                        {i, i % 10, 'k' .. i % 7})
+            box.execute([[INSERT INTO t2 VALUES(?, ?, ?, ?);]],
+                        {i, i % 20, i % 20 + (i % 2) * 0.5,
+                         'K' .. i % 5})
+        end
+        box.execute([[INSERT INTO t1 VALUES(101, NULL, NULL);]])
+        box.execute([[INSERT INTO t2 VALUES(101, NULL, NULL, NULL);]])
+    end)
+end)
+
+g.after_all(function()
+    g.server:exec(function()
+        box.execute([[DROP TABLE t1;]])
+        box.execute([[DROP TABLE t2;]])
+    end)
+    g.server:stop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        box.cfg{sql_hash_join_memory = 64 * 1024 * 1024}
+    end)
+end)
+
+g.test_hash_join = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local queries = {
+            [[SELECT t1.i, t2.i FROM t1, t2 WHERE a = b ORDER BY 1, 2;]],
+            [[SELECT t1.i, t2.i FROM t1 JOIN t2 ON t1.s = t2.s
+              ORDER BY 1, 2;]],
+            [[SELECT t1.i, t2.i FROM t1, t2 WHERE a = d ORDER BY 1, 2;]],
+            [[SELECT t1.i, t2.i FROM t1 LEFT JOIN t2 ON a = b AND b > 5
+              ORDER BY 1, 2;]],
+            [[SELECT t1.i, t2.i FROM t1, t2 WHERE a = b AND t1.s = t2.s
+              ORDER BY 1, 2;]],
+        }
+        for _, sql in ipairs(queries) do
+            local plan = box.execute('EXPLAIN QUERY PLAN ' .. sql).rows
+            local uses_hash_join = false
+            for _, row in ipairs(plan) do
+                if row[4]:find('USING HASH JOIN') then
+                    uses_hash_join = true
+                end
+            end
+            t.assert(uses_hash_join, sql)
+            local res = box.execute(sql).rows
+            t.assert(#res > 0, sql)
+
+            box.cfg{sql_hash_join_memory = 0}
+            plan = box.execute('EXPLAIN QUERY PLAN ' .. sql).rows
+            for _, row in ipairs(plan) do
+                t.assert_not(row[4]:find('HASH JOIN'), sql)
+            end
+            t.assert_equals(box.execute(sql).rows, res, sql)
+            box.cfg{sql_hash_join_memory = 64 * 1024 * 1024}
+        end
+    end)
+end
+
+g.test_hash_join_spill = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local sql = [[SELECT t1.i, t2.i FROM t1, t2 WHERE a = b
+                      ORDER BY 1, 2;]]
+        local expected = box.execute(sql).rows
+        -- Rows are moved to an ephemeral index if the limit is
+        -- exceeded after the statement was prepared.
+        local stmt = box.prepare(sql)
+        box.cfg{sql_hash_join_memory = 1}
+        t.assert_equals(stmt:execute().rows, expected)
+        stmt:unprepare()
+        -- The limit is also checked when the statement is prepared.
+        local plan = box.execute('EXPLAIN QUERY PLAN ' .. sql).rows
+        for _, row in ipairs(plan) do
+            t.assert_not(row[4]:find('HASH JOIN'))
+        end
+        t.assert_equals(box.execute(sql).rows, expected)
+    end)
+end
+
+g.test_hash_join_memory_cfg = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.cfg.sql_hash_join_memory, 64 * 1024 * 1024)
+        t.assert_error_msg_content_equals(
+            "Incorrect value for option 'sql_hash_join_memory': " ..
+            "must be non-negative",
+            box.cfg, {sql_hash_join_memory = -1})
+    end)
+end
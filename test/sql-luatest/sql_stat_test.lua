@@ -0,0 +1,191 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({alias = 'sql_stat'})
+    g.server:start()
+    g.server:exec(function()
+        box.execute([[CREATE TABLE t(i INT PRIMARY KEY, a INT, b INT);]])
+        box.execute([[CREATE INDEX ta ON t(a);]])
+        box.execute([[CREATE INDEX tb ON t(b);]])
+        box.begin()
+        for i = 1, 1000 do
+            box.execute([[INSERT INTO t VALUES(?, ?, ?);]],
+                        {i, i % 5 ~= 0 and i % 2 or nil, i % 500})
+        end
+        box.commit()
+    end)
+end)
+
+g.after_all(function()
+    g.server:exec(function()
+        box.execute([[DROP TABLE t;]])
+    end)
+    g.server:stop()
+end)
+
+g.after_each(function()
+    g.server:exec(function()
+        box.cfg{sql_stat_refresh_ratio = 0}
+    end)
+end)
+
+g.test_collect = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.T
+        local stat = box.internal.sql_stat_collect(s.id, s.index.TA.id)
+        t.assert_equals(stat[1], s.id)
+        t.assert_equals(stat[2], s.index.TA.id)
+        -- NULL, 0 and 1.
+        t.assert_equals(stat[3].tuple_stat1, {1000, 334})
+        -- NULL keys get a sample of their own.
+        local samples = stat[3].samples
+        t.assert(samples[1].key[1] == nil)
+        t.assert_equals(samples[1].eq, {200})
+        t.assert_equals(samples[1].lt, {0})
+        t.assert_equals(samples[1].dlt, {0})
+        for i = 2, #samples do
+            t.assert(samples[i - 1].key[1] == nil or
+                     samples[i].key[1] > samples[i - 1].key[1])
+            t.assert_equals(samples[i].eq, {400})
+        end
+
+        stat = box.internal.sql_stat_collect(s.id, s.index.TB.id)
+        t.assert_equals(stat[3].tuple_stat1, {1000, 2})
+        t.assert(#stat[3].samples > 1)
+
+        -- The planner prefers the more selective index.
+        local sql = [[SELECT i FROM t WHERE a = 1 AND b = 7;]]
+        local plan = box.execute('EXPLAIN QUERY PLAN ' .. sql).rows
+        t.assert_str_contains(plan[1][4], 'INDEX TB')
+        t.assert_equals(box.execute(sql).rows, {{7}, {507}})
+
+        -- Statistics can be stored and loaded back.
+        box.internal.sql_stat_load(stat)
+        t.assert_error_msg_content_equals(
+            'Invalid MsgPack - SQL statistics',
+            box.internal.sql_stat_load,
+            box.tuple.new{s.id, s.index.TB.id, {tuple_stat1 = {1000}}})
+    end)
+end
+
+g.test_refresh = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        box.execute([[CREATE TABLE u(i INT PRIMARY KEY);]])
+        for i = 1, 100 do
+            box.execute([[INSERT INTO u VALUES(?);]], {i})
+        end
+        box.cfg{sql_stat_refresh_ratio = 0.5}
+        local s = box.space.U
+        local function row_count()
+            local stat = box.space._sql_stat:get{s.id, 0}
+            return stat and stat[3].tuple_stat1[1]
+        end
+        t.helpers.retrying({}, function()
+            t.assert_equals(row_count(), 100)
+        end)
+        for i = 101, 200 do
+            box.execute([[INSERT INTO u VALUES(?);]], {i})
+        end
+        t.helpers.retrying({}, function()
+            t.assert_equals(row_count(), 200)
+        end)
+        -- Statistics can be stored manually.
+        local space = box.space.T
+        for _, name in ipairs({'TA', 'TB'}) do
+            box.space._sql_stat:replace(box.internal.sql_stat_collect(
+                space.id, space.index[name].id))
+        end
+    end)
+    -- Statistics persist across restart.
+    g.server:restart()
+    g.server:exec(function()
+        local t = require('luatest')
+        local sql = [[SELECT i FROM t WHERE a = 1 AND b = 7;]]
+        local plan = box.execute('EXPLAIN QUERY PLAN ' .. sql).rows
+        t.assert_str_contains(plan[1][4], 'INDEX TB')
+        -- Statistics of dropped tables are deleted.
+        local id = box.space.U.id
+        box.execute([[DROP TABLE u;]])
+        box.cfg{sql_stat_refresh_ratio = 0.5}
+        t.helpers.retrying({}, function()
+            t.assert_equals(box.space._sql_stat:get{id, 0}, nil)
+        end)
+    end)
+end
+
+g.test_errors = function()
+    g.server:exec(function()
+        local t = require('luatest')
+        local s = box.schema.space.create('h')
+        s:create_index('pk', {type = 'hash'})
+        t.assert_error_msg_content_equals(
+            'HASH does not support SQL statistics',
+            box.internal.sql_stat_collect, s.id, 0)
+        s:drop()
+        t.assert_error_msg_content_equals(
+            "Incorrect value for option 'sql_stat_refresh_ratio': " ..
+            "must be non-negative",
+            box.cfg, {sql_stat_refresh_ratio = -1})
+    end)
+end
+
+local g_old = t.group('sql_stat_old_schema')
+
+g_old.before_all(function(cg)
+    -- The schema isn't upgraded automatically in read-only mode.
+    cg.server = server:new({alias = 'old_schema',
+                            datadir = 'test/box-luatest/upgrade/2.9.1',
+                            box_cfg = {read_only = true}})
+    cg.server:start()
+end)
+
+g_old.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g_old.test_old_schema = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.space._sql_stat, nil)
+        box.cfg{read_only = false}
+        box.execute([[CREATE TABLE t(i INT PRIMARY KEY, a INT, b INT);]])
+        box.execute([[CREATE INDEX ta ON t(a);]])
+        box.execute([[CREATE INDEX tb ON t(b);]])
+        box.begin()
+        for i = 1, 1000 do
+            box.execute([[INSERT INTO t VALUES(?, ?, ?);]],
+                        {i, i % 2, i % 500})
+        end
+        box.commit()
+        box.cfg{sql_stat_refresh_ratio = 0.5}
+        -- Statistics are used by the planner without being stored.
+        local sql = [[SELECT i FROM t WHERE a = 1 AND b = 7;]]
+        t.helpers.retrying({}, function()
+            local plan = box.execute('EXPLAIN QUERY PLAN ' .. sql).rows
+            t.assert_str_contains(plan[1][4], 'INDEX TB')
+        end)
+    end)
+    t.assert(cg.server:grep_log('the _sql_stat space is missing'))
+    cg.server:exec(function()
+        local t = require('luatest')
+        box.schema.upgrade()
+        local s = box.space.T
+        t.assert_equals(box.space._sql_stat.id, box.schema.SQL_STAT_ID)
+        t.assert_equals(box.space._sql_stat:select(), {})
+        box.begin()
+        for i = 1001, 2000 do
+            box.execute([[INSERT INTO t VALUES(?, ?, ?);]],
+                        {i, i % 2, i % 500})
+        end
+        box.commit()
+        t.helpers.retrying({}, function()
+            local stat = box.space._sql_stat:get{s.id, 0}
+            t.assert(stat ~= nil)
+            t.assert_equals(stat[3].tuple_stat1[1], 2000)
+        end)
+    end)
+end
@@ -7,6 +7,10 @@ test:plan(8)
 -- script is testing ephemeral index creation logic.
 --
 
+-- Hash joins are used instead of ephemeral indexes when they fit
+-- in memory.
+box.cfg{sql_hash_join_memory = 0}
+
 test:execsql([[
     CREATE TABLE t1(a INT, b INT PRIMARY KEY);
     INSERT INTO t1 VALUES(1, 11);
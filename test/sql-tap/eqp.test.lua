@@ -99,7 +99,7 @@ test:do_eqp_test(
     ]], {
         -- <1.6>
         {0, 0, 0, "SCAN TABLE T3 (~1048576 rows)"},
-        {0, 0, 0, "USE TEMP B-TREE FOR GROUP BY"},
+        {0, 0, 0, "USE HASH TABLE FOR GROUP BY"},
         {0, 0, 0, "USE TEMP B-TREE FOR DISTINCT"},
 
         -- </1.6>
@@ -187,7 +187,7 @@ test:do_execsql_test(
 
 test:do_eqp_test("2.2.1", "SELECT DISTINCT min(x), max(x) FROM t1 GROUP BY x ORDER BY 1", {
     {0, 0, 0, "SCAN TABLE T1 (~1048576 rows)"},
-    {0, 0, 0, "USE TEMP B-TREE FOR GROUP BY"},
+    {0, 0, 0, "USE HASH TABLE FOR GROUP BY"},
     {0, 0, 0, "USE TEMP B-TREE FOR DISTINCT"},
     {0, 0, 0, "USE TEMP B-TREE FOR ORDER BY"},
 })
@@ -226,7 +226,7 @@ test:do_eqp_test("2.3.2", "SELECT min(x) FROM t2", {
     {0, 0, 0, "SEARCH TABLE T2 USING COVERING INDEX T2I1 (~1048576 rows)"},
 })
 test:do_eqp_test("2.3.3", "SELECT min(x), max(x) FROM t2", {
-    {0, 0, 0, "SCAN TABLE T2 (~1048576 rows)"},
+    {0, 0, 0, "SCAN TABLE T2 IN BATCHES"},
 })
 test:do_eqp_test("2.4.1", "SELECT * FROM t1 WHERE idt1=?", {
     {0, 0, 0, "SEARCH TABLE T1 USING PRIMARY KEY (IDT1=?) (~1 row)"},
@@ -647,7 +647,7 @@ test:do_eqp_test("5.10", [[
 ]], {
     {1, 0, 0, "SCAN TABLE T1 USING COVERING INDEX I1 (~1048576 rows)"},
     {0, 0, 0, "SCAN SUBQUERY 1 (~1 row)"},
-    {0, 0, 0, "USE TEMP B-TREE FOR GROUP BY"},
+    {0, 0, 0, "USE HASH TABLE FOR GROUP BY"},
 })
 -- EVIDENCE-OF: R-46219-33846 sql> EXPLAIN QUERY PLAN
 -- SELECT * FROM (SELECT * FROM t2 WHERE c=1), t1;
@@ -1,6 +1,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #include <inttypes.h>
 #include <time.h>
 
@@ -115,6 +116,21 @@ static int compare_key(const elem_t &a, long b)
 #define bps_tree_key_t uint32_t
 #define bps_tree_arg_t int
 #include "salad/bps_tree.h"
+#undef BPS_TREE_NAME
+#undef BPS_TREE_COMPARE
+#undef BPS_TREE_COMPARE_KEY
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
+
+/* tree for offset test */
+#define BPS_TREE_NAME card
+#define BPS_TREE_COMPARE(a, b, arg) compare(a, b)
+#define BPS_TREE_COMPARE_KEY(a, b, arg) compare(a, b)
+#define bps_tree_elem_t type_t
+#define bps_tree_key_t type_t
+#define BPS_INNER_CARD
+#include "salad/bps_tree.h"
+#undef BPS_INNER_CARD
 
 #define bps_insert_and_check(tree_name, tree, elem, replaced) \
 {\
@@ -901,6 +917,105 @@ insert_successor_test()
 	footer();
 }
 
+/**
+ * Check the offset API against a plain bitmap of present values.
+ * The tree with BPS_INNER_CARD and the one without it must agree.
+ */
+#define offset_check_tree(tree_name, tree, present, max_value) do {\
+	size_t expected = 0;\
+	for (type_t v = 0; v < (max_value); v++) {\
+		size_t lower, upper;\
+		bool exact;\
+		tree_name##_iterator itr = tree_name##_lower_bound_get_offset(\
+			(tree), v, &exact, &lower);\
+		fail_unless(lower == expected);\
+		fail_unless(exact == (present)[v]);\
+		tree_name##_iterator at = tree_name##_iterator_at((tree),\
+								  lower);\
+		fail_unless(tree_name##_iterator_are_equal((tree), &itr, &at));\
+		if ((present)[v]) {\
+			fail_unless(*tree_name##_iterator_get_elem((tree),\
+								   &at) == v);\
+			expected++;\
+		}\
+		tree_name##_upper_bound_get_offset((tree), v, &exact, &upper);\
+		fail_unless(upper == expected);\
+		fail_unless(exact == (present)[v]);\
+	}\
+	fail_unless(expected == tree_name##_size(tree));\
+	tree_name##_iterator itr = tree_name##_iterator_at((tree), expected);\
+	fail_unless(tree_name##_iterator_is_invalid(&itr));\
+} while (0)
+
+static void
+offset_test()
+{
+	header();
+	srand(0);
+
+	const type_t max_value = 2000;
+	bool present[max_value];
+	memset(present, 0, sizeof(present));
+
+	card tree;
+	card_create(&tree, 0, extent_alloc, extent_free, &extents_count);
+	test plain_tree;
+	test_create(&plain_tree, 0, extent_alloc, extent_free, &extents_count);
+	offset_check_tree(card, &tree, present, max_value);
+
+	for (int i = 0; i < 40000; i++) {
+		/* Grow the tree during the first half, shrink after. */
+		bool insert = rand() % 4 != 0;
+		if (i >= 20000)
+			insert = !insert;
+		type_t v = rand() % max_value;
+		if (insert) {
+			card_insert(&tree, v, NULL, NULL);
+			test_insert(&plain_tree, v, NULL, NULL);
+		} else {
+			card_delete(&tree, v);
+			test_delete(&plain_tree, v);
+		}
+		present[v] = insert;
+		if (card_debug_check(&tree)) {
+			card_print(&tree, TYPE_F);
+			fail("debug check nonzero", "true");
+		}
+		if (i % 1000 == 0) {
+			offset_check_tree(card, &tree, present, max_value);
+			offset_check_tree(test, &plain_tree, present,
+					  max_value);
+		}
+	}
+	offset_check_tree(card, &tree, present, max_value);
+	offset_check_tree(test, &plain_tree, present, max_value);
+	test_destroy(&plain_tree);
+	card_destroy(&tree);
+
+	type_t arr[max_value];
+	for (type_t i = 0; i < max_value; i++)
+		arr[i] = i * 2;
+	for (type_t i = 0; i < max_value; i += 99) {
+		card_create(&tree, 0, extent_alloc, extent_free,
+			    &extents_count);
+		if (card_build(&tree, arr, i))
+			fail("building failed", "true");
+		if (card_debug_check(&tree))
+			fail("debug check nonzero", "true");
+		for (type_t j = 0; j < i; j++) {
+			card_iterator itr = card_iterator_at(&tree, j);
+			fail_unless(*card_iterator_get_elem(&tree, &itr) ==
+				    j * 2);
+		}
+		card_destroy(&tree);
+	}
+
+	int res = card_debug_check_internal_functions(false);
+	if (res)
+		printf("self test returned error %d\n", res);
+
+	footer();
+}
 
 int
 main(void)
@@ -918,4 +1033,5 @@ main(void)
 	insert_get_iterator();
 	delete_value_check();
 	insert_successor_test();
+	offset_test();
 }
@@ -0,0 +1,118 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hdr_histogram.h"
+#include "unit.h"
+#include "trivia/util.h"
+
+static uint64_t
+gen_value(void)
+{
+	/* Cover all orders of magnitude evenly. */
+	int bits = rand() % (HDR_HISTOGRAM_MAX_BITS + 4);
+	uint64_t value = ((uint64_t)rand() << 32) | (uint64_t)rand();
+	return bits == 0 ? 0 : value >> (64 - bits);
+}
+
+static void
+test_buckets(void)
+{
+	header();
+
+	for (int b = 0; b < HDR_HISTOGRAM_BUCKET_COUNT - 1; b++) {
+		uint64_t max = hdr_histogram_bucket_max(b);
+		fail_if(hdr_histogram_bucket(max) != b);
+		fail_if(hdr_histogram_bucket(max + 1) != b + 1);
+	}
+	fail_if(hdr_histogram_bucket(UINT64_MAX) !=
+		HDR_HISTOGRAM_BUCKET_COUNT - 1);
+	for (int i = 0; i < 10000; i++) {
+		uint64_t value = gen_value();
+		int b = hdr_histogram_bucket(value);
+		uint64_t max = hdr_histogram_bucket_max(b);
+		uint64_t min = b > 0 ? hdr_histogram_bucket_max(b - 1) + 1 : 0;
+		fail_if(value < min || value > max);
+		/* Check the relative error bound. */
+		if (b < HDR_HISTOGRAM_BUCKET_COUNT - 1)
+			fail_if((max - min) * HDR_HISTOGRAM_SUB_COUNT > min);
+	}
+
+	footer();
+}
+
+static void
+test_collect_merge(void)
+{
+	header();
+
+	struct hdr_histogram hist1, hist2, total;
+	hdr_histogram_create(&hist1);
+	hdr_histogram_create(&hist2);
+	hdr_histogram_create(&total);
+	uint64_t sum = 0, max = 0;
+	size_t count = 1000 + rand() % 1000;
+	for (size_t i = 0; i < count; i++) {
+		uint64_t value = gen_value() % 1000000;
+		hdr_histogram_collect(i % 2 == 0 ? &hist1 : &hist2, value);
+		hdr_histogram_collect(&total, value);
+		sum += value;
+		max = MAX(max, value);
+	}
+	hdr_histogram_merge(&hist1, &hist2);
+	fail_if(memcmp(&hist1, &total, sizeof(total)) != 0);
+	fail_if(total.count != count);
+	fail_if(total.sum != sum);
+	fail_if(total.max != max);
+
+	hdr_histogram_reset(&total);
+	fail_if(total.count != 0);
+	fail_if(hdr_histogram_percentile(&total, 50) != 0);
+
+	footer();
+}
+
+static int
+uint64_cmp(const void *p1, const void *p2)
+{
+	uint64_t v1 = *(uint64_t *)p1;
+	uint64_t v2 = *(uint64_t *)p2;
+	return v1 < v2 ? -1 : v1 > v2;
+}
+
+static void
+test_percentile(void)
+{
+	header();
+
+	size_t count = 1000 + rand() % 1000;
+	uint64_t *data = calloc(count, sizeof(*data));
+	struct hdr_histogram hist;
+	hdr_histogram_create(&hist);
+	for (size_t i = 0; i < count; i++) {
+		data[i] = gen_value() % 1000000;
+		hdr_histogram_collect(&hist, data[i]);
+	}
+	qsort(data, count, sizeof(*data), uint64_cmp);
+	for (int pct = 1; pct <= 100; pct++) {
+		uint64_t value = data[(count * pct + 99) / 100 - 1];
+		int b = hdr_histogram_bucket(value);
+		uint64_t expected = MIN(hdr_histogram_bucket_max(b),
+					data[count - 1]);
+		fail_if(hdr_histogram_percentile(&hist, pct) != expected);
+	}
+	fail_if(hdr_histogram_percentile(&hist, 100) != data[count - 1]);
+	free(data);
+
+	footer();
+}
+
+int
+main()
+{
+	srand(time(NULL));
+	test_buckets();
+	test_collect_merge();
+	test_percentile();
+}
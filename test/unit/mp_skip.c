@@ -0,0 +1,257 @@
+#include "mp_skip.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "msgpuck.h"
+#include "trivia/util.h"
+#include "unit.h"
+
+enum {
+	/** Size of the test buffer, enough for any encoded sequence. */
+	BUF_SIZE = 64 * 1024,
+	/** Max number of values in a generated sequence. */
+	MAX_VALUE_COUNT = 200,
+	/** Number of random sequences to check. */
+	SEQUENCE_COUNT = 1000,
+};
+
+/**
+ * The buffer is aligned and followed by enough slack for the
+ * vectorized implementations to read the whole last block.
+ */
+static char buf[BUF_SIZE + 64] __attribute__((aligned(64)));
+
+/**
+ * Check that mp_skip() skips the same values as mp_next() for
+ * every prefix of the first @a count values encoded at @a data.
+ * Returns the number of mismatches.
+ */
+static int
+check_skip(const char *data, uint32_t count)
+{
+	int fail_count = 0;
+	const char *expected = data;
+	for (uint32_t i = 0; i <= count; i++) {
+		const char *pos = data;
+		mp_skip(&pos, i);
+		if (pos != expected)
+			fail_count++;
+		if (i < count)
+			mp_next(&expected);
+	}
+	return fail_count;
+}
+
+static char *
+encode_str(char *data, uint32_t len)
+{
+	data = mp_encode_strl(data, len);
+	memset(data, 'x', len);
+	return data + len;
+}
+
+static char *
+encode_bin(char *data, uint32_t len)
+{
+	data = mp_encode_binl(data, len);
+	memset(data, 0xc3, len);
+	return data + len;
+}
+
+static char *
+encode_ext(char *data, uint32_t len)
+{
+	data = mp_encode_extl(data, 1, len);
+	memset(data, 0xc0, len);
+	return data + len;
+}
+
+/** Encode a sample value of each kind, see test_types(). */
+static char *
+encode_sample(char *data, int kind)
+{
+	switch (kind) {
+	case 0: return mp_encode_nil(data);
+	case 1: return mp_encode_bool(data, false);
+	case 2: return mp_encode_bool(data, true);
+	case 3: return mp_encode_uint(data, 0);
+	case 4: return mp_encode_uint(data, 127);
+	case 5: return mp_encode_int(data, -1);
+	case 6: return mp_encode_int(data, -32);
+	case 7: return mp_encode_uint(data, UINT8_MAX);
+	case 8: return mp_encode_uint(data, UINT16_MAX);
+	case 9: return mp_encode_uint(data, UINT32_MAX);
+	case 10: return mp_encode_uint(data, UINT64_MAX);
+	case 11: return mp_encode_int(data, INT8_MIN);
+	case 12: return mp_encode_int(data, INT16_MIN);
+	case 13: return mp_encode_int(data, INT32_MIN);
+	case 14: return mp_encode_int(data, INT64_MIN);
+	case 15: return mp_encode_float(data, 1.5);
+	case 16: return mp_encode_double(data, 1.5);
+	case 17: return encode_str(data, 0);
+	case 18: return encode_str(data, 31);
+	case 19: return encode_str(data, 32);
+	case 20: return encode_str(data, UINT8_MAX + 1);
+	case 21: return encode_str(data, UINT16_MAX + 1);
+	case 22: return encode_bin(data, 0);
+	case 23: return encode_bin(data, UINT8_MAX + 1);
+	case 24: return encode_bin(data, UINT16_MAX / 2);
+	case 25: return encode_ext(data, 1);
+	case 26: return encode_ext(data, 2);
+	case 27: return encode_ext(data, 4);
+	case 28: return encode_ext(data, 8);
+	case 29: return encode_ext(data, 16);
+	case 30: return encode_ext(data, 3);
+	case 31: return encode_ext(data, UINT8_MAX + 1);
+	case 32:
+		data = mp_encode_array(data, 3);
+		data = mp_encode_uint(data, 1);
+		data = mp_encode_nil(data);
+		return mp_encode_uint(data, 1000);
+	case 33:
+		data = mp_encode_array(data, 16);
+		for (int i = 0; i < 16; i++)
+			data = mp_encode_uint(data, i);
+		return data;
+	case 34:
+		data = mp_encode_map(data, 2);
+		data = mp_encode_uint(data, 1);
+		data = mp_encode_array(data, 1);
+		data = mp_encode_map(data, 1);
+		data = mp_encode_str0(data, "key");
+		data = mp_encode_bool(data, true);
+		data = mp_encode_str0(data, "key");
+		return mp_encode_int(data, -100);
+	case 35:
+		data = mp_encode_map(data, 16);
+		for (int i = 0; i < 16; i++) {
+			data = mp_encode_uint(data, i);
+			data = mp_encode_nil(data);
+		}
+		return data;
+	default:
+		unreachable();
+	}
+	return data;
+}
+
+enum { SAMPLE_KIND_COUNT = 36 };
+
+/** Skip a single value of each kind at any alignment. */
+static void
+test_types(void)
+{
+	header();
+	plan(SAMPLE_KIND_COUNT);
+	for (int kind = 0; kind < SAMPLE_KIND_COUNT; kind++) {
+		int fail_count = 0;
+		for (int offset = 0; offset < 64; offset++) {
+			char *data = buf + offset;
+			char *end = encode_sample(data, kind);
+			/* Followed by single-byte values. */
+			memset(end, 0, 64);
+			const char *pos = data;
+			mp_skip(&pos, 1);
+			if (pos != end)
+				fail_count++;
+		}
+		is(fail_count, 0, "kind %d", kind);
+	}
+	footer();
+	check_plan();
+}
+
+/**
+ * Skip runs of single-byte values of any length crossing aligned
+ * block boundaries, followed by a multi-byte value.
+ */
+static void
+test_single_byte_runs(void)
+{
+	header();
+	plan(3);
+	const char single[] = {0x00, 0x7f, 0xe0, 0xff, 0xc0, 0xc2, 0xc3};
+	int fail_count = 0;
+	for (int offset = 0; offset < 64; offset++) {
+		for (uint32_t len = 0; len <= 100; len++) {
+			char *data = buf + offset;
+			for (uint32_t i = 0; i < len; i++)
+				data[i] = single[i % lengthof(single)];
+			char *end = mp_encode_uint(data + len, UINT32_MAX);
+			memset(end, 0, 64);
+			fail_count += check_skip(data, len + 1);
+		}
+	}
+	is(fail_count, 0, "runs followed by a multi-byte value");
+	/* Bytes that look like single-byte values inside strings. */
+	fail_count = 0;
+	for (int offset = 0; offset < 64; offset++) {
+		char *data = buf + offset;
+		char *end = data;
+		for (uint32_t i = 0; i < 20; i++) {
+			end = mp_encode_uint(end, i);
+			end = mp_encode_strl(end, i);
+			memset(end, i % 2 == 0 ? 0x01 : 0xc0, i);
+			end += i;
+		}
+		memset(end, 0, 64);
+		fail_count += check_skip(data, 40);
+	}
+	is(fail_count, 0, "strings of single-byte-like data");
+	/* A run ending exactly at the end of the data. */
+	fail_count = 0;
+	for (int offset = 0; offset < 64; offset++) {
+		char *data = buf + BUF_SIZE - 64 + offset;
+		uint32_t len = 64 - offset;
+		memset(data, 0x01, len);
+		fail_count += check_skip(data, len);
+	}
+	is(fail_count, 0, "runs at the end of the buffer");
+	footer();
+	check_plan();
+}
+
+/** Skip random sequences of values of all kinds. */
+static void
+test_random_sequences(void)
+{
+	header();
+	plan(1);
+	int fail_count = 0;
+	for (int i = 0; i < SEQUENCE_COUNT; i++) {
+		char *data = buf + rand() % 64;
+		char *end = data;
+		uint32_t count = rand() % MAX_VALUE_COUNT;
+		for (uint32_t j = 0; j < count; j++) {
+			/* Prefer single-byte values to get long runs. */
+			int kind = rand() % (2 * SAMPLE_KIND_COUNT);
+			if (kind >= SAMPLE_KIND_COUNT)
+				kind %= 7;
+			/* Long strings and binaries don't fit. */
+			if (kind == 21 || kind == 24)
+				kind = 0;
+			end = encode_sample(end, kind);
+		}
+		memset(end, 0, 64);
+		fail_count += check_skip(data, count);
+	}
+	is(fail_count, 0, "random sequences");
+	footer();
+	check_plan();
+}
+
+int
+main(void)
+{
+	header();
+	plan(3);
+	srand(time(NULL));
+	mp_skip_init();
+	test_types();
+	test_single_byte_runs();
+	test_random_sequences();
+	footer();
+	return check_plan();
+}
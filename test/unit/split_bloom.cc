@@ -0,0 +1,139 @@
+#include "salad/split_bloom.h"
+#include <unordered_set>
+#include <vector>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+using namespace std;
+
+uint32_t h(uint32_t i)
+{
+	/* MurmurHash3 finalizer. */
+	i ^= i >> 16;
+	i *= 0x85ebca6b;
+	i ^= i >> 13;
+	i *= 0xc2b2ae35;
+	i ^= i >> 16;
+	return i;
+}
+
+void
+simple_test()
+{
+	cout << "*** " << __func__ << " ***" << endl;
+	srand(time(0));
+	uint32_t error_count = 0;
+	uint32_t fp_rate_too_big = 0;
+	for (double p = 0.001; p < 0.5; p *= 1.3) {
+		uint64_t tests = 0;
+		uint64_t false_positive = 0;
+		for (uint32_t count = 1000; count <= 10000; count *= 2) {
+			struct split_bloom bloom;
+			split_bloom_create(&bloom, count, p);
+			unordered_set<uint32_t> check;
+			for (uint32_t i = 0; i < count; i++) {
+				uint32_t val = rand() % (count * 10);
+				check.insert(val);
+				split_bloom_add(&bloom, h(val));
+			}
+			for (uint32_t i = 0; i < count * 10; i++) {
+				bool has = check.find(i) != check.end();
+				bool bloom_possible =
+					split_bloom_maybe_has(&bloom, h(i));
+				tests++;
+				if (has && !bloom_possible)
+					error_count++;
+				if (!has && bloom_possible)
+					false_positive++;
+			}
+			split_bloom_destroy(&bloom);
+		}
+		double fp_rate = (double)false_positive / tests;
+		if (fp_rate > p * 1.1 + 0.001)
+			fp_rate_too_big++;
+	}
+	cout << "error_count = " << error_count << endl;
+	cout << "fp_rate_too_big = " << fp_rate_too_big << endl;
+}
+
+void
+store_load_test()
+{
+	cout << "*** " << __func__ << " ***" << endl;
+	srand(time(0));
+	uint32_t error_count = 0;
+	uint32_t fp_rate_too_big = 0;
+	for (double p = 0.01; p < 0.5; p *= 1.5) {
+		uint64_t tests = 0;
+		uint64_t false_positive = 0;
+		for (uint32_t count = 300; count <= 3000; count *= 10) {
+			struct split_bloom bloom;
+			split_bloom_create(&bloom, count, p);
+			unordered_set<uint32_t> check;
+			for (uint32_t i = 0; i < count; i++) {
+				uint32_t val = rand() % (count * 10);
+				check.insert(val);
+				split_bloom_add(&bloom, h(val));
+			}
+			struct split_bloom test = bloom;
+			size_t size = split_bloom_store_size(&bloom);
+			char *buf = (char *)malloc(size);
+			split_bloom_store(&bloom, buf);
+			split_bloom_destroy(&bloom);
+			memset(&bloom, '#', sizeof(bloom));
+			split_bloom_load_table(&test, buf);
+			free(buf);
+			for (uint32_t i = 0; i < count * 10; i++) {
+				bool has = check.find(i) != check.end();
+				bool bloom_possible =
+					split_bloom_maybe_has(&test, h(i));
+				tests++;
+				if (has && !bloom_possible)
+					error_count++;
+				if (!has && bloom_possible)
+					false_positive++;
+			}
+			split_bloom_destroy(&test);
+		}
+		double fp_rate = (double)false_positive / tests;
+		if (fp_rate > p * 1.1 + 0.001)
+			fp_rate_too_big++;
+	}
+	cout << "error_count = " << error_count << endl;
+	cout << "fp_rate_too_big = " << fp_rate_too_big << endl;
+}
+
+void
+size_test()
+{
+	cout << "*** " << __func__ << " ***" << endl;
+	uint32_t size_too_big = 0;
+	for (double p = 0.001; p < 0.5; p *= 1.3) {
+		for (uint32_t count = 1000; count <= 100000; count *= 10) {
+			struct bloom classic;
+			struct split_bloom split;
+			bloom_create(&classic, count, p);
+			split_bloom_create(&split, count, p);
+			/*
+			 * A split block filter may need more space for
+			 * the same false positive rate, but not much.
+			 */
+			if (split_bloom_store_size(&split) >
+			    bloom_store_size(&classic) * 1.3)
+				size_too_big++;
+			bloom_destroy(&classic);
+			split_bloom_destroy(&split);
+		}
+	}
+	cout << "size_too_big = " << size_too_big << endl;
+}
+
+int
+main(void)
+{
+	simple_test();
+	store_load_test();
+	size_test();
+}
@@ -0,0 +1,265 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <set>
+#include <vector>
+
+#include "unit.h"
+
+typedef uint64_t hash_value_t;
+typedef uint32_t hash_t;
+
+static const size_t swiss_extent_size = 16 * 1024;
+static size_t extents_count = 0;
+/** Extent allocation fails when this counter drops to zero. */
+static int extents_fail_countdown = -1;
+
+static hash_t
+hash(hash_value_t value)
+{
+	uint64_t x = value * 0x9E3779B97F4A7C15ULL;
+	return (hash_t)(x >> 32) ^ (hash_t)x;
+}
+
+#define SWISS_NAME
+#define SWISS_DATA_TYPE uint64_t
+#define SWISS_KEY_TYPE uint64_t
+#define SWISS_CMP_ARG_TYPE int
+#define SWISS_EQUAL(a, b, arg) ((a) == (b))
+#define SWISS_EQUAL_KEY(a, b, arg) ((a) == (b))
+#include "salad/swiss.h"
+
+static void *
+my_swiss_alloc(void *ctx)
+{
+	size_t *p_extents_count = (size_t *)ctx;
+	assert(p_extents_count == &extents_count);
+	if (extents_fail_countdown >= 0 && extents_fail_countdown-- == 0)
+		return NULL;
+	++*p_extents_count;
+	return malloc(swiss_extent_size);
+}
+
+static void
+my_swiss_free(void *ctx, void *p)
+{
+	size_t *p_extents_count = (size_t *)ctx;
+	assert(p_extents_count == &extents_count);
+	--*p_extents_count;
+	free(p);
+}
+
+static std::set<hash_value_t>
+collect(struct swiss_core *ht, struct swiss_iterator *itr)
+{
+	std::set<hash_value_t> result;
+	hash_value_t *value;
+	while ((value = swiss_iterator_get_and_next(ht, itr)) != NULL)
+		result.insert(*value);
+	return result;
+}
+
+/**
+ * Apply a random insertion or deletion to the hash table and
+ * the reference set. Returns false on memory error.
+ */
+static bool
+random_op(struct swiss_core *ht, std::set<hash_value_t> &ref,
+	  size_t limit, bool *ok)
+{
+	hash_value_t value = rand() % limit;
+	hash_t h = hash(value);
+	bool found = ref.count(value) != 0;
+	if (rand() % 3 != 0) {
+		hash_value_t replaced = 0;
+		int rc = swiss_replace(ht, h, value, &replaced);
+		if (rc == 0) {
+			*ok = *ok && found && replaced == value;
+			return true;
+		}
+		if (rc < 0)
+			return false;
+		if (rc > 0)
+			rc = swiss_insert(ht, h, value);
+		*ok = *ok && !found;
+		if (rc == 0)
+			ref.insert(value);
+		return rc == 0;
+	}
+	int rc = swiss_delete_value(ht, h, value);
+	if (rc == 0)
+		ref.erase(value);
+	*ok = *ok && (rc != 1 || !found) && (rc != 0 || found);
+	return rc >= 0;
+}
+
+static void
+simple_test()
+{
+	plan(6);
+	header();
+
+	struct swiss_core ht;
+	swiss_create(&ht, swiss_extent_size,
+		     my_swiss_alloc, my_swiss_free, &extents_count, 0);
+	std::set<hash_value_t> ref;
+	bool ok = true;
+	for (size_t limit = 20; limit <= 200000; limit *= 10) {
+		for (int i = 0; i < 100000; i++)
+			random_op(&ht, ref, limit, &ok);
+	}
+	ok(ok, "replace, insert and delete results");
+	ok(swiss_selfcheck(&ht) == 0, "selfcheck");
+	is(ht.count, ref.size(), "count");
+
+	bool found = true;
+	for (hash_value_t value : ref) {
+		hash_value_t *res = swiss_find_key(&ht, hash(value), value);
+		found = found && res != NULL && *res == value;
+	}
+	ok(found, "all values are found");
+
+	struct swiss_iterator itr;
+	swiss_iterator_begin(&ht, &itr);
+	ok(collect(&ht, &itr) == ref, "iteration");
+
+	while (!ref.empty()) {
+		hash_value_t value = *ref.begin();
+		swiss_delete_value(&ht, hash(value), value);
+		ref.erase(value);
+	}
+	ok(ht.count == 0 && swiss_selfcheck(&ht) == 0, "delete all");
+
+	swiss_destroy(&ht);
+	footer();
+	check_plan();
+}
+
+static void
+iterator_key_test()
+{
+	plan(4);
+	header();
+
+	struct swiss_core ht;
+	swiss_create(&ht, swiss_extent_size,
+		     my_swiss_alloc, my_swiss_free, &extents_count, 0);
+	for (hash_value_t value = 0; value < 10000; value++)
+		swiss_insert(&ht, hash(value), value);
+
+	struct swiss_iterator itr;
+	ok(!swiss_iterator_key(&ht, &itr, hash(10000), 10000),
+	   "missing key");
+	ok(swiss_iterator_get_and_next(&ht, &itr) == NULL,
+	   "iterator is exhausted");
+
+	ok(swiss_iterator_key(&ht, &itr, hash(5000), 5000), "existing key");
+	hash_value_t *value = swiss_iterator_get_and_next(&ht, &itr);
+	ok(value != NULL && *value == 5000, "iterator points to the key");
+
+	swiss_destroy(&ht);
+	footer();
+	check_plan();
+}
+
+static void
+freeze_test()
+{
+	plan(2);
+	header();
+
+	struct swiss_core ht;
+	swiss_create(&ht, swiss_extent_size,
+		     my_swiss_alloc, my_swiss_free, &extents_count, 0);
+	std::set<hash_value_t> ref;
+	bool ok = true;
+	struct frozen {
+		struct swiss_iterator itr;
+		std::set<hash_value_t> content;
+	};
+	std::vector<frozen *> frozen_list;
+	bool frozen_ok = true;
+	for (int i = 0; i < 200000; i++) {
+		random_op(&ht, ref, i < 100000 ? 50000 : 5000, &ok);
+		if (i % 10000 == 0) {
+			frozen *f = new frozen;
+			swiss_iterator_begin(&ht, &f->itr);
+			swiss_iterator_freeze(&ht, &f->itr);
+			f->content = ref;
+			frozen_list.push_back(f);
+		}
+		if (i % 30000 == 15000) {
+			for (frozen *f : frozen_list) {
+				if (collect(&ht, &f->itr) != f->content)
+					frozen_ok = false;
+				swiss_iterator_destroy(&ht, &f->itr);
+				delete f;
+			}
+			frozen_list.clear();
+		}
+	}
+	for (frozen *f : frozen_list) {
+		if (collect(&ht, &f->itr) != f->content)
+			frozen_ok = false;
+		swiss_iterator_destroy(&ht, &f->itr);
+		delete f;
+	}
+	ok(ok && swiss_selfcheck(&ht) == 0, "modifications");
+	ok(frozen_ok, "frozen iterators see the state at freeze");
+
+	swiss_destroy(&ht);
+	footer();
+	check_plan();
+}
+
+static void
+memory_failure_test()
+{
+	plan(3);
+	header();
+
+	struct swiss_core ht;
+	swiss_create(&ht, swiss_extent_size,
+		     my_swiss_alloc, my_swiss_free, &extents_count, 0);
+	std::set<hash_value_t> ref;
+	bool ok = true;
+	int failures = 0;
+	for (int i = 0; i < 100000; i++) {
+		struct swiss_iterator itr;
+		swiss_iterator_begin(&ht, &itr);
+		swiss_iterator_freeze(&ht, &itr);
+		extents_fail_countdown = rand() % 8;
+		if (!random_op(&ht, ref, 20000, &ok))
+			failures++;
+		extents_fail_countdown = -1;
+		swiss_iterator_destroy(&ht, &itr);
+	}
+	ok(failures > 0, "memory errors happened");
+	ok(ok && swiss_selfcheck(&ht) == 0, "hash table is consistent");
+	struct swiss_iterator itr;
+	swiss_iterator_begin(&ht, &itr);
+	ok(collect(&ht, &itr) == ref, "no values are lost");
+
+	swiss_destroy(&ht);
+	footer();
+	check_plan();
+}
+
+int
+main(int argc, char *argv[])
+{
+	plan(5);
+	header();
+
+	srand(time(NULL));
+	simple_test();
+	iterator_key_test();
+	freeze_test();
+	memory_failure_test();
+	ok(extents_count == 0, "all memory is freed");
+
+	footer();
+	return check_plan();
+}
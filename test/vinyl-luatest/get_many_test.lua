@@ -0,0 +1,110 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group('get_many', t.helpers.matrix({engine = {'memtx', 'vinyl'}}))
+
+g.before_all(function(cg)
+    cg.server = server:new({
+        alias = 'master',
+        box_cfg = {
+            vinyl_cache = 0,
+            vinyl_page_size = 1024,
+            vinyl_read_threads = 2,
+        },
+    })
+    cg.server:start()
+end)
+
+g.after_all(function(cg)
+    cg.server:drop()
+end)
+
+g.before_each(function(cg)
+    cg.server:exec(function(engine)
+        local s = box.schema.space.create('test', {engine = engine})
+        s:create_index('pk')
+        s:create_index('sk', {parts = {{2, 'string'}}})
+        s:create_index('nu', {parts = {{3, 'unsigned'}}, unique = false})
+        for i = 1, 200 do
+            s:replace{i, 'v' .. i, i % 10, string.rep('x', 100)}
+        end
+        if engine == 'vinyl' then
+            box.snapshot()
+        end
+    end, {cg.params.engine})
+end)
+
+g.after_each(function(cg)
+    cg.server:exec(function() box.space.test:drop() end)
+end)
+
+g.test_get_many = function(cg)
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+
+        local function check(index, keys)
+            local expected = {}
+            for _, key in ipairs(keys) do
+                local tuple = index:get(key)
+                if tuple ~= nil then
+                    table.insert(expected, tuple)
+                end
+            end
+            t.assert_equals(index:get_many(keys), expected)
+        end
+
+        check(s.index.pk, {})
+        check(s.index.pk, {1})
+        check(s.index.pk, {150, 3, 1000, 77, 3, {42}, 0, 200})
+        check(s.index.sk, {'v10', 'v5', 'foo', {'v199'}})
+        local keys = {}
+        for i = 300, 1, -3 do
+            table.insert(keys, i)
+        end
+        check(s.index.pk, keys)
+        t.assert_equals(s:get_many({2, 1}), {s:get(2), s:get(1)})
+
+        -- Changes made in a transaction are visible.
+        box.begin()
+        s:delete(5)
+        s:replace{1000, 'v1000', 0}
+        t.assert_equals(s:get_many({1000, 5, 6}), {s:get(1000), s:get(6)})
+        box.rollback()
+        t.assert_equals(s:get_many({1000, 5}), {s:get(5)})
+
+        t.assert_error_msg_contains(
+            "Get() doesn't support partial keys and non-unique indexes",
+            s.index.nu.get_many, s.index.nu, {1})
+        t.assert_error_msg_contains(
+            "Invalid key part count in an exact match (expected 1, got 2)",
+            s.get_many, s, {1, {1, 2}})
+        t.assert_error_msg_contains(
+            "Supplied key type of part 0 does not match index part type",
+            s.get_many, s, {1, 'x'})
+        t.assert_error_msg_contains(
+            "Usage: index:get_many({key1, key2, ...})",
+            s.get_many, s, 1)
+    end)
+end
+
+g.test_get_many_disk = function(cg)
+    t.skip_if(cg.params.engine ~= 'vinyl', 'vinyl only')
+    cg.server:exec(function()
+        local t = require('luatest')
+        local s = box.space.test
+        local function pages()
+            return s.index.pk:stat().disk.iterator.read.pages
+        end
+        local keys = {}
+        for i = 200, 1, -1 do
+            table.insert(keys, i)
+        end
+        local pages_before = pages()
+        local result = s:get_many(keys)
+        t.assert_equals(#result, 200)
+        for i, tuple in ipairs(result) do
+            t.assert_equals(tuple[1], 201 - i)
+        end
+        t.assert_gt(pages(), pages_before)
+    end)
+end
@@ -0,0 +1,96 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({
+        alias = 'master',
+        box_cfg = {
+            use_io_uring = true,
+            wal_mode = 'fsync',
+            vinyl_cache = 0,
+            vinyl_page_size = 1024,
+            vinyl_read_threads = 2,
+        },
+    })
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.test_io_uring = function()
+    t.skip_if(g.server:grep_log('failed to set up io_uring'),
+              'io_uring is not supported')
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_error_msg_contains(
+            "Can't set option 'use_io_uring' dynamically",
+            box.cfg, {use_io_uring = false})
+
+        local s = box.schema.space.create('test', {engine = 'vinyl'})
+        s:create_index('pk')
+        local m = box.schema.space.create('test_memtx')
+        m:create_index('pk')
+        local ok, writes = pcall(box.error.injection.get,
+                                 'ERRINJ_IO_RING_WRITE_COUNT')
+        for i = 1, 500 do
+            s:replace{i, string.rep(string.char(65 + i % 26), 100)}
+            m:replace{i, i * 2}
+        end
+        -- WAL writes go through io_uring.
+        if ok then
+            t.assert_ge(box.error.injection.get('ERRINJ_IO_RING_WRITE_COUNT'),
+                        writes + 1000)
+            -- A commit group isn't committed if the sync fails.
+            box.error.injection.set('ERRINJ_WAL_SYNC_DISK', true)
+            t.assert_error_msg_contains('Failed to write to disk',
+                                        m.replace, m, {501})
+            box.error.injection.set('ERRINJ_WAL_SYNC_DISK', false)
+            t.assert_equals(m:get(501), nil)
+            m:replace{501}
+            m:delete{501}
+        end
+        box.snapshot()
+
+        local function disk_pages()
+            return s.index.pk:stat().disk.iterator.read.pages
+        end
+        local pages = disk_pages()
+        local ok, reads = pcall(box.error.injection.get,
+                                'ERRINJ_IO_RING_READ_COUNT')
+        -- Concurrent page reads.
+        local fiber = require('fiber')
+        local fibers = {}
+        for f = 1, 10 do
+            fibers[f] = fiber.new(function()
+                for i = f, 500, 10 do
+                    local tuple = s:get(i)
+                    assert(tuple ~= nil and tuple[1] == i)
+                end
+            end)
+            fibers[f]:set_joinable(true)
+        end
+        for f = 1, 10 do
+            t.assert((fibers[f]:join()))
+        end
+        t.assert_gt(disk_pages(), pages)
+        -- Pages are read through io_uring.
+        if ok then
+            t.assert_ge(box.error.injection.get('ERRINJ_IO_RING_READ_COUNT'),
+                        reads + disk_pages() - pages)
+        end
+        t.assert_equals(s:count(), 500)
+        t.assert_equals(#s:select({}, {iterator = 'GE', limit = 100}), 100)
+    end)
+    -- Data is read back after restart.
+    g.server:restart()
+    g.server:exec(function()
+        local t = require('luatest')
+        t.assert_equals(box.space.test:count(), 500)
+        t.assert_equals(box.space.test_memtx:count(), 500)
+        t.assert_equals(box.space.test_memtx:get(250), {250, 500})
+        t.assert_equals(box.space.test:get(499)[2], string.rep('F', 100))
+    end)
+end
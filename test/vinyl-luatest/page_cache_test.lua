@@ -0,0 +1,78 @@
+local server = require('test.luatest_helpers.server')
+local t = require('luatest')
+local g = t.group()
+
+g.before_all(function()
+    g.server = server:new({
+        alias = 'master',
+        box_cfg = {
+            vinyl_cache = 0,
+            vinyl_page_cache = 1024 * 1024,
+            vinyl_page_size = 1024,
+        },
+    })
+    g.server:start()
+end)
+
+g.after_all(function()
+    g.server:drop()
+end)
+
+g.test_page_cache = function()
+    g.server:exec(function()
+        local t = require('luatest')
+
+        t.assert_error_msg_contains(
+            "Incorrect value for option 'vinyl_page_cache'",
+            box.cfg, {vinyl_page_cache = -1})
+
+        local s = box.schema.space.create('test', {engine = 'vinyl'})
+        s:create_index('pk')
+        for i = 1, 100 do
+            s:replace{i, string.rep('x', 100)}
+        end
+        box.snapshot()
+
+        local function disk_pages()
+            return s.index.pk:stat().disk.iterator.read.pages
+        end
+
+        local pages = disk_pages()
+        for i = 1, 100 do
+            t.assert_equals(s:get(i)[1], i)
+        end
+        t.assert_gt(disk_pages(), pages)
+        t.assert_gt(box.stat.vinyl().memory.page_cache, 0)
+        t.assert_gt(box.stat.vinyl().page_cache.put, 0)
+
+        -- All pages are cached now, no disk reads are expected.
+        pages = disk_pages()
+        local hit = box.stat.vinyl().page_cache.hit
+        for i = 1, 100 do
+            t.assert_equals(s:get(i)[1], i)
+        end
+        t.assert_equals(disk_pages(), pages)
+        t.assert_gt(box.stat.vinyl().page_cache.hit, hit)
+
+        -- Shrinking the cache evicts pages.
+        box.cfg{vinyl_page_cache = 0}
+        t.assert_equals(box.stat.vinyl().memory.page_cache, 0)
+        t.assert_gt(box.stat.vinyl().page_cache.evict, 0)
+        for i = 1, 100 do
+            t.assert_equals(s:get(i)[1], i)
+        end
+        t.assert_gt(disk_pages(), pages)
+
+        -- Pages of dropped runs are evicted too.
+        box.cfg{vinyl_page_cache = 1024 * 1024}
+        for i = 1, 100 do
+            s:get(i)
+        end
+        t.assert_gt(box.stat.vinyl().memory.page_cache, 0)
+        s:drop()
+        t.helpers.retrying({}, function()
+            collectgarbage()
+            t.assert_equals(box.stat.vinyl().memory.page_cache, 0)
+        end)
+    end)
+end
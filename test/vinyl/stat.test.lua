@@ -90,6 +90,8 @@ end;
 function gstat()
     local st = box.stat.vinyl()
     st.regulator = nil
+    st.page_cache = nil
+    st.memory.page_cache = nil
     st.scheduler.dump_time = nil
     st.scheduler.compaction_time = nil
     return st